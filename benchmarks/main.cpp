@@ -0,0 +1,306 @@
+/* main.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Microbenchmarks for the core data structures and kernels of Endless Sky.
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Angle.h"
+#include "CollisionSet.h"
+#include "ConditionSet.h"
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Dictionary.h"
+#include "DistanceMap.h"
+#include "Files.h"
+#include "GameData.h"
+#include "Mask.h"
+#include "Outfit.h"
+#include "Point.h"
+#include "Random.h"
+#include "Ship.h"
+#include "System.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// All the inputs are generated from this seed, so every run is the same.
+	const uint64_t SEED = 1;
+	
+	// Only run the benchmarks whose names contain this string.
+	string filter;
+	
+	// Results are accumulated here so that the compiler cannot optimize the
+	// work being measured away.
+	volatile double sink = 0.;
+	
+	
+	// Call the given function the given number of times, and print the time
+	// per call. The output is one comma-separated line per benchmark:
+	// name, iterations, total milliseconds, nanoseconds per iteration.
+	template <class Function>
+	void Run(const string &name, int iterations, Function function)
+	{
+		if(!filter.empty() && name.find(filter) == string::npos)
+			return;
+		
+		// Warm up the caches (and any lazily built state) before timing.
+		function();
+		
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for(int i = 0; i < iterations; ++i)
+			function();
+		chrono::steady_clock::duration elapsed = chrono::steady_clock::now() - start;
+		
+		double milliseconds = chrono::duration<double, milli>(elapsed).count();
+		cout << name << "," << iterations << "," << milliseconds << ","
+			<< (milliseconds * 1000000.) / iterations << endl;
+	}
+	
+	
+	// Make a group of ships of the given model, scattered randomly over a
+	// square region of the given size.
+	vector<shared_ptr<Ship>> Scatter(const Ship &model, int count, double size)
+	{
+		vector<shared_ptr<Ship>> ships;
+		for(int i = 0; i < count; ++i)
+		{
+			ships.emplace_back(new Ship(model));
+			Point position((Random::Real() - .5) * size, (Random::Real() - .5) * size);
+			ships.back()->Place(position, Point(), Angle::Random());
+		}
+		return ships;
+	}
+	
+	
+	// Benchmarks that do not depend on the game data.
+	void RunMath()
+	{
+		Run("Random::Real", 100, []()
+		{
+			double sum = 0.;
+			for(int i = 0; i < 100000; ++i)
+				sum += Random::Real();
+			sink = sum;
+		});
+		
+		vector<Angle> angles;
+		vector<Point> points;
+		for(int i = 0; i < 1024; ++i)
+		{
+			angles.push_back(Angle::Random());
+			points.emplace_back(Random::Real() * 1000., Random::Real() * 1000.);
+		}
+		Run("Angle::Rotate", 100, [&angles, &points]()
+		{
+			Point sum;
+			for(int j = 0; j < 100; ++j)
+				for(size_t i = 0; i < angles.size(); ++i)
+					sum += angles[i].Rotate(points[i]);
+			sink = sum.X();
+		});
+		Run("Point math", 100, [&points]()
+		{
+			double sum = 0.;
+			for(int j = 0; j < 100; ++j)
+				for(size_t i = 1; i < points.size(); ++i)
+				{
+					Point d = points[i] - points[i - 1];
+					sum += d.Length() + d.Unit().Dot(points[i]) + d.Cross(points[i - 1]);
+				}
+			sink = sum;
+		});
+		
+		ConditionSet::Conditions conditions;
+		for(int i = 0; i < 1000; ++i)
+			conditions["condition " + to_string(i)] = Random::Int(100);
+		conditions["combat rating"] = 500;
+		conditions["reputation: Republic"] = 20;
+		conditions["day"] = 5;
+		istringstream text(
+			"conditions\n"
+			"\t\"combat rating\" > 100\n"
+			"\t\"reputation: Republic\" >= 10\n"
+			"\tor\n"
+			"\t\thas \"event: war begins\"\n"
+			"\t\t\"day\" == 5\n"
+			"\t\"condition 500\" + \"condition 501\" < 1000\n"
+			"\tnot \"condition 999 is not set\"\n");
+		DataFile file(text);
+		ConditionSet conditionSet(*file.begin());
+		Run("ConditionSet::Test", 100, [&conditionSet, &conditions]()
+		{
+			int count = 0;
+			for(int i = 0; i < 1000; ++i)
+				count += conditionSet.Test(conditions);
+			sink = count;
+		});
+	}
+	
+	
+	// Benchmarks that use the game data.
+	void RunData()
+	{
+		// Use the ship model with the most attributes, so that lookups have as
+		// much to search through as they ever do in the game.
+		const Ship *model = nullptr;
+		auto Count = [](const Ship &ship)
+		{
+			const Dictionary &attributes = ship.Attributes().Attributes();
+			return attributes.end() - attributes.begin();
+		};
+		for(const auto &it : GameData::Ships())
+			if(it.second.HasSprite() && (!model || Count(it.second) > Count(*model)))
+				model = &it.second;
+		if(!model)
+			throw runtime_error("No ship models were loaded.");
+		
+		const Dictionary &attributes = model->Attributes().Attributes();
+		vector<string> keys;
+		for(const auto &it : attributes)
+			keys.push_back(it.first);
+		keys.push_back("not an attribute");
+		Run("Dictionary::Get", 100, [&attributes, &keys]()
+		{
+			double sum = 0.;
+			for(int j = 0; j < 100; ++j)
+				for(const string &key : keys)
+					sum += attributes.Get(key.c_str());
+			sink = sum;
+		});
+		
+		const Mask &mask = model->GetMask(0);
+		double radius = mask.Radius();
+		vector<Point> starts;
+		vector<Point> moves;
+		vector<Angle> facings;
+		for(int i = 0; i < 1024; ++i)
+		{
+			starts.push_back(Angle::Random().Unit() * (radius * 2. * Random::Real()));
+			moves.push_back(Angle::Random().Unit() * (radius * Random::Real()));
+			facings.push_back(Angle::Random());
+		}
+		Run("Mask::Collide", 100, [&]()
+		{
+			double sum = 0.;
+			for(size_t i = 0; i < starts.size(); ++i)
+				sum += mask.Collide(starts[i], moves[i], facings[i]);
+			sink = sum;
+		});
+		
+		vector<shared_ptr<Ship>> ships = Scatter(*model, 200, 8000.);
+		CollisionSet collisions(256u, 32u);
+		Run("CollisionSet build", 1000, [&ships, &collisions]()
+		{
+			collisions.Clear(0);
+			for(const shared_ptr<Ship> &ship : ships)
+				collisions.Add(*ship);
+			collisions.Finish();
+		});
+		vector<pair<Point, Point>> lines;
+		for(int i = 0; i < 1024; ++i)
+		{
+			Point from((Random::Real() - .5) * 8000., (Random::Real() - .5) * 8000.);
+			lines.emplace_back(from, from + Angle::Random().Unit() * (1000. * Random::Real()));
+		}
+		Run("CollisionSet::Line", 100, [&lines, &collisions]()
+		{
+			size_t hits = 0;
+			for(const pair<Point, Point> &line : lines)
+				hits += (collisions.Line(line.first, line.second) != nullptr);
+			sink = hits;
+		});
+		Run("CollisionSet::Circle", 100, [&lines, &collisions]()
+		{
+			size_t found = 0;
+			for(const pair<Point, Point> &line : lines)
+				found += collisions.Circle(line.first, 1000.).size();
+			sink = found;
+		});
+		
+		vector<const System *> systems;
+		for(const auto &it : GameData::Systems())
+			if(!it.second.Name().empty())
+				systems.push_back(&it.second);
+		Run("DistanceMap", 10, [&systems]()
+		{
+			size_t total = 0;
+			for(size_t i = 0; i < systems.size(); i += 10)
+				total += DistanceMap(systems[i]).Systems().size();
+			sink = total;
+		});
+		
+		vector<string> dataFiles = Files::RecursiveList(Files::Data());
+		Run("DataFile::Load", 5, [&dataFiles]()
+		{
+			size_t nodes = 0;
+			for(const string &path : dataFiles)
+			{
+				DataFile file(path);
+				for(const DataNode &node : file)
+					nodes += node.Size();
+			}
+			sink = nodes;
+		});
+	}
+}
+
+
+
+int main(int argc, char *argv[])
+{
+	for(const char *const *it = argv + 1; *it; ++it)
+	{
+		string arg = *it;
+		if((arg == "-f" || arg == "--filter") && *++it)
+			filter = *it;
+		else if(arg == "-h" || arg == "--help")
+		{
+			cerr << "Command line options:" << endl;
+			cerr << "    -f, --filter <name>: only run the benchmarks whose names contain this string." << endl;
+			cerr << "    -r, --resources <path>: load resources from given directory." << endl;
+			cerr << "    -c, --config <path>: save user's files to given directory." << endl;
+			return 0;
+		}
+	}
+	
+	try {
+		Random::Seed(SEED);
+		cout << fixed << setprecision(3);
+		cout << "benchmark,iterations,total ms,ns per iteration" << endl;
+		RunMath();
+		
+		// Load the game data, including all the sprites (for their masks). The
+		// game only waits for the background sprites in a headless run.
+		Files::Init(argv);
+		vector<const char *> args(argv, argv + argc);
+		args.push_back("--headless");
+		args.push_back(nullptr);
+		GameData::BeginLoad(args.data());
+		GameData::FinishLoading();
+		Random::Seed(SEED);
+		RunData();
+	}
+	catch(const runtime_error &error)
+	{
+		cerr << error.what() << endl;
+		return 1;
+	}
+	return 0;
+}
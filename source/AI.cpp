@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "AI.h"
 
 #include "Audio.h"
+#include "CollisionSet.h"
 #include "Command.h"
 #include "DistanceMap.h"
 #include "Flotsam.h"
@@ -32,12 +33,17 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "StellarObject.h"
 #include "System.h"
 #include "Weapon.h"
+#include "WorkerPool.h"
 
 #include <algorithm>
 #include <cmath>
 #include <limits>
 #include <set>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 namespace {
@@ -53,7 +59,7 @@ namespace {
 	bool IsStranded(const Ship &ship)
 	{
 		return ship.GetSystem() && !ship.IsEnteringHyperspace() && !ship.GetSystem()->HasFuelFor(ship)
-			&& ship.JumpFuel() && ship.Attributes().Get("fuel capacity") && !ship.JumpsRemaining();
+			&& ship.JumpFuel() && ship.Attributes().Get(Outfit::FUEL_CAPACITY) && !ship.JumpsRemaining();
 	}
 	
 	bool CanBoard(const Ship &ship, const Ship &target)
@@ -128,7 +134,7 @@ namespace {
 	bool ShouldRefuel(const Ship &ship, const DistanceMap &route, double fuelCapacity = 0.)
 	{
 		if(!fuelCapacity)
-			fuelCapacity = ship.Attributes().Get("fuel capacity");
+			fuelCapacity = ship.Attributes().Get(Outfit::FUEL_CAPACITY);
 		
 		const System *from = ship.GetSystem();
 		const bool systemHasFuel = from->HasFuelFor(ship) && fuelCapacity;
@@ -156,7 +162,7 @@ namespace {
 	{
 		if(!to || ship.Fuel() == 1. || !ship.GetSystem()->HasFuelFor(ship))
 			return false;
-		double fuelCapacity = ship.Attributes().Get("fuel capacity");
+		double fuelCapacity = ship.Attributes().Get(Outfit::FUEL_CAPACITY);
 		if(!fuelCapacity)
 			return false;
 		double needed = ship.JumpFuel(to);
@@ -237,12 +243,30 @@ namespace {
 	// The health remaining before becoming disabled, at which fighters and
 	// other ships consider retreating from battle.
 	const double RETREAT_HEALTH = .25;
+	// Ships that have a target only switch targets twice a second, so that
+	// they can focus on damaging one particular ship. Ships with no target
+	// look for one more often. The steps on which each ship looks are
+	// staggered, so the searches are spread evenly across steps.
+	const int TARGET_PERIOD = 32;
+	const int IDLE_TARGET_PERIOD = 8;
+	// The cost of a scheduled target search is the number of enemies it must
+	// consider. Searches that would go over this total in one step are put off
+	// until the next step. Ships whose target is no longer valid always search.
+	const size_t TARGET_SEARCH_BUDGET = 20000;
+	// Each search can look through many enemies, so they are split between the
+	// worker threads even if there are only a few of them.
+	const size_t MIN_SEARCH_CHUNK = 4;
+	// Ships outside the player's system only decide what to do once in this
+	// many steps. This is also staggered by each ship's place in the list.
+	const int REMOTE_PERIOD = 4;
 }
 
 
 
-AI::AI(const List<Ship> &ships, const List<Minable> &minables, const List<Flotsam> &flotsam)
-	: ships(ships), minables(minables), flotsam(flotsam)
+AI::AI(const List<Ship> &ships, const List<Minable> &minables, const CollisionSet &shipCollisions,
+		const CollisionSet &minableCollisions, const CollisionSet &flotsamCollisions)
+	: ships(ships), minables(minables), shipCollisions(shipCollisions),
+	minableCollisions(minableCollisions), flotsamCollisions(flotsamCollisions)
 {
 }
 
@@ -301,7 +325,7 @@ void AI::UpdateKeys(PlayerInfo &player, Command &activeCommands)
 	// Only toggle the "cloak" command if one of your ships has a cloaking device.
 	if(activeCommands.Has(Command::CLOAK))
 		for(const auto &it : player.Ships())
-			if(!it->IsParked() && it->Attributes().Get("cloak"))
+			if(!it->IsParked() && it->Attributes().Get(Outfit::CLOAK))
 			{
 				isCloaking = !isCloaking;
 				Messages::Add(isCloaking ? "Engaging cloaking device." : "Disengaging cloaking device.");
@@ -365,7 +389,7 @@ void AI::UpdateKeys(PlayerInfo &player, Command &activeCommands)
 
 
 
-void AI::UpdateEvents(const list<ShipEvent> &events)
+void AI::UpdateEvents(const vector<ShipEvent> &events)
 {
 	for(const ShipEvent &event : events)
 	{
@@ -408,6 +432,9 @@ void AI::Clean()
 	shipStrength.clear();
 	enemyStrength.clear();
 	allyStrength.clear();
+	delayedSearches.clear();
+	fireSolutions.clear();
+	escortRoutes.clear();
 }
 
 
@@ -422,10 +449,10 @@ void AI::ClearOrders()
 
 
 
-void AI::Step(const PlayerInfo &player, Command &activeCommands)
+void AI::Step(const PlayerInfo &player, Command &activeCommands, WorkerPool &workers)
 {
 	// First, figure out the comparative strengths of the present governments.
-	const System *playerSystem = player.GetSystem();
+	playerSystem = player.GetSystem();
 	map<const Government *, int64_t> strength;
 	UpdateStrengths(strength, playerSystem);
 	CacheShipLists();
@@ -450,13 +477,71 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 	
 	const Ship *flagship = player.Flagship();
 	step = (step + 1) & 31;
-	int targetTurn = 0;
+	
+	// Finding a target only reads the state of the ships, not any of the AI's
+	// own state that this step changes, so all the ships that want a new target
+	// this step can search for one in parallel, based on where every ship is at
+	// the start of the step. Each ship's index in the list of ships is stored
+	// along with it, in increasing order.
+	vector<pair<size_t, const Ship *>> searches;
+	size_t budget = TARGET_SEARCH_BUDGET;
+	size_t index = 0;
+	// Only the ships that are put off during this step are remembered for the
+	// next one, so ships that have been removed do not linger in the list.
+	set<weak_ptr<const Ship>, Comp> wasDelayed;
+	wasDelayed.swap(delayedSearches);
+	for(const auto &it : ships)
+	{
+		const Ship &ship = *it;
+		size_t shipIndex = index++;
+		if(ship.GetSystem() != playerSystem || &ship == flagship || ship.IsDisabled() || ship.IsOverheated()
+				|| ship.GetPersonality().IsSwarming())
+			continue;
+		
+		// A ship whose target has been destroyed or disabled, or can no longer
+		// be targeted, must find a new one right away.
+		shared_ptr<const Ship> target = ship.GetTargetShip();
+		if(target && (target->IsDestroyed() || (target->IsDisabled() && ship.GetPersonality().Disables())
+				|| !target->IsTargetable()))
+		{
+			searches.emplace_back(shipIndex, &ship);
+			continue;
+		}
+		// Otherwise, check if this ship is scheduled to search on this step, or
+		// was put off from a previous step.
+		int period = target ? TARGET_PERIOD : IDLE_TARGET_PERIOD;
+		bool isDelayed = wasDelayed.count(it);
+		if(static_cast<int>(shipIndex % period) != step % period && !isDelayed)
+			continue;
+		
+		// A search is only put off once, so no ship waits more than one extra
+		// step, even if the budget is used up.
+		auto enemies = enemyLists.find(ship.GetGovernment());
+		size_t cost = (enemies == enemyLists.end() ? 0 : enemies->second.count);
+		if(!isDelayed && cost > budget && budget < TARGET_SEARCH_BUDGET)
+		{
+			delayedSearches.insert(it);
+			continue;
+		}
+		budget -= min(cost, budget);
+		searches.emplace_back(shipIndex, &ship);
+	}
+	vector<shared_ptr<Ship>> foundTargets(searches.size());
+	workers.Run(searches.size(), [this, &searches, &foundTargets](size_t, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+			foundTargets[i] = FindTarget(*searches[i].second);
+	}, MIN_SEARCH_CHUNK);
+	
+	size_t nextSearch = 0;
+	index = 0;
 	int minerCount = 0;
 	const int maxMinerCount = minables.empty() ? 0 : 9;
-	bool opportunisticEscorts = !Preferences::Has("Turrets focus fire");
-	bool fightersRetreat = Preferences::Has("Damaged fighters retreat");
+	bool opportunisticEscorts = !Preferences::Has(Preferences::TURRETS_FOCUS_FIRE);
+	bool fightersRetreat = Preferences::Has(Preferences::DAMAGED_FIGHTERS_RETREAT);
 	for(const auto &it : ships)
 	{
+		size_t shipIndex = index++;
 		// Skip any carried fighters or drones that are somehow in the list.
 		if(!it->GetSystem())
 			continue;
@@ -467,10 +552,22 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 			continue;
 		}
 		
+		// Ships outside the player's system cannot be seen, so they only make
+		// new decisions every few steps. In between, they keep following their
+		// last commands, except that they stop turning, so that they do not
+		// overshoot the direction they were turning toward.
+		bool isPresent = (it->GetSystem() == playerSystem);
+		if(!isPresent && static_cast<int>(shipIndex % REMOTE_PERIOD) != step % REMOTE_PERIOD)
+		{
+			Command command = it->Commands();
+			command.SetTurn(0.);
+			it->SetCommands(command);
+			continue;
+		}
+		
 		const Government *gov = it->GetGovernment();
 		const Personality &personality = it->GetPersonality();
 		double healthRemaining = it->Health();
-		bool isPresent = (it->GetSystem() == playerSystem);
 		bool isStranded = IsStranded(*it);
 		bool thisIsLaunching = (isLaunching && isPresent);
 		if(isStranded || it->IsDisabled())
@@ -545,11 +642,14 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 		shared_ptr<Ship> target = it->GetTargetShip();
 		if(isPresent && !personality.IsSwarming())
 		{
-			// Each ship only switches targets twice a second, so that it can
-			// focus on damaging one particular ship.
-			targetTurn = (targetTurn + 1) & 31;
-			if(targetTurn == step || !target || target->IsDestroyed() || (target->IsDisabled()
-					&& personality.Disables()) || !target->IsTargetable())
+			// Use the target found above, if this ship looked for one. If not,
+			// it still needs a new target if its current one became invalid.
+			while(nextSearch < searches.size() && searches[nextSearch].first < shipIndex)
+				++nextSearch;
+			if(nextSearch < searches.size() && searches[nextSearch].first == shipIndex)
+				it->SetTargetShip(foundTargets[nextSearch]);
+			else if(target && (target->IsDestroyed() || (target->IsDisabled() && personality.Disables())
+					|| !target->IsTargetable()))
 				it->SetTargetShip(FindTarget(*it));
 		}
 		if(isPresent)
@@ -707,17 +807,18 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 				// Find the possible parents for orphaned fighters and drones.
 				auto parentChoices = vector<shared_ptr<Ship>>{};
 				parentChoices.reserve(ships.size() * .1);
-				auto getParentFrom = [&it, &gov, &parentChoices](const list<shared_ptr<Ship>> otherShips) -> shared_ptr<Ship>
+				// Check whether the given ship can carry this one. If it can't,
+				// but could otherwise be a parent, remember it as a choice.
+				auto canBeParent = [&it, &gov, &parentChoices](const shared_ptr<Ship> &other) -> bool
 				{
-					for(const auto &other : otherShips)
-						if(other->GetGovernment() == gov && other->GetSystem() == it->GetSystem() && !other->CanBeCarried())
-						{
-							if(!other->IsDisabled() && other->CanCarry(*it.get()))
-								return other;
-							else
-								parentChoices.emplace_back(other);
-						}
-					return shared_ptr<Ship>();
+					if(other->GetGovernment() == gov && other->GetSystem() == it->GetSystem() && !other->CanBeCarried())
+					{
+						if(!other->IsDisabled() && other->CanCarry(*it.get()))
+							return true;
+						else
+							parentChoices.emplace_back(other);
+					}
+					return false;
 				};
 				// Mission ships should only pick amongst ships from the same mission.
 				auto missionIt = it->IsSpecial() && !it->IsYours()
@@ -734,13 +835,20 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 					auto &npcs = missionIt->NPCs();
 					for(const auto &npc : npcs)
 					{
-						newParent = getParentFrom(npc.Ships());
-						if(newParent)
+						auto found = find_if(npc.Ships().begin(), npc.Ships().end(), canBeParent);
+						if(found != npc.Ships().end())
+						{
+							newParent = *found;
 							break;
+						}
 					}
 				}
 				else
-					newParent = getParentFrom(ships);
+				{
+					auto found = find_if(ships.begin(), ships.end(), canBeParent);
+					if(found != ships.end())
+						newParent = *found;
+				}
 				
 				// If a new parent was found, then this carried ship should always reparent
 				// as a ship of its own government is in-system and has space to carry it.
@@ -817,7 +925,7 @@ void AI::Step(const PlayerInfo &player, Command &activeCommands)
 			MoveIndependent(*it, command);
 		else if(parent->GetSystem() != it->GetSystem())
 		{
-			if(personality.IsStaying() || !it->Attributes().Get("fuel capacity"))
+			if(personality.IsStaying() || !it->Attributes().Get(Outfit::FUEL_CAPACITY))
 				MoveIndependent(*it, command);
 			else
 				MoveEscort(*it, command);
@@ -1137,8 +1245,8 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 	// mission NPCs) should consider friendly targets for surveillance.
 	if(!isYours && !target && (ship.IsSpecial() || scanPermissions.at(gov)))
 	{
-		bool cargoScan = ship.Attributes().Get("cargo scan power");
-		bool outfitScan = ship.Attributes().Get("outfit scan power");
+		bool cargoScan = ship.Attributes().Get(Outfit::CARGO_SCAN_POWER);
+		bool outfitScan = ship.Attributes().Get(Outfit::OUTFIT_SCAN_POWER);
 		if(cargoScan || outfitScan)
 		{
 			closest = numeric_limits<double>::infinity();
@@ -1170,7 +1278,7 @@ shared_ptr<Ship> AI::FindTarget(const Ship &ship) const
 	{
 		// Make sure the ship has somewhere to flee to.
 		const System *system = ship.GetSystem();
-		if(ship.JumpsRemaining() && (!system->Links().empty() || ship.Attributes().Get("jump drive")))
+		if(ship.JumpsRemaining() && (!system->Links().empty() || ship.Attributes().Get(Outfit::JUMP_DRIVE)))
 			target.reset();
 		else
 			for(const StellarObject &object : system->Objects())
@@ -1210,19 +1318,46 @@ vector<shared_ptr<Ship>> AI::GetShipsList(const Ship &ship, bool targetEnemies,
 	const auto &rosters = targetEnemies ? enemyLists : allyLists;
 	
 	const auto it = rosters.find(ship.GetGovernment());
-	if(it != rosters.end() && !it->second.empty())
+	if(it != rosters.end() && it->second.count)
 	{
-		targets.reserve(it->second.size());
-		
 		const System *here = ship.GetSystem();
 		const Point &p = ship.Position();
-		for(const auto &target : it->second)
-			if(target->IsTargetable() && target->GetSystem() == here
-					&& !(target->IsHyperspacing() && target->Velocity().Length() > 10.)
-					&& p.Distance(target->Position()) < maxRange
-					&& (ship.IsYours() || !target->GetPersonality().IsMarked())
-					&& (target->IsYours() || !ship.GetPersonality().IsMarked()))
-				targets.emplace_back(target);
+		auto isTarget = [&ship, here, &p, maxRange](const Ship &target) -> bool
+		{
+			return target.IsTargetable() && target.GetSystem() == here
+				&& !(target.IsHyperspacing() && target.Velocity().Length() > 10.)
+				&& p.Distance(target.Position()) < maxRange
+				&& (ship.IsYours() || !target.GetPersonality().IsMarked())
+				&& (target.IsYours() || !ship.GetPersonality().IsMarked());
+		};
+		
+		// If only nearby ships are wanted, look them up by position rather than
+		// checking every ship, unless the range covers so much of the grid that
+		// it would be slower. Any ship that passes the checks below is in the
+		// player's system and is targetable, so it will be in the collision set.
+		if(here == playerSystem && shipCollisions.CircleCost(maxRange) < it->second.count)
+		{
+			// This runs on several threads at once, so each one must have its
+			// own list of the ships in range.
+			thread_local vector<Body *> inRange;
+			shipCollisions.Circle(p, maxRange, inRange);
+			const Government *gov = ship.GetGovernment();
+			for(Body *body : inRange)
+			{
+				Ship *target = static_cast<Ship *>(body);
+				const Government *targetGov = target->GetGovernment();
+				if(targetGov && gov->IsEnemy(targetGov) == targetEnemies && isTarget(*target))
+					targets.emplace_back(target->shared_from_this());
+			}
+		}
+		else
+		{
+			targets.reserve(it->second.count);
+			for(const auto *roster : it->second.rosters)
+				for(const auto &target : *roster)
+					if(isTarget(*target))
+						targets.emplace_back(target);
+		}
 	}
 	
 	return targets;
@@ -1337,8 +1472,8 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 	else if(target)
 	{
 		// An AI ship that is targeting a non-hostile ship should scan it, or move on.
-		bool cargoScan = ship.Attributes().Get("cargo scan power");
-		bool outfitScan = ship.Attributes().Get("outfit scan power");
+		bool cargoScan = ship.Attributes().Get(Outfit::CARGO_SCAN_POWER);
+		bool outfitScan = ship.Attributes().Get(Outfit::OUTFIT_SCAN_POWER);
 		if((!cargoScan || Has(gov, target, ShipEvent::SCAN_CARGO))
 				&& (!outfitScan || Has(gov, target, ShipEvent::SCAN_OUTFITS)))
 			target.reset();
@@ -1366,7 +1501,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 		
 		vector<int> systemWeights;
 		int totalWeight = 0;
-		const set<const System *> &links = ship.Attributes().Get("jump drive")
+		const set<const System *> &links = ship.Attributes().Get(Outfit::JUMP_DRIVE)
 			? origin->Neighbors() : origin->Links();
 		if(jumps)
 		{
@@ -1451,7 +1586,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 	else if(ship.GetTargetStellar())
 	{
 		MoveToPlanet(ship, command);
-		if(!shouldStay && ship.Attributes().Get("fuel capacity")
+		if(!shouldStay && ship.Attributes().Get(Outfit::FUEL_CAPACITY)
 				&& ship.GetTargetStellar()->GetPlanet() && ship.GetTargetStellar()->GetPlanet()->CanLand(ship))
 			command |= Command::LAND;
 		else if(ship.Position().Distance(ship.GetTargetStellar()->Position()) < 100.)
@@ -1469,7 +1604,7 @@ void AI::MoveIndependent(Ship &ship, Command &command) const
 void AI::MoveEscort(Ship &ship, Command &command) const
 {
 	const Ship &parent = *ship.GetParent();
-	bool hasFuelCapacity = ship.Attributes().Get("fuel capacity") && ship.JumpFuel();
+	bool hasFuelCapacity = ship.Attributes().Get(Outfit::FUEL_CAPACITY) && ship.JumpFuel();
 	bool isStaying = ship.GetPersonality().IsStaying() || !hasFuelCapacity;
 	bool parentIsHere = (ship.GetSystem() == parent.GetSystem());
 	// Check if the parent has a target planet that is in the parent's system.
@@ -1521,8 +1656,17 @@ void AI::MoveEscort(Ship &ship, Command &command) const
 	// If the parent is in-system and planning to jump, non-staying escorts should follow suit.
 	else if(parent.Commands().Has(Command::JUMP) && parent.GetTargetSystem() && !isStaying)
 	{
-		DistanceMap distance(ship, parent.GetTargetSystem());
-		const System *dest = distance.Route(ship.GetSystem());
+		// Every escort would otherwise find its route again on every step until
+		// its parent jumps, so the route is only found again if the escort or
+		// its parent's destination has changed.
+		EscortRoute &route = escortRoutes[&ship];
+		if(route.from != ship.GetSystem() || route.to != parent.GetTargetSystem())
+		{
+			route.from = ship.GetSystem();
+			route.to = parent.GetTargetSystem();
+			route.next = DistanceMap(ship, route.to).Route(route.from);
+		}
+		const System *dest = route.next;
 		ship.SetTargetSystem(dest);
 		if(!dest)
 			// This ship has no route to the parent's destination system, so protect it until it jumps away.
@@ -1615,16 +1759,16 @@ bool AI::ShouldDock(const Ship &ship, const Ship &parent, bool playerShipsLaunch
 	// If a fighter has repair abilities, avoid having it get stuck oscillating between
 	// retreating and attacking when at exactly 25% health by adding hysteresis to the check.
 	double minHealth = RETREAT_HEALTH + .1 * !ship.Commands().Has(Command::DEPLOY);
-	if(ship.Health() < minHealth && (!ship.IsYours() || Preferences::Has("Damaged fighters retreat")))
+	if(ship.Health() < minHealth && (!ship.IsYours() || Preferences::Has(Preferences::DAMAGED_FIGHTERS_RETREAT)))
 		return true;
 	
 	// TODO: Reboard if in need of ammo.
 	
 	// If a fighter has fuel capacity but is very low, it should return if
 	// the parent can refuel it.
-	double maxFuel = ship.Attributes().Get("fuel capacity");
+	double maxFuel = ship.Attributes().Get(Outfit::FUEL_CAPACITY);
 	if(maxFuel && ship.Fuel() < .005 && parent.JumpFuel() < parent.Fuel() *
-			parent.Attributes().Get("fuel capacity") - maxFuel)
+			parent.Attributes().Get(Outfit::FUEL_CAPACITY) - maxFuel)
 		return true;
 	
 	// If an out-of-combat NPC fighter is carrying a significant cargo
@@ -1736,7 +1880,7 @@ bool AI::Stop(Ship &ship, Command &command, double maxSpeed, const Point directi
 	
 	// If you have a reverse thruster, figure out whether using it is faster
 	// than turning around and using your main thruster.
-	if(ship.Attributes().Get("reverse thrust"))
+	if(ship.Attributes().Get(Outfit::REVERSE_THRUST))
 	{
 		// Figure out your stopping time using your main engine:
 		double degreesToTurn = TO_DEG * acos(min(1., max(-1., -velocity.Unit().Dot(angle.Unit()))));
@@ -1744,7 +1888,7 @@ bool AI::Stop(Ship &ship, Command &command, double maxSpeed, const Point directi
 		forwardTime += stopTime;
 		
 		// Figure out your reverse thruster stopping time:
-		double reverseAcceleration = ship.Attributes().Get("reverse thrust") / ship.Mass();
+		double reverseAcceleration = ship.Attributes().Get(Outfit::REVERSE_THRUST) / ship.Mass();
 		double reverseTime = (180. - degreesToTurn) / ship.TurnRate();
 		reverseTime += speed / reverseAcceleration;
 		
@@ -1782,9 +1926,9 @@ bool AI::Stop(Ship &ship, Command &command, double maxSpeed, const Point directi
 
 void AI::PrepareForHyperspace(Ship &ship, Command &command)
 {
-	bool hasHyperdrive = ship.Attributes().Get("hyperdrive");
-	double scramThreshold = ship.Attributes().Get("scram drive");
-	bool hasJumpDrive = ship.Attributes().Get("jump drive");
+	bool hasHyperdrive = ship.Attributes().Get(Outfit::HYPERDRIVE);
+	double scramThreshold = ship.Attributes().Get(Outfit::SCRAM_DRIVE);
+	bool hasJumpDrive = ship.Attributes().Get(Outfit::JUMP_DRIVE);
 	if(!hasHyperdrive && !hasJumpDrive)
 		return;
 	
@@ -1824,9 +1968,9 @@ void AI::PrepareForHyperspace(Ship &ship, Command &command)
 	}
 	// If we're a jump drive, just stop.
 	else if(isJump)
-		Stop(ship, command, ship.Attributes().Get("jump speed"));
+		Stop(ship, command, ship.Attributes().Get(Outfit::JUMP_SPEED));
 	// Else stop in the fastest way to end facing in the right direction
-	else if(Stop(ship, command, ship.Attributes().Get("jump speed"), direction))
+	else if(Stop(ship, command, ship.Attributes().Get(Outfit::JUMP_SPEED), direction))
 		command.SetTurn(TurnToward(ship, direction));
 }
 
@@ -1929,12 +2073,12 @@ void AI::KeepStation(Ship &ship, Command &command, const Body &target)
 		command.SetTurn(targetAngle);
 	
 	// Determine whether to apply thrust.
-	Point drag = ship.Velocity() * (ship.Attributes().Get("drag") / mass);
-	if(ship.Attributes().Get("reverse thrust"))
+	Point drag = ship.Velocity() * (ship.Attributes().Get(Outfit::DRAG) / mass);
+	if(ship.Attributes().Get(Outfit::REVERSE_THRUST))
 	{
 		// Don't take drag into account when reverse thrusting, because this
 		// estimate of how it will be applied can be quite inaccurate.
-		Point a = (unit * (-ship.Attributes().Get("reverse thrust") / mass)).Unit();
+		Point a = (unit * (-ship.Attributes().Get(Outfit::REVERSE_THRUST) / mass)).Unit();
 		double direction = positionWeight * positionDelta.Dot(a) / POSITION_DEADBAND
 			+ velocityWeight * velocityDelta.Dot(a) / VELOCITY_DEADBAND;
 		if(direction > THRUST_DEADBAND)
@@ -2081,18 +2225,18 @@ void AI::PickUp(Ship &ship, Command &command, const Body &target)
 // energy strain, or undue thermal loads if almost overheated.
 bool AI::ShouldUseAfterburner(Ship &ship)
 {
-	if(!ship.Attributes().Get("afterburner thrust"))
+	if(!ship.Attributes().Get(Outfit::AFTERBURNER_THRUST))
 		return false;
 	
-	double fuel = ship.Fuel() * ship.Attributes().Get("fuel capacity");
-	double neededFuel = ship.Attributes().Get("afterburner fuel");
-	double energy = ship.Energy() * ship.Attributes().Get("energy capacity");
-	double neededEnergy = ship.Attributes().Get("afterburner energy");
+	double fuel = ship.Fuel() * ship.Attributes().Get(Outfit::FUEL_CAPACITY);
+	double neededFuel = ship.Attributes().Get(Outfit::AFTERBURNER_FUEL);
+	double energy = ship.Energy() * ship.Attributes().Get(Outfit::ENERGY_CAPACITY);
+	double neededEnergy = ship.Attributes().Get(Outfit::AFTERBURNER_ENERGY);
 	if(energy == 0.)
-		energy = ship.Attributes().Get("energy generation")
-				+ 0.2 * ship.Attributes().Get("solar collection")
-				- ship.Attributes().Get("energy consumption");
-	double outputHeat = ship.Attributes().Get("afterburner heat") / (100 * ship.Mass());
+		energy = ship.Attributes().Get(Outfit::ENERGY_GENERATION)
+				+ 0.2 * ship.Attributes().Get(Outfit::SOLAR_COLLECTION)
+				- ship.Attributes().Get(Outfit::ENERGY_CONSUMPTION);
+	double outputHeat = ship.Attributes().Get(Outfit::AFTERBURNER_HEAT) / (100 * ship.Mass());
 	if((!neededFuel || fuel - neededFuel > ship.JumpFuel())
 			&& (!neededEnergy || neededEnergy / energy < 0.25)
 			&& (!outputHeat || ship.Heat() + outputHeat < .9))
@@ -2184,7 +2328,7 @@ void AI::DoSurveillance(Ship &ship, Command &command, shared_ptr<Ship> &target)
 	{
 		// Approach the planet and "land" on it (i.e. scan it).
 		MoveToPlanet(ship, command);
-		double atmosphereScan = ship.Attributes().Get("atmosphere scan");
+		double atmosphereScan = ship.Attributes().Get(Outfit::ATMOSPHERE_SCAN);
 		double distance = ship.Position().Distance(ship.GetTargetStellar()->Position());
 		if(distance < atmosphereScan && !Random::Int(100))
 			ship.SetTargetStellar(nullptr);
@@ -2194,8 +2338,8 @@ void AI::DoSurveillance(Ship &ship, Command &command, shared_ptr<Ship> &target)
 	else if(target)
 	{
 		// Approach and scan the targeted, friendly ship's cargo or outfits.
-		bool cargoScan = ship.Attributes().Get("cargo scan power");
-		bool outfitScan = ship.Attributes().Get("outfit scan power");
+		bool cargoScan = ship.Attributes().Get(Outfit::CARGO_SCAN_POWER);
+		bool outfitScan = ship.Attributes().Get(Outfit::OUTFIT_SCAN_POWER);
 		// If the pointer to the target ship exists, it is targetable and in-system.
 		bool mustScanCargo = cargoScan && !Has(ship, target, ShipEvent::SCAN_CARGO);
 		bool mustScanOutfits = outfitScan && !Has(ship, target, ShipEvent::SCAN_OUTFITS);
@@ -2214,8 +2358,8 @@ void AI::DoSurveillance(Ship &ship, Command &command, shared_ptr<Ship> &target)
 		
 		// Consider scanning any non-hostile ship in this system that you haven't yet personally scanned.
 		vector<shared_ptr<Ship>> targetShips;
-		bool cargoScan = ship.Attributes().Get("cargo scan power");
-		bool outfitScan = ship.Attributes().Get("outfit scan power");
+		bool cargoScan = ship.Attributes().Get(Outfit::CARGO_SCAN_POWER);
+		bool outfitScan = ship.Attributes().Get(Outfit::OUTFIT_SCAN_POWER);
 		if(cargoScan || outfitScan)
 			for(const auto &grit : governmentRosters)
 			{
@@ -2234,7 +2378,7 @@ void AI::DoSurveillance(Ship &ship, Command &command, shared_ptr<Ship> &target)
 		
 		// Consider scanning any planetary object in the system, if able.
 		vector<const StellarObject *> targetPlanets;
-		double atmosphereScan = ship.Attributes().Get("atmosphere scan");
+		double atmosphereScan = ship.Attributes().Get(Outfit::ATMOSPHERE_SCAN);
 		if(atmosphereScan)
 			for(const StellarObject &object : system->Objects())
 				if(!object.IsStar() && !object.IsStation())
@@ -2244,7 +2388,7 @@ void AI::DoSurveillance(Ship &ship, Command &command, shared_ptr<Ship> &target)
 		vector<const System *> targetSystems;
 		if(ship.JumpsRemaining(false))
 		{
-			const auto &links  = ship.Attributes().Get("jump drive") ? system->Neighbors() : system->Links();
+			const auto &links  = ship.Attributes().Get(Outfit::JUMP_DRIVE) ? system->Neighbors() : system->Links();
 			targetSystems.insert(targetSystems.end(), links.begin(), links.end());
 		}
 		
@@ -2287,18 +2431,18 @@ void AI::DoMining(Ship &ship, Command &command)
 	shared_ptr<Minable> target = ship.GetTargetAsteroid();
 	if(!target || target->Velocity().Length() > ship.MaxVelocity())
 	{
-		for(const shared_ptr<Minable> &minable : minables)
-		{
-			Point offset = minable->Position() - ship.Position();
-			// Target only nearby minables that are within 45deg of the current heading
-			// and not moving faster than the ship can catch.
-			if(offset.Length() < 800. && offset.Unit().Dot(ship.Facing().Unit()) > .7
-					&& minable->Velocity().Dot(offset.Unit()) < ship.MaxVelocity())
+		// Target only nearby minables that are within 45deg of the current heading
+		// and not moving faster than the ship can catch.
+		Body *found = minableCollisions.FindInCircle(ship.Position(), 800., [&ship](const Body *body)
 			{
-				target = minable;
-				ship.SetTargetAsteroid(target);
-				break;
-			}
+				Point offset = body->Position() - ship.Position();
+				return offset.Unit().Dot(ship.Facing().Unit()) > .7
+					&& body->Velocity().Dot(offset.Unit()) < ship.MaxVelocity();
+			});
+		if(found)
+		{
+			target = static_cast<Minable *>(found)->shared_from_this();
+			ship.SetTargetAsteroid(target);
 		}
 	}
 	if(target)
@@ -2339,14 +2483,17 @@ bool AI::DoHarvesting(Ship &ship, Command &command)
 		
 		// Don't chase anything that will take more than 10 seconds to reach.
 		double bestTime = 600.;
-		for(const shared_ptr<Flotsam> &it : flotsam)
+		vector<Body *> nearby;
+		flotsamCollisions.Circle(ship.Position(), 800., nearby);
+		for(Body *body : nearby)
 		{
+			Flotsam *it = static_cast<Flotsam *>(body);
 			if(ship.Cargo().Free() < it->UnitSize())
 				continue;
 			// Only pick up flotsam that is nearby and that you are facing toward.
 			Point p = it->Position() - ship.Position();
 			double range = p.Length();
-			if(range > 800. || (range > 100. && p.Unit().Dot(ship.Facing().Unit()) < .9))
+			if(range > 100. && p.Unit().Dot(ship.Facing().Unit()) < .9)
 				continue;
 			
 			// Estimate how long it would take to intercept this flotsam.
@@ -2361,7 +2508,7 @@ bool AI::DoHarvesting(Ship &ship, Command &command)
 			if(time < bestTime)
 			{
 				bestTime = time;
-				target = it;
+				target = it->shared_from_this();
 			}
 		}
 		if(!target)
@@ -2385,15 +2532,15 @@ bool AI::DoHarvesting(Ship &ship, Command &command)
 // Check if this ship should cloak. Returns true if this ship decided to run away while cloaking.
 bool AI::DoCloak(Ship &ship, Command &command)
 {
-	if(ship.Attributes().Get("cloak"))
+	if(ship.Attributes().Get(Outfit::CLOAK))
 	{
 		// Never cloak if it will cause you to be stranded.
 		const Outfit &attributes = ship.Attributes();
-		double fuelCost = attributes.Get("cloaking fuel") + attributes.Get("fuel consumption") - attributes.Get("fuel generation");
-		if(attributes.Get("cloaking fuel") && !attributes.Get("ramscoop"))
+		double fuelCost = attributes.Get(Outfit::CLOAKING_FUEL) + attributes.Get(Outfit::FUEL_CONSUMPTION) - attributes.Get(Outfit::FUEL_GENERATION);
+		if(attributes.Get(Outfit::CLOAKING_FUEL) && !attributes.Get(Outfit::RAMSCOOP))
 		{
-			double fuel = ship.Fuel() * attributes.Get("fuel capacity");
-			int steps = ceil((1. - ship.Cloaking()) / attributes.Get("cloak"));
+			double fuel = ship.Fuel() * attributes.Get(Outfit::FUEL_CAPACITY);
+			int steps = ceil((1. - ship.Cloaking()) / attributes.Get(Outfit::CLOAK));
 			// Only cloak if you will be able to fully cloak and also maintain it
 			// for as long as it will take you to reach full cloak.
 			fuel -= fuelCost * (1 + 2 * steps);
@@ -2435,7 +2582,7 @@ bool AI::DoCloak(Ship &ship, Command &command)
 		bool cloakFreely = (fuelCost <= 0.) && !ship.GetShipToAssist();
 		// If this ship is injured / repairing, it should cloak while under threat.
 		bool cloakToRepair = (ship.Health() < RETREAT_HEALTH + hysteresis)
-				&& (attributes.Get("shield generation") || attributes.Get("hull repair rate"));
+				&& (attributes.Get(Outfit::SHIELD_GENERATION) || attributes.Get(Outfit::HULL_REPAIR_RATE));
 		if(cloakToRepair && (cloakFreely || range < 2000. * (1. + hysteresis)))
 		{
 			command |= Command::CLOAK;
@@ -2472,28 +2619,38 @@ void AI::DoScatter(Ship &ship, Command &command)
 	
 	double turnRate = ship.TurnRate();
 	double acceleration = ship.Acceleration();
-	// TODO: If there are many ships, use CollisionSet::Circle or another
-	// suitable method to limit which ships are checked.
-	for(const shared_ptr<Ship> &other : ships)
+	auto scatter = [&ship, &command, turnRate, acceleration](const Ship &other) -> bool
 	{
 		// Do not scatter away from yourself, or ships in other systems.
-		if(other.get() == &ship || other->GetSystem() != ship.GetSystem())
-			continue;
+		if(&other == &ship || other.GetSystem() != ship.GetSystem())
+			return false;
 		
 		// Check for any ships that have nearly the same movement profile as
 		// this ship and are in nearly the same location.
-		Point offset = other->Position() - ship.Position();
+		Point offset = other.Position() - ship.Position();
 		if(offset.LengthSquared() > 400.)
-			continue;
-		if(fabs(other->TurnRate() / turnRate - 1.) > .05)
-			continue;
-		if(fabs(other->Acceleration() / acceleration - 1.) > .05)
-			continue;
+			return false;
+		if(fabs(other.TurnRate() / turnRate - 1.) > .05)
+			return false;
+		if(fabs(other.Acceleration() / acceleration - 1.) > .05)
+			return false;
 		
 		// Move away from this ship. What side of me is it on?
 		command.SetTurn(offset.Cross(ship.Facing().Unit()) > 0. ? 1. : -1.);
-		return;
+		return true;
+	};
+	
+	// In the player's system, only the ships that are close by need to be
+	// checked. Elsewhere, check every ship.
+	if(ship.GetSystem() == playerSystem)
+	{
+		shipCollisions.FindInCircle(ship.Position(), 20.,
+			[&scatter](const Body *body) { return scatter(*static_cast<const Ship *>(body)); });
 	}
+	else
+		for(const shared_ptr<Ship> &other : ships)
+			if(scatter(*other))
+				return;
 }
 
 
@@ -2532,10 +2689,10 @@ Point AI::StoppingPoint(const Ship &ship, const Point &targetVelocity, bool &sho
 	// The average term's value will be v / 2. So:
 	stopDistance += .5 * v * v / acceleration;
 	
-	if(ship.Attributes().Get("reverse thrust"))
+	if(ship.Attributes().Get(Outfit::REVERSE_THRUST))
 	{
 		// Figure out your reverse thruster stopping distance:
-		double reverseAcceleration = ship.Attributes().Get("reverse thrust") / ship.Mass();
+		double reverseAcceleration = ship.Attributes().Get(Outfit::REVERSE_THRUST) / ship.Mass();
 		double reverseDistance = v * (180. - degreesToTurn) / turnRate;
 		reverseDistance += .5 * v * v / reverseAcceleration;
 		
@@ -2671,6 +2828,28 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 			}
 		return;
 	}
+	// Gather the positions and velocities of all the targets into flat arrays,
+	// so that for each turret, the rendezvous times for all of them can be
+	// found in one batch.
+	size_t count = targets.size();
+	vector<double> buffer(9 * count);
+	double *targetX = buffer.data();
+	double *targetY = targetX + count;
+	double *targetVX = targetY + count;
+	double *targetVY = targetVX + count;
+	double *px = targetVY + count;
+	double *py = px + count;
+	double *vx = py + count;
+	double *vy = vx + count;
+	double *times = vy + count;
+	for(size_t i = 0; i < count; ++i)
+	{
+		targetX[i] = targets[i]->Position().X();
+		targetY[i] = targets[i]->Position().Y();
+		targetVX[i] = targets[i]->Velocity().X();
+		targetVY[i] = targets[i]->Velocity().Y();
+	}
+	
 	// Each hardpoint should aim at the target that it is "closest" to hitting.
 	for(const Hardpoint &hardpoint : ship.Weapons())
 		if(hardpoint.CanAim())
@@ -2684,25 +2863,32 @@ void AI::AimTurrets(const Ship &ship, Command &command, bool opportunistic) cons
 			// Get this projectile's average velocity.
 			const Weapon *weapon = hardpoint.GetOutfit();
 			double vp = weapon->Velocity() + .5 * weapon->RandomVelocity();
+			
+			// Only take the ship's velocity into account if this weapon does not
+			// have its own acceleration.
+			bool isRelative = !weapon->Acceleration();
+			for(size_t i = 0; i < count; ++i)
+			{
+				vx[i] = isRelative ? targetVX[i] - ship.Velocity().X() : targetVX[i];
+				vy[i] = isRelative ? targetVY[i] - ship.Velocity().Y() : targetVY[i];
+				// By the time this action is performed, the target will have
+				// moved forward one time step.
+				px[i] = (targetX[i] - start.X()) + vx[i];
+				py[i] = (targetY[i] - start.Y()) + vy[i];
+			}
+			// Find out how long it would take for this projectile to reach each target.
+			RendezvousTimes(px, py, vx, vy, vp, times, count);
+			
 			// Loop through each body this hardpoint could shoot at. Find the
 			// one that is the "best" in terms of how many frames it will take
 			// to aim at it and for a projectile to hit it.
 			double bestScore = numeric_limits<double>::infinity();
 			double bestAngle = 0.;
-			for(const Body *target : targets)
+			for(size_t i = 0; i < count; ++i)
 			{
-				Point p = target->Position() - start;
-				Point v = target->Velocity();
-				// Only take the ship's velocity into account if this weapon
-				// does not have its own acceleration.
-				if(!weapon->Acceleration())
-					v -= ship.Velocity();
-				// By the time this action is performed, the target will
-				// have moved forward one time step.
-				p += v;
-				
-				// Find out how long it would take for this projectile to reach the target.
-				double rendezvousTime = RendezvousTime(p, v, vp);
+				Point p(px[i], py[i]);
+				Point v(vx[i], vy[i]);
+				double rendezvousTime = times[i];
 				// If there is no intersection (i.e. the turret is not facing the target),
 				// consider this target "out-of-range" but still targetable.
 				if(std::isnan(rendezvousTime))
@@ -2804,6 +2990,11 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 			&& find(enemies.cbegin(), enemies.cend(), currentTarget) == enemies.cend())
 		enemies.push_back(currentTarget);
 	
+	// Get the ship that each of this ship's weapons would have hit the last time
+	// it was checked.
+	vector<const Ship *> &solutions = fireSolutions[&ship];
+	solutions.resize(ship.Weapons().size());
+	
 	int index = -1;
 	for(const Hardpoint &hardpoint : ship.Weapons())
 	{
@@ -2830,7 +3021,7 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 		// fuel that you cannot leave the system if necessary.
 		if(weapon->FiringFuel())
 		{
-			double fuel = ship.Fuel() * ship.Attributes().Get("fuel capacity");
+			double fuel = ship.Fuel() * ship.Attributes().Get(Outfit::FUEL_CAPACITY);
 			fuel -= weapon->FiringFuel();
 			// If the ship is not ever leaving this system, it does not need to
 			// reserve any fuel.
@@ -2880,13 +3071,14 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 			}
 			continue;
 		}
-		// For non-homing weapons:
-		for(const auto &target : enemies)
+		// For non-homing weapons, check if a shot fired now would hit any of
+		// the enemy ships.
+		auto wouldHit = [&](const shared_ptr<Ship> &target) -> bool
 		{
 			// Don't shoot ships we want to plunder.
 			bool hasBoarded = Has(ship, target, ShipEvent::BOARD);
 			if(target->IsDisabled() && spareDisabled && !hasBoarded && !disabledOverride)
-				continue;
+				return false;
 			
 			Point p = target->Position() - start;
 			Point v = target->Velocity();
@@ -2901,7 +3093,7 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 			// Non-homing weapons may have a blast radius or proximity trigger.
 			// Do not fire this weapon if we will be caught in the blast.
 			if(!weapon->IsSafe() && p.Length() <= (weapon->BlastRadius() + weapon->TriggerRadius()))
-				continue;
+				return false;
 			
 			// Get the vector the weapon will travel along.
 			v = (ship.Facing() + hardpoint.GetAngle()).Unit() * vp - v;
@@ -2909,12 +3101,33 @@ void AI::AutoFire(const Ship &ship, Command &command, bool secondary) const
 			v *= lifetime;
 			
 			const Mask &mask = target->GetMask(step);
-			if(mask.Collide(-p, v, target->Facing()) < 1.)
-			{
-				command.SetFire(index);
-				break;
-			}
+			return (mask.Collide(-p, v, target->Facing()) < 1.);
+		};
+		// From one step to the next, the ship a weapon would hit rarely changes,
+		// so check the one it would have hit last time before all the others.
+		const Ship *&previous = solutions[index];
+		bool shouldFire = false;
+		if(previous)
+			for(const auto &target : enemies)
+				if(target.get() == previous)
+				{
+					shouldFire = wouldHit(target);
+					break;
+				}
+		if(!shouldFire)
+		{
+			const Ship *skip = previous;
+			previous = nullptr;
+			for(const auto &target : enemies)
+				if(target.get() != skip && wouldHit(target))
+				{
+					shouldFire = true;
+					previous = target.get();
+					break;
+				}
 		}
+		if(shouldFire)
+			command.SetFire(index);
 	}
 }
 
@@ -3000,6 +3213,57 @@ double AI::RendezvousTime(const Point &p, const Point &v, double vp)
 
 
 
+// Calculate the rendezvous times for a batch of targets, whose relative
+// positions and velocities are given as arrays of x and y coordinates. Each
+// result is exactly what RendezvousTime() would return for that target.
+void AI::RendezvousTimes(const double *px, const double *py, const double *vx, const double *vy,
+	double vp, double *times, size_t count)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	// Solve the quadratic for two targets at once. If the discriminant is
+	// negative, its square root is NaN, so neither solution is positive and
+	// the result is NaN, just as in the scalar version.
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d sign = _mm_set1_pd(-0.);
+	const __m128d nan = _mm_set1_pd(numeric_limits<double>::quiet_NaN());
+	const __m128d two = _mm_set1_pd(2.);
+	const __m128d four = _mm_set1_pd(4.);
+	const __m128d vp2 = _mm_set1_pd(vp * vp);
+	for( ; i + 2 <= count; i += 2)
+	{
+		__m128d x = _mm_loadu_pd(px + i);
+		__m128d y = _mm_loadu_pd(py + i);
+		__m128d dx = _mm_loadu_pd(vx + i);
+		__m128d dy = _mm_loadu_pd(vy + i);
+		
+		__m128d a = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), vp2);
+		__m128d b = _mm_mul_pd(two, _mm_add_pd(_mm_mul_pd(x, dx), _mm_mul_pd(y, dy)));
+		__m128d c = _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y));
+		__m128d discriminant = _mm_sqrt_pd(_mm_sub_pd(_mm_mul_pd(b, b), _mm_mul_pd(_mm_mul_pd(four, a), c)));
+		
+		__m128d minusB = _mm_xor_pd(b, sign);
+		__m128d twoA = _mm_mul_pd(two, a);
+		__m128d r1 = _mm_div_pd(_mm_add_pd(minusB, discriminant), twoA);
+		__m128d r2 = _mm_div_pd(_mm_sub_pd(minusB, discriminant), twoA);
+		__m128d has1 = _mm_cmpge_pd(r1, zero);
+		__m128d has2 = _mm_cmpge_pd(r2, zero);
+		
+		// These match the results of min(r1, r2) and max(r1, r2).
+		__m128d both = _mm_and_pd(has1, has2);
+		__m128d either = _mm_or_pd(has1, has2);
+		__m128d result = _mm_or_pd(_mm_and_pd(both, _mm_min_pd(r2, r1)),
+			_mm_andnot_pd(both, _mm_max_pd(r2, r1)));
+		result = _mm_or_pd(_mm_and_pd(either, result), _mm_andnot_pd(either, nan));
+		_mm_storeu_pd(times + i, result);
+	}
+#endif
+	for( ; i < count; ++i)
+		times[i] = RendezvousTime(Point(px[i], py[i]), Point(vx[i], vy[i]), vp);
+}
+
+
+
 void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommands)
 {
 	Command command;
@@ -3122,7 +3386,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 				}
 			}
 		// If no ship was found, look for nearby asteroids.
-		double asteroidRange = 100. * sqrt(ship.Attributes().Get("asteroid scan power"));
+		double asteroidRange = ship.AsteroidScanRange();
 		if(!found && asteroidRange)
 		{
 			for(const shared_ptr<Minable> &asteroid : minables)
@@ -3314,7 +3578,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 		if(!ship.GetTargetSystem() && !isWormhole)
 		{
 			double bestMatch = -2.;
-			const auto &links = (ship.Attributes().Get("jump drive") ?
+			const auto &links = (ship.Attributes().Get(Outfit::JUMP_DRIVE) ?
 				ship.GetSystem()->Neighbors() : ship.GetSystem()->Links());
 			for(const System *link : links)
 			{
@@ -3346,8 +3610,8 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 		command |= Command::SCAN;
 	
 	const shared_ptr<const Ship> target = ship.GetTargetShip();
-	AimTurrets(ship, command, !Preferences::Has("Turrets focus fire"));
-	if(Preferences::Has("Automatic firing") && !ship.IsBoarding()
+	AimTurrets(ship, command, !Preferences::Has(Preferences::TURRETS_FOCUS_FIRE));
+	if(Preferences::Has(Preferences::AUTOMATIC_FIRING) && !ship.IsBoarding()
 			&& !(autoPilot | activeCommands).Has(Command::LAND | Command::JUMP | Command::BOARD)
 			&& (!target || target->GetGovernment()->IsEnemy()))
 		AutoFire(ship, command, false);
@@ -3359,7 +3623,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 			command.SetTurn(activeCommands.Has(Command::RIGHT) - activeCommands.Has(Command::LEFT));
 		if(activeCommands.Has(Command::BACK))
 		{
-			if(!activeCommands.Has(Command::FORWARD) && ship.Attributes().Get("reverse thrust"))
+			if(!activeCommands.Has(Command::FORWARD) && ship.Attributes().Get(Outfit::REVERSE_THRUST))
 				command |= Command::BACK;
 			else if(!activeCommands.Has(Command::RIGHT | Command::LEFT))
 				command.SetTurn(TurnBackward(ship));
@@ -3392,8 +3656,8 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 			autoPilot = activeCommands;
 	}
 	bool shouldAutoAim = false;
-	if(Preferences::Has("Automatic aiming") && !command.Turn() && !ship.IsBoarding()
-			&& (Preferences::Has("Automatic firing") || activeCommands.Has(Command::PRIMARY))
+	if(Preferences::Has(Preferences::AUTOMATIC_AIMING) && !command.Turn() && !ship.IsBoarding()
+			&& (Preferences::Has(Preferences::AUTOMATIC_FIRING) || activeCommands.Has(Command::PRIMARY))
 			&& ((target && target->GetSystem() == ship.GetSystem() && target->IsTargetable())
 				|| ship.GetTargetAsteroid())
 			&& !autoPilot.Has(Command::LAND | Command::JUMP | Command::BOARD))
@@ -3452,7 +3716,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 	}
 	else if(autoPilot.Has(Command::JUMP))
 	{
-		if(!ship.Attributes().Get("hyperdrive") && !ship.Attributes().Get("jump drive"))
+		if(!ship.Attributes().Get(Outfit::HYPERDRIVE) && !ship.Attributes().Get(Outfit::JUMP_DRIVE))
 		{
 			Messages::Add("You do not have a hyperdrive installed.");
 			autoPilot.Clear();
@@ -3492,7 +3756,7 @@ void AI::MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommand
 	if(ship.HasBays() && isLaunching)
 	{
 		command |= Command::DEPLOY;
-		Deploy(ship, !Preferences::Has("Damaged fighters retreat"));
+		Deploy(ship, !Preferences::Has(Preferences::DAMAGED_FIGHTERS_RETREAT));
 	}
 	if(isCloaking)
 		command |= Command::CLOAK;
@@ -3551,8 +3815,13 @@ bool AI::Has(const Ship &ship, const Government *government, int type) const
 
 void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const System *playerSystem)
 {
-	// Tally the strength of a government by the cost of its present and able ships.
-	governmentRosters.clear();
+	// Tally the strength of a government by the cost of its present and able
+	// ships. The rosters are emptied rather than erased, so that each one
+	// keeps its memory from one step to the next while that government is
+	// present, and only the rosters of governments which are not present
+	// any more are erased.
+	for(auto &it : governmentRosters)
+		it.second.clear();
 	for(const auto &it : ships)
 		if(it->GetGovernment() && it->GetSystem() == playerSystem)
 		{
@@ -3560,6 +3829,13 @@ void AI::UpdateStrengths(map<const Government *, int64_t> &strength, const Syste
 			if(!it->IsDisabled())
 				strength[it->GetGovernment()] += it->Cost();
 		}
+	for(auto it = governmentRosters.begin(); it != governmentRosters.end(); )
+	{
+		if(it->second.empty())
+			it = governmentRosters.erase(it);
+		else
+			++it;
+	}
 	
 	// Strengths of enemies and allies are rebuilt every step.
 	enemyStrength.clear();
@@ -3617,15 +3893,13 @@ void AI::CacheShipLists()
 	enemyLists.clear();
 	for(const auto &git : governmentRosters)
 	{
-		allyLists.emplace(git.first, vector<shared_ptr<Ship>>());
-		allyLists.at(git.first).reserve(ships.size());
-		enemyLists.emplace(git.first, vector<shared_ptr<Ship>>());
-		enemyLists.at(git.first).reserve(ships.size());
+		ShipLists &allies = allyLists[git.first];
+		ShipLists &enemies = enemyLists[git.first];
 		for(const auto &oit : governmentRosters)
 		{
-			auto &list = git.first->IsEnemy(oit.first)
-					? enemyLists[git.first] : allyLists[git.first];
-			list.insert(list.end(), oit.second.begin(), oit.second.end());
+			ShipLists &lists = git.first->IsEnemy(oit.first) ? enemies : allies;
+			lists.rosters.push_back(&oit.second);
+			lists.count += oit.second.size();
 		}
 	}
 }
@@ -17,15 +17,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 
 #include <cstdint>
-#include <list>
 #include <map>
 #include <memory>
+#include <set>
 #include <vector>
 
 class Angle;
 class AsteroidField;
 class Body;
-class Flotsam;
+class CollisionSet;
 class Government;
 class Minable;
 class PlayerInfo;
@@ -33,6 +33,7 @@ class Ship;
 class ShipEvent;
 class StellarObject;
 class System;
+class WorkerPool;
 
 
 
@@ -46,9 +47,12 @@ class AI {
 public:
 	// Any object that can be a ship's target is in a list of this type:
 template <class Type>
-	using List = std::list<std::shared_ptr<Type>>;
-	// Constructor, giving the AI access to various object lists.
-	AI(const List<Ship> &ships, const List<Minable> &minables, const List<Flotsam> &flotsam);
+	using List = std::vector<std::shared_ptr<Type>>;
+	// Constructor, giving the AI access to various object lists. The collision
+	// sets must hold all the ships in the player's system that can be targeted,
+	// and all the minables and flotsam in it.
+	AI(const List<Ship> &ships, const List<Minable> &minables, const CollisionSet &shipCollisions,
+		const CollisionSet &minableCollisions, const CollisionSet &flotsamCollisions);
 	
 	// Fleet commands from the player.
 	void IssueShipTarget(const PlayerInfo &player, const std::shared_ptr<Ship> &target);
@@ -57,14 +61,15 @@ template <class Type>
 	void UpdateKeys(PlayerInfo &player, Command &clickCommands);
 	
 	// Allow the AI to track any events it is interested in.
-	void UpdateEvents(const std::list<ShipEvent> &events);
+	void UpdateEvents(const std::vector<ShipEvent> &events);
 	// Reset the AI's memory of events.
 	void Clean();
 	// Clear ship orders. This should be done when the player lands on a planet,
 	// but not when they jump from one system to another.
 	void ClearOrders();
-	// Issue AI commands to all ships for one game step.
-	void Step(const PlayerInfo &player, Command &activeCommands);
+	// Issue AI commands to all ships for one game step. The given workers are
+	// used to find targets for many ships at once.
+	void Step(const PlayerInfo &player, Command &activeCommands, WorkerPool &workers);
 	
 	// Get the in-system strength of each government's allies and enemies.
 	int64_t AllyStrength(const Government *government);
@@ -132,6 +137,9 @@ private:
 	// target's relative position and velocity and the velocity of the
 	// projectile. If it cannot hit the target, this returns NaN.
 	static double RendezvousTime(const Point &p, const Point &v, double vp);
+	// Calculate the rendezvous times for a whole batch of targets at once.
+	static void RendezvousTimes(const double *px, const double *py, const double *vx, const double *vy,
+		double vp, double *times, size_t count);
 	
 	void MovePlayer(Ship &ship, const PlayerInfo &player, Command &activeCommands);
 	
@@ -165,6 +173,15 @@ private:
 		Point point;
 		const System *targetSystem = nullptr;
 	};
+	
+	// The ships of all the governments that one government considers to be its
+	// enemies (or allies). This refers to those governments' rosters instead of
+	// copying them, and keeps track of the total number of ships in them.
+	class ShipLists {
+	public:
+		std::vector<const std::vector<std::shared_ptr<Ship>> *> rosters;
+		size_t count = 0;
+	};
 
 
 private:
@@ -177,7 +194,14 @@ private:
 	// Data from the game engine.
 	const List<Ship> &ships;
 	const List<Minable> &minables;
-	const List<Flotsam> &flotsam;
+	// Spatial lookup of the ships in the player's system, for finding which
+	// ships are near a given point without checking every ship.
+	const CollisionSet &shipCollisions;
+	// The same for the minables and flotsam, so miners and harvesters only
+	// have to consider the ones that are within reach.
+	const CollisionSet &minableCollisions;
+	const CollisionSet &flotsamCollisions;
+	const System *playerSystem = nullptr;
 	
 	// The current step count for the AI, ranging from 0 to 30. Its value
 	// helps limit how often certain actions occur (such as changing targets).
@@ -210,14 +234,30 @@ private:
 	std::map<const Ship *, Angle> miningAngle;
 	std::map<const Ship *, int> miningTime;
 	std::map<const Ship *, double> appeasmentThreshold;
+	// Ships whose scheduled target search was put off to the next step. These
+	// are weak pointers, so a new ship can never be mistaken for one that was
+	// destroyed, even if it is given the same address.
+	std::set<std::weak_ptr<const Ship>, Comp> delayedSearches;
+	// For each weapon of each ship, the ship that AutoFire() last found it
+	// would hit. These pointers are only compared, never dereferenced.
+	mutable std::map<const Ship *, std::vector<const Ship *>> fireSolutions;
+	// For each escort whose parent is about to jump, the next system on its
+	// route to the parent's destination, and the systems it was found for.
+	class EscortRoute {
+	public:
+		const System *from = nullptr;
+		const System *to = nullptr;
+		const System *next = nullptr;
+	};
+	mutable std::map<const Ship *, EscortRoute> escortRoutes;
 	
 	std::map<const Ship *, int64_t> shipStrength;
 	
 	std::map<const Government *, int64_t> enemyStrength;
 	std::map<const Government *, int64_t> allyStrength;
 	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> governmentRosters;
-	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> enemyLists;
-	std::map<const Government *, std::vector<std::shared_ptr<Ship>>> allyLists;
+	std::map<const Government *, ShipLists> enemyLists;
+	std::map<const Government *, ShipLists> allyLists;
 };
 
 
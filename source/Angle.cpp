@@ -31,6 +31,25 @@ namespace {
 	const int32_t MASK = STEPS - 1;
 	const double DEG_TO_STEP = STEPS / 360.;
 	const double STEP_TO_RAD = PI / (STEPS / 2);
+
+#ifdef ES_COMPACT_ANGLES
+	// The number of entries in the table for the fine part of an angle.
+	const int32_t FINE_STEPS = 0x100;
+	
+	// Get a table of the (sine, cosine) of the given number of angles, which
+	// are the given number of steps apart.
+	vector<Point> SineTable(int32_t count, int32_t stride)
+	{
+		vector<Point> table;
+		table.reserve(count);
+		for(int32_t i = 0; i < count; ++i)
+		{
+			double radians = i * stride * STEP_TO_RAD;
+			table.emplace_back(sin(radians), cos(radians));
+		}
+		return table;
+	}
+#endif
 }
 
 
@@ -128,6 +147,22 @@ Angle Angle::operator-() const
 // Get a unit vector in the direction of this angle.
 Point Angle::Unit() const
 {
+#ifdef ES_COMPACT_ANGLES
+	// Split the angle into a coarse and a fine part, each with its own lookup
+	// table of sines and cosines, and combine them with the angle addition
+	// formulas. That is a few more multiplications, but the two tables take up
+	// only 8 kB instead of 1 MB, so they stay in the L1 cache. The results
+	// differ from the full table by no more than a few bits of rounding.
+	static const vector<Point> coarse = SineTable(STEPS / FINE_STEPS, FINE_STEPS);
+	static const vector<Point> fine = SineTable(FINE_STEPS, 1);
+	const Point &a = coarse[angle / FINE_STEPS];
+	const Point &b = fine[angle % FINE_STEPS];
+	// The graphics use the usual screen coordinate system, meaning that
+	// positive Y is down rather than up. Angles are clock angles, i.e.
+	// 0 is 12:00 and angles increase in the clockwise direction. So, an
+	// angle of 0 degrees is pointing in the direction (0, -1).
+	return Point(a.X() * b.Y() + a.Y() * b.X(), a.X() * b.X() - a.Y() * b.Y());
+#else
 	// The very first time this is called, create a lookup table of unit vectors.
 	static vector<Point> cache;
 	if(cache.empty())
@@ -144,6 +179,7 @@ Point Angle::Unit() const
 		}
 	}
 	return cache[angle];
+#endif
 }
 
 
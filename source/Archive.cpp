@@ -0,0 +1,229 @@
+/* Archive.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Archive.h"
+
+#include "File.h"
+#include "Files.h"
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// This must be changed whenever the format of the file changes, so that an
+	// old archive will be ignored instead of being misread.
+	const char SIGNATURE[] = "Endless Sky archive 1\n";
+	const size_t SIGNATURE_SIZE = sizeof(SIGNATURE) - 1;
+	
+	// The contents of each file are aligned to this many bytes.
+	const uint64_t ALIGNMENT = 16;
+	
+	// An archive may be used on a different machine than the one that wrote
+	// it, so values are stored in little-endian byte order.
+	template <class Type>
+	void WriteValue(string &out, Type value)
+	{
+		for(size_t i = 0; i < sizeof(value); ++i)
+			out += static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+	}
+	
+	template <class Type>
+	bool ReadValue(const char *&it, const char *end, Type &value)
+	{
+		if(static_cast<size_t>(end - it) < sizeof(value))
+			return false;
+		uint64_t result = 0;
+		for(size_t i = 0; i < sizeof(value); ++i)
+			result |= static_cast<uint64_t>(static_cast<unsigned char>(*it++)) << (8 * i);
+		value = static_cast<Type>(result);
+		return true;
+	}
+	
+	// Which archive a file is in, and where its contents are.
+	class Entry {
+	public:
+		size_t archive;
+		uint64_t offset;
+		uint64_t size;
+	};
+	
+	// The path and time stamp of each archive that has been added, and where
+	// each file in them is. These are only modified while the game data is
+	// being loaded, before any of the files are read.
+	vector<pair<string, time_t>> archives;
+	map<string, Entry> entries;
+}
+
+
+
+// Pack the given files, which must all be inside the given directory, into an
+// archive at the given path. Returns false if writing the file failed.
+bool Archive::Write(const string &path, const string &directory, const vector<string> &files)
+{
+	// Sort the files by their path within the directory, and find out where
+	// the contents of each one will go.
+	map<string, pair<string, uint64_t>> sorted;
+	for(const string &file : files)
+		if(!file.compare(0, directory.length(), directory))
+			sorted[file.substr(directory.length())] = make_pair(file, static_cast<uint64_t>(Files::Size(file)));
+	
+	// The index holds the number of files, and then the length of each path,
+	// the path itself, and the offset and size of the contents.
+	uint64_t offset = SIGNATURE_SIZE + 8 + 4;
+	for(const auto &it : sorted)
+		offset += 4 + it.first.length() + 16;
+	
+	string index;
+	WriteValue<uint32_t>(index, sorted.size());
+	for(const auto &it : sorted)
+	{
+		offset = (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		WriteValue<uint32_t>(index, it.first.length());
+		index += it.first;
+		WriteValue(index, offset);
+		WriteValue(index, it.second.second);
+		offset += it.second.second;
+	}
+	
+	string header(SIGNATURE, SIGNATURE_SIZE);
+	WriteValue<uint64_t>(header, index.length());
+	header += index;
+	
+	File out(path, true);
+	if(!out || fwrite(header.data(), 1, header.length(), out) != header.length())
+		return false;
+	
+	// Copy the contents of each file, padding each one to the next aligned offset.
+	offset = header.length();
+	vector<char> contents;
+	for(const auto &it : sorted)
+	{
+		string padding((ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT, '\0');
+		contents.resize(it.second.second);
+		File in(it.second.first);
+		if(!in || fread(contents.data(), 1, contents.size(), in) != contents.size())
+			return false;
+		if(fwrite(padding.data(), 1, padding.length(), out) != padding.length()
+				|| fwrite(contents.data(), 1, contents.size(), out) != contents.size())
+			return false;
+		offset += padding.length() + contents.size();
+	}
+	return true;
+}
+
+
+
+// Add the archive at the given path, whose files are treated as if they were
+// inside the given directory. Returns false if there is no valid archive at that
+// path. All archives must be added before any files in them are loaded.
+bool Archive::Add(const string &path, const string &directory)
+{
+	File file(path);
+	if(!file)
+		return false;
+	
+	// Read the signature and the size of the index, and then the index itself.
+	string header(SIGNATURE_SIZE + 8, '\0');
+	if(fread(&header[0], 1, header.length(), file) != header.length() || header.compare(0, SIGNATURE_SIZE, SIGNATURE))
+		return false;
+	const char *it = header.data() + SIGNATURE_SIZE;
+	uint64_t length = 0;
+	ReadValue(it, header.data() + header.length(), length);
+	if(static_cast<long long>(length) > Files::Size(path))
+		return false;
+	
+	string index(length, '\0');
+	if(fread(&index[0], 1, index.length(), file) != index.length())
+		return false;
+	
+	// Parse the whole index before adding any of it, in case it is not valid.
+	it = index.data();
+	const char *end = index.data() + index.length();
+	uint32_t count = 0;
+	if(!ReadValue(it, end, count))
+		return false;
+	
+	vector<pair<string, Entry>> added;
+	Entry entry;
+	entry.archive = archives.size();
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		uint32_t size = 0;
+		if(!ReadValue(it, end, size) || static_cast<size_t>(end - it) < size)
+			return false;
+		string name = directory + string(it, size);
+		it += size;
+		if(!ReadValue(it, end, entry.offset) || !ReadValue(it, end, entry.size))
+			return false;
+		added.emplace_back(name, entry);
+	}
+	
+	archives.emplace_back(path, Files::Timestamp(path));
+	for(const auto &it : added)
+		entries[it.first] = it.second;
+	return true;
+}
+
+
+
+// Check whether the given path is to a file in one of the archives. If so, also
+// get the file's size and the time stamp of the archive it is in.
+bool Archive::Find(const string &path, long long *size, time_t *timestamp)
+{
+	auto it = entries.find(path);
+	if(it == entries.end())
+		return false;
+	
+	if(size)
+		*size = it->second.size;
+	if(timestamp)
+		*timestamp = archives[it->second.archive].second;
+	return true;
+}
+
+
+
+// Open the given file in one of the archives. The returned file is just the
+// archive, positioned at the start of the given file's contents, so no more
+// than its size should be read from it. Returns null if the file is not in any
+// archive.
+FILE *Archive::Open(const string &path)
+{
+	auto it = entries.find(path);
+	if(it == entries.end())
+		return nullptr;
+	
+	FILE *file = Files::Open(archives[it->second.archive].first);
+	if(file && fseek(file, it->second.offset, SEEK_SET))
+	{
+		fclose(file);
+		file = nullptr;
+	}
+	return file;
+}
+
+
+
+// Add the paths of all the archived files in the given directory (or any
+// directory that it contains) to the given list.
+void Archive::List(const string &directory, vector<string> *list)
+{
+	for(auto it = entries.lower_bound(directory); it != entries.end(); ++it)
+	{
+		if(it->first.compare(0, directory.length(), directory))
+			break;
+		list->push_back(it->first);
+	}
+}
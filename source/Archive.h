@@ -0,0 +1,57 @@
+/* Archive.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+
+
+// Class for packing the images and sounds of a source directory into a single
+// file, so that loading them does not require listing thousands of files in
+// nested directories and then opening each of them. The archive begins with an
+// index of every file it holds, sorted by path, followed by the contents of the
+// files, each starting at an offset aligned to 16 bytes. Once an archive has
+// been added, Files treats the files in it as if they were still in the source
+// directory, so nothing else needs to know whether a file came from one. Loose
+// files still work as before, so plugins do not need to be packed.
+class Archive {
+public:
+	// Pack the given files, which must all be inside the given directory, into
+	// an archive at the given path. Returns false if writing the file failed.
+	static bool Write(const std::string &path, const std::string &directory, const std::vector<std::string> &files);
+	// Add the archive at the given path, whose files are treated as if they
+	// were inside the given directory. Returns false if there is no valid
+	// archive at that path. All archives must be added before any files in
+	// them are loaded.
+	static bool Add(const std::string &path, const std::string &directory);
+	
+	// Check whether the given path is to a file in one of the archives. If so,
+	// also get the file's size and the time stamp of the archive it is in.
+	static bool Find(const std::string &path, long long *size = nullptr, std::time_t *timestamp = nullptr);
+	// Open the given file in one of the archives. The returned file is just
+	// the archive, positioned at the start of the given file's contents, so no
+	// more than its size should be read from it. Returns null if the file is
+	// not in any archive.
+	static FILE *Open(const std::string &path);
+	// Add the paths of all the archived files in the given directory (or any
+	// directory that it contains) to the given list.
+	static void List(const std::string &directory, std::vector<std::string> *list);
+};
+
+
+
+#endif
@@ -0,0 +1,101 @@
+/* Arena.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Arena.h"
+
+#include "MemoryUsage.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace std;
+
+namespace {
+	// The blocks start out small, so that an arena with only a few objects in
+	// it does not waste much memory, and double in size up to this limit.
+	const size_t FIRST_BLOCK = 4096;
+	const size_t MAX_BLOCK = 262144;
+}
+
+
+
+Arena::Arena()
+	: blockSize(FIRST_BLOCK)
+{
+}
+
+
+
+Arena::~Arena()
+{
+	MemoryUsage::Add(MemoryUsage::OBJECTS, -static_cast<int64_t>(bytes));
+}
+
+
+
+void *Arena::Allocate(size_t size, size_t alignment)
+{
+	// Every object must be big enough to hold a link in the list of freed
+	// objects once it is freed.
+	size = max(size, sizeof(void *));
+	auto it = freed.find(size);
+	if(it != freed.end() && it->second)
+	{
+		void *pointer = it->second;
+		it->second = *static_cast<void **>(pointer);
+		return pointer;
+	}
+	
+	// Objects that are too big to share a block get a block of their own.
+	if(size + alignment > MAX_BLOCK)
+		return NewBlock(size + alignment, alignment);
+	
+	// Otherwise, take the next properly aligned space in the current block,
+	// or start a new block if there is not enough room left in this one.
+	size_t padding = (alignment - reinterpret_cast<uintptr_t>(next) % alignment) % alignment;
+	if(!next || padding + size > left)
+	{
+		size_t newSize = max(blockSize, size + alignment);
+		next = static_cast<char *>(NewBlock(newSize, alignment));
+		left = newSize - (next - blocks.back().get());
+		padding = 0;
+		blockSize = min(2 * blockSize, MAX_BLOCK);
+	}
+	void *pointer = next + padding;
+	next += padding + size;
+	left -= padding + size;
+	return pointer;
+}
+
+
+
+void Arena::Free(void *pointer, size_t size)
+{
+	size = max(size, sizeof(void *));
+	void *&head = freed[size];
+	*static_cast<void **>(pointer) = head;
+	head = pointer;
+}
+
+
+
+// Allocate a new block of the given size, and return the first properly
+// aligned address in it.
+void *Arena::NewBlock(size_t size, size_t alignment)
+{
+	blocks.emplace_back(new char[size]);
+	bytes += size;
+	MemoryUsage::Add(MemoryUsage::OBJECTS, size);
+	
+	char *block = blocks.back().get();
+	return block + (alignment - reinterpret_cast<uintptr_t>(block) % alignment) % alignment;
+}
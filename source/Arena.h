@@ -0,0 +1,88 @@
+/* Arena.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+
+// Class for allocating many small objects that mostly live as long as each
+// other, such as the nodes of a map that is filled in while the game data is
+// loading. Objects are packed into large blocks in the order they are
+// allocated, so that iterating over them in that order touches as little
+// memory as possible, and so that they do not fragment the rest of the heap.
+// Freed objects are kept to be reused by later allocations of the same size;
+// the blocks themselves are only freed when the arena is destroyed.
+class Arena {
+public:
+	Arena();
+	~Arena();
+	
+	Arena(const Arena &) = delete;
+	Arena &operator=(const Arena &) = delete;
+	
+	void *Allocate(std::size_t size, std::size_t alignment);
+	void Free(void *pointer, std::size_t size);
+	
+	
+private:
+	void *NewBlock(std::size_t size, std::size_t alignment);
+	
+	
+private:
+	// The size of the next block to allocate.
+	std::size_t blockSize;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::size_t bytes = 0;
+	char *next = nullptr;
+	std::size_t left = 0;
+	// Freed objects, in a linked list for each size.
+	std::map<std::size_t, void *> freed;
+};
+
+
+
+// Allocator for standard containers that gets its memory from an arena. The
+// arena must outlive the container.
+template <class Type>
+class ArenaAllocator {
+public:
+	typedef Type value_type;
+	
+	explicit ArenaAllocator(Arena &arena) noexcept : arena(&arena) {}
+	template <class Other>
+	ArenaAllocator(const ArenaAllocator<Other> &other) noexcept : arena(other.arena) {}
+	
+	Type *allocate(std::size_t count) { return static_cast<Type *>(arena->Allocate(count * sizeof(Type), alignof(Type))); }
+	void deallocate(Type *pointer, std::size_t count) { arena->Free(pointer, count * sizeof(Type)); }
+	
+	template <class Other>
+	bool operator==(const ArenaAllocator<Other> &other) const noexcept { return arena == other.arena; }
+	template <class Other>
+	bool operator!=(const ArenaAllocator<Other> &other) const noexcept { return arena != other.arena; }
+	
+	
+private:
+	template <class Other>
+	friend class ArenaAllocator;
+	
+	Arena *arena;
+};
+
+
+
+#endif
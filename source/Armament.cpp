@@ -213,6 +213,8 @@ void Armament::Fire(int index, Ship &ship, vector<Projectile> &projectiles, vect
 			it->second += it->first->Reload() * hardpoints[index].BurstRemaining();
 		}
 	}
+	if(hardpoints[index].IsIdle())
+		reloading.push_back(index);
 	hardpoints[index].Fire(ship, projectiles, visuals);
 }
 
@@ -223,7 +225,12 @@ bool Armament::FireAntiMissile(int index, Ship &ship, const Projectile &projecti
 	if(static_cast<unsigned>(index) >= hardpoints.size() || !hardpoints[index].IsReady())
 		return false;
 	
-	return hardpoints[index].FireAntiMissile(ship, projectile, visuals);
+	Hardpoint &hardpoint = hardpoints[index];
+	bool wasIdle = hardpoint.IsIdle();
+	bool result = hardpoint.FireAntiMissile(ship, projectile, visuals);
+	if(wasIdle && !hardpoint.IsIdle())
+		reloading.push_back(index);
+	return result;
 }
 
 
@@ -231,8 +238,17 @@ bool Armament::FireAntiMissile(int index, Ship &ship, const Projectile &projecti
 // Update the reload counters.
 void Armament::Step(const Ship &ship)
 {
-	for(Hardpoint &hardpoint : hardpoints)
+	// Most hardpoints are fully reloaded most of the time, so only step the
+	// ones that have fired, and stop tracking them once they are idle again.
+	auto out = reloading.begin();
+	for(unsigned index : reloading)
+	{
+		Hardpoint &hardpoint = hardpoints[index];
 		hardpoint.Step();
+		if(!hardpoint.IsIdle())
+			*out++ = index;
+	}
+	reloading.erase(out, reloading.end());
 	
 	for(auto &it : streamReload)
 	{
@@ -78,6 +78,9 @@ private:
 	// elements of this Armament itself).
 	std::map<const Outfit *, int> streamReload;
 	std::vector<Hardpoint> hardpoints;
+	// The indices of the hardpoints that have fired and are not idle yet. Only
+	// these need to be stepped, since stepping an idle hardpoint does nothing.
+	std::vector<unsigned> reloading;
 };
 
 
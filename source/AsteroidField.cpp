@@ -47,6 +47,12 @@ void AsteroidField::Clear()
 {
 	asteroids.clear();
 	minables.clear();
+	// Empty the minable grid too, so that nothing looks up the minables that
+	// were just removed before the next step refills it.
+	minableCollisions.Clear(0);
+	minableCollisions.Finish();
+	isGridCurrent = false;
+	maxSpeed = 0.;
 }
 
 
@@ -56,7 +62,11 @@ void AsteroidField::Add(const string &name, int count, double energy)
 {
 	const Sprite *sprite = SpriteSet::Get("asteroid/" + name + "/spin");
 	for(int i = 0; i < count; ++i)
+	{
 		asteroids.emplace_back(sprite, energy);
+		maxSpeed = max(maxSpeed, asteroids.back().Velocity().Length());
+	}
+	isGridCurrent = false;
 }
 
 
@@ -87,21 +97,22 @@ void AsteroidField::Step(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flo
 		asteroid.Step();
 	}
 	asteroidCollisions.Finish();
+	isGridCurrent = true;
 	
 	// Step through the minables. Since they are destructible, we may need to
-	// remove them from the list.
+	// remove them from the list. The survivors are shifted down in place, so
+	// that they stay in the same order.
 	minableCollisions.Clear(step);
-	auto it = minables.begin();
-	while(it != minables.end())
-	{
+	auto out = minables.begin();
+	for(auto it = minables.begin(); it != minables.end(); ++it)
 		if((*it)->Move(visuals, flotsam))
 		{
 			minableCollisions.Add(**it);
-			++it;
+			if(out != it)
+				*out = std::move(*it);
+			++out;
 		}
-		else
-			it = minables.erase(it);
-	}
+	minables.erase(out, minables.end());
 	minableCollisions.Finish();
 }
 
@@ -110,8 +121,22 @@ void AsteroidField::Step(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flo
 // Draw the asteroids, centered on the given location.
 void AsteroidField::Draw(DrawList &draw, const Point &center, double zoom) const
 {
-	for(const Asteroid &asteroid : asteroids)
-		asteroid.Draw(draw, center, zoom);
+	// Only the asteroids in the grid cells that are on screen need to be drawn.
+	// The collision set was filled before the asteroids moved, so allow for
+	// that motion. If the screen is bigger than the wrap square, every asteroid
+	// is on screen at least once anyway.
+	Point margin(maxSpeed + 1., maxSpeed + 1.);
+	Point topLeft = center + Screen::TopLeft() / zoom - margin;
+	Point bottomRight = center + Screen::BottomRight() / zoom + margin;
+	Point span = bottomRight - topLeft;
+	if(isGridCurrent && span.X() < WRAP && span.Y() < WRAP)
+	{
+		for(const Body *body : asteroidCollisions.Region(topLeft, bottomRight))
+			static_cast<const Asteroid *>(body)->Draw(draw, center, zoom);
+	}
+	else
+		for(const Asteroid &asteroid : asteroids)
+			asteroid.Draw(draw, center, zoom);
 	for(const shared_ptr<Minable> &minable : minables)
 		draw.Add(*minable);
 }
@@ -165,13 +190,21 @@ Body *AsteroidField::Collide(const Projectile &projectile, double *closestHit)
 
 
 // Get the list of mainable asteroids.
-const list<shared_ptr<Minable>> &AsteroidField::Minables() const
+const vector<shared_ptr<Minable>> &AsteroidField::Minables() const
 {
 	return minables;
 }
 
 
 
+// Get the collision set holding the minables.
+const CollisionSet &AsteroidField::MinableCollisions() const
+{
+	return minableCollisions;
+}
+
+
+
 // Construct an asteroid with the given sprite and "energy level."
 AsteroidField::Asteroid::Asteroid(const Sprite *sprite, double energy)
 {
@@ -228,11 +261,11 @@ void AsteroidField::Asteroid::Draw(DrawList &draw, const Point &center, double z
 	Point bottomRight = center + (Screen::BottomRight() + size) / zoom;
 	
 	// Figure out the position of the first instance of this asteroid that is to
-	// the right of and below the top left corner of the screen.
-	double startX = fmod(position.X() - topLeft.X(), WRAP);
-	startX += topLeft.X() + WRAP * (startX < 0.);
-	double startY = fmod(position.Y() - topLeft.Y(), WRAP);
-	startY += topLeft.Y() + WRAP * (startY < 0.);
+	// the right of and below the top left corner of the screen. The asteroid's
+	// own position is always within the wrap square, so this is just a matter
+	// of how many whole wrap distances to shift it by.
+	double startX = position.X() + WRAP * ceil((topLeft.X() - position.X()) * (1. / WRAP));
+	double startY = position.Y() + WRAP * ceil((topLeft.Y() - position.Y()) * (1. / WRAP));
 	
 	// Draw any instances of this asteroid that are on screen.
 	for(double y = startY; y < bottomRight.Y(); y += WRAP)
@@ -59,7 +59,10 @@ public:
 	Body *Collide(const Projectile &projectile, double *closestHit);
 	
 	// Get the list of minable asteroids.
-	const std::list<std::shared_ptr<Minable>> &Minables() const;
+	const std::vector<std::shared_ptr<Minable>> &Minables() const;
+	// Get the collision set holding the minables, for finding which of them
+	// are near a given point. It is refreshed each step.
+	const CollisionSet &MinableCollisions() const;
 	
 	
 private:
@@ -80,10 +83,15 @@ private:
 	
 private:
 	std::vector<Asteroid> asteroids;
-	std::list<std::shared_ptr<Minable>> minables;
+	std::vector<std::shared_ptr<Minable>> minables;
 	
 	CollisionSet asteroidCollisions;
 	CollisionSet minableCollisions;
+	// The asteroid collision set can be used to find which asteroids are on
+	// screen, but only if no asteroids have been added since it was filled.
+	bool isGridCurrent = false;
+	// The positions in the collision set may be out of date by up to this much.
+	double maxSpeed = 0.;
 };
 
 
@@ -17,6 +17,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "Random.h"
 #include "Sound.h"
+#include "Threads.h"
+#include "Trace.h"
 
 #ifndef __APPLE__
 #include <AL/al.h>
@@ -27,7 +29,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <list>
 #include <map>
 #include <mutex>
 #include <set>
@@ -69,6 +74,15 @@ namespace {
 	
 	// Thread entry point for loading the sound files.
 	void Load();
+	// Thread entry point for updating the OpenAL sources.
+	void AudioLoop();
+	// Update the sources and the music, once for each time Step() was called.
+	void UpdateSources();
+	// Keep a source that is done playing, to reuse it for another sound.
+	void Recycle(const Source &source);
+	// Load a sound that is played for the first time since it was unloaded,
+	// and unload others if that puts the sounds over budget.
+	bool LoadSound(const Sound *sound);
 	
 	
 	// Mutex to make sure different threads don't modify the audio at the same time.
@@ -86,6 +100,36 @@ namespace {
 	map<const Sound *, QueueEntry> queue;
 	map<const Sound *, QueueEntry> deferred;
 	thread::id mainThreadID;
+	// The queued sounds which need a new source, in order of priority. This is
+	// kept between steps so that its memory can be reused.
+	vector<pair<const Sound *, QueueEntry>> starting;
+	
+	// All the work of talking to OpenAL is done in its own thread, so that a
+	// slow audio driver does not hold up drawing the next frame. Step() hands
+	// the queued sounds over to that thread, along with any changes to the
+	// volume or music. These are protected by the audio mutex.
+	thread audioThread;
+	condition_variable audioCondition;
+	bool stepRequested = false;
+	bool isQuitting = false;
+	bool volumeChanged = false;
+	vector<string> musicRequests;
+	// The sounds that the audio thread is starting, and the music it is
+	// switching to. Only the audio thread touches these.
+	map<const Sound *, QueueEntry> stepQueue;
+	vector<string> stepMusic;
+	
+	// All the plays of one sound in a step are merged into one source. Beyond
+	// that, plays that come soon after a source started playing the same sound
+	// are held back for a few steps so more of them can be merged, and each
+	// sound only gets a limited number of sources. Otherwise a battle where
+	// many ships fire the same weapon would use up all the sources on it.
+	const int MIN_RESTART_STEPS = 3;
+	const int MAX_SOURCES_PER_SOUND = 6;
+	int audioStep = 0;
+	map<const Sound *, int> lastStarted;
+	map<const Sound *, QueueEntry> heldBack;
+	map<const Sound *, int> sourceCount;
 	
 	// Sound resources that have been loaded from files.
 	map<string, Sound> sounds;
@@ -93,13 +137,22 @@ namespace {
 	// of these, so they must be reused.
 	vector<Source> sources;
 	vector<unsigned> recycledSources;
-	vector<unsigned> endingSources;
+	vector<Source> endingSources;
 	unsigned maxSources = 255;
+	// The number of sources in use, which other threads may check.
+	atomic<size_t> voices(0);
 	
 	// Queue and thread for loading sound files in the background.
 	map<string, string> loadQueue;
 	thread loadThread;
 	
+	// If the sounds are loaded on demand, these are the ones that are loaded,
+	// most recently played first. Only the audio thread uses these.
+	size_t soundBudget = 0;
+	size_t loadedBytes = 0;
+	list<const Sound *> loaded;
+	map<const Sound *, list<const Sound *>::iterator> loadedIndex;
+	
 	// The current position of the "listener," i.e. the center of the screen.
 	Point listener;
 	
@@ -116,8 +169,9 @@ namespace {
 
 
 // Begin loading sounds (in a separate thread).
-void Audio::Init(const vector<string> &sources)
+void Audio::Init(const vector<string> &sources, size_t soundBudget)
 {
+	::soundBudget = soundBudget;
 	device = alcOpenDevice(nullptr);
 	if(!device)
 		return;
@@ -156,7 +210,11 @@ void Audio::Init(const vector<string> &sources)
 				size_t end = path.length() - 4;
 				if(path[end - 1] == '~')
 					--end;
-				loadQueue[path.substr(root.length(), end - root.length())] = path;
+				string name = path.substr(root.length(), end - root.length());
+				if(soundBudget)
+					sounds[name].Defer(path, name);
+				else
+					loadQueue[name] = path;
 			}
 		}
 	}
@@ -177,6 +235,8 @@ void Audio::Init(const vector<string> &sources)
 	}
 	alSourceQueueBuffers(musicSource, MUSIC_BUFFERS, musicBuffers);
 	alSourcePlay(musicSource);
+	
+	audioThread = thread(&AudioLoop);
 }
 
 
@@ -196,6 +256,14 @@ double Audio::Progress()
 
 
 
+// Get the number of sounds that are playing right now.
+size_t Audio::Voices()
+{
+	return voices;
+}
+
+
+
 // Get the volume.
 double Audio::Volume()
 {
@@ -207,9 +275,9 @@ double Audio::Volume()
 // Set the volume (to a value between 0 and 1).
 void Audio::SetVolume(double level)
 {
+	unique_lock<mutex> lock(audioMutex);
 	volume = min(1., max(0., level));
-	if(isInitialized)
-		alListenerf(AL_GAIN, volume);
+	volumeChanged = true;
 }
 
 
@@ -234,6 +302,7 @@ void Audio::Update(const Point &listenerPosition)
 	
 	listener = listenerPosition;
 	
+	unique_lock<mutex> lock(audioMutex);
 	for(const auto &it : deferred)
 		queue[it.first].Add(it.second);
 	deferred.clear();
@@ -253,18 +322,18 @@ void Audio::Play(const Sound *sound)
 // "listener". This will make it softer and change the left / right balance.
 void Audio::Play(const Sound *sound, const Point &position)
 {
-	if(!isInitialized || !sound || !sound->Buffer() || !volume)
+	// If the sounds are loaded on demand, the audio thread loads this one just
+	// before it starts playing it.
+	if(!isInitialized || !sound || (!soundBudget && !sound->Buffer()) || !volume)
 		return;
 	
 	// Place sounds from the main thread directly into the queue. They are from
 	// the UI, and the Engine may not be running right now to call Update().
+	unique_lock<mutex> lock(audioMutex);
 	if(this_thread::get_id() == mainThreadID)
 		queue[sound].Add(position - listener);
 	else
-	{
-		unique_lock<mutex> lock(audioMutex);
 		deferred[sound].Add(position - listener);
-	}
 }
 
 
@@ -275,12 +344,9 @@ void Audio::PlayMusic(const string &name)
 	if(!isInitialized)
 		return;
 	
-	// Don't worry about thread safety here, since music will always be started
-	// by the main thread.
-	musicFade = 65536;
-	swap(currentTrack, previousTrack);
-	// If the name is empty, it means to turn music off.
-	currentTrack->SetSource(name);
+	// The audio thread will switch to this music the next time it is stepped.
+	unique_lock<mutex> lock(audioMutex);
+	musicRequests.push_back(name);
 }
 
 
@@ -292,130 +358,13 @@ void Audio::Step()
 	if(!isInitialized)
 		return;
 	
-	vector<Source> newSources;
-	// For each sound that is looping, see if it is going to continue. For other
-	// sounds, check if they are done playing.
-	for(const Source &source : sources)
-	{
-		if(source.GetSound()->IsLooping())
-		{
-			auto it = queue.find(source.GetSound());
-			if(it != queue.end())
-			{
-				source.Move(it->second);
-				newSources.push_back(source);
-				queue.erase(it);
-			}
-			else
-			{
-				alSourcei(source.ID(), AL_LOOPING, false);
-				endingSources.push_back(source.ID());
-			}
-		}
-		else
-		{
-			// Non-looping sounds: check if they're done playing.
-			ALint state;
-			alGetSourcei(source.ID(), AL_SOURCE_STATE, &state);
-			if(state == AL_PLAYING)
-				newSources.push_back(source);
-			else
-				recycledSources.push_back(source.ID());
-		}
-	}
-	// These sources were looping and are now wrapping up a loop.
-	auto it = endingSources.begin();
-	while(it != endingSources.end())
-	{
-		ALint state;
-		alGetSourcei(*it, AL_SOURCE_STATE, &state);
-		if(state == AL_PLAYING)
-		{
-			// Fade out the sound. This avoids a clicking or rasping sound if a
-			// sound is cut off in the middle of its loop.
-			float gain = 1.f;
-			alGetSourcef(*it, AL_GAIN, &gain);
-			gain = max(0.f, gain - .05f);
-			alSourcef(*it, AL_GAIN, gain);
-			++it;
-		}
-		else
-		{
-			recycledSources.push_back(*it);
-			it = endingSources.erase(it);
-		}
-	}
-	newSources.swap(sources);
-	
-	// Now, what is left in the queue is sounds that want to play, and that do
-	// not correspond to an existing source.
-	for(const auto &it : queue)
+	// Hand the queued sounds over to the audio thread. If it is still busy with
+	// the previous step, it will pick these sounds up as soon as it is done.
 	{
-		// Use a recycled source if possible. Otherwise, create a new one.
-		unsigned source = 0;
-		if(recycledSources.empty())
-		{
-			if(sources.size() >= maxSources)
-				break;
-			
-			alGenSources(1, &source);
-			if(!source)
-			{
-				// If we just tried to generate a new source and OpenAL would
-				// not give us one, we've reached this system's limit for the
-				// number of concurrent sounds.
-				maxSources = sources.size();
-				break;
-			}
-		}
-		else
-		{
-			source = recycledSources.back();
-			recycledSources.pop_back();
-		}
-		// Begin playing this sound.
-		sources.emplace_back(it.first, source);
-		sources.back().Move(it.second);
-		alSourcePlay(source);
-	}
-	queue.clear();
-	
-	// Queue up new buffers for the music, if necessary.
-	int buffersDone = 0;
-	alGetSourcei(musicSource, AL_BUFFERS_PROCESSED, &buffersDone);
-	if(buffersDone)
-	{
-		unsigned buffer = 0;
-		alSourceUnqueueBuffers(musicSource, 1, &buffer);
-		
-		const vector<int16_t> &chunk = currentTrack->NextChunk();
-		
-		if(!musicFade)
-			alBufferData(buffer, AL_FORMAT_STEREO16, &chunk.front(), 2 * chunk.size(), 44100);
-		else
-		{
-			fadeBuffer.clear();
-			const vector<int16_t> &other = previousTrack->NextChunk();
-			for(size_t i = 0; i < chunk.size(); ++i)
-			{
-				// Blend the two tracks together.
-				fadeBuffer.push_back(
-					(musicFade * other[i] + (65536 - musicFade) * chunk[i]) / 65536);
-				
-				// Slowly fade into the new track.
-				if(musicFade)
-					--musicFade;
-			}
-			alBufferData(buffer, AL_FORMAT_STEREO16, &fadeBuffer.front(), 2 * fadeBuffer.size(), 44100);
-		}
-		
-		alSourceQueueBuffers(musicSource, 1, &buffer);
-		// Check if the source has stopped (i.e. because it ran out of buffers).
-		ALint state;
-		alGetSourcei(musicSource, AL_SOURCE_STATE, &state);
-		if(state != AL_PLAYING)
-			alSourcePlay(musicSource);
+		unique_lock<mutex> lock(audioMutex);
+		stepRequested = true;
 	}
+	audioCondition.notify_one();
 }
 
 
@@ -424,8 +373,17 @@ void Audio::Step()
 void Audio::Quit()
 {
 	// First, check if sounds are still being loaded in a separate thread, and
-	// if so interrupt that thread and wait for it to quit.
+	// if so interrupt that thread and wait for it to quit. The audio thread
+	// must also be stopped before its sources are deleted.
 	unique_lock<mutex> lock(audioMutex);
+	isQuitting = true;
+	if(audioThread.joinable())
+	{
+		lock.unlock();
+		audioCondition.notify_all();
+		audioThread.join();
+		lock.lock();
+	}
 	if(!loadQueue.empty())
 		loadQueue.clear();
 	if(loadThread.joinable())
@@ -445,9 +403,10 @@ void Audio::Quit()
 	sources.clear();
 	
 	// Also clean up any sources that are fading out.
-	for(unsigned id : endingSources)
+	for(const Source &source : endingSources)
 	{
-		alSourceStop(id);
+		alSourceStop(source.ID());
+		ALuint id = source.ID();
 		alDeleteSources(1, &id);
 	}
 	endingSources.clear();
@@ -561,6 +520,7 @@ namespace {
 	// Thread entry point for loading sounds.
 	void Load()
 	{
+		Threads::Scope threadScope("sound loader", Threads::Priority::LOW);
 		string name;
 		string path;
 		while(true)
@@ -579,8 +539,288 @@ namespace {
 			}
 			
 			// Unlock the mutex for the time-intensive part of the loop.
+			TRACE_SCOPE("Sound::Load");
 			if(!sounds[name].Load(path, name))
 				Files::LogError("Unable to load sound \"" + name + "\" from path: " + path);
 		}
 	}
+	
+	
+	
+	// Thread entry point for updating the OpenAL sources.
+	void AudioLoop()
+	{
+		Threads::Scope threadScope("audio", Threads::Priority::NORMAL);
+		unique_lock<mutex> lock(audioMutex);
+		while(true)
+		{
+			while(!isQuitting && !stepRequested)
+				audioCondition.wait(lock);
+			if(isQuitting)
+				return;
+			
+			// Take everything that was queued up since the last step, so that
+			// other threads can keep queuing sounds while this one works.
+			stepRequested = false;
+			for(const auto &it : queue)
+				stepQueue[it.first].Add(it.second);
+			queue.clear();
+			stepMusic.swap(musicRequests);
+			bool updateVolume = volumeChanged;
+			volumeChanged = false;
+			double gain = volume;
+			
+			lock.unlock();
+			if(updateVolume)
+				alListenerf(AL_GAIN, gain);
+			UpdateSources();
+			lock.lock();
+		}
+	}
+	
+	
+	
+	// Update the sources and the music, once for each time Step() was called.
+	void UpdateSources()
+	{
+		TRACE_SCOPE("Audio::Step");
+		for(const string &name : stepMusic)
+		{
+			musicFade = 65536;
+			swap(currentTrack, previousTrack);
+			// If the name is empty, it means to turn music off.
+			currentTrack->SetSource(name);
+		}
+		stepMusic.clear();
+		
+		// Merge in any plays that were held back in previous steps.
+		++audioStep;
+		for(const auto &it : heldBack)
+			stepQueue[it.first].Add(it.second);
+		heldBack.clear();
+		
+		// For each sound that is looping, see if it is going to continue. For other
+		// sounds, check if they are done playing. The sources that are still in use
+		// are shifted down in place.
+		auto out = sources.begin();
+		for(auto in = sources.begin(); in != sources.end(); ++in)
+		{
+			const Source &source = *in;
+			bool isPlaying = false;
+			if(source.GetSound()->IsLooping())
+			{
+				auto it = stepQueue.find(source.GetSound());
+				if(it != stepQueue.end())
+				{
+					source.Move(it->second);
+					isPlaying = true;
+					stepQueue.erase(it);
+				}
+				else
+				{
+					alSourcei(source.ID(), AL_LOOPING, false);
+					endingSources.push_back(source);
+				}
+			}
+			else
+			{
+				// Non-looping sounds: check if they're done playing.
+				ALint state;
+				alGetSourcei(source.ID(), AL_SOURCE_STATE, &state);
+				if(state == AL_PLAYING)
+					isPlaying = true;
+				else
+					Recycle(source);
+			}
+			if(isPlaying)
+				*out++ = source;
+		}
+		sources.erase(out, sources.end());
+		
+		// These sources were looping and are now wrapping up a loop.
+		auto it = endingSources.begin();
+		while(it != endingSources.end())
+		{
+			ALint state;
+			alGetSourcei(it->ID(), AL_SOURCE_STATE, &state);
+			if(state == AL_PLAYING)
+			{
+				// Fade out the sound. This avoids a clicking or rasping sound if a
+				// sound is cut off in the middle of its loop.
+				float gain = 1.f;
+				alGetSourcef(it->ID(), AL_GAIN, &gain);
+				gain = max(0.f, gain - .05f);
+				alSourcef(it->ID(), AL_GAIN, gain);
+				++it;
+			}
+			else
+			{
+				Recycle(*it);
+				it = endingSources.erase(it);
+			}
+		}
+		
+		// Now, what is left in the queue is sounds that want to play, and that do
+		// not correspond to an existing source. Hold back the ones that just
+		// started playing, so they can be merged with the plays in the next few
+		// steps, and drop the ones that already have too many sources.
+		sourceCount.clear();
+		for(const Source &source : sources)
+			++sourceCount[source.GetSound()];
+		for(const auto &it : stepQueue)
+		{
+			if(sourceCount[it.first] >= MAX_SOURCES_PER_SOUND)
+				continue;
+			auto last = lastStarted.find(it.first);
+			if(last != lastStarted.end() && audioStep - last->second < MIN_RESTART_STEPS)
+				heldBack[it.first].Add(it.second);
+			else
+				starting.push_back(it);
+		}
+		stepQueue.clear();
+		// If there are not enough sources for all of them, the loudest ones (i.e.
+		// the ones that are closest to the listener, or that were queued up the
+		// most times) should get one first.
+		sort(starting.begin(), starting.end(),
+			[](const pair<const Sound *, QueueEntry> &a, const pair<const Sound *, QueueEntry> &b)
+			{
+				return a.second.weight > b.second.weight;
+			});
+		for(const auto &it : starting)
+		{
+			if(soundBudget && !LoadSound(it.first))
+				continue;
+			
+			// Use a recycled source if possible. Otherwise, create a new one.
+			unsigned source = 0;
+			if(recycledSources.empty())
+			{
+				if(sources.size() >= maxSources)
+					break;
+				
+				alGenSources(1, &source);
+				if(!source)
+				{
+					// If we just tried to generate a new source and OpenAL would
+					// not give us one, we've reached this system's limit for the
+					// number of concurrent sounds.
+					maxSources = sources.size();
+					break;
+				}
+			}
+			else
+			{
+				source = recycledSources.back();
+				recycledSources.pop_back();
+			}
+			// Begin playing this sound.
+			lastStarted[it.first] = audioStep;
+			sources.emplace_back(it.first, source);
+			sources.back().Move(it.second);
+			alSourcePlay(source);
+		}
+		starting.clear();
+		voices = sources.size();
+		
+		// Queue up new buffers for the music, if necessary.
+		int buffersDone = 0;
+		alGetSourcei(musicSource, AL_BUFFERS_PROCESSED, &buffersDone);
+		if(buffersDone)
+		{
+			unsigned buffer = 0;
+			alSourceUnqueueBuffers(musicSource, 1, &buffer);
+			
+			const vector<int16_t> &chunk = currentTrack->NextChunk();
+			
+			if(!musicFade)
+				alBufferData(buffer, AL_FORMAT_STEREO16, &chunk.front(), 2 * chunk.size(), 44100);
+			else
+			{
+				fadeBuffer.clear();
+				const vector<int16_t> &other = previousTrack->NextChunk();
+				for(size_t i = 0; i < chunk.size(); ++i)
+				{
+					// Blend the two tracks together.
+					fadeBuffer.push_back(
+						(musicFade * other[i] + (65536 - musicFade) * chunk[i]) / 65536);
+					
+					// Slowly fade into the new track.
+					if(musicFade)
+						--musicFade;
+				}
+				alBufferData(buffer, AL_FORMAT_STEREO16, &fadeBuffer.front(), 2 * fadeBuffer.size(), 44100);
+			}
+			
+			alSourceQueueBuffers(musicSource, 1, &buffer);
+			// Check if the source has stopped (i.e. because it ran out of buffers).
+			ALint state;
+			alGetSourcei(musicSource, AL_SOURCE_STATE, &state);
+			if(state != AL_PLAYING)
+				alSourcePlay(musicSource);
+		}
+	}
+	
+	
+	
+	// Keep a source that is done playing, to reuse it for another sound.
+	void Recycle(const Source &source)
+	{
+		// If sounds may be unloaded, the source must not hold on to the buffer.
+		if(soundBudget)
+			alSourcei(source.ID(), AL_BUFFER, 0);
+		recycledSources.push_back(source.ID());
+	}
+	
+	
+	
+	// Load a sound that is played for the first time since it was unloaded,
+	// and unload others if that puts the sounds over budget.
+	bool LoadSound(const Sound *sound)
+	{
+		// Move this sound to the front of the list of recently played sounds.
+		auto it = loadedIndex.find(sound);
+		if(it != loadedIndex.end())
+		{
+			loaded.splice(loaded.begin(), loaded, it->second);
+			return true;
+		}
+		
+		Sound *target = nullptr;
+		{
+			unique_lock<mutex> lock(audioMutex);
+			target = &sounds[sound->Name()];
+		}
+		TRACE_SCOPE("Sound::Reload");
+		if(!target->Reload())
+			return false;
+		loaded.push_front(sound);
+		loadedIndex[sound] = loaded.begin();
+		loadedBytes += sound->Size();
+		
+		// Unload the least recently played sounds that no source is playing,
+		// until the rest fit within the budget.
+		auto next = loaded.end();
+		while(loadedBytes > soundBudget && next != loaded.begin())
+		{
+			--next;
+			const Sound *oldest = *next;
+			bool isUsed = (oldest == sound);
+			for(const Source &source : sources)
+				isUsed |= (source.GetSound() == oldest);
+			for(const Source &source : endingSources)
+				isUsed |= (source.GetSound() == oldest);
+			if(isUsed)
+				continue;
+			
+			loadedBytes -= oldest->Size();
+			{
+				unique_lock<mutex> lock(audioMutex);
+				target = &sounds[oldest->Name()];
+			}
+			target->Unload();
+			loadedIndex.erase(oldest);
+			next = loaded.erase(next);
+		}
+		return true;
+	}
 }
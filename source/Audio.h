@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef AUDIO_H_
 #define AUDIO_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -30,11 +31,15 @@ class Sound;
 // their source stops calling the "play" function for them.
 class Audio {
 public:
-	// Begin loading sounds (in a separate thread).
-	static void Init(const std::vector<std::string> &sources);
+	// Begin loading sounds (in a separate thread). If a budget is given, each
+	// sound is instead loaded the first time it is played, and the least
+	// recently played ones are unloaded to stay within that many bytes.
+	static void Init(const std::vector<std::string> &sources, size_t soundBudget = 0);
 	
 	// Check the progress of loading sounds.
 	static double Progress();
+	// Get the number of sounds that are playing right now.
+	static std::size_t Voices();
 	
 	// Get or set the volume (between 0 and 1).
 	static double Volume();
@@ -61,7 +66,8 @@ public:
 	static void PlayMusic(const std::string &name);
 	
 	// Begin playing all the sounds that have been added since the last time
-	// this function was called.
+	// this function was called. The OpenAL work is done in the audio thread, so
+	// this returns right away.
 	static void Step();
 	
 	// Shut down the audio system (because we're about to quit).
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 #include "Sprite.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -30,6 +31,26 @@ namespace {
 		v.push_back(t);
 		v.push_back(frame);
 	}
+	
+	// Push the texture coordinates of the given point in the given frame. If the
+	// sprite has been packed into an atlas, the coordinates of each frame are
+	// given; otherwise, each frame is a layer of the sprite's own texture.
+	void PushTexCoord(vector<float> &v, float s, float t, int frame, const float *atlas)
+	{
+		if(atlas)
+		{
+			const float *rect = atlas + 4 * frame;
+			v.push_back(rect[0] + s * (rect[2] - rect[0]));
+			v.push_back(rect[1] + t * (rect[3] - rect[1]));
+			v.push_back(0.f);
+		}
+		else
+		{
+			v.push_back(s);
+			v.push_back(t);
+			v.push_back(frame);
+		}
+	}
 }
 
 
@@ -52,6 +73,32 @@ void BatchDrawList::SetCenter(const Point &center)
 
 
 
+// Clear the list and give it the same view as the given one.
+void BatchDrawList::Clear(const BatchDrawList &view)
+{
+	data.clear();
+	step = view.step;
+	zoom = view.zoom;
+	isHighDPI = view.isHighDPI;
+	center = view.center;
+}
+
+
+
+// Add all the sprites in the given list after the ones in this list. Each
+// sprite's instances are drawn in order, so this gives the same result as
+// if all of them had been added to this list.
+void BatchDrawList::Append(const BatchDrawList &other)
+{
+	for(const auto &it : other.data)
+	{
+		vector<float> &v = data[it.first];
+		v.insert(v.end(), it.second.begin(), it.second.end());
+	}
+}
+
+
+
 // Add an unswizzled object based on the Body class.
 bool BatchDrawList::Add(const Body &body, float clip)
 {
@@ -81,16 +128,94 @@ bool BatchDrawList::AddVisual(const Body &visual)
 // Draw all the items in this list.
 void BatchDrawList::Draw() const
 {
+	// Group the vertices by which texture they will be drawn from. Sprites that
+	// have been packed into the atlas all share a few textures, so they can be
+	// drawn with a single call for each of those textures.
+	map<uint32_t, vector<float>> batches;
+	for(const pair<const Sprite * const, vector<float>> &it : data)
+	{
+		const Sprite *sprite = it.first;
+		const float *atlas = nullptr;
+		uint32_t texture = sprite->AtlasTexture(isHighDPI);
+		if(texture)
+			atlas = sprite->AtlasCoordinates(isHighDPI);
+		else
+			texture = sprite->Texture(isHighDPI);
+		// Skip sprites that are still being streamed in.
+		if(!texture)
+			continue;
+		
+		vector<float> &v = batches[texture];
+		int frames = max(1, sprite->Frames());
+		const vector<float> &source = it.second;
+		for(size_t i = 0; i + 5 <= source.size(); i += 5)
+		{
+			const float *vertex = &source[i];
+			// Figure out which two frames this vertex blends between.
+			float first = floor(vertex[4]);
+			float fade = vertex[4] - first;
+			int firstFrame = static_cast<int>(first) % frames;
+			int secondFrame = static_cast<int>(ceil(vertex[4])) % frames;
+			
+			v.push_back(vertex[0]);
+			v.push_back(vertex[1]);
+			PushTexCoord(v, vertex[2], vertex[3], firstFrame, atlas);
+			PushTexCoord(v, vertex[2], vertex[3], secondFrame, atlas);
+			v.push_back(fade);
+		}
+	}
+	
 	BatchShader::Bind();
 	
-	for(const pair<const Sprite * const, vector<float>> &it : data)
-		BatchShader::Add(it.first, isHighDPI, it.second);
+	for(const pair<const uint32_t, vector<float>> &it : batches)
+		BatchShader::Add(it.first, it.second);
 	
 	BatchShader::Unbind();
 }
 
 
 
+// Get the number of sprites in this list. Each one is six vertices of five
+// values each.
+size_t BatchDrawList::Size() const
+{
+	size_t size = 0;
+	for(const auto &it : data)
+		size += it.second.size() / 30;
+	return size;
+}
+
+
+
+// Get the view that this list is drawn with.
+int BatchDrawList::Step() const
+{
+	return step;
+}
+
+
+
+const Point &BatchDrawList::Center() const
+{
+	return center;
+}
+
+
+
+double BatchDrawList::Zoom() const
+{
+	return zoom;
+}
+
+
+
+bool BatchDrawList::IsHighDPI() const
+{
+	return isHighDPI;
+}
+
+
+
 bool BatchDrawList::Cull(const Body &body, const Point &position) const
 {
 	if(!body.HasSprite() || !body.Zoom())
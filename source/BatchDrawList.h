@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Point.h"
 
+#include <cstddef>
 #include <map>
 #include <vector>
 
@@ -25,11 +26,19 @@ class Sprite;
 
 // This class collects a set of OpenGL draw commands to issue and groups them by
 // sprite, so all instances of each sprite can be drawn with a single command.
+// Sprites that are packed into the SpriteAtlas share textures, so all the
+// instances of all of those sprites are drawn with just a few commands.
 class BatchDrawList {
 public:
 	// Clear the list, also setting the global time step for animation.
 	void Clear(int step = 0, double zoom = 1.);
 	void SetCenter(const Point &center);
+	// Clear the list and give it the same step, zoom, and center as the given
+	// one, so that sprites can be added to it in another thread and then be
+	// appended to that list.
+	void Clear(const BatchDrawList &view);
+	// Add all the sprites in the given list after the ones in this list.
+	void Append(const BatchDrawList &other);
 	
 	// Add an unswizzled object based on the Body class.
 	bool Add(const Body &body, float clip = 1.f);
@@ -37,6 +46,14 @@ public:
 	
 	// Draw all the items in this list.
 	void Draw() const;
+	// Get the number of sprites in this list.
+	std::size_t Size() const;
+	
+	// Get the view that this list is drawn with.
+	int Step() const;
+	const Point &Center() const;
+	double Zoom() const;
+	bool IsHighDPI() const;
 	
 	
 private:
@@ -56,7 +73,8 @@ private:
 	// Each sprite consists of six vertices (four vertices to form a quad and
 	// two dummy vertices to mark the break in between them). Each of those
 	// vertices has five attributes: (x, y) position in pixels, (s, t) texture
-	// coordinates, and the index of the sprite frame.
+	// coordinates, and the index of the sprite frame. When the list is drawn,
+	// those are converted into the format that the BatchShader expects.
 	std::map<const Sprite *, std::vector<float>> data;
 };
 
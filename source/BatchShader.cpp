@@ -14,7 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Screen.h"
 #include "Shader.h"
-#include "Sprite.h"
+#include "StreamBuffer.h"
 
 using namespace std;
 
@@ -22,13 +22,13 @@ namespace {
 	Shader shader;
 	// Uniforms:
 	GLint scaleI;
-	GLint frameCountI;
 	// Vertex data:
 	GLint vertI;
 	GLint texCoordI;
+	GLint nextTexCoordI;
+	GLint fadeI;
 	
 	GLuint vao;
-	GLuint vbo;
 }
 
 
@@ -40,60 +40,62 @@ void BatchShader::Init()
 		"uniform vec2 scale;\n"
 		"in vec2 vert;\n"
 		"in vec3 texCoord;\n"
+		"in vec3 nextTexCoord;\n"
+		"in float fade;\n"
 		
 		"out vec3 fragTexCoord;\n"
+		"out vec3 fragNextTexCoord;\n"
+		"out float fragFade;\n"
 		
 		"void main() {\n"
 		"  gl_Position = vec4(vert * scale, 0, 1);\n"
 		"  fragTexCoord = texCoord;\n"
+		"  fragNextTexCoord = nextTexCoord;\n"
+		"  fragFade = fade;\n"
 		"}\n";
 	
+	// Each vertex specifies where to find both of the animation frames that
+	// it is blending between, because in a texture atlas those frames may be
+	// in different places rather than just in different layers.
 	static const char *fragmentCode =
 		"uniform sampler2DArray tex;\n"
-		"uniform float frameCount;\n"
 		
 		"in vec3 fragTexCoord;\n"
+		"in vec3 fragNextTexCoord;\n"
+		"in float fragFade;\n"
 		
 		"out vec4 finalColor;\n"
 		
 		"void main() {\n"
-		"  float first = floor(fragTexCoord.z);\n"
-		"  float second = mod(ceil(fragTexCoord.z), frameCount);\n"
-		"  float fade = fragTexCoord.z - first;\n"
 		"  finalColor = mix(\n"
-		"    texture(tex, vec3(fragTexCoord.xy, first)),\n"
-		"    texture(tex, vec3(fragTexCoord.xy, second)), fade);\n"
+		"    texture(tex, fragTexCoord),\n"
+		"    texture(tex, fragNextTexCoord), fragFade);\n"
 		"}\n";
 	
 	// Compile the shaders.
 	shader = Shader(vertexCode, fragmentCode);
 	// Get the indices of the uniforms and attributes.
 	scaleI = shader.Uniform("scale");
-	frameCountI = shader.Uniform("frameCount");
 	vertI = shader.Attrib("vert");
 	texCoordI = shader.Attrib("texCoord");
+	nextTexCoordI = shader.Attrib("nextTexCoord");
+	fadeI = shader.Attrib("fade");
 	
 	// Make sure we're using texture 0.
 	glUseProgram(shader.Object());
 	glUniform1i(shader.Uniform("tex"), 0);
 	glUseProgram(0);
 	
-	// Generate the buffer for uploading the batch vertex data.
+	// The vertex data is uploaded into the StreamBuffer, so its location is
+	// not known until it is drawn. Just enable the four vertex arrays here.
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 	
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	
-	// In this VAO, enable the two vertex arrays and specify their byte offsets.
 	glEnableVertexAttribArray(vertI);
-	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)0);
 	glEnableVertexAttribArray(texCoordI);
-	glVertexAttribPointer(texCoordI, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *)(2 * sizeof(float)));
+	glEnableVertexAttribArray(nextTexCoordI);
+	glEnableVertexAttribArray(fadeI);
 	
-	// Unbind the buffer and the VAO, but leave the vertex attrib arrays enabled
-	// in the VAO so they will be used when it is bound.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 }
 
@@ -103,8 +105,6 @@ void BatchShader::Bind()
 {
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
-	// Bind the vertex buffer so we can upload data to it.
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	
 	// Set up the screen scale.
 	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
@@ -113,22 +113,27 @@ void BatchShader::Bind()
 
 
 
-void BatchShader::Add(const Sprite *sprite, bool isHighDPI, const vector<float> &data)
+void BatchShader::Add(uint32_t texture, const vector<float> &data)
 {
-	// Do nothing if there are no sprites to draw.
-	if(data.empty())
+	// Do nothing if there are no sprites to draw, or if their texture is not
+	// loaded (e.g. because it is still being streamed in).
+	if(data.empty() || !texture)
 		return;
 	
 	// First, bind the proper texture.
-	glBindTexture(GL_TEXTURE_2D_ARRAY, sprite->Texture(isHighDPI));
-	// The shader also needs to know how many frames the texture has.
-	glUniform1f(frameCountI, sprite->Frames());
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
 	
-	// Upload the vertex data.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * data.size(), data.data(), GL_STREAM_DRAW);
+	// Upload the vertex data, and point each of the attributes at it.
+	const char *offset = reinterpret_cast<const char *>(
+		StreamBuffer::Upload(data.data(), sizeof(float) * data.size()));
+	const GLsizei stride = VERTEX_SIZE * sizeof(float);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, stride, offset);
+	glVertexAttribPointer(texCoordI, 3, GL_FLOAT, GL_FALSE, stride, offset + 2 * sizeof(float));
+	glVertexAttribPointer(nextTexCoordI, 3, GL_FLOAT, GL_FALSE, stride, offset + 5 * sizeof(float));
+	glVertexAttribPointer(fadeI, 1, GL_FLOAT, GL_FALSE, stride, offset + 8 * sizeof(float));
 	
 	// Draw all the vertices.
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, data.size() / 5);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, data.size() / VERTEX_SIZE);
 }
 
 
@@ -13,21 +13,27 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef BATCH_SHADER_H_
 #define BATCH_SHADER_H_
 
-class Sprite;
-
+#include <cstdint>
 #include <vector>
 
 
 
 // Class for drawing sprites in a batch. The input to each draw command is a
-// sprite, whether it should be drawn high DPI, and the vertex data.
+// texture and the vertex data for all the sprites that are drawn from it. Each
+// vertex has nine attributes: (x, y) position in pixels, (s, t, layer) texture
+// coordinates of the current animation frame and of the frame after it, and
+// how far to fade from the first of those frames to the second.
 class BatchShader {
+public:
+	static const int VERTEX_SIZE = 9;
+	
+	
 public:
 	// Initialize the shaders.
 	static void Init();
 	
 	static void Bind();
-	static void Add(const Sprite *sprite, bool isHighDPI, const std::vector<float> &data);
+	static void Add(uint32_t texture, const std::vector<float> &data);
 	static void Unbind();
 };
 
@@ -114,7 +114,7 @@ const Mask &Body::GetMask(int step) const
 		SetStep(step);
 	
 	static const Mask EMPTY;
-	return sprite ? sprite->GetMask(round(frame)) : EMPTY;
+	return sprite ? sprite->GetMask(maskFrame) : EMPTY;
 }
 
 
@@ -318,6 +318,7 @@ void Body::SetStep(int step) const
 	if(frames <= 1.f)
 	{
 		frame = 0.f;
+		maskFrame = 0;
 		return;
 	}
 	float lastFrame = frames - 1.f;
@@ -366,4 +367,5 @@ void Body::SetStep(int step) const
 		// be less than 0, clamp it to 0.
 		frame = max(0.f, lastFrame * 2.f - frame);
 	}
+	maskFrame = lround(frame);
 }
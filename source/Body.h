@@ -99,6 +99,10 @@ protected:
 	
 	
 private:
+	// The particle system reads the animation parameters directly, so that the
+	// graphics card can calculate each frame instead.
+	friend class ParticleSystem;
+	
 	// Set what animation step we're on. This affects future calls to GetMask()
 	// and GetFrame().
 	void SetStep(int step) const;
@@ -124,9 +128,11 @@ private:
 	bool shouldBeRemoved = false;
 	
 	// Cache the frame calculation so it doesn't have to be repeated if given
-	// the same step over and over again.
+	// the same step over and over again. Collision checks use the nearest whole
+	// frame's mask, which is also worked out just once per step.
 	mutable int currentStep = -1;
 	mutable float frame = 0.f;
+	mutable int maskFrame = 0;
 };
 
 
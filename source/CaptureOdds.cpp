@@ -113,6 +113,13 @@ void CaptureOdds::Calculate()
 	if(powerD.empty() || powerA.empty())
 		return;
 	
+	// Each table has one entry for every combination of crew sizes. For ships
+	// with large crews that is a lot of entries, so allocate them all at once.
+	size_t size = powerA.size() * powerD.size();
+	capture.reserve(size);
+	casualtiesA.reserve(size);
+	casualtiesD.reserve(size);
+	
 	// The first row represents the case where the attacker has only one crew left.
 	// In that case, the defending ship can never be successfully captured.
 	capture.resize(powerD.size(), 0.);
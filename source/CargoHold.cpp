@@ -56,6 +56,7 @@ void CargoHold::Clear()
 	outfits.clear();
 	missionCargo.clear();
 	passengers.clear();
+	Recount();
 }
 
 
@@ -86,6 +87,7 @@ void CargoHold::Load(const DataNode &node)
 			}
 		}
 	}
+	Recount();
 }
 
 
@@ -177,7 +179,7 @@ int CargoHold::Free() const
 // (Some outfits may have non-integral masses.)
 int CargoHold::Used() const
 {
-	return CommoditiesSize() + OutfitsSize() + MissionCargoSize();
+	return commoditiesSize + outfitsSize + missionCargoSize;
 }
 
 
@@ -185,10 +187,7 @@ int CargoHold::Used() const
 // Get the total number of tons of commodities.
 int CargoHold::CommoditiesSize() const
 {
-	int size = 0;
-	for(const auto &it : commodities)
-		size += it.second;
-	return size;
+	return commoditiesSize;
 }
 
 
@@ -196,10 +195,7 @@ int CargoHold::CommoditiesSize() const
 // Get the total mass of outfit cargo, rounded up to the nearest ton.
 int CargoHold::OutfitsSize() const
 {
-	double size = 0.;
-	for(const auto &it : outfits)
-		size += it.second * it.first->Mass();
-	return ceil(size);
+	return outfitsSize;
 }
 
 
@@ -222,10 +218,7 @@ bool CargoHold::HasOutfits() const
 // Get the total mass of mission cargo.
 int CargoHold::MissionCargoSize() const
 {
-	int size = 0;
-	for(const auto &it : missionCargo)
-		size += it.second;
-	return size;
+	return missionCargoSize;
 }
 
 
@@ -356,6 +349,7 @@ int CargoHold::Transfer(const string &commodity, int amount, CargoHold &to)
 	int removed = Remove(commodity, amount);
 	int added = to.Add(commodity, removed);
 	commodities[commodity] += removed - added;
+	Recount();
 	
 	return added;
 }
@@ -374,6 +368,7 @@ int CargoHold::Transfer(const Outfit *outfit, int amount, CargoHold &to)
 	int removed = Remove(outfit, amount);
 	int added = to.Add(outfit, removed);
 	outfits[outfit] += removed - added;
+	Recount();
 	
 	return added;
 }
@@ -401,6 +396,8 @@ int CargoHold::Transfer(const Mission *mission, int amount, CargoHold &to)
 	
 	missionCargo[mission] -= amount;
 	to.missionCargo[mission] += amount;
+	Recount();
+	to.Recount();
 	
 	return amount;
 }
@@ -467,6 +464,7 @@ int CargoHold::Add(const string &commodity, int amount)
 	if(size >= 0)
 		amount = max(0, min(amount, Free()));
 	commodities[commodity] += amount;
+	Recount();
 	return amount;
 }
 
@@ -483,6 +481,7 @@ int CargoHold::Add(const Outfit *outfit, int amount)
 	if(size >= 0 && mass > 0.)
 		amount = max(0, min(amount, static_cast<int>(Free() / mass)));
 	outfits[outfit] += amount;
+	Recount();
 	return amount;
 }
 
@@ -496,6 +495,7 @@ int CargoHold::Remove(const string &commodity, int amount)
 	
 	amount = min(amount, commodities[commodity]);
 	commodities[commodity] -= amount;
+	Recount();
 	return amount;
 }
 
@@ -509,6 +509,7 @@ int CargoHold::Remove(const Outfit *outfit, int amount)
 	
 	amount = min(amount, outfits[outfit]);
 	outfits[outfit] -= amount;
+	Recount();
 	return amount;
 }
 
@@ -524,6 +525,7 @@ void CargoHold::AddMissionCargo(const Mission *mission)
 		missionCargo[mission] += mission->CargoSize();
 	if(mission && mission->Passengers())
 		passengers[mission] += mission->Passengers();
+	Recount();
 }
 
 
@@ -533,6 +535,7 @@ void CargoHold::RemoveMissionCargo(const Mission *mission)
 {
 	missionCargo.erase(mission);
 	passengers.erase(mission);
+	Recount();
 }
 
 
@@ -585,3 +588,24 @@ int CargoHold::IllegalCargoFine() const
 	
 	return worst;
 }
+
+
+
+// Update the cached totals of how much space each kind of cargo takes up.
+// These are queried far more often than the cargo changes.
+void CargoHold::Recount()
+{
+	commoditiesSize = 0;
+	for(const auto &it : commodities)
+		commoditiesSize += it.second;
+	
+	// Outfits may have non-integral masses, so round the total up.
+	double mass = 0.;
+	for(const auto &it : outfits)
+		mass += it.second * it.first->Mass();
+	outfitsSize = ceil(mass);
+	
+	missionCargoSize = 0;
+	for(const auto &it : missionCargo)
+		missionCargoSize += it.second;
+}
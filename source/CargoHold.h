@@ -104,6 +104,11 @@ public:
 	int IllegalCargoFine() const;
 	
 	
+private:
+	// Update the cached totals of how much space each kind of cargo takes up.
+	void Recount();
+	
+	
 private:
 	// Use -1 to indicate unlimited capacity.
 	int size = -1;
@@ -114,6 +119,11 @@ private:
 	std::map<const Outfit *, int> outfits;
 	std::map<const Mission *, int> missionCargo;
 	std::map<const Mission *, int> passengers;
+	
+	// Cached totals of the space used by each kind of cargo.
+	int commoditiesSize = 0;
+	int outfitsSize = 0;
+	int missionCargoSize = 0;
 };
 
 
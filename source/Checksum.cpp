@@ -0,0 +1,140 @@
+/* Checksum.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Checksum.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Point.h"
+
+#include <cstring>
+#include <iostream>
+#include <list>
+
+using namespace std;
+
+namespace {
+	// Describe a line of a checksum file, without the checksum at the end.
+	string Describe(const DataNode &node)
+	{
+		string result;
+		for(int i = 0; i < node.Size() - 1; ++i)
+			result += (i ? " " : "") + node.Token(i);
+		return result;
+	}
+}
+
+
+
+void Checksum::Add(uint64_t bits)
+{
+	// This is FNV-1a, taking eight bytes at a time, with an extra shift so
+	// that the high bits also affect the low ones.
+	value = (value ^ bits) * 0x100000001B3ull;
+	value ^= value >> 32;
+}
+
+
+
+void Checksum::Add(double number)
+{
+	uint64_t bits;
+	memcpy(&bits, &number, sizeof(bits));
+	Add(bits);
+}
+
+
+
+void Checksum::Add(const Point &point)
+{
+	Add(point.X());
+	Add(point.Y());
+}
+
+
+
+void Checksum::Add(const string &text)
+{
+	Add(static_cast<uint64_t>(text.length()));
+	for(char c : text)
+		Add(static_cast<uint64_t>(static_cast<unsigned char>(c)));
+}
+
+
+
+uint64_t Checksum::Value() const
+{
+	return value;
+}
+
+
+
+// Get the value as a string of hexadecimal digits.
+string Checksum::ToString() const
+{
+	static const char DIGITS[] = "0123456789abcdef";
+	
+	string result(16, '0');
+	for(int i = 0; i < 16; ++i)
+		result[i] = DIGITS[(value >> (60 - 4 * i)) & 0xF];
+	return result;
+}
+
+
+
+// Compare two files of checksums, and print the first step and object in
+// which they differ, if any.
+bool Checksum::Compare(const string &firstPath, const string &secondPath)
+{
+	DataFile first(firstPath);
+	DataFile second(secondPath);
+	
+	auto a = first.begin();
+	auto b = second.begin();
+	for( ; a != first.end() && b != second.end(); ++a, ++b)
+	{
+		// Find the first object in this step that is not the same.
+		auto ait = a->begin();
+		auto bit = b->begin();
+		while(ait != a->end() && bit != b->end() && ait->Tokens() == bit->Tokens())
+		{
+			++ait;
+			++bit;
+		}
+		bool sameObjects = (ait == a->end() && bit == b->end());
+		if(sameObjects && a->Tokens() == b->Tokens())
+			continue;
+		
+		cout << "The checksums differ in " << Describe(*a);
+		if(a->Token(1) != b->Token(1))
+			cout << " and " << Describe(*b);
+		cout << "." << endl;
+		if(ait != a->end() && bit != b->end())
+		{
+			cout << "The first difference is in " << Describe(*ait);
+			if(Describe(*ait) != Describe(*bit))
+				cout << " and " << Describe(*bit);
+			cout << "." << endl;
+		}
+		else if(!sameObjects)
+			cout << "One step has more objects than the other." << endl;
+		return false;
+	}
+	if(a != first.end() || b != second.end())
+	{
+		cout << "The checksums are the same until one file ends." << endl;
+		return false;
+	}
+	
+	cout << "The checksums are the same." << endl;
+	return true;
+}
@@ -0,0 +1,51 @@
+/* Checksum.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef CHECKSUM_H_
+#define CHECKSUM_H_
+
+#include <cstdint>
+#include <string>
+
+class Point;
+
+
+
+// Class for mixing the state of the simulation into a single number, so that
+// two runs of the same scenario can be checked for whether they did exactly
+// the same thing. Numbers are mixed in bit by bit, so the slightest difference
+// in rounding changes the result. The engine writes one checksum for each step
+// if asked to, and Compare() finds the first step where two such files differ.
+class Checksum {
+public:
+	void Add(uint64_t value);
+	void Add(double value);
+	void Add(const Point &point);
+	void Add(const std::string &value);
+	
+	uint64_t Value() const;
+	// Get the value as a string of hexadecimal digits, since data files store
+	// numbers with less precision than this.
+	std::string ToString() const;
+	
+	// Compare two files of checksums, and print the first step and object in
+	// which they differ, if any. This returns true if they are the same.
+	static bool Compare(const std::string &firstPath, const std::string &secondPath);
+	
+	
+private:
+	uint64_t value = 0xCBF29CE484222325ull;
+};
+
+
+
+#endif
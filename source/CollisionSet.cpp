@@ -21,9 +21,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Ship.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <numeric>
-#include <set>
 #include <string>
 
 using namespace std;
@@ -35,6 +35,17 @@ namespace {
 	constexpr int USED_MAX_VELOCITY = MAX_VELOCITY - 1;
 	// Warn the user only once about too-large projectile velocities.
 	bool warned = false;
+	
+	// The range of cell sizes to choose from, as powers of two. There are
+	// always at least this many rows and columns in the grid.
+	constexpr unsigned MIN_SHIFT = 6u;
+	constexpr unsigned MIN_CELLS_SHIFT = 2u;
+	// If the objects are so spread out that there would be fewer than this many
+	// of them per cell on average, bigger cells are cheaper to walk through.
+	constexpr double MIN_OCCUPANCY = 1. / 16.;
+	// How many steps in a row a different cell size must be better before the
+	// grid switches to it.
+	constexpr int PATIENCE = 30;
 }
 
 
@@ -43,35 +54,41 @@ namespace {
 CollisionSet::CollisionSet(unsigned cellSize, unsigned cellCount)
 {
 	// Right shift amount to convert from (x, y) location to grid (x, y).
-	SHIFT = 0u;
+	unsigned shift = 0u;
 	while(cellSize >>= 1u)
-		++SHIFT;
-	CELL_SIZE = (1u << SHIFT);
-	CELL_MASK = CELL_SIZE - 1u;
+		++shift;
 	
-	// Number of grid rows and columns.
-	CELLS = 1u;
+	// The grid always wraps around at the same distance, no matter what cell
+	// size it picks.
+	wrapShift = shift;
 	while(cellCount >>= 1u)
-		CELLS <<= 1;
-	WRAP_MASK = CELLS - 1u;
+		++wrapShift;
+	SetShift(shift);
+	desiredShift = shift;
 	
 	// Just in case Clear() isn't called before objects are added:
 	Clear(0);
+	Rebuild();
 }
 
 
 
-// Clear all objects in the set.
+// Clear all objects in the set. The lookup table is kept until Finish() is
+// called, so that if the same objects are added again, it only needs to update
+// the ones that have moved into a different grid cell.
 void CollisionSet::Clear(int step)
 {
 	this->step = step;
 	
 	added.clear();
-	sorted.clear();
-	counts.clear();
-	// The counts vector starts with two sentinel slots that will be used in the
-	// course of performing the radix sort.
-	counts.resize(CELLS * CELLS + 2u, 0u);
+	bodies.clear();
+	radiusSum = 0.;
+	maxRadius = 0.;
+	for(Level &level : levels)
+	{
+		level.added.clear();
+		level.addedRadius = 0.;
+	}
 }
 
 
@@ -79,23 +96,21 @@ void CollisionSet::Clear(int step)
 // Add an object to the set.
 void CollisionSet::Add(Body &body)
 {
-	// Calculate the range of (x, y) grid coordinates this object covers.
-	int minX = static_cast<int>(body.Position().X() - body.Radius()) >> SHIFT;
-	int minY = static_cast<int>(body.Position().Y() - body.Radius()) >> SHIFT;
-	int maxX = static_cast<int>(body.Position().X() + body.Radius()) >> SHIFT;
-	int maxY = static_cast<int>(body.Position().Y() + body.Radius()) >> SHIFT;
-	
-	// Add a pointer to this object in every grid cell it occupies.
-	for(int y = minY; y <= maxY; ++y)
+	// Keep track of how big the objects are and how widely they are spread
+	// out, to choose the best cell size.
+	const Point &position = body.Position();
+	if(bodies.empty())
+		boundsMin = boundsMax = position;
+	else
 	{
-		auto gy = y & WRAP_MASK;
-		for(int x = minX; x <= maxX; ++x)
-		{
-			auto gx = x & WRAP_MASK;
-			added.emplace_back(&body, x, y);
-			++counts[gy * CELLS + gx + 2];
-		}
+		boundsMin = Point(min(boundsMin.X(), position.X()), min(boundsMin.Y(), position.Y()));
+		boundsMax = Point(max(boundsMax.X(), position.X()), max(boundsMax.Y(), position.Y()));
 	}
+	bodies.push_back(&body);
+	radiusSum += body.Radius();
+	maxRadius = max(maxRadius, body.Radius());
+	
+	AddEntries(body);
 }
 
 
@@ -103,24 +118,104 @@ void CollisionSet::Add(Body &body)
 // Finish adding objects (and organize them into the final lookup table).
 void CollisionSet::Finish()
 {
-	// Perform a partial sum to convert the counts of items in each bin into the
-	// index of the output element where that bin begins.
-	partial_sum(counts.begin(), counts.end(), counts.begin());
+	// If a different cell size has been better for long enough, switch to it.
+	// That changes which cells every object is in, so they must all be added
+	// again and the lookup table built from scratch.
+	unsigned best = BestShift();
+	if(best != desiredShift)
+		desiredSteps = 0;
+	desiredShift = best;
+	if(best != SHIFT && ++desiredSteps >= PATIENCE)
+	{
+		desiredSteps = 0;
+		SetShift(best);
+		added.clear();
+		for(Body *body : bodies)
+			AddEntries(*body);
+		Rebuild();
+	}
+	// Otherwise, most objects stay in the same grid cells from one step to the
+	// next, so if possible just move the few entries that have changed.
+	else if(!Update())
+		Rebuild();
+	previous.swap(added);
 	
-	// Allocate space for a sorted copy of the vector.
-	sorted.resize(added.size());
+	// Every object's mask lies within its radius of its center. If there are
+	// no objects at all, the box is inside out, so nothing overlaps it.
+	if(bodies.empty())
+	{
+		extentMin = Point(1., 1.);
+		extentMax = Point(-1., -1.);
+	}
+	else
+	{
+		extentMin = boundsMin - Point(maxRadius + 1., maxRadius + 1.);
+		extentMax = boundsMax + Point(maxRadius + 1., maxRadius + 1.);
+	}
 	
-	// Now, perform a radix sort.
-	for(const Entry &entry : added)
+	// The coarser grids only hold a few objects, so just sort them into bins
+	// the same way that Rebuild() does.
+	largeCount = 0;
+	for(Level &level : levels)
 	{
-		auto gx = entry.x & WRAP_MASK;
-		auto gy = entry.y & WRAP_MASK;
-		auto index = gy * CELLS + gx + 1;
-		
-		sorted[counts[index]++] = entry;
+		auto bin = [&level](const Entry &entry)
+		{
+			return (entry.y & level.wrapMask) * level.cells + (entry.x & level.wrapMask);
+		};
+		level.radius = level.addedRadius;
+		level.counts.assign(level.cells * level.cells + 2u, 0u);
+		for(const Entry &entry : level.added)
+			++level.counts[bin(entry) + 2];
+		partial_sum(level.counts.begin(), level.counts.end(), level.counts.begin());
+		level.sorted.resize(level.added.size());
+		for(const Entry &entry : level.added)
+			level.sorted[level.counts[bin(entry) + 1]++] = entry;
+		largeCount += level.sorted.size();
 	}
 	
-	// Now, counts[index] is where a certain bin begins.
+	// Make sure every object's animation frame is cached for this step, so
+	// that queries do not need to modify the objects and can safely be made
+	// from multiple threads at once.
+	for(const Entry &entry : sorted)
+		entry.body->GetMask(step);
+	for(const Level &level : levels)
+		for(const Entry &entry : level.sorted)
+			entry.body->GetMask(step);
+	
+	// Record how the objects are spread through the grid.
+	stats.cellSize = CELL_SIZE;
+	stats.objects = bodies.size();
+	stats.entries = sorted.size();
+	stats.large = largeCount;
+	stats.occupiedCells = 0;
+	stats.busiestCell = 0;
+	for(unsigned i = 0; i < CELLS * CELLS; ++i)
+	{
+		size_t count = counts[i + 1] - counts[i];
+		stats.occupiedCells += (count != 0);
+		stats.busiestCell = max(stats.busiestCell, count);
+	}
+}
+
+
+
+// Get statistics about how the objects are spread through the grid, as of the
+// last Finish().
+const CollisionSet::Stats &CollisionSet::GetStats() const
+{
+	return stats;
+}
+
+
+
+// Check whether anything swept along the given line, out to the given radius,
+// could come anywhere near the objects in the set as of the last Finish().
+bool CollisionSet::MayReach(const Point &from, const Point &to, double radius) const
+{
+	return min(from.X(), to.X()) - radius <= extentMax.X()
+		&& max(from.X(), to.X()) + radius >= extentMin.X()
+		&& min(from.Y(), to.Y()) - radius <= extentMax.Y()
+		&& max(from.Y(), to.Y()) + radius >= extentMin.Y();
 }
 
 
@@ -145,6 +240,11 @@ Body *CollisionSet::Line(const Projectile &projectile, double *closestHit) const
 Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 		const Government *pGov, const Body *target) const
 {
+	// Lines that miss the whole region that the objects are in, such as those
+	// of projectiles that are far off in empty space, cannot hit anything.
+	if(!MayReach(from, to))
+		return nullptr;
+	
 	int x = from.X();
 	int y = from.Y();
 	int endX = to.X();
@@ -193,6 +293,7 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 				result = it->body;
 			}
 		}
+		LineLarge(from, to, pGov, target, closest, result);
 		if(closest < 1. && closestHit)
 			*closestHit = closest;
 		return result;
@@ -232,8 +333,11 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 	if(stepY > 0)
 		ry = fullScale - ry;
 	
-	// Keep track of which objects we've already considered.
-	set<const Body *> seen;
+	// Keep track of which objects we've already considered. A line only passes
+	// through a few grid cells, so this list stays short, and it is reused from
+	// one query to the next so that it is only allocated once per thread.
+	thread_local vector<const Body *> seen;
+	seen.clear();
 	while(true)
 	{
 		// Examine all objects in the current grid cell.
@@ -247,9 +351,9 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 			if(it->x != gx || it->y != gy)
 				continue;
 			
-			if(seen.count(it->body))
+			if(find(seen.begin(), seen.end(), it->body) != seen.end())
 				continue;
-			seen.insert(it->body);
+			seen.push_back(it->body);
 			
 			// Check if this projectile can hit this object. If either the
 			// projectile or the object has no government, it will always hit.
@@ -305,6 +409,10 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 		}
 	}
 	
+	// The objects in the coarser grids are only checked once the line has
+	// been followed through the main grid, because finding a hit there stops
+	// the search.
+	LineLarge(from, to, pGov, target, closest, result);
 	if(closest < 1. && closestHit)
 		*closestHit = closest;
 	return result;
@@ -312,8 +420,185 @@ Body *CollisionSet::Line(const Point &from, const Point &to, double *closestHit,
 
 
 
+// Check the projectiles in the range [begin, end) all at once, storing the
+// first object each one hits and the fraction of its motion this step at
+// which it hits (or 1 if it does not) in the matching slot of "hits."
+void CollisionSet::Line(const vector<Projectile> &projectiles, size_t begin, size_t end,
+		vector<pair<Body *, double>> &hits) const
+{
+	// Sort the projectiles that start and end in the same grid cell by which
+	// cell that is. The rest must walk the grid one cell at a time, so just
+	// check each of them individually.
+	vector<pair<unsigned, size_t>> binned;
+	binned.reserve(end - begin);
+	for(size_t i = begin; i < end; ++i)
+	{
+		const Projectile &projectile = projectiles[i];
+		hits[i] = make_pair(nullptr, 1.);
+		
+		Point from = projectile.Position();
+		Point to = from + projectile.Velocity();
+		if(!MayReach(from, to))
+			continue;
+		int gx = static_cast<int>(from.X()) >> SHIFT;
+		int gy = static_cast<int>(from.Y()) >> SHIFT;
+		if(gx == (static_cast<int>(to.X()) >> SHIFT) && gy == (static_cast<int>(to.Y()) >> SHIFT))
+			binned.emplace_back((gy & WRAP_MASK) * CELLS + (gx & WRAP_MASK), i);
+		else
+			hits[i].first = Line(projectile, &hits[i].second);
+	}
+	sort(binned.begin(), binned.end());
+	
+	// Now, test each grid cell's objects against all the projectiles in it.
+	for(auto first = binned.begin(); first != binned.end(); )
+	{
+		unsigned cell = first->first;
+		auto last = first;
+		while(last != binned.end() && last->first == cell)
+			++last;
+		
+		vector<Entry>::const_iterator it = sorted.begin() + counts[cell];
+		vector<Entry>::const_iterator cellEnd = sorted.begin() + counts[cell + 1];
+		for( ; it != cellEnd; ++it)
+		{
+			const Government *iGov = it->body->GetGovernment();
+			const Mask &mask = it->body->GetMask();
+			for(auto bit = first; bit != last; ++bit)
+			{
+				const Projectile &projectile = projectiles[bit->second];
+				const Point &from = projectile.Position();
+				
+				// Skip objects that were put in this same grid cell only because
+				// of the cell coordinates wrapping around.
+				if(it->x != (static_cast<int>(from.X()) >> SHIFT) || it->y != (static_cast<int>(from.Y()) >> SHIFT))
+					continue;
+				
+				// Check if this projectile can hit this object. If either the
+				// projectile or the object has no government, it will always hit.
+				const Government *pGov = projectile.GetGovernment();
+				if(it->body != projectile.Target() && iGov && pGov && !iGov->IsEnemy(pGov))
+					continue;
+				
+				Point offset = from - it->body->Position();
+				double range = mask.Collide(offset, (from + projectile.Velocity()) - from, it->body->Facing());
+				
+				pair<Body *, double> &hit = hits[bit->second];
+				if(range < hit.second)
+				{
+					hit.second = range;
+					hit.first = it->body;
+				}
+			}
+		}
+		first = last;
+	}
+	
+	// The projectiles that were checked by cell have not yet been checked
+	// against the objects in the coarser grids.
+	if(largeCount)
+		for(const pair<unsigned, size_t> &it : binned)
+		{
+			const Projectile &projectile = projectiles[it.second];
+			pair<Body *, double> &hit = hits[it.second];
+			LineLarge(projectile.Position(), projectile.Position() + projectile.Velocity(),
+				projectile.GetGovernment(), projectile.Target(), hit.second, hit.first);
+		}
+}
+
+
+
 // Get all objects within the given range of the given point.
 const vector<Body *> &CollisionSet::Circle(const Point &center, double radius) const
+{
+	Circle(center, radius, result);
+	return result;
+}
+
+
+
+// Store all objects within the given range of the given point in the given
+// vector. This does not modify the set, so it can be called from several
+// threads at once.
+void CollisionSet::Circle(const Point &center, double radius, vector<Body *> &result) const
+{
+	result.clear();
+	for(Body *body : Nearby(center, radius))
+		if(IsInCircle(*body, center, radius))
+			result.push_back(body);
+}
+
+
+
+// Find the first object within the given range of the given point that passes
+// the given test. This does not modify the set.
+Body *CollisionSet::FindInCircle(const Point &center, double radius, const function<bool(const Body *)> &test) const
+{
+	// Nearby() returns a buffer that is reused by the next query on this
+	// thread, so copy the objects in range before running the test, in case the
+	// test queries a collision set itself.
+	vector<Body *> inRange;
+	Circle(center, radius, inRange);
+	for(Body *body : inRange)
+		if(test(body))
+			return body;
+	return nullptr;
+}
+
+
+
+// Get every object in the grid cells that the given rectangle overlaps, treating
+// the grid as wrapping around. That is, objects that lie a whole number of wrap
+// distances away from the rectangle are also included, so this is only suitable
+// for objects that really do repeat, like asteroids. This is not an exact test:
+// some of the objects may be just outside the rectangle.
+const vector<Body *> &CollisionSet::Region(const Point &topLeft, const Point &bottomRight) const
+{
+	// Calculate the range of grid cells the rectangle covers. If it covers the
+	// whole width or height of the grid, each cell only needs to be visited once.
+	int minX = static_cast<int>(floor(topLeft.X())) >> SHIFT;
+	int minY = static_cast<int>(floor(topLeft.Y())) >> SHIFT;
+	int maxX = min(static_cast<int>(floor(bottomRight.X())) >> SHIFT, minX + static_cast<int>(CELLS) - 1);
+	int maxY = min(static_cast<int>(floor(bottomRight.Y())) >> SHIFT, minY + static_cast<int>(CELLS) - 1);
+	
+	result.clear();
+	for(int y = minY; y <= maxY; ++y)
+	{
+		auto gy = y & WRAP_MASK;
+		for(int x = minX; x <= maxX; ++x)
+		{
+			auto gx = x & WRAP_MASK;
+			auto i = gy * CELLS + gx;
+			vector<Entry>::const_iterator it = sorted.begin() + counts[i];
+			vector<Entry>::const_iterator end = sorted.begin() + counts[i + 1];
+			for( ; it != end; ++it)
+				result.push_back(it->body);
+		}
+	}
+	
+	FindLarge(topLeft, bottomRight, true, result);
+	
+	// An object that is big enough to overlap several cells is listed in each
+	// of them, so remove the duplicates.
+	sort(result.begin(), result.end());
+	result.erase(unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+
+
+// Get roughly how many grid cells a circle query with the given radius will
+// examine, to decide whether it is cheaper than checking every object.
+double CollisionSet::CircleCost(double radius) const
+{
+	double span = 2. * radius / CELL_SIZE + 1.;
+	return span * span;
+}
+
+
+
+// Get each object in the grid cells that a circle with the given center and
+// radius overlaps, listing it only once even if it is in several of them.
+const vector<Body *> &CollisionSet::Nearby(const Point &center, double radius) const
 {
 	// Calculate the range of (x, y) grid coordinates this circle covers.
 	int minX = static_cast<int>(center.X() - radius) >> SHIFT;
@@ -321,9 +606,15 @@ const vector<Body *> &CollisionSet::Circle(const Point &center, double radius) c
 	int maxX = static_cast<int>(center.X() + radius) >> SHIFT;
 	int maxY = static_cast<int>(center.Y() + radius) >> SHIFT;
 	
-	// Keep track of which objects we've already considered.
-	set<const Body *> seen;
-	result.clear();
+	// Gather every object in those cells. An object that overlaps several of
+	// them is listed once for each, so keep a sorted copy of the list to find
+	// out which ones have been listed already. These buffers are reused from
+	// one query to the next, so they are only allocated once per thread.
+	thread_local vector<Body *> candidates;
+	thread_local vector<Body *> unique;
+	thread_local vector<char> listed;
+	thread_local vector<Body *> nearby;
+	candidates.clear();
 	for(int y = minY; y <= maxY; ++y)
 	{
 		auto gy = y & WRAP_MASK;
@@ -334,23 +625,338 @@ const vector<Body *> &CollisionSet::Circle(const Point &center, double radius) c
 			vector<Entry>::const_iterator it = sorted.begin() + counts[i];
 			vector<Entry>::const_iterator end = sorted.begin() + counts[i + 1];
 			
+			// Skip objects that were put in this same grid cell only because
+			// of the cell coordinates wrapping around.
 			for( ; it != end; ++it)
+				if(it->x == x && it->y == y)
+					candidates.push_back(it->body);
+		}
+	}
+	unique = candidates;
+	sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	listed.assign(unique.size(), false);
+	
+	// List the objects in the order they were found, so that the results do
+	// not depend on where in memory each object happens to be.
+	nearby.clear();
+	for(Body *body : candidates)
+	{
+		char &isListed = listed[lower_bound(unique.begin(), unique.end(), body) - unique.begin()];
+		if(!isListed)
+		{
+			isListed = true;
+			nearby.push_back(body);
+		}
+	}
+	// Each object in the coarser grids is only listed once.
+	FindLarge(Point(center.X() - radius, center.Y() - radius), Point(center.X() + radius, center.Y() + radius),
+		false, nearby);
+	return nearby;
+}
+
+
+
+// Check whether the given object is within the given range of the point.
+bool CollisionSet::IsInCircle(const Body &body, const Point &center, double radius) const
+{
+	Point offset = center - body.Position();
+	return offset.Length() <= radius || body.GetMask(step).WithinRange(offset, body.Facing(), radius);
+}
+
+
+
+// Add each object in the coarser grids that may overlap the given rectangle to
+// the given list.
+void CollisionSet::FindLarge(const Point &topLeft, const Point &bottomRight, bool wrap, vector<Body *> &bodies) const
+{
+	if(!largeCount)
+		return;
+	
+	for(const Level &level : levels)
+	{
+		if(level.sorted.empty())
+			continue;
+		
+		// An object may overlap the rectangle even if its center is as far
+		// outside of it as the largest radius in this level.
+		int minX = static_cast<int>(floor(topLeft.X() - level.radius)) >> level.shift;
+		int minY = static_cast<int>(floor(topLeft.Y() - level.radius)) >> level.shift;
+		int maxX = static_cast<int>(ceil(bottomRight.X() + level.radius)) >> level.shift;
+		int maxY = static_cast<int>(ceil(bottomRight.Y() + level.radius)) >> level.shift;
+		// If wrapping, each cell only needs to be visited once.
+		if(wrap)
+		{
+			maxX = min(maxX, minX + static_cast<int>(level.cells) - 1);
+			maxY = min(maxY, minY + static_cast<int>(level.cells) - 1);
+		}
+		
+		for(int y = minY; y <= maxY; ++y)
+		{
+			auto gy = y & level.wrapMask;
+			for(int x = minX; x <= maxX; ++x)
 			{
-				// Skip objects that were put in this same grid cell only because
-				// of the cell coordinates wrapping around.
-				if(it->x != x || it->y != y)
-					continue;
-				
-				if(seen.count(it->body))
-					continue;
-				seen.insert(it->body);
-				
-				const Mask &mask = it->body->GetMask(step);
-				Point offset = center - it->body->Position();
-				if(offset.Length() <= radius || mask.WithinRange(offset, it->body->Facing(), radius))
-					result.push_back(it->body);
+				auto i = gy * level.cells + (x & level.wrapMask);
+				vector<Entry>::const_iterator it = level.sorted.begin() + level.counts[i];
+				vector<Entry>::const_iterator end = level.sorted.begin() + level.counts[i + 1];
+				for( ; it != end; ++it)
+					if(wrap || (it->x == x && it->y == y))
+						bodies.push_back(it->body);
 			}
 		}
 	}
-	return result;
+}
+
+
+
+// Check for collisions between a line and the objects in the coarser grids,
+// updating the closest hit so far if any of them are closer.
+void CollisionSet::LineLarge(const Point &from, const Point &to, const Government *pGov,
+	const Body *target, double &closest, Body *&result) const
+{
+	if(!largeCount)
+		return;
+	
+	thread_local vector<Body *> candidates;
+	candidates.clear();
+	FindLarge(Point(min(from.X(), to.X()), min(from.Y(), to.Y())),
+		Point(max(from.X(), to.X()), max(from.Y(), to.Y())), false, candidates);
+	for(Body *body : candidates)
+	{
+		// Check if this projectile can hit this object. If either the
+		// projectile or the object has no government, it will always hit.
+		const Government *iGov = body->GetGovernment();
+		if(body != target && iGov && pGov && !iGov->IsEnemy(pGov))
+			continue;
+		
+		const Mask &mask = body->GetMask(step);
+		double range = mask.Collide(from - body->Position(), to - from, body->Facing());
+		if(range < closest)
+		{
+			closest = range;
+			result = body;
+		}
+	}
+}
+
+
+
+// Switch to the given cell size. The wrap distance stays the same, so the number
+// of cells changes to match, and so do the coarser grids.
+void CollisionSet::SetShift(unsigned shift)
+{
+	SHIFT = shift;
+	CELL_SIZE = (1u << SHIFT);
+	CELL_MASK = CELL_SIZE - 1u;
+	
+	// Number of grid rows and columns.
+	CELLS = 1u << (wrapShift - SHIFT);
+	WRAP_MASK = CELLS - 1u;
+	
+	// Each coarser grid has half as many rows and columns as the one before
+	// it, down to a grid of just one cell.
+	levels.clear();
+	for(unsigned cells = CELLS >> 1; cells; cells >>= 1)
+	{
+		levels.emplace_back();
+		Level &level = levels.back();
+		level.shift = SHIFT + levels.size();
+		level.cells = cells;
+		level.wrapMask = cells - 1u;
+		level.counts.assign(cells * cells + 2u, 0u);
+	}
+}
+
+
+
+// Pick the cell size that suits the objects that have been added this step.
+unsigned CollisionSet::BestShift() const
+{
+	// Don't change anything if there is nothing to go by.
+	if(bodies.empty())
+		return SHIFT;
+	
+	// Ideally, each cell is about as wide as a typical object, so that one
+	// only covers a few cells and a cell only holds a few objects.
+	double size = 2. * radiusSum / bodies.size();
+	// But if the objects are spread very thinly, most of those cells would be
+	// empty, and walking through them would be the main cost.
+	double width = max(boundsMax.X() - boundsMin.X(), size);
+	double height = max(boundsMax.Y() - boundsMin.Y(), size);
+	double density = bodies.size() / (width * height);
+	size = max(size, sqrt(MIN_OCCUPANCY / density));
+	
+	unsigned shift = min(MIN_SHIFT, wrapShift);
+	unsigned maxShift = max(shift, wrapShift - min(wrapShift, MIN_CELLS_SHIFT));
+	while(shift < maxShift && (1u << shift) < size)
+		++shift;
+	return shift;
+}
+
+
+
+// Add the entries for the given object to the grid it belongs in.
+void CollisionSet::AddEntries(Body &body)
+{
+	// An object that would cover more than a few grid cells in each direction
+	// goes in the first of the coarser grids whose cells are at least as big as
+	// its radius, in the one cell that its center is in.
+	double radius = body.Radius();
+	if(radius > CELL_SIZE && !levels.empty())
+	{
+		size_t i = 0;
+		while(i + 1 < levels.size() && radius > (1u << levels[i].shift))
+			++i;
+		Level &level = levels[i];
+		level.added.emplace_back(&body,
+			static_cast<int>(body.Position().X()) >> level.shift,
+			static_cast<int>(body.Position().Y()) >> level.shift);
+		level.addedRadius = max(level.addedRadius, radius);
+		return;
+	}
+	
+	// Calculate the range of (x, y) grid coordinates this object covers.
+	int minX = static_cast<int>(body.Position().X() - body.Radius()) >> SHIFT;
+	int minY = static_cast<int>(body.Position().Y() - body.Radius()) >> SHIFT;
+	int maxX = static_cast<int>(body.Position().X() + body.Radius()) >> SHIFT;
+	int maxY = static_cast<int>(body.Position().Y() + body.Radius()) >> SHIFT;
+	
+	// Add a pointer to this object in every grid cell it occupies.
+	for(int y = minY; y <= maxY; ++y)
+		for(int x = minX; x <= maxX; ++x)
+			added.emplace_back(&body, x, y);
+}
+
+
+
+// Rebuild the lookup table from scratch.
+void CollisionSet::Rebuild()
+{
+	// The counts vector starts with two sentinel slots that will be used in the
+	// course of performing the radix sort.
+	counts.assign(CELLS * CELLS + 2u, 0u);
+	for(const Entry &entry : added)
+		++counts[Bin(entry) + 2];
+	
+	// Perform a partial sum to convert the counts of items in each bin into the
+	// index of the output element where that bin begins.
+	partial_sum(counts.begin(), counts.end(), counts.begin());
+	
+	// Allocate space for a sorted copy of the vector.
+	sorted.resize(added.size());
+	
+	// Now, perform a radix sort.
+	for(const Entry &entry : added)
+		sorted[counts[Bin(entry) + 1]++] = entry;
+	
+	// Now, counts[index] is where a certain bin begins. The bin just past the
+	// last grid cell is always empty, and is used when adding or removing
+	// entries in Update().
+}
+
+
+
+// If the same objects were added as in the previous step, update the lookup
+// table by moving only the entries that have changed grid cells. Return false
+// if the table must be rebuilt instead.
+bool CollisionSet::Update()
+{
+	// Compare the objects one at a time. Each object has one entry for each
+	// grid cell that it covers, and its entries are all added together.
+	removed.clear();
+	inserted.clear();
+	auto oldIt = previous.begin();
+	auto newIt = added.begin();
+	while(oldIt != previous.end() && newIt != added.end())
+	{
+		if(oldIt->body != newIt->body)
+			return false;
+		auto oldEnd = oldIt;
+		while(oldEnd != previous.end() && oldEnd->body == oldIt->body)
+			++oldEnd;
+		auto newEnd = newIt;
+		while(newEnd != added.end() && newEnd->body == newIt->body)
+			++newEnd;
+		
+		for(auto it = oldIt; it != oldEnd; ++it)
+			if(find(newIt, newEnd, *it) == newEnd)
+				removed.push_back(*it);
+		for(auto it = newIt; it != newEnd; ++it)
+			if(find(oldIt, oldEnd, *it) == oldEnd)
+				inserted.push_back(*it);
+		
+		oldIt = oldEnd;
+		newIt = newEnd;
+	}
+	if(oldIt != previous.end() || newIt != added.end())
+		return false;
+	
+	// Moving an entry shifts every bin in between over by one, so if entries
+	// have moved too far in total it is faster to start over.
+	const unsigned end = CELLS * CELLS;
+	size_t moved = min(removed.size(), inserted.size());
+	size_t cost = 0;
+	for(size_t i = 0; i < removed.size(); ++i)
+	{
+		unsigned from = Bin(removed[i]);
+		unsigned to = (i < moved ? Bin(inserted[i]) : end);
+		cost += (from < to ? to - from : from - to);
+	}
+	for(size_t i = moved; i < inserted.size(); ++i)
+		cost += end - Bin(inserted[i]);
+	if(cost > 2 * added.size() + counts.size())
+		return false;
+	
+	// Entries that are being removed are moved into the empty bin past the
+	// end and then dropped, and new entries are pulled out of that bin.
+	for(size_t i = 0; i < removed.size(); ++i)
+	{
+		unsigned from = Bin(removed[i]);
+		auto it = find(sorted.begin() + counts[from], sorted.begin() + counts[from + 1], removed[i]);
+		if(i < moved)
+			Move(it - sorted.begin(), from, Bin(inserted[i]), inserted[i]);
+		else
+		{
+			Move(it - sorted.begin(), from, end, removed[i]);
+			sorted.pop_back();
+			--counts[end + 1];
+		}
+	}
+	for(size_t i = moved; i < inserted.size(); ++i)
+	{
+		sorted.push_back(inserted[i]);
+		++counts[end + 1];
+		Move(sorted.size() - 1, end, Bin(inserted[i]), inserted[i]);
+	}
+	return true;
+}
+
+
+
+// Move the entry at the given index of the sorted list from one bin to
+// another, and replace it with the given entry. Each bin in between is shifted
+// over by one by swapping the moving entry with the one at the bin's edge.
+void CollisionSet::Move(size_t index, unsigned from, unsigned to, const Entry &entry)
+{
+	for( ; from < to; ++from)
+	{
+		size_t last = --counts[from + 1];
+		swap(sorted[index], sorted[last]);
+		index = last;
+	}
+	for( ; from > to; --from)
+	{
+		size_t first = counts[from]++;
+		swap(sorted[index], sorted[first]);
+		index = first;
+	}
+	sorted[index] = entry;
+}
+
+
+
+// Get the index of the grid cell that the given entry is in.
+unsigned CollisionSet::Bin(const Entry &entry) const
+{
+	return (entry.y & WRAP_MASK) * CELLS + (entry.x & WRAP_MASK);
 }
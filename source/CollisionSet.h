@@ -13,10 +13,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef COLLISION_SET_H_
 #define COLLISION_SET_H_
 
+#include "Point.h"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
 #include <vector>
 
 class Government;
-class Point;
 class Projectile;
 class Body;
 
@@ -24,11 +28,29 @@ class Body;
 
 // A CollisionSet allows efficient collision detection by splitting space up
 // into a grid and keeping track of which objects are in each grid cell. A check
-// for collisions can then only examine objects in certain cells.
+// for collisions can then only examine objects in certain cells. Objects that
+// are much bigger than a grid cell would be listed in a great many cells, so
+// they are kept in coarser grids instead, each in just one cell.
 class CollisionSet {
+public:
+	// Statistics about how the objects are spread through the grid. Objects in
+	// the coarser grids are counted separately from the main grid's entries.
+	class Stats {
+	public:
+		unsigned cellSize = 0;
+		size_t objects = 0;
+		size_t entries = 0;
+		size_t large = 0;
+		size_t occupiedCells = 0;
+		size_t busiestCell = 0;
+	};
+	
+	
 public:
 	// Initialize a collision set. The cell size and cell count should both be
-	// powers of two; otherwise, they are rounded down to a power of two.
+	// powers of two; otherwise, they are rounded down to a power of two. The
+	// cell size is only a starting point: the set picks whichever size suits
+	// the objects in it best, keeping the same wrap distance.
 	CollisionSet(unsigned cellSize, unsigned cellCount);
 	
 	// Clear all objects in the set. Specify which engine step we are on, so we
@@ -38,6 +60,14 @@ public:
 	void Add(Body &body);
 	// Finish adding objects (and organize them into the final lookup table).
 	void Finish();
+	// Get statistics about how the objects are spread through the grid, as of
+	// the last Finish().
+	const Stats &GetStats() const;
+	// Check whether anything swept along the given line, out to the given
+	// radius, could come anywhere near the objects in the set as of the last
+	// Finish(). If not, it cannot collide with any of them, so the grid does
+	// not need to be searched at all.
+	bool MayReach(const Point &from, const Point &to, double radius = 0.) const;
 	
 	// Get the first object that collides with the given projectile. If a
 	// "closest hit" value is given, update that value.
@@ -46,9 +76,38 @@ public:
 	// position or its entire expected trajectory (for the auto-firing AI).
 	Body *Line(const Point &from, const Point &to, double *closestHit = nullptr,
 		const Government *pGov = nullptr, const Body *target = nullptr) const;
+	// Check the projectiles in the range [begin, end) all at once, storing the
+	// first object each one hits and the fraction of its motion this step at
+	// which it hits (or 1 if it does not) in the matching slot of "hits," which
+	// must be at least as large as the projectile list. Projectiles that lie in
+	// a single grid cell are grouped by cell so each cell's objects are only
+	// looked up once. This does not modify the set, so separate ranges may be
+	// checked in parallel.
+	void Line(const std::vector<Projectile> &projectiles, size_t begin, size_t end,
+		std::vector<std::pair<Body *, double>> &hits) const;
 	
 	// Get all objects within the given range of the given point.
 	const std::vector<Body *> &Circle(const Point &center, double radius) const;
+	// Store all objects within the given range of the given point in the given
+	// vector. Unlike the version above, this does not modify the set, so it can
+	// be called from several threads at once.
+	void Circle(const Point &center, double radius, std::vector<Body *> &result) const;
+	// Find the first object within the given range of the given point, in the
+	// same order that Circle() would list them, that passes the given test. The
+	// test is only run on objects that are in range, and the search stops as
+	// soon as it returns true. This does not modify the set, and the test may
+	// itself query this or any other collision set.
+	Body *FindInCircle(const Point &center, double radius, const std::function<bool(const Body *)> &test) const;
+	// Get every object in the grid cells that the given rectangle overlaps,
+	// treating the grid as wrapping around. That is, objects that lie a whole
+	// number of wrap distances away from the rectangle are also included, so
+	// this is only suitable for objects that really do repeat, like asteroids.
+	// This is not an exact test: some of the objects may be just outside the
+	// rectangle. Each object is only listed once.
+	const std::vector<Body *> &Region(const Point &topLeft, const Point &bottomRight) const;
+	// Get roughly how many grid cells a circle query with the given radius will
+	// examine, to decide whether it is cheaper than checking every object.
+	double CircleCost(double radius) const;
 	
 	
 private:
@@ -57,11 +116,68 @@ private:
 		Entry() = default;
 		Entry(Body *body, int x, int y) : body(body), x(x), y(y) {}
 		
+		bool operator==(const Entry &other) const { return body == other.body && x == other.x && y == other.y; }
+		
 		Body *body;
 		int x;
 		int y;
 	};
 	
+	// One of the coarser grids. Each level's cells are twice the size of the
+	// previous level's, and there are half as many of them in each direction,
+	// so every level wraps around at the same distance. An object is only
+	// listed in the cell that its center is in, so queries must look farther
+	// out by the radius of the biggest object in that level.
+	class Level {
+	public:
+		unsigned shift;
+		unsigned cells;
+		unsigned wrapMask;
+		
+		double radius = 0.;
+		double addedRadius = 0.;
+		std::vector<Entry> added;
+		std::vector<Entry> sorted;
+		// After Finish(), counts[index] is where a certain bin begins.
+		std::vector<unsigned> counts;
+	};
+	
+	
+private:
+	// Get each object in the grid cells that a circle with the given center
+	// and radius overlaps, listing it only once even if it is in several of
+	// them. The list is only valid until the next query on the same thread.
+	const std::vector<Body *> &Nearby(const Point &center, double radius) const;
+	// Check whether the given object is within the given range of the point.
+	bool IsInCircle(const Body &body, const Point &center, double radius) const;
+	// Add each object in the coarser grids that may overlap the given rectangle
+	// to the given list. If wrapping, objects that are a whole number of wrap
+	// distances away are included too, as in Region().
+	void FindLarge(const Point &topLeft, const Point &bottomRight, bool wrap, std::vector<Body *> &bodies) const;
+	// Check for collisions between a line and the objects in the coarser grids,
+	// updating the closest hit so far if any of them are closer.
+	void LineLarge(const Point &from, const Point &to, const Government *pGov,
+		const Body *target, double &closest, Body *&result) const;
+	
+	// Switch to the given cell size, as a power of two.
+	void SetShift(unsigned shift);
+	// Pick the cell size that suits the objects that have been added this step.
+	unsigned BestShift() const;
+	// Add the entries for the given object to the grid it belongs in.
+	void AddEntries(Body &body);
+	
+	// Rebuild the lookup table from scratch.
+	void Rebuild();
+	// If the same objects were added as in the previous step, update the lookup
+	// table by moving only the entries that have changed grid cells. Return
+	// false if the table must be rebuilt instead.
+	bool Update();
+	// Move the entry at the given index of the sorted list from one bin to
+	// another, and replace it with the given entry.
+	void Move(size_t index, unsigned from, unsigned to, const Entry &entry);
+	// Get the index of the grid cell that the given entry is in.
+	unsigned Bin(const Entry &entry) const;
+	
 	
 private:
 	// The size of individual cells of the grid.
@@ -72,6 +188,24 @@ private:
 	// The number of grid cells.
 	unsigned CELLS;
 	unsigned WRAP_MASK;
+	// The wrap distance, which stays the same even if the cell size changes.
+	unsigned wrapShift;
+	
+	// The cell size that would be better than the current one, and how many
+	// steps in a row it has been better.
+	unsigned desiredShift;
+	int desiredSteps = 0;
+	// The objects added since the last Clear(), their total radius, and the
+	// box that their centers are in.
+	std::vector<Body *> bodies;
+	double radiusSum = 0.;
+	Point boundsMin;
+	Point boundsMax;
+	double maxRadius = 0.;
+	// The box that the objects themselves cover, as of the last Finish().
+	Point extentMin;
+	Point extentMax;
+	Stats stats;
 	
 	// The current game engine step.
 	int step;
@@ -81,8 +215,17 @@ private:
 	std::vector<Entry> sorted;
 	// After Finish(), counts[index] is where a certain bin begins.
 	std::vector<unsigned> counts;
+	// The objects that are in the lookup table as of the last Finish(), and the
+	// differences from them that Update() has found.
+	std::vector<Entry> previous;
+	std::vector<Entry> removed;
+	std::vector<Entry> inserted;
+	
+	// The coarser grids, and how many objects they hold as of the last Finish().
+	std::vector<Level> levels;
+	size_t largeCount = 0;
 	
-	// Vector for returning the result of a circle query.
+	// Vector for returning the result of a circle or region query.
 	mutable std::vector<Body *> result;
 };
 
@@ -337,6 +337,22 @@ void Command::SetAim(int index, double amount)
 
 
 
+// Get or set the key commands, which along with the turn amount are all the
+// input that the player gives.
+uint32_t Command::Keys() const
+{
+	return state & 0xFFFFFFFFull;
+}
+
+
+
+void Command::SetKeys(uint32_t keys)
+{
+	state = (state & 0xFFFFFFFF00000000ull) | keys;
+}
+
+
+
 // Check if any bits are set in this command (including a nonzero turn).
 Command::operator bool() const
 {
@@ -121,6 +121,12 @@ public:
 	double Aim(int index) const;
 	void SetAim(int index, double amount);
 	
+	// Get or set the key commands, which along with the turn amount are all
+	// the input that the player gives, e.g. so it can be recorded and replayed.
+	// This does not include the weapons to fire or the turret turn rates.
+	uint32_t Keys() const;
+	void SetKeys(uint32_t keys);
+	
 	// Check if any bits are set in this command (including a nonzero turn).
 	explicit operator bool() const;
 	bool operator!() const;
@@ -0,0 +1,414 @@
+/* CompressedImage.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "CompressedImage.h"
+
+#include "Files.h"
+#include "ImageBuffer.h"
+#include "Mask.h"
+#include "Point.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	// This must be changed whenever the format of the file changes, so that an
+	// old file will be ignored instead of being misread.
+	const char SIGNATURE[] = "Endless Sky compressed sprite 1\n";
+	const size_t SIGNATURE_SIZE = sizeof(SIGNATURE) - 1;
+	
+	// Each block holds 4x4 pixels, in 16 bytes: the alpha values, and then the
+	// colors in the same format as DXT1.
+	const size_t BLOCK_SIZE = 16;
+	
+	// The files are written for whatever machine will be using them, so values
+	// are stored in little-endian byte order.
+	template <class Type>
+	void WriteValue(string &out, Type value)
+	{
+		for(size_t i = 0; i < sizeof(value); ++i)
+			out += static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+	}
+	
+	template <class Type>
+	bool ReadValue(const char *&it, const char *end, Type &value)
+	{
+		if(static_cast<size_t>(end - it) < sizeof(value))
+			return false;
+		uint64_t result = 0;
+		for(size_t i = 0; i < sizeof(value); ++i)
+			result |= static_cast<uint64_t>(static_cast<unsigned char>(*it++)) << (8 * i);
+		value = static_cast<Type>(result);
+		return true;
+	}
+	
+	// Convert between 8-bit color channels and the 5:6:5 format of a block's
+	// two endpoint colors.
+	uint16_t To565(const int color[3])
+	{
+		return ((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255);
+	}
+	
+	void From565(uint16_t value, int color[3])
+	{
+		int red = (value >> 11) & 31;
+		int green = (value >> 5) & 63;
+		int blue = value & 31;
+		color[0] = (red << 3) | (red >> 2);
+		color[1] = (green << 2) | (green >> 4);
+		color[2] = (blue << 3) | (blue >> 2);
+	}
+	
+	// Get the four colors that a block's color indices refer to.
+	void Palette(uint16_t first, uint16_t second, int palette[4][3])
+	{
+		From565(first, palette[0]);
+		From565(second, palette[1]);
+		for(int i = 0; i < 3; ++i)
+		{
+			palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+			palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+		}
+	}
+	
+	// Get the eight alpha values that a block's alpha indices refer to.
+	void AlphaLevels(int first, int second, int levels[8])
+	{
+		levels[0] = first;
+		levels[1] = second;
+		if(first > second)
+			for(int i = 2; i < 8; ++i)
+				levels[i] = ((8 - i) * first + (i - 1) * second) / 7;
+		else
+		{
+			for(int i = 2; i < 6; ++i)
+				levels[i] = ((6 - i) * first + (i - 1) * second) / 5;
+			levels[6] = 0;
+			levels[7] = 255;
+		}
+	}
+	
+	// Compress a block of 16 pixels, using the range of values that they span
+	// as the endpoints. This is not the highest quality compression possible,
+	// but it is fast, and sprites have few enough sharp color changes that the
+	// difference is hard to see.
+	void EncodeBlock(const uint32_t pixels[16], unsigned char *out)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		int minColor[3] = {255, 255, 255};
+		int maxColor[3] = {0, 0, 0};
+		for(int i = 0; i < 16; ++i)
+		{
+			minAlpha = min<int>(minAlpha, pixels[i] >> 24);
+			maxAlpha = max<int>(maxAlpha, pixels[i] >> 24);
+			for(int c = 0; c < 3; ++c)
+			{
+				int value = (pixels[i] >> (16 - 8 * c)) & 0xFF;
+				minColor[c] = min(minColor[c], value);
+				maxColor[c] = max(maxColor[c], value);
+			}
+		}
+		
+		// The alpha endpoints are the maximum and minimum alpha, and each pixel
+		// gets whichever of the levels in between them is closest.
+		out[0] = maxAlpha;
+		out[1] = minAlpha;
+		uint64_t alphaBits = 0;
+		if(maxAlpha > minAlpha)
+		{
+			int range = maxAlpha - minAlpha;
+			for(int i = 0; i < 16; ++i)
+			{
+				// Find how many sevenths of the way this is from max to min.
+				int step = ((maxAlpha - static_cast<int>(pixels[i] >> 24)) * 7 + range / 2) / range;
+				uint64_t index = (step == 0) ? 0 : (step == 7) ? 1 : step + 1;
+				alphaBits |= index << (3 * i);
+			}
+		}
+		for(int i = 0; i < 6; ++i)
+			out[2 + i] = static_cast<unsigned char>(alphaBits >> (8 * i));
+		
+		// Move the color endpoints in slightly, so that the rounding to 5:6:5
+		// does not make them overshoot.
+		for(int c = 0; c < 3; ++c)
+		{
+			int inset = (maxColor[c] - minColor[c]) / 16;
+			maxColor[c] -= inset;
+			minColor[c] += inset;
+		}
+		uint16_t first = To565(maxColor);
+		uint16_t second = To565(minColor);
+		if(first < second)
+			swap(first, second);
+		out[8] = first & 0xFF;
+		out[9] = first >> 8;
+		out[10] = second & 0xFF;
+		out[11] = second >> 8;
+		
+		uint32_t colorBits = 0;
+		if(first != second)
+		{
+			int palette[4][3];
+			Palette(first, second, palette);
+			for(int i = 0; i < 16; ++i)
+			{
+				int best = 0;
+				int bestDistance = 0;
+				for(int j = 0; j < 4; ++j)
+				{
+					int distance = 0;
+					for(int c = 0; c < 3; ++c)
+					{
+						int d = static_cast<int>((pixels[i] >> (16 - 8 * c)) & 0xFF) - palette[j][c];
+						distance += d * d;
+					}
+					if(!j || distance < bestDistance)
+					{
+						best = j;
+						bestDistance = distance;
+					}
+				}
+				colorBits |= static_cast<uint32_t>(best) << (2 * i);
+			}
+		}
+		for(int i = 0; i < 4; ++i)
+			out[12 + i] = static_cast<unsigned char>(colorBits >> (8 * i));
+	}
+	
+	// Decode one block into 16 pixels.
+	void DecodeBlock(const unsigned char *in, uint32_t pixels[16])
+	{
+		int levels[8];
+		AlphaLevels(in[0], in[1], levels);
+		uint64_t alphaBits = 0;
+		for(int i = 0; i < 6; ++i)
+			alphaBits |= static_cast<uint64_t>(in[2 + i]) << (8 * i);
+		
+		int palette[4][3];
+		Palette(in[8] | (in[9] << 8), in[10] | (in[11] << 8), palette);
+		uint32_t colorBits = in[12] | (in[13] << 8) | (in[14] << 16) | (static_cast<uint32_t>(in[15]) << 24);
+		
+		for(int i = 0; i < 16; ++i)
+		{
+			const int *color = palette[(colorBits >> (2 * i)) & 3];
+			uint32_t alpha = levels[(alphaBits >> (3 * i)) & 7];
+			pixels[i] = (alpha << 24) | (color[0] << 16) | (color[1] << 8) | color[2];
+		}
+	}
+}
+
+
+
+// Read a file holding the compressed 1x and 2x frames of a sprite, and its
+// collision masks. This returns false if the file is not valid.
+bool CompressedImage::ReadFile(const string &path, CompressedImage images[2], vector<Mask> &masks)
+{
+	return ReadData(Files::Read(path), images, masks);
+}
+
+
+
+// Parse the contents of a file holding the compressed frames of a sprite and
+// its collision masks, which have already been read into memory.
+bool CompressedImage::ReadData(const string &file, CompressedImage images[2], vector<Mask> &masks)
+{
+	if(file.compare(0, SIGNATURE_SIZE, SIGNATURE))
+		return false;
+	
+	const char *it = file.data() + SIGNATURE_SIZE;
+	const char *end = file.data() + file.length();
+	for(int i = 0; i < 2; ++i)
+	{
+		CompressedImage &image = images[i];
+		uint64_t size = 0;
+		if(!ReadValue(it, end, image.width) || !ReadValue(it, end, image.height)
+				|| !ReadValue(it, end, image.frames) || !ReadValue(it, end, size))
+			return false;
+		
+		// Make sure the amount of data is right for the image's dimensions.
+		size_t blocks = ((image.width + 3) / 4) * ((image.height + 3) / 4);
+		if(image.width < 0 || image.height < 0 || image.frames < 0
+				|| size != blocks * BLOCK_SIZE * image.frames || static_cast<uint64_t>(end - it) < size)
+			return false;
+		image.data.assign(it, size);
+		it += size;
+	}
+	
+	uint32_t count = 0;
+	if(!ReadValue(it, end, count) || count > static_cast<size_t>(end - it))
+		return false;
+	masks.resize(count);
+	vector<Point> points;
+	for(Mask &mask : masks)
+	{
+		uint32_t size = 0;
+		if(!ReadValue(it, end, size) || size > static_cast<size_t>(end - it) / (2 * sizeof(double)))
+			return false;
+		
+		points.resize(size);
+		for(Point &point : points)
+		{
+			uint64_t x = 0;
+			uint64_t y = 0;
+			ReadValue(it, end, x);
+			ReadValue(it, end, y);
+			double values[2];
+			memcpy(&values[0], &x, sizeof(double));
+			memcpy(&values[1], &y, sizeof(double));
+			point = Point(values[0], values[1]);
+		}
+		mask.Create(points);
+	}
+	return true;
+}
+
+
+
+// Write a file holding the compressed 1x and 2x frames of a sprite, and its
+// collision masks.
+void CompressedImage::WriteFile(const string &path, const CompressedImage images[2], const vector<Mask> &masks)
+{
+	string out(SIGNATURE, SIGNATURE_SIZE);
+	for(int i = 0; i < 2; ++i)
+	{
+		const CompressedImage &image = images[i];
+		WriteValue(out, image.width);
+		WriteValue(out, image.height);
+		WriteValue(out, image.frames);
+		WriteValue<uint64_t>(out, image.data.size());
+		out += image.data;
+	}
+	
+	WriteValue<uint32_t>(out, masks.size());
+	for(const Mask &mask : masks)
+	{
+		WriteValue<uint32_t>(out, mask.Points().size());
+		for(const Point &point : mask.Points())
+		{
+			double values[2] = {point.X(), point.Y()};
+			uint64_t x = 0;
+			uint64_t y = 0;
+			memcpy(&x, &values[0], sizeof(double));
+			memcpy(&y, &values[1], sizeof(double));
+			WriteValue(out, x);
+			WriteValue(out, y);
+		}
+	}
+	Files::Write(path, out);
+}
+
+
+
+// Compress all the frames of the given image, which must already have been
+// converted to premultiplied alpha.
+void CompressedImage::Compress(const ImageBuffer &buffer)
+{
+	Clear();
+	if(!buffer.Pixels())
+		return;
+	
+	width = buffer.Width();
+	height = buffer.Height();
+	frames = buffer.Frames();
+	int columns = (width + 3) / 4;
+	int rows = (height + 3) / 4;
+	data.resize(columns * rows * BLOCK_SIZE * frames);
+	
+	unsigned char *out = reinterpret_cast<unsigned char *>(&data[0]);
+	uint32_t pixels[16];
+	for(int frame = 0; frame < frames; ++frame)
+		for(int by = 0; by < rows; ++by)
+			for(int bx = 0; bx < columns; ++bx, out += BLOCK_SIZE)
+			{
+				// If the image's size is not a multiple of 4, repeat the pixels
+				// along the right and bottom edges to fill out the blocks.
+				for(int y = 0; y < 4; ++y)
+				{
+					const uint32_t *row = buffer.Begin(min(4 * by + y, height - 1), frame);
+					for(int x = 0; x < 4; ++x)
+						pixels[4 * y + x] = row[min(4 * bx + x, width - 1)];
+				}
+				EncodeBlock(pixels, out);
+			}
+}
+
+
+
+// Decode the frames into the given buffer, for graphics cards that do not
+// support drawing from this format directly.
+void CompressedImage::Decompress(ImageBuffer &buffer) const
+{
+	buffer.Clear(frames);
+	buffer.Allocate(width, height);
+	if(!buffer.Pixels())
+		return;
+	
+	int columns = (width + 3) / 4;
+	int rows = (height + 3) / 4;
+	const unsigned char *in = reinterpret_cast<const unsigned char *>(data.data());
+	uint32_t pixels[16];
+	for(int frame = 0; frame < frames; ++frame)
+		for(int by = 0; by < rows; ++by)
+			for(int bx = 0; bx < columns; ++bx, in += BLOCK_SIZE)
+			{
+				DecodeBlock(in, pixels);
+				for(int y = 0; y < 4 && 4 * by + y < height; ++y)
+				{
+					uint32_t *row = buffer.Begin(4 * by + y, frame);
+					for(int x = 0; x < 4 && 4 * bx + x < width; ++x)
+						row[4 * bx + x] = pixels[4 * y + x];
+				}
+			}
+}
+
+
+
+void CompressedImage::Clear()
+{
+	width = 0;
+	height = 0;
+	frames = 0;
+	string().swap(data);
+}
+
+
+
+int CompressedImage::Width() const
+{
+	return width;
+}
+
+
+
+int CompressedImage::Height() const
+{
+	return height;
+}
+
+
+
+int CompressedImage::Frames() const
+{
+	return frames;
+}
+
+
+
+// Get the compressed blocks, with each frame stored after the one before.
+const string &CompressedImage::Data() const
+{
+	return data;
+}
@@ -0,0 +1,65 @@
+/* CompressedImage.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef COMPRESSED_IMAGE_H_
+#define COMPRESSED_IMAGE_H_
+
+#include <string>
+#include <vector>
+
+class ImageBuffer;
+class Mask;
+
+
+
+// Class representing the frames of a sprite in the DXT5 (also called BC3) block
+// compression format, which graphics cards can draw from directly. Each 4x4 block
+// of pixels takes up 16 bytes, a quarter of the size of the decoded image, so a
+// compressed sprite uses less video memory and can be uploaded without decoding
+// any PNG or JPEG files. The images are compressed ahead of time, by running the
+// game with "--compress-images", and saved in a file along with their masks.
+class CompressedImage {
+public:
+	// Read or write a file holding the compressed 1x and 2x frames of a sprite,
+	// and its collision masks. Reading returns false if the file is not valid.
+	static bool ReadFile(const std::string &path, CompressedImage images[2], std::vector<Mask> &masks);
+	static void WriteFile(const std::string &path, const CompressedImage images[2], const std::vector<Mask> &masks);
+	// Parse the contents of such a file, which have already been read.
+	static bool ReadData(const std::string &file, CompressedImage images[2], std::vector<Mask> &masks);
+	
+	
+public:
+	// Compress all the frames of the given image, which must already have been
+	// converted to premultiplied alpha.
+	void Compress(const ImageBuffer &buffer);
+	// Decode the frames into the given buffer, for graphics cards that do not
+	// support drawing from this format directly.
+	void Decompress(ImageBuffer &buffer) const;
+	void Clear();
+	
+	int Width() const;
+	int Height() const;
+	int Frames() const;
+	// Get the compressed blocks, with each frame stored after the one before.
+	const std::string &Data() const;
+	
+	
+private:
+	int width = 0;
+	int height = 0;
+	int frames = 0;
+	std::string data;
+};
+
+
+
+#endif
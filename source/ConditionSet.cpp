@@ -147,33 +147,6 @@ namespace {
 		return false;
 	}
 	
-	// Converts the given vector of condition tokens (like "reputation: Republic",
-	// "random", or "4") into the integral values they have at runtime.
-	vector<int64_t> SubstituteValues(const vector<string> &side, const map<string, int64_t> &conditions, const map<string, int64_t> &created)
-	{
-		auto result = vector<int64_t>();
-		result.reserve(side.size());
-		for(const string &str : side)
-		{
-			int64_t value = 0;
-			if(str == "random")
-				value = Random::Int(100);
-			else if(DataNode::IsNumber(str))
-				value = static_cast<int64_t>(DataNode::Value(str));
-			else
-			{
-				const auto temp = created.find(str);
-				const auto perm = conditions.find(str);
-				if(temp != created.end())
-					value = temp->second;
-				else if(perm != conditions.end())
-					value = perm->second;
-			}
-			result.emplace_back(value);
-		}
-		return result;
-	}
-	
 	bool UsedAll(const vector<bool> &status)
 	{
 		for(auto v : status)
@@ -573,6 +546,7 @@ ConditionSet::Expression::SubExpression::SubExpression(const vector<string> &sid
 	
 	ParseSide(side);
 	GenerateSequence();
+	ParseOperands();
 }
 
 
@@ -582,6 +556,7 @@ ConditionSet::Expression::SubExpression::SubExpression(const vector<string> &sid
 ConditionSet::Expression::SubExpression::SubExpression(const string &side)
 {
 	tokens.emplace_back(side.empty() ? "'" : side);
+	ParseOperands();
 }
 
 
@@ -649,16 +624,18 @@ int64_t ConditionSet::Expression::SubExpression::Evaluate(const Conditions &cond
 		return 0;
 	
 	// For SubExpressions with no Operations (i.e. simple conditions), tokens will consist
-	// of only the condition or numeric value to be returned as-is after substitution.
-	auto data = SubstituteValues(tokens, conditions, created);
+	// of only the condition or numeric value to be returned as-is.
+	if(sequence.empty())
+		return Value(tokens.size() - 1, conditions, created);
 	
-	if(!sequence.empty())
-	{
-		// Each Operation adds to the end of the data vector.
-		data.reserve(operatorCount + data.size());
-		for(const Operation &op : sequence)
-			data.emplace_back(op.fun(data[op.a], data[op.b]));
-	}
+	// Substitute in the value of each token, then perform each Operation, which
+	// adds its result to the end of the data vector.
+	vector<int64_t> data;
+	data.reserve(tokens.size() + operatorCount);
+	for(size_t i = 0; i < tokens.size(); ++i)
+		data.emplace_back(Value(i, conditions, created));
+	for(const Operation &op : sequence)
+		data.emplace_back(op.fun(data[op.a], data[op.b]));
 	
 	return data.back();
 }
@@ -815,6 +792,49 @@ bool ConditionSet::Expression::SubExpression::AddOperation(vector<int> &data, si
 
 
 
+// Figure out what kind of value each token represents: a number, the "random"
+// token, or a condition (including the empty tokens left by parentheses).
+void ConditionSet::Expression::SubExpression::ParseOperands()
+{
+	operands.clear();
+	operands.resize(tokens.size());
+	for(size_t i = 0; i < tokens.size(); ++i)
+	{
+		Operand &operand = operands[i];
+		if(tokens[i] == "random")
+			operand.isRandom = true;
+		else if(DataNode::IsNumber(tokens[i]))
+		{
+			operand.isNumber = true;
+			operand.value = static_cast<int64_t>(DataNode::Value(tokens[i]));
+		}
+	}
+}
+
+
+
+// Get the current value of the token with the given index. Temporary conditions
+// created by this set's own assignments take precedence over the given ones.
+int64_t ConditionSet::Expression::SubExpression::Value(size_t index, const Conditions &conditions, const Conditions &created) const
+{
+	const Operand &operand = operands[index];
+	if(operand.isRandom)
+		return Random::Int(100);
+	if(operand.isNumber)
+		return operand.value;
+	
+	if(!created.empty())
+	{
+		auto it = created.find(tokens[index]);
+		if(it != created.end())
+			return it->second;
+	}
+	auto it = conditions.find(tokens[index]);
+	return (it == conditions.end() ? 0 : it->second);
+}
+
+
+
 // Constructor for an Operation, indicating the binary function and the
 // indices of its operands within the evaluation-time data vector.
 ConditionSet::Expression::SubExpression::Operation::Operation(const string &op, size_t &a, size_t &b)
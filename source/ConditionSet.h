@@ -117,6 +117,10 @@ private:
 			void ParseSide(const std::vector<std::string> &side);
 			void GenerateSequence();
 			bool AddOperation(std::vector<int> &data, size_t &index, const size_t &opIndex);
+			// Figure out what kind of value each token represents.
+			void ParseOperands();
+			// Get the current value of the token with the given index.
+			int64_t Value(size_t index, const Conditions &conditions, const Conditions &created) const;
 			
 			
 		private:
@@ -131,12 +135,23 @@ private:
 				size_t b;
 			};
 			
+			// Each token is a number, the special "random" token, or the name of
+			// a condition. This is only worked out once, when the expression is
+			// loaded, instead of every time that it is evaluated.
+			class Operand {
+			public:
+				bool isNumber = false;
+				bool isRandom = false;
+				int64_t value = 0;
+			};
+			
 			
 		private:
 			// Iteration of the sequence vector yields the result.
 			std::vector<Operation> sequence;
 			// The tokens vector converts into a data vector of numeric values during evaluation.
 			std::vector<std::string> tokens;
+			std::vector<Operand> operands;
 			std::vector<std::string> operators;
 			// The number of true (non-parentheses) operators.
 			int operatorCount = 0;
@@ -115,9 +115,16 @@ void ConversationPanel::Draw()
 	Point point(
 		Screen::Left() + MARGIN,
 		Screen::Top() + MARGIN + scroll);
-	// Draw all the conversation text up to this point.
+	// Draw all the conversation text up to this point. In a long conversation,
+	// most of it has scrolled off the screen and can just be skipped over.
 	for(const Paragraph &it : text)
-		point = it.Draw(point, grey);
+	{
+		int height = it.Height();
+		if(point.Y() + height < Screen::Top() || point.Y() > Screen::Bottom())
+			point.Y() += height;
+		else
+			point = it.Draw(point, grey);
+	}
 	
 	// Draw whatever choices are being presented.
 	if(node < 0)
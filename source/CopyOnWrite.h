@@ -0,0 +1,82 @@
+/* CopyOnWrite.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef COPY_ON_WRITE_H_
+#define COPY_ON_WRITE_H_
+
+#include <memory>
+
+
+
+// Wrapper for a value that is expensive to copy, but that most copies never
+// modify, such as the outfits and attributes of a ship that is created from one
+// of the ship models. Copying the wrapper just shares the value; it is only
+// copied for real the first time that one of the objects sharing it asks for a
+// version that it can modify.
+template <class Type>
+class CopyOnWrite {
+public:
+	CopyOnWrite();
+	// Copies share the value. There is no move constructor, so that an object
+	// that is moved from is never left without a value.
+	CopyOnWrite(const CopyOnWrite &other) = default;
+	CopyOnWrite &operator=(const CopyOnWrite &other) = default;
+	
+	const Type &operator*() const;
+	const Type *operator->() const;
+	
+	// Get a version of the value that can be modified, copying it first if any
+	// other object is sharing it.
+	Type &Mutable();
+	
+	
+private:
+	std::shared_ptr<Type> value;
+};
+
+
+
+template <class Type>
+CopyOnWrite<Type>::CopyOnWrite()
+	: value(std::make_shared<Type>())
+{
+}
+
+
+
+template <class Type>
+const Type &CopyOnWrite<Type>::operator*() const
+{
+	return *value;
+}
+
+
+
+template <class Type>
+const Type *CopyOnWrite<Type>::operator->() const
+{
+	return value.get();
+}
+
+
+
+template <class Type>
+Type &CopyOnWrite<Type>::Mutable()
+{
+	if(value.use_count() > 1)
+		value = std::make_shared<Type>(*value);
+	return *value;
+}
+
+
+
+#endif
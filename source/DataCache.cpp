@@ -0,0 +1,235 @@
+/* DataCache.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "DataCache.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Files.h"
+#include "Threads.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// This must be changed whenever the format of the cache changes, so that an
+	// old cache will be ignored instead of being misread.
+	const char SIGNATURE[] = "Endless Sky data cache 1\n";
+	const size_t SIGNATURE_SIZE = sizeof(SIGNATURE) - 1;
+	
+	// The cache is only ever read on the machine that wrote it, so values are
+	// just stored in whatever byte order that machine uses.
+	template <class Type>
+	void WriteValue(string &out, Type value)
+	{
+		out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	template <class Type>
+	bool ReadValue(const char *&it, const char *end, Type &value)
+	{
+		if(static_cast<size_t>(end - it) < sizeof(value))
+			return false;
+		memcpy(&value, it, sizeof(value));
+		it += sizeof(value);
+		return true;
+	}
+	
+	void WriteString(string &out, const string &value)
+	{
+		WriteValue<uint32_t>(out, value.length());
+		out += value;
+	}
+	
+	bool ReadString(const char *&it, const char *end, string &value)
+	{
+		uint32_t length = 0;
+		if(!ReadValue(it, end, length) || static_cast<size_t>(end - it) < length)
+			return false;
+		value.assign(it, length);
+		it += length;
+		return true;
+	}
+	
+	// A file is assumed not to have changed if its time stamp and size are both
+	// the same as when it was cached.
+	pair<int64_t, int64_t> Stamp(const string &path)
+	{
+		return make_pair(static_cast<int64_t>(Files::Timestamp(path)), static_cast<int64_t>(Files::Size(path)));
+	}
+	
+	// Call the given function for each index in [0, count), using as many
+	// threads as there are cores. Each file can be handled without depending on
+	// any of the others, so the threads just claim them one at a time.
+	void InParallel(size_t count, const function<void(size_t)> &function)
+	{
+		atomic<size_t> next(0);
+		auto work = [count, &function, &next]()
+		{
+			for(size_t i = next++; i < count; i = next++)
+				function(i);
+		};
+		
+		int cores = max(1, Threads::Workers(static_cast<int>(thread::hardware_concurrency())));
+		vector<thread> threads(min<size_t>(count, cores) - 1);
+		for(thread &t : threads)
+			t = thread(work);
+		work();
+		for(thread &t : threads)
+			t.join();
+	}
+}
+
+
+
+// Get the parsed contents of each of the given files, in the same order,
+// using the cache file at the given path if it exists.
+vector<DataFile> DataCache::Load(const vector<string> &paths, const string &cachePath)
+{
+	TRACE_SCOPE("DataCache::Load");
+	vector<pair<int64_t, int64_t>> stamps;
+	map<string, size_t> index;
+	for(const string &path : paths)
+	{
+		index[path] = stamps.size();
+		stamps.push_back(Stamp(path));
+	}
+	
+	// Find out which of the files are in the cache and have not changed since
+	// it was written, and where in the cache each one's nodes are stored.
+	string cache = Files::Read(cachePath);
+	vector<pair<const char *, const char *>> cached(paths.size(), make_pair(nullptr, nullptr));
+	size_t found = 0;
+	uint32_t count = 0;
+	if(!cache.compare(0, SIGNATURE_SIZE, SIGNATURE))
+	{
+		const char *it = cache.data() + SIGNATURE_SIZE;
+		const char *end = cache.data() + cache.length();
+		ReadValue(it, end, count);
+		
+		string path;
+		pair<int64_t, int64_t> stamp;
+		uint64_t length = 0;
+		for(uint32_t i = 0; i < count; ++i)
+		{
+			if(!ReadString(it, end, path) || !ReadValue(it, end, stamp.first)
+					|| !ReadValue(it, end, stamp.second) || !ReadValue(it, end, length)
+					|| static_cast<uint64_t>(end - it) < length)
+				break;
+			
+			auto match = index.find(path);
+			if(match != index.end() && stamps[match->second] == stamp)
+			{
+				cached[match->second] = make_pair(it, it + length);
+				++found;
+			}
+			it += length;
+		}
+	}
+	
+	// Restore each cached file, and parse any that were not cached or whose
+	// cached nodes turn out not to be valid.
+	vector<DataFile> files(paths.size());
+	atomic<size_t> parsed(0);
+	InParallel(paths.size(), [&paths, &cached, &files, &parsed](size_t i)
+	{
+		const char *it = cached[i].first;
+		if(it && Read(files[i].root, it, cached[i].second) && it == cached[i].second)
+		{
+			files[i].CountBytes();
+			return;
+		}
+		
+		files[i] = DataFile();
+		files[i].Load(paths[i]);
+		++parsed;
+	});
+	
+	// Rewrite the cache if anything was parsed or if any of the files that it
+	// holds are no longer in use.
+	if(parsed || found != count)
+	{
+		string out(SIGNATURE, SIGNATURE_SIZE);
+		WriteValue<uint32_t>(out, paths.size());
+		string nodes;
+		for(size_t i = 0; i < paths.size(); ++i)
+		{
+			nodes.clear();
+			Write(files[i].root, nodes);
+			
+			WriteString(out, paths[i]);
+			WriteValue(out, stamps[i].first);
+			WriteValue(out, stamps[i].second);
+			WriteValue<uint64_t>(out, nodes.length());
+			out += nodes;
+		}
+		Files::Write(cachePath, out);
+	}
+	
+	return files;
+}
+
+
+
+// Append the given node and all its children to the given buffer.
+void DataCache::Write(const DataNode &node, string &out)
+{
+	WriteValue<uint32_t>(out, node.lineNumber);
+	WriteValue<uint32_t>(out, node.tokens.size());
+	for(const string &token : node.tokens)
+		WriteString(out, token);
+	WriteValue<uint32_t>(out, node.children.size());
+	for(const DataNode &child : node.children)
+		Write(child, out);
+}
+
+
+
+// Read a node written by Write(). This returns false if the data is not
+// valid, in which case the node may be only partly filled in.
+bool DataCache::Read(DataNode &node, const char *&it, const char *end)
+{
+	uint32_t lineNumber = 0;
+	uint32_t count = 0;
+	if(!ReadValue(it, end, lineNumber) || !ReadValue(it, end, count))
+		return false;
+	// Every token takes up at least as many bytes as its length does, so a count
+	// larger than that must be garbage and should not be used to allocate memory.
+	if(count > static_cast<size_t>(end - it) / sizeof(uint32_t))
+		return false;
+	
+	node.lineNumber = lineNumber;
+	node.tokens.resize(count);
+	for(string &token : node.tokens)
+		if(!ReadString(it, end, token))
+			return false;
+	node.ParseValues();
+	
+	if(!ReadValue(it, end, count))
+		return false;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		node.children.emplace_back(&node);
+		if(!Read(node.children.back(), it, end))
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,46 @@
+/* DataCache.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef DATA_CACHE_H_
+#define DATA_CACHE_H_
+
+#include <string>
+#include <vector>
+
+class DataFile;
+class DataNode;
+
+
+
+// Class for loading a list of data files, keeping a binary copy of their parsed
+// nodes on disk so that the next time the game starts, any file whose time stamp
+// and size have not changed can be restored without parsing its text again. Any
+// files that have changed (or that are not in the cache yet) are parsed in
+// parallel, and then the cache is rewritten to include them.
+class DataCache {
+public:
+	// Get the parsed contents of each of the given files, in the same order,
+	// using the cache file at the given path if it exists.
+	static std::vector<DataFile> Load(const std::vector<std::string> &paths, const std::string &cachePath);
+	
+	
+private:
+	// Append the given node and all its children to the given buffer.
+	static void Write(const DataNode &node, std::string &out);
+	// Read a node written by Write(). This returns false if the data is not
+	// valid, in which case the node may be only partly filled in.
+	static bool Read(DataNode &node, const char *&it, const char *end);
+};
+
+
+
+#endif
@@ -12,10 +12,25 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "DataFile.h"
 
-#include "Files.h"
+#include "MappedFile.h"
+#include "MemoryUsage.h"
+
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+namespace {
+	// Get the memory used by the given node and all its children.
+	size_t Bytes(const DataNode &node)
+	{
+		size_t bytes = sizeof(DataNode) + node.Size() * (sizeof(string) + sizeof(double));
+		for(const DataNode &child : node)
+			bytes += Bytes(child);
+		return bytes;
+	}
+}
+
 
 
 // Constructor, taking a file path (in UTF-8).
@@ -34,22 +49,55 @@ DataFile::DataFile(istream &in)
 
 
 
+DataFile::DataFile(DataFile &&other)
+	: root(std::move(other.root)), bytes(other.bytes)
+{
+	other.bytes = 0;
+}
+
+
+
+DataFile &DataFile::operator=(DataFile &&other)
+{
+	MemoryUsage::Add(MemoryUsage::DATA, -static_cast<int64_t>(bytes));
+	root = std::move(other.root);
+	bytes = other.bytes;
+	other.bytes = 0;
+	return *this;
+}
+
+
+
+DataFile::~DataFile()
+{
+	MemoryUsage::Add(MemoryUsage::DATA, -static_cast<int64_t>(bytes));
+}
+
+
+
 // Load from a file path (in UTF-8).
 void DataFile::Load(const string &path)
 {
-	string data = Files::Read(path);
-	if(data.empty())
+	MappedFile file(path);
+	if(!file.Size())
 		return;
 	
-	// As a sentinel, make sure the file always ends in a newline.
-	if(data.empty() || data.back() != '\n')
-		data.push_back('\n');
-	
 	// Note what file this node is in, so it will show up in error traces.
 	root.tokens.push_back("file");
 	root.tokens.push_back(path);
+	root.ParseValues();
 	
-	Load(&*data.begin(), &*data.end());
+	// As a sentinel, the text must end in a newline. Nearly every file does, so
+	// it can be parsed straight from the mapped file without copying it.
+	const char *data = file.Data();
+	if(data[file.Size() - 1] == '\n')
+		Load(data, data + file.Size());
+	else
+	{
+		string copy(data, file.Size());
+		copy.push_back('\n');
+		Load(copy.data(), copy.data() + copy.size());
+	}
 }
 
 
@@ -92,6 +140,21 @@ list<DataNode>::const_iterator DataFile::end() const
 
 
 
+// Get iterators that allow the nodes to be moved out of this file.
+list<DataNode>::iterator DataFile::begin()
+{
+	return root.begin();
+}
+
+
+
+list<DataNode>::iterator DataFile::end()
+{
+	return root.end();
+}
+
+
+
 // Parse the given text.
 void DataFile::Load(const char *it, const char *end)
 {
@@ -103,6 +166,10 @@ void DataFile::Load(const char *it, const char *end)
 	bool fileIsSpaces = false;
 	bool warned = false;
 	size_t lineNumber = 0;
+	// The start and end of each token in the current line. The tokens are found
+	// first and then copied all at once, so that each node's token list only
+	// needs to be allocated once instead of growing one token at a time.
+	vector<pair<const char *, const char *>> ranges;
 	
 	for( ; it != end; ++it)
 	{
@@ -161,6 +228,8 @@ void DataFile::Load(const char *it, const char *end)
 		whiteStack.push_back(white);
 		
 		// Tokenize the line. Skip comments and empty lines.
+		ranges.clear();
+		bool missingQuote = false;
 		while(*it != '\n')
 		{
 			// Check if this token begins with a quotation mark. If so, it will
@@ -175,16 +244,8 @@ void DataFile::Load(const char *it, const char *end)
 			while(*it != '\n' && (isQuoted ? (*it != endQuote) : (*it > ' ')))
 				++it;
 			
-			// It ought to be legal to construct a string from an empty iterator
-			// range, but it appears that some libraries do not handle that case
-			// correctly. So:
-			if(start == it)
-				node.tokens.emplace_back();
-			else
-				node.tokens.emplace_back(start, it);
-			// This is not a fatal error, but it may indicate a format mistake:
-			if(isQuoted && *it == '\n')
-				node.PrintTrace("Closing quotation mark is missing:");
+			ranges.emplace_back(start, it);
+			missingQuote |= (isQuoted && *it == '\n');
 			
 			if(*it != '\n')
 			{
@@ -203,5 +264,32 @@ void DataFile::Load(const char *it, const char *end)
 				}
 			}
 		}
+		
+		node.tokens.reserve(ranges.size());
+		for(const pair<const char *, const char *> &range : ranges)
+		{
+			// It ought to be legal to construct a string from an empty iterator
+			// range, but it appears that some libraries do not handle that case
+			// correctly. So:
+			if(range.first == range.second)
+				node.tokens.emplace_back();
+			else
+				node.tokens.emplace_back(range.first, range.second);
+		}
+		node.ParseValues();
+		// This is not a fatal error, but it may indicate a format mistake:
+		if(missingQuote)
+			node.PrintTrace("Closing quotation mark is missing:");
 	}
+	CountBytes();
+}
+
+
+
+// Add the memory used by the nodes to the memory usage totals.
+void DataFile::CountBytes()
+{
+	size_t total = Bytes(root);
+	MemoryUsage::Add(MemoryUsage::DATA, static_cast<int64_t>(total) - static_cast<int64_t>(bytes));
+	bytes = total;
 }
@@ -33,22 +33,38 @@ public:
 	DataFile() = default;
 	explicit DataFile(const std::string &path);
 	explicit DataFile(std::istream &in);
+	// The memory taken up by the nodes is counted for as long as they exist,
+	// so a DataFile can be moved but not copied.
+	DataFile(DataFile &&other);
+	DataFile &operator=(DataFile &&other);
+	~DataFile();
 	
 	void Load(const std::string &path);
 	void Load(std::istream &in);
+	// Parse the given text, which must end in a newline.
+	void Load(const char *it, const char *end);
 	
 	// Functions for iterating through all DataNodes in this file.
 	std::list<DataNode>::const_iterator begin() const;
 	std::list<DataNode>::const_iterator end() const;
+	// Nodes that should outlive the file can be moved out of it through these.
+	std::list<DataNode>::iterator begin();
+	std::list<DataNode>::iterator end();
 	
 	
 private:
-	void Load(const char *it, const char *end);
+	// Add the memory used by the nodes to the memory usage totals.
+	void CountBytes();
 	
 	
 private:
 	// This is the container for all DataNodes in this file.
 	DataNode root;
+	// How many bytes of memory the nodes are using.
+	size_t bytes = 0;
+	
+	// Allow DataCache to restore the nodes without parsing them.
+	friend class DataCache;
 };
 
 
@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <limits>
 
 using namespace std;
 
@@ -36,24 +37,46 @@ DataNode::DataNode(const DataNode *parent)
 
 // Copy constructor.
 DataNode::DataNode(const DataNode &other)
-	: children(other.children), tokens(other.tokens)
+	: children(other.children), tokens(other.tokens), values(other.values)
 {
 	Reparent();
 }
 
 
 
+// Move constructor.
+DataNode::DataNode(DataNode &&other) noexcept
+	: children(std::move(other.children)), tokens(std::move(other.tokens)), values(std::move(other.values))
+{
+	AdoptChildren();
+}
+
+
+
 // Assignment operator.
 DataNode &DataNode::operator=(const DataNode &other)
 {
 	children = other.children;
 	tokens = other.tokens;
+	values = other.values;
 	Reparent();
 	return *this;
 }
 
 
 
+// Move assignment operator.
+DataNode &DataNode::operator=(DataNode &&other) noexcept
+{
+	children = std::move(other.children);
+	tokens = std::move(other.tokens);
+	values = std::move(other.values);
+	AdoptChildren();
+	return *this;
+}
+
+
+
 // Get the number of tokens in this line of the data file.
 int DataNode::Size() const
 {
@@ -84,10 +107,10 @@ double DataNode::Value(int index) const
 	// Check for empty strings and out-of-bounds indices.
 	if(static_cast<size_t>(index) >= tokens.size() || tokens[index].empty())
 		PrintTrace("Requested token index (" + to_string(index) + ") is out of bounds:");
-	else if(!IsNumber(tokens[index]))
+	else if(std::isnan(values[index]))
 		PrintTrace("Cannot convert value \"" + tokens[index] + "\" to a number:");
 	else
-		return Value(tokens[index]);
+		return values[index];
 	
 	return 0.;
 }
@@ -103,45 +126,7 @@ double DataNode::Value(const string &token)
 		Files::LogError("Cannot convert value \"" + token + "\" to a number.");
 		return 0.;
 	}
-	const char *it = token.c_str();
-	
-	// Check for leading sign.
-	double sign = (*it == '-') ? -1. : 1.;
-	it += (*it == '-' || *it == '+');
-	
-	// Digits before the decimal point.
-	int64_t value = 0;
-	while(*it >= '0' && *it <= '9')
-		value = (value * 10) + (*it++ - '0');
-	
-	// Digits after the decimal point (if any).
-	int64_t power = 0;
-	if(*it == '.')
-	{
-		++it;
-		while(*it >= '0' && *it <= '9')
-		{
-			value = (value * 10) + (*it++ - '0');
-			--power;
-		}
-	}
-	
-	// Exponent.
-	if(*it == 'e' || *it == 'E')
-	{
-		++it;
-		int64_t sign = (*it == '-') ? -1 : 1;
-		it += (*it == '-' || *it == '+');
-		
-		int64_t exponent = 0;
-		while(*it >= '0' && *it <= '9')
-			exponent = (exponent * 10) + (*it++ - '0');
-		
-		power += sign * exponent;
-	}
-	
-	// Compose the return value.
-	return copysign(value * pow(10., power), sign);
+	return Parse(token);
 }
 
 
@@ -154,7 +139,7 @@ bool DataNode::IsNumber(int index) const
 	if(static_cast<size_t>(index) >= tokens.size() || tokens[index].empty())
 		return false;
 	
-	return IsNumber(tokens[index]);
+	return !std::isnan(values[index]);
 }
 
 
@@ -197,6 +182,64 @@ bool DataNode::IsNumber(const string &token)
 
 
 
+// Parse any tokens that are numbers, once the tokens have been filled in. Most
+// numbers are looked up at least once and many are checked with IsNumber()
+// first, so it is cheaper to convert them all up front.
+void DataNode::ParseValues()
+{
+	values.resize(tokens.size());
+	for(size_t i = 0; i < tokens.size(); ++i)
+		values[i] = (!tokens[i].empty() && IsNumber(tokens[i])) ? Parse(tokens[i]) : numeric_limits<double>::quiet_NaN();
+}
+
+
+
+// Convert a token to a number, assuming it has already been checked.
+double DataNode::Parse(const string &token)
+{
+	const char *it = token.c_str();
+	
+	// Check for leading sign.
+	double sign = (*it == '-') ? -1. : 1.;
+	it += (*it == '-' || *it == '+');
+	
+	// Digits before the decimal point.
+	int64_t value = 0;
+	while(*it >= '0' && *it <= '9')
+		value = (value * 10) + (*it++ - '0');
+	
+	// Digits after the decimal point (if any).
+	int64_t power = 0;
+	if(*it == '.')
+	{
+		++it;
+		while(*it >= '0' && *it <= '9')
+		{
+			value = (value * 10) + (*it++ - '0');
+			--power;
+		}
+	}
+	
+	// Exponent.
+	if(*it == 'e' || *it == 'E')
+	{
+		++it;
+		int64_t sign = (*it == '-') ? -1 : 1;
+		it += (*it == '-' || *it == '+');
+		
+		int64_t exponent = 0;
+		while(*it >= '0' && *it <= '9')
+			exponent = (exponent * 10) + (*it++ - '0');
+		
+		power += sign * exponent;
+	}
+	
+	// Compose the return value.
+	return copysign(value * pow(10., power), sign);
+}
+
+
+
 // Check if this node has any children.
 bool DataNode::HasChildren() const
 {
@@ -221,6 +264,21 @@ list<DataNode>::const_iterator DataNode::end() const
 
 
 
+// Iterators through the children that allow them to be moved out.
+list<DataNode>::iterator DataNode::begin()
+{
+	return children.begin();
+}
+
+
+
+list<DataNode>::iterator DataNode::end()
+{
+	return children.end();
+}
+
+
+
 // Print a message followed by a "trace" of this node and its parents.
 int DataNode::PrintTrace(const string &message) const
 {
@@ -271,3 +329,13 @@ void DataNode::Reparent()
 		child.Reparent();
 	}
 }
+
+
+
+// Adjust the parent pointers of just this node's children, when it has been
+// moved. The nodes below them have not moved.
+void DataNode::AdoptChildren() noexcept
+{
+	for(DataNode &child : children)
+		child.parent = this;
+}
@@ -32,8 +32,11 @@ public:
 	explicit DataNode(const DataNode *parent = nullptr);
 	// Copy constructor.
 	DataNode(const DataNode &other);
+	// Moving a node does not copy any of its children, so it is much cheaper.
+	DataNode(DataNode &&other) noexcept;
 	
 	DataNode &operator=(const DataNode &other);
+	DataNode &operator=(DataNode &&other) noexcept;
 	
 	// Get the number of tokens in this node.
 	int Size() const;
@@ -55,6 +58,10 @@ public:
 	bool HasChildren() const;
 	std::list<DataNode>::const_iterator begin() const;
 	std::list<DataNode>::const_iterator end() const;
+	// Children that are not needed here any more may be moved out instead of
+	// copied, e.g. when keeping part of a file that is about to be discarded.
+	std::list<DataNode>::iterator begin();
+	std::list<DataNode>::iterator end();
 	
 	// Print a message followed by a "trace" of this node and its parents.
 	int PrintTrace(const std::string &message = "") const;
@@ -63,6 +70,13 @@ public:
 private:
 	// Adjust the parent pointers when a copy is made of a DataNode.
 	void Reparent();
+	// Adjust the parent pointers of just this node's children, when it has been
+	// moved. The nodes below them have not moved.
+	void AdoptChildren() noexcept;
+	// Parse any tokens that are numbers, once the tokens have been filled in.
+	void ParseValues();
+	// Convert a token to a number, assuming it has already been checked.
+	static double Parse(const std::string &token);
 	
 	
 private:
@@ -70,6 +84,8 @@ private:
 	std::list<DataNode> children;
 	// These are the tokens found in this particular line of the data file.
 	std::vector<std::string> tokens;
+	// The numeric value of each token, or NaN if that token is not a number.
+	std::vector<double> values;
 	// The parent pointer is used only for printing stack traces.
 	const DataNode *parent = nullptr;
 	// The line number in the given file that produced this node.
@@ -77,6 +93,8 @@ private:
 	
 	// Allow DataFile to modify the internal structure of DataNodes.
 	friend class DataFile;
+	// DataCache saves and restores that structure directly.
+	friend class DataCache;
 };
 
 
@@ -15,8 +15,15 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 #include "Files.h"
 
+#include <cstdio>
+
 using namespace std;
 
+namespace {
+	// Once this much output has been composed, it is written to the file.
+	const size_t BUFFER_SIZE = 1 << 16;
+}
+
 
 
 // This string constant is just used for remembering what string needs to be
@@ -27,17 +34,26 @@ const string DataWriter::space = " ";
 
 // Constructor, specifying the file to save.
 DataWriter::DataWriter(const string &path)
-	: path(path), before(&indent)
+	: file(path, true), before(&indent)
 {
-	out.precision(8);
+	out.reserve(BUFFER_SIZE + BUFFER_SIZE / 4);
 }
 
 
 
-// Destructor, which saves the file all in one block.
+// Constructor for a writer that does not save to a file.
+DataWriter::DataWriter()
+	: before(&indent)
+{
+}
+
+
+
+// Destructor, which writes out anything that is still in the buffer.
 DataWriter::~DataWriter()
 {
-	Files::Write(path, out.str());
+	if(file)
+		Files::Write(file, out);
 }
 
 
@@ -67,8 +83,9 @@ void DataWriter::Write(const DataNode &node)
 // Begin a new line of the file.
 void DataWriter::Write()
 {
-	out << '\n';
+	out += '\n';
 	before = &indent;
+	Flush();
 }
 
 
@@ -92,7 +109,20 @@ void DataWriter::EndChild()
 // Write a comment line, at the current indentation level.
 void DataWriter::WriteComment(const string &str)
 {
-	out << indent << "# " << str << '\n';
+	out += indent;
+	out += "# ";
+	out += str;
+	out += '\n';
+	Flush();
+}
+
+
+
+// Write text that is already in this format, without indenting it.
+void DataWriter::WriteRaw(const string &text)
+{
+	out += text;
+	Flush();
 }
 
 
@@ -110,13 +140,13 @@ void DataWriter::WriteToken(const char *a)
 	}
 	
 	// Write the token, enclosed in quotes if necessary.
-	out << *before;
-	if(hasSpace && hasQuote)
-		out << '`' << a << '`';
-	else if(hasSpace)
-		out << '"' << a << '"';
-	else
-		out << a;
+	char quote = (hasSpace && hasQuote) ? '`' : '"';
+	out += *before;
+	if(hasSpace)
+		out += quote;
+	out += a;
+	if(hasSpace)
+		out += quote;
 	
 	// The next token written will not be the first one on this line, so it only
 	// needs to have a single space before it.
@@ -130,3 +160,67 @@ void DataWriter::WriteToken(const string &a)
 {
 	WriteToken(a.c_str());
 }
+
+
+
+// Get everything that has been written so far, if this writer is not writing
+// to a file.
+const string &DataWriter::GetString() const
+{
+	return out;
+}
+
+
+
+// Write a floating point number with up to 8 significant digits.
+void DataWriter::WriteNumber(double value)
+{
+	char buffer[32];
+	int length = snprintf(buffer, sizeof(buffer), "%.8g", value);
+	if(length > 0)
+		out.append(buffer, length);
+}
+
+
+
+// Write a signed integer.
+void DataWriter::WriteNumber(long long value)
+{
+	// Negate the value as an unsigned number, so that the most negative value
+	// does not overflow.
+	if(value < 0)
+	{
+		out += '-';
+		WriteNumber(0ull - static_cast<unsigned long long>(value));
+	}
+	else
+		WriteNumber(static_cast<unsigned long long>(value));
+}
+
+
+
+// Write an unsigned integer.
+void DataWriter::WriteNumber(unsigned long long value)
+{
+	// Fill in the digits from right to left.
+	char buffer[24];
+	char *end = buffer + sizeof(buffer);
+	char *it = end;
+	do {
+		*--it = '0' + value % 10;
+		value /= 10;
+	} while(value);
+	out.append(it, end);
+}
+
+
+
+// If the output has grown past the buffer size, write it to the file.
+void DataWriter::Flush()
+{
+	if(file && out.size() >= BUFFER_SIZE)
+	{
+		Files::Write(file, out);
+		out.clear();
+	}
+}
@@ -13,8 +13,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DATA_WRITER_H_
 #define DATA_WRITER_H_
 
-#include <sstream>
+#include "File.h"
+
 #include <string>
+#include <type_traits>
 
 class DataNode;
 
@@ -27,10 +29,13 @@ class DataNode;
 // automatically adds quotation marks around strings if they contain whitespace.
 class DataWriter {
 public:
-	// Constructor, specifying the file to write.
+	// Constructor, specifying the file to write. The output is buffered, and
+	// written to the file in large chunks as the buffer fills up.
 	explicit DataWriter(const std::string &path);
-	// The file is not actually saved until the destructor is called. This makes
-	// it possible to write the whole file in a single chunk.
+	// Constructor for a writer that only composes the data in memory, so that
+	// it can be retrieved with GetString() and saved somewhere else.
+	DataWriter();
+	// Write whatever is left in the buffer to the file.
 	~DataWriter();
 	
 	// The Write() function can take any number of arguments. Each argument is
@@ -52,6 +57,9 @@ public:
 	// Write a comment. It will be at the current indentation level, and will
 	// have "# " inserted before it.
 	void WriteComment(const std::string &str);
+	// Write text that is already in this format, such as the output of another
+	// DataWriter. It is copied as is, so it must not need to be indented.
+	void WriteRaw(const std::string &text);
 	
 	// Write a token, without writing a whole line. Use this very carefully.
 	void WriteToken(const char *a);
@@ -60,10 +68,23 @@ public:
 	template <class A>
 	void WriteToken(const A &a);
 	
+	// Get everything that has been written so far, if this writer is not
+	// writing to a file.
+	const std::string &GetString() const;
+	
+	
+private:
+	// Convert a number to text and add it to the output.
+	void WriteNumber(double value);
+	void WriteNumber(long long value);
+	void WriteNumber(unsigned long long value);
+	// If the output has grown past the buffer size, write it to the file.
+	void Flush();
+	
 	
 private:
-	// Save path (in UTF-8).
-	std::string path;
+	// The file being written, if any.
+	File file;
 	// Current indentation level.
 	std::string indent;
 	// Before writing each token, we will write either the indentation string
@@ -72,8 +93,9 @@ private:
 	// Remember which string should be written before the next token. This is
 	// "indent" for the first token in a line and "space" for subsequent tokens.
 	const std::string *before;
-	// Compose the output in memory before writing it to file.
-	std::ostringstream out;
+	// Output that has not been written to the file yet. If there is no file,
+	// this is everything that has been written.
+	std::string out;
 };
 
 
@@ -96,7 +118,15 @@ void DataWriter::WriteToken(const A &a)
 	static_assert(std::is_arithmetic<A>::value,
 		"DataWriter cannot output anything but strings and arithmetic types.");
 	
-	out << *before << a;
+	out += *before;
+	if(std::is_floating_point<A>::value)
+		WriteNumber(static_cast<double>(a));
+	else if(std::is_same<A, char>::value)
+		out += static_cast<char>(a);
+	else if(std::is_signed<A>::value)
+		WriteNumber(static_cast<long long>(a));
+	else
+		WriteNumber(static_cast<unsigned long long>(a));
 	before = &space;
 }
 
@@ -31,6 +31,26 @@ namespace {
 	constexpr double DAILY_DEPRECIATION = 0.997;
 	constexpr int GRACE_PERIOD = 7;
 	constexpr int MAX_AGE = 1000 + GRACE_PERIOD;
+	
+	// Get the value fraction for every age from the end of the grace period up
+	// to the maximum age. A fleet's value is calculated every day, and it may
+	// have records for many different days, so the curve is only calculated
+	// once instead of once per record.
+	const vector<double> &DepreciationCurve()
+	{
+		static const vector<double> curve = []()
+		{
+			vector<double> result;
+			for(int age = GRACE_PERIOD; age <= MAX_AGE; ++age)
+			{
+				double daily = pow(DAILY_DEPRECIATION, age - GRACE_PERIOD);
+				double linear = static_cast<double>(MAX_AGE - age) / (MAX_AGE - GRACE_PERIOD);
+				result.push_back(FULL_DEPRECIATION + (1. - FULL_DEPRECIATION) * daily * linear);
+			}
+			return result;
+		}();
+		return curve;
+	}
 }
 
 
@@ -337,9 +357,7 @@ double Depreciation::Depreciate(int age) const
 	if(age >= MAX_AGE)
 		return FULL_DEPRECIATION;
 	
-	double daily = pow(DAILY_DEPRECIATION, age - GRACE_PERIOD);
-	double linear = static_cast<double>(MAX_AGE - age) / (MAX_AGE - GRACE_PERIOD);
-	return FULL_DEPRECIATION + (1. - FULL_DEPRECIATION) * daily * linear;
+	return DepreciationCurve()[age - GRACE_PERIOD];
 }
 
 
@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Dictionary.h"
 
+#include <cmath>
 #include <cstring>
 #include <mutex>
 #include <set>
@@ -44,6 +45,13 @@ namespace {
 		return make_pair(low, false);
 	}
 	
+	// Compare two keys. Every key in a dictionary is interned, so two keys that
+	// are the same string are usually the same pointer as well.
+	int Compare(const char *a, const char *b)
+	{
+		return (a == b) ? 0 : strcmp(a, b);
+	}
+	
 	// String interning: return a pointer to a character string that matches the
 	// given string but has static storage duration.
 	const char *Intern(const char *key)
@@ -89,3 +97,54 @@ double Dictionary::Get(const string &key) const
 {
 	return Get(key.c_str());
 }
+
+
+
+// Add the given multiple of each of the other dictionary's values to this one.
+void Dictionary::Add(const Dictionary &other, double scale, double epsilon)
+{
+	auto add = [scale, epsilon](double &value, double amount)
+	{
+		value += amount * scale;
+		if(fabs(value) < epsilon)
+			value = 0.;
+	};
+	
+	// Both dictionaries are sorted, so they can be merged in a single pass.
+	// Usually every key in the other dictionary is already in this one, and
+	// the values can just be added in place.
+	size_t missing = 0;
+	size_t i = 0;
+	for(const auto &it : other)
+	{
+		while(i < size() && Compare(data()[i].first, it.first) < 0)
+			++i;
+		if(i == size() || Compare(data()[i].first, it.first))
+			++missing;
+		else
+			add(data()[i].second, it.second);
+	}
+	if(!missing)
+		return;
+	
+	// Otherwise, make room for the missing keys at the end, and then merge
+	// backwards so that nothing has to be moved more than once. The keys in
+	// the other dictionary are already interned. Values for keys that were
+	// already in this one have been added above.
+	size_t from = size();
+	size_t to = from + missing;
+	resize(to);
+	for(size_t j = other.size(); j--; )
+	{
+		const auto &it = other.data()[j];
+		while(from && Compare(data()[from - 1].first, it.first) > 0)
+			data()[--to] = data()[--from];
+		if(from && !Compare(data()[from - 1].first, it.first))
+			data()[--to] = data()[--from];
+		else
+		{
+			data()[--to] = make_pair(it.first, 0.);
+			add(data()[to].second, it.second);
+		}
+	}
+}
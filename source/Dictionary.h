@@ -31,6 +31,10 @@ public:
 	// Get the value of a key, or 0 if it does not exist:
 	double Get(const char *key) const;
 	double Get(const std::string &key) const;
+	// Add the given multiple of each of the other dictionary's values to this
+	// one. Any value that this changes to within the given epsilon of zero is
+	// set to exactly zero.
+	void Add(const Dictionary &other, double scale, double epsilon = 0.);
 	
 	// Expose certain functions from the underlying vector:
 	using std::vector<std::pair<const char *, double>>::empty;
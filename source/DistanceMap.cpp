@@ -18,8 +18,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "StellarObject.h"
 #include "System.h"
 
+#include <algorithm>
+#include <mutex>
+
 using namespace std;
 
+namespace {
+	// Maps of hyperspace link distances from each system that has been asked
+	// about. Missions may be created from more than one thread, so the cache
+	// is protected by a mutex.
+	map<const System *, DistanceMap> cache;
+	mutex cacheMutex;
+}
+
 
 
 // Find paths to the given system. If the given maximum count is above zero,
@@ -76,7 +87,7 @@ DistanceMap::DistanceMap(const Ship &ship, const System *destination)
 // Find out if the given system is reachable.
 bool DistanceMap::HasRoute(const System *system) const
 {
-	return route.count(system);
+	return system && system->Index() < reached.size() && reached[system->Index()];
 }
 
 
@@ -84,8 +95,7 @@ bool DistanceMap::HasRoute(const System *system) const
 // Find out how many days away the given system is.
 int DistanceMap::Days(const System *system) const
 {
-	auto it = route.find(system);
-	return (it == route.end() ? -1 : it->second.days);
+	return HasRoute(system) ? route[system->Index()].days : -1;
 }
 
 
@@ -93,8 +103,7 @@ int DistanceMap::Days(const System *system) const
 // Starting in the given system, what is the next system along the route?
 const System *DistanceMap::Route(const System *system) const
 {
-	auto it = route.find(system);
-	return (it == route.end() ? nullptr : it->second.next);
+	return HasRoute(system) ? route[system->Index()].next : nullptr;
 }
 	
 	
@@ -102,10 +111,7 @@ const System *DistanceMap::Route(const System *system) const
 // Get a set containing all the systems.
 set<const System *> DistanceMap::Systems() const
 {
-	set<const System *> systems;
-	for(const auto &it : route)
-		systems.insert(it.first);
-	return systems;
+	return set<const System *>(systems.begin(), systems.end());
 }
 
 
@@ -120,11 +126,37 @@ const System *DistanceMap::End() const
 
 int DistanceMap::RequiredFuel(const System *system1, const System *system2) const
 {
-	auto it1 = route.find(system1);
-	auto it2 = route.find(system2);
-	if(it1 == route.end() || it2 == route.end())
+	if(!HasRoute(system1) || !HasRoute(system2))
+		return -1;
+	return abs(route[system1->Index()].fuel - route[system2->Index()].fuel);
+}
+
+
+
+// Get the number of jumps it takes to get from one system to another by
+// hyperspace links alone, or -1 if there is no such route. This is the same as
+// DistanceMap(from).Days(to), but once a map has been calculated for a given
+// starting system it is remembered, so this is fast to call often.
+int DistanceMap::Jumps(const System *from, const System *to)
+{
+	if(!from)
 		return -1;
-	return abs(it1->second.fuel - it2->second.fuel);
+	
+	lock_guard<mutex> lock(cacheMutex);
+	auto it = cache.find(from);
+	if(it == cache.end())
+		it = cache.emplace(from, DistanceMap(from)).first;
+	return it->second.Days(to);
+}
+
+
+
+// Forget all the remembered maps. This must be done whenever any change is made
+// to the systems or the links between them.
+void DistanceMap::ClearCache()
+{
+	lock_guard<mutex> lock(cacheMutex);
+	cache.clear();
 }
 
 
@@ -160,7 +192,9 @@ void DistanceMap::Init(const Ship *ship)
 	if(!center)
 		return;
 	
-	route[center] = Edge();
+	route.resize(System::Count());
+	reached.resize(System::Count());
+	Add(center, Edge());
 	if(!maxDistance)
 		return;
 	
@@ -196,11 +230,11 @@ void DistanceMap::Init(const Ship *ship)
 	// choose the one with the fewest jumps (i.e. using jump drive rather than
 	// hyperdrive). If multiple routes have the same fuel and the same number of
 	// jumps, break the tie by using how "dangerous" the route is.
-	edges.emplace(center);
 	while(maxCount && !edges.empty())
 	{
-		Edge top = edges.top();
-		edges.pop();
+		pop_heap(edges.begin(), edges.end());
+		Edge top = edges.back();
+		edges.pop_back();
 		
 		// Source is only defined when given a ship and a destination system.
 		// Once we have a route between them, stop searching for more routes.
@@ -247,6 +281,8 @@ void DistanceMap::Init(const Ship *ship)
 		if(jumpFuel && !Propagate(top, true))
 			break;
 	}
+	// Free the memory used by the search.
+	vector<Edge>().swap(edges);
 }
 
 
@@ -275,8 +311,7 @@ bool DistanceMap::Propagate(Edge edge, bool useJump)
 // Check if we already have a better path to the given system.
 bool DistanceMap::HasBetter(const System *to, const Edge &edge)
 {
-	auto it = route.find(to);
-	return (it != route.end() && !(it->second < edge));
+	return HasRoute(to) && !(route[to->Index()] < edge);
 }
 
 
@@ -286,10 +321,19 @@ void DistanceMap::Add(const System *to, Edge edge)
 {
 	// This is the best path we have found so far to this system, but it is
 	// conceivable that a better one will be found.
-	route[to] = edge;
+	size_t index = to->Index();
+	if(!reached[index])
+	{
+		reached[index] = true;
+		systems.push_back(to);
+	}
+	route[index] = edge;
 	edge.next = to;
 	if(maxDistance < 0 || edge.days < maxDistance)
-		edges.emplace(edge);
+	{
+		edges.push_back(edge);
+		push_heap(edges.begin(), edges.end());
+	}
 }
 
 
@@ -13,10 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef DISTANCE_MAP_H_
 #define DISTANCE_MAP_H_
 
-#include <map>
-#include <queue>
 #include <set>
-#include <utility>
+#include <vector>
 
 class PlayerInfo;
 class Ship;
@@ -58,6 +56,15 @@ public:
 	// How much fuel is needed to travel between two systems.
 	int RequiredFuel(const System *system1, const System *system2) const;
 	
+	// Get the number of jumps it takes to get from one system to another by
+	// hyperspace links alone, or -1 if there is no such route. This is the same
+	// as DistanceMap(from).Days(to), but once a map has been calculated for a
+	// given starting system it is remembered, so this is fast to call often.
+	static int Jumps(const System *from, const System *to);
+	// Forget all the remembered maps. This must be done whenever any change is
+	// made to the systems or the links between them.
+	static void ClearCache();
+	
 	
 private:
 	// For each system, track how much fuel it will take to get there, how many
@@ -96,10 +103,16 @@ private:
 	
 	
 private:
-	std::map<const System *, Edge> route;
+	// The best route to each system, indexed by System::Index(). The systems
+	// that have been reached are marked in the "reached" vector, and are also
+	// listed in the order in which they were reached.
+	std::vector<Edge> route;
+	std::vector<bool> reached;
+	std::vector<const System *> systems;
 	
-	// Variables only used during construction:
-	std::priority_queue<Edge> edges;
+	// Variables only used during construction. The edges to explore next are
+	// stored as a heap, ordered the same way a priority queue would be.
+	std::vector<Edge> edges;
 	const PlayerInfo *player = nullptr;
 	const System *source = nullptr;
 	const System *center = nullptr;
@@ -19,16 +19,23 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 #include "SpriteShader.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
 
+namespace {
+	// Only look this many batches back for one that an item can be added to.
+	const size_t MAX_LOOKBACK = 16;
+}
+
 
 
 // Clear the list.
 void DrawList::Clear(int step, double zoom)
 {
 	items.clear();
+	bounds.clear();
 	this->step = step;
 	this->zoom = zoom;
 	isHighDPI = (Screen::IsHighResolution() ? zoom > .5 : zoom > 1.);
@@ -44,6 +51,29 @@ void DrawList::SetCenter(const Point &center, const Point &centerVelocity)
 
 
 
+// Clear the list and give it the same view as the given one.
+void DrawList::Clear(const DrawList &view)
+{
+	items.clear();
+	bounds.clear();
+	step = view.step;
+	zoom = view.zoom;
+	isHighDPI = view.isHighDPI;
+	center = view.center;
+	centerVelocity = view.centerVelocity;
+}
+
+
+
+// Add all the items in the given list after the ones in this list.
+void DrawList::Append(const DrawList &other)
+{
+	items.insert(items.end(), other.items.begin(), other.items.end());
+	bounds.insert(bounds.end(), other.bounds.begin(), other.bounds.end());
+}
+
+
+
 // Add an object based on the Body class.
 bool DrawList::Add(const Body &body, double cloak)
 {
@@ -100,13 +130,54 @@ bool DrawList::AddSwizzled(const Body &body, int swizzle)
 // Draw all the items in this list.
 void DrawList::Draw() const
 {
-	SpriteShader::Bind();
+	// Each item can be moved back to the most recent batch that uses the same
+	// texture and swizzle, as long as it does not overlap anything in the
+	// batches that come after that one, because those will now be drawn after
+	// it instead of before it.
+	batches.clear();
+	batchOf.resize(items.size());
+	for(size_t i = 0; i < items.size(); ++i)
+	{
+		const SpriteShader::Item &item = items[i];
+		size_t target = batches.size();
+		size_t stop = batches.size() > MAX_LOOKBACK ? batches.size() - MAX_LOOKBACK : 0;
+		for(size_t b = batches.size(); b-- > stop; )
+		{
+			if(batches[b].texture == item.texture && batches[b].swizzle == item.swizzle)
+			{
+				target = b;
+				break;
+			}
+			if(batches[b].bounds.Overlaps(bounds[i]))
+				break;
+		}
+		
+		if(target == batches.size())
+			batches.push_back(Batch{item.texture, item.swizzle, bounds[i]});
+		else
+			batches[target].bounds.Add(bounds[i]);
+		batchOf[i] = target;
+	}
 	
-	bool withBlur = Preferences::Has("Render motion blur");
-	for(const SpriteShader::Item &item : items)
-		SpriteShader::Add(item, withBlur);
+	// Put the items in order by batch, keeping the order within each batch.
+	batchStart.assign(batches.size() + 1, 0);
+	for(size_t b : batchOf)
+		++batchStart[b + 1];
+	for(size_t b = 1; b < batchStart.size(); ++b)
+		batchStart[b] += batchStart[b - 1];
+	sorted.resize(items.size());
+	for(size_t i = 0; i < items.size(); ++i)
+		sorted[batchStart[batchOf[i]]++] = items[i];
 	
-	SpriteShader::Unbind();
+	SpriteShader::Draw(sorted, Preferences::Has(Preferences::RENDER_MOTION_BLUR));
+}
+
+
+
+// Get the number of items in this list.
+size_t DrawList::Size() const
+{
+	return items.size();
 }
 
 
@@ -177,4 +248,31 @@ void DrawList::Push(const Body &body, Point pos, Point blur, double cloak, doubl
 	item.swizzle = swizzle;
 	
 	items.push_back(item);
+	
+	// Remember what part of the screen this covers, including its blur.
+	Point size(
+		.5 * (fabs(uw.Y()) + fabs(uh.X()) + fabs(blur.X())),
+		.5 * (fabs(uw.X()) + fabs(uh.Y()) + fabs(blur.Y())));
+	Point topLeft = pos * zoom - size;
+	Point bottomRight = pos * zoom + size;
+	bounds.push_back(Box{
+		static_cast<float>(topLeft.X()), static_cast<float>(topLeft.Y()),
+		static_cast<float>(bottomRight.X()), static_cast<float>(bottomRight.Y())});
+}
+
+
+
+bool DrawList::Box::Overlaps(const Box &other) const
+{
+	return left < other.right && other.left < right && top < other.bottom && other.top < bottom;
+}
+
+
+
+void DrawList::Box::Add(const Box &other)
+{
+	left = min(left, other.left);
+	top = min(top, other.top);
+	right = max(right, other.right);
+	bottom = max(bottom, other.bottom);
 }
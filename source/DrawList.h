@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Point.h"
 #include "SpriteShader.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -34,6 +35,12 @@ public:
 	// Clear the list, also setting the global time step for animation.
 	void Clear(int step = 0, double zoom = 1.);
 	void SetCenter(const Point &center, const Point &centerVelocity = Point());
+	// Clear the list and give it the same step, zoom, and center as the given
+	// one, so that items can be added to it in another thread and then be
+	// appended to that list.
+	void Clear(const DrawList &view);
+	// Add all the items in the given list after the ones in this list.
+	void Append(const DrawList &other);
 	
 	// Add an object based on the Body class.
 	bool Add(const Body &body, double cloak = 0.);
@@ -44,8 +51,32 @@ public:
 	// Add an object using a specific swizzle (rather than its own).
 	bool AddSwizzled(const Body &body, int swizzle);
 	
-	// Draw all the items in this list.
+	// Draw all the items in this list. Items that share a texture are drawn
+	// together where that does not change which of them are drawn on top.
 	void Draw() const;
+	// Get the number of items in this list.
+	std::size_t Size() const;
+	
+	
+private:
+	// The area of the screen that an item, or a batch of items, covers.
+	class Box {
+	public:
+		bool Overlaps(const Box &other) const;
+		void Add(const Box &other);
+		
+		float left;
+		float top;
+		float right;
+		float bottom;
+	};
+	// A run of items that can all be drawn at once.
+	class Batch {
+	public:
+		uint32_t texture;
+		uint32_t swizzle;
+		Box bounds;
+	};
 	
 	
 private:
@@ -60,6 +91,13 @@ private:
 	double zoom = 1.;
 	bool isHighDPI = false;
 	std::vector<SpriteShader::Item> items;
+	std::vector<Box> bounds;
+	
+	// Buffers for sorting the items into batches when they are drawn.
+	mutable std::vector<Batch> batches;
+	mutable std::vector<std::size_t> batchOf;
+	mutable std::vector<std::size_t> batchStart;
+	mutable std::vector<SpriteShader::Item> sorted;
 	
 	Point center;
 	Point centerVelocity;
@@ -13,6 +13,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Engine.h"
 
 #include "Audio.h"
+#include "Checksum.h"
+#include "Color.h"
+#include "DataWriter.h"
 #include "Effect.h"
 #include "Files.h"
 #include "FillShader.h"
@@ -22,11 +25,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "FontSet.h"
 #include "Format.h"
 #include "FrameTimer.h"
+#include "GPUProfiler.h"
 #include "GameData.h"
 #include "Government.h"
 #include "Interface.h"
 #include "MapPanel.h"
 #include "Mask.h"
+#include "MemoryUsage.h"
 #include "Messages.h"
 #include "Minable.h"
 #include "Mission.h"
@@ -39,10 +44,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 #include "Politics.h"
 #include "Preferences.h"
+#include "Profiler.h"
 #include "Projectile.h"
 #include "Random.h"
 #include "RingShader.h"
 #include "Screen.h"
+#include "Set.h"
 #include "Ship.h"
 #include "ShipEvent.h"
 #include "Sprite.h"
@@ -52,6 +59,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "StartConditions.h"
 #include "StellarObject.h"
 #include "System.h"
+#include "Telemetry.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "Visual.h"
 #include "WrappedText.h"
 
@@ -62,6 +72,112 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
+	// The phases of the calculation step that are timed separately.
+	enum Phase : size_t {AI_STEP, SHIP_MOVE, ASTEROID_STEP, PROJECTILE_MOVE, SPAWNING,
+		COLLISION_FILL, COLLISIONS, SCANNING, RADAR_FILL, DRAW_LIST};
+	const vector<string> PHASE_NAMES = {"ai", "ships", "asteroids", "projectiles", "spawning",
+		"collision fill", "collisions", "scanning", "radar", "draw list"};
+	
+	// The passes of drawing a frame, which are timed on the graphics card.
+	enum Pass : size_t {BACKGROUND_PASS, OBJECT_PASS, EFFECT_PASS, INTERFACE_PASS, UPLOAD_PASS};
+	const vector<string> PASS_NAMES = {"background", "objects", "effects", "interface", "uploads"};
+	
+	// The jobs that are split between the worker threads draw their random
+	// numbers from streams keyed by what the job is, the step, and the index of
+	// the object, so the result does not depend on which thread does what.
+	enum RandomStream : uint64_t {MOVE_PROJECTILE = 1, MOVE_VISUAL, DRAW_SHIP, DRAW_PROJECTILE, DRAW_VISUAL};
+	const vector<string> RANDOM_STREAM_NAMES = {"", "move projectiles", "move visuals",
+		"draw ships", "draw projectiles", "draw visuals"};
+	
+	// Convert the name of a phase into one that can be sent as telemetry.
+	string TelemetryName(string name)
+	{
+		replace(name.begin(), name.end(), ' ', '_');
+		return name;
+	}
+	// How many frames to show in the frame time graph.
+	const size_t FRAME_HISTORY = 120;
+	
+	// An adaptive render scale tries to keep the time the graphics card spends
+	// on each frame near this many milliseconds, which leaves some room to spare
+	// at 60 frames per second. The scale is only changed once per this many
+	// frames, and never goes below the given minimum.
+	const double TARGET_GPU_TIME = 12.;
+	const int RENDER_SCALE_FRAMES = 30;
+	const double MIN_RENDER_SCALE = .5;
+	
+	// The interface and colors that are drawn in every frame.
+	const Set<Interface>::Ref HUD(GameData::Interfaces(), "hud");
+	const Set<Color>::Ref OVERLAY_COLORS[8] = {
+		{GameData::Colors(), "overlay friendly shields"},
+		{GameData::Colors(), "overlay hostile shields"},
+		{GameData::Colors(), "overlay outfit scan"},
+		{GameData::Colors(), "overlay friendly hull"},
+		{GameData::Colors(), "overlay hostile hull"},
+		{GameData::Colors(), "overlay cargo scan"},
+		{GameData::Colors(), "overlay friendly disabled"},
+		{GameData::Colors(), "overlay hostile disabled"}
+	};
+	const Set<Color>::Ref FLAGSHIP_HIGHLIGHT(GameData::Colors(), "flagship highlight");
+	const Set<Color>::Ref BRIGHT(GameData::Colors(), "bright");
+	const Set<Color>::Ref MEDIUM(GameData::Colors(), "medium");
+	const Set<Color>::Ref DIM(GameData::Colors(), "dim");
+	
+	// The names of the values that the HUD shows, looked up once.
+	const Information::Key CREDITS_KEY("credits");
+	const Information::Key DATE_KEY("date");
+	const Information::Key DESTINATION_KEY("destination");
+	const Information::Key DISABLED_HULL_KEY("disabled hull");
+	const Information::Key ENERGY_KEY("energy");
+	const Information::Key FUEL_KEY("fuel");
+	const Information::Key HEAT_KEY("heat");
+	const Information::Key HULL_KEY("hull");
+	const Information::Key LOCATION_KEY("location");
+	const Information::Key MISSION_TARGET_KEY("mission target");
+	const Information::Key NAVIGATION_MODE_KEY("navigation mode");
+	const Information::Key OVERHEAT_KEY("overheat");
+	const Information::Key OVERHEAT_BLINK_KEY("overheat blink");
+	const Information::Key PLAYER_SPRITE_KEY("player sprite");
+	const Information::Key RANGE_DISPLAY_KEY("range display");
+	const Information::Key SHIELDS_KEY("shields");
+	const Information::Key TACTICAL_DISPLAY_KEY("tactical display");
+	const Information::Key TARGET_CREW_KEY("target crew");
+	const Information::Key TARGET_DISABLED_HULL_KEY("target disabled hull");
+	const Information::Key TARGET_ENERGY_KEY("target energy");
+	const Information::Key TARGET_FUEL_KEY("target fuel");
+	const Information::Key TARGET_GOVERNMENT_KEY("target government");
+	const Information::Key TARGET_HEAT_KEY("target heat");
+	const Information::Key TARGET_HULL_KEY("target hull");
+	const Information::Key TARGET_NAME_KEY("target name");
+	const Information::Key TARGET_RANGE_KEY("target range");
+	const Information::Key TARGET_SHIELDS_KEY("target shields");
+	const Information::Key TARGET_SPRITE_KEY("target sprite");
+	const Information::Key TARGET_TYPE_KEY("target type");
+	
+	// Where to record the player's commands to, if anywhere.
+	string recordPath;
+	uint64_t recordSeed = 0;
+	// Where to write the checksum of each step to, if anywhere.
+	string checksumPath;
+	
+	// The anti-missile grid is made of square cells of this size, and wraps
+	// around after this many cells in each direction.
+	const int ANTI_MISSILE_SHIFT = 9;
+	const int ANTI_MISSILE_CELLS = 32;
+	
+	// Get the grid coordinate of the cell the given coordinate is in.
+	int AntiMissileCell(double coordinate)
+	{
+		return static_cast<int>(floor(coordinate * (1. / (1 << ANTI_MISSILE_SHIFT))));
+	}
+	
+	// Get the index of the grid cell with the given coordinates.
+	unsigned AntiMissileBin(int x, int y)
+	{
+		const int mask = ANTI_MISSILE_CELLS - 1;
+		return (x & mask) + (y & mask) * ANTI_MISSILE_CELLS;
+	}
+	
 	int RadarType(const Ship &ship, int step)
 	{
 		if(ship.GetPersonality().IsTarget() && !ship.IsDestroyed())
@@ -102,16 +218,21 @@ namespace {
 			objects.erase(out, objects.end());
 	}
 	
+	// Erase any of the given objects that should be removed. The rest are
+	// shifted down in place, so they stay in the same order.
 	template <class Type>
-	void Prune(list<shared_ptr<Type>> &objects)
+	void Prune(vector<shared_ptr<Type>> &objects)
 	{
-		for(auto it = objects.begin(); it != objects.end(); )
-		{
-			if((*it)->ShouldBeRemoved())
-				it = objects.erase(it);
-			else
-				++it;
-		}
+		objects.erase(remove_if(objects.begin(), objects.end(),
+			[](const shared_ptr<Type> &object) { return object->ShouldBeRemoved(); }),
+			objects.end());
+	}
+	
+	template <class Type>
+	void Append(vector<shared_ptr<Type>> &objects, list<shared_ptr<Type>> &added)
+	{
+		objects.insert(objects.end(), make_move_iterator(added.begin()), make_move_iterator(added.end()));
+		added.clear();
 	}
 	
 	template <class Type>
@@ -121,6 +242,24 @@ namespace {
 		added.clear();
 	}
 	
+	// Move the objects from the shared staging buffer and then from each of the
+	// per-chunk buffers onto the end of the given list. The buffers keep their
+	// capacity, so once they have grown to fit a typical step, staging new
+	// objects does not allocate. The list itself is grown at most once.
+	template <class Type>
+	void Append(vector<Type> &objects, vector<Type> &added, vector<vector<Type>> &staged)
+	{
+		size_t count = objects.size() + added.size();
+		for(const vector<Type> &buffer : staged)
+			count += buffer.size();
+		if(count > objects.capacity())
+			objects.reserve(max(count, 2 * objects.capacity()));
+		
+		Append(objects, added);
+		for(vector<Type> &buffer : staged)
+			Append(objects, buffer);
+	}
+	
 	bool CanSendHail(const shared_ptr<const Ship> &ship, const System *playerSystem)
 	{
 		if(!ship || !playerSystem)
@@ -165,12 +304,32 @@ namespace {
 
 
 Engine::Engine(PlayerInfo &player)
-	: player(player), ai(ships, asteroids.Minables(), flotsam),
-	shipCollisions(256u, 32u)
+	: player(player), ai(ships, asteroids.Minables(), shipCollisions, asteroids.MinableCollisions(), flotsamCollisions),
+	shipCollisions(256u, 32u), flotsamCollisions(256u, 32u), profiler(PHASE_NAMES), drawProfiler(PASS_NAMES),
+	frameTimes(FRAME_HISTORY, 0.), gpuTimes(FRAME_HISTORY, 0.)
 {
 	zoom = Preferences::ViewZoom();
+	chunkProjectiles.resize(workers.Chunks());
+	if(!recordPath.empty())
+	{
+		commandLog.reset(new DataWriter(recordPath));
+		commandLog->Write("seed", recordSeed);
+		recordPath.clear();
+	}
+	if(!checksumPath.empty())
+	{
+		checksumLog.reset(new DataWriter(checksumPath));
+		checksumPath.clear();
+	}
+	chunkVisuals.resize(workers.Chunks());
+	chunkDraws.resize(workers.Chunks());
+	chunkBatches.resize(workers.Chunks());
 	
-	// Start the thread for doing calculations.
+	// Start the thread for doing calculations. It carries on from a state drawn
+	// from this thread's random numbers, rather than whichever one it would be
+	// given by chance.
+	calcRandomState = static_cast<uint64_t>(Random::Int()) << 32;
+	calcRandomState |= Random::Int();
 	calcThread = thread(&Engine::ThreadEntryPoint, this);
 	
 	if(!player.IsLoaded() || !player.GetSystem())
@@ -202,7 +361,7 @@ Engine::Engine(PlayerInfo &player)
 	
 	// Add all neighboring systems to the radar.
 	const System *targetSystem = flagship ? flagship->GetTargetSystem() : nullptr;
-	const set<const System *> &links = (flagship && flagship->Attributes().Get("jump drive")) ?
+	const set<const System *> &links = (flagship && flagship->Attributes().Get(Outfit::JUMP_DRIVE)) ?
 		player.GetSystem()->Neighbors() : player.GetSystem()->Links();
 	for(const System *system : links)
 		radar[calcTickTock].AddPointer(
@@ -222,6 +381,7 @@ Engine::~Engine()
 	}
 	condition.notify_all();
 	calcThread.join();
+	FinishPreparingSystem();
 }
 
 
@@ -230,6 +390,11 @@ void Engine::Place()
 {
 	ships.clear();
 	ai.ClearOrders();
+	// Any system that was set up ahead of time is not this one.
+	FinishPreparingSystem();
+	preparedAsteroids.Clear();
+	preparedFleets.clear();
+	preparedSystem = nullptr;
 	
 	EnterSystem();
 	
@@ -305,7 +470,10 @@ void Engine::Place()
 	}
 	// Move any ships that were randomly spawned into the main list, now
 	// that all special ships have been repositioned.
-	ships.splice(ships.end(), newShips);
+	Append(ships, newShips);
+	// The AI looks up nearby ships in the collision set, so it must not refer
+	// to any of the ships that were just removed.
+	FillCollisionSets();
 	
 	player.SetPlanet(nullptr);
 }
@@ -319,8 +487,10 @@ void Engine::Place(const list<NPC> &npcs, shared_ptr<Ship> flagship)
 {
 	for(const NPC &npc : npcs)
 	{
-		map<Ship *, int> droneCarriers;
-		map<Ship *, int> fighterCarriers;
+		// The carriers are listed in the order of the NPC's ships rather than
+		// by address, so which fighters go in which bays is reproducible.
+		vector<pair<Ship *, int>> droneCarriers;
+		vector<pair<Ship *, int>> fighterCarriers;
 		for(const shared_ptr<Ship> &ship : npc.Ships())
 		{
 			// Skip ships that have been destroyed.
@@ -330,9 +500,9 @@ void Engine::Place(const list<NPC> &npcs, shared_ptr<Ship> flagship)
 			// Redo the loading up of fighters.
 			ship->UnloadBays();
 			if(ship->BaysFree(false))
-				droneCarriers[&*ship] = ship->BaysFree(false);
+				droneCarriers.emplace_back(&*ship, ship->BaysFree(false));
 			if(ship->BaysFree(true))
-				fighterCarriers[&*ship] = ship->BaysFree(true);
+				fighterCarriers.emplace_back(&*ship, ship->BaysFree(true));
 		}
 		
 		shared_ptr<Ship> npcFlagship;
@@ -351,7 +521,7 @@ void Engine::Place(const list<NPC> &npcs, shared_ptr<Ship> flagship)
 			if(ship->CanBeCarried())
 			{
 				bool docked = false;
-				map<Ship *, int> &carriers = (ship->Attributes().Category() == "Drone") ?
+				vector<pair<Ship *, int>> &carriers = (ship->Attributes().Category() == "Drone") ?
 					droneCarriers : fighterCarriers;
 				for(auto &it : carriers)
 					if(it.second && it.first->Carry(ship))
@@ -387,6 +557,7 @@ void Engine::Place(const list<NPC> &npcs, shared_ptr<Ship> flagship)
 // Wait for the previous calculations (if any) to be done.
 void Engine::Wait()
 {
+	TRACE_SCOPE("Engine::Wait");
 	unique_lock<mutex> lock(swapMutex);
 	while(calcTickTock != drawTickTock)
 		condition.wait(lock);
@@ -397,6 +568,7 @@ void Engine::Wait()
 // Begin the next step of calculations.
 void Engine::Step(bool isActive)
 {
+	TRACE_SCOPE("Engine::Step");
 	events.swap(eventQueue);
 	eventQueue.clear();
 	
@@ -433,7 +605,16 @@ void Engine::Step(bool isActive)
 			--jumpCount;
 	}
 	ai.UpdateEvents(events);
-	if(isActive)
+	if(!replayCommands.empty())
+	{
+		auto it = replayCommands.find(step);
+		if(it != replayCommands.end())
+		{
+			activeCommands |= it->second;
+			ai.UpdateKeys(player, activeCommands);
+		}
+	}
+	else if(isActive)
 	{
 		HandleKeyboardInputs();
 		// Ignore any inputs given when first becoming active, since those inputs
@@ -441,7 +622,24 @@ void Engine::Step(bool isActive)
 		if(!wasActive)
 			activeCommands.Clear();
 		else
+		{
+			if(commandLog)
+			{
+				// Record the system the player is flying in, followed by the
+				// commands in each step, counting from the first one.
+				if(recordStart < 0)
+				{
+					recordStart = step - 1;
+					if(player.GetSystem())
+						commandLog->Write("system", player.GetSystem()->Name());
+				}
+				if(activeCommands.Turn())
+					commandLog->Write("command", step - recordStart, activeCommands.Keys(), activeCommands.Turn());
+				else if(activeCommands.Keys())
+					commandLog->Write("command", step - recordStart, activeCommands.Keys());
+			}
 			ai.UpdateKeys(player, activeCommands);
+		}
 	}
 	wasActive = isActive;
 	Audio::Update(center);
@@ -467,7 +665,7 @@ void Engine::Step(bool isActive)
 	}
 	
 	// Draw a highlight to distinguish the flagship from other ships.
-	if(flagship && !flagship->IsDestroyed() && Preferences::Has("Highlight player's flagship"))
+	if(flagship && !flagship->IsDestroyed() && Preferences::Has(Preferences::HIGHLIGHT_FLAGSHIP))
 	{
 		highlightSprite = flagship->GetSprite();
 		highlightUnit = flagship->Unit() * zoom;
@@ -511,7 +709,7 @@ void Engine::Step(bool isActive)
 			else if(it.first->FiringFuel())
 			{
 				double remaining = flagship->Fuel()
-					* flagship->Attributes().Get("fuel capacity");
+					* flagship->Attributes().Get(Outfit::FUEL_CAPACITY);
 				ammo.emplace_back(it.first,
 					remaining / it.first->FiringFuel());
 			}
@@ -545,30 +743,15 @@ void Engine::Step(bool isActive)
 			escorts.Add(*escort, escort->GetSystem() == currentSystem, fleetIsJumping, isSelected);
 		}
 	
-	// Create the status overlays.
+	// The status overlays for all the ships were created by the calculation
+	// thread. Only the one for the current target's scan progress is added here.
 	statuses.clear();
-	if(isActive && Preferences::Has("Show status overlays"))
-		for(const auto &it : ships)
-		{
-			if(!it->GetGovernment() || it->GetSystem() != currentSystem || it->Cloaking() == 1.)
-				continue;
-			// Don't show status for dead ships.
-			if(it->IsDestroyed())
-				continue;
-			
-			bool isEnemy = it->GetGovernment()->IsEnemy();
-			if(isEnemy || it->IsYours() || it->GetPersonality().IsEscort())
-			{
-				double width = min(it->Width(), it->Height());
-				statuses.emplace_back(it->Position() - center, it->Shields(), it->Hull(),
-					min(it->Hull(), it->DisabledHull()), max(20., width * .5), isEnemy);
-			}
-		}
 	
 	// Create the planet labels.
 	labels.clear();
-	if(currentSystem && Preferences::Has("Show planet labels"))
+	if(currentSystem && Preferences::Has(Preferences::SHOW_PLANET_LABELS))
 	{
+		labelPlacements.Update(currentSystem, zoom);
 		for(const StellarObject &object : currentSystem->Objects())
 		{
 			if(!object.GetPlanet() || !object.GetPlanet()->IsAccessible(flagship.get()))
@@ -576,7 +759,7 @@ void Engine::Step(bool isActive)
 			
 			Point pos = object.Position() - center;
 			if(pos.Length() - object.Radius() < 600. / zoom)
-				labels.emplace_back(pos, object, currentSystem, zoom);
+				labels.emplace_back(pos, object, currentSystem, zoom, labelPlacements);
 		}
 	}
 	
@@ -584,36 +767,36 @@ void Engine::Step(bool isActive)
 		Messages::Add("Your ship has overheated.");
 	
 	// Clear the HUD information from the previous frame.
-	info = Information();
+	info.Clear();
 	if(flagship && flagship->Hull())
 	{
 		Point shipFacingUnit(0., -1.);
-		if(Preferences::Has("Rotate flagship in HUD"))
+		if(Preferences::Has(Preferences::ROTATE_FLAGSHIP_IN_HUD))
 			shipFacingUnit = flagship->Facing().Unit();
 		
-		info.SetSprite("player sprite", flagship->GetSprite(), shipFacingUnit, flagship->GetFrame(step));
+		info.SetSprite(PLAYER_SPRITE_KEY, flagship->GetSprite(), shipFacingUnit, flagship->GetFrame(step));
 	}
 	if(currentSystem)
-		info.SetString("location", currentSystem->Name());
-	info.SetString("date", player.GetDate().ToString());
+		info.SetString(LOCATION_KEY, currentSystem->Name());
+	info.SetString(DATE_KEY, player.GetDate().ToString());
 	if(flagship)
 	{
-		info.SetBar("fuel", flagship->Fuel(),
-			flagship->Attributes().Get("fuel capacity") * .01);
-		info.SetBar("energy", flagship->Energy());
+		info.SetBar(FUEL_KEY, flagship->Fuel(),
+			flagship->Attributes().Get(Outfit::FUEL_CAPACITY) * .01);
+		info.SetBar(ENERGY_KEY, flagship->Energy());
 		double heat = flagship->Heat();
-		info.SetBar("heat", min(1., heat));
+		info.SetBar(HEAT_KEY, min(1., heat));
 		// If heat is above 100%, draw a second overlaid bar to indicate the
 		// total heat level.
 		if(heat > 1.)
-			info.SetBar("overheat", min(1., heat - 1.));
+			info.SetBar(OVERHEAT_KEY, min(1., heat - 1.));
 		if(flagship->IsOverheated() && (step / 20) % 2)
-			info.SetBar("overheat blink", min(1., heat));
-		info.SetBar("shields", flagship->Shields());
-		info.SetBar("hull", flagship->Hull(), 20.);
-		info.SetBar("disabled hull", min(flagship->Hull(), flagship->DisabledHull()), 20.);
+			info.SetBar(OVERHEAT_BLINK_KEY, min(1., heat));
+		info.SetBar(SHIELDS_KEY, flagship->Shields());
+		info.SetBar(HULL_KEY, flagship->Hull(), 20.);
+		info.SetBar(DISABLED_HULL_KEY, min(flagship->Hull(), flagship->DisabledHull()), 20.);
 	}
-	info.SetString("credits",
+	info.SetString(CREDITS_KEY,
 		Format::Credits(player.Accounts().Credits()) + " credits");
 	bool isJumping = flagship && (flagship->Commands().Has(Command::JUMP) || flagship->IsEnteringHyperspace());
 	if(flagship && flagship->GetTargetStellar() && !isJumping)
@@ -622,9 +805,9 @@ void Engine::Step(bool isActive)
 		string navigationMode = flagship->Commands().Has(Command::LAND) ? "Landing on:" :
 			object->GetPlanet() && object->GetPlanet()->CanLand(*flagship) ? "Can land on:" :
 			"Cannot land on:";
-		info.SetString("navigation mode", navigationMode);
+		info.SetString(NAVIGATION_MODE_KEY, navigationMode);
 		const string &name = object->Name();
-		info.SetString("destination", name);
+		info.SetString(DESTINATION_KEY, name);
 		
 		targets.push_back({
 			object->Position() - center,
@@ -635,16 +818,16 @@ void Engine::Step(bool isActive)
 	}
 	else if(flagship && flagship->GetTargetSystem())
 	{
-		info.SetString("navigation mode", "Hyperspace:");
+		info.SetString(NAVIGATION_MODE_KEY, "Hyperspace:");
 		if(player.HasVisited(flagship->GetTargetSystem()))
-			info.SetString("destination", flagship->GetTargetSystem()->Name());
+			info.SetString(DESTINATION_KEY, flagship->GetTargetSystem()->Name());
 		else
-			info.SetString("destination", "unexplored system");
+			info.SetString(DESTINATION_KEY, "unexplored system");
 	}
 	else
 	{
-		info.SetString("navigation mode", "Navigation:");
-		info.SetString("destination", "no destination");
+		info.SetString(NAVIGATION_MODE_KEY, "Navigation:");
+		info.SetString(DESTINATION_KEY, "no destination");
 	}
 	// Use the radar that was just populated. (The draw tick-tock has not
 	// yet been toggled, but it will be at the end of this function.)
@@ -663,22 +846,22 @@ void Engine::Step(bool isActive)
 	if(!target)
 		targetSwizzle = -1;
 	if(!target && !targetAsteroid)
-		info.SetString("target name", "no target");
+		info.SetString(TARGET_NAME_KEY, "no target");
 	else if(!target)
 	{
-		info.SetSprite("target sprite",
+		info.SetSprite(TARGET_SPRITE_KEY,
 			targetAsteroid->GetSprite(),
 			targetAsteroid->Facing().Unit(),
 			targetAsteroid->GetFrame(step));
-		info.SetString("target name", Format::Capitalize(targetAsteroid->Name()) + " Asteroid");
+		info.SetString(TARGET_NAME_KEY, Format::Capitalize(targetAsteroid->Name()) + " Asteroid");
 		
 		targetVector = targetAsteroid->Position() - center;
 		
-		if(flagship->Attributes().Get("tactical scan power"))
+		if(flagship->TacticalScanRange())
 		{
-			info.SetCondition("range display");
+			info.SetCondition(RANGE_DISPLAY_KEY);
 			int targetRange = round(targetAsteroid->Position().Distance(flagship->Position()));
-			info.SetString("target range", to_string(targetRange));
+			info.SetString(TARGET_RANGE_KEY, to_string(targetRange));
 		}
 	}
 	else
@@ -686,23 +869,23 @@ void Engine::Step(bool isActive)
 		const Font &font = FontSet::Get(14);
 		if(target->GetSystem() == player.GetSystem() && target->Cloaking() < 1.)
 			targetUnit = target->Facing().Unit();
-		info.SetSprite("target sprite", target->GetSprite(), targetUnit, target->GetFrame(step));
-		info.SetString("target name", font.TruncateMiddle(target->Name(), 150));
-		info.SetString("target type", target->ModelName());
+		info.SetSprite(TARGET_SPRITE_KEY, target->GetSprite(), targetUnit, target->GetFrame(step));
+		info.SetString(TARGET_NAME_KEY, font.TruncateMiddle(target->Name(), 150));
+		info.SetString(TARGET_TYPE_KEY, target->ModelName());
 		if(!target->GetGovernment())
-			info.SetString("target government", "No Government");
+			info.SetString(TARGET_GOVERNMENT_KEY, "No Government");
 		else
-			info.SetString("target government", target->GetGovernment()->GetName());
+			info.SetString(TARGET_GOVERNMENT_KEY, target->GetGovernment()->GetName());
 		targetSwizzle = target->GetSwizzle();
-		info.SetString("mission target", target->GetPersonality().IsTarget() ? "(mission target)" : "");
+		info.SetString(MISSION_TARGET_KEY, target->GetPersonality().IsTarget() ? "(mission target)" : "");
 		
 		int targetType = RadarType(*target, step);
 		info.SetOutlineColor(Radar::GetColor(targetType));
 		if(target->GetSystem() == player.GetSystem() && target->IsTargetable())
 		{
-			info.SetBar("target shields", target->Shields());
-			info.SetBar("target hull", target->Hull(), 20.);
-			info.SetBar("target disabled hull", min(target->Hull(), target->DisabledHull()), 20.);
+			info.SetBar(TARGET_SHIELDS_KEY, target->Shields());
+			info.SetBar(TARGET_HULL_KEY, target->Hull(), 20.);
+			info.SetBar(TARGET_DISABLED_HULL_KEY, min(target->Hull(), target->DisabledHull()), 20.);
 		
 			// The target area will be a square, with sides proportional to the average
 			// of the width and the height of the sprite.
@@ -717,26 +900,26 @@ void Engine::Step(bool isActive)
 			targetVector = target->Position() - center;
 			
 			// Check if the target is close enough to show tactical information.
-			double tacticalRange = 100. * sqrt(flagship->Attributes().Get("tactical scan power"));
+			double tacticalRange = flagship->TacticalScanRange();
 			double targetRange = target->Position().Distance(flagship->Position());
 			if(tacticalRange)
 			{
-				info.SetCondition("range display");
-				info.SetString("target range", to_string(static_cast<int>(round(targetRange))));
+				info.SetCondition(RANGE_DISPLAY_KEY);
+				info.SetString(TARGET_RANGE_KEY, to_string(static_cast<int>(round(targetRange))));
 			}
 			// Actual tactical information requires a scrutable
 			// target that is within the tactical scanner range.
 			if((targetRange <= tacticalRange && !target->Attributes().Get("inscrutable"))
 					|| (tacticalRange && target->IsYours()))
 			{
-				info.SetCondition("tactical display");
-				info.SetString("target crew", to_string(target->Crew()));
-				int fuel = round(target->Fuel() * target->Attributes().Get("fuel capacity"));
-				info.SetString("target fuel", to_string(fuel));
-				int energy = round(target->Energy() * target->Attributes().Get("energy capacity"));
-				info.SetString("target energy", to_string(energy));
+				info.SetCondition(TACTICAL_DISPLAY_KEY);
+				info.SetString(TARGET_CREW_KEY, to_string(target->Crew()));
+				int fuel = round(target->Fuel() * target->Attributes().Get(Outfit::FUEL_CAPACITY));
+				info.SetString(TARGET_FUEL_KEY, to_string(fuel));
+				int energy = round(target->Energy() * target->Attributes().Get(Outfit::ENERGY_CAPACITY));
+				info.SetString(TARGET_ENERGY_KEY, to_string(energy));
 				int heat = round(100. * target->Heat());
-				info.SetString("target heat", to_string(heat) + "%");
+				info.SetString(TARGET_HEAT_KEY, to_string(heat) + "%");
 			}
 		}
 	}
@@ -797,23 +980,6 @@ void Engine::Step(bool isActive)
 				4});
 		}
 	}
-	
-	// Draw crosshairs on any minables in range of the flagship's scanners.
-	double scanRange = flagship ? 100. * sqrt(flagship->Attributes().Get("asteroid scan power")) : 0.;
-	if(flagship && scanRange && !flagship->IsHyperspacing())
-		for(const shared_ptr<Minable> &minable : asteroids.Minables())
-		{
-			Point offset = minable->Position() - center;
-			if(offset.Length() > scanRange)
-				continue;
-			
-			targets.push_back({
-				offset,
-				minable->Facing(),
-				.8 * minable->Radius(),
-				minable == flagship->GetTargetAsteroid() ? Radar::SPECIAL : Radar::INACTIVE,
-				3});
-		}
 }
 
 
@@ -821,6 +987,7 @@ void Engine::Step(bool isActive)
 // Begin the next step of calculations.
 void Engine::Go()
 {
+	TRACE_SCOPE("Engine::Go");
 	{
 		unique_lock<mutex> lock(swapMutex);
 		++step;
@@ -833,7 +1000,7 @@ void Engine::Go()
 
 // Pass the list of game events to MainPanel for handling by the player, and any
 // UI element generation.
-list<ShipEvent> &Engine::Events()
+vector<ShipEvent> &Engine::Events()
 {
 	return events;
 }
@@ -843,45 +1010,87 @@ list<ShipEvent> &Engine::Events()
 // Draw a frame.
 void Engine::Draw() const
 {
+	// Keep track of how long each frame took, and how much of that time the
+	// graphics card spent drawing the previous frames.
+	// An adaptive render scale also needs to know how long the graphics card is
+	// taking to draw each frame.
+	bool showLoad = Preferences::Has(Preferences::SHOW_LOAD);
+	bool isAdaptive = !Preferences::RenderScale();
+	bool isProfiling = (showLoad || isAdaptive);
+	if(showLoad || Telemetry::IsOpen())
+	{
+		chrono::steady_clock::time_point now = chrono::steady_clock::now();
+		frameIndex = (frameIndex + 1) % FRAME_HISTORY;
+		frameTimes[frameIndex] = chrono::duration<double, milli>(now - lastFrame).count();
+		gpuTimes[frameIndex] = drawProfiler.Last();
+		lastFrame = now;
+		Telemetry::Timing("frame", frameTimes[frameIndex]);
+	}
+	if(isProfiling)
+		drawProfiler.Start(BACKGROUND_PASS);
+	UpdateRenderScale(isAdaptive);
+	
+	// If the space scene is being drawn at less than full resolution, draw it
+	// offscreen and then scale it up to fill the screen. The planet labels are
+	// text, so in that case they are drawn afterwards at full resolution.
+	bool isScaled = (renderScale < 1. && sceneTarget.Begin(renderScale));
 	GameData::Background().Draw(center, centerVelocity, zoom);
-	static const Set<Color> &colors = GameData::Colors();
-	const Interface *interface = GameData::Interfaces().Get("hud");
+	const Interface *interface = HUD.Get();
 	
+	if(isProfiling)
+		drawProfiler.Start(OBJECT_PASS);
 	// Draw any active planet labels.
-	for(const PlanetLabel &label : labels)
-		label.Draw();
+	if(!isScaled)
+		for(const PlanetLabel &label : labels)
+			label.Draw();
 	
 	draw[drawTickTock].Draw();
+	if(isProfiling)
+		drawProfiler.Start(EFFECT_PASS);
 	batchDraw[drawTickTock].Draw();
+	particles.Draw(batchDraw[drawTickTock]);
+	if(isScaled)
+	{
+		sceneTarget.End();
+		sceneTarget.Draw();
+		for(const PlanetLabel &label : labels)
+			label.Draw();
+	}
+	if(isProfiling)
+		drawProfiler.Start(INTERFACE_PASS);
 	
-	for(const auto &it : statuses)
-	{
-		static const Color color[8] = {
-			*colors.Get("overlay friendly shields"),
-			*colors.Get("overlay hostile shields"),
-			*colors.Get("overlay outfit scan"),
-			*colors.Get("overlay friendly hull"),
-			*colors.Get("overlay hostile hull"),
-			*colors.Get("overlay cargo scan"),
-			*colors.Get("overlay friendly disabled"),
-			*colors.Get("overlay hostile disabled")
-		};
+	// Draw the status overlays. Those for the ships in the system are only shown
+	// while the player is flying. A big battle can have hundreds of them, so
+	// they are all drawn at once.
+	vector<RingShader::Item> rings;
+	auto addStatus = [this, &rings](const Status &it)
+	{
+		const Set<Color>::Ref *color = OVERLAY_COLORS;
 		Point pos = it.position * zoom;
 		double radius = it.radius * zoom;
 		if(it.outer > 0.)
-			RingShader::Draw(pos, radius + 3., 1.5f, it.outer, color[it.type], 0.f, it.angle);
+			rings.emplace_back(pos, radius + 3., 1.5f, it.outer, *color[it.type], 0.f, it.angle);
 		double dashes = (it.type >= 2) ? 0. : 20. * min(1., zoom);
 		if(it.inner > 0.)
-			RingShader::Draw(pos, radius, 1.5f, it.inner, color[3 + it.type], dashes, it.angle);
+			rings.emplace_back(pos, radius, 1.5f, it.inner, *color[3 + it.type], dashes, it.angle);
 		if(it.disabled > 0.)
-			RingShader::Draw(pos, radius, 1.5f, it.disabled, color[6 + it.type], dashes, it.angle);
+			rings.emplace_back(pos, radius, 1.5f, it.disabled, *color[6 + it.type], dashes, it.angle);
+	};
+	if(wasActive)
+	{
+		rings.reserve(3 * (shipStatuses[drawTickTock].size() + statuses.size()));
+		for(const Status &it : shipStatuses[drawTickTock])
+			addStatus(it);
 	}
+	for(const Status &it : statuses)
+		addStatus(it);
+	RingShader::Draw(rings);
 	
 	// Draw the flagship highlight, if any.
 	if(highlightSprite)
 	{
 		Point size(highlightSprite->Width(), highlightSprite->Height());
-		const Color &color = *colors.Get("flagship highlight");
+		const Color &color = *FLAGSHIP_HIGHLIGHT;
 		// The flagship is always in the dead center of the screen.
 		OutlineShader::Draw(highlightSprite, Point(), size, color, highlightUnit, highlightFrame);
 	}
@@ -894,13 +1103,32 @@ void Engine::Draw() const
 	const Font &font = FontSet::Get(14);
 	const vector<Messages::Entry> &messages = Messages::Get(step);
 	Rectangle messageBox = interface->GetBox("messages");
-	WrappedText messageLine(font);
-	messageLine.SetWrapWidth(messageBox.Width());
-	messageLine.SetParagraphBreak(0.);
+	if(wrappedMessageWidth != messageBox.Width())
+	{
+		wrappedMessages.clear();
+		wrappedMessageWidth = messageBox.Width();
+	}
+	// Only the messages that are still being shown are kept for the next frame.
+	map<string, WrappedText> wrapped;
 	Point messagePoint = Point(messageBox.Left(), messageBox.Bottom());
 	for(auto it = messages.rbegin(); it != messages.rend(); ++it)
 	{
-		messageLine.Wrap(it->message);
+		auto wit = wrapped.find(it->text);
+		if(wit == wrapped.end())
+		{
+			auto old = wrappedMessages.find(it->text);
+			if(old != wrappedMessages.end())
+				wit = wrapped.emplace(it->text, std::move(old->second)).first;
+			else
+			{
+				WrappedText line(font);
+				line.SetWrapWidth(wrappedMessageWidth);
+				line.SetParagraphBreak(0.);
+				line.Wrap(it->text);
+				wit = wrapped.emplace(it->text, std::move(line)).first;
+			}
+		}
+		const WrappedText &messageLine = wit->second;
 		messagePoint.Y() -= messageLine.Height();
 		if(messagePoint.Y() < messageBox.Top())
 			break;
@@ -908,9 +1136,10 @@ void Engine::Draw() const
 		Color color(alpha, 0.f);
 		messageLine.Draw(messagePoint, color);
 	}
+	wrappedMessages.swap(wrapped);
 	
 	// Draw crosshairs around anything that is targeted.
-	for(const Target &target : targets)
+	auto drawTarget = [this](const Target &target)
 	{
 		Angle a = target.angle;
 		Angle da(360. / target.count);
@@ -921,7 +1150,11 @@ void Engine::Draw() const
 				Radar::GetColor(target.type));
 			a += da;
 		}
-	}
+	};
+	for(const Target &target : targets)
+		drawTarget(target);
+	for(const Target &target : minableTargets[drawTickTock])
+		drawTarget(target);
 	
 	// Draw the heads-up display.
 	interface->Draw(info);
@@ -943,7 +1176,7 @@ void Engine::Draw() const
 	// Draw the faction markers.
 	if(targetSwizzle >= 0 && interface->HasPoint("faction markers"))
 	{
-		int width = font.Width(info.GetString("target government"));
+		int width = font.Width(info.GetString(TARGET_GOVERNMENT_KEY));
 		Point center = interface->GetPoint("faction markers");
 		
 		const Sprite *mark[2] = {SpriteSet::Get("ui/faction left"), SpriteSet::Get("ui/faction right")};
@@ -952,7 +1185,7 @@ void Engine::Draw() const
 		for(int i = 0; i < 2; ++i)
 			SpriteShader::Draw(mark[i], center + Point(dx[i], 0.), 1., targetSwizzle);
 	}
-	if(jumpCount && Preferences::Has("Show mini-map"))
+	if(jumpCount && Preferences::Has(Preferences::SHOW_MINI_MAP))
 		MapPanel::DrawMiniMap(player, .5f * min(1.f, jumpCount / 30.f), jumpInProgress, step);
 	
 	// Draw ammo status.
@@ -963,8 +1196,8 @@ void Engine::Draw() const
 	double ammoPad = .5 * (ammoBox.Width() - AMMO_WIDTH);
 	const Sprite *selectedSprite = SpriteSet::Get("ui/ammo selected");
 	const Sprite *unselectedSprite = SpriteSet::Get("ui/ammo unselected");
-	Color selectedColor = *colors.Get("bright");
-	Color unselectedColor = *colors.Get("dim");
+	Color selectedColor = *BRIGHT;
+	Color unselectedColor = *DIM;
 	
 	// This is the top left corner of the ammo display.
 	Point pos(ammoBox.Left() + ammoPad, ammoBox.Bottom() - ammoPad);
@@ -998,19 +1231,125 @@ void Engine::Draw() const
 	
 	// Upload any preloaded sprites that are now available. This is to avoid
 	// filling the entire backlog of sprites before landing on a planet.
+	if(isProfiling)
+		drawProfiler.Start(UPLOAD_PASS);
 	GameData::Progress();
+	if(isProfiling)
+		drawProfiler.Finish();
 	
-	if(Preferences::Has("Show CPU / GPU load"))
+	if(showLoad)
 	{
 		string loadString = to_string(lround(load * 100.)) + "% CPU";
-		Color color = *colors.Get("medium");
+		Color color = *MEDIUM;
 		font.Draw(loadString,
 			Point(-10 - font.Width(loadString), Screen::Height() * -.5 + 5.), color);
+		
+		// Below that, show the mean and 95th percentile time of each phase.
+		Point pos(-10., Screen::Height() * -.5 + 25.);
+		const vector<string> &names = profiler.Names();
+		for(size_t i = 0; i < names.size(); ++i)
+		{
+			const Profiler::Stats &stats = profiler.GetStats(i);
+			string line = names[i] + ": " + Format::Decimal(stats.mean, 2)
+				+ " / " + Format::Decimal(stats.high, 2) + " ms";
+			font.Draw(line, pos - Point(font.Width(line), 0.), color);
+			pos.Y() += 20.;
+		}
+		
+		// Then, show the same for each pass of drawing on the graphics card.
+		const Profiler &passes = drawProfiler.Times();
+		for(size_t i = 0; i < PASS_NAMES.size(); ++i)
+		{
+			const Profiler::Stats &stats = passes.GetStats(i);
+			string line = "gpu " + PASS_NAMES[i] + ": " + Format::Decimal(stats.mean, 2)
+				+ " / " + Format::Decimal(stats.high, 2) + " ms";
+			font.Draw(line, pos - Point(font.Width(line), 0.), color);
+			pos.Y() += 20.;
+		}
+		string scaleLine = "render scale: " + to_string(lround(100. * renderScale)) + "%";
+		font.Draw(scaleLine, pos - Point(font.Width(scaleLine), 0.), color);
+		pos.Y() += 20.;
+		
+		// Show how crowded the ship collision grid is.
+		string gridLine = "ship grid: " + to_string(shipGridStats.cellSize) + " px, "
+			+ to_string(shipGridStats.entries) + " in " + to_string(shipGridStats.occupiedCells)
+			+ " cells (max " + to_string(shipGridStats.busiestCell) + "), "
+			+ to_string(shipGridStats.large) + " large";
+		font.Draw(gridLine, pos - Point(font.Width(gridLine), 0.), color);
+		pos.Y() += 20.;
+		
+		// Show how much memory the largest subsystems are using.
+		for(int i = 0; i < MemoryUsage::CATEGORY_COUNT; ++i)
+		{
+			MemoryUsage::Category category = static_cast<MemoryUsage::Category>(i);
+			string line = MemoryUsage::Name(category) + ": "
+				+ Format::Decimal(MemoryUsage::Current(category) / 1048576., 1) + " MB";
+			font.Draw(line, pos - Point(font.Width(line), 0.), color);
+			pos.Y() += 20.;
+		}
+		
+		// Below that, graph the time of each recent frame, with the part of it
+		// that the graphics card spent on drawing in a brighter color. Each bar
+		// is one pixel tall per millisecond, and the line marks 60 frames per
+		// second. A hitch with a short bright part came from the CPU or vsync.
+		static const double BAR_WIDTH = 2.;
+		static const double MAX_HEIGHT = 50.;
+		const Color &bright = *BRIGHT;
+		const Color &dim = *DIM;
+		double bottom = pos.Y() + MAX_HEIGHT;
+		double right = pos.X();
+		for(size_t i = 0; i < FRAME_HISTORY; ++i)
+		{
+			size_t index = (frameIndex + 1 + i) % FRAME_HISTORY;
+			double x = right - (FRAME_HISTORY - i - .5) * BAR_WIDTH;
+			double height = min(MAX_HEIGHT, frameTimes[index]);
+			double gpuHeight = min(height, gpuTimes[index]);
+			FillShader::Fill(Point(x, bottom - .5 * height), Point(BAR_WIDTH, height), color);
+			FillShader::Fill(Point(x, bottom - .5 * gpuHeight), Point(BAR_WIDTH, gpuHeight), bright);
+		}
+		FillShader::Fill(Point(right - .5 * FRAME_HISTORY * BAR_WIDTH, bottom - 1000. / 60.),
+			Point(FRAME_HISTORY * BAR_WIDTH, 1.), dim);
 	}
 }
 
 
 
+// Get the timers for each phase of the calculation step.
+Profiler &Engine::GetProfiler()
+{
+	return profiler;
+}
+
+
+
+// Write the player's commands in each step that the player is flying to the
+// given file, in the format that a Scenario can replay.
+void Engine::RecordCommands(const string &path, uint64_t seed)
+{
+	recordPath = path;
+	recordSeed = seed;
+}
+
+
+
+// Give the player these commands, indexed by step, instead of reading the
+// keyboard.
+void Engine::ReplayCommands(const map<int, Command> &commands)
+{
+	replayCommands = commands;
+}
+
+
+
+// Write a checksum of the ships, projectiles, and random number generator
+// after each step to the given file.
+void Engine::WriteChecksums(const string &path)
+{
+	checksumPath = path;
+}
+
+
+
 // Select the object the player clicked on.
 void Engine::Click(const Point &from, const Point &to, bool hasShift)
 {
@@ -1020,7 +1359,7 @@ void Engine::Click(const Point &from, const Point &to, bool hasShift)
 	isRightClick = false;
 	
 	// Determine if the left-click was within the radar display.
-	const Interface *interface = GameData::Interfaces().Get("hud");
+	const Interface *interface = HUD.Get();
 	Point radarCenter = interface->GetPoint("radar");
 	double radarRadius = interface->GetValue("radar radius");
 	if(Preferences::Has("Clickable radar display") && (from - radarCenter).Length() <= radarRadius)
@@ -1046,7 +1385,7 @@ void Engine::RClick(const Point &point)
 	isRightClick = true;
 	
 	// Determine if the right-click was within the radar display, and if so, rescale.
-	const Interface *interface = GameData::Interfaces().Get("hud");
+	const Interface *interface = HUD.Get();
 	Point radarCenter = interface->GetPoint("radar");
 	double radarRadius = interface->GetValue("radar radius");
 	if(Preferences::Has("Clickable radar display") && (point - radarCenter).Length() <= radarRadius)
@@ -1070,6 +1409,10 @@ void Engine::EnterSystem()
 {
 	ai.Clean();
 	
+	// The system must be ready before the date changes, in case that causes
+	// any events that change the fleet or ship definitions.
+	const System *prepared = FinishPreparingSystem();
+	
 	Ship *flagship = player.Flagship();
 	if(!flagship)
 		return;
@@ -1096,6 +1439,17 @@ void Engine::EnterSystem()
 					&& flagship->Position().Distance(object.Position()) < 1.)
 				usedWormhole = &object;
 		}
+	// If the player is traveling on to another system, its landscapes can start
+	// loading too, in case the player lands there.
+	const vector<const System *> &plan = player.TravelPlan();
+	for(auto it = plan.rbegin(); it != plan.rend(); ++it)
+		if(*it != system)
+		{
+			for(const StellarObject &object : (*it)->Objects())
+				if(object.GetPlanet())
+					GameData::Preload(object.GetPlanet()->Landscape());
+			break;
+		}
 	
 	// Advance the positions of every StellarObject and update politics.
 	// Remove expired bribes, clearance, and grace periods from past fines.
@@ -1127,22 +1481,18 @@ void Engine::EnterSystem()
 		}
 	}
 	
-	asteroids.Clear();
-	for(const System::Asteroid &a : system->Asteroids())
-	{
-		// Check whether this is a minable or an ordinary asteroid.
-		if(a.Type())
-			asteroids.Add(a.Type(), a.Count(), a.Energy(), system->AsteroidBelt());
-		else
-			asteroids.Add(a.Name(), a.Count(), a.Energy());
-	}
-	
-	// Place five seconds worth of fleets. Check for undefined fleets by not
-	// trying to create anything with no government set.
-	for(int i = 0; i < 5; ++i)
-		for(const System::FleetProbability &fleet : system->Fleets())
-			if(fleet.Get()->GetGovernment() && Random::Int(fleet.Period()) < 60)
-				fleet.Get()->Place(*system, newShips);
+	// Add the asteroids and place five seconds worth of fleets. If the player
+	// jumped here, they were already created while the flagship was in
+	// hyperspace. Otherwise, create them now.
+	if(prepared != system)
+		PrepareSystem(system);
+	FinishPreparingSystem();
+	swap(asteroids, preparedAsteroids);
+	preparedAsteroids.Clear();
+	for(auto &it : preparedFleets)
+		it.first->Place(*system, newShips, std::move(it.second));
+	preparedFleets.clear();
+	preparedSystem = nullptr;
 	
 	const Fleet *raidFleet = system->GetGovernment()->RaidFleet();
 	const Government *raidGovernment = raidFleet ? raidFleet->GetGovernment() : nullptr;
@@ -1164,11 +1514,16 @@ void Engine::EnterSystem()
 	
 	projectiles.clear();
 	visuals.clear();
+	particles.Clear();
 	flotsam.clear();
 	// Cancel any projectiles, visuals, or flotsam created by ships this step.
 	newProjectiles.clear();
 	newVisuals.clear();
 	newFlotsam.clear();
+	for(vector<Projectile> &buffer : chunkProjectiles)
+		buffer.clear();
+	for(vector<Visual> &buffer : chunkVisuals)
+		buffer.clear();
 	
 	// Help message for new players. Show this message for the first four days,
 	// since the new player ships can make at most four jumps before landing.
@@ -1184,6 +1539,8 @@ void Engine::EnterSystem()
 // Thread entry point.
 void Engine::ThreadEntryPoint()
 {
+	Threads::Scope threadScope("engine", Threads::Priority::HIGH);
+	Random::SetState(calcRandomState);
 	while(true)
 	{
 		{
@@ -1210,18 +1567,22 @@ void Engine::ThreadEntryPoint()
 
 void Engine::CalculateStep()
 {
+	TRACE_SCOPE("Engine::CalculateStep");
 	FrameTimer loadTimer;
 	
 	// Clear the list of objects to draw.
 	draw[calcTickTock].Clear(step, zoom);
 	batchDraw[calcTickTock].Clear(step, zoom);
 	radar[calcTickTock].Clear();
+	shipStatuses[calcTickTock].clear();
+	minableTargets[calcTickTock].clear();
 	
 	if(!player.GetSystem())
 		return;
 	
 	// Now, all the ships must decide what they are doing next.
-	ai.Step(player, activeCommands);
+	profiler.Start(AI_STEP);
+	ai.Step(player, activeCommands, workers);
 	
 	// Clear the active players commands, they are all processed at this point.
 	activeCommands.Clear();
@@ -1231,6 +1592,7 @@ void Engine::CalculateStep()
 	// "act" before another does.
 	
 	// The only action stellar objects perform is to launch defense fleets.
+	profiler.Start(SHIP_MOVE);
 	const System *playerSystem = player.GetSystem();
 	for(const StellarObject &object : playerSystem->Objects())
 		if(object.GetPlanet())
@@ -1242,9 +1604,13 @@ void Engine::CalculateStep()
 	// Move all the ships.
 	for(const shared_ptr<Ship> &it : ships)
 		MoveShip(it);
-	// If the flagship just began jumping, play the appropriate sound.
+	// If the flagship just began jumping, play the appropriate sound, and start
+	// setting up the system it is jumping to.
 	if(!wasHyperspacing && flagship && flagship->IsEnteringHyperspace())
+	{
 		Audio::Play(Audio::Get(flagship->IsUsingJumpDrive() ? "jump drive" : "hyperdrive"));
+		PrepareSystem(flagship->GetTargetSystem());
+	}
 	// Check if the flagship just entered a new system.
 	if(flagship && playerSystem != flagship->GetSystem())
 	{
@@ -1255,7 +1621,7 @@ void Engine::CalculateStep()
 						it.GetPlanet()->WormholeDestination(playerSystem) == flagship->GetSystem())
 					player.Visit(it.GetPlanet());
 		
-		doFlash = Preferences::Has("Show hyperspace flash");
+		doFlash = Preferences::Has(Preferences::SHOW_HYPERSPACE_FLASH);
 		playerSystem = flagship->GetSystem();
 		player.SetSystem(playerSystem);
 		EnterSystem();
@@ -1264,6 +1630,7 @@ void Engine::CalculateStep()
 	
 	// Move the asteroids. This must be done before collision detection. Minables
 	// may create visuals or flotsam.
+	profiler.Start(ASTEROID_STEP);
 	asteroids.Step(newVisuals, newFlotsam, step);
 	
 	// Move the flotsam. This must happen after the ships move, because flotsam
@@ -1272,42 +1639,74 @@ void Engine::CalculateStep()
 		it->Move(newVisuals);
 	Prune(flotsam);
 	
-	// Move the projectiles.
-	for(Projectile &projectile : projectiles)
-		projectile.Move(newVisuals, newProjectiles);
+	// Move the projectiles. Each chunk of them is moved in parallel, storing
+	// any effects or submunitions it creates in its own staging buffers. Those
+	// are spliced in after everything in newVisuals and newProjectiles, in chunk
+	// order, so the new objects end up in the same order as if the projectiles
+	// had all been moved one after another. Each one draws its random numbers
+	// from its own stream, so they are the same no matter how the chunks were
+	// split between the threads.
+	profiler.Start(PROJECTILE_MOVE);
+	workers.Run(projectiles.size(), [this](size_t chunk, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			Random::Stream stream(MOVE_PROJECTILE, step, i);
+			projectiles[i].Move(chunkVisuals[chunk], chunkProjectiles[chunk]);
+		}
+	});
 	Prune(projectiles);
 	
 	// Move the visuals.
-	for(Visual &visual : visuals)
-		visual.Move();
+	workers.Run(visuals.size(), [this](size_t chunk, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			Random::Stream stream(MOVE_VISUAL, step, i);
+			visuals[i].Move();
+		}
+	});
 	Prune(visuals);
 	
 	// Perform various minor actions.
+	profiler.Start(SPAWNING);
 	SpawnFleets();
 	SpawnPersons();
 	SendHails();
-	HandleMouseClicks();
 	
 	// Now, take the new objects that were generated this step and splice them
 	// on to the ends of the respective lists of objects. These new objects will
 	// be drawn this step (and the projectiles will participate in collision
 	// detection) but they should not be moved, which is why we put off adding
 	// them to the lists until now.
-	ships.splice(ships.end(), newShips);
-	Append(projectiles, newProjectiles);
-	flotsam.splice(flotsam.end(), newFlotsam);
-	Append(visuals, newVisuals);
+	Append(ships, newShips);
+	Append(projectiles, newProjectiles, chunkProjectiles);
+	Append(flotsam, newFlotsam);
+	Append(visuals, newVisuals, chunkVisuals);
 	
 	// Decrement the count of how long it's been since a ship last asked for help.
 	if(grudgeTime)
 		--grudgeTime;
 	
 	// Populate the collision detection lookup sets.
+	profiler.Start(COLLISION_FILL);
 	FillCollisionSets();
 	
-	// Perform collision detection.
-	for(Projectile &projectile : projectiles)
-		DoCollisions(projectile);
+	// Mouse clicks look up the ships in the collision set, so they must be
+	// handled once it holds this step's ships and positions.
+	HandleMouseClicks();
+	
+	// Perform collision detection. Finding which ship each projectile hits does
+	// not change anything, so do that for all of them in parallel first.
+	profiler.Start(COLLISIONS);
+	shipHits.resize(projectiles.size());
+	workers.Run(projectiles.size(), [this](size_t, size_t begin, size_t end)
+	{
+		shipCollisions.Line(projectiles, begin, end, shipHits);
+	});
+	FillAntiMissileGrid();
+	for(size_t i = 0; i < projectiles.size(); ++i)
+		DoCollisions(projectiles[i], shipHits[i]);
 	// Now that collision detection is done, clear the cache of ships with anti-
 	// missile systems ready to fire.
 	hasAntiMissile.clear();
@@ -1317,6 +1716,7 @@ void Engine::CalculateStep()
 		DoCollection(*it);
 	
 	// Check for ship scanning.
+	profiler.Start(SCANNING);
 	for(const shared_ptr<Ship> &it : ships)
 		DoScanning(it);
 	
@@ -1333,8 +1733,11 @@ void Engine::CalculateStep()
 	radar[calcTickTock].SetCenter(newCenter);
 	
 	// Populate the radar.
+	profiler.Start(RADAR_FILL);
 	FillRadar();
 	
+	profiler.Start(DRAW_LIST);
+	
 	// Draw the planets.
 	for(const StellarObject &object : playerSystem->Objects())
 		if(object.HasSprite())
@@ -1351,13 +1754,34 @@ void Engine::CalculateStep()
 	for(const shared_ptr<Flotsam> &it : flotsam)
 		draw[calcTickTock].Add(*it);
 	// Draw the ships. Skip the flagship, then draw it on top of all the others.
+	// Each chunk of the ships is drawn into a list of its own, and those lists
+	// are appended in chunk order, so the ships are drawn in the same order as
+	// if they had all been added to the main list one after another. Picking
+	// the starting frames of flares and hardpoints draws random numbers, so
+	// each ship is drawn with its own random stream, as when moving objects.
+	for(DrawList &list : chunkDraws)
+		list.Clear(draw[calcTickTock]);
+	workers.Run(ships.size(), [this, playerSystem, flagship](size_t chunk, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			const Ship &ship = *ships[i];
+			if(ship.GetSystem() != playerSystem || !ship.HasSprite() || &ship == flagship)
+				continue;
+			
+			Random::Stream stream(DRAW_SHIP, step, i);
+			AddSprites(chunkDraws[chunk], ship);
+		}
+	});
+	for(const DrawList &list : chunkDraws)
+		draw[calcTickTock].Append(list);
+	
 	bool showFlagship = false;
 	for(const shared_ptr<Ship> &ship : ships)
 		if(ship->GetSystem() == playerSystem && ship->HasSprite())
 		{
 			if(ship.get() != flagship)
 			{
-				AddSprites(*ship);
 				if(ship->IsThrusting())
 				{
 					for(const auto &it : ship->Attributes().FlareSounds())
@@ -1371,7 +1795,7 @@ void Engine::CalculateStep()
 		
 	if(flagship && showFlagship)
 	{
-		AddSprites(*flagship);
+		AddSprites(draw[calcTickTock], *flagship);
 		if(flagship->IsThrusting())
 		{
 			for(const auto &it : flagship->Attributes().FlareSounds())
@@ -1379,12 +1803,82 @@ void Engine::CalculateStep()
 					Audio::Play(it.first);
 		}
 	}
-	// Draw the projectiles.
-	for(const Projectile &projectile : projectiles)
-		batchDraw[calcTickTock].Add(projectile, projectile.Clip());
-	// Draw the visuals.
-	for(const Visual &visual : visuals)
-		batchDraw[calcTickTock].AddVisual(visual);
+	// Create the status overlays, so that the main thread does not need to
+	// go through all the ships to find them.
+	if(Preferences::Has(Preferences::SHOW_STATUS_OVERLAYS))
+		for(const auto &it : ships)
+		{
+			if(!it->GetGovernment() || it->GetSystem() != playerSystem || it->Cloaking() == 1.)
+				continue;
+			// Don't show status for dead ships.
+			if(it->IsDestroyed())
+				continue;
+			
+			bool isEnemy = it->GetGovernment()->IsEnemy();
+			if(isEnemy || it->IsYours() || it->GetPersonality().IsEscort())
+			{
+				double width = min(it->Width(), it->Height());
+				shipStatuses[calcTickTock].emplace_back(it->Position() - newCenter, it->Shields(), it->Hull(),
+					min(it->Hull(), it->DisabledHull()), max(20., width * .5), isEnemy);
+			}
+		}
+	// Draw crosshairs on any minables in range of the flagship's scanners.
+	// Only the minables near the flagship need to be checked.
+	double scanRange = flagship ? flagship->AsteroidScanRange() : 0.;
+	if(scanRange && !flagship->IsHyperspacing())
+	{
+		const Minable *targetAsteroid = flagship->GetTargetAsteroid().get();
+		for(Body *body : asteroids.MinableCollisions().Circle(newCenter, scanRange))
+		{
+			const Minable *minable = static_cast<const Minable *>(body);
+			Point offset = minable->Position() - newCenter;
+			if(offset.Length() > scanRange)
+				continue;
+			
+			minableTargets[calcTickTock].push_back({
+				offset,
+				minable->Facing(),
+				.8 * minable->Radius(),
+				minable == targetAsteroid ? Radar::SPECIAL : Radar::INACTIVE,
+				3});
+		}
+	}
+	// Draw the projectiles, in chunks like the ships. Each sprite's instances
+	// are drawn in the order they were added, so all the projectiles' chunks
+	// must be appended before any of the visuals are drawn.
+	for(BatchDrawList &list : chunkBatches)
+		list.Clear(batchDraw[calcTickTock]);
+	workers.Run(projectiles.size(), [this](size_t chunk, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			Random::Stream stream(DRAW_PROJECTILE, step, i);
+			chunkBatches[chunk].Add(projectiles[i], projectiles[i].Clip());
+		}
+	});
+	for(BatchDrawList &list : chunkBatches)
+	{
+		batchDraw[calcTickTock].Append(list);
+		list.Clear(batchDraw[calcTickTock]);
+	}
+	// Visuals that the graphics card can move and animate on its own are handed
+	// over to it, and are not moved or drawn here again. Draw the rest.
+	particles.Add(visuals, step);
+	workers.Run(visuals.size(), [this](size_t chunk, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
+		{
+			Random::Stream stream(DRAW_VISUAL, step, i);
+			chunkBatches[chunk].AddVisual(visuals[i]);
+		}
+	});
+	for(const BatchDrawList &list : chunkBatches)
+		batchDraw[calcTickTock].Append(list);
+	
+	profiler.Finish();
+	
+	if(checksumLog)
+		WriteChecksum();
 	
 	// Keep track of how much of the CPU time we are using.
 	loadSum += loadTimer.Time();
@@ -1393,7 +1887,97 @@ void Engine::CalculateStep()
 		load = loadSum;
 		loadSum = 0.;
 		loadCount = 0;
+		shipGridStats = shipCollisions.GetStats();
+		
+		// If anyone is watching, report how the simulation is doing once for
+		// each of these windows, along with the average time of each phase.
+		if(Telemetry::IsOpen())
+		{
+			Telemetry::Gauge("ships", ships.size());
+			Telemetry::Gauge("projectiles", projectiles.size());
+			Telemetry::Gauge("visuals", visuals.size());
+			Telemetry::Gauge("flotsam", flotsam.size());
+			Telemetry::Gauge("load", load);
+			Telemetry::Gauge("draw.items", draw[calcTickTock].Size());
+			Telemetry::Gauge("draw.batched", batchDraw[calcTickTock].Size());
+			Telemetry::Gauge("sprites.backlog", GameData::SpriteBacklog());
+			Telemetry::Gauge("audio.voices", Audio::Voices());
+			Telemetry::Gauge("collisions.cell_size", shipGridStats.cellSize);
+			Telemetry::Gauge("collisions.entries", shipGridStats.entries);
+			Telemetry::Gauge("collisions.large", shipGridStats.large);
+			Telemetry::Gauge("collisions.occupied", shipGridStats.occupiedCells);
+			Telemetry::Gauge("collisions.busiest", shipGridStats.busiestCell);
+			const vector<string> &names = profiler.Names();
+			for(size_t i = 0; i < names.size(); ++i)
+				Telemetry::Timing("step." + TelemetryName(names[i]), profiler.GetStats(i).mean);
+			Telemetry::Flush();
+		}
+	}
+}
+
+
+
+// Write the checksum of this step. Each object gets a checksum of its own, so
+// that if two runs differ it is clear where they first did.
+void Engine::WriteChecksum()
+{
+	vector<Checksum> shipSums;
+	shipSums.reserve(ships.size());
+	for(const shared_ptr<Ship> &ship : ships)
+	{
+		shipSums.emplace_back();
+		Checksum &sum = shipSums.back();
+		sum.Add(ship->Name());
+		sum.Add(ship->Position());
+		sum.Add(ship->Velocity());
+		sum.Add(ship->Facing().Degrees());
+		sum.Add(ship->Energy());
+		sum.Add(ship->Hull());
+		sum.Add(ship->Shields());
+		sum.Add(ship->Fuel());
+		sum.Add(ship->Heat());
 	}
+	
+	Checksum projectileSum;
+	for(const Projectile &projectile : projectiles)
+	{
+		projectileSum.Add(projectile.Position());
+		projectileSum.Add(projectile.Velocity());
+		projectileSum.Add(projectile.Facing().Degrees());
+	}
+	
+	// The random numbers are checked first, so that if they are what made the
+	// two runs differ, that is the first difference reported. This thread's
+	// own generator is checked, along with each kind of keyed stream that the
+	// worker threads draw from.
+	Checksum randomSum;
+	randomSum.Add(Random::State());
+	// There is no stream zero, so the checksum for stream i is at index i - 1.
+	vector<Checksum> streamSums(RANDOM_STREAM_NAMES.size() - 1);
+	for(size_t i = 1; i < RANDOM_STREAM_NAMES.size(); ++i)
+		streamSums[i - 1].Add(Random::StreamHash(i));
+	
+	Checksum total;
+	total.Add(randomSum.Value());
+	for(const Checksum &sum : streamSums)
+		total.Add(sum.Value());
+	for(const Checksum &sum : shipSums)
+		total.Add(sum.Value());
+	total.Add(projectileSum.Value());
+	
+	checksumLog->Write("step", step, total.ToString());
+	checksumLog->BeginChild();
+	{
+		checksumLog->Write("random", randomSum.ToString());
+		for(size_t i = 1; i < RANDOM_STREAM_NAMES.size(); ++i)
+			checksumLog->Write("stream", RANDOM_STREAM_NAMES[i], streamSums[i - 1].ToString());
+		auto sum = shipSums.begin();
+		int index = 0;
+		for(const shared_ptr<Ship> &ship : ships)
+			checksumLog->Write("ship", index++, ship->Name(), (sum++)->ToString());
+		checksumLog->Write("projectiles", projectiles.size(), projectileSum.ToString());
+	}
+	checksumLog->EndChild();
 }
 
 
@@ -1466,7 +2050,8 @@ void Engine::MoveShip(const shared_ptr<Ship> &ship)
 
 
 
-// Populate the ship collision detection set for projectile & flotsam computations.
+// Populate the ship collision detection set for projectile & flotsam computations,
+// and the flotsam set for the AI's harvesters.
 void Engine::FillCollisionSets()
 {
 	shipCollisions.Clear(step);
@@ -1476,6 +2061,123 @@ void Engine::FillCollisionSets()
 	
 	// Get the ship collision set ready to query.
 	shipCollisions.Finish();
+	
+	flotsamCollisions.Clear(step);
+	for(const shared_ptr<Flotsam> &it : flotsam)
+		flotsamCollisions.Add(*it);
+	flotsamCollisions.Finish();
+}
+
+
+
+// Begin setting up the asteroids and fleets of the given system, so that they
+// are ready by the time the player enters it. Creating them takes long enough
+// to cause a noticeable hitch if it is all done in the step when the player
+// arrives, so it is done in a background thread while the flagship is still in
+// hyperspace. The planet landscapes also begin loading now.
+void Engine::PrepareSystem(const System *system)
+{
+	FinishPreparingSystem();
+	preparedAsteroids.Clear();
+	preparedFleets.clear();
+	preparedSystem = system;
+	if(!system)
+		return;
+	
+	for(const StellarObject &object : system->Objects())
+		if(object.GetPlanet())
+			GameData::Preload(object.GetPlanet()->Landscape());
+	
+	// Which fleets appear, and the ships in them, are rolled on the new thread,
+	// so it carries on from a state drawn from this thread's random numbers to
+	// keep them reproducible from the seed.
+	uint64_t randomState = static_cast<uint64_t>(Random::Int()) << 32;
+	randomState |= Random::Int();
+	prepareThread = thread([this, system, randomState]()
+	{
+		Threads::Scope threadScope("prepare", Threads::Priority::LOW);
+		Random::SetState(randomState);
+		TRACE_SCOPE("Engine::PrepareSystem");
+		lock_guard<mutex> lock(GameData::ReloadMutex());
+		for(const System::Asteroid &a : system->Asteroids())
+		{
+			// Check whether this is a minable or an ordinary asteroid.
+			if(a.Type())
+				preparedAsteroids.Add(a.Type(), a.Count(), a.Energy(), system->AsteroidBelt());
+			else
+				preparedAsteroids.Add(a.Name(), a.Count(), a.Energy());
+		}
+		
+		// Create five seconds worth of fleets. Check for undefined fleets by not
+		// trying to create anything with no government set.
+		for(int i = 0; i < 5; ++i)
+			for(const System::FleetProbability &fleet : system->Fleets())
+				if(fleet.Get()->GetGovernment() && Random::Int(fleet.Period()) < 60)
+					preparedFleets.emplace_back(fleet.Get(), fleet.Get()->Instantiate());
+	});
+}
+
+
+
+// Wait for the system to be ready, and get which system it is.
+const System *Engine::FinishPreparingSystem()
+{
+	if(prepareThread.joinable())
+		prepareThread.join();
+	return preparedSystem;
+}
+
+
+
+// Sort the ships with anti-missile systems ready to fire into the grid cells
+// that their anti-missile range overlaps, so that each missile only has to
+// check the ships that might be able to shoot it down.
+void Engine::FillAntiMissileGrid()
+{
+	const unsigned CELLS = ANTI_MISSILE_CELLS * ANTI_MISSILE_CELLS;
+	antiMissileStart.assign(CELLS + 2, 0);
+	
+	// Get the range of cells that a ship's anti-missile range overlaps. A very
+	// long range might wrap around the grid, but each ship should still only
+	// be listed once in each cell.
+	auto bounds = [](const Ship &ship, int &left, int &top, int &right, int &bottom)
+	{
+		const Point &p = ship.Position();
+		double range = ship.AntiMissileRange();
+		left = AntiMissileCell(p.X() - range);
+		top = AntiMissileCell(p.Y() - range);
+		right = min(AntiMissileCell(p.X() + range), left + ANTI_MISSILE_CELLS - 1);
+		bottom = min(AntiMissileCell(p.Y() + range), top + ANTI_MISSILE_CELLS - 1);
+	};
+	
+	// Count how many ships are in each cell, then convert those counts into
+	// the index where each cell's list begins. The counts are offset by two so
+	// that after the conversion, antiMissileStart[bin + 1] is where the next
+	// ship in that bin should be placed.
+	int left, top, right, bottom;
+	for(const Ship *ship : hasAntiMissile)
+	{
+		bounds(*ship, left, top, right, bottom);
+		for(int y = top; y <= bottom; ++y)
+			for(int x = left; x <= right; ++x)
+				++antiMissileStart[AntiMissileBin(x, y) + 2];
+	}
+	for(unsigned i = 2; i < CELLS + 2; ++i)
+		antiMissileStart[i] += antiMissileStart[i - 1];
+	
+	// Fill in each cell's list. The ships are added in order, so each list is
+	// in the same order as hasAntiMissile, and the first ship to shoot down a
+	// given missile is the same as if every ship were checked. Once this is
+	// done, each cell's list begins at antiMissileStart[bin] and ends at
+	// antiMissileStart[bin + 1].
+	antiMissileSorted.resize(antiMissileStart.back());
+	for(unsigned i = 0; i < hasAntiMissile.size(); ++i)
+	{
+		bounds(*hasAntiMissile[i], left, top, right, bottom);
+		for(int y = top; y <= bottom; ++y)
+			for(int x = left; x <= right; ++x)
+				antiMissileSorted[antiMissileStart[AntiMissileBin(x, y) + 1]++] = i;
+	}
 }
 
 
@@ -1687,11 +2389,15 @@ void Engine::HandleMouseClicks()
 				}
 			}
 	
-	// Check for clicks on ships in this system.
+	// Check for clicks on ships in this system. Only the ships whose masks come
+	// within the click range need to be checked, and any targetable ship in
+	// this system is in the collision set.
 	double clickRange = 50.;
 	shared_ptr<Ship> clickTarget;
-	for(shared_ptr<Ship> &ship : ships)
-		if(ship->GetSystem() == playerSystem && &*ship != flagship && ship->IsTargetable())
+	for(Body *body : shipCollisions.Circle(clickPoint + flagship->Position(), clickRange))
+	{
+		Ship *ship = reinterpret_cast<Ship *>(body);
+		if(ship != flagship && ship->IsTargetable())
 		{
 			Point position = ship->Position() - flagship->Position();
 			const Mask &mask = ship->GetMask(step);
@@ -1699,7 +2405,7 @@ void Engine::HandleMouseClicks()
 			if(range <= clickRange)
 			{
 				clickRange = range;
-				clickTarget = ship;
+				clickTarget = ship->shared_from_this();
 				// If we've found an enemy within the click zone, favor
 				// targeting it rather than any other ship. Otherwise, keep
 				// checking for hits because another ship might be an enemy.
@@ -1707,6 +2413,7 @@ void Engine::HandleMouseClicks()
 					break;
 			}
 		}
+	}
 	if(clickTarget)
 	{
 		if(isRightClick)
@@ -1726,10 +2433,10 @@ void Engine::HandleMouseClicks()
 	}
 	else if(isRightClick)
 		ai.IssueMoveTarget(player, clickPoint + center, playerSystem);
-	else if(flagship->Attributes().Get("asteroid scan power"))
+	else if(flagship->AsteroidScanRange())
 	{
 		// If the click was not on any ship, check if it was on a minable.
-		double scanRange = 100. * sqrt(flagship->Attributes().Get("asteroid scan power"));
+		double scanRange = flagship->AsteroidScanRange();
 		for(const shared_ptr<Minable> &minable : asteroids.Minables())
 		{
 			Point position = minable->Position() - flagship->Position();
@@ -1751,7 +2458,7 @@ void Engine::HandleMouseClicks()
 // Perform collision detection. Note that unlike the preceding functions, this
 // one adds any visuals that are created directly to the main visuals list. If
 // this is multi-threaded in the future, that will need to change.
-void Engine::DoCollisions(Projectile &projectile)
+void Engine::DoCollisions(Projectile &projectile, const pair<Body *, double> &shipHit)
 {
 	// The asteroids can collide with projectiles, the same as any other
 	// object. If the asteroid turns out to be closer than the ship, it
@@ -1783,24 +2490,22 @@ void Engine::DoCollisions(Projectile &projectile)
 	{
 		// For weapons with a trigger radius, check if any detectable object will set it off.
 		double triggerRadius = projectile.GetWeapon().TriggerRadius();
-		if(triggerRadius)
-			for(const Body *body : shipCollisions.Circle(projectile.Position(), triggerRadius))
-				if(body == projectile.Target() || (gov->IsEnemy(body->GetGovernment())
-						&& reinterpret_cast<const Ship *>(body)->Cloaking() < 1.))
+		if(triggerRadius && shipCollisions.MayReach(projectile.Position(), projectile.Position(), triggerRadius)
+				&& shipCollisions.FindInCircle(projectile.Position(), triggerRadius,
+				[&projectile, gov](const Body *body)
 				{
-					closestHit = 0.;
-					break;
-				}
+					return body == projectile.Target() || (gov->IsEnemy(body->GetGovernment())
+						&& reinterpret_cast<const Ship *>(body)->Cloaking() < 1.);
+				}))
+			closestHit = 0.;
 		
 		// If nothing triggered the projectile, check for collisions with ships.
-		if(closestHit > 0.)
+		if(closestHit > 0. && shipHit.first)
 		{
-			Ship *ship = reinterpret_cast<Ship *>(shipCollisions.Line(projectile, &closestHit));
-			if(ship)
-			{
-				hit = ship->shared_from_this();
-				hitVelocity = ship->Velocity();
-			}
+			Ship *ship = reinterpret_cast<Ship *>(shipHit.first);
+			closestHit = shipHit.second;
+			hit = ship->shared_from_this();
+			hitVelocity = ship->Velocity();
 		}
 		// "Phasing" projectiles can pass through asteroids. For all other
 		// projectiles, check if they've hit an asteroid that is closer than any
@@ -1856,14 +2561,20 @@ void Engine::DoCollisions(Projectile &projectile)
 	else if(projectile.MissileStrength())
 	{
 		// If the projectile did not hit anything, give the anti-missile systems
-		// a chance to shoot it down.
-		for(Ship *ship : hasAntiMissile)
+		// a chance to shoot it down. Only the ships listed in the grid cell the
+		// missile is in can be in range of it.
+		const Point &p = projectile.Position();
+		unsigned bin = AntiMissileBin(AntiMissileCell(p.X()), AntiMissileCell(p.Y()));
+		for(unsigned i = antiMissileStart[bin]; i < antiMissileStart[bin + 1]; ++i)
+		{
+			Ship *ship = hasAntiMissile[antiMissileSorted[i]];
 			if(ship == projectile.Target() || gov->IsEnemy(ship->GetGovernment()))
 				if(ship->FireAntiMissile(projectile, visuals))
 				{
 					projectile.Kill();
 					break;
 				}
+		}
 	}
 }
 
@@ -1873,16 +2584,12 @@ void Engine::DoCollisions(Projectile &projectile)
 void Engine::DoCollection(Flotsam &flotsam)
 {
 	// Check if any ship can pick up this flotsam. Cloaked ships cannot act.
-	Ship *collector = nullptr;
-	for(Body *body : shipCollisions.Circle(flotsam.Position(), 5.))
-	{
-		Ship *ship = reinterpret_cast<Ship *>(body);
-		if(!ship->CannotAct() && ship != flotsam.Source() && ship->Cargo().Free() >= flotsam.UnitSize())
+	Ship *collector = reinterpret_cast<Ship *>(shipCollisions.FindInCircle(flotsam.Position(), 5.,
+		[&flotsam](const Body *body)
 		{
-			collector = ship;
-			break;
-		}
-	}
+			const Ship *ship = reinterpret_cast<const Ship *>(body);
+			return !ship->CannotAct() && ship != flotsam.Source() && ship->Cargo().Free() >= flotsam.UnitSize();
+		}));
 	if(!collector)
 		return;
 	
@@ -1967,7 +2674,7 @@ void Engine::FillRadar()
 	if(flagship)
 	{
 		const System *targetSystem = flagship->GetTargetSystem();
-		const set<const System *> &links = (flagship->Attributes().Get("jump drive")) ?
+		const set<const System *> &links = (flagship->Attributes().Get(Outfit::JUMP_DRIVE)) ?
 			playerSystem->Neighbors() : playerSystem->Links();
 		for(const System *system : links)
 			radar[calcTickTock].AddPointer(
@@ -1976,7 +2683,7 @@ void Engine::FillRadar()
 	}
 	
 	// Add viewport brackets.
-	if(!Preferences::Has("Disable viewport on radar"))
+	if(!Preferences::Has(Preferences::DISABLE_VIEWPORT_ON_RADAR))
 	{
 		radar[calcTickTock].AddViewportBoundary(Screen::TopLeft() / zoom);
 		radar[calcTickTock].AddViewportBoundary(Screen::TopRight() / zoom);
@@ -2011,7 +2718,7 @@ void Engine::FillRadar()
 		--alarmTime;
 	else if(hasHostiles && !hadHostiles)
 	{
-		if(Preferences::Has("Warning siren"))
+		if(Preferences::Has(Preferences::WARNING_SIREN))
 			Audio::Play(Audio::Get("alarm"));
 		alarmTime = 180;
 		hadHostiles = true;
@@ -2036,8 +2743,9 @@ void Engine::FillRadar()
 
 
 // Each ship is drawn as an entire stack of sprites, including hardpoint sprites
-// and engine flares and any fighters it is carrying externally.
-void Engine::AddSprites(const Ship &ship)
+// and engine flares and any fighters it is carrying externally. This may be
+// called for different ships in different threads at once.
+void Engine::AddSprites(DrawList &list, const Ship &ship)
 {
 	bool hasFighters = ship.PositionFighters();
 	double cloak = ship.Cloaking();
@@ -2048,8 +2756,8 @@ void Engine::AddSprites(const Ship &ship)
 			if(bay.side == Ship::Bay::UNDER && bay.ship)
 			{
 				if(drawCloaked)
-					draw[calcTickTock].AddSwizzled(*bay.ship, 7);
-				draw[calcTickTock].Add(*bay.ship, cloak);
+					list.AddSwizzled(*bay.ship, 7);
+				list.Add(*bay.ship, cloak);
 			}
 	
 	if(ship.IsThrusting())
@@ -2062,13 +2770,13 @@ void Engine::AddSprites(const Ship &ship)
 				for(int i = 0; i < it.second && i < 3; ++i)
 				{
 					Body sprite(it.first, pos, ship.Velocity(), ship.Facing(), point.Zoom());
-					draw[calcTickTock].Add(sprite, cloak);
+					list.Add(sprite, cloak);
 				}
 		}
 	
 	if(drawCloaked)
-		draw[calcTickTock].AddSwizzled(ship, 7);
-	draw[calcTickTock].Add(ship, cloak);
+		list.AddSwizzled(ship, 7);
+	list.Add(ship, cloak);
 	for(const Hardpoint &hardpoint : ship.Weapons())
 		if(hardpoint.GetOutfit() && hardpoint.GetOutfit()->HardpointSprite().HasSprite())
 		{
@@ -2078,7 +2786,7 @@ void Engine::AddSprites(const Ship &ship)
 				ship.Velocity(),
 				ship.Facing() + hardpoint.GetAngle(),
 				ship.Zoom());
-			draw[calcTickTock].Add(body, cloak);
+			list.Add(body, cloak);
 		}
 	
 	if(hasFighters)
@@ -2086,13 +2794,50 @@ void Engine::AddSprites(const Ship &ship)
 			if(bay.side == Ship::Bay::OVER && bay.ship)
 			{
 				if(drawCloaked)
-					draw[calcTickTock].AddSwizzled(*bay.ship, 7);
-				draw[calcTickTock].Add(*bay.ship, cloak);
+					list.AddSwizzled(*bay.ship, 7);
+				list.Add(*bay.ship, cloak);
 			}
 }
 
 
 
+// Pick the resolution to draw the space scene at in this frame.
+void Engine::UpdateRenderScale(bool isAdaptive) const
+{
+	if(!isAdaptive)
+	{
+		renderScale = Preferences::RenderScale();
+		gpuTimeSum = 0.;
+		gpuTimeCount = 0;
+		return;
+	}
+	
+	// Frames whose graphics card time is not known yet are not counted.
+	double last = drawProfiler.Last();
+	if(last <= 0.)
+		return;
+	gpuTimeSum += last;
+	if(++gpuTimeCount < RENDER_SCALE_FRAMES)
+		return;
+	
+	// The time it takes to draw the scene mostly depends on how many pixels it
+	// covers, which goes as the square of the scale. Leave the scale alone if
+	// it is close enough, so that it does not keep changing back and forth.
+	double mean = gpuTimeSum / gpuTimeCount;
+	gpuTimeSum = 0.;
+	gpuTimeCount = 0;
+	if(mean < TARGET_GPU_TIME * 1.1 && (mean > TARGET_GPU_TIME * .7 || renderScale == 1.))
+		return;
+	
+	// Lower the resolution quickly when frames are being dropped, but raise it
+	// slowly, and by no more than the graphics card seems to have room for.
+	double ideal = renderScale * sqrt(TARGET_GPU_TIME / mean);
+	renderScale = max(renderScale - .1, min(renderScale + .05, ideal));
+	renderScale = max(MIN_RENDER_SCALE, min(1., renderScale));
+}
+
+
+
 // If a ship just damaged another ship, update information on who has asked the
 // player for assistance (and ask for assistance if appropriate).
 void Engine::DoGrudge(const shared_ptr<Ship> &target, const Government *attacker)
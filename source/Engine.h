@@ -20,29 +20,41 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "DrawList.h"
 #include "EscortDisplay.h"
+#include "GPUProfiler.h"
 #include "Information.h"
+#include "ParticleSystem.h"
+#include "PlanetLabel.h"
 #include "Point.h"
+#include "Profiler.h"
 #include "Radar.h"
 #include "Rectangle.h"
+#include "RenderTarget.h"
+#include "WorkerPool.h"
+#include "WrappedText.h"
 
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
+#include <string>
 #include <thread>
 #include <utility>
 #include <vector>
 
+class DataWriter;
+class Fleet;
 class Flotsam;
 class Government;
 class NPC;
 class Outfit;
-class PlanetLabel;
 class PlayerInfo;
 class Projectile;
 class Ship;
 class ShipEvent;
 class Sprite;
+class System;
 class Visual;
 
 
@@ -74,11 +86,27 @@ public:
 	
 	// Get any special events that happened in this step.
 	// MainPanel::Step will clear this list.
-	std::list<ShipEvent> &Events();
+	std::vector<ShipEvent> &Events();
 	
 	// Draw a frame.
 	void Draw() const;
 	
+	// Get the timers for each phase of the calculation step.
+	Profiler &GetProfiler();
+	
+	// Write the player's commands in each step that the player is flying to
+	// the given file, in the format that a Scenario can replay, starting with
+	// the given random seed. This applies to the next engine that is created.
+	static void RecordCommands(const std::string &path, uint64_t seed);
+	// Give the player these commands, indexed by step, instead of reading the
+	// keyboard. Steps are counted from 1, the first step after Place().
+	void ReplayCommands(const std::map<int, Command> &commands);
+	// Write a checksum of the ships, projectiles, and random number generator
+	// after each step to the given file, so that two runs can be compared to
+	// make sure they behave the same. This applies to the next engine that is
+	// created.
+	static void WriteChecksums(const std::string &path);
+	
 	// Select the object the player clicked on.
 	void Click(const Point &from, const Point &to, bool hasShift);
 	void RClick(const Point &point);
@@ -87,9 +115,16 @@ public:
 	
 private:
 	void EnterSystem();
+	// Begin setting up the asteroids and fleets of the given system, so that
+	// they are ready by the time the player enters it.
+	void PrepareSystem(const System *system);
+	// Wait for the system to be ready, and get which system it is.
+	const System *FinishPreparingSystem();
 	
 	void ThreadEntryPoint();
 	void CalculateStep();
+	// Write the checksum of this step.
+	void WriteChecksum();
 	
 	void MoveShip(const std::shared_ptr<Ship> &ship);
 	
@@ -100,14 +135,17 @@ private:
 	void HandleMouseClicks();
 	
 	void FillCollisionSets();
+	void FillAntiMissileGrid();
 	
-	void DoCollisions(Projectile &projectile);
+	void DoCollisions(Projectile &projectile, const std::pair<Body *, double> &shipHit);
 	void DoCollection(Flotsam &flotsam);
 	void DoScanning(const std::shared_ptr<Ship> &ship);
 	
 	void FillRadar();
 	
-	void AddSprites(const Ship &ship);
+	void AddSprites(DrawList &list, const Ship &ship);
+	// Pick the resolution to draw the space scene at in this frame.
+	void UpdateRenderScale(bool isAdaptive) const;
 	
 	void DoGrudge(const std::shared_ptr<Ship> &target, const Government *attacker);
 	
@@ -139,9 +177,9 @@ private:
 private:
 	PlayerInfo &player;
 	
-	std::list<std::shared_ptr<Ship>> ships;
+	std::vector<std::shared_ptr<Ship>> ships;
 	std::vector<Projectile> projectiles;
-	std::list<std::shared_ptr<Flotsam>> flotsam;
+	std::vector<std::shared_ptr<Flotsam>> flotsam;
 	std::vector<Visual> visuals;
 	AsteroidField asteroids;
 	
@@ -151,12 +189,36 @@ private:
 	std::list<std::shared_ptr<Flotsam>> newFlotsam;
 	std::vector<Visual> newVisuals;
 	
-	// Track which ships currently have anti-missiles ready to fire.
+	// Track which ships currently have anti-missiles ready to fire. Each cell
+	// of the anti-missile grid lists the indices of the ships whose range
+	// overlaps it, as a range of the sorted list, in the same order as above.
 	std::vector<Ship *> hasAntiMissile;
+	std::vector<unsigned> antiMissileStart;
+	std::vector<unsigned> antiMissileSorted;
 	
 	AI ai;
 	
 	std::thread calcThread;
+	// The state the calculation thread's random number generator starts in,
+	// which comes from the thread that created the engine, so that seeding that
+	// thread also decides what the calculations draw.
+	uint64_t calcRandomState = 0;
+	// The thread that sets up the system the flagship is jumping to while it is
+	// in hyperspace, and the asteroids and fleets it has created.
+	std::thread prepareThread;
+	const System *preparedSystem = nullptr;
+	AsteroidField preparedAsteroids;
+	std::vector<std::pair<const Fleet *, std::vector<std::shared_ptr<Ship>>>> preparedFleets;
+	// Worker threads for splitting up the per-object loops in CalculateStep,
+	// and the staging buffers that each chunk of those loops adds new objects
+	// to. These are spliced into the main lists along with the new objects.
+	WorkerPool workers;
+	std::vector<std::vector<Projectile>> chunkProjectiles;
+	std::vector<std::vector<Visual>> chunkVisuals;
+	// The lists that each chunk of the ships, projectiles, or visuals is drawn
+	// into. These are appended to the main draw lists in chunk order.
+	std::vector<DrawList> chunkDraws;
+	std::vector<BatchDrawList> chunkBatches;
 	std::condition_variable condition;
 	std::mutex swapMutex;
 	
@@ -166,6 +228,8 @@ private:
 	bool wasActive = false;
 	DrawList draw[2];
 	BatchDrawList batchDraw[2];
+	// The particles are uploaded to the graphics card when they are drawn.
+	mutable ParticleSystem particles;
 	Radar radar[2];
 	// Viewport position and velocity.
 	Point center;
@@ -177,8 +241,14 @@ private:
 	Point targetUnit;
 	int targetSwizzle = -1;
 	EscortDisplay escorts;
+	// The status overlays for the ships are created by the calculation thread.
+	std::vector<Status> shipStatuses[2];
+	// So are the crosshairs on the minables in range of the flagship's
+	// asteroid scanners.
+	std::vector<Target> minableTargets[2];
 	std::vector<Status> statuses;
 	std::vector<PlanetLabel> labels;
+	PlanetLabel::Placements labelPlacements;
 	std::vector<std::pair<const Outfit *, int>> ammo;
 	int jumpCount = 0;
 	const System *jumpInProgress[2] = {nullptr, nullptr};
@@ -188,13 +258,20 @@ private:
 	
 	int step = 0;
 	
-	std::list<ShipEvent> eventQueue;
-	std::list<ShipEvent> events;
+	// Events generated by the calculation thread, and the ones from the previous
+	// step that are being handed off to the main thread. The two buffers are
+	// swapped every step, so once they have grown big enough for a battle no
+	// more memory needs to be allocated for the events.
+	std::vector<ShipEvent> eventQueue;
+	std::vector<ShipEvent> events;
 	// Keep track of who has asked for help in fighting whom.
 	std::map<const Government *, std::weak_ptr<const Ship>> grudge;
 	int grudgeTime = 0;
 	
 	CollisionSet shipCollisions;
+	CollisionSet flotsamCollisions;
+	// The first ship each projectile will hit this step (if any), and where.
+	std::vector<std::pair<Body *, double>> shipHits;
 	
 	int alarmTime = 0;
 	double flash = 0.;
@@ -207,6 +284,14 @@ private:
 	Command activeCommands;
 	// Keyboard commands that were active in the previous step.
 	Command keyHeld;
+	// The file the player's commands are being recorded to, if any, and the
+	// step that the recording started on.
+	std::unique_ptr<DataWriter> commandLog;
+	int recordStart = -1;
+	// The commands to give the player instead of the keyboard, if any.
+	std::map<int, Command> replayCommands;
+	// The file the checksum of each step is written to, if any.
+	std::unique_ptr<DataWriter> checksumLog;
 	// Pressing "land" rapidly toggles targets; pressing it once re-engages landing.
 	int landKeyInterval = 0;
 	
@@ -226,6 +311,30 @@ private:
 	double load = 0.;
 	int loadCount = 0;
 	double loadSum = 0.;
+	// How the ship collision grid was filled at the end of the last window.
+	CollisionSet::Stats shipGridStats;
+	// Timers for each phase of CalculateStep().
+	Profiler profiler;
+	// Timers for each pass of Draw(), and the recent frame times, which are
+	// only kept track of while the load is being shown.
+	mutable GPUProfiler drawProfiler;
+	mutable std::vector<double> frameTimes;
+	mutable std::vector<double> gpuTimes;
+	mutable size_t frameIndex = 0;
+	mutable std::chrono::steady_clock::time_point lastFrame;
+	
+	// The space scene is drawn into this target instead of onto the screen if
+	// it is being drawn at less than full resolution. If the render scale is
+	// adaptive, it is adjusted based on the recent graphics card frame times.
+	mutable RenderTarget sceneTarget;
+	mutable double renderScale = 1.;
+	mutable double gpuTimeSum = 0.;
+	mutable int gpuTimeCount = 0;
+	
+	// The messages being shown, already wrapped to the width of the message
+	// box, so that each one is only wrapped once instead of every frame.
+	mutable std::map<std::string, WrappedText> wrappedMessages;
+	mutable int wrappedMessageWidth = 0;
 };
 
 
@@ -21,12 +21,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "OutlineShader.h"
 #include "Point.h"
 #include "Rectangle.h"
+#include "Set.h"
 #include "Ship.h"
 #include "Sprite.h"
 #include "System.h"
 
 #include <algorithm>
 #include <set>
+#include <utility>
 
 using namespace std;
 
@@ -38,6 +40,14 @@ namespace {
 	const double BAR_PAD = 5.;
 	const double WIDTH = 120.;
 	const double BAR_WIDTH = WIDTH - ICON_SIZE - 2. * PAD - 2. * BAR_PAD;
+	
+	// The colors of the escort icons, depending on the escort's status.
+	const Set<Color>::Ref ELSEWHERE(GameData::Colors(), "escort elsewhere");
+	const Set<Color>::Ref CANNOT_JUMP(GameData::Colors(), "escort blocked");
+	const Set<Color>::Ref NOT_READY_TO_JUMP(GameData::Colors(), "escort not ready");
+	const Set<Color>::Ref SELECTED(GameData::Colors(), "escort selected");
+	const Set<Color>::Ref HERE(GameData::Colors(), "escort present");
+	const Set<Color>::Ref HOSTILE(GameData::Colors(), "escort hostile");
 }
 
 
@@ -45,13 +55,15 @@ namespace {
 void EscortDisplay::Clear()
 {
 	icons.clear();
+	isStacked = false;
 }
 
 
 
 void EscortDisplay::Add(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected)
 {
-	icons.emplace_back(ship, isHere, fleetIsJumping, isSelected);
+	icons.emplace_back(ship, isHere, fleetIsJumping, isSelected, icons.size());
+	isStacked = false;
 }
 
 
@@ -61,8 +73,7 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 {
 	// Figure out how much space there is for the icons.
 	int maxColumns = max(1., bounds.Width() / WIDTH);
-	MergeStacks(maxColumns * bounds.Height());
-	icons.sort();
+	Stack(maxColumns * bounds.Height());
 	stacks.clear();
 	zones.clear();
 	static const Set<Color> &colors = GameData::Colors();
@@ -71,12 +82,12 @@ void EscortDisplay::Draw(const Rectangle &bounds) const
 	const Font &font = FontSet::Get(14);
 	// Top left corner of the current escort icon.
 	Point corner = Point(bounds.Left(), bounds.Bottom());
-	const Color &elsewhereColor = *colors.Get("escort elsewhere");
-	const Color &cannotJumpColor = *colors.Get("escort blocked");
-	const Color &notReadyToJumpColor = *colors.Get("escort not ready");
-	const Color &selectedColor = *colors.Get("escort selected");
-	const Color &hereColor = *colors.Get("escort present");
-	const Color &hostileColor = *colors.Get("escort hostile");
+	const Color &elsewhereColor = *ELSEWHERE;
+	const Color &cannotJumpColor = *CANNOT_JUMP;
+	const Color &notReadyToJumpColor = *NOT_READY_TO_JUMP;
+	const Color &selectedColor = *SELECTED;
+	const Color &hereColor = *HERE;
+	const Color &hostileColor = *HOSTILE;
 	for(const Icon &escort : icons)
 	{
 		if(!escort.sprite)
@@ -184,7 +195,7 @@ const vector<const Ship *> &EscortDisplay::Click(const Point &point) const
 
 
 
-EscortDisplay::Icon::Icon(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected)
+EscortDisplay::Icon::Icon(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected, size_t index)
 	: sprite(ship.GetSprite()),
 	isHere(isHere && !ship.IsDisabled()),
 	isHostile(ship.GetGovernment() && ship.GetGovernment()->IsEnemy()),
@@ -195,7 +206,8 @@ EscortDisplay::Icon::Icon(const Ship &ship, bool isHere, bool fleetIsJumping, bo
 	system((!isHere && ship.GetSystem()) ? ship.GetSystem()->Name() : ""),
 	low{ship.Shields(), ship.Hull(), ship.Energy(), ship.Heat(), ship.Fuel()},
 	high(low),
-	ships(1, &ship)
+	ships(1, &ship),
+	indices(1, index)
 {
 }
 
@@ -232,6 +244,67 @@ void EscortDisplay::Icon::Merge(const Icon &other)
 		high[i] = max(high[i], other.high[i]);
 	}
 	ships.insert(ships.end(), other.ships.begin(), other.ships.end());
+	indices.insert(indices.end(), other.indices.begin(), other.indices.end());
+}
+
+
+
+EscortDisplay::StackKey::StackKey(const Icon &icon)
+	: sprite(icon.sprite), isHostile(icon.isHostile), cost(icon.cost), system(icon.system)
+{
+}
+
+
+
+bool EscortDisplay::StackKey::operator==(const StackKey &other) const
+{
+	return sprite == other.sprite && isHostile == other.isHostile && cost == other.cost && system == other.system;
+}
+
+
+
+// Merge and sort the icons. The status of each escort changes constantly, but
+// which escorts there are and how they should be stacked rarely does, so if
+// nothing that the stacking depends on has changed, just merge the new icons
+// into the same stacks as last time.
+void EscortDisplay::Stack(int maxHeight) const
+{
+	// The icons may be drawn more than once between updates.
+	if(isStacked && maxHeight == layoutHeight)
+		return;
+	isStacked = true;
+	
+	vector<StackKey> keys;
+	keys.reserve(icons.size());
+	for(const Icon &icon : icons)
+		keys.emplace_back(icon);
+	
+	if(maxHeight == layoutHeight && keys == layoutKeys)
+	{
+		vector<Icon *> added;
+		added.reserve(icons.size());
+		for(Icon &icon : icons)
+			added.push_back(&icon);
+		
+		list<Icon> stacked;
+		for(const vector<size_t> &stack : layout)
+		{
+			stacked.push_back(std::move(*added[stack.front()]));
+			for(size_t i = 1; i < stack.size(); ++i)
+				stacked.back().Merge(*added[stack[i]]);
+		}
+		icons.swap(stacked);
+		return;
+	}
+	
+	MergeStacks(maxHeight);
+	icons.sort();
+	
+	layout.clear();
+	for(const Icon &icon : icons)
+		layout.push_back(icon.indices);
+	layoutKeys.swap(keys);
+	layoutHeight = maxHeight;
 }
 
 
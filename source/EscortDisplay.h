@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Point.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <list>
 #include <string>
@@ -44,7 +45,7 @@ public:
 private:
 	class Icon {
 	public:
-		Icon(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected);
+		Icon(const Ship &ship, bool isHere, bool fleetIsJumping, bool isSelected, std::size_t index);
 		
 		// Sorting operator.
 		bool operator<(const Icon &other) const;
@@ -63,15 +64,40 @@ private:
 		std::vector<double> low;
 		std::vector<double> high;
 		std::vector<const Ship *> ships;
+		// The order in which each of those ships was added to the display.
+		std::vector<std::size_t> indices;
+	};
+	
+	// The properties of an icon that determine how it is stacked and sorted.
+	class StackKey {
+	public:
+		explicit StackKey(const Icon &icon);
+		
+		bool operator==(const StackKey &other) const;
+		
+		const Sprite *sprite;
+		bool isHostile;
+		int64_t cost;
+		std::string system;
 	};
 	
 	
 private:
+	// Merge and sort the icons, reusing the previous stacking if nothing that
+	// it depends on has changed.
+	void Stack(int maxHeight) const;
 	void MergeStacks(int maxHeight) const;
 	
 	
 private:
 	mutable std::list<Icon> icons;
+	// The stacks the icons were merged into the last time they were drawn, as
+	// lists of the order in which their ships were added, along with what
+	// that stacking was based on.
+	mutable std::vector<std::vector<std::size_t>> layout;
+	mutable std::vector<StackKey> layoutKeys;
+	mutable int layoutHeight = -1;
+	mutable bool isStacked = false;
 	mutable std::vector<std::vector<const Ship *>> stacks;
 	mutable std::vector<Point> zones;
 };
@@ -12,6 +12,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 
+#include "Archive.h"
 #include "File.h"
 
 #include <SDL2/SDL.h>
@@ -23,7 +24,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <sys/stat.h>
 #include <dirent.h>
 #include <unistd.h>
+#include <zlib.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -44,6 +47,48 @@ namespace {
 	mutex errorMutex;
 	File errorLog;
 	
+	// Compressed files are gzip streams, which can be recognized by the first
+	// two bytes. Plain text data files never start with those.
+	bool IsCompressed(const string &data)
+	{
+		return data.size() >= 2 && static_cast<unsigned char>(data[0]) == 0x1f
+			&& static_cast<unsigned char>(data[1]) == 0x8b;
+	}
+	
+	// Decompress the given gzip stream. If it is not valid, whatever part of it
+	// could be decompressed is returned.
+	string Inflate(const string &data)
+	{
+		string result;
+		z_stream stream = {};
+		// Adding 16 to the window bits tells zlib to expect a gzip header.
+		if(inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+			return result;
+		
+		stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+		stream.avail_in = data.size();
+		// Text usually compresses by a factor of about four to ten. Reserve one
+		// extra byte for the newline that DataFile appends.
+		result.reserve(data.size() * 8 + 1);
+		int status = Z_OK;
+		while(status == Z_OK)
+		{
+			size_t size = result.size();
+			result.resize(max<size_t>(size * 2, 1 << 16));
+			stream.next_out = reinterpret_cast<Bytef *>(&result[size]);
+			stream.avail_out = result.size() - size;
+			status = inflate(&stream, Z_NO_FLUSH);
+			result.resize(result.size() - stream.avail_out);
+		}
+		inflateEnd(&stream);
+		// Allow any number of gzip members, like the gzip tool does.
+		if(status == Z_STREAM_END && stream.avail_in)
+			result += Inflate(data.substr(data.size() - stream.avail_in));
+		else if(status != Z_STREAM_END)
+			Files::LogError("Error: compressed file is damaged or incomplete.");
+		return result;
+	}
+	
 	// Convert windows-style directory separators ('\\') to standard '/'.
 #if defined _WIN32
 	void FixWindowsSlashes(string &path)
@@ -345,6 +390,19 @@ vector<string> Files::RecursiveList(const string &directory)
 {
 	vector<string> list;
 	RecursiveList(directory, &list);
+	
+	// Also include any files in this directory that are in an archive, unless
+	// there is a loose copy of them too.
+	vector<string> archived;
+	Archive::List(directory.empty() || directory.back() == '/' ? directory : directory + '/', &archived);
+	if(!archived.empty())
+	{
+		sort(list.begin(), list.end());
+		size_t looseCount = list.size();
+		for(const string &path : archived)
+			if(!binary_search(list.begin(), list.begin() + looseCount, path))
+				list.push_back(path);
+	}
 	return list;
 }
 
@@ -408,6 +466,8 @@ void Files::RecursiveList(string directory, vector<string> *list)
 
 bool Files::Exists(const string &filePath)
 {
+	if(Archive::Find(filePath))
+		return true;
 #if defined _WIN32
 	struct _stat buf;
 	return !_wstat(ToUTF16(filePath).c_str(), &buf);
@@ -421,6 +481,10 @@ bool Files::Exists(const string &filePath)
 
 time_t Files::Timestamp(const string &filePath)
 {
+	// Files in an archive are as old as the archive itself.
+	time_t timestamp = 0;
+	if(Archive::Find(filePath, nullptr, &timestamp))
+		return timestamp;
 #if defined _WIN32
 	struct _stat buf;
 	_wstat(ToUTF16(filePath).c_str(), &buf);
@@ -433,6 +497,25 @@ time_t Files::Timestamp(const string &filePath)
 
 
 
+long long Files::Size(const string &filePath)
+{
+	long long size = 0;
+	if(Archive::Find(filePath, &size))
+		return size;
+#if defined _WIN32
+	struct _stat buf;
+	if(_wstat(ToUTF16(filePath).c_str(), &buf))
+		return -1;
+#else
+	struct stat buf;
+	if(stat(filePath.c_str(), &buf))
+		return -1;
+#endif
+	return buf.st_size;
+}
+
+
+
 void Files::Copy(const string &from, const string &to)
 {
 #if defined _WIN32
@@ -478,6 +561,12 @@ string Files::Name(const string &path)
 
 FILE *Files::Open(const string &path, bool write)
 {
+	if(!write)
+	{
+		FILE *file = Archive::Open(path);
+		if(file)
+			return file;
+	}
 #if defined _WIN32
 	return _wfopen(ToUTF16(path).c_str(), write ? L"w" : L"rb");
 #else
@@ -490,6 +579,15 @@ FILE *Files::Open(const string &path, bool write)
 string Files::Read(const string &path)
 {
 	File file(path);
+	// A file in an archive ends where its contents do, not where the archive does.
+	long long size = 0;
+	if(file && Archive::Find(path, &size))
+	{
+		string result(size, '\0');
+		if(fread(&result[0], 1, result.size(), file) != result.size())
+			throw runtime_error("Error reading file!");
+		return result;
+	}
 	return Read(file);
 }
 
@@ -516,6 +614,9 @@ string Files::Read(FILE *file)
 	if(bytes != result.size())
 		throw runtime_error("Error reading file!");
 	
+	// Compressed files are decompressed transparently.
+	if(IsCompressed(result))
+		return Inflate(result);
 	return result;
 }
 
@@ -539,6 +640,48 @@ void Files::Write(FILE *file, const string &data)
 
 
 
+// Write the given data to a gzip-compressed file, which Read() will decompress.
+// Returns false if the file could not be written in its entirety.
+bool Files::WriteCompressed(const string &path, const string &data)
+{
+	File file(path, true);
+	if(!file)
+		return false;
+	
+	z_stream stream = {};
+	if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return false;
+	
+	// Compress the data in chunks, writing each one to the file as it is done.
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+	stream.avail_in = data.size();
+	static const size_t CHUNK = 1 << 16;
+	vector<Bytef> buffer(CHUNK);
+	bool success = true;
+	int status = Z_OK;
+	while(status == Z_OK && success)
+	{
+		stream.next_out = buffer.data();
+		stream.avail_out = CHUNK;
+		status = deflate(&stream, Z_FINISH);
+		size_t size = CHUNK - stream.avail_out;
+		success = (fwrite(buffer.data(), 1, size, file) == size);
+	}
+	deflateEnd(&stream);
+	return success && status == Z_STREAM_END;
+}
+
+
+
+// Copy a file, compressing the copy if the original was not compressed already.
+bool Files::CopyCompressed(const string &from, const string &to)
+{
+	string data = Read(from);
+	return !data.empty() && WriteCompressed(to, data);
+}
+
+
+
 void Files::LogError(const string &message)
 {
 	lock_guard<mutex> lock(errorMutex);
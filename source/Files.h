@@ -49,6 +49,7 @@ public:
 	
 	static bool Exists(const std::string &filePath);
 	static std::time_t Timestamp(const std::string &filePath);
+	static long long Size(const std::string &filePath);
 	static void Copy(const std::string &from, const std::string &to);
 	static void Move(const std::string &from, const std::string &to);
 	static void Delete(const std::string &filePath);
@@ -62,6 +63,12 @@ public:
 	static std::string Read(FILE *file);
 	static void Write(const std::string &path, const std::string &data);
 	static void Write(FILE *file, const std::string &data);
+	// Write a compressed file. Read() recognizes these files and decompresses
+	// them automatically. Returns false if writing the file failed.
+	static bool WriteCompressed(const std::string &path, const std::string &data);
+	// Copy a file, compressing the copy if the original was not compressed
+	// already. Returns false if the copy could not be written.
+	static bool CopyCompressed(const std::string &from, const std::string &to);
 	
 	static void LogError(const std::string &message);
 };
@@ -409,13 +409,29 @@ void Fleet::Enter(const System &system, list<shared_ptr<Ship>> &ships, const Pla
 // Place one of the variants in the given system, already "in action." If the carried flag is set,
 // only uncarried ships will be added to the list (as any carriables will be stored in bays).
 void Fleet::Place(const System &system, list<shared_ptr<Ship>> &ships, bool carried) const
+{
+	Place(system, ships, Instantiate(), carried);
+}
+
+
+
+// Choose a variant of this fleet and create its ships, but do not place them in
+// any system. This changes nothing but the new ships, so it is safe to do in a
+// background thread. Then, the ships can be placed in the main thread.
+vector<shared_ptr<Ship>> Fleet::Instantiate() const
 {
 	if(!total || variants.empty())
-		return;
+		return vector<shared_ptr<Ship>>();
 	
 	// Pick a fleet variant to instantiate.
-	const Variant &variant = ChooseVariant();
-	if(variant.ships.empty())
+	return Instantiate(ChooseVariant());
+}
+
+
+
+void Fleet::Place(const System &system, list<shared_ptr<Ship>> &ships, vector<shared_ptr<Ship>> placed, bool carried) const
+{
+	if(placed.empty())
 		return;
 	
 	// Determine where the fleet is going to or coming from.
@@ -423,7 +439,6 @@ void Fleet::Place(const System &system, list<shared_ptr<Ship>> &ships, bool carr
 	
 	// Place all the ships in the chosen fleet variant.
 	shared_ptr<Ship> flagship;
-	vector<shared_ptr<Ship>> placed = Instantiate(variant);
 	for(shared_ptr<Ship> &ship : placed)
 	{
 		// If this is a fighter and someone can carry it, no need to position it.
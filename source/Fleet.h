@@ -55,6 +55,12 @@ public:
 	// Place a fleet in the given system, already "in action." If the carried flag is set, only
 	// uncarried ships will be added to the list (as any carriables will be stored in bays).
 	void Place(const System &system, std::list<std::shared_ptr<Ship>> &ships, bool carried = true) const;
+	// Choose a variant of this fleet and create its ships, but do not place them
+	// in any system. This changes nothing but the new ships, so it is safe to do
+	// in a background thread. Then, the ships can be placed in the main thread.
+	std::vector<std::shared_ptr<Ship>> Instantiate() const;
+	void Place(const System &system, std::list<std::shared_ptr<Ship>> &ships,
+		std::vector<std::shared_ptr<Ship>> placed, bool carried = true) const;
 	
 	// Do the randomization to make a ship enter or be in the given system.
 	// Return the system that was chosen for the ship to enter from.
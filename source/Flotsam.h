@@ -17,6 +17,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Body.h"
 #include "Point.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,11 +28,15 @@ class Visual;
 
 
 
-class Flotsam : public Body {
+class Flotsam : public Body, public std::enable_shared_from_this<Flotsam> {
 public:
 	// Constructors for flotsam carrying either a commodity or an outfit.
 	Flotsam(const std::string &commodity, int count);
 	Flotsam(const Outfit *outfit, int count);
+	// Create flotsam whose memory is recycled from flotsam that has already
+	// been destroyed, if possible.
+	static std::shared_ptr<Flotsam> Create(const std::string &commodity, int count);
+	static std::shared_ptr<Flotsam> Create(const Outfit *outfit, int count);
 	
 	/* Functions provided by the Body base class:
 	Frame GetFrame(int step = -1) const;
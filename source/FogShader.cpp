@@ -23,6 +23,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 using namespace std;
@@ -43,18 +44,104 @@ namespace {
 	Shader shader;
 	GLuint cornerI;
 	GLuint dimensionsI;
+	GLuint texCornerI;
+	GLuint texDimensionsI;
 	GLuint vao;
 	GLuint vbo;
 	GLuint texture = 0;
 	
-	// Keep track of the previous frame's view so that if it is unchanged we can
-	// skip regenerating the mask.
-	double previousZoom = 0.;
-	double previousLeft = 0.;
-	double previousTop = 0.;
-	int previousColumns = 0;
-	int previousRows = 0;
-	Point previousCenter;
+	// The mask covers every system the player has visited, in map coordinates,
+	// so it only needs to be regenerated when what the player has visited
+	// changes, not whenever the map view moves. This is the map position of
+	// the center of its top left pixel, and its size in pixels.
+	Point origin;
+	int columns = 0;
+	int rows = 0;
+	// Keep track of which player and which map revision the mask was made for.
+	const PlayerInfo *previousPlayer = nullptr;
+	int previousRevision = 0;
+	bool shouldRegenerate = true;
+	
+	
+	
+	// Generate the mask image for all the systems the given player has visited.
+	void Regenerate(const PlayerInfo &player)
+	{
+		// Find the grid positions of all the systems the player knows about.
+		vector<pair<int, int>> visited;
+		double minX = 0.;
+		double minY = 0.;
+		double maxX = 0.;
+		double maxY = 0.;
+		for(const auto &it : GameData::Systems())
+		{
+			const System &system = it.second;
+			if(system.Name().empty() || !player.HasVisited(&system))
+				continue;
+			const Point &pos = system.Position();
+			if(visited.empty())
+			{
+				minX = maxX = pos.X();
+				minY = maxY = pos.Y();
+			}
+			minX = min(minX, pos.X());
+			minY = min(minY, pos.Y());
+			maxX = max(maxX, pos.X());
+			maxY = max(maxY, pos.Y());
+			visited.emplace_back(round(pos.X() / GRID), round(pos.Y() / GRID));
+		}
+		
+		// Pad beyond the systems enough that the edges of the mask are entirely
+		// fogged, so anything beyond them can be drawn using the edge pixels.
+		int left = round(minX / GRID) - PAD - 1;
+		int top = round(minY / GRID) - PAD - 1;
+		columns = visited.empty() ? 1 : round(maxX / GRID) + PAD + 2 - left;
+		rows = visited.empty() ? 1 : round(maxY / GRID) + PAD + 2 - top;
+		// Round up to a multiple of 4 so the rows will be 32-bit aligned.
+		columns = (columns + 3) & ~3;
+		origin = Point(left * GRID, top * GRID);
+		
+		// This buffer will hold the mask image. For each system the player
+		// knows about, its "distance" pixel in the buffer should be set to 0.
+		vector<unsigned char> buffer(rows * columns, LIMIT);
+		for(const pair<int, int> &it : visited)
+			buffer[(it.first - left) + (it.second - top) * columns] = 0;
+		
+		// Distance transformation: make two passes through the buffer. In the first
+		// pass, propagate down and to the right. In the second, propagate in the
+		// opposite direction. Once these two passes are done, each value is equal
+		for(int y = 1; y < rows; ++y)
+			for(int x = 1; x < columns - 1; ++x)
+				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
+					ORTH + min(buffer[(x - 1) + y * columns], buffer[x + (y - 1) * columns]),
+					DIAG + min(buffer[(x - 1) + (y - 1) * columns], buffer[(x + 1) + (y - 1) * columns])));
+		for(int y = rows - 2; y >= 0; --y)
+			for(int x = columns - 2; x >= 1; --x)
+				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
+					ORTH + min(buffer[(x + 1) + y * columns], buffer[x + (y + 1) * columns]),
+					DIAG + min(buffer[(x - 1) + (y + 1) * columns], buffer[(x + 1) + (y + 1) * columns])));
+		
+		// Strech the distance values so there is no shading up to about 200 pixels
+		// away, then it transitions somewhat quickly.
+		for(unsigned char &value : buffer)
+			value = max(0, min(LIMIT, (value - 60) * 4));
+		
+		// Set up the OpenGL texture if it doesn't exist yet.
+		if(!texture)
+		{
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+		else
+			glBindTexture(GL_TEXTURE_2D, texture);
+		
+		// Upload the new "image."
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, columns, rows, 0, GL_RED, GL_UNSIGNED_BYTE, &buffer.front());
+	}
 }
 
 
@@ -64,13 +151,15 @@ void FogShader::Init()
 	static const char *vertexCode =
 		"uniform vec2 corner;\n"
 		"uniform vec2 dimensions;\n"
+		"uniform vec2 texCorner;\n"
+		"uniform vec2 texDimensions;\n"
 		
 		"in vec2 vert;\n"
 		"out vec2 fragTexCoord;\n"
 		
 		"void main() {\n"
 		"  gl_Position = vec4(corner + vert * dimensions, 0, 1);\n"
-		"  fragTexCoord = vert;\n"
+		"  fragTexCoord = texCorner + vert * texDimensions;\n"
 		"}\n";
 
 	static const char *fragmentCode =
@@ -87,6 +176,8 @@ void FogShader::Init()
 	shader = Shader(vertexCode, fragmentCode);
 	cornerI = shader.Uniform("corner");
 	dimensionsI = shader.Uniform("dimensions");
+	texCornerI = shader.Uniform("texCorner");
+	texDimensionsI = shader.Uniform("texDimensions");
 	
 	glUseProgram(shader.Object());
 	glUniform1i(shader.Uniform("tex"), 0);
@@ -121,102 +212,21 @@ void FogShader::Init()
 
 void FogShader::Redraw()
 {
-	previousZoom = 0.;
+	shouldRegenerate = true;
 }
 
 
 
 void FogShader::Draw(const Point &center, double zoom, const PlayerInfo &player)
 {
-	// Generate a scaled-down mask image that represents the entire screen plus
-	// enough pixels beyond the screen to include any systems that may be off
-	// screen but close enough to "illuminate" part of the on-screen map.
-	double left = Screen::Left() - GRID * PAD * zoom + fmod(center.X(), GRID) * zoom;
-	double top = Screen::Top() - GRID * PAD * zoom + fmod(center.Y(), GRID) * zoom;
-	int columns = ceil(Screen::Width() / (GRID * zoom)) + 1 + 2 * PAD;
-	int rows = ceil(Screen::Height() / (GRID * zoom)) + 1 + 2 * PAD;
-	// Round up to a multiple of 4 so the rows will be 32-bit aligned.
-	columns = (columns + 3) & ~3;
-	
-	// To avoid extra work, don't regenerate the mask buffer if the view has not
-	// moved. This might cause an inaccurate mask if you explore more systems,
-	// come back to the original, and view the map again without viewing it in
-	// between. But, that's an unlikely situation.
-	bool shouldRegenerate = (
-		zoom != previousZoom || center.X() != previousCenter.X() || center.Y() != previousCenter.Y() ||
-		left != previousLeft || top != previousTop || columns != previousColumns || rows != previousRows);
-	if(shouldRegenerate)
+	// The mask covers the whole galaxy, so it only has to be regenerated if
+	// the systems the player has visited might have changed.
+	if(shouldRegenerate || &player != previousPlayer || player.MapRevision() != previousRevision)
 	{
-		bool sizeChanged = (!texture || columns != previousColumns || rows != previousRows);
-		
-		// Remember the current viewport attributes.
-		previousZoom = zoom;
-		previousCenter = center;
-		previousLeft = left;
-		previousTop = top;
-		previousColumns = columns;
-		previousRows = rows;
-		
-		// This buffer will hold the mask image.
-		vector<unsigned char> buffer(rows * columns, LIMIT);
-	
-		// For each system the player knows about, its "distance" pixel in the
-		// buffer should be set to 0.
-		for(const auto &it : GameData::Systems())
-		{
-			const System &system = it.second;
-			if(system.Name().empty() || !player.HasVisited(&system))
-				continue;
-			Point pos = zoom * (system.Position() + center);
-		
-			int x = round((pos.X() - left) / (GRID * zoom));
-			int y = round((pos.Y() - top) / (GRID * zoom));
-			if(x >= 0 && y >= 0 && x < columns && y < rows)
-				buffer[x + y * columns] = 0;
-		}
-	
-		// Distance transformation: make two passes through the buffer. In the first
-		// pass, propagate down and to the right. In the second, propagate in the
-		// opposite direction. Once these two passes are done, each value is equal
-		for(int y = 1; y < rows; ++y)
-			for(int x = 1; x < columns; ++x)
-				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
-					ORTH + min(buffer[(x - 1) + y * columns], buffer[x + (y - 1) * columns]),
-					DIAG + min(buffer[(x - 1) + (y - 1) * columns], buffer[(x + 1) + (y - 1) * columns])));
-		for(int y = rows - 2; y >= 0; --y)
-			for(int x = columns - 2; x >= 0; --x)
-				buffer[x + y * columns] = min<int>(buffer[x + y * columns], min(
-					ORTH + min(buffer[(x + 1) + y * columns], buffer[x + (y + 1) * columns]),
-					DIAG + min(buffer[(x - 1) + (y + 1) * columns], buffer[(x + 1) + (y + 1) * columns])));
-	
-		// Strech the distance values so there is no shading up to about 200 pixels
-		// away, then it transitions somewhat quickly.
-		for(unsigned char &value : buffer)
-			value = max(0, min(LIMIT, (value - 60) * 4));
-		const void *data = &buffer.front();
-		
-		// Set up the OpenGL texture if it doesn't exist yet.
-		if(sizeChanged)
-		{
-			// If the texture size changed, it must be reallocated.
-			if(texture)
-				glDeleteTextures(1, &texture);
-			
-			glGenTextures(1, &texture);
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-			
-			// Upload the new "image."
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, columns, rows, 0, GL_RED, GL_UNSIGNED_BYTE, data);
-		}
-		else
-		{
-			glBindTexture(GL_TEXTURE_2D, texture);
-			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, columns, rows, GL_RED, GL_UNSIGNED_BYTE, data);
-		}
+		shouldRegenerate = false;
+		previousPlayer = &player;
+		previousRevision = player.MapRevision();
+		Regenerate(player);
 	}
 	else
 		glBindTexture(GL_TEXTURE_2D, texture);
@@ -225,15 +235,25 @@ void FogShader::Draw(const Point &center, double zoom, const PlayerInfo &player)
 	glUseProgram(shader.Object());
 	glBindVertexArray(vao);
 	
-	GLfloat corner[2] = {
-		static_cast<float>(left - .5 * GRID * zoom) / (.5f * Screen::Width()),
-		static_cast<float>(top - .5 * GRID * zoom) / (-.5f * Screen::Height())};
+	// Cover the whole screen. Anything beyond the edges of the mask is drawn
+	// using the edge pixels, which are fully fogged.
+	GLfloat corner[2] = {-1.f, 1.f};
 	glUniform2fv(cornerI, 1, corner);
-	GLfloat dimensions[2] = {
-		GRID * static_cast<float>(zoom) * (columns + 1.f) / (.5f * Screen::Width()),
-		GRID * static_cast<float>(zoom) * (rows + 1.f) / (-.5f * Screen::Height())};
+	GLfloat dimensions[2] = {2.f, -2.f};
 	glUniform2fv(dimensionsI, 1, dimensions);
 	
+	// Find which part of the mask is on screen. The center of each pixel is
+	// at the map position of the grid cell it represents.
+	Point topLeft = Screen::TopLeft() / zoom - center - origin;
+	GLfloat texCorner[2] = {
+		static_cast<float>((topLeft.X() / GRID + .5) / columns),
+		static_cast<float>((topLeft.Y() / GRID + .5) / rows)};
+	glUniform2fv(texCornerI, 1, texCorner);
+	GLfloat texDimensions[2] = {
+		static_cast<float>(Screen::Width() / (zoom * GRID * columns)),
+		static_cast<float>(Screen::Height() / (zoom * GRID * rows))};
+	glUniform2fv(texDimensionsI, 1, texDimensions);
+	
 	// Call the shader program to draw the image.
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	
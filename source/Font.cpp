@@ -15,10 +15,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Color.h"
 #include "ImageBuffer.h"
 #include "Point.h"
+#include "Preferences.h"
 #include "Screen.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+
+#include "gl_header.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 
@@ -30,30 +36,30 @@ namespace {
 	const char *vertexCode =
 		// "scale" maps pixel coordinates to GL coordinates (-1 to 1).
 		"uniform vec2 scale;\n"
-		// The (x, y) coordinates of the top left corner of the glyph.
+		// The (x, y) coordinates of the start of the text.
 		"uniform vec2 position;\n"
-		// The glyph to draw. (ASCII value - 32).
-		"uniform int glyph;\n"
-		// Aspect ratio of rendered glyph (unity by default).
-		"uniform float aspect = 1.f;\n"
 		
-		// Inputs from the VBO.
+		// The shared texture, whose size may change as fonts are added to it.
+		"uniform sampler2D tex;\n"
+		
+		// Inputs from the VBO: the position of each glyph corner relative to
+		// the start of the text, and its coordinates in the texture in texels.
 		"in vec2 vert;\n"
 		"in vec2 corner;\n"
 		
 		// Output to the fragment shader.
 		"out vec2 texCoord;\n"
 		
-		// Pick the proper glyph out of the texture.
 		"void main() {\n"
-		"  texCoord = vec2((glyph + corner.x) / 98.f, corner.y);\n"
-		"  gl_Position = vec4((aspect * vert.x + position.x) * scale.x, (vert.y + position.y) * scale.y, 0, 1);\n"
+		"  texCoord = corner / vec2(textureSize(tex, 0));\n"
+		"  gl_Position = vec4((vert + position) * scale, 0, 1);\n"
 		"}\n";
 	
 	const char *fragmentCode =
 		// The user must supply a texture and a color (white by default).
 		"uniform sampler2D tex;\n"
 		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
+		"uniform int useDistance;\n"
 		
 		// This comes from the vertex shader.
 		"in vec2 texCoord;\n"
@@ -61,19 +67,96 @@ namespace {
 		// Output color.
 		"out vec4 finalColor;\n"
 		
-		// Multiply the texture by the user-specified color (including alpha).
+		// Multiply the coverage by the user-specified color (including alpha).
+		// The edge of the glyph is where the distance is one half, and it is
+		// blurred over about one pixel at whatever scale the text is drawn.
 		"void main() {\n"
-		"  finalColor = texture(tex, texCoord).a * color;\n"
+		"  vec2 value = texture(tex, texCoord).rg;\n"
+		"  float alpha = value.r;\n"
+		"  if(useDistance != 0) {\n"
+		"    float width = .7 * fwidth(value.g);\n"
+		"    alpha = smoothstep(.5 - width, .5 + width, value.g);\n"
+		"  }\n"
+		"  finalColor = alpha * color;\n"
 		"}\n";
 	
+	Shader shader;
+	GLint colorI;
+	GLint scaleI;
+	GLint positionI;
+	GLint useDistanceI;
+	GLint vertI;
+	GLint cornerI;
+	GLuint vao = 0;
+	int screenWidth = 0;
+	int screenHeight = 0;
+	
+	// The texture that all the fonts' glyphs are in, one font below the other,
+	// and a copy of it in memory, so that it can be uploaded again with each
+	// font that is added. Each texel is a glyph's coverage and distance field.
+	GLuint texture = 0;
+	vector<uint8_t> atlas;
+	int atlasWidth = 0;
+	int atlasHeight = 0;
+	// Leave this many empty rows between fonts, so none bleeds into another.
+	const int ATLAS_PADDING = 2;
+	// Distances up to this many texels from the edge of a glyph are stored.
+	const int DISTANCE_RANGE = 4;
+	
 	const int KERN = 2;
+	// Each glyph is drawn as two triangles, with four values per vertex.
+	const int GLYPH_SIZE = 6 * 4;
+	// Don't let the cache of string layouts grow without bound; strings that
+	// change every frame (e.g. timers) would otherwise keep adding to it.
+	const size_t MAX_LAYOUTS = 2000;
+	
+	// Add the two triangles for one glyph to the given vertex array. The
+	// texture coordinates are given in texels.
+	void PushGlyph(vector<float> &v, float x, float y, float width, float height,
+		float s0, float s1, float t0, float t1)
+	{
+		const float corners[GLYPH_SIZE] = {
+			x, y, s0, t0,
+			x, y + height, s0, t1,
+			x + width, y, s1, t0,
+			x + width, y, s1, t0,
+			x, y + height, s0, t1,
+			x + width, y + height, s1, t1
+		};
+		v.insert(v.end(), corners, corners + GLYPH_SIZE);
+	}
+	
+	// Compile the shader that all the fonts share.
+	void SetUpShader()
+	{
+		shader = Shader(vertexCode, fragmentCode);
+		glUseProgram(shader.Object());
+		glUniform1i(shader.Uniform("tex"), 0);
+		glUseProgram(0);
+		
+		// Create the VAO. The glyph vertices are uploaded into the StreamBuffer
+		// each time some text is drawn, so just enable the vertex arrays here.
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		
+		vertI = shader.Attrib("vert");
+		cornerI = shader.Attrib("corner");
+		glEnableVertexAttribArray(vertI);
+		glEnableVertexAttribArray(cornerI);
+		
+		glBindVertexArray(0);
+		
+		colorI = shader.Uniform("color");
+		scaleI = shader.Uniform("scale");
+		positionI = shader.Uniform("position");
+		useDistanceI = shader.Uniform("useDistance");
+	}
 }
 
 
 
 Font::Font()
-	: texture(0), vao(0), vbo(0), colorI(0), scaleI(0), glyphI(0), aspectI(0),
-	  positionI(0), height(0), space(0), screenWidth(0), screenHeight(0)
+	: glyphWidth(0.f), glyphHeight(0.f), cellWidth(0.f), top(0.f), bottom(0.f), height(0), space(0)
 {
 }
 
@@ -94,9 +177,13 @@ void Font::Load(const string &imagePath)
 	if(!image.Read(imagePath))
 		return;
 	
-	LoadTexture(image);
+	if(!shader.Object())
+		SetUpShader();
+	AddToAtlas(image);
 	CalculateAdvances(image);
-	SetUpShader(image.Width() / GLYPHS, image.Height());
+	
+	glyphWidth = cellWidth * .5f;
+	glyphHeight = (bottom - top) * .5f;
 }
 
 
@@ -110,31 +197,38 @@ void Font::Draw(const string &str, const Point &point, const Color &color) const
 
 void Font::DrawAliased(const string &str, double x, double y, const Color &color) const
 {
-	glUseProgram(shader.Object());
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glBindVertexArray(vao);
-	
-	glUniform4fv(colorI, 1, color.Get());
-	
-	// Update the scale, only if the screen size has changed.
-	if(Screen::Width() != screenWidth || Screen::Height() != screenHeight)
+	// Laying out the text is much more work than drawing it, and most text is
+	// drawn over and over again, so remember how each string was laid out.
+	if(layoutUnderlines != showUnderlines || layouts.size() >= MAX_LAYOUTS)
 	{
-		screenWidth = Screen::Width();
-		screenHeight = Screen::Height();
-		GLfloat scale[2] = {2.f / screenWidth, -2.f / screenHeight};
-		glUniform2fv(scaleI, 1, scale);
+		layouts.clear();
+		layoutUnderlines = showUnderlines;
+	}
+	auto it = layouts.find(str);
+	if(it == layouts.end())
+	{
+		it = layouts.emplace(str, vector<float>()).first;
+		Layout(str.c_str(), 0.f, 0.f, it->second);
 	}
 	
-	GLfloat textPos[2] = {
-		static_cast<float>(x - 1.),
-		static_cast<float>(y)};
+	DrawLayout(it->second, x, y, color);
+}
+
+
+
+// Add the glyphs for the given string to the given vertex array, with the
+// start of the string at the given position.
+void Font::Layout(const char *str, float x, float y, vector<float> &vertices) const
+{
+	x -= 1.f;
 	int previous = 0;
 	bool isAfterSpace = true;
 	bool underlineChar = false;
 	const int underscoreGlyph = max(0, min(GLYPHS - 1, '_' - 32));
 	
-	for(char c : str)
+	for( ; *str; ++str)
 	{
+		char c = *str;
 		if(c == '_')
 		{
 			underlineChar = showUnderlines;
@@ -146,33 +240,64 @@ void Font::DrawAliased(const string &str, double x, double y, const Color &color
 			isAfterSpace = !glyph;
 		if(!glyph)
 		{
-			textPos[0] += space;
+			x += space;
 			continue;
 		}
 		
-		glUniform1i(glyphI, glyph);
-		glUniform1f(aspectI, 1.f);
-		
-		textPos[0] += advance[previous * GLYPHS + glyph] + KERN;
-		glUniform2fv(positionI, 1, textPos);
-		
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		x += advance[previous * GLYPHS + glyph] + KERN;
+		PushGlyph(vertices, x, y, glyphWidth, glyphHeight,
+			glyph * cellWidth, (glyph + 1) * cellWidth, top, bottom);
 		
+		// The underline is stretched to cover the full width of this glyph.
 		if(underlineChar)
 		{
-			glUniform1i(glyphI, underscoreGlyph);
-			glUniform1f(aspectI, static_cast<float>(advance[glyph * GLYPHS] + KERN)
-				/ (advance[underscoreGlyph * GLYPHS] + KERN));
-			
-			glUniform2fv(positionI, 1, textPos);
-			
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			float aspect = static_cast<float>(advance[glyph * GLYPHS] + KERN)
+				/ (advance[underscoreGlyph * GLYPHS] + KERN);
+			PushGlyph(vertices, x, y, aspect * glyphWidth, glyphHeight,
+				underscoreGlyph * cellWidth, (underscoreGlyph + 1) * cellWidth, top, bottom);
 			underlineChar = false;
 		}
 		
 		previous = glyph;
 	}
+}
+
+
+
+// Draw glyphs that were laid out by Layout(), offset by the given position.
+// They are all drawn with a single call.
+void Font::DrawLayout(const vector<float> &vertices, double x, double y, const Color &color) const
+{
+	if(vertices.empty())
+		return;
+	
+	glUseProgram(shader.Object());
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(vao);
+	
+	glUniform4fv(colorI, 1, color.Get());
+	glUniform1i(useDistanceI, Preferences::Has(Preferences::SHARP_TEXT));
+	
+	// Update the scale, only if the screen size has changed.
+	if(Screen::Width() != screenWidth || Screen::Height() != screenHeight)
+	{
+		screenWidth = Screen::Width();
+		screenHeight = Screen::Height();
+		GLfloat scale[2] = {2.f / screenWidth, -2.f / screenHeight};
+		glUniform2fv(scaleI, 1, scale);
+	}
+	
+	GLfloat textPos[2] = {static_cast<float>(x), static_cast<float>(y)};
+	glUniform2fv(positionI, 1, textPos);
 	
+	const char *offset = reinterpret_cast<const char *>(
+		StreamBuffer::Upload(vertices.data(), sizeof(float) * vertices.size()));
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), offset);
+	glVertexAttribPointer(cornerI, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), offset + 2 * sizeof(GLfloat));
+	
+	glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 4);
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
@@ -344,6 +469,13 @@ void Font::ShowUnderlines(bool show)
 
 
 
+bool Font::IsShowingUnderlines()
+{
+	return showUnderlines;
+}
+
+
+
 int Font::Glyph(char c, bool isAfterSpace)
 {
 	// Curly quotes.
@@ -357,18 +489,84 @@ int Font::Glyph(char c, bool isAfterSpace)
 
 
 
-void Font::LoadTexture(ImageBuffer &image)
+// Add the given font image to the texture that all the fonts share, below the
+// fonts that are already in it, and work out its distance field.
+void Font::AddToAtlas(ImageBuffer &image)
 {
-	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
+	const int width = image.Width();
+	const int rows = image.Height();
+	cellWidth = width / GLYPHS;
+	
+	// Make room for this font, keeping each row an even number of texels so
+	// that its length in bytes is a multiple of four.
+	const int newWidth = max(atlasWidth, width + (width & 1));
+	const int firstRow = atlasHeight ? atlasHeight + ATLAS_PADDING : 0;
+	vector<uint8_t> newAtlas(2 * newWidth * (firstRow + rows), 0);
+	for(int y = 0; y < atlasHeight; ++y)
+		copy(atlas.begin() + 2 * atlasWidth * y, atlas.begin() + 2 * atlasWidth * (y + 1),
+			newAtlas.begin() + 2 * newWidth * y);
+	atlas.swap(newAtlas);
+	atlasWidth = newWidth;
+	atlasHeight = firstRow + rows;
+	top = firstRow;
+	bottom = firstRow + rows;
+	
+	// Each texel's distance from the edge of the glyph is found by looking for
+	// the nearest texel on the other side of it, without going into the next
+	// glyph. The texels right at the edge are partly covered, so the coverage
+	// of each texel places the edge more precisely than that.
+	const uint32_t *pixels = image.Pixels();
+	auto Coverage = [pixels, width](int x, int y) -> int
+	{
+		return pixels[x + y * width] >> 24;
+	};
+	for(int y = 0; y < rows; ++y)
+		for(int x = 0; x < width; ++x)
+		{
+			const int coverage = Coverage(x, y);
+			const bool isInside = (coverage >= 128);
+			const int cellStart = x - x % static_cast<int>(cellWidth);
+			const int cellEnd = cellStart + static_cast<int>(cellWidth);
+			
+			int nearest = DISTANCE_RANGE * DISTANCE_RANGE + 1;
+			for(int dy = -DISTANCE_RANGE; dy <= DISTANCE_RANGE; ++dy)
+				for(int dx = -DISTANCE_RANGE; dx <= DISTANCE_RANGE; ++dx)
+				{
+					int sx = x + dx;
+					int sy = y + dy;
+					int squared = dx * dx + dy * dy;
+					// Anything past the edge of the glyph's cell is empty.
+					bool isOtherInside = (sx >= cellStart && sx < cellEnd && sy >= 0 && sy < rows
+						&& Coverage(sx, sy) >= 128);
+					if(isOtherInside != isInside && squared < nearest)
+						nearest = squared;
+				}
+			float distance = sqrt(static_cast<float>(nearest)) - 1.f;
+			distance += isInside ? coverage / 255.f - .5f : .5f - coverage / 255.f;
+			if(!isInside)
+				distance = -distance;
+			distance = max(-1.f, min(1.f, distance / DISTANCE_RANGE));
+			
+			uint8_t *texel = &atlas[2 * (x + (firstRow + y) * atlasWidth)];
+			texel[0] = coverage;
+			texel[1] = static_cast<uint8_t>(lround(127.5f + 127.5f * distance));
+		}
 	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	if(!texture)
+	{
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	else
+		glBindTexture(GL_TEXTURE_2D, texture);
 	
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.Width(), image.Height(), 0,
-		GL_BGRA, GL_UNSIGNED_BYTE, image.Pixels());
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, atlasWidth, atlasHeight, 0,
+		GL_RG, GL_UNSIGNED_BYTE, atlas.data());
 }
 
 
@@ -432,52 +630,3 @@ void Font::CalculateAdvances(ImageBuffer &image)
 	height /= 2;
 	space = (width + 3) / 6 + 1;
 }
-
-
-
-void Font::SetUpShader(float glyphW, float glyphH)
-{
-	glyphW *= .5f;
-	glyphH *= .5f;
-	
-	shader = Shader(vertexCode, fragmentCode);
-	glUseProgram(shader.Object());
-	glUniform1i(shader.Uniform("tex"), 0);
-	glUseProgram(0);
-	
-	// Create the VAO and VBO.
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-	
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	
-	GLfloat vertices[] = {
-		   0.f,    0.f, 0.f, 0.f,
-		   0.f, glyphH, 0.f, 1.f,
-		glyphW,    0.f, 1.f, 0.f,
-		glyphW, glyphH, 1.f, 1.f
-	};
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	
-	// connect the xy to the "vert" attribute of the vertex shader
-	glEnableVertexAttribArray(shader.Attrib("vert"));
-	glVertexAttribPointer(shader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
-	
-	glEnableVertexAttribArray(shader.Attrib("corner"));
-	glVertexAttribPointer(shader.Attrib("corner"), 2, GL_FLOAT, GL_FALSE,
-		4 * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
-	
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
-	
-	// We must update the screen size next time we draw.
-	screenWidth = 0;
-	screenHeight = 0;
-	
-	colorI = shader.Uniform("color");
-	scaleI = shader.Uniform("scale");
-	glyphI = shader.Uniform("glyph");
-	aspectI = shader.Uniform("aspect");
-	positionI = shader.Uniform("position");
-}
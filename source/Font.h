@@ -13,11 +13,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef FONT_H_
 #define FONT_H_
 
-#include "Shader.h"
-
-#include "gl_header.h"
-
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class Color;
 class ImageBuffer;
@@ -28,7 +26,11 @@ class Point;
 // Class for drawing text in OpenGL. Each font is based on a single image with
 // glyphs for each character in ASCII order (not counting control characters).
 // The kerning between characters is automatically adjusted to look good. At the
-// moment only plain ASCII characters are supported, not Unicode.
+// moment only plain ASCII characters are supported, not Unicode. All the fonts
+// share one texture and one shader. Along with each glyph's coverage, that
+// texture holds its signed distance field, which keeps the edges sharp when
+// the text is scaled up; that is used if the "Sharp text when zoomed" setting
+// is on.
 class Font {
 public:
 	Font();
@@ -38,6 +40,12 @@ public:
 	
 	void Draw(const std::string &str, const Point &point, const Color &color) const;
 	void DrawAliased(const std::string &str, double x, double y, const Color &color) const;
+	// Add the glyphs for the given string to the given vertex array, with the
+	// start of the string at the given position. This is for classes that draw
+	// many strings at once, like WrappedText, to lay them all out once and then
+	// draw them all with a single call to DrawLayout().
+	void Layout(const char *str, float x, float y, std::vector<float> &vertices) const;
+	void DrawLayout(const std::vector<float> &vertices, double x, double y, const Color &color) const;
 	
 	int Width(const std::string &str, char after = ' ') const;
 	int Width(const char *str, char after = ' ') const;
@@ -50,34 +58,33 @@ public:
 	int Space() const;
 	
 	static void ShowUnderlines(bool show);
+	static bool IsShowingUnderlines();
 	
 	
 private:
 	static int Glyph(char c, bool isAfterSpace);
-	void LoadTexture(ImageBuffer &image);
+	void AddToAtlas(ImageBuffer &image);
 	void CalculateAdvances(ImageBuffer &image);
-	void SetUpShader(float glyphW, float glyphH);
 	
 	
 private:
-	Shader shader;
-	GLuint texture;
-	GLuint vao;
-	GLuint vbo;
-	
-	GLint colorI;
-	GLint scaleI;
-	GLint glyphI;
-	GLint aspectI;
-	GLint positionI;
-	
+	// The size of each glyph when it is drawn.
+	float glyphWidth;
+	float glyphHeight;
+	// The position of this font's glyphs in the shared texture, in texels.
+	float cellWidth;
+	float top;
+	float bottom;
 	int height;
 	int space;
-	mutable int screenWidth;
-	mutable int screenHeight;
 	
 	static const int GLYPHS = 98;
 	int advance[GLYPHS * GLYPHS];
+	
+	// Cache of the glyph layout of each string that has been drawn. This must
+	// be thrown out if the underlines are turned on or off.
+	mutable std::unordered_map<std::string, std::vector<float>> layouts;
+	mutable bool layoutUnderlines = false;
 };
 
 
@@ -12,10 +12,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "FrameTimer.h"
 
+#include "Trace.h"
+
 #include <thread>
 
 using namespace std;
 
+namespace {
+	// The operating system may wake a sleeping thread this long after it asked
+	// to be woken up, or worse. In precise mode, the frame timer stops sleeping
+	// this long before the next frame, and yields the rest of the time away.
+	const chrono::microseconds SPIN_TIME(1000);
+}
+
 
 
 // Create a timer that is just responsible for measuring the time that
@@ -43,6 +52,7 @@ FrameTimer::FrameTimer(int fps, int maxLagMsec)
 // Wait until the next frame should begin.
 void FrameTimer::Wait()
 {
+	TRACE_SCOPE("FrameTimer::Wait");
 	// Note: in theory this could get interrupted by a signal handler, although
 	// it's unlikely the program will receive any signals that do not terminate
 	// it and that it does not ignore. But, the worst that would happen in that
@@ -56,7 +66,7 @@ void FrameTimer::Wait()
 		if(now + step + maxLag < next)
 			next = now + step;
 		
-		this_thread::sleep_until(next);
+		SleepUntil(next);
 		now = chrono::steady_clock::now();
 	}
 	// If the lag is too high, don't try to do catch-up.
@@ -68,6 +78,40 @@ void FrameTimer::Wait()
 
 
 
+// Wait until the next frame should begin, then return how many frames' worth
+// of time have passed since the previous one, up to the given maximum.
+int FrameTimer::WaitSteps(int maxSteps)
+{
+	TRACE_SCOPE("FrameTimer::WaitSteps");
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if(now < next)
+	{
+		// Just as in Wait(), never sleep for longer than one frame.
+		if(now + step + maxLag < next)
+			next = now + step;
+		
+		SleepUntil(next);
+		now = chrono::steady_clock::now();
+	}
+	
+	// Count this frame, plus each whole frame that has gone by since it should
+	// have begun. If more time than that has been lost, do not try to catch up
+	// on the rest of it.
+	int steps = 1 + static_cast<int>((now - next) / step);
+	if(steps > maxSteps)
+	{
+		steps = maxSteps;
+		next = now;
+	}
+	else
+		next += (steps - 1) * step;
+	
+	Step();
+	return steps;
+}
+
+
+
 // Find out how long it has been since this timer was created, in seconds.
 double FrameTimer::Time() const
 {
@@ -85,8 +129,35 @@ void FrameTimer::SetFrameRate(int fps)
 
 
 
+// Set whether to wait for the next frame more precisely, at the cost of keeping
+// the processor busy for the last fraction of a millisecond.
+void FrameTimer::SetPrecise(bool precise)
+{
+	isPrecise = precise;
+}
+
+
+
 // Calculate when the next frame should begin.
 void FrameTimer::Step()
 {
 	next += step;
 }
+
+
+
+// Sleep until the given time. Sleeping is only accurate to within a millisecond
+// or so, so a precise timer only sleeps until shortly before that time.
+void FrameTimer::SleepUntil(chrono::steady_clock::time_point time) const
+{
+	if(!isPrecise)
+	{
+		this_thread::sleep_until(time);
+		return;
+	}
+	
+	if(chrono::steady_clock::now() + SPIN_TIME < time)
+		this_thread::sleep_until(time - SPIN_TIME);
+	while(chrono::steady_clock::now() < time)
+		this_thread::yield();
+}
@@ -32,22 +32,33 @@ public:
 	
 	// Wait until the next frame should begin.
 	void Wait();
+	// Wait until the next frame should begin, then return how many frames'
+	// worth of time have passed since the previous one, so that the caller can
+	// run extra simulation steps to make up for a frame that took too long.
+	// At most the given number is returned; any lag beyond that is dropped.
+	int WaitSteps(int maxSteps);
 	// Find out how long it has been since this timer was created, in seconds.
 	double Time() const;
 	
 	// Change the frame rate (for viewing in slow motion).
 	void SetFrameRate(int fps);
+	// Set whether to wait for the next frame more precisely, at the cost of
+	// keeping the processor busy for the last fraction of a millisecond.
+	void SetPrecise(bool precise);
 	
 	
 private:
 	// Calculate when the next frame should begin.
 	void Step();
+	// Sleep until the given time.
+	void SleepUntil(std::chrono::steady_clock::time_point time) const;
 	
 	
 private:
 	std::chrono::steady_clock::time_point next;
 	std::chrono::steady_clock::duration step;
 	std::chrono::steady_clock::duration maxLag;
+	bool isPrecise = false;
 };
 
 
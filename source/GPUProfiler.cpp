@@ -0,0 +1,124 @@
+/* GPUProfiler.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "GPUProfiler.h"
+
+#include "GameWindow.h"
+
+using namespace std;
+
+namespace {
+	// How many frames may be in flight before their results are collected.
+	const size_t FRAMES = 4;
+}
+
+
+
+GPUProfiler::GPUProfiler(const vector<string> &names, size_t window)
+	: profiler(names, window), isUsed(names.size() * FRAMES, false), current(names.size())
+{
+}
+
+
+
+GPUProfiler::~GPUProfiler()
+{
+	if(!queries.empty())
+		glDeleteQueries(queries.size(), queries.data());
+}
+
+
+
+// End the current pass, if any, and begin timing the given one.
+void GPUProfiler::Start(size_t phase)
+{
+	if(!GameWindow::HasTimerQueries())
+		return;
+	
+	// The queries are only created once there is an OpenGL context to use.
+	const size_t count = profiler.Names().size();
+	if(queries.empty())
+	{
+		queries.resize(count * FRAMES);
+		glGenQueries(queries.size(), queries.data());
+	}
+	
+	if(current < count)
+		glEndQuery(GL_TIME_ELAPSED);
+	current = phase;
+	if(current < count)
+	{
+		size_t index = (frame % FRAMES) * count + current;
+		glBeginQuery(GL_TIME_ELAPSED, queries[index]);
+		isUsed[index] = true;
+	}
+}
+
+
+
+// End the current pass, and finish recording this frame.
+void GPUProfiler::Finish()
+{
+	const size_t count = profiler.Names().size();
+	Start(count);
+	if(queries.empty())
+		return;
+	
+	// Collect the results of the oldest frame in the ring, which is the one
+	// that will be reused next. If any of them are not ready, skip that frame.
+	++frame;
+	size_t begin = (frame % FRAMES) * count;
+	bool isReady = false;
+	for(size_t i = begin; i < begin + count; ++i)
+		if(isUsed[i])
+		{
+			GLint available = 0;
+			glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+			if(!available)
+			{
+				isReady = false;
+				break;
+			}
+			isReady = true;
+		}
+	if(isReady)
+	{
+		last = 0.;
+		for(size_t i = 0; i < count; ++i)
+		{
+			GLuint64 time = 0;
+			if(isUsed[begin + i])
+				glGetQueryObjectui64v(queries[begin + i], GL_QUERY_RESULT, &time);
+			profiler.Add(i, time * .000001);
+			last += time * .000001;
+		}
+		profiler.Finish();
+	}
+	for(size_t i = begin; i < begin + count; ++i)
+		isUsed[i] = false;
+}
+
+
+
+// Get the statistics for each pass, like a Profiler's.
+const Profiler &GPUProfiler::Times() const
+{
+	return profiler;
+}
+
+
+
+// Get the total time of the most recent frame whose results are in.
+double GPUProfiler::Last() const
+{
+	return last;
+}
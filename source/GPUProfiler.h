@@ -0,0 +1,66 @@
+/* GPUProfiler.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef GPU_PROFILER_H_
+#define GPU_PROFILER_H_
+
+#include "Profiler.h"
+
+#include "gl_header.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+
+// Class for measuring how much time the graphics card spends on each pass of
+// drawing a frame. Like the Profiler, starting one pass ends the previous one.
+// The graphics card runs behind the CPU, so the results of each frame are only
+// collected a few frames later, and if they are still not ready by then that
+// frame is skipped rather than waiting for it. If the OpenGL version does not
+// support timer queries, nothing is measured.
+class GPUProfiler {
+public:
+	explicit GPUProfiler(const std::vector<std::string> &names, size_t window = 60);
+	~GPUProfiler();
+	
+	GPUProfiler(const GPUProfiler &) = delete;
+	GPUProfiler &operator=(const GPUProfiler &) = delete;
+	
+	// End the current pass, if any, and begin timing the given one.
+	void Start(size_t phase);
+	// End the current pass, and finish recording this frame.
+	void Finish();
+	
+	// Get the statistics for each pass, like a Profiler's.
+	const Profiler &Times() const;
+	// Get the total time of the most recent frame whose results are in, in
+	// milliseconds.
+	double Last() const;
+	
+	
+private:
+	Profiler profiler;
+	
+	// The queries for each pass of each frame, in a ring of frames.
+	std::vector<GLuint> queries;
+	std::vector<bool> isUsed;
+	size_t frame = 0;
+	size_t current;
+	
+	double last = 0.;
+};
+
+
+
+#endif
@@ -12,14 +12,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "GameData.h"
 
-#include "Audio.h"
+#include "Archive.h"
 #include "BatchShader.h"
 #include "Color.h"
 #include "Command.h"
 #include "Conversation.h"
+#include "DataCache.h"
 #include "DataFile.h"
 #include "DataNode.h"
 #include "DataWriter.h"
+#include "DistanceMap.h"
 #include "Effect.h"
 #include "Files.h"
 #include "FillShader.h"
@@ -32,19 +34,25 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ImageSet.h"
 #include "Interface.h"
 #include "LineShader.h"
+#include "MaskCache.h"
 #include "Minable.h"
 #include "Mission.h"
 #include "Music.h"
 #include "News.h"
 #include "Outfit.h"
 #include "OutlineShader.h"
+#include "ParticleShader.h"
 #include "Person.h"
 #include "Phrase.h"
 #include "Planet.h"
+#include "Point.h"
 #include "PointerShader.h"
 #include "Politics.h"
+#include "Preferences.h"
 #include "Random.h"
 #include "RingShader.h"
+#include "Screen.h"
+#include "ShaderCache.h"
 #include "Ship.h"
 #include "Sprite.h"
 #include "SpriteQueue.h"
@@ -52,11 +60,21 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteShader.h"
 #include "StarField.h"
 #include "StartConditions.h"
+#include "StellarObject.h"
+#include "StreamBuffer.h"
 #include "System.h"
+#include "Trace.h"
+#include "WorkerPool.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
 #include <iostream>
+#include <list>
 #include <map>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -92,6 +110,15 @@ namespace {
 	Set<Galaxy> defaultGalaxies;
 	Set<Sale<Ship>> defaultShipSales;
 	Set<Sale<Outfit>> defaultOutfitSales;
+	// The objects that events have changed since the last time the game data
+	// was reverted. Only they need to be restored from the default copies.
+	// Every system is always restored, because the economy changes them all.
+	set<string> changedFleets;
+	set<string> changedGovernments;
+	set<string> changedPlanets;
+	set<string> changedGalaxies;
+	set<string> changedShipSales;
+	set<string> changedOutfitSales;
 	
 	Politics politics;
 	StartConditions startConditions;
@@ -115,9 +142,172 @@ namespace {
 	
 	vector<string> sources;
 	map<const Sprite *, shared_ptr<ImageSet>> deferred;
-	map<const Sprite *, int> preloaded;
+	// The deferred sprites that are loaded, most recently requested first, and
+	// where each one is in that list. Only this many of them are kept loaded.
+	const size_t MAX_PRELOADED = 20;
+	list<const Sprite *> preloaded;
+	map<const Sprite *, list<const Sprite *>::iterator> preloadedIndex;
+	bool savedMasks = false;
+	// In debug mode, report how long the sprites took to load.
+	bool printLoadStats = false;
 	
 	const Government *playerGovernment = nullptr;
+	
+	// The missions that could be offered on each planet, based only on their
+	// source and source filter, and the missions that are offered by ships.
+	map<const Planet *, vector<const Mission *>> planetMissions;
+	vector<const Mission *> shipMissions;
+	bool hasShipMissions = false;
+	// The news that can be shown on each planet.
+	map<const Planet *, vector<const News *>> planetNews;
+	
+	// This is incremented every time the systems or planets change, so that
+	// anything calculated from them knows when it must be recalculated.
+	atomic<int> revision(0);
+	
+	// The name of the file that a source's images and sounds may be packed into.
+	const string ARCHIVE_NAME = "assets.archive";
+	
+	
+	
+	// Forget anything that was calculated from the systems and planets, because
+	// an event or a reverted save has changed them.
+	void ClearCaches()
+	{
+		++revision;
+		DistanceMap::ClearCache();
+		planetMissions.clear();
+		planetNews.clear();
+	}
+	
+	
+	
+	// Compress all the given images ahead of time, using all available cores,
+	// so that the next time the game starts they can be loaded without being
+	// decoded.
+	void CompressImages(const map<string, shared_ptr<ImageSet>> &images)
+	{
+		vector<shared_ptr<ImageSet>> sets;
+		for(const auto &it : images)
+			if(it.second)
+				sets.push_back(it.second);
+		
+		WorkerPool pool;
+		pool.Run(sets.size(), [&sets](size_t, size_t begin, size_t end)
+		{
+			for(size_t i = begin; i < end; ++i)
+				sets[i]->Compress();
+		});
+		cout << "Compressed " << sets.size() << " sprites." << endl;
+	}
+	
+	
+	
+	// Pack the images (including any compressed copies of them) and sounds of
+	// each source into a single archive, so that the next time the game starts
+	// they can be loaded without searching through all those directories.
+	void PackArchives()
+	{
+		for(const string &source : sources)
+		{
+			vector<string> files;
+			for(const string &path : Files::RecursiveList(source + "images/"))
+				if(ImageSet::IsImage(path) || (path.length() > 4 && !path.compare(path.length() - 4, 4, ".bc3")))
+					files.push_back(path);
+			for(const string &path : Files::RecursiveList(source + "sounds/"))
+				if(path.length() > 4 && !path.compare(path.length() - 4, 4, ".wav"))
+					files.push_back(path);
+			if(files.empty())
+				continue;
+			
+			if(Archive::Write(source + ARCHIVE_NAME, source, files))
+				cout << "Packed " << files.size() << " files into " << source << ARCHIVE_NAME << "." << endl;
+			else
+				Files::LogError("Unable to write " + source + ARCHIVE_NAME + ".");
+		}
+	}
+	
+	
+	
+	// Get the paths of all the data files, in the order they must be loaded.
+	vector<string> DataPaths()
+	{
+		vector<string> paths;
+		for(const string &source : sources)
+			for(const string &path : Files::RecursiveList(source + "data/"))
+				if(path.length() >= 4 && !path.compare(path.length() - 4, 4, ".txt"))
+					paths.push_back(path);
+		return paths;
+	}
+	
+	
+	
+	// In debug mode, remember when each data file was last modified and which
+	// objects it defines, so that any changes to it can be loaded while the
+	// game is running.
+	bool isWatchingData = false;
+	mutex reloadMutex;
+	map<string, time_t> dataTimes;
+	map<string, vector<pair<string, string>>> dataDefinitions;
+	
+	// Get the type and name of the object that the given root node defines.
+	pair<string, string> Definition(const DataNode &node)
+	{
+		// Ship variants are named by their second token.
+		int index = (node.Token(0) == "ship" && node.Size() > 2) ? 2 : 1;
+		return make_pair(node.Token(0), node.Size() > index ? node.Token(index) : string());
+	}
+	
+	template <class Type>
+	void Reset(Set<Type> &set, const string &name)
+	{
+		*set.Get(name) = Type();
+	}
+	
+	// Clear the given object, so that all its definitions can be loaded again.
+	// Objects that the saved game or the state of the universe depends on, like
+	// governments, planets, and systems, cannot be replaced this way, so return
+	// false for those.
+	bool ResetDefinition(const pair<string, string> &definition)
+	{
+		const string &key = definition.first;
+		const string &name = definition.second;
+		if(name.empty())
+			return false;
+		if(key == "conversation")
+			Reset(conversations, name);
+		else if(key == "effect")
+			Reset(effects, name);
+		else if(key == "event")
+			Reset(events, name);
+		else if(key == "fleet")
+			Reset(fleets, name);
+		else if(key == "galaxy")
+			Reset(galaxies, name);
+		else if(key == "interface")
+			Reset(interfaces, name);
+		else if(key == "minable")
+			Reset(minables, name);
+		else if(key == "mission")
+			Reset(missions, name);
+		else if(key == "news")
+			Reset(news, name);
+		else if(key == "outfit")
+			Reset(outfits, name);
+		else if(key == "outfitter")
+			Reset(outfitSales, name);
+		else if(key == "phrase")
+			Reset(phrases, name);
+		else if(key == "ship")
+			Reset(ships, name);
+		else if(key == "shipyard")
+			Reset(shipSales, name);
+		// These are replaced completely each time they are loaded.
+		else if(key != "color" && key != "landing message" && key != "star" && key != "rating"
+				&& key != "tip" && key != "help")
+			return false;
+		return true;
+	}
 }
 
 
@@ -127,6 +317,11 @@ bool GameData::BeginLoad(const char * const *argv)
 	bool printShips = false;
 	bool printWeapons = false;
 	bool debugMode = false;
+	bool compressImages = false;
+	bool packArchives = false;
+	bool parseOnly = false;
+	bool isHeadless = false;
+	size_t textureBudget = 0;
 	for(const char * const *it = argv + 1; *it; ++it)
 	{
 		if((*it)[0] == '-')
@@ -138,18 +333,56 @@ bool GameData::BeginLoad(const char * const *argv)
 				printWeapons = true;
 			if(arg == "-d" || arg == "--debug")
 				debugMode = true;
+			if(arg == "--compress-images")
+				compressImages = true;
+			if(arg == "--pack-archives")
+				packArchives = true;
+			if(arg == "-p" || arg == "--parse-save")
+				parseOnly = true;
+			if(arg == "--headless")
+				isHeadless = true;
+			if(arg == "--texture-budget" && it[1])
+				textureBudget = static_cast<size_t>(max(0, atoi(*++it))) << 20;
 			continue;
 		}
 	}
-	Files::Init(argv);
+	printLoadStats = debugMode;
 	
 	// Initialize the list of "source" folders based on any active plugins.
 	LoadSources();
 	
+	// Any source's images and sounds may be packed into an archive. When the
+	// archives are being rewritten, the old ones must not be read from.
+	if(packArchives)
+	{
+		PackArchives();
+		return false;
+	}
+	for(const string &source : sources)
+		Archive::Add(source + ARCHIVE_NAME, source);
+	
+	// If a texture budget is given, sprites are streamed: most of them are not
+	// loaded until they are first drawn, and the least recently drawn ones are
+	// unloaded whenever the loaded textures take up more than the budget.
+	spriteQueue.SetTextureBudget(textureBudget);
+	
 	// Now, read all the images in all the path directories. For each unique
 	// name, only remember one instance, letting things on the higher priority
-	// paths override the default images.
-	map<string, shared_ptr<ImageSet>> images = FindImages();
+	// paths override the default images. When only checking the data for
+	// errors, nothing will be drawn, so the images are not even looked for.
+	map<string, shared_ptr<ImageSet>> images;
+	if(!parseOnly)
+		images = FindImages();
+	if(compressImages)
+	{
+		CompressImages(images);
+		return false;
+	}
+	
+	// Any ship or asteroid images that have not changed since the last time
+	// the game was run can use the collision masks that were traced then.
+	if(!parseOnly)
+		MaskCache::Load(Files::Config() + "mask cache");
 	
 	// From the name, strip out any frame number, plus the extension.
 	for(const auto &it : images)
@@ -163,25 +396,50 @@ bool GameData::BeginLoad(const char * const *argv)
 		// For landscapes, remember all the source files but don't load them yet.
 		if(ImageSet::IsDeferred(it.first))
 			deferred[SpriteSet::Get(it.first)] = it.second;
-		else
+		else if(textureBudget)
+			spriteQueue.AddStreamed(it.second, !ImageSet::IsStreamed(it.first));
+		// Only the interface needs to be loaded before the main menu is shown.
+		// Everything else loads in the background, unless a scenario is being
+		// simulated, which needs all the collision masks from the start.
+		else if(isHeadless || ImageSet::IsEssential(it.first))
 			spriteQueue.Add(it.second);
+		else
+			spriteQueue.AddBackground(it.second);
 	}
 	
 	// Generate a catalog of music files.
-	Music::Init(sources);
+	if(!parseOnly)
+		Music::Init(sources);
 	
-	for(const string &source : sources)
+	// Iterate through the paths starting with the last directory given. That
+	// is, things in folders near the start of the path have the ability to
+	// override things in folders later in the path.
+	vector<string> dataPaths = DataPaths();
+	// The files are parsed in parallel (or restored from the cache of parsed
+	// files), but must be loaded in order so that the overrides work the same
+	// way every time.
+	vector<DataFile> dataFiles = DataCache::Load(dataPaths, Files::Config() + "data cache");
+	isWatchingData = debugMode && !parseOnly;
+	for(size_t i = 0; i < dataFiles.size(); ++i)
 	{
-		// Iterate through the paths starting with the last directory given. That
-		// is, things in folders near the start of the path have the ability to
-		// override things in folders later in the path.
-		vector<string> dataFiles = Files::RecursiveList(source + "data/");
-		for(const string &path : dataFiles)
-			LoadFile(path, debugMode);
+		if(isWatchingData)
+		{
+			dataTimes[dataPaths[i]] = Files::Timestamp(dataPaths[i]);
+			vector<pair<string, string>> &definitions = dataDefinitions[dataPaths[i]];
+			for(const DataNode &node : dataFiles[i])
+				definitions.push_back(Definition(node));
+		}
+		LoadFile(dataFiles[i], dataPaths[i], debugMode);
+		// Free up the memory used by this file's nodes.
+		dataFiles[i] = DataFile();
 	}
 	
 	// Now that all the stars are loaded, update the neighbor lists.
 	UpdateNeighbors();
+	// The commodities may have been defined after some of the systems, so the
+	// systems' price tables can only be filled in now.
+	for(auto &it : systems)
+		it.second.UpdateTrade();
 	// And, update the ships with the outfits we've now finished loading.
 	for(auto &it : ships)
 		it.second.FinishLoading(true);
@@ -286,6 +544,10 @@ void GameData::CheckReferences()
 
 void GameData::LoadShaders()
 {
+	// Programs that were linked the last time the game ran do not need to be
+	// compiled again, if the graphics driver has not changed since then.
+	ShaderCache::Load(Files::Config() + "shader cache");
+	
 	FontSet::Add(Files::Images() + "font/ubuntu14r.png", 14);
 	FontSet::Add(Files::Images() + "font/ubuntu18r.png", 18);
 	
@@ -293,6 +555,7 @@ void GameData::LoadShaders()
 	Command::LoadSettings(Files::Resources() + "keys.txt");
 	Command::LoadSettings(Files::Config() + "keys.txt");
 	
+	StreamBuffer::Init();
 	FillShader::Init();
 	FogShader::Init();
 	LineShader::Init();
@@ -301,15 +564,58 @@ void GameData::LoadShaders()
 	RingShader::Init();
 	SpriteShader::Init();
 	BatchShader::Init();
+	ParticleShader::Init();
 	
 	background.Init(16384, 4096);
+	
+	ShaderCache::Save();
 }
 
 
 
 double GameData::Progress()
 {
-	return min(spriteQueue.Progress(), Audio::Progress());
+	// The @2x sprites are drawn if the screen is high resolution or if the view
+	// is zoomed in, so they only need to be loaded if one of those is true.
+	ImageSet::SetUse2x(Screen::IsHighResolution() || Preferences::ViewZoom() > 1.);
+	// Sounds that are not loaded yet are just not played, so the game does not
+	// need to wait for them, or for the background sprites.
+	double progress = spriteQueue.Progress();
+	// Once everything has loaded, save any masks that had to be traced.
+	if(!savedMasks && spriteQueue.IsDone())
+	{
+		MaskCache::Save();
+		savedMasks = true;
+		if(printLoadStats)
+		{
+			SpriteQueue::Stats stats = spriteQueue.GetStats();
+			cout << "Read " << (stats.bytesRead >> 20) << " MB of sprites in " << stats.readTime
+				<< " s, and decoded them in " << stats.decodeTime << " s on " << stats.decodeThreads
+				<< " threads." << endl;
+		}
+	}
+	return progress;
+}
+
+
+
+// Start loading any streamed or background sprites that have been drawn, and if
+// sprites are being streamed, unload the least recently drawn ones if the
+// textures are over budget. This must be called from the main thread, once per
+// frame.
+void GameData::StreamSprites()
+{
+	spriteQueue.Stream();
+}
+
+
+
+// Get the number of sprites that are waiting to be read, decoded, or uploaded
+// to the graphics card.
+size_t GameData::SpriteBacklog()
+{
+	SpriteQueue::Stats stats = spriteQueue.GetStats();
+	return stats.toRead + stats.toDecode + stats.toUpload;
 }
 
 
@@ -326,41 +632,41 @@ void GameData::Preload(const Sprite *sprite)
 	// If this sprite is one of the currently loaded ones, there is no need to
 	// load it again. But, make note of the fact that it is the most recently
 	// asked-for sprite.
-	map<const Sprite *, int>::iterator pit = preloaded.find(sprite);
-	if(pit != preloaded.end())
+	auto pit = preloadedIndex.find(sprite);
+	if(pit != preloadedIndex.end())
 	{
-		for(pair<const Sprite * const, int> &it : preloaded)
-			if(it.second < pit->second)
-				++it.second;
-		
-		pit->second = 0;
+		preloaded.splice(preloaded.begin(), preloaded, pit->second);
 		return;
 	}
 	
 	// This sprite is not currently preloaded. Check to see whether we already
-	// have the maximum number of sprites loaded, in which case the oldest one
-	// must be unloaded to make room for this one.
-	const string &name = sprite->Name();
-	pit = preloaded.begin();
-	while(pit != preloaded.end())
+	// have the maximum number of sprites loaded, in which case the least
+	// recently asked-for one must be unloaded to make room for this one.
+	if(preloaded.size() >= MAX_PRELOADED)
 	{
-		++pit->second;
-		if(pit->second >= 20)
-		{
-			spriteQueue.Unload(name);
-			pit = preloaded.erase(pit);
-		}
-		else
-			++pit;
+		const Sprite *oldest = preloaded.back();
+		spriteQueue.Unload(oldest->Name());
+		preloadedIndex.erase(oldest);
+		preloaded.pop_back();
 	}
 	
 	// Now, load all the files for this sprite.
-	preloaded[sprite] = 0;
+	preloaded.push_front(sprite);
+	preloadedIndex[sprite] = preloaded.begin();
 	spriteQueue.Add(dit->second);
 }
 
 
 
+// Load the given sprite ahead of the others that are loading in the background,
+// because it will be needed soon.
+void GameData::Prioritize(const Sprite *sprite)
+{
+	spriteQueue.Prioritize(sprite);
+}
+
+
+
 void GameData::FinishLoading()
 {
 	spriteQueue.Finish();
@@ -368,6 +674,134 @@ void GameData::FinishLoading()
 
 
 
+// In debug mode, load any changes to the data files since the game started.
+bool GameData::ReloadChangedFiles()
+{
+	if(!isWatchingData)
+		return false;
+	// If another thread is creating objects from the data right now, check for
+	// changes again later instead.
+	unique_lock<mutex> lock(reloadMutex, try_to_lock);
+	if(!lock.owns_lock())
+		return false;
+	
+	// Find which files have been added, changed, or removed.
+	vector<string> paths = DataPaths();
+	set<string> current(paths.begin(), paths.end());
+	set<string> changed;
+	for(const string &path : paths)
+	{
+		auto it = dataTimes.find(path);
+		if(it == dataTimes.end() || it->second != Files::Timestamp(path))
+			changed.insert(path);
+	}
+	for(const auto &it : dataTimes)
+		if(!current.count(it.first))
+			changed.insert(it.first);
+	if(changed.empty())
+		return false;
+	
+	// Every object that a changed file defined before or defines now must be
+	// loaded again from scratch.
+	map<string, DataFile> files;
+	set<pair<string, string>> affected;
+	for(const string &path : changed)
+	{
+		for(const pair<string, string> &definition : dataDefinitions[path])
+			affected.insert(definition);
+		if(!current.count(path))
+		{
+			dataTimes.erase(path);
+			dataDefinitions.erase(path);
+			continue;
+		}
+		
+		dataTimes[path] = Files::Timestamp(path);
+		DataFile &file = files[path];
+		file.Load(path);
+		vector<pair<string, string>> &definitions = dataDefinitions[path];
+		definitions.clear();
+		for(const DataNode &node : file)
+		{
+			definitions.push_back(Definition(node));
+			affected.insert(definitions.back());
+		}
+	}
+	// Ship variants are copied from their base models when they are loaded, so
+	// any variants of a reloaded ship must be loaded again too.
+	set<string> affectedShips;
+	for(const pair<string, string> &definition : affected)
+		if(definition.first == "ship")
+			affectedShips.insert(definition.second);
+	for(const auto &it : ships)
+		if(it.first != it.second.ModelName() && affectedShips.count(it.second.ModelName()))
+			affected.emplace("ship", it.first);
+	
+	set<pair<string, string>> reloaded;
+	for(const pair<string, string> &definition : affected)
+	{
+		if(ResetDefinition(definition))
+			reloaded.insert(definition);
+		else
+			Files::LogError("Restart the game to load the changes to " + definition.first
+				+ (definition.second.empty() ? "" : " \"" + definition.second + "\"") + ".");
+	}
+	
+	// Load every definition of those objects again, including the ones in files
+	// that did not change, in the same order as at startup so that any
+	// overrides still apply the same way.
+	for(const string &path : paths)
+	{
+		const vector<pair<string, string>> &definitions = dataDefinitions[path];
+		bool isNeeded = false;
+		for(const pair<string, string> &definition : definitions)
+			isNeeded |= reloaded.count(definition);
+		if(!isNeeded)
+			continue;
+		
+		auto it = files.find(path);
+		if(it == files.end())
+			it = files.emplace(path, DataFile(path)).first;
+		for(const DataNode &node : it->second)
+			if(reloaded.count(Definition(node)))
+				LoadNode(node);
+	}
+	
+	// Finish loading the reloaded objects, and update the copies of them that
+	// the universe is reverted to.
+	for(const pair<string, string> &definition : reloaded)
+	{
+		const string &key = definition.first;
+		const string &name = definition.second;
+		if(key == "ship")
+			ships.Get(name)->FinishLoading(true);
+		else if(key == "fleet")
+			*defaultFleets.Get(name) = *fleets.Get(name);
+		else if(key == "galaxy")
+			*defaultGalaxies.Get(name) = *galaxies.Get(name);
+		else if(key == "outfitter")
+			*defaultOutfitSales.Get(name) = *outfitSales.Get(name);
+		else if(key == "shipyard")
+			*defaultShipSales.Get(name) = *shipSales.Get(name);
+	}
+	ClearCaches();
+	shipMissions.clear();
+	hasShipMissions = false;
+	
+	Files::LogError("Reloaded " + to_string(reloaded.size()) + " objects from "
+		+ to_string(changed.size()) + " changed data files.");
+	return !reloaded.empty();
+}
+
+
+
+mutex &GameData::ReloadMutex()
+{
+	return reloadMutex;
+}
+
+
+
 // Get the list of resource sources (i.e. plugin folders).
 const vector<string> &GameData::Sources()
 {
@@ -379,18 +813,28 @@ const vector<string> &GameData::Sources()
 // Revert any changes that have been made to the universe.
 void GameData::Revert()
 {
-	fleets.Revert(defaultFleets);
-	governments.Revert(defaultGovernments);
-	planets.Revert(defaultPlanets);
+	fleets.Revert(defaultFleets, &changedFleets);
+	governments.Revert(defaultGovernments, &changedGovernments);
+	planets.Revert(defaultPlanets, &changedPlanets);
 	systems.Revert(defaultSystems);
-	galaxies.Revert(defaultGalaxies);
-	shipSales.Revert(defaultShipSales);
-	outfitSales.Revert(defaultOutfitSales);
+	galaxies.Revert(defaultGalaxies, &changedGalaxies);
+	shipSales.Revert(defaultShipSales, &changedShipSales);
+	outfitSales.Revert(defaultOutfitSales, &changedOutfitSales);
+	changedFleets.clear();
+	changedGovernments.clear();
+	changedPlanets.clear();
+	changedGalaxies.clear();
+	changedShipSales.clear();
+	changedOutfitSales.clear();
+	// Planets that were not reverted may still have defense fleets deployed.
+	for(const auto &it : planets)
+		it.second.ResetDefense();
 	for(auto &it : persons)
 		it.second.Restore();
 	
 	politics.Reset();
 	purchases.clear();
+	ClearCaches();
 }
 
 
@@ -430,7 +874,7 @@ void GameData::ReadEconomy(const DataNode &node)
 			
 			int index = 0;
 			for(const string &commodity : headings)
-				system.SetSupply(commodity, child.Value(++index));
+				system.SetSupply(CommodityIndex(commodity), child.Value(++index));
 		}
 	}
 }
@@ -463,8 +907,8 @@ void GameData::WriteEconomy(DataWriter &out)
 				continue;
 			
 			out.WriteToken(sit.second.Name());
-			for(const auto &cit : GameData::Commodities())
-				out.WriteToken(static_cast<int>(sit.second.Supply(cit.name)));
+			for(size_t i = 0; i < GameData::Commodities().size(); ++i)
+				out.WriteToken(static_cast<int>(sit.second.Supply(i)));
 			out.Write();
 		}
 	}
@@ -481,7 +925,10 @@ void GameData::StepEconomy()
 	{
 		System &system = const_cast<System &>(*pit.first);
 		for(const auto &cit : pit.second)
-			system.SetSupply(cit.first, system.Supply(cit.first) - cit.second);
+		{
+			size_t index = trade.Index(cit.first);
+			system.SetSupply(index, system.Supply(index) - cit.second);
+		}
 	}
 	purchases.clear();
 	
@@ -491,22 +938,39 @@ void GameData::StepEconomy()
 	
 	// Finally, send out the trade goods. This has to be done in a separate step
 	// because otherwise whichever systems trade last would already have gotten
-	// supplied by the other systems.
+	// supplied by the other systems. Look up each system's exports just once,
+	// and store them in a table indexed by system and commodity, instead of
+	// looking them up again for each of that system's neighbors.
+	const size_t count = trade.Commodities().size();
+	vector<double> exports(System::Count() * count, 0.);
+	for(const auto &it : systems)
+	{
+		double *row = exports.data() + it.second.Index() * count;
+		for(size_t i = 0; i < count; ++i)
+			row[i] = it.second.Exports(i);
+	}
+	
+	vector<double> supply(count, 0.);
 	for(auto &it : systems)
 	{
 		System &system = it.second;
-		if(!system.Links().empty())
-			for(const Trade::Commodity &commodity : trade.Commodities())
-			{
-				double supply = system.Supply(commodity.name);
-				for(const System *neighbor : system.Links())
-				{
-					double scale = neighbor->Links().size();
-					if(scale)
-						supply += neighbor->Exports(commodity.name) / scale;
-				}
-				system.SetSupply(commodity.name, supply);
-			}
+		if(system.Links().empty())
+			continue;
+		
+		for(size_t i = 0; i < count; ++i)
+			supply[i] = system.Supply(i);
+		for(const System *neighbor : system.Links())
+		{
+			double scale = neighbor->Links().size();
+			if(!scale)
+				continue;
+			
+			const double *row = exports.data() + neighbor->Index() * count;
+			for(size_t i = 0; i < count; ++i)
+				supply[i] += row[i] / scale;
+		}
+		for(size_t i = 0; i < count; ++i)
+			system.SetSupply(i, supply[i]);
 	}
 }
 
@@ -520,23 +984,67 @@ void GameData::AddPurchase(const System &system, const string &commodity, int to
 
 
 
+// Get a number that changes every time the systems or planets are changed by
+// an event or by reverting to the original game data.
+int GameData::Revision()
+{
+	return revision;
+}
+
+
+
 // Apply the given change to the universe.
 void GameData::Change(const DataNode &node)
 {
+	// Any change to the systems or planets may change which missions can be
+	// offered where, or the distances between systems.
+	ClearCaches();
+	
 	if(node.Token(0) == "fleet" && node.Size() >= 2)
+	{
+		changedFleets.insert(node.Token(1));
 		fleets.Get(node.Token(1))->Load(node);
+	}
 	else if(node.Token(0) == "galaxy" && node.Size() >= 2)
+	{
+		changedGalaxies.insert(node.Token(1));
 		galaxies.Get(node.Token(1))->Load(node);
+	}
 	else if(node.Token(0) == "government" && node.Size() >= 2)
+	{
+		changedGovernments.insert(node.Token(1));
 		governments.Get(node.Token(1))->Load(node);
+	}
 	else if(node.Token(0) == "outfitter" && node.Size() >= 2)
+	{
+		changedOutfitSales.insert(node.Token(1));
 		outfitSales.Get(node.Token(1))->Load(node, outfits);
+	}
 	else if(node.Token(0) == "planet" && node.Size() >= 2)
+	{
+		changedPlanets.insert(node.Token(1));
 		planets.Get(node.Token(1))->Load(node);
+	}
 	else if(node.Token(0) == "shipyard" && node.Size() >= 2)
+	{
+		changedShipSales.insert(node.Token(1));
 		shipSales.Get(node.Token(1))->Load(node, ships);
+	}
 	else if(node.Token(0) == "system" && node.Size() >= 2)
-		systems.Get(node.Token(1))->Load(node, planets);
+	{
+		// Loading a system also changes which system its planets are in, both
+		// for the planets that it had before and the ones it has now.
+		System *system = systems.Get(node.Token(1));
+		auto changePlanets = [system]()
+		{
+			for(const StellarObject &object : system->Objects())
+				if(object.GetPlanet())
+					changedPlanets.insert(object.GetPlanet()->TrueName());
+		};
+		changePlanets();
+		system->Load(node, planets);
+		changePlanets();
+	}
 	else if(node.Token(0) == "news" && node.Size() >= 2)
 		news.Get(node.Token(1))->Load(node);
 	else if(node.Token(0) == "link" && node.Size() >= 3)
@@ -553,8 +1061,33 @@ void GameData::Change(const DataNode &node)
 // that a change creates or moves a system.
 void GameData::UpdateNeighbors()
 {
+	// Sort the systems into a grid of cells as big as the neighbor distance.
+	// Then, all the neighbors of a system are either in its own cell or in one
+	// of the eight cells around it.
+	auto cell = [](const Point &pos)
+	{
+		return make_pair(static_cast<int>(floor(pos.X() / System::NEIGHBOR_DISTANCE)),
+			static_cast<int>(floor(pos.Y() / System::NEIGHBOR_DISTANCE)));
+	};
+	map<pair<int, int>, vector<const System *>> cells;
+	for(const auto &it : systems)
+		cells[cell(it.second.Position())].push_back(&it.second);
+	
+	vector<const System *> nearby;
 	for(auto &it : systems)
-		it.second.UpdateNeighbors(systems);
+	{
+		nearby.clear();
+		pair<int, int> center = cell(it.second.Position());
+		for(int x = center.first - 1; x <= center.first + 1; ++x)
+			for(int y = center.second - 1; y <= center.second + 1; ++y)
+			{
+				auto cit = cells.find(make_pair(x, y));
+				if(cit != cells.end())
+					nearby.insert(nearby.end(), cit->second.begin(), cit->second.end());
+			}
+		it.second.UpdateNeighbors(nearby);
+	}
+	ClearCaches();
 }
 
 
@@ -650,6 +1183,41 @@ const Set<Mission> &GameData::Missions()
 
 
 
+// Get the missions whose source and source filter match the given planet, in
+// the same order as Missions(). No other non-boarding missions can be offered
+// there, but these missions may still fail their other offer conditions.
+const vector<const Mission *> &GameData::MissionsFrom(const Planet *planet)
+{
+	auto cached = planetMissions.find(planet);
+	if(cached != planetMissions.end())
+		return cached->second;
+	
+	vector<const Mission *> &list = planetMissions[planet];
+	if(planet)
+		for(const auto &it : missions)
+			if(!it.second.IsAtLocation(Mission::BOARDING) && !it.second.IsAtLocation(Mission::ASSISTING)
+					&& it.second.MatchesSource(planet))
+				list.push_back(&it.second);
+	return list;
+}
+
+
+
+// Get all the missions that are offered by boarding or assisting a ship.
+const vector<const Mission *> &GameData::ShipMissions()
+{
+	if(!hasShipMissions)
+	{
+		for(const auto &it : missions)
+			if(it.second.IsAtLocation(Mission::BOARDING) || it.second.IsAtLocation(Mission::ASSISTING))
+				shipMissions.push_back(&it.second);
+		hasShipMissions = true;
+	}
+	return shipMissions;
+}
+
+
+
 const Set<Outfit> &GameData::Outfits()
 {
 	return outfits;
@@ -742,6 +1310,13 @@ const vector<Trade::Commodity> &GameData::SpecialCommodities()
 
 
 
+size_t GameData::CommodityIndex(const string &name)
+{
+	return trade.Index(name);
+}
+
+
+
 // Custom messages to be shown when trying to land on certain stellar objects.
 bool GameData::HasLandingMessage(const Sprite *sprite)
 {
@@ -780,11 +1355,18 @@ double GameData::SolarWind(const Sprite *sprite)
 // no applicable news, this returns null.
 const News *GameData::PickNews(const Planet *planet)
 {
-	vector<const News *> matches;
-	for(const auto &it : news)
-		if(it.second.Matches(planet))
-			matches.push_back(&it.second);
+	// Which news matches a planet only depends on the planets and systems, so
+	// it only needs to be checked again if an event changes them.
+	auto cached = planetNews.find(planet);
+	if(cached == planetNews.end())
+	{
+		cached = planetNews.emplace(planet, vector<const News *>()).first;
+		for(const auto &it : news)
+			if(it.second.Matches(planet))
+				cached->second.push_back(&it.second);
+	}
 	
+	const vector<const News *> &matches = cached->second;
 	return matches.empty() ? nullptr : matches[Random::Int(matches.size())];
 }
 
@@ -905,109 +1487,110 @@ void GameData::LoadSources()
 
 
 
-void GameData::LoadFile(const string &path, bool debugMode)
+void GameData::LoadFile(const DataFile &data, const string &path, bool debugMode)
 {
-	// This is an ordinary file. Check to see if it is an image.
-	if(path.length() < 4 || path.compare(path.length() - 4, 4, ".txt"))
-		return;
-	
-	DataFile data(path);
+	TRACE_SCOPE("GameData::LoadFile");
 	if(debugMode)
 		Files::LogError("Parsing: " + path);
 	
 	for(const DataNode &node : data)
+		LoadNode(node);
+}
+
+
+
+void GameData::LoadNode(const DataNode &node)
+{
+	const string &key = node.Token(0);
+	if(key == "color" && node.Size() >= 6)
+		colors.Get(node.Token(1))->Load(
+			node.Value(2), node.Value(3), node.Value(4), node.Value(5));
+	else if(key == "conversation" && node.Size() >= 2)
+		conversations.Get(node.Token(1))->Load(node);
+	else if(key == "effect" && node.Size() >= 2)
+		effects.Get(node.Token(1))->Load(node);
+	else if(key == "event" && node.Size() >= 2)
+		events.Get(node.Token(1))->Load(node);
+	else if(key == "fleet" && node.Size() >= 2)
+		fleets.Get(node.Token(1))->Load(node);
+	else if(key == "galaxy" && node.Size() >= 2)
+		galaxies.Get(node.Token(1))->Load(node);
+	else if(key == "government" && node.Size() >= 2)
+		governments.Get(node.Token(1))->Load(node);
+	else if(key == "interface" && node.Size() >= 2)
+		interfaces.Get(node.Token(1))->Load(node);
+	else if(key == "minable" && node.Size() >= 2)
+		minables.Get(node.Token(1))->Load(node);
+	else if(key == "mission" && node.Size() >= 2)
+		missions.Get(node.Token(1))->Load(node);
+	else if(key == "outfit" && node.Size() >= 2)
+		outfits.Get(node.Token(1))->Load(node);
+	else if(key == "outfitter" && node.Size() >= 2)
+		outfitSales.Get(node.Token(1))->Load(node, outfits);
+	else if(key == "person" && node.Size() >= 2)
+		persons.Get(node.Token(1))->Load(node);
+	else if(key == "phrase" && node.Size() >= 2)
+		phrases.Get(node.Token(1))->Load(node);
+	else if(key == "planet" && node.Size() >= 2)
+		planets.Get(node.Token(1))->Load(node);
+	else if(key == "ship" && node.Size() >= 2)
 	{
-		const string &key = node.Token(0);
-		if(key == "color" && node.Size() >= 6)
-			colors.Get(node.Token(1))->Load(
-				node.Value(2), node.Value(3), node.Value(4), node.Value(5));
-		else if(key == "conversation" && node.Size() >= 2)
-			conversations.Get(node.Token(1))->Load(node);
-		else if(key == "effect" && node.Size() >= 2)
-			effects.Get(node.Token(1))->Load(node);
-		else if(key == "event" && node.Size() >= 2)
-			events.Get(node.Token(1))->Load(node);
-		else if(key == "fleet" && node.Size() >= 2)
-			fleets.Get(node.Token(1))->Load(node);
-		else if(key == "galaxy" && node.Size() >= 2)
-			galaxies.Get(node.Token(1))->Load(node);
-		else if(key == "government" && node.Size() >= 2)
-			governments.Get(node.Token(1))->Load(node);
-		else if(key == "interface" && node.Size() >= 2)
-			interfaces.Get(node.Token(1))->Load(node);
-		else if(key == "minable" && node.Size() >= 2)
-			minables.Get(node.Token(1))->Load(node);
-		else if(key == "mission" && node.Size() >= 2)
-			missions.Get(node.Token(1))->Load(node);
-		else if(key == "outfit" && node.Size() >= 2)
-			outfits.Get(node.Token(1))->Load(node);
-		else if(key == "outfitter" && node.Size() >= 2)
-			outfitSales.Get(node.Token(1))->Load(node, outfits);
-		else if(key == "person" && node.Size() >= 2)
-			persons.Get(node.Token(1))->Load(node);
-		else if(key == "phrase" && node.Size() >= 2)
-			phrases.Get(node.Token(1))->Load(node);
-		else if(key == "planet" && node.Size() >= 2)
-			planets.Get(node.Token(1))->Load(node);
-		else if(key == "ship" && node.Size() >= 2)
-		{
-			// Allow multiple named variants of the same ship model.
-			const string &name = node.Token((node.Size() > 2) ? 2 : 1);
-			ships.Get(name)->Load(node);
-		}
-		else if(key == "shipyard" && node.Size() >= 2)
-			shipSales.Get(node.Token(1))->Load(node, ships);
-		else if(key == "start")
-			startConditions.Load(node);
-		else if(key == "system" && node.Size() >= 2)
-			systems.Get(node.Token(1))->Load(node, planets);
-		else if(key == "trade")
-			trade.Load(node);
-		else if(key == "landing message" && node.Size() >= 2)
-		{
-			for(const DataNode &child : node)
-				landingMessages[SpriteSet::Get(child.Token(0))] = node.Token(1);
-		}
-		else if(key == "star" && node.Size() >= 2)
-		{
-			const Sprite *sprite = SpriteSet::Get(node.Token(1));
-			for(const DataNode &child : node)
-			{
-				if(child.Token(0) == "power" && child.Size() >= 2)
-					solarPower[sprite] = child.Value(1);
-				else if(child.Token(0) == "wind" && child.Size() >= 2)
-					solarWind[sprite] = child.Value(1);
-				else
-					child.PrintTrace("Unrecognized star attribute:");
-			}
-		}
-		else if(key == "news" && node.Size() >= 2)
-			news.Get(node.Token(1))->Load(node);
-		else if(key == "rating" && node.Size() >= 2)
+		// Allow multiple named variants of the same ship model.
+		const string &name = node.Token((node.Size() > 2) ? 2 : 1);
+		ships.Get(name)->Load(node);
+	}
+	else if(key == "shipyard" && node.Size() >= 2)
+		shipSales.Get(node.Token(1))->Load(node, ships);
+	else if(key == "start")
+		startConditions.Load(node);
+	else if(key == "system" && node.Size() >= 2)
+		systems.Get(node.Token(1))->Load(node, planets);
+	else if(key == "trade")
+		trade.Load(node);
+	else if(key == "landing message" && node.Size() >= 2)
+	{
+		for(const DataNode &child : node)
+			landingMessages[SpriteSet::Get(child.Token(0))] = node.Token(1);
+	}
+	else if(key == "star" && node.Size() >= 2)
+	{
+		const Sprite *sprite = SpriteSet::Get(node.Token(1));
+		for(const DataNode &child : node)
 		{
-			vector<string> &list = ratings[node.Token(1)];
-			list.clear();
-			for(const DataNode &child : node)
-				list.push_back(child.Token(0));
+			if(child.Token(0) == "power" && child.Size() >= 2)
+				solarPower[sprite] = child.Value(1);
+			else if(child.Token(0) == "wind" && child.Size() >= 2)
+				solarWind[sprite] = child.Value(1);
+			else
+				child.PrintTrace("Unrecognized star attribute:");
 		}
-		else if((key == "tip" || key == "help") && node.Size() >= 2)
+	}
+	else if(key == "news" && node.Size() >= 2)
+		news.Get(node.Token(1))->Load(node);
+	else if(key == "rating" && node.Size() >= 2)
+	{
+		vector<string> &list = ratings[node.Token(1)];
+		list.clear();
+		for(const DataNode &child : node)
+			list.push_back(child.Token(0));
+	}
+	else if((key == "tip" || key == "help") && node.Size() >= 2)
+	{
+		string &text = (key == "tip" ? tooltips : helpMessages)[node.Token(1)];
+		text.clear();
+		for(const DataNode &child : node)
 		{
-			string &text = (key == "tip" ? tooltips : helpMessages)[node.Token(1)];
-			text.clear();
-			for(const DataNode &child : node)
+			if(!text.empty())
 			{
-				if(!text.empty())
-				{
-					text += '\n';
-					if(child.Token(0)[0] != '\t')
-						text += '\t';
-				}
-				text += child.Token(0);
+				text += '\n';
+				if(child.Token(0)[0] != '\t')
+					text += '\t';
 			}
+			text += child.Token(0);
 		}
-		else
-			node.PrintTrace("Skipping unrecognized root object:");
 	}
+	else
+		node.PrintTrace("Skipping unrecognized root object:");
 }
 
 
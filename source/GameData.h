@@ -17,13 +17,16 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Set.h"
 #include "Trade.h"
 
+#include <cstddef>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 class Color;
 class Conversation;
+class DataFile;
 class DataNode;
 class DataWriter;
 class Date;
@@ -66,7 +69,26 @@ public:
 	// Begin loading a sprite that was previously deferred. Currently this is
 	// done with all landscapes to speed up the program's startup.
 	static void Preload(const Sprite *sprite);
+	// Load the given sprite ahead of the others that are loading in the
+	// background, because it will be needed soon.
+	static void Prioritize(const Sprite *sprite);
+	// Start loading any streamed or background sprites that have been drawn,
+	// and if sprites are being streamed, unload the least recently drawn ones
+	// if the textures are over budget.
+	static void StreamSprites();
+	// Get the number of sprites that are waiting to be read, decoded, or
+	// uploaded to the graphics card.
+	static std::size_t SpriteBacklog();
 	static void FinishLoading();
+	// In debug mode, check whether any data files have been changed since they
+	// were loaded, and if so, load the objects they define again. Only objects
+	// that the state of the universe does not depend on can be reloaded. Return
+	// true if anything was.
+	static bool ReloadChangedFiles();
+	// Any other thread that creates objects from the game data, like ships from
+	// their fleet definitions, must hold this lock meanwhile, so that the data
+	// is not reloaded while it is being used.
+	static std::mutex &ReloadMutex();
 	
 	// Get the list of resource sources (i.e. plugin folders).
 	static const std::vector<std::string> &Sources();
@@ -79,6 +101,9 @@ public:
 	static void WriteEconomy(DataWriter &out);
 	static void StepEconomy();
 	static void AddPurchase(const System &system, const std::string &commodity, int tons);
+	// Get a number that changes every time the systems or planets are changed by
+	// an event or by reverting to the original game data.
+	static int Revision();
 	// Apply the given change to the universe.
 	static void Change(const DataNode &node);
 	// Update the neighbor lists of all the systems. This must be done any time
@@ -101,6 +126,11 @@ public:
 	static const Set<Interface> &Interfaces();
 	static const Set<Minable> &Minables();
 	static const Set<Mission> &Missions();
+	// Get the missions whose source and source filter match the given planet,
+	// or all the missions that are offered by boarding or assisting a ship.
+	// These lists are only recalculated when the game data changes.
+	static const std::vector<const Mission *> &MissionsFrom(const Planet *planet);
+	static const std::vector<const Mission *> &ShipMissions();
 	static const Set<Outfit> &Outfits();
 	static const Set<Sale<Outfit>> &Outfitters();
 	static const Set<Person> &Persons();
@@ -116,6 +146,9 @@ public:
 	
 	static const std::vector<Trade::Commodity> &Commodities();
 	static const std::vector<Trade::Commodity> &SpecialCommodities();
+	// Get the index of the given commodity in Commodities(), or the number of
+	// commodities if it is not an ordinary commodity.
+	static std::size_t CommodityIndex(const std::string &name);
 	
 	// Custom messages to be shown when trying to land on certain stellar objects.
 	static bool HasLandingMessage(const Sprite *sprite);
@@ -143,7 +176,8 @@ public:
 	
 private:
 	static void LoadSources();
-	static void LoadFile(const std::string &path, bool debugMode);
+	static void LoadFile(const DataFile &data, const std::string &path, bool debugMode);
+	static void LoadNode(const DataNode &node);
 	static std::map<std::string, std::shared_ptr<ImageSet>> FindImages();
 	
 	static void PrintShipTable();
@@ -16,6 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ImageBuffer.h"
 #include "Preferences.h"
 #include "Screen.h"
+#include "StreamBuffer.h"
+#include "Trace.h"
 
 #include "gl_header.h"
 #include <SDL2/SDL.h>
@@ -32,6 +34,7 @@ namespace {
 	int width = 0;
 	int height = 0;
 	bool hasSwizzle = false;
+	bool hasInstancing = false;
 		
 	// Logs SDL errors and returns true if found
 	bool checkSDLerror()
@@ -195,6 +198,13 @@ bool GameWindow::Init()
 	hasSwizzle = swizzled;
 #endif
 
+	// Instanced vertex attributes are only part of OpenGL 3.3 and later.
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	hasInstancing = (majorVersion > 3 || (majorVersion == 3 && minorVersion >= 3));
+
 	return true;
 }
 
@@ -223,6 +233,8 @@ void GameWindow::Quit()
 
 void GameWindow::Step()
 {
+	TRACE_SCOPE("GameWindow::Step");
+	StreamBuffer::EndFrame();
 	SDL_GL_SwapWindow(mainWindow);
 }
 
@@ -341,6 +353,21 @@ bool GameWindow::HasSwizzle()
 
 
 
+bool GameWindow::HasInstancing()
+{
+	return hasInstancing;
+}
+
+
+
+bool GameWindow::HasTimerQueries()
+{
+	// Timer queries became part of OpenGL in the same version as instancing.
+	return hasInstancing;
+}
+
+
+
 void GameWindow::ExitWithError(const string& message)
 {
 	// Print the error message in the terminal and the error file.
@@ -41,6 +41,10 @@ public:
 	
 	// Check if the initialized window system supports OpenGL texture_swizzle.
 	static bool HasSwizzle();
+	// Check if the OpenGL version supports instanced vertex attributes.
+	static bool HasInstancing();
+	// Check if the OpenGL version supports timer queries.
+	static bool HasTimerQueries();
 	
 	// Print the error message in the terminal, error file, and message box.
 	// Checks for video system errors and records those as well.
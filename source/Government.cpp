@@ -172,6 +172,15 @@ const Color &Government::GetColor() const
 
 
 
+// Get this government's index. Each government has a different one, and they
+// are numbered starting from zero.
+unsigned Government::Index() const
+{
+	return id;
+}
+
+
+
 // Get the government's initial disposition toward other governments or
 // toward the player.
 double Government::AttitudeToward(const Government *other) const
@@ -53,6 +53,9 @@ public:
 	int GetSwizzle() const;
 	// Get the color to use for displaying this government on the map.
 	const Color &GetColor() const;
+	// Get this government's index. Each government has a different one, and
+	// they are numbered starting from zero.
+	unsigned Index() const;
 	
 	// Get the government's initial disposition toward other governments or
 	// toward the player.
@@ -166,6 +166,15 @@ void Hardpoint::Step()
 
 
 
+// Check if stepping this weapon would not change anything, because it is fully
+// reloaded and has not fired recently.
+bool Hardpoint::IsIdle() const
+{
+	return reload <= 0. && burstReload <= 0. && !isFiring && !wasFiring;
+}
+
+
+
 // Adjust this weapon's aim by the given amount, relative to its maximum
 // "turret turn" rate.
 void Hardpoint::Aim(double amount)
@@ -56,6 +56,9 @@ public:
 	int BurstRemaining() const;
 	// Perform one step (i.e. decrement the reload count).
 	void Step();
+	// Check if stepping this weapon would not change anything, because it is
+	// fully reloaded and has not fired recently.
+	bool IsIdle() const;
 	
 	// Adjust this weapon's aim by the given amount, relative to its maximum
 	// "turret turn" rate.
@@ -13,19 +13,33 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ImageBuffer.h"
 
 #include "File.h"
+#include "MappedFile.h"
+#include "Trace.h"
 
 #include <png.h>
 #include <jpeglib.h>
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <vector>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 namespace {
-	bool ReadPNG(const string &path, ImageBuffer &buffer, int frame);
-	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame);
-	void Premultiply(ImageBuffer &buffer, int frame, int additive);
+	// The blending mode of an image determines how its colors must be
+	// premultiplied by its alpha once they are read.
+	const int ALREADY_PREMULTIPLIED = -1;
+	
+	bool ReadPNG(const char *data, size_t size, ImageBuffer &buffer, int frame, int additive);
+	bool ReadJPG(const char *data, size_t size, ImageBuffer &buffer, int frame, int additive);
+	bool ReadPNGSize(const string &path, int &width, int &height);
+	bool ReadJPGSize(const string &path, int &width, int &height);
+	void Premultiply(uint32_t *it, uint32_t *end, int additive);
 }
 
 
@@ -132,6 +146,30 @@ void ImageBuffer::ShrinkToHalfSize()
 		unsigned char *aIt = begin + (4 * width) * (2 * y);
 		unsigned char *aEnd = aIt + 4 * 2 * result.width;
 		unsigned char *bIt = begin + (4 * width) * (2 * y + 1);
+#ifdef __SSE2__
+		// Average four output pixels at a time. The sums of each channel fit in
+		// 16 bits, so the results are exactly the same as below.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		for( ; aEnd - aIt >= 32; aIt += 32, bIt += 32, out += 16)
+		{
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(aIt));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(aIt + 16));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bIt));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bIt + 16));
+			// Add the two rows, two input pixels at a time.
+			__m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+			__m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+			__m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+			__m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+			// Then add each pair of neighboring pixels.
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+			__m128i hi = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(lo, hi));
+		}
+#endif
 		for( ; aIt != aEnd; aIt += 4, bIt += 4)
 		{
 			for(int channel = 0; channel < 4; ++channel, ++aIt, ++bIt, ++out)
@@ -148,8 +186,28 @@ void ImageBuffer::ShrinkToHalfSize()
 
 bool ImageBuffer::Read(const string &path, int frame)
 {
+	// The image is decoded straight from the mapped file.
+	MappedFile file(path);
+	return Read(path, file.Data(), file.Size(), frame);
+}
+
+
+
+// Decode a single frame from the contents of an image file that have already
+// been read into memory. The path is only used to determine the file format
+// and the blending mode.
+bool ImageBuffer::Read(const string &path, const string &data, int frame)
+{
+	return Read(path, data.data(), data.size(), frame);
+}
+
+
+
+bool ImageBuffer::Read(const string &path, const char *data, size_t size, int frame)
+{
+	TRACE_SCOPE("ImageBuffer::Read");
 	// First, make sure this is a JPG or PNG file.
-	if(path.length() < 4)
+	if(path.length() < 4 || !size)
 		return false;
 	
 	string extension = path.substr(path.length() - 4);
@@ -158,11 +216,6 @@ bool ImageBuffer::Read(const string &path, int frame)
 	if(!isPNG && !isJPG)
 		return false;
 	
-	if(isPNG && !ReadPNG(path, *this, frame))
-		return false;
-	if(isJPG && !ReadJPG(path, *this, frame))
-		return false;
-	
 	// Check if the sprite uses additive blending. Start by getting the index of
 	// the last character before the frame number (if one is specified).
 	int pos = path.length() - 4;
@@ -172,24 +225,61 @@ bool ImageBuffer::Read(const string &path, int frame)
 		if(path[pos] < '0' || path[pos] > '9')
 			break;
 	// Special case: if the image is already in premultiplied alpha format,
-	// there is no need to apply premultiplication here.
-	if(path[pos] != '=')
-	{
-		int additive = (path[pos] == '+') ? 2 : (path[pos] == '~') ? 1 : 0;
-		if(isPNG || (isJPG && additive == 2))
-			Premultiply(*this, frame, additive);
-	}
-	return true;
+	// there is no need to apply premultiplication here. JPEGs have no alpha, so
+	// they only need it if they use additive blending.
+	int additive = (path[pos] == '+') ? 2 : (path[pos] == '~') ? 1 : 0;
+	if(path[pos] == '=' || (isJPG && additive != 2))
+		additive = ALREADY_PREMULTIPLIED;
+	
+	// The premultiplication is done to each batch of rows as soon as they are
+	// decoded, while they are still in the cache.
+	if(isPNG)
+		return ReadPNG(data, size, *this, frame, additive);
+	return ReadJPG(data, size, *this, frame, additive);
+}
+
+
+
+bool ImageBuffer::ReadSize(const string &path, int &width, int &height)
+{
+	if(path.length() < 4)
+		return false;
+	
+	string extension = path.substr(path.length() - 4);
+	if(extension == ".png" || extension == ".PNG")
+		return ReadPNGSize(path, width, height);
+	if(extension == ".jpg" || extension == ".JPG")
+		return ReadJPGSize(path, width, height);
+	return false;
 }
 
 
 
 namespace {
-	bool ReadPNG(const string &path, ImageBuffer &buffer, int frame)
+	// The part of an image file that libpng has not read yet.
+	class PNGSource {
+	public:
+		const char *it;
+		const char *end;
+	};
+	
+	
+	
+	void ReadPNGData(png_struct *png, png_byte *out, png_size_t size)
 	{
-		// Open the file, and make sure it really is a PNG.
-		File file(path);
-		if(!file)
+		PNGSource &source = *static_cast<PNGSource *>(png_get_io_ptr(png));
+		if(static_cast<size_t>(source.end - source.it) < size)
+			png_error(png, "unexpected end of file");
+		memcpy(out, source.it, size);
+		source.it += size;
+	}
+	
+	
+	
+	bool ReadPNG(const char *data, size_t size, ImageBuffer &buffer, int frame, int additive)
+	{
+		// Make sure the data really is a PNG.
+		if(png_sig_cmp(reinterpret_cast<png_const_bytep>(data), 0, min<size_t>(size, 8)))
 			return false;
 		
 		// Set up libpng.
@@ -210,7 +300,8 @@ namespace {
 			return false;
 		}
 		
-		png_init_io(png, file);
+		PNGSource source{data, data + size};
+		png_set_read_fn(png, &source, ReadPNGData);
 		png_set_sig_bytes(png, 0);
 		
 		png_read_info(png, info);
@@ -240,17 +331,32 @@ namespace {
 		if(colorType & PNG_COLOR_MASK_COLOR)
 			png_set_bgr(png);
 		// Let libpng handle any interlaced image decoding.
-		png_set_interlace_handling(png);
+		int passes = png_set_interlace_handling(png);
 		png_read_update_info(png, info);
 		
-		// Read the file.
-		vector<png_byte *> rows(height, nullptr);
-		for(int y = 0; y < height; ++y)
-			rows[y] = reinterpret_cast<png_byte *>(buffer.Begin(y, frame));
-		
-		png_read_image(png, &rows.front());
+		// Read the file. Unless the image is interlaced, each row is complete
+		// as soon as it is read, so it can be premultiplied right away.
+		if(passes == 1)
+			for(int y = 0; y < height; ++y)
+			{
+				uint32_t *row = buffer.Begin(y, frame);
+				png_read_row(png, reinterpret_cast<png_byte *>(row), nullptr);
+				if(additive != ALREADY_PREMULTIPLIED)
+					Premultiply(row, row + width, additive);
+			}
+		else
+		{
+			vector<png_byte *> rows(height, nullptr);
+			for(int y = 0; y < height; ++y)
+				rows[y] = reinterpret_cast<png_byte *>(buffer.Begin(y, frame));
+			
+			png_read_image(png, &rows.front());
+			if(additive != ALREADY_PREMULTIPLIED)
+				for(int y = 0; y < height; ++y)
+					Premultiply(buffer.Begin(y, frame), buffer.Begin(y, frame) + width, additive);
+		}
 		
-		// Clean up. The file will be closed automatically.
+		// Clean up.
 		png_destroy_read_struct(&png, &info, nullptr);
 		
 		return true;
@@ -258,18 +364,16 @@ namespace {
 	
 	
 	
-	bool ReadJPG(const string &path, ImageBuffer &buffer, int frame)
+	bool ReadJPG(const char *data, size_t size, ImageBuffer &buffer, int frame, int additive)
 	{
-		File file(path);
-		if(!file)
-			return false;
-		
 		jpeg_decompress_struct cinfo;
 		struct jpeg_error_mgr jerr;
 		cinfo.err = jpeg_std_error(&jerr);
 		jpeg_create_decompress(&cinfo);
 		
-		jpeg_stdio_src(&cinfo, file);
+		// Some versions of libjpeg take a non-const pointer here, even though
+		// they never modify the data.
+		jpeg_mem_src(&cinfo, reinterpret_cast<unsigned char *>(const_cast<char *>(data)), size);
 		jpeg_read_header(&cinfo, true);
 		cinfo.out_color_space = JCS_EXT_BGRA;
 		
@@ -291,8 +395,14 @@ namespace {
 		for(int y = 0; y < height; ++y)
 			rows[y] = reinterpret_cast<JSAMPLE *>(buffer.Begin(y, frame));
 		
-		while(height)
-			height -= jpeg_read_scanlines(&cinfo, &rows.front() + cinfo.output_scanline, height);
+		for(int y = 0; y < height; )
+		{
+			int end = y + jpeg_read_scanlines(&cinfo, &rows.front() + y, height - y);
+			if(additive != ALREADY_PREMULTIPLIED)
+				for( ; y < end; ++y)
+					Premultiply(buffer.Begin(y, frame), buffer.Begin(y, frame) + width, additive);
+			y = end;
+		}
 		
 		jpeg_finish_decompress(&cinfo);
 		jpeg_destroy_decompress(&cinfo);
@@ -302,29 +412,100 @@ namespace {
 	
 	
 	
-	void Premultiply(ImageBuffer &buffer, int frame, int additive)
+	bool ReadPNGSize(const string &path, int &width, int &height)
+	{
+		File file(path);
+		if(!file)
+			return false;
+		
+		// A PNG file must begin with its signature and then the IHDR chunk,
+		// which starts with the width and height as big-endian integers.
+		static const unsigned char SIGNATURE[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+		unsigned char header[24];
+		if(fread(header, 1, sizeof(header), file) != sizeof(header))
+			return false;
+		if(memcmp(header, SIGNATURE, sizeof(SIGNATURE)) || memcmp(header + 12, "IHDR", 4))
+			return false;
+		
+		width = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+		height = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+		return (width > 0 && height > 0);
+	}
+	
+	
+	
+	bool ReadJPGSize(const string &path, int &width, int &height)
+	{
+		File file(path);
+		if(!file)
+			return false;
+		
+		jpeg_decompress_struct cinfo;
+		struct jpeg_error_mgr jerr;
+		cinfo.err = jpeg_std_error(&jerr);
+		jpeg_create_decompress(&cinfo);
+		
+		// Reading the header does not decode any of the image data.
+		jpeg_stdio_src(&cinfo, file);
+		jpeg_read_header(&cinfo, true);
+		width = cinfo.image_width;
+		height = cinfo.image_height;
+		
+		jpeg_destroy_decompress(&cinfo);
+		return (width > 0 && height > 0);
+	}
+	
+	
+	
+	// Premultiply the given range of pixels by their alpha.
+	void Premultiply(uint32_t *it, uint32_t *end, int additive)
 	{
-		for(int y = 0; y < buffer.Height(); ++y)
+#ifdef __SSE2__
+		// Premultiply four pixels at a time. Opaque pixels are not skipped, but
+		// with ordinary blending premultiplying them does not change them. The
+		// division by 255 is exact for any product of two bytes.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i colorMask = _mm_set1_epi32(0xFFFFFF);
+		for( ; end - it >= 4; it += 4)
 		{
-			uint32_t *it = buffer.Begin(y, frame);
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(it));
+			__m128i lo = _mm_unpacklo_epi8(value, zero);
+			__m128i hi = _mm_unpackhi_epi8(value, zero);
+			__m128i loAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i hiAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			lo = _mm_add_epi16(_mm_mullo_epi16(lo, loAlpha), one);
+			hi = _mm_add_epi16(_mm_mullo_epi16(hi, hiAlpha), one);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+			__m128i result = _mm_and_si128(_mm_packus_epi16(lo, hi), colorMask);
 			
-			for(uint32_t *end = it + buffer.Width(); it != end; ++it)
-			{
-				uint64_t value = *it;
-				uint64_t alpha = (value & 0xFF000000) >> 24;
-				
-				uint64_t red = (((value & 0xFF0000) * alpha) / 255) & 0xFF0000;
-				uint64_t green = (((value & 0xFF00) * alpha) / 255) & 0xFF00;
-				uint64_t blue = (((value & 0xFF) * alpha) / 255) & 0xFF;
-				
-				value = red | green | blue;
-				if(additive == 1)
-					alpha >>= 2;
-				if(additive != 2)
-					value |= (alpha << 24);
-				
-				*it = static_cast<uint32_t>(value);
-			}
+			if(additive == 1)
+				result = _mm_or_si128(result, _mm_slli_epi32(_mm_srli_epi32(value, 26), 24));
+			else if(additive != 2)
+				result = _mm_or_si128(result, _mm_andnot_si128(colorMask, value));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(it), result);
+		}
+#endif
+		for( ; it != end; ++it)
+		{
+			uint64_t value = *it;
+			uint64_t alpha = (value & 0xFF000000) >> 24;
+			// Opaque pixels with ordinary blending do not change.
+			if(alpha == 255 && !additive)
+				continue;
+			
+			uint64_t red = (((value & 0xFF0000) * alpha) / 255) & 0xFF0000;
+			uint64_t green = (((value & 0xFF00) * alpha) / 255) & 0xFF00;
+			uint64_t blue = (((value & 0xFF) * alpha) / 255) & 0xFF;
+			
+			value = red | green | blue;
+			if(additive == 1)
+				alpha >>= 2;
+			if(additive != 2)
+				value |= (alpha << 24);
+			
+			*it = static_cast<uint32_t>(value);
 		}
 	}
 }
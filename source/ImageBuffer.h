@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef IMAGE_BUFFER_H_
 #define IMAGE_BUFFER_H_
 
+#include <cstddef>
 #include <string>
 
 
@@ -54,6 +55,14 @@ public:
 	// Read a single frame. Return false if an error is encountered - either the
 	// image is the wrong size, or it is not a supported image format.
 	bool Read(const std::string &path, int frame = 0);
+	// Decode a single frame from the contents of an image file that have
+	// already been read into memory. The path is only used to determine the
+	// file format and the blending mode.
+	bool Read(const std::string &path, const std::string &data, int frame = 0);
+	bool Read(const std::string &path, const char *data, std::size_t size, int frame = 0);
+	// Read just the dimensions of the image at the given path, without decoding
+	// any of its pixels. Return false if that is not possible.
+	static bool ReadSize(const std::string &path, int &width, int &height);
 	
 	
 private:
@@ -14,11 +14,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Files.h"
 #include "Mask.h"
+#include "MaskCache.h"
 #include "Sprite.h"
 
+#include <algorithm>
+#include <atomic>
+
 using namespace std;
 
 namespace {
+	// Until the game knows what kind of screen it is drawing to, assume that
+	// the @2x frames will be needed.
+	atomic<bool> use2x(true);
+	
 	// Check if the given character is a valid blending mode.
 	bool IsBlend(char c)
 	{
@@ -45,6 +53,15 @@ namespace {
 		// are part of the sprite name, not a frame index.
 		return (IsBlend(path[pos]) ? pos : end);
 	}
+	
+	// Decode the given frame from the file contents that were read for it, or
+	// read the file now if that was never done.
+	bool ReadFrame(ImageBuffer &buffer, const string &path, const vector<string> &files, size_t frame)
+	{
+		if(frame < files.size() && !files[frame].empty())
+			return buffer.Read(path, files[frame], frame);
+		return buffer.Read(path, frame);
+	}
 }
 
 
@@ -131,6 +148,53 @@ bool ImageSet::IsMasked(const string &path)
 
 
 
+// Determine whether the given path or name is for a sprite that does not
+// need to be loaded until it is first drawn, if sprites are being streamed.
+bool ImageSet::IsStreamed(const string &path)
+{
+	// Masks can only be made from the loaded frames, and the interface should
+	// never be missing any of its images, so those sprites are always loaded.
+	if(IsMasked(path))
+		return false;
+	if(path.length() >= 3 && !path.compare(0, 3, "ui/"))
+		return false;
+	
+	return true;
+}
+
+
+
+// Determine whether the given path or name is for a sprite that must be loaded
+// before the main menu can be shown. Other sprites are loaded in the background.
+bool ImageSet::IsEssential(const string &path)
+{
+	if(path.length() >= 6 && !path.compare(0, 6, "_menu/"))
+		return true;
+	if(path.length() >= 3 && !path.compare(0, 3, "ui/"))
+		return true;
+	
+	return false;
+}
+
+
+
+// Set whether the @2x frames of sprites should be loaded. They are only drawn
+// on high resolution screens or when the view is zoomed in, so until then they
+// can be skipped. This is safe to call from any thread.
+void ImageSet::SetUse2x(bool use)
+{
+	use2x.store(use, memory_order_relaxed);
+}
+
+
+
+bool ImageSet::Uses2x()
+{
+	return use2x.load(memory_order_relaxed);
+}
+
+
+
 // Constructor, optionally specifying the name (for image sets like the
 // plugin icons, whose name can't be determined from the path names).
 ImageSet::ImageSet(const string &name)
@@ -187,9 +251,190 @@ void ImageSet::Check() const
 
 
 
+// Read the files that Load() needs into memory, without decoding any of them.
+// Disk reads are slowest if they are spread out over many threads, so this
+// should be called from a thread that reads the sprites one at a time. If this
+// is not called first, Load() reads the files itself.
+void ImageSet::Read()
+{
+	isRead = true;
+	if(HasCompressed())
+	{
+		compressedFile = Files::Read(CompressedPath());
+		return;
+	}
+	bool load1x = !only2x;
+	bool load2x = only2x || Uses2x();
+	size_t frames = paths[0].size();
+	for(int i = 0; i < 2; ++i)
+		if(i ? load2x : load1x)
+		{
+			files[i].resize(min(frames, paths[i].size()));
+			for(size_t j = 0; j < files[i].size(); ++j)
+				if(!paths[i][j].empty())
+					files[i][j] = Files::Read(paths[i][j]);
+		}
+}
+
+
+
+// Get the number of bytes of file data that Read() is holding.
+size_t ImageSet::ReadSize() const
+{
+	size_t size = compressedFile.size();
+	for(const vector<string> &list : files)
+		for(const string &file : list)
+			size += file.size();
+	return size;
+}
+
+
+
 // Load all the frames. This should be called in one of the image-loading
-// worker threads. This also generates collision masks if needed.
+// worker threads. This also generates collision masks if needed. If there
+// is an up to date compressed copy of the frames, it is loaded instead.
 void ImageSet::Load()
+{
+	if(!isRead)
+		Read();
+	
+	bool load2x = Uses2x() && !paths[1].empty();
+	if(only2x)
+	{
+		// The compressed file holds both sets of frames, but the 1x frames are
+		// already loaded.
+		if(LoadCompressed())
+		{
+			compressed[0].Clear();
+			masks.clear();
+		}
+		else
+			Decode(false, true);
+	}
+	else if(LoadCompressed())
+	{
+		if(!load2x)
+			compressed[1].Clear();
+	}
+	else
+		Decode(true, load2x);
+	skipped2x = !paths[1].empty() && !load2x;
+	
+	// The file contents are no longer needed.
+	isRead = false;
+	compressedFile.clear();
+	compressedFile.shrink_to_fit();
+	files[0].clear();
+	files[1].clear();
+}
+
+
+
+// Decode the frames, compress them, and save the compressed copy along with
+// the masks next to the original images.
+void ImageSet::Compress()
+{
+	if(paths[0].empty())
+		return;
+	
+	Decode(true, true);
+	for(int i = 0; i < 2; ++i)
+	{
+		compressed[i].Compress(buffer[i]);
+		buffer[i].Clear();
+	}
+	CompressedImage::WriteFile(CompressedPath(), compressed, masks);
+	
+	compressed[0].Clear();
+	compressed[1].Clear();
+	masks.clear();
+}
+
+
+
+// Create the sprite and upload the image data to the GPU. After this is
+// called, the internal image buffers and mask vector will be cleared, but
+// the paths are saved in case the sprite needs to be loaded again.
+void ImageSet::Upload(Sprite *sprite)
+{
+	// If the @2x frames are no longer needed by the time they are uploaded,
+	// skip them, so they do not use up texture memory.
+	if(!Uses2x() && !paths[1].empty())
+	{
+		buffer[1].Clear();
+		compressed[1].Clear();
+		skipped2x = true;
+	}
+	
+	// Load the frames. This will clear the buffers and the mask vector.
+	if(compressed[0].Frames() || compressed[1].Frames())
+	{
+		sprite->AddFrames(compressed[0], false);
+		sprite->AddFrames(compressed[1], true);
+		compressed[0].Clear();
+		compressed[1].Clear();
+	}
+	else
+	{
+		sprite->AddFrames(buffer[0], false);
+		sprite->AddFrames(buffer[1], true);
+	}
+	// If only the @2x frames were loaded, the masks are already in place.
+	if(!only2x)
+		sprite->AddMasks(masks);
+	only2x = false;
+}
+
+
+
+// Check whether this sprite has @2x frames that were skipped the last time it
+// was loaded. If so, they can be added later without reloading the rest of the
+// sprite: after calling Set2xOnly(), the next Load() and Upload() only handle
+// the @2x frames.
+bool ImageSet::Skipped2x() const
+{
+	return skipped2x;
+}
+
+
+
+void ImageSet::Set2xOnly()
+{
+	only2x = true;
+}
+
+
+
+// Get the number of bytes of image data that Upload() will send to the GPU.
+size_t ImageSet::UploadSize() const
+{
+	size_t size = 0;
+	for(int i = 0; i < 2; ++i)
+	{
+		if(compressed[i].Frames())
+			size += compressed[i].Data().size();
+		else
+			size += static_cast<size_t>(buffer[i].Width()) * buffer[i].Height() * buffer[i].Frames() * 4;
+	}
+	return size;
+}
+
+
+
+// Give the sprite its dimensions without loading any of its frames, so it
+// can be laid out and culled before its textures are streamed in.
+void ImageSet::LoadSize(Sprite *sprite) const
+{
+	int width = 0;
+	int height = 0;
+	if(!paths[0].empty() && ImageBuffer::ReadSize(paths[0][0], width, height))
+		sprite->SetSize(width, height, paths[0].size());
+}
+
+
+
+// Decode the frames from the original images.
+void ImageSet::Decode(bool load1x, bool load2x)
 {
 	// Determine how many frames there will be, total. The image buffers will
 	// not actually be allocated until the first image is loaded (at which point
@@ -199,30 +444,84 @@ void ImageSet::Load()
 	buffer[1].Clear(frames);
 	
 	// Check whether we need to generate collision masks.
-	bool makeMasks = IsMasked(name);
+	bool makeMasks = load1x && IsMasked(name);
 	if(makeMasks)
 		masks.resize(frames);
 	
 	// Load the 1x sprites first, then the 2x sprites, because they are likely
-	// to be in separate locations on the disk. Create masks if needed.
-	for(size_t i = 0; i < frames; ++i)
-		if(buffer[0].Read(paths[0][i], i) && makeMasks)
+	// to be in separate locations on the disk. Create masks if needed, unless
+	// they were already traced from the same images the last time. If the files
+	// were not read already (or the compressed copy that was read turned out not
+	// to be valid), they are read now.
+	for(size_t i = 0; load1x && i < frames; ++i)
+		if(ReadFrame(buffer[0], paths[0][i], files[0], i) && makeMasks && !MaskCache::Get(paths[0][i], masks[i]))
+		{
 			masks[i].Create(buffer[0], i);
+			if(masks[i].IsLoaded())
+				MaskCache::Set(paths[0][i], masks[i]);
+		}
 	// Now, load the 2x sprites, if they exist. Because the number of 1x frames
 	// is definitive, don't load any frames beyond the size of the 1x list.
-	for(size_t i = 0; i < frames && i < paths[1].size(); ++i)
-		buffer[1].Read(paths[1][i], i);
+	for(size_t i = 0; load2x && i < frames && i < paths[1].size(); ++i)
+		ReadFrame(buffer[1], paths[1][i], files[1], i);
 }
 
 
 
-// Create the sprite and upload the image data to the GPU. After this is
-// called, the internal image buffers and mask vector will be cleared, but
-// the paths are saved in case the sprite needs to be loaded again.
-void ImageSet::Upload(Sprite *sprite)
+// Get the path to the compressed copy of this sprite's frames. It is stored in
+// the same directory as the first frame, so that if a plugin replaces some of
+// the sprite's images, a compressed copy in some other directory is not used.
+string ImageSet::CompressedPath() const
 {
-	// Load the frames. This will clear the buffers and the mask vector.
-	sprite->AddFrames(buffer[0], false);
-	sprite->AddFrames(buffer[1], true);
-	sprite->AddMasks(masks);
+	const string &first = paths[0].front();
+	return first.substr(0, first.rfind('/') + 1) + name.substr(name.rfind('/') + 1) + ".bc3";
+}
+
+
+
+// Check whether the compressed frames exist and are newer than all the
+// original images.
+bool ImageSet::HasCompressed() const
+{
+	if(paths[0].empty())
+		return false;
+	
+	string path = CompressedPath();
+	if(!Files::Exists(path))
+		return false;
+	
+	// If any of the images is in a different directory (e.g. because a plugin
+	// replaced it) or has changed since it was compressed, don't use the file.
+	size_t directory = path.rfind('/') + 1;
+	time_t timestamp = Files::Timestamp(path);
+	for(const vector<string> &list : paths)
+		for(const string &source : list)
+		{
+			if(source.compare(0, directory, path, 0, directory) || source.find('/', directory) != string::npos)
+				return false;
+			if(Files::Timestamp(source) > timestamp)
+				return false;
+		}
+	return true;
+}
+
+
+
+// Load the compressed frames, if Read() found an up to date copy of them.
+bool ImageSet::LoadCompressed()
+{
+	if(compressedFile.empty())
+		return false;
+	
+	// The file must match the images that it was made from.
+	if(!CompressedImage::ReadData(compressedFile, compressed, masks)
+			|| compressed[0].Frames() != static_cast<int>(paths[0].size())
+			|| (compressed[1].Frames() && compressed[1].Frames() != compressed[0].Frames()))
+	{
+		compressed[0].Clear();
+		compressed[1].Clear();
+		masks.clear();
+		return false;
+	}
+	return true;
 }
@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef IMAGE_SET_H_
 #define IMAGE_SET_H_
 
+#include "CompressedImage.h"
 #include "ImageBuffer.h"
 
 #include <string>
@@ -43,6 +44,17 @@ public:
 	// Determine whether the given path or name is to a sprite for which a
 	// collision mask ought to be generated.
 	static bool IsMasked(const std::string &path);
+	// Determine whether the given path or name is for a sprite that does not
+	// need to be loaded until it is first drawn, if sprites are being streamed.
+	static bool IsStreamed(const std::string &path);
+	// Determine whether the given path or name is for a sprite that must be
+	// loaded before the main menu can be shown.
+	static bool IsEssential(const std::string &path);
+	// Set whether the @2x frames of sprites should be loaded. They are only
+	// drawn on high resolution screens or when the view is zoomed in, so until
+	// then they can be skipped. This is safe to call from any thread.
+	static void SetUse2x(bool use);
+	static bool Uses2x();
 	
 	
 public:
@@ -58,13 +70,48 @@ public:
 	// Check this image set to determine whether any frames are missing. Report
 	// an error for each missing frame. (It will be left uninitialized.)
 	void Check() const;
+	// Read the files that Load() needs into memory, without decoding any of
+	// them. Disk reads are slowest if they are spread out over many threads,
+	// so this should be called from a thread that reads the sprites one at a
+	// time. If this is not called first, Load() reads the files itself.
+	void Read();
+	// Get the number of bytes of file data that Read() is holding.
+	size_t ReadSize() const;
 	// Load all the frames. This should be called in one of the image-loading
-	// worker threads. This also generates collision masks if needed.
+	// worker threads. This also generates collision masks if needed. If there
+	// is an up to date compressed copy of the frames, it is loaded instead.
 	void Load();
+	// Decode the frames, compress them, and save the compressed copy along with
+	// the masks next to the original images, so that later calls to Load() can
+	// just read that file instead.
+	void Compress();
 	// Create the sprite and upload the image data to the GPU. After this is
 	// called, the internal image buffers and mask vector will be cleared, but
 	// the paths are saved in case the sprite needs to be loaded again.
 	void Upload(Sprite *sprite);
+	// Get the number of bytes of image data that Upload() will send to the GPU.
+	size_t UploadSize() const;
+	// Check whether this sprite has @2x frames that were skipped the last time
+	// it was loaded. If so, they can be added later without reloading the rest
+	// of the sprite: after calling Set2xOnly(), the next Load() and Upload()
+	// only handle the @2x frames.
+	bool Skipped2x() const;
+	void Set2xOnly();
+	// Give the sprite its dimensions without loading any of its frames, so it
+	// can be laid out and culled before its textures are streamed in.
+	void LoadSize(Sprite *sprite) const;
+	
+	
+private:
+	// Decode the frames from the original images.
+	void Decode(bool load1x, bool load2x);
+	// Get the path to the compressed copy of this sprite's frames.
+	std::string CompressedPath() const;
+	// Check whether the compressed frames exist and are newer than all the
+	// original images.
+	bool HasCompressed() const;
+	// Load the compressed frames, if Read() found an up to date copy of them.
+	bool LoadCompressed();
 	
 	
 private:
@@ -74,7 +121,15 @@ private:
 	std::vector<std::string> paths[2];
 	// Data loaded from the images:
 	ImageBuffer buffer[2];
+	CompressedImage compressed[2];
 	std::vector<Mask> masks;
+	// The contents of the files, if they have been read but not decoded yet.
+	bool isRead = false;
+	std::string compressedFile;
+	std::vector<std::string> files[2];
+	// Whether the @2x frames were skipped, and whether only they are loaded.
+	bool skipped2x = false;
+	bool only2x = false;
 };
 
 
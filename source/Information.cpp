@@ -14,110 +14,256 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sprite.h"
 
+#include <map>
+#include <mutex>
+
 using namespace std;
 
+namespace {
+	// Give the given name a key, if it does not have one yet, and return the
+	// key's index. Interfaces may be loaded in a different thread than the
+	// one that fills them in. Keys may also be static variables, so the list
+	// of them must be created the first time it is used.
+	int KeyIndex(const string &name)
+	{
+		static map<string, int> keys;
+		static mutex keyMutex;
+		
+		lock_guard<mutex> lock(keyMutex);
+		return keys.emplace(name, static_cast<int>(keys.size())).first->second;
+	}
+	
+	const Point UP(0., -1.);
+	const string EMPTY_STRING;
+	
+	// Make sure the given list has a place for the given key, and return it.
+	template <class Type>
+	typename vector<Type>::reference Slot(vector<Type> &list, int index)
+	{
+		if(static_cast<size_t>(index) >= list.size())
+			list.resize(index + 1);
+		return list[index];
+	}
+	
+	// Check if the given key is in the given list.
+	template <class Type>
+	bool HasSlot(const vector<Type> &list, int index)
+	{
+		return index >= 0 && static_cast<size_t>(index) < list.size();
+	}
+}
+
+
+
+Information::Key::Key(const string &name)
+{
+	if(!name.empty())
+		index = KeyIndex(name);
+}
+
+
+
+bool Information::Key::IsEmpty() const
+{
+	return index < 0;
+}
+
+
+
+// Remove all the values but keep the space set aside for them.
+void Information::Clear()
+{
+	for(SpriteSlot &slot : sprites)
+		slot = SpriteSlot();
+	for(string &value : strings)
+		value.clear();
+	for(BarSlot &slot : bars)
+		slot = BarSlot();
+	conditions.assign(conditions.size(), false);
+	outlineColor = Color();
+}
+
+
+
+void Information::SetSprite(const Key &key, const Sprite *sprite, const Point &unit, float frame)
+{
+	if(key.IsEmpty())
+		return;
+	
+	SpriteSlot &slot = Slot(sprites, key.index);
+	slot.sprite = sprite;
+	slot.unit = unit;
+	slot.frame = frame;
+	slot.isSet = true;
+}
+
 
 
 void Information::SetSprite(const string &name, const Sprite *sprite, const Point &unit, float frame)
 {
-	sprites[name] = sprite;
-	spriteUnits[name] = unit;
-	spriteFrames[name] = frame;
+	SetSprite(Key(name), sprite, unit, frame);
 }
 
 
 
-const Sprite *Information::GetSprite(const string &name) const
+const Sprite *Information::GetSprite(const Key &key) const
 {
 	static const Sprite empty;
 	
-	auto it = sprites.find(name);
-	return (it == sprites.end()) ? &empty : it->second;
+	if(!HasSlot(sprites, key.index) || !sprites[key.index].isSet)
+		return &empty;
+	
+	return sprites[key.index].sprite;
+}
+
+
+
+const Sprite *Information::GetSprite(const string &name) const
+{
+	return GetSprite(Key(name));
+}
+
+
+
+const Point &Information::GetSpriteUnit(const Key &key) const
+{
+	return HasSlot(sprites, key.index) ? sprites[key.index].unit : UP;
 }
 
 
 
 const Point &Information::GetSpriteUnit(const string &name) const
 {
-	static const Point up(0., -1.);
-	
-	auto it = spriteUnits.find(name);
-	return (it == spriteUnits.end()) ? up : it->second;
+	return GetSpriteUnit(Key(name));
+}
+
+
+
+float Information::GetSpriteFrame(const Key &key) const
+{
+	return HasSlot(sprites, key.index) ? sprites[key.index].frame : 0.f;
 }
 
 
 
 float Information::GetSpriteFrame(const string &name) const
 {
-	auto it = spriteFrames.find(name);
-	return (it == spriteFrames.end()) ? 0.f : it->second;
+	return GetSpriteFrame(Key(name));
+}
+
+
+
+void Information::SetString(const Key &key, const string &value)
+{
+	if(!key.IsEmpty())
+		Slot(strings, key.index) = value;
 }
 
 
 
 void Information::SetString(const string &name, const string &value)
 {
-	strings[name] = value;
+	SetString(Key(name), value);
+}
+
+
+
+const string &Information::GetString(const Key &key) const
+{
+	return HasSlot(strings, key.index) ? strings[key.index] : EMPTY_STRING;
 }
 
 
 
 const string &Information::GetString(const string &name) const
 {
-	static const string empty;
+	return GetString(Key(name));
+}
+
+
+
+void Information::SetBar(const Key &key, double value, double segments)
+{
+	if(key.IsEmpty())
+		return;
 	
-	auto it = strings.find(name);
-	return (it == strings.end()) ? empty : it->second;
+	BarSlot &slot = Slot(bars, key.index);
+	slot.value = value;
+	slot.segments = segments;
 }
 
 
 
 void Information::SetBar(const string &name, double value, double segments)
 {
-	bars[name] = value;
-	barSegments[name] = segments;
+	SetBar(Key(name), value, segments);
+}
+
+
+
+double Information::BarValue(const Key &key) const
+{
+	return HasSlot(bars, key.index) ? bars[key.index].value : 0.;
 }
 
 
 
 double Information::BarValue(const string &name) const
 {
-	auto it = bars.find(name);
-	
-	return (it == bars.end()) ? 0. : it->second;
+	return BarValue(Key(name));
+}
+
+
+
+double Information::BarSegments(const Key &key) const
+{
+	return HasSlot(bars, key.index) ? bars[key.index].segments : 1.;
 }
 
 
 
 double Information::BarSegments(const string &name) const
 {
-	auto it = barSegments.find(name);
-	
-	return (it == barSegments.end()) ? 1. : it->second;
+	return BarSegments(Key(name));
 }
 
 
-	
+
+void Information::SetCondition(const Key &key)
+{
+	if(!key.IsEmpty())
+		Slot(conditions, key.index) = true;
+}
+
+
+
 void Information::SetCondition(const string &condition)
 {
-	conditions.insert(condition);
+	SetCondition(Key(condition));
 }
 
 
 
-bool Information::HasCondition(const string &condition) const
+bool Information::HasCondition(const Key &key) const
 {
-	if(condition.empty())
+	if(key.IsEmpty())
 		return true;
 	
-	if(condition.front() == '!')
+	return HasSlot(conditions, key.index) && conditions[key.index];
+}
+
+
+
+bool Information::HasCondition(const string &condition) const
+{
+	if(!condition.empty() && condition.front() == '!')
 		return !HasCondition(condition.substr(1));
 	
-	return conditions.count(condition);
+	return HasCondition(Key(condition));
 }
 
 
-	
+
 void Information::SetOutlineColor(const Color &color)
 {
 	outlineColor = color;
@@ -16,9 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Color.h"
 #include "Point.h"
 
-#include <map>
-#include <set>
 #include <string>
+#include <vector>
 
 class Sprite;
 
@@ -28,19 +27,54 @@ class Sprite;
 // of how that information is laid out or shown.
 class Information {
 public:
+	// A name that has been looked up once, so that it can be used to set or
+	// get a value without comparing strings. The same name always gives the
+	// same key, so interfaces can find their keys when they are loaded and
+	// whatever fills in the information can keep its keys in static variables.
+	class Key {
+	public:
+		// The empty name is a condition that is always true.
+		Key() = default;
+		explicit Key(const std::string &name);
+		
+		bool IsEmpty() const;
+		
+	private:
+		int index = -1;
+		
+		friend class Information;
+	};
+	
+	
+public:
+	// Remove all the values but keep the space set aside for them, so that an
+	// object that is filled in every frame need not allocate anything anew.
+	void Clear();
+	
+	void SetSprite(const Key &key, const Sprite *sprite, const Point &unit = Point(0., -1.), float frame = 0.f);
 	void SetSprite(const std::string &name, const Sprite *sprite, const Point &unit = Point(0., -1.), float frame = 0.f);
+	const Sprite *GetSprite(const Key &key) const;
 	const Sprite *GetSprite(const std::string &name) const;
+	const Point &GetSpriteUnit(const Key &key) const;
 	const Point &GetSpriteUnit(const std::string &name) const;
+	float GetSpriteFrame(const Key &key) const;
 	float GetSpriteFrame(const std::string &name) const;
 	
+	void SetString(const Key &key, const std::string &value);
 	void SetString(const std::string &name, const std::string &value);
+	const std::string &GetString(const Key &key) const;
 	const std::string &GetString(const std::string &name) const;
 	
+	void SetBar(const Key &key, double value, double segments = 0.);
 	void SetBar(const std::string &name, double value, double segments = 0.);
+	double BarValue(const Key &key) const;
 	double BarValue(const std::string &name) const;
+	double BarSegments(const Key &key) const;
 	double BarSegments(const std::string &name) const;
 	
+	void SetCondition(const Key &key);
 	void SetCondition(const std::string &condition);
+	bool HasCondition(const Key &key) const;
 	bool HasCondition(const std::string &condition) const;
 	
 	void SetOutlineColor(const Color &color);
@@ -48,14 +82,27 @@ public:
 	
 	
 private:
-	std::map<std::string, const Sprite *> sprites;
-	std::map<std::string, Point> spriteUnits;
-	std::map<std::string, float> spriteFrames;
-	std::map<std::string, std::string> strings;
-	std::map<std::string, double> bars;
-	std::map<std::string, double> barSegments;
+	class SpriteSlot {
+	public:
+		const Sprite *sprite = nullptr;
+		Point unit = Point(0., -1.);
+		float frame = 0.f;
+		bool isSet = false;
+	};
+	class BarSlot {
+	public:
+		double value = 0.;
+		double segments = 1.;
+	};
+	
 	
-	std::set<std::string> conditions;
+private:
+	// Each value is stored at its key's index. Values that have never been
+	// set may be past the end of their list.
+	std::vector<SpriteSlot> sprites;
+	std::vector<std::string> strings;
+	std::vector<BarSlot> bars;
+	std::vector<bool> conditions;
 	
 	Color outlineColor;
 };
@@ -30,6 +30,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 using namespace std;
 
@@ -53,6 +54,13 @@ namespace {
 		}
 		return alignment;
 	}
+	
+	// Mix the given value into a hash of everything an interface displays.
+	template <class Type>
+	void Combine(size_t &seed, const Type &value)
+	{
+		seed ^= hash<Type>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	}
 }
 
 
@@ -77,6 +85,8 @@ void Interface::Load(const DataNode &node)
 	elements.clear();
 	points.clear();
 	values.clear();
+	isCached = false;
+	isCacheCurrent = false;
 	
 	// First, figure out the anchor point of this interface.
 	Point anchor = ParseAlignment(node, 2);
@@ -88,6 +98,8 @@ void Interface::Load(const DataNode &node)
 	{
 		if(child.Token(0) == "anchor")
 			anchor = ParseAlignment(child);
+		else if(child.Token(0) == "cache")
+			isCached = true;
 		else if(child.Token(0) == "value" && child.Size() >= 3)
 			values[child.Token(1)] = child.Value(2);
 		else if((child.Token(0) == "point" || child.Token(0) == "box") && child.Size() >= 2)
@@ -130,8 +142,49 @@ void Interface::Load(const DataNode &node)
 // Draw this interface.
 void Interface::Draw(const Information &info, Panel *panel) const
 {
-	for(const Element *element : elements)
-		element->Draw(info, panel);
+	if(!isCached)
+	{
+		for(const Element *element : elements)
+			element->Draw(info, panel);
+		return;
+	}
+	
+	// Find out if anything this interface shows has changed since it was last
+	// drawn into the cache. If not, only the clickable zones need to be added.
+	// Each element's conditions are only tested once.
+	size_t hash = 0;
+	Combine(hash, Screen::Width());
+	Combine(hash, Screen::Height());
+	Combine(hash, Font::IsShowingUnderlines());
+	states.resize(elements.size());
+	for(size_t i = 0; i < elements.size(); ++i)
+	{
+		states[i] = elements[i]->GetState(info);
+		elements[i]->Hash(info, states[i], hash);
+	}
+	
+	if(isCacheCurrent && hash == cacheHash && cache.IsCurrent())
+	{
+		for(size_t i = 0; i < elements.size(); ++i)
+			elements[i]->AddZones(panel, states[i]);
+	}
+	else if(cache.Begin())
+	{
+		for(size_t i = 0; i < elements.size(); ++i)
+			elements[i]->Draw(info, panel, states[i]);
+		cache.End();
+		cacheHash = hash;
+		isCacheCurrent = true;
+	}
+	else
+	{
+		// If offscreen drawing is not possible, draw directly to the screen.
+		for(size_t i = 0; i < elements.size(); ++i)
+			elements[i]->Draw(info, panel, states[i]);
+		isCacheCurrent = false;
+		return;
+	}
+	cache.Draw();
 }
 
 
@@ -296,15 +349,19 @@ void Interface::Element::Load(const DataNode &node, const Point &globalAnchor)
 // button, it will add a clickable zone to the given panel.
 void Interface::Element::Draw(const Information &info, Panel *panel) const
 {
-	if(!info.HasCondition(visibleIf))
+	Draw(info, panel, GetState(info));
+}
+
+
+
+// Draw this element, with a state that was already found by GetState().
+void Interface::Element::Draw(const Information &info, Panel *panel, int state) const
+{
+	if(state == HIDDEN)
 		return;
 	
 	// Get the bounding box of this element, relative to the anchor point.
 	Rectangle box = Bounds();
-	// Check if this element is active.
-	int state = info.HasCondition(activeIf);
-	// Check if the mouse is hovering over this element.
-	state += (state && box.Contains(UI::GetMouse()));
 	// Place buttons even if they are inactive, in case the UI wants to show a
 	// message explaining why the button is inactive.
 	if(panel)
@@ -320,12 +377,55 @@ void Interface::Element::Draw(const Information &info, Panel *panel) const
 
 
 
+// Add this element's clickable zone to the given panel without drawing it.
+void Interface::Element::AddZones(Panel *panel, int state) const
+{
+	if(panel && state != HIDDEN)
+		Place(Bounds(), panel);
+}
+
+
+
+// Mix everything that affects how this element is drawn into the given hash.
+void Interface::Element::Hash(const Information &info, int state, size_t &hash) const
+{
+	Combine(hash, state);
+	if(state != HIDDEN)
+		HashContents(info, state, hash);
+}
+
+
+
+// Get the current state of this element: hidden, inactive, active, or hover.
+// This tests its conditions, so it should only be done once for each time that
+// the element is drawn.
+int Interface::Element::GetState(const Information &info) const
+{
+	if(info.HasCondition(visibleIf) == isVisibleIfNot)
+		return HIDDEN;
+	
+	// Check if this element is active.
+	int state = (info.HasCondition(activeIf) != isActiveIfNot);
+	// Check if the mouse is hovering over this element.
+	state += (state && Bounds().Contains(UI::GetMouse()));
+	return state;
+}
+
+
+
 // Set the conditions that control when this element is visible and active.
 // An empty string means it is always visible or active.
 void Interface::Element::SetConditions(const string &visible, const string &active)
 {
-	visibleIf = visible;
-	activeIf = active;
+	// Strip off any "!" now, rather than every time the conditions are tested.
+	size_t visibleStart = visible.find_first_not_of('!');
+	size_t activeStart = active.find_first_not_of('!');
+	visibleStart = min(visibleStart, visible.length());
+	activeStart = min(activeStart, active.length());
+	visibleIf = Information::Key(visible.substr(visibleStart));
+	activeIf = Information::Key(active.substr(activeStart));
+	isVisibleIfNot = visibleStart % 2;
+	isActiveIfNot = activeStart % 2;
 }
 
 
@@ -362,6 +462,13 @@ void Interface::Element::Draw(const Rectangle &rect, const Information &info, in
 
 
 
+// Mix the information this element displays into the given hash.
+void Interface::Element::HashContents(const Information &info, int state, size_t &hash) const
+{
+}
+
+
+
 // Add any click handlers needed for this element. This will only be
 // called if the element is visible and active.
 void Interface::Element::Place(const Rectangle &bounds, Panel *panel) const
@@ -385,7 +492,7 @@ Interface::ImageElement::ImageElement(const DataNode &node, const Point &globalA
 	if(node.Token(0) == "sprite")
 		sprite[Element::ACTIVE] = SpriteSet::Get(node.Token(1));
 	else
-		name = node.Token(1);
+		name = Information::Key(node.Token(1));
 	
 	// This function will call ParseLine() for any line it does not recognize.
 	Load(node, globalAnchor);
@@ -408,9 +515,9 @@ bool Interface::ImageElement::ParseLine(const DataNode &node)
 {
 	// The "inactive" and "hover" sprite only applies to non-dynamic images.
 	// The "colored" tag only applies to outlines.
-	if(node.Token(0) == "inactive" && node.Size() >= 2 && name.empty())
+	if(node.Token(0) == "inactive" && node.Size() >= 2 && name.IsEmpty())
 		sprite[Element::INACTIVE] = SpriteSet::Get(node.Token(1));
-	else if(node.Token(0) == "hover" && node.Size() >= 2 && name.empty())
+	else if(node.Token(0) == "hover" && node.Size() >= 2 && name.IsEmpty())
 		sprite[Element::HOVER] = SpriteSet::Get(node.Token(1));
 	else if(isOutline && node.Token(0) == "colored")
 		isColored = true;
@@ -463,9 +570,34 @@ void Interface::ImageElement::Draw(const Rectangle &rect, const Information &inf
 
 
 
+// Mix the information this element displays into the given hash.
+void Interface::ImageElement::HashContents(const Information &info, int state, size_t &hash) const
+{
+	// The sprite's texture may not have been loaded yet. Asking for it also
+	// counts as drawing the sprite, so it will not be unloaded while cached.
+	const Sprite *sprite = GetSprite(info, state);
+	Combine(hash, sprite);
+	Combine(hash, sprite ? sprite->Texture() : 0);
+	if(name.IsEmpty())
+		return;
+	
+	Combine(hash, info.GetSpriteFrame(name));
+	if(isOutline)
+	{
+		const Point &unit = info.GetSpriteUnit(name);
+		Combine(hash, unit.X());
+		Combine(hash, unit.Y());
+		if(isColored)
+			for(int i = 0; i < 4; ++i)
+				Combine(hash, info.GetOutlineColor().Get()[i]);
+	}
+}
+
+
+
 const Sprite *Interface::ImageElement::GetSprite(const Information &info, int state) const
 {
-	return name.empty() ? sprite[state] : info.GetSprite(name);
+	return name.IsEmpty() ? sprite[state] : info.GetSprite(name);
 }
 
 
@@ -487,6 +619,8 @@ Interface::TextElement::TextElement(const DataNode &node, const Point &globalAnc
 	}
 	else
 		str = node.Token(1);
+	if(isDynamic)
+		key = Information::Key(str);
 	
 	// This function will call ParseLine() for any line it does not recognize.
 	Load(node, globalAnchor);
@@ -569,9 +703,18 @@ void Interface::TextElement::Place(const Rectangle &bounds, Panel *panel) const
 
 
 
+// Mix the information this element displays into the given hash.
+void Interface::TextElement::HashContents(const Information &info, int state, size_t &hash) const
+{
+	if(isDynamic)
+		Combine(hash, info.GetString(key));
+}
+
+
+
 string Interface::TextElement::GetString(const Information &info) const
 {
-	return (isDynamic ? info.GetString(str) : str);
+	return (isDynamic ? info.GetString(key) : str);
 }
 
 
@@ -585,7 +728,7 @@ Interface::BarElement::BarElement(const DataNode &node, const Point &globalAncho
 		return;
 	
 	// Get the name of the element and find out what type it is (bar or ring).
-	name = node.Token(1);
+	name = Information::Key(node.Token(1));
 	isRing = (node.Token(0) == "ring");
 	
 	// This function will call ParseLine() for any line it does not recognize.
@@ -614,6 +757,15 @@ bool Interface::BarElement::ParseLine(const DataNode &node)
 
 
 
+// Mix the information this element displays into the given hash.
+void Interface::BarElement::HashContents(const Information &info, int state, size_t &hash) const
+{
+	Combine(hash, info.BarValue(name));
+	Combine(hash, info.BarSegments(name));
+}
+
+
+
 // Draw this element in the given rectangle.
 void Interface::BarElement::Draw(const Rectangle &rect, const Information &info, int state) const
 {
@@ -14,15 +14,17 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #define INTERFACE_H_
 
 #include "Color.h"
+#include "Information.h"
 #include "Point.h"
 #include "Rectangle.h"
+#include "RenderTarget.h"
 
+#include <cstddef>
 #include <map>
 #include <string>
 #include <vector>
 
 class DataNode;
-class Information;
 class Panel;
 class Sprite;
 
@@ -39,7 +41,9 @@ public:
 	void Load(const DataNode &node);
 	
 	// Draw this interface. If the given panel is not null, also register any
-	// buttons in this interface with the panel's list of clickable zones.
+	// buttons in this interface with the panel's list of clickable zones. An
+	// interface marked as "cache" is drawn into an offscreen texture, which is
+	// only redrawn when something that the interface shows has changed.
 	void Draw(const Information &info, Panel *panel = nullptr) const;
 	
 	// Get the location of a named point or box.
@@ -66,6 +70,7 @@ private:
 	class Element {
 	public:
 		// State enumeration:
+		static const int HIDDEN = -1;
 		static const int INACTIVE = 0;
 		static const int ACTIVE = 1;
 		static const int HOVER = 2;
@@ -83,6 +88,17 @@ private:
 		// Draw this element, relative to the given anchor point. If this is a
 		// button, it will add a clickable zone to the given panel.
 		void Draw(const Information &info, Panel *panel) const;
+		// The same, but with a state that was already found by GetState().
+		void Draw(const Information &info, Panel *panel, int state) const;
+		// Add this element's clickable zone to the given panel without drawing it.
+		void AddZones(Panel *panel, int state) const;
+		// Mix everything that affects how this element is drawn into the given hash.
+		void Hash(const Information &info, int state, size_t &hash) const;
+		
+		// Get the current state of this element: hidden, inactive, active, or
+		// hover. This tests its conditions, so it should only be done once for
+		// each time that the element is drawn.
+		int GetState(const Information &info) const;
 		
 		// Set the conditions that control when this element is visible and active.
 		// An empty string means it is always visible or active.
@@ -102,14 +118,19 @@ private:
 		// Add any click handlers needed for this element. This will only be
 		// called if the element is visible and active.
 		virtual void Place(const Rectangle &bounds, Panel *panel) const;
+		// Mix the information this element displays into the given hash.
+		virtual void HashContents(const Information &info, int state, size_t &hash) const;
 		
 	protected:
 		AnchoredPoint from;
 		AnchoredPoint to;
 		Point alignment;
 		Point padding;
-		std::string visibleIf;
-		std::string activeIf;
+		// The conditions, without any leading "!", and whether they are negated.
+		Information::Key visibleIf;
+		Information::Key activeIf;
+		bool isVisibleIfNot = false;
+		bool isActiveIfNot = false;
 	};
 	
 	// This class handles "sprite", "image", and "outline" elements.
@@ -125,13 +146,15 @@ private:
 		virtual Point NativeDimensions(const Information &info, int state) const override;
 		// Draw this element in the given rectangle.
 		virtual void Draw(const Rectangle &rect, const Information &info, int state) const override;
+		// Mix the information this element displays into the given hash.
+		virtual void HashContents(const Information &info, int state, size_t &hash) const override;
 		
 	private:
 		const Sprite *GetSprite(const Information &info, int state) const;
 		
 	private:
 		// If a name is given, look up the sprite with that name and draw it.
-		std::string name;
+		Information::Key name;
 		// Otherwise, draw a sprite. Which sprite is drawn depends on the current
 		// state of this element: inactive, active, or hover.
 		const Sprite *sprite[3] = {nullptr, nullptr, nullptr};
@@ -157,6 +180,8 @@ private:
 		// Add any click handlers needed for this element. This will only be
 		// called if the element is visible and active.
 		virtual void Place(const Rectangle &bounds, Panel *panel) const override;
+		// Mix the information this element displays into the given hash.
+		virtual void HashContents(const Information &info, int state, size_t &hash) const override;
 		
 	private:
 		std::string GetString(const Information &info) const;
@@ -164,6 +189,7 @@ private:
 	private:
 		// The string may either be a name of a dynamic string, or static text.
 		std::string str;
+		Information::Key key;
 		// Color for inactive, active, and hover states.
 		const Color *color[3] = {nullptr, nullptr, nullptr};
 		int fontSize = 14;
@@ -182,9 +208,11 @@ private:
 		virtual bool ParseLine(const DataNode &node) override;
 		// Draw this element in the given rectangle.
 		virtual void Draw(const Rectangle &rect, const Information &info, int state) const override;
+		// Mix the information this element displays into the given hash.
+		virtual void HashContents(const Information &info, int state, size_t &hash) const override;
 		
 	private:
-		std::string name;
+		Information::Key name;
 		const Color *color = nullptr;
 		float width = 2.f;
 		bool isRing = false;
@@ -195,6 +223,15 @@ private:
 	std::vector<Element *> elements;
 	std::map<std::string, Element> points;
 	std::map<std::string, double> values;
+	
+	// If this interface is cached, remember what it showed when it was last
+	// drawn into the offscreen texture.
+	bool isCached = false;
+	mutable RenderTarget cache;
+	mutable size_t cacheHash = 0;
+	mutable bool isCacheCurrent = false;
+	// The state of each element, found once per frame.
+	mutable std::vector<int> states;
 };
 
 
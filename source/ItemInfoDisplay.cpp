@@ -126,12 +126,11 @@ void ItemInfoDisplay::ClearHover()
 
 void ItemInfoDisplay::UpdateDescription(const string &text, const vector<string> &licenses, bool isShip)
 {
-	if(licenses.empty())
-		description.Wrap(text);
-	else
+	string fullText = text;
+	if(!licenses.empty())
 	{
 		static const string NOUN[2] = {"outfit", "ship"};
-		string fullText = text + "\tTo purchase this " + NOUN[isShip] + " you must have ";
+		fullText += "\tTo purchase this " + NOUN[isShip] + " you must have ";
 		for(unsigned i = 0; i < licenses.size(); ++i)
 		{
 			bool isVoweled = false;
@@ -151,7 +150,13 @@ void ItemInfoDisplay::UpdateDescription(const string &text, const vector<string>
 
 		}
 		fullText += ".\n";
-		description.Wrap(fullText);
+	}
+	// The shops update their displays in every frame, so only wrap the text
+	// again if it is different from the last time.
+	if(fullText != descriptionText)
+	{
+		descriptionText.swap(fullText);
+		description.Wrap(descriptionText);
 	}
 	
 	// Pad by 10 pixels on the top and bottom.
@@ -57,6 +57,8 @@ protected:
 	static const int WIDTH = 250;
 	
 	WrappedText description;
+	// The text that the description was wrapped from.
+	std::string descriptionText;
 	int descriptionHeight = 0;
 	
 	std::vector<std::string> attributeLabels;
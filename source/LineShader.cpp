@@ -13,10 +13,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "LineShader.h"
 
 #include "Color.h"
+#include "GameWindow.h"
 #include "Point.h"
 #include "Screen.h"
 #include "Shader.h"
+#include "StreamBuffer.h"
 
+#include <cstddef>
 #include <stdexcept>
 
 using namespace std;
@@ -31,6 +34,26 @@ namespace {
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// The instanced version of the shader reads each line's parameters from a
+	// vertex buffer instead of from uniforms.
+	Shader instancedShader;
+	GLint instancedScaleI;
+	GLint instancedOffsetI;
+	GLint itemStartI;
+	GLint itemLengthI;
+	GLint itemWidthI;
+	GLint itemColorI;
+	
+	GLuint instancedVao;
+	
+	void SetUniforms(const float start[2], const float length[2], const float width[2], const float color[4])
+	{
+		glUniform2fv(startI, 1, start);
+		glUniform2fv(lengthI, 1, length);
+		glUniform2fv(widthI, 1, width);
+		glUniform4fv(colorI, 1, color);
+	}
 }
 
 
@@ -53,9 +76,12 @@ void LineShader::Init()
 		"  gl_Position = vec4((start + vert.x * len + vert.y * width) * scale, 0, 1);\n"
 		"}\n";
 
+	// The fragment shader is the same whether its color is a uniform or is
+	// passed in for each instance by the instanced vertex shader.
+	static const char *fragmentUniforms =
+		"uniform vec4 color = vec4(1, 1, 1, 1);\n";
+	
 	static const char *fragmentCode =
-		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		
 		"in vec2 tpos;\n"
 		"in float tscale;\n"
 		"out vec4 finalColor;\n"
@@ -65,7 +91,7 @@ void LineShader::Init()
 		"  finalColor = color * alpha;\n"
 		"}\n";
 	
-	shader = Shader(vertexCode, fragmentCode);
+	shader = Shader(vertexCode, (fragmentUniforms + string(fragmentCode)).c_str());
 	scaleI = shader.Uniform("scale");
 	startI = shader.Uniform("start");
 	lengthI = shader.Uniform("len");
@@ -93,6 +119,77 @@ void LineShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	static const char *instancedVertexCode =
+		"uniform vec2 scale;\n"
+		"uniform vec2 offset;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 itemStart;\n"
+		"in vec2 itemLength;\n"
+		"in vec2 itemWidth;\n"
+		"in vec4 itemColor;\n"
+		
+		"out vec2 tpos;\n"
+		"out float tscale;\n"
+		"flat out vec4 color;\n"
+		
+		"void main() {\n"
+		"  tpos = vert;\n"
+		"  tscale = length(itemLength);\n"
+		"  color = itemColor;\n"
+		"  gl_Position = vec4((itemStart + offset + vert.x * itemLength + vert.y * itemWidth) * scale, 0, 1);\n"
+		"}\n";
+	
+	static const char *fragmentInputs =
+		"flat in vec4 color;\n";
+	
+	instancedShader = Shader(instancedVertexCode, (fragmentInputs + string(fragmentCode)).c_str());
+	instancedScaleI = instancedShader.Uniform("scale");
+	instancedOffsetI = instancedShader.Uniform("offset");
+	itemStartI = instancedShader.Attrib("itemStart");
+	itemLengthI = instancedShader.Attrib("itemLength");
+	itemWidthI = instancedShader.Attrib("itemWidth");
+	itemColorI = instancedShader.Attrib("itemColor");
+	
+	glGenVertexArrays(1, &instancedVao);
+	glBindVertexArray(instancedVao);
+	
+	// The corners of the quad come from the same buffer as above. Everything
+	// else comes from the StreamBuffer, once per line.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GLint vertI = instancedShader.Attrib("vert");
+	glEnableVertexAttribArray(vertI);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	for(GLint attrib : {itemStartI, itemLengthI, itemWidthI, itemColorI})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+
+LineShader::Item::Item(const Point &from, const Point &to, float width, const Color &color)
+{
+	Point v = to - from;
+	Point u = v.Unit() * width;
+	start[0] = from.X();
+	start[1] = from.Y();
+	length[0] = v.X();
+	length[1] = v.Y();
+	this->width[0] = u.Y();
+	this->width[1] = -u.X();
+	
+	const float *source = color.Get();
+	for(int i = 0; i < 4; ++i)
+		this->color[i] = source[i];
 }
 
 
@@ -108,21 +205,65 @@ void LineShader::Draw(const Point &from, const Point &to, float width, const Col
 	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
 	glUniform2fv(scaleI, 1, scale);
 	
-	GLfloat start[2] = {static_cast<float>(from.X()), static_cast<float>(from.Y())};
-	glUniform2fv(startI, 1, start);
+	Item item(from, to, width, color);
+	SetUniforms(item.start, item.length, item.width, item.color);
 	
-	Point v = to - from;
-	Point u = v.Unit() * width;
-	GLfloat length[2] = {static_cast<float>(v.X()), static_cast<float>(v.Y())};
-	glUniform2fv(lengthI, 1, length);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	
-	GLfloat w[2] = {static_cast<float>(u.Y()), static_cast<float>(-u.X())};
-	glUniform2fv(widthI, 1, w);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
+
+
+
+// Draw all the given lines, moved by the given offset. If the graphics card
+// supports instancing this is a single draw call; otherwise, each line is drawn
+// separately.
+void LineShader::Draw(const vector<Item> &items, const Point &offset)
+{
+	if(items.empty())
+		return;
+	if(!shader.Object())
+		throw runtime_error("LineShader: Draw() called before Init().");
 	
-	glUniform4fv(colorI, 1, color.Get());
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	if(!GameWindow::HasInstancing())
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		glUniform2fv(scaleI, 1, scale);
+		for(const Item &item : items)
+		{
+			GLfloat start[2] = {
+				static_cast<float>(item.start[0] + offset.X()),
+				static_cast<float>(item.start[1] + offset.Y())};
+			SetUniforms(start, item.length, item.width, item.color);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+		glBindVertexArray(0);
+		glUseProgram(0);
+		return;
+	}
 	
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glUseProgram(instancedShader.Object());
+	glBindVertexArray(instancedVao);
+	
+	glUniform2fv(instancedScaleI, 1, scale);
+	GLfloat translate[2] = {static_cast<float>(offset.X()), static_cast<float>(offset.Y())};
+	glUniform2fv(instancedOffsetI, 1, translate);
 	
+	// The items are uploaded exactly as they are stored.
+	const char *base = reinterpret_cast<const char *>(
+		StreamBuffer::Upload(items.data(), sizeof(Item) * items.size()));
+	const GLsizei stride = sizeof(Item);
+	glVertexAttribPointer(itemStartI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, start));
+	glVertexAttribPointer(itemLengthI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, length));
+	glVertexAttribPointer(itemWidthI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, width));
+	glVertexAttribPointer(itemColorI, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, color));
+	
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, items.size());
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
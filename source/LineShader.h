@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef LINE_SHADER_H_
 #define LINE_SHADER_H_
 
+#include <vector>
+
 class Color;
 class Point;
 
@@ -21,10 +23,28 @@ class Point;
 // Class to be used for drawing lines. The sides of a line are anti-aliased, but
 // the start and end of the line are not.
 class LineShader {
+public:
+	// The parameters for drawing one line, for use when drawing many at once.
+	// The values are stored the way the shader uses them.
+	class Item {
+	public:
+		Item(const Point &from, const Point &to, float width, const Color &color);
+		
+		float start[2];
+		float length[2];
+		float width[2];
+		float color[4];
+	};
+	
+	
 public:
 	static void Init();
 	
 	static void Draw(const Point &from, const Point &to, float width, const Color &color);
+	// Draw all the given lines, moved by the given offset. If the graphics card
+	// supports instancing this is a single draw call; otherwise, each line is
+	// drawn separately.
+	static void Draw(const std::vector<Item> &items, const Point &offset);
 };
 
 
@@ -66,6 +66,8 @@ namespace {
 LoadPanel::LoadPanel(PlayerInfo &player, UI &gamePanels)
 	: player(player), gamePanels(gamePanels), selectedPilot(player.Identifier())
 {
+	SetIsFullScreen(true);
+	
 	// If you have a player loaded, and the player is on a planet, make sure
 	// the player is saved so that any snapshot you create will be of the
 	// player's current state, rather than one planet ago. Only do this if the
@@ -370,6 +372,8 @@ void LoadPanel::UpdateLists()
 {
 	files.clear();
 	
+	// Make sure any save that is being written in the background is done.
+	PlayerInfo::FinishSaving();
 	vector<string> fileList = Files::List(Files::Saves());
 	for(const string &path : fileList)
 	{
@@ -461,9 +465,11 @@ void LoadPanel::SnapshotCallback(const string &name)
 			}
 	}
 	
-	// Copy the autosave to a new, named file.
+	// Copy the autosave to a new, named file. Snapshots are kept for a long
+	// time but rarely loaded, so they are stored compressed.
 	string to = from.substr(0, from.size() - 4) + extension;
-	Files::Copy(from, to);
+	if(!Files::CopyCompressed(from, to))
+		Files::Copy(from, to);
 	if(Files::Exists(to))
 	{
 		UpdateLists();
@@ -23,8 +23,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "StellarObject.h"
 #include "System.h"
 
-#include <mutex>
-
 using namespace std;
 
 namespace {
@@ -67,23 +65,8 @@ namespace {
 	// Check if the given system is within the given distance of the center.
 	int Distance(const System *center, const System *system, int maximum)
 	{
-		// This function should only ever be called from the main thread, but
-		// just to be sure, use mutex protection on the static locals.
-		static mutex distanceMutex;
-		lock_guard<mutex> lock(distanceMutex);
-		
-		static const System *previousCenter = center;
-		static DistanceMap distance(center, -1, maximum);
-		static int previousMaximum = maximum;
-		
-		if(center != previousCenter || maximum > previousMaximum)
-		{
-			previousCenter = center;
-			previousMaximum = maximum;
-			distance = DistanceMap(center, -1, maximum);
-		}
 		// If the distance is greater than the maximum, this is not a match.
-		int d = distance.Days(system);
+		int d = DistanceMap::Jumps(center, system);
 		return (d > maximum) ? -1 : d;
 	}
 	
@@ -119,6 +102,7 @@ LocationFilter::LocationFilter(const DataNode &node)
 
 void LocationFilter::Load(const DataNode &node)
 {
+	cache.reset();
 	for(const DataNode &child : node)
 	{
 		// Handle filters that must not match, or must apply to a
@@ -356,6 +340,8 @@ LocationFilter LocationFilter::SetOrigin(const System *origin) const
 	// Revert "distance" parameters to their default.
 	result.originMinDistance = 0;
 	result.originMaxDistance = -1;
+	// The converted filter matches different systems.
+	result.cache.reset();
 	
 	return result;
 }
@@ -365,7 +351,15 @@ LocationFilter LocationFilter::SetOrigin(const System *origin) const
 // Pick a random system that matches this filter, based on the given origin.
 const System *LocationFilter::PickSystem(const System *origin) const
 {
-	// Find a planet that satisfies the filter.
+	// If this filter does not depend on the origin, the cache already has the
+	// list of all the systems that it matches.
+	if(CanCache())
+	{
+		const vector<const System *> &options = FillCache()->systems;
+		return options.empty() ? nullptr : options[Random::Int(options.size())];
+	}
+	
+	// Find a system that satisfies the filter.
 	vector<const System *> options;
 	for(const auto &it : GameData::Systems())
 	{
@@ -383,8 +377,18 @@ const System *LocationFilter::PickSystem(const System *origin) const
 // Pick a random planet that matches this filter, based on the given origin.
 const Planet *LocationFilter::PickPlanet(const System *origin, bool hasClearance) const
 {
-	// Find a planet that satisfies the filter.
+	// Whether a planet can be landed on may change at any time, but the cache
+	// at least narrows down which planets must be checked.
 	vector<const Planet *> options;
+	if(CanCache())
+	{
+		for(const Planet *planet : FillCache()->planets)
+			if(hasClearance || planet->CanLand())
+				options.push_back(planet);
+		return options.empty() ? nullptr : options[Random::Int(options.size())];
+	}
+	
+	// Find a planet that satisfies the filter.
 	for(const auto &it : GameData::Planets())
 	{
 		const Planet &planet = it.second;
@@ -555,3 +559,55 @@ bool LocationFilter::Matches(const System *system, const System *origin, bool di
 	
 	return true;
 }
+
+
+
+// Check if this filter matches the same systems and planets no matter what the
+// origin is, so that they can all be found once and cached.
+bool LocationFilter::CanCache() const
+{
+	// Only "distance" filters depend on the origin.
+	if(originMaxDistance >= 0)
+		return false;
+	
+	for(const LocationFilter &filter : notFilters)
+		if(!filter.CanCache())
+			return false;
+	for(const LocationFilter &filter : neighborFilters)
+		if(!filter.CanCache())
+			return false;
+	return true;
+}
+
+
+
+// Get the cache, filling it in first if the galaxy has changed.
+const LocationFilter::Cache *LocationFilter::FillCache() const
+{
+	int revision = GameData::Revision();
+	if(cache && cache->revision == revision)
+		return cache.get();
+	
+	shared_ptr<Cache> result = make_shared<Cache>();
+	result->revision = revision;
+	for(const auto &it : GameData::Systems())
+	{
+		// Skip entries with incomplete data.
+		if(!it.second.Name().empty() && Matches(&it.second))
+			result->systems.push_back(&it.second);
+	}
+	for(const auto &it : GameData::Planets())
+	{
+		const Planet &planet = it.second;
+		// Skip entries with incomplete data.
+		if(planet.Name().empty() || !planet.GetSystem())
+			continue;
+		// Skip planets that do not offer jobs or missions.
+		if(planet.IsWormhole() || !planet.HasSpaceport())
+			continue;
+		if(Matches(&planet))
+			result->planets.push_back(&planet);
+	}
+	cache = result;
+	return result.get();
+}
@@ -14,8 +14,10 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #define LOCATION_FILTER_H_
 
 #include <list>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 
 class DataNode;
 class DataWriter;
@@ -69,6 +71,24 @@ private:
 	// only if the filter wasn't looking for planet characteristics or if the
 	// didPlanet argument is set (meaning we already checked those).
 	bool Matches(const System *system, const System *origin, bool didPlanet) const;
+	// Check if this filter matches the same systems and planets no matter
+	// what the origin is, so that they can all be found once and cached.
+	bool CanCache() const;
+	
+	
+private:
+	// All the systems and planets that a filter which does not depend on the
+	// origin can pick from, as of the given GameData revision. They are in the
+	// same order as the game data.
+	class Cache {
+	public:
+		int revision = 0;
+		std::vector<const System *> systems;
+		std::vector<const Planet *> planets;
+	};
+	
+	// Get the cache, filling it in first if the galaxy has changed.
+	const Cache *FillCache() const;
 	
 	
 private:
@@ -98,6 +118,10 @@ private:
 	std::list<LocationFilter> notFilters;
 	// These filters store all the things the planet or system must border.
 	std::list<LocationFilter> neighborFilters;
+	
+	// Copies of a filter share its cache until one of them is changed, or
+	// until the galaxy changes and the cache must be filled in again.
+	mutable std::shared_ptr<const Cache> cache;
 };
 
 
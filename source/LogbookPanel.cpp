@@ -108,7 +108,7 @@ void LogbookPanel::Draw()
 	Point textOffset(0., .5 * (LINE_HEIGHT - font.Height()));
 	// Start at this point on the screen:
 	Point pos = Screen::TopLeft() + Point(PAD, PAD);
-	for(size_t i = 0; i < contents.size(); ++i)
+	for(size_t i = 0; i < contents.size() && pos.Y() < Screen::Bottom(); ++i)
 	{
 		if(selectedDate ? dates[i].Month() == selectedDate.Month() : selectedName == contents[i])
 		{
@@ -124,37 +124,26 @@ void LogbookPanel::Draw()
 	wrap.SetAlignment(WrappedText::JUSTIFIED);
 	wrap.SetWrapWidth(TEXT_WIDTH - 2. * PAD);
 	
-	// Draw the main text.
+	// Draw the main text. Only the entries that are on screen need to be
+	// wrapped and drawn.
 	pos = Screen::TopLeft() + Point(SIDEBAR_WIDTH + PAD, PAD + .5 * (LINE_HEIGHT - font.Height()) - scroll);
-	
-	// Branch based on whether this is an ordinary log month or a special page.
-	auto pit = player.SpecialLogs().find(selectedName);
-	if(selectedDate && begin != end)
-	{
-		for(auto it = begin; it != end; ++it)
-		{
-			string date = it->first.ToString();
-			double dateWidth = font.Width(date);
-			font.Draw(date, pos + Point(TEXT_WIDTH - dateWidth - 2. * PAD, textOffset.Y()), dim);
-			pos.Y() += LINE_HEIGHT;
-		
-			wrap.Wrap(it->second);
-			wrap.Draw(pos, medium);
-			pos.Y() += wrap.Height() + GAP;
-		}
-	}
-	else if(!selectedDate && pit != player.SpecialLogs().end())
+	pair<size_t, size_t> visible = rows.Visible(Screen::Top() - pos.Y(), Screen::Bottom() - pos.Y());
+	for(size_t i = visible.first; i < visible.second; ++i)
 	{
-		for(const auto &it : pit->second)
-		{
-			font.Draw(it.first, pos + textOffset, bright);
-			pos.Y() += LINE_HEIGHT;
+		Point entryPos = pos + Point(0., rows.Top(i));
+		const string &heading = entries[i].first;
+		// Dated entries have the date on the right. Special pages have their
+		// headings on the left.
+		if(selectedDate)
+			font.Draw(heading, entryPos + Point(TEXT_WIDTH - font.Width(heading) - 2. * PAD, textOffset.Y()), dim);
+		else
+			font.Draw(heading, entryPos + textOffset, bright);
+		entryPos.Y() += LINE_HEIGHT;
 		
-			wrap.Wrap(it.second);
-			wrap.Draw(pos, medium);
-			pos.Y() += wrap.Height() + GAP;
-		}
+		wrap.Wrap(*entries[i].second);
+		wrap.Draw(entryPos, medium);
 	}
+	pos.Y() += rows.Height();
 	
 	maxScroll = max(0., scroll + pos.Y() - Screen::Bottom());
 }
@@ -258,6 +247,40 @@ bool LogbookPanel::Scroll(double dx, double dy)
 
 
 void LogbookPanel::Update(bool selectLast)
+{
+	FindPages(selectLast);
+	
+	// Find the entries on the selected page, and measure how tall each one is
+	// once it is wrapped.
+	entries.clear();
+	rows.Clear();
+	if(selectedDate)
+	{
+		for(auto it = begin; it != end; ++it)
+			entries.emplace_back(it->first.ToString(), &it->second);
+	}
+	else
+	{
+		auto pit = player.SpecialLogs().find(selectedName);
+		if(pit != player.SpecialLogs().end())
+			for(const auto &it : pit->second)
+				entries.emplace_back(it.first, &it.second);
+	}
+	
+	WrappedText wrap(FontSet::Get(14));
+	wrap.SetAlignment(WrappedText::JUSTIFIED);
+	wrap.SetWrapWidth(TEXT_WIDTH - 2. * PAD);
+	for(const auto &it : entries)
+	{
+		wrap.Wrap(*it.second);
+		rows.Add(LINE_HEIGHT + wrap.Height() + GAP);
+	}
+}
+
+
+
+// Fill in the table of contents, and find the entries for the selected month.
+void LogbookPanel::FindPages(bool selectLast)
 {
 	contents.clear();
 	dates.clear();
@@ -16,9 +16,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Panel.h"
 
 #include "Date.h"
+#include "VirtualList.h"
 
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 class PlayerInfo;
@@ -46,6 +48,7 @@ protected:
 	
 private:
 	void Update(bool selectLast = true);
+	void FindPages(bool selectLast);
 	
 	
 private:
@@ -61,6 +64,11 @@ private:
 	std::vector<std::string> contents;
 	std::vector<Date> dates;
 	
+	// The heading and text of each entry on the current page, and the height
+	// of each entry once its text is wrapped.
+	std::vector<std::pair<std::string, const std::string *>> entries;
+	VirtualList rows;
+	
 	// Current scroll:
 	double scroll = 0.;
 	mutable double maxScroll = 0.;
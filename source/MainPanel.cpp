@@ -43,6 +43,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "gl_header.h"
 
 #include <cmath>
+#include <iterator>
 #include <sstream>
 #include <string>
 
@@ -125,9 +126,11 @@ void MainPanel::Step()
 	
 	engine.Step(isActive);
 	
-	// Splice new events onto the eventQueue for (eventual) handling. No
+	// Move new events onto the eventQueue for (eventual) handling. No
 	// other classes use Engine::Events() after Engine::Step() completes.
-	eventQueue.splice(eventQueue.end(), engine.Events());
+	vector<ShipEvent> &events = engine.Events();
+	eventQueue.insert(eventQueue.end(), make_move_iterator(events.begin()), make_move_iterator(events.end()));
+	events.clear();
 	// Handle as many ShipEvents as possible (stopping if no longer active
 	// and updating the isActive flag).
 	StepEvents(isActive);
@@ -162,7 +165,7 @@ void MainPanel::Draw()
 			isDragging = false;
 	}
 	
-	if(Preferences::Has("Show CPU / GPU load"))
+	if(Preferences::Has(Preferences::SHOW_LOAD))
 	{
 		string loadString = to_string(lround(load * 100.)) + "% GPU";
 		const Color &color = *GameData::Colors().Get("medium");
@@ -18,7 +18,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "Engine.h"
 
-#include <list>
+#include <deque>
 
 class PlayerInfo;
 class ShipEvent;
@@ -62,7 +62,7 @@ private:
 	Engine engine;
 	
 	// These are the pending ShipEvents that have yet to be processed.
-	std::list<ShipEvent> eventQueue;
+	std::deque<ShipEvent> eventQueue;
 	bool handledFront = false;
 	
 	Command show;
@@ -0,0 +1,159 @@
+/* MapIndex.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MapIndex.h"
+
+#include "Format.h"
+#include "GameData.h"
+#include "Planet.h"
+#include "Point.h"
+#include "System.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace {
+	// The size of each grid cell, in map coordinates. A click only looks at the
+	// systems within a few map units, so most clicks only check one cell.
+	const double CELL_SIZE = 64.;
+	
+	int Cell(double value)
+	{
+		return static_cast<int>(floor(value / CELL_SIZE));
+	}
+	
+	// Sort the given entries by name, without moving them.
+	template <class Type>
+	vector<size_t> SortedOrder(const vector<Type> &entries)
+	{
+		vector<size_t> sorted(entries.size());
+		for(size_t i = 0; i < sorted.size(); ++i)
+			sorted[i] = i;
+		sort(sorted.begin(), sorted.end(), [&entries](size_t a, size_t b)
+			{ return entries[a].name < entries[b].name; });
+		return sorted;
+	}
+}
+
+
+
+// Index all the systems and planets in the game data.
+void MapIndex::Build()
+{
+	cells.clear();
+	systems.clear();
+	planets.clear();
+	
+	for(const auto &it : GameData::Systems())
+	{
+		const System &system = it.second;
+		const Point &pos = system.Position();
+		cells[make_pair(Cell(pos.X()), Cell(pos.Y()))].push_back(&system);
+		systems.push_back(Entry{Format::LowerCase(it.first), &system, nullptr});
+	}
+	for(const auto &it : GameData::Planets())
+		planets.push_back(Entry{Format::LowerCase(it.first), it.second.GetSystem(), &it.second});
+	
+	sortedSystems = SortedOrder(systems);
+	sortedPlanets = SortedOrder(planets);
+}
+
+
+
+// Find the system closest to the given point (in map coordinates) that is
+// within the given radius of it and that passes the given test.
+const System *MapIndex::Closest(const Point &point, double radius, const function<bool(const System *)> &test) const
+{
+	const System *closest = nullptr;
+	double closestDistance = radius * radius;
+	
+	int right = Cell(point.X() + radius);
+	int bottom = Cell(point.Y() + radius);
+	for(int x = Cell(point.X() - radius); x <= right; ++x)
+		for(int y = Cell(point.Y() - radius); y <= bottom; ++y)
+		{
+			auto it = cells.find(make_pair(x, y));
+			if(it == cells.end())
+				continue;
+			
+			for(const System *system : it->second)
+			{
+				double distance = point.DistanceSquared(system->Position());
+				if(distance < closestDistance && test(system))
+				{
+					closest = system;
+					closestDistance = distance;
+				}
+			}
+		}
+	return closest;
+}
+
+
+
+// Find the system or planet name in which the given string appears the soonest.
+MapIndex::Match MapIndex::Find(const string &name, const function<bool(const System *)> &test) const
+{
+	Match match;
+	string lower = Format::LowerCase(name);
+	
+	// Matches at the start of a name can be looked up in the sorted lists.
+	const Entry *entry = FindPrefix(systems, sortedSystems, lower, test);
+	if(!entry)
+		entry = FindPrefix(planets, sortedPlanets, lower, test);
+	if(entry)
+	{
+		match.system = entry->system;
+		match.planet = entry->planet;
+		match.index = 0;
+		return match;
+	}
+	
+	// Otherwise, every name must be checked. Only replace an earlier match if
+	// this one is closer to the start of the name.
+	size_t best = numeric_limits<size_t>::max();
+	for(const vector<Entry> *list : {&systems, &planets})
+		for(const Entry &it : *list)
+		{
+			size_t index = it.name.find(lower);
+			if(index < best && it.system && test(it.system))
+			{
+				best = index;
+				match.system = it.system;
+				match.planet = it.planet;
+				match.index = index;
+			}
+		}
+	return match;
+}
+
+
+
+// Find the first entry (in the order of the game data) in the given list whose
+// name starts with the given string.
+const MapIndex::Entry *MapIndex::FindPrefix(const vector<Entry> &entries, const vector<size_t> &sorted,
+	const string &name, const function<bool(const System *)> &test) const
+{
+	// All the names that start with the given string are together in the
+	// sorted list, starting where the string itself would be.
+	auto it = lower_bound(sorted.begin(), sorted.end(), name, [&entries](size_t index, const string &key)
+		{ return entries[index].name < key; });
+	
+	const Entry *first = nullptr;
+	for( ; it != sorted.end() && !entries[*it].name.compare(0, name.length(), name); ++it)
+		if((!first || &entries[*it] < first) && entries[*it].system && test(entries[*it].system))
+			first = &entries[*it];
+	return first;
+}
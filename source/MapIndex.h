@@ -0,0 +1,90 @@
+/* MapIndex.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAP_INDEX_H_
+#define MAP_INDEX_H_
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Planet;
+class Point;
+class System;
+
+
+
+// Class that indexes the positions of all the systems, and the names of all the
+// systems and planets, so that the map can find which system was clicked on or
+// which name is being searched for without checking every single one of them.
+// The index must be rebuilt if any systems are added or moved.
+class MapIndex {
+public:
+	// The result of a name search. If the name was found in a system name,
+	// the planet is null. The index is where in the name the search string
+	// was found, or -1 if it was not found anywhere.
+	class Match {
+	public:
+		const System *system = nullptr;
+		const Planet *planet = nullptr;
+		int index = -1;
+	};
+	
+	
+public:
+	// Index all the systems and planets in the game data.
+	void Build();
+	
+	// Find the system closest to the given point (in map coordinates) that is
+	// within the given radius of it and that passes the given test.
+	const System *Closest(const Point &point, double radius, const std::function<bool(const System *)> &test) const;
+	// Find the system or planet name in which the given string (ignoring
+	// case) appears the soonest, considering only systems that pass the given
+	// test and planets in such systems. Ties go to systems before planets, and
+	// otherwise to whichever comes first in the game data.
+	Match Find(const std::string &name, const std::function<bool(const System *)> &test) const;
+	
+	
+private:
+	class Entry {
+	public:
+		std::string name;
+		const System *system;
+		const Planet *planet;
+	};
+	
+	
+private:
+	// Find the first entry (in the order of the game data) in the given list
+	// whose name starts with the given string. The list is sorted by name.
+	const Entry *FindPrefix(const std::vector<Entry> &entries, const std::vector<std::size_t> &sorted,
+		const std::string &name, const std::function<bool(const System *)> &test) const;
+	
+	
+private:
+	// The systems, in grid cells of a fixed size.
+	std::map<std::pair<int, int>, std::vector<const System *>> cells;
+	
+	// The lowercase names of the systems and planets, in the order of the game
+	// data, plus the order of those names when sorted alphabetically.
+	std::vector<Entry> systems;
+	std::vector<Entry> planets;
+	std::vector<std::size_t> sortedSystems;
+	std::vector<std::size_t> sortedPlanets;
+};
+
+
+
+#endif
@@ -149,6 +149,13 @@ double MapOutfitterPanel::SystemValue(const System *system) const
 
 
 
+const void *MapOutfitterPanel::SystemValueKey() const
+{
+	return selected;
+}
+
+
+
 int MapOutfitterPanel::FindItem(const string &text) const
 {
 	int bestIndex = 9999;
@@ -26,6 +26,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Interface.h"
 #include "LineShader.h"
 #include "MapDetailPanel.h"
+#include "MapIndex.h"
 #include "MapOutfitterPanel.h"
 #include "MapShipyardPanel.h"
 #include "Mission.h"
@@ -35,6 +36,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 #include "Politics.h"
 #include "Preferences.h"
+#include "RenderTarget.h"
 #include "RingShader.h"
 #include "Screen.h"
 #include "Ship.h"
@@ -50,6 +52,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <cctype>
 #include <cmath>
 #include <limits>
+#include <tuple>
 
 using namespace std;
 
@@ -82,6 +85,84 @@ namespace {
 	const int HOVER_TIME = 60;
 	// Length in frames of the recentering animation.
 	const int RECENTER_TIME = 20;
+	
+	// Everything other than the coloring mode that the shared map cache depends
+	// on: the player, their map and political revisions, their flagship and its
+	// attributes (which decide which planets it may land on), and the current
+	// and special systems.
+	using Attributes = vector<pair<const char *, double>>;
+	using CacheState = tuple<const PlayerInfo *, int, int, const Ship *, Attributes, const System *, const System *>;
+	CacheState cacheState;
+	
+	// The index of system positions and names, and the map revision it was
+	// last built for.
+	MapIndex mapIndex;
+	int indexRevision = -1;
+	
+	// The systems and links in the mini-map are drawn into a texture once per
+	// jump, at the brightest they are ever shown, and only drawn again if what
+	// the player knows about them changes. Everything in it is additive, so
+	// it fades out the same way when it is drawn dimmer.
+	const float MINI_MAP_ALPHA = .5f;
+	using MiniMapState = tuple<const PlayerInfo *, int, const Ship *, const System *, const System *>;
+	MiniMapState miniMapState;
+	RenderTarget miniMapCache;
+	
+	// Draw the jump systems of the mini-map, the systems linked to them, and
+	// their names and links.
+	void DrawMiniMapSystems(const PlayerInfo &player, float alpha, const System *const jump[2], const Point &center, const Point &drawPos)
+	{
+		const Font &font = FontSet::Get(14);
+		Color lineColor(alpha, 0.f);
+		set<const System *> drawnSystems = { jump[0], jump[1] };
+		
+		const Ship *flagship = player.Flagship();
+		for(int i = 0; i < 2; ++i)
+		{
+			static const string UNKNOWN_SYSTEM = "Unexplored System";
+			const System *system = jump[i];
+			const Government *gov = system->GetGovernment();
+			Point from = system->Position() - center + drawPos;
+			const string &name = player.KnowsName(system) ? system->Name() : UNKNOWN_SYSTEM;
+			font.Draw(name, from + Point(MapPanel::OUTER, -.5 * font.Height()), lineColor);
+			
+			// Draw the origin and destination systems, since they
+			// might not be linked via hyperspace.
+			Color color = Color(.5f * alpha, 0.f);
+			if(player.HasVisited(system) && system->IsInhabited(flagship) && gov)
+				color = Color(
+					alpha * gov->GetColor().Get()[0],
+					alpha * gov->GetColor().Get()[1],
+					alpha * gov->GetColor().Get()[2], 0.f);
+			RingShader::Draw(from, MapPanel::OUTER, MapPanel::INNER, color);
+			
+			for(const System *link : system->Links())
+			{
+				// Only draw systems known to be attached to the jump systems.
+				if(!player.HasVisited(system) && !player.HasVisited(link))
+					continue;
+				
+				// Draw the system link. This will double-draw the jump
+				// path if it is via hyperlink, to increase brightness.
+				Point to = link->Position() - center + drawPos;
+				Point unit = (from - to).Unit() * MapPanel::LINK_OFFSET;
+				LineShader::Draw(from - unit, to + unit, MapPanel::LINK_WIDTH, lineColor);
+				
+				if(drawnSystems.count(link))
+					continue;
+				drawnSystems.insert(link);
+				
+				gov = link->GetGovernment();
+				Color color = Color(.5f * alpha, 0.f);
+				if(player.HasVisited(link) && link->IsInhabited(flagship) && gov)
+					color = Color(
+						alpha * gov->GetColor().Get()[0],
+						alpha * gov->GetColor().Get()[1],
+						alpha * gov->GetColor().Get()[2], 0.f);
+				RingShader::Draw(to, MapPanel::OUTER, MapPanel::INNER, color);
+			}
+		}
+	}
 }
 
 const float MapPanel::OUTER = 6.f;
@@ -90,6 +171,9 @@ const float MapPanel::LINK_WIDTH = 1.2f;
 // Draw links only outside the system ring, which has radius MapPanel::OUTER.
 const float MapPanel::LINK_OFFSET = 7.f;
 
+map<pair<int, const void *>, vector<MapPanel::Node>> MapPanel::cachedNodes;
+vector<MapPanel::Link> MapPanel::cachedLinks;
+
 
 
 MapPanel::MapPanel(PlayerInfo &player, int commodity, const System *special)
@@ -111,6 +195,14 @@ MapPanel::MapPanel(PlayerInfo &player, int commodity, const System *special)
 	if(Preferences::Has("Show escort systems on map"))
 		TallyEscorts(player.Ships(), escortSystems);
 	
+	// Systems can only be added or moved by changes that also change the map
+	// revision, so only update the index if that has changed.
+	if(indexRevision != player.MapRevision())
+	{
+		mapIndex.Build();
+		indexRevision = player.MapRevision();
+	}
+	
 	// Initialize a centered tooltip.
 	hoverText.SetFont(FontSet::Get(14));
 	hoverText.SetWrapWidth(150);
@@ -154,6 +246,11 @@ void MapPanel::Draw()
 	RingShader::Draw(Zoom() * (selectedSystem ? selectedSystem->Position() + center : center),
 		11.f, 9.f, brightColor);
 	
+	if(commodity != cachedCommodity)
+		UpdateCache();
+	else if(Zoom() != cachedZoom)
+		CacheGeometry();
+	
 	// Advance a "blink" timer.
 	++step;
 	// Update the tooltip timer [0-60].
@@ -203,63 +300,42 @@ void MapPanel::DrawButtons(const string &condition)
 
 void MapPanel::DrawMiniMap(const PlayerInfo &player, float alpha, const System *const jump[2], int step)
 {
-	const Font &font = FontSet::Get(14);
-	Color lineColor(alpha, 0.f);
 	Point center = .5 * (jump[0]->Position() + jump[1]->Position());
-	const Point &drawPos = GameData::Interfaces().Get("hud")->GetPoint("mini-map");
-	set<const System *> drawnSystems = { jump[0], jump[1] };
+	static const Set<Interface>::Ref hud(GameData::Interfaces(), "hud");
+	const Point &drawPos = hud->GetPoint("mini-map");
 	bool isLink = jump[0]->Links().count(jump[1]);
 	
+	// The visited systems and the flagship's outfits, which decide which
+	// systems are shown as inhabited, cannot change while the mini-map is
+	// showing without also changing the map revision or the flagship.
+	MiniMapState state(&player, player.MapRevision(), player.Flagship(), jump[0], jump[1]);
+	if(alpha > MINI_MAP_ALPHA)
+		DrawMiniMapSystems(player, alpha, jump, center, drawPos);
+	else if(state == miniMapState && miniMapCache.IsCurrent())
+		miniMapCache.Draw(alpha / MINI_MAP_ALPHA);
+	else if(miniMapCache.Begin())
+	{
+		DrawMiniMapSystems(player, MINI_MAP_ALPHA, jump, center, drawPos);
+		miniMapCache.End();
+		miniMapState = state;
+		miniMapCache.Draw(alpha / MINI_MAP_ALPHA);
+	}
+	else
+	{
+		// If offscreen drawing is not possible, draw directly to the screen.
+		DrawMiniMapSystems(player, alpha, jump, center, drawPos);
+		miniMapState = MiniMapState();
+	}
+	
+	// The mission markers blink, so they are drawn every time.
 	const Set<Color> &colors = GameData::Colors();
 	const Color &currentColor = colors.Get("active mission")->Additive(alpha * 2.f);
 	const Color &blockedColor = colors.Get("blocked mission")->Additive(alpha * 2.f);
 	const Color &waypointColor = colors.Get("waypoint")->Additive(alpha * 2.f);
-	
-	const Ship *flagship = player.Flagship();
 	for(int i = 0; i < 2; ++i)
 	{
-		static const string UNKNOWN_SYSTEM = "Unexplored System";
 		const System *system = jump[i];
-		const Government *gov = system->GetGovernment();
 		Point from = system->Position() - center + drawPos;
-		const string &name = player.KnowsName(system) ? system->Name() : UNKNOWN_SYSTEM;
-		font.Draw(name, from + Point(OUTER, -.5 * font.Height()), lineColor);
-		
-		// Draw the origin and destination systems, since they
-		// might not be linked via hyperspace.
-		Color color = Color(.5f * alpha, 0.f);
-		if(player.HasVisited(system) && system->IsInhabited(flagship) && gov)
-			color = Color(
-				alpha * gov->GetColor().Get()[0],
-				alpha * gov->GetColor().Get()[1],
-				alpha * gov->GetColor().Get()[2], 0.f);
-		RingShader::Draw(from, OUTER, INNER, color);
-		
-		for(const System *link : system->Links())
-		{
-			// Only draw systems known to be attached to the jump systems.
-			if(!player.HasVisited(system) && !player.HasVisited(link))
-				continue;
-			
-			// Draw the system link. This will double-draw the jump
-			// path if it is via hyperlink, to increase brightness.
-			Point to = link->Position() - center + drawPos;
-			Point unit = (from - to).Unit() * LINK_OFFSET;
-			LineShader::Draw(from - unit, to + unit, LINK_WIDTH, lineColor);
-			
-			if(drawnSystems.count(link))
-				continue;
-			drawnSystems.insert(link);
-			
-			gov = link->GetGovernment();
-			Color color = Color(.5f * alpha, 0.f);
-			if(player.HasVisited(link) && link->IsInhabited(flagship) && gov)
-				color = Color(
-					alpha * gov->GetColor().Get()[0],
-					alpha * gov->GetColor().Get()[1],
-					alpha * gov->GetColor().Get()[2], 0.f);
-			RingShader::Draw(to, OUTER, INNER, color);
-		}
 		
 		Angle angle;
 		for(const Mission &mission : player.Missions())
@@ -364,13 +440,10 @@ bool MapPanel::Click(int x, int y, int clicks)
 {
 	// Figure out if a system was clicked on.
 	Point click = Point(x, y) / Zoom() - center;
-	for(const auto &it : GameData::Systems())
-		if(click.Distance(it.second.Position()) < 10.
-				&& (player.HasSeen(&it.second) || &it.second == specialSystem))
-		{
-			Select(&it.second);
-			break;
-		}
+	const System *system = mapIndex.Closest(click, 10., [this](const System *system)
+		{ return player.HasSeen(system) || system == specialSystem; });
+	if(system)
+		Select(system);
 	
 	return true;
 }
@@ -525,6 +598,13 @@ double MapPanel::SystemValue(const System *system) const
 
 
 
+const void *MapPanel::SystemValueKey() const
+{
+	return nullptr;
+}
+
+
+
 void MapPanel::Select(const System *system)
 {
 	if(!system)
@@ -580,39 +660,16 @@ void MapPanel::Select(const System *system)
 
 void MapPanel::Find(const string &name)
 {
-	int bestIndex = 9999;
-	for(const auto &it : GameData::Systems())
-		if(player.HasVisited(&it.second))
-		{
-			int index = Search(it.first, name);
-			if(index >= 0 && index < bestIndex)
-			{
-				bestIndex = index;
-				selectedSystem = &it.second;
-				CenterOnSystem(selectedSystem);
-				if(!index)
-				{
-					selectedPlanet = nullptr;
-					return;
-				}
-			}
-		}
-	for(const auto &it : GameData::Planets())
-		if(player.HasVisited(it.second.GetSystem()))
-		{
-			int index = Search(it.first, name);
-			if(index >= 0 && index < bestIndex)
-			{
-				bestIndex = index;
-				selectedSystem = it.second.GetSystem();
-				CenterOnSystem(selectedSystem);
-				if(!index)
-				{
-					selectedPlanet = &it.second;
-					return;
-				}
-			}
-		}
+	MapIndex::Match match = mapIndex.Find(name, [this](const System *system)
+		{ return player.HasVisited(system); });
+	if(match.index < 0)
+		return;
+	
+	selectedSystem = match.system;
+	CenterOnSystem(selectedSystem);
+	// Only a match at the start of a name changes which planet is selected.
+	if(!match.index)
+		selectedPlanet = match.planet;
 }
 
 
@@ -668,7 +725,42 @@ void MapPanel::UpdateCache()
 {
 	// Remember which commodity the cached systems are colored by.
 	cachedCommodity = commodity;
-	nodes.clear();
+	
+	// The shared cache is only valid as long as nothing it depends on has
+	// changed. The links are the same for every coloring mode.
+	const Ship *flagship = player.Flagship();
+	Attributes attributes;
+	if(flagship)
+		attributes.assign(flagship->Attributes().Attributes().begin(), flagship->Attributes().Attributes().end());
+	CacheState state(&player, player.MapRevision(), GameData::GetPolitics().Revision(),
+		flagship, std::move(attributes), playerSystem, specialSystem);
+	if(state != cacheState)
+	{
+		cacheState = state;
+		cachedNodes.clear();
+		FindLinks(cachedLinks);
+	}
+	links = cachedLinks;
+	
+	auto key = make_pair(commodity, SystemValueKey());
+	auto it = cachedNodes.find(key);
+	if(it == cachedNodes.end())
+	{
+		it = cachedNodes.emplace(key, vector<Node>()).first;
+		ColorSystems(it->second);
+	}
+	nodes = it->second;
+	
+	CacheGeometry();
+}
+
+
+
+// Find the color and name of every system that should be drawn, based on the
+// current coloring mode.
+void MapPanel::ColorSystems(vector<Node> &result) const
+{
+	result.clear();
 	
 	// Draw the circles for the systems, colored based on the selected criterion,
 	// which may be government, services, or commodity prices.
@@ -695,7 +787,7 @@ void MapPanel::UpdateCache()
 				if(commodity >= 0)
 				{
 					const Trade::Commodity &com = GameData::Commodities()[commodity];
-					double price = system.Trade(com.name);
+					double price = system.Trade(static_cast<size_t>(commodity));
 					if(!price)
 						value = numeric_limits<double>::quiet_NaN();
 					else
@@ -773,14 +865,19 @@ void MapPanel::UpdateCache()
 			}
 		}
 		
-		nodes.emplace_back(system.Position(), color,
+		result.emplace_back(system.Position(), color,
 			player.KnowsName(&system) ? system.Name() : "",
 			(&system == playerSystem) ? closeNameColor : farNameColor,
 			player.HasVisited(&system) ? system.GetGovernment() : nullptr);
 	}
-	
-	// Now, update the cache of the links.
-	links.clear();
+}
+
+
+
+// Find all the links between systems that should be drawn.
+void MapPanel::FindLinks(vector<Link> &result) const
+{
+	result.clear();
 	
 	// The link color depends on whether it's connected to the current system or not.
 	const Color &closeColor = *GameData::Colors().Get("map link");
@@ -801,13 +898,123 @@ void MapPanel::UpdateCache()
 					continue;
 				
 				bool isClose = (system == playerSystem || link == playerSystem);
-				links.emplace_back(system->Position(), link->Position(), isClose ? closeColor : farColor);
+				result.emplace_back(system->Position(), link->Position(), isClose ? closeColor : farColor);
 			}
 	}
 }
 
 
 
+// Build the lines, rings, and text layouts for the wormholes, links, systems,
+// and names at the current zoom level.
+void MapPanel::CacheGeometry()
+{
+	const double zoom = Zoom();
+	cachedZoom = zoom;
+	
+	// Keep track of what arrows and links need to be drawn.
+	set<pair<const System *, const System *>> arrowsToDraw;
+	
+	// Avoid iterating each StellarObject in every system by iterating over planets instead. A
+	// system can host more than one set of wormholes (e.g. Cardea), and some wormholes may even
+	// share a link vector. If a wormhole's planet has no description, no link will be drawn.
+	for(const auto &it : GameData::Planets())
+	{
+		if(!it.second.IsWormhole() || !player.HasVisited(&it.second) || it.second.Description().empty())
+			continue;
+		
+		const vector<const System *> &waypoints = it.second.WormholeSystems();
+		const System *from = waypoints.back();
+		for(const System *to : waypoints)
+		{
+			if(player.HasVisited(from) && player.HasVisited(to))
+				arrowsToDraw.emplace(from, to);
+			
+			from = to;
+		}
+	}
+	
+	const Color &wormholeDim = *GameData::Colors().Get("map unused wormhole");
+	const Color &arrowColor = *GameData::Colors().Get("map used wormhole");
+	static const double ARROW_LENGTH = 4.;
+	static const double ARROW_RATIO = .3;
+	static const Angle LEFT(30.);
+	static const Angle RIGHT(-30.);
+	
+	wormholeLines.clear();
+	for(const pair<const System *, const System *> &link : arrowsToDraw)
+	{
+		// Compute the start and end positions of the wormhole link.
+		Point from = zoom * link.first->Position();
+		Point to = zoom * link.second->Position();
+		Point offset = (from - to).Unit() * LINK_OFFSET;
+		from -= offset;
+		to += offset;
+		
+		// If an arrow is being drawn, the link will always be drawn too. Draw
+		// the link only for the first instance of it in this set.
+		if(link.first < link.second || !arrowsToDraw.count(make_pair(link.second, link.first)))
+			wormholeLines.emplace_back(from, to, LINK_WIDTH, wormholeDim);
+		
+		// Compute the start and end positions of the arrow edges.
+		Point arrowStem = zoom * ARROW_LENGTH * offset;
+		Point arrowLeft = arrowStem - ARROW_RATIO * LEFT.Rotate(arrowStem);
+		Point arrowRight = arrowStem - ARROW_RATIO * RIGHT.Rotate(arrowStem);
+		
+		// Draw the arrowhead.
+		Point fromTip = from - arrowStem;
+		wormholeLines.emplace_back(from, fromTip, LINK_WIDTH, arrowColor);
+		wormholeLines.emplace_back(from - arrowLeft, fromTip, LINK_WIDTH, arrowColor);
+		wormholeLines.emplace_back(from - arrowRight, fromTip, LINK_WIDTH, arrowColor);
+	}
+	
+	linkLines.clear();
+	for(const Link &link : links)
+	{
+		Point from = zoom * link.start;
+		Point to = zoom * link.end;
+		Point unit = (from - to).Unit() * LINK_OFFSET;
+		from -= unit;
+		to += unit;
+		
+		linkLines.emplace_back(from, to, LINK_WIDTH, link.color);
+	}
+	
+	systemRings.clear();
+	for(const Node &node : nodes)
+		systemRings.emplace_back(zoom * node.position, OUTER, INNER, node.color);
+	
+	// Lay out the names of the systems, with one layout for each color. Don't
+	// draw them at all if the map is zoomed out too far.
+	nameLayouts.clear();
+	if(zoom <= .5)
+		return;
+	
+	bool useBigFont = (zoom > 2.);
+	const Font &font = FontSet::Get(useBigFont ? 18 : 14);
+	Point offset(useBigFont ? 8. : 6., -.5 * font.Height());
+	for(const Node &node : nodes)
+	{
+		if(node.name.empty())
+			continue;
+		
+		auto it = nameLayouts.begin();
+		for( ; it != nameLayouts.end(); ++it)
+			if(equal(it->first.Get(), it->first.Get() + 4, node.nameColor.Get()))
+				break;
+		if(it == nameLayouts.end())
+		{
+			nameLayouts.emplace_back(node.nameColor, vector<float>());
+			it = nameLayouts.end() - 1;
+		}
+		
+		Point pos = zoom * node.position + offset;
+		font.Layout(node.name.c_str(), round(pos.X()), round(pos.Y()), it->second);
+	}
+}
+
+
+
 void MapPanel::DrawTravelPlan()
 {
 	if(!playerSystem)
@@ -842,21 +1049,10 @@ void MapPanel::DrawTravelPlan()
 		}
 	stranded |= !hasEscort;
 	
-	const System *previous = playerSystem;
-	for(int i = player.TravelPlan().size() - 1; i >= 0; --i)
+	for(const PlayerInfo::TravelHop &hop : player.TravelRoute())
 	{
-		const System *next = player.TravelPlan()[i];
-		bool isHyper = previous->Links().count(next);
-		bool isJump = !isHyper && previous->Neighbors().count(next);
-		bool isWormhole = false;
-		for(const StellarObject &object : previous->Objects())
-			isWormhole |= (object.GetPlanet() && player.HasVisited(object.GetPlanet())
-				&& !object.GetPlanet()->Description().empty()
-				&& player.HasVisited(previous) && player.HasVisited(next)
-				&& object.GetPlanet()->WormholeDestination(previous) == next);
-		
-		if(!isHyper && !isJump && !isWormhole)
-			break;
+		bool isJump = (hop.type == PlayerInfo::TravelHop::JUMP_DRIVE);
+		bool isWormhole = (hop.type == PlayerInfo::TravelHop::WORMHOLE);
 		
 		// Wormholes cost nothing to go through. If this is not a wormhole,
 		// check how much fuel every ship will expend to go through it.
@@ -884,12 +1080,10 @@ void MapPanel::DrawTravelPlan()
 		else if(fuel[flagship] >= 0.)
 			drawColor = defaultColor;
 		
-		Point from = Zoom() * (next->Position() + center);
-		Point to = Zoom() * (previous->Position() + center);
+		Point from = Zoom() * (hop.to->Position() + center);
+		Point to = Zoom() * (hop.from->Position() + center);
 		Point unit = (from - to).Unit() * LINK_OFFSET;
 		LineShader::Draw(from - unit, to + unit, 3.f, drawColor);
-		
-		previous = next;
 	}
 }
 
@@ -918,130 +1112,59 @@ void MapPanel::DrawEscorts()
 
 void MapPanel::DrawWormholes()
 {
-	// Keep track of what arrows and links need to be drawn.
-	set<pair<const System *, const System *>> arrowsToDraw;
-	
-	// Avoid iterating each StellarObject in every system by iterating over planets instead. A
-	// system can host more than one set of wormholes (e.g. Cardea), and some wormholes may even
-	// share a link vector. If a wormhole's planet has no description, no link will be drawn.
-	for(const auto &it : GameData::Planets())
-	{
-		if(!it.second.IsWormhole() || !player.HasVisited(&it.second) || it.second.Description().empty())
-			continue;
-		
-		const vector<const System *> &waypoints = it.second.WormholeSystems();
-		const System *from = waypoints.back();
-		for(const System *to : waypoints)
-		{
-			if(player.HasVisited(from) && player.HasVisited(to))
-				arrowsToDraw.emplace(from, to);
-			
-			from = to;
-		}
-	}
-	
-	const Color &wormholeDim = *GameData::Colors().Get("map unused wormhole");
-	const Color &arrowColor = *GameData::Colors().Get("map used wormhole");
-	static const double ARROW_LENGTH = 4.;
-	static const double ARROW_RATIO = .3;
-	static const Angle LEFT(30.);
-	static const Angle RIGHT(-30.);
-	const double zoom = Zoom();
-	
-	for(const pair<const System *, const System *> &link : arrowsToDraw)
-	{
-		// Compute the start and end positions of the wormhole link.
-		Point from = zoom * (link.first->Position() + center);
-		Point to = zoom * (link.second->Position() + center);
-		Point offset = (from - to).Unit() * LINK_OFFSET;
-		from -= offset;
-		to += offset;
-		
-		// If an arrow is being drawn, the link will always be drawn too. Draw
-		// the link only for the first instance of it in this set.
-		if(link.first < link.second || !arrowsToDraw.count(make_pair(link.second, link.first)))
-			LineShader::Draw(from, to, LINK_WIDTH, wormholeDim);
-		
-		// Compute the start and end positions of the arrow edges.
-		Point arrowStem = zoom * ARROW_LENGTH * offset;
-		Point arrowLeft = arrowStem - ARROW_RATIO * LEFT.Rotate(arrowStem);
-		Point arrowRight = arrowStem - ARROW_RATIO * RIGHT.Rotate(arrowStem);
-		
-		// Draw the arrowhead.
-		Point fromTip = from - arrowStem;
-		LineShader::Draw(from, fromTip, LINK_WIDTH, arrowColor);
-		LineShader::Draw(from - arrowLeft, fromTip, LINK_WIDTH, arrowColor);
-		LineShader::Draw(from - arrowRight, fromTip, LINK_WIDTH, arrowColor);
-	}
+	LineShader::Draw(wormholeLines, Zoom() * center);
 }
 
 
 
 void MapPanel::DrawLinks()
 {
-	double zoom = Zoom();
-	for(const Link &link : links)
-	{
-		Point from = zoom * (link.start + center);
-		Point to = zoom * (link.end + center);
-		Point unit = (from - to).Unit() * LINK_OFFSET;
-		from -= unit;
-		to += unit;
-		
-		LineShader::Draw(from, to, LINK_WIDTH, link.color);
-	}
+	LineShader::Draw(linkLines, Zoom() * center);
 }
 
 
 
 void MapPanel::DrawSystems()
 {
-	if(commodity != cachedCommodity)
-		UpdateCache();
+	// Draw the circles for the systems.
+	double zoom = Zoom();
+	RingShader::Draw(systemRings, zoom * center);
 	
 	// If coloring by government, we need to keep track of which ones are the
 	// closest to the center of the window because those will be the ones that
 	// are shown in the map key.
-	if(commodity == SHOW_GOVERNMENT)
-		closeGovernments.clear();
+	if(commodity != SHOW_GOVERNMENT)
+		return;
 	
-	// Draw the circles for the systems.
-	double zoom = Zoom();
+	closeGovernments.clear();
 	for(const Node &node : nodes)
-	{
-		Point pos = zoom * (node.position + center);
-		RingShader::Draw(pos, OUTER, INNER, node.color);
-		
-		if(commodity == SHOW_GOVERNMENT && node.government && node.government->GetName() != "Uninhabited")
+		if(node.government && node.government->GetName() != "Uninhabited")
 		{
 			// For every government that is drawn, keep track of how close it
 			// is to the center of the view. The four closest governments
 			// will be displayed in the key.
-			double distance = pos.Length();
+			double distance = (zoom * (node.position + center)).Length();
 			auto it = closeGovernments.find(node.government);
 			if(it == closeGovernments.end())
 				closeGovernments[node.government] = distance;
 			else
 				it->second = min(it->second, distance);
 		}
-	}
 }
 
 
 
 void MapPanel::DrawNames()
 {
-	// Don't draw if too small.
-	double zoom = Zoom();
-	if(zoom <= 0.5)
-		return;
+	// The names are laid out on whole pixels, so the offset must be too.
+	Point offset = Zoom() * center;
+	double x = round(offset.X());
+	double y = round(offset.Y());
 	
-	// Draw names for all systems you have visited.
-	bool useBigFont = (zoom > 2.);
+	bool useBigFont = (Zoom() > 2.);
 	const Font &font = FontSet::Get(useBigFont ? 18 : 14);
-	Point offset(useBigFont ? 8. : 6., -.5 * font.Height());
-	for(const Node &node : nodes)
-		font.Draw(node.name, zoom * (node.position + center) + offset, node.nameColor);
+	for(const auto &it : nameLayouts)
+		font.DrawLayout(it.second, x, y, it.first);
 }
 
 
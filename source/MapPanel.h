@@ -17,7 +17,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Color.h"
 #include "DistanceMap.h"
+#include "LineShader.h"
 #include "Point.h"
+#include "RingShader.h"
 #include "WrappedText.h"
 
 #include <map>
@@ -80,6 +82,9 @@ protected:
 	static Color UnexploredColor();
 	
 	virtual double SystemValue(const System *system) const;
+	// Get whatever SystemValue() is currently showing (e.g. the selected outfit),
+	// so that the map colorings for different items are cached separately.
+	virtual const void *SystemValueKey() const;
 	
 	void Select(const System *system);
 	void Find(const std::string &name);
@@ -147,6 +152,10 @@ private:
 	void DrawPointer(const System *system, Angle &angle, const Color &color, bool bigger = false);
 	static void DrawPointer(Point position, Angle &angle, const Color &color, bool drawBack = true, bool bigger = false);
 	
+	// Build the lines, rings, and text layouts for the wormholes, links,
+	// systems, and names at the current zoom level.
+	void CacheGeometry();
+	
 	
 private:
 	// This is the coloring mode currently used in the cache.
@@ -175,6 +184,23 @@ private:
 		Color color;
 	};
 	std::vector<Link> links;
+	
+	// The systems for each coloring mode, and the links, are shared by all map
+	// panels. They only need to be recalculated when the player's state changes.
+	static std::map<std::pair<int, const void *>, std::vector<Node>> cachedNodes;
+	static std::vector<Link> cachedLinks;
+	// Fill in the shared cache of system colors and links.
+	void ColorSystems(std::vector<Node> &result) const;
+	void FindLinks(std::vector<Link> &result) const;
+	
+	// The map geometry, in screen coordinates relative to the center of the
+	// map. It only changes if the cache is updated or the zoom level changes,
+	// so each frame it can be drawn with a few batched draw calls.
+	double cachedZoom = 0.;
+	std::vector<LineShader::Item> wormholeLines;
+	std::vector<LineShader::Item> linkLines;
+	std::vector<RingShader::Item> systemRings;
+	std::vector<std::pair<Color, std::vector<float>>> nameLayouts;
 };
 
 
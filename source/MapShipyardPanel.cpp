@@ -136,6 +136,13 @@ double MapShipyardPanel::SystemValue(const System *system) const
 
 
 
+const void *MapShipyardPanel::SystemValueKey() const
+{
+	return selected;
+}
+
+
+
 int MapShipyardPanel::FindItem(const string &text) const
 {
 	int bestIndex = 9999;
@@ -44,6 +44,7 @@ protected:
 	virtual void Select(int index) override;
 	virtual void Compare(int index) override;
 	virtual double SystemValue(const System *system) const override;
+	virtual const void *SystemValueKey() const override;
 	virtual int FindItem(const std::string &text) const override;
 	
 	virtual void DrawItems() override;
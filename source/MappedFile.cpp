@@ -0,0 +1,168 @@
+/* MappedFile.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MappedFile.h"
+
+#include "Archive.h"
+#include "File.h"
+#include "Files.h"
+
+#if defined _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// Mappings must start at a multiple of this many bytes into the file.
+	size_t Granularity()
+	{
+#if defined _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwAllocationGranularity;
+#else
+		return sysconf(_SC_PAGESIZE);
+#endif
+	}
+	
+	// Check if this is the start of a gzip file.
+	bool IsCompressed(const char *data, size_t size)
+	{
+		return (size >= 2 && static_cast<unsigned char>(data[0]) == 0x1f
+			&& static_cast<unsigned char>(data[1]) == 0x8b);
+	}
+}
+
+
+
+MappedFile::MappedFile(const string &path)
+{
+	// If the file is in an archive, this opens the archive at the start of it.
+	File file(path);
+	if(!file)
+		return;
+	
+	long long start = ftell(file);
+	long long length = 0;
+	if(!Archive::Find(path, &length))
+	{
+		fseek(file, 0, SEEK_END);
+		length = ftell(file) - start;
+	}
+	if(start < 0 || length <= 0)
+		return;
+	
+	static const size_t GRANULARITY = Granularity();
+	size_t offset = start % GRANULARITY;
+	size_t base = start - offset;
+	mappingSize = offset + length;
+#if defined _WIN32
+	HANDLE handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)));
+	HANDLE object = CreateFileMapping(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(object)
+	{
+		uint64_t wide = base;
+		mapping = MapViewOfFile(object, FILE_MAP_READ, wide >> 32, wide & 0xFFFFFFFF, mappingSize);
+		// The view keeps the file mapping object alive on its own.
+		CloseHandle(object);
+	}
+#else
+	mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileno(file), base);
+	if(mapping == MAP_FAILED)
+		mapping = nullptr;
+#endif
+	if(mapping)
+	{
+		data = static_cast<const char *>(mapping) + offset;
+		size = length;
+	}
+	// Compressed files cannot be used as they are, so they are read and
+	// decompressed instead.
+	if(!mapping || IsCompressed(data, size))
+	{
+		Unmap();
+		buffer = Files::Read(path);
+	}
+}
+
+
+
+MappedFile::MappedFile(MappedFile &&other)
+{
+	*this = std::move(other);
+}
+
+
+
+MappedFile::~MappedFile()
+{
+	Unmap();
+}
+
+
+
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+	if(this != &other)
+	{
+		Unmap();
+		swap(mapping, other.mapping);
+		swap(mappingSize, other.mappingSize);
+		swap(data, other.data);
+		swap(size, other.size);
+		buffer = std::move(other.buffer);
+		other.buffer.clear();
+	}
+	return *this;
+}
+
+
+
+// Get the contents of the file.
+const char *MappedFile::Data() const
+{
+	return mapping ? data : buffer.data();
+}
+
+
+
+size_t MappedFile::Size() const
+{
+	return mapping ? size : buffer.size();
+}
+
+
+
+void MappedFile::Unmap()
+{
+	if(mapping)
+	{
+#if defined _WIN32
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, mappingSize);
+#endif
+	}
+	mapping = nullptr;
+	mappingSize = 0;
+	data = nullptr;
+	size = 0;
+}
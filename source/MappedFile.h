@@ -0,0 +1,59 @@
+/* MappedFile.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+
+
+// A read-only view of the entire contents of a file, which stays valid for as
+// long as this object exists. If possible the file is mapped into memory, so
+// that nothing is copied until the contents are actually used; a file in an
+// archive is mapped straight from the archive. Compressed files, and any file
+// that cannot be mapped, are read into memory instead, just as Files::Read()
+// would read them.
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string &path);
+	MappedFile(const MappedFile &) = delete;
+	MappedFile(MappedFile &&other);
+	~MappedFile();
+	
+	MappedFile &operator=(const MappedFile &) = delete;
+	MappedFile &operator=(MappedFile &&other);
+	
+	// Get the contents of the file. If the file does not exist, it is empty.
+	const char *Data() const;
+	std::size_t Size() const;
+	
+	
+private:
+	void Unmap();
+	
+	
+private:
+	// The mapping starts at the page boundary at or before the contents.
+	void *mapping = nullptr;
+	std::size_t mappingSize = 0;
+	const char *data = nullptr;
+	std::size_t size = 0;
+	// If the file was not mapped, this holds its contents instead.
+	std::string buffer;
+};
+
+
+
+#endif
@@ -21,6 +21,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
+	// Number of outline edges to group together under one bounding box.
+	const size_t CHUNK_SIZE = 8;
+	
 	// Trace out a pixmap.
 	void Trace(const ImageBuffer &image, int frame, vector<Point> *raw)
 	{
@@ -227,9 +230,41 @@ void Mask::Create(const ImageBuffer &image, int frame)
 	
 	SmoothAndCenter(&raw, Point(image.Width(), image.Height()));
 	
-	Simplify(raw, &outline);
-	
+	vector<Point> result;
+	Simplify(raw, &result);
+	Create(result);
+}
+
+
+
+// Construct a mask from an outline that has already been traced.
+void Mask::Create(const vector<Point> &points)
+{
+	outline = points;
 	radius = ComputeRadius(outline);
+	
+	// Store the edges of the outline, and build the tree of bounding boxes
+	// around them. Any leaves past the end of the outline are left empty.
+	edges.clear();
+	leaves = 1;
+	while(leaves * CHUNK_SIZE < outline.size())
+		leaves <<= 1;
+	tree.assign(2 * leaves, Box());
+	for(size_t i = 0; i < outline.size(); ++i)
+	{
+		const Point &start = outline[i];
+		const Point &end = outline[i + 1 < outline.size() ? i + 1 : 0];
+		edges.push_back(end - start);
+		
+		Box &box = tree[leaves + i / CHUNK_SIZE];
+		box.Add(start);
+		box.Add(end);
+	}
+	for(size_t i = leaves - 1; i; --i)
+	{
+		tree[i] = tree[2 * i];
+		tree[i].Add(tree[2 * i + 1]);
+	}
 }
 
 
@@ -342,33 +377,80 @@ const vector<Point> &Mask::Points() const
 
 
 
+// Get the amount of memory this mask is using, in bytes.
+size_t Mask::Bytes() const
+{
+	return sizeof(Mask) + (outline.capacity() + edges.capacity()) * sizeof(Point) + tree.capacity() * sizeof(Box);
+}
+
+
+
+// Call the given function with the index of every chunk of the outline
+// whose bounding box passes the given test.
+template <class Test, class Function>
+void Mask::ForChunks(Test test, Function function) const
+{
+	if(tree.empty())
+		return;
+	
+	// Walk the tree depth first, skipping any nodes that fail the test. The
+	// tree is never anywhere near deep enough to overflow this stack.
+	size_t stack[64];
+	size_t size = 0;
+	stack[size++] = 1;
+	while(size)
+	{
+		size_t node = stack[--size];
+		if(!test(tree[node]))
+			continue;
+		
+		if(node >= leaves)
+			function(node - leaves);
+		else
+		{
+			stack[size++] = 2 * node + 1;
+			stack[size++] = 2 * node;
+		}
+	}
+}
+
+
+
 double Mask::Intersection(Point sA, Point vA) const
 {
 	// Keep track of the closest intersection point found.
 	double closest = 1.;
 	
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	// Only the parts of the outline whose bounds overlap the bounds of the
+	// query segment can possibly intersect it.
+	Point end = sA + vA;
+	Point low(min(sA.X(), end.X()), min(sA.Y(), end.Y()));
+	Point high(max(sA.X(), end.X()), max(sA.Y(), end.Y()));
+	auto overlaps = [&low, &high](const Box &box) -> bool
+	{
+		return (box.max.X() >= low.X()) & (box.min.X() <= high.X())
+			& (box.max.Y() >= low.Y()) & (box.min.Y() <= high.Y());
+	};
+	ForChunks(overlaps, [this, &sA, &vA, &closest](size_t c)
 	{
-		// Check if there is an intersection. (If not, the cross would be 0.) If
-		// there is, handle it only if it is a point where the segment is
-		// entering the polygon rather than exiting it (i.e. cross > 0).
-		Point vB = next - prev;
-		double cross = vB.Cross(vA);
-		if(cross > 0.)
+		size_t last = min(outline.size(), (c + 1) * CHUNK_SIZE);
+		for(size_t i = c * CHUNK_SIZE; i < last; ++i)
 		{
-			Point vS = prev - sA;
+			// Check if there is an intersection. (If not, the cross would be 0.) If
+			// there is, handle it only if it is a point where the segment is
+			// entering the polygon rather than exiting it (i.e. cross > 0).
+			const Point &vB = edges[i];
+			double cross = vB.Cross(vA);
+			Point vS = outline[i] - sA;
 			double uB = vA.Cross(vS);
 			double uA = vB.Cross(vS);
 			// If the intersection occurs somewhere within this segment of the
 			// outline, find out how far along the query vector it occurs and
 			// remember it if it is the closest so far.
-			if((uB >= 0.) & (uB < cross) & (uA >= 0.))
+			if((cross > 0.) & (uB >= 0.) & (uB < cross) & (uA >= 0.))
 				closest = min(closest, uA / cross);
 		}
-		
-		prev = next;
-	}
+	});
 	return closest;
 }
 
@@ -382,20 +464,48 @@ bool Mask::Contains(Point point) const
 	// open at the end to avoid double-counting.
 	
 	// For simplicity, use a ray pointing straight downwards. A segment then
-	// intersects only if its x coordinates span the point's coordinates.
+	// intersects only if its x coordinates span the point's coordinates, so
+	// any part of the outline that does not span them, or that lies entirely
+	// above the point, can be skipped.
 	int intersections = 0;
-	Point prev = outline.back();
-	for(const Point &next : outline)
+	auto spans = [&point](const Box &box) -> bool
 	{
-		if(prev.X() != next.X())
-			if((prev.X() <= point.X()) == (point.X() < next.X()))
-			{
-				double y = prev.Y() + (next.Y() - prev.Y()) *
-					(point.X() - prev.X()) / (next.X() - prev.X());
-				intersections += (y >= point.Y());
-			}
-		prev = next;
-	}
+		return (point.X() >= box.min.X()) & (point.X() < box.max.X()) & (box.max.Y() >= point.Y());
+	};
+	ForChunks(spans, [this, &point, &intersections](size_t c)
+	{
+		size_t last = min(outline.size(), (c + 1) * CHUNK_SIZE);
+		for(size_t i = c * CHUNK_SIZE; i < last; ++i)
+		{
+			const Point &prev = outline[i];
+			const Point &next = outline[i + 1 < outline.size() ? i + 1 : 0];
+			if(prev.X() != next.X())
+				if((prev.X() <= point.X()) == (point.X() < next.X()))
+				{
+					double y = prev.Y() + (next.Y() - prev.Y()) *
+						(point.X() - prev.X()) / (next.X() - prev.X());
+					intersections += (y >= point.Y());
+				}
+		}
+	});
 	// If the number of intersections is odd, the point is within the mask.
 	return (intersections & 1);
 }
+
+
+
+// Expand this box to include the given point.
+void Mask::Box::Add(const Point &point)
+{
+	min = Point(std::min(min.X(), point.X()), std::min(min.Y(), point.Y()));
+	max = Point(std::max(max.X(), point.X()), std::max(max.Y(), point.Y()));
+}
+
+
+
+// Expand this box to include the given box.
+void Mask::Box::Add(const Box &box)
+{
+	min = Point(std::min(min.X(), box.min.X()), std::min(min.Y(), box.min.Y()));
+	max = Point(std::max(max.X(), box.max.X()), std::max(max.Y(), box.max.Y()));
+}
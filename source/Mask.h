@@ -16,6 +16,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Angle.h"
 #include "Point.h"
 
+#include <cstddef>
+#include <limits>
 #include <vector>
 
 class ImageBuffer;
@@ -34,6 +36,9 @@ public:
 	
 	// Construct a mask from the alpha channel of an image.
 	void Create(const ImageBuffer &image, int frame = 0);
+	// Construct a mask from an outline that has already been traced, such as
+	// one that was saved along with a precompressed image.
+	void Create(const std::vector<Point> &points);
 	
 	// Check whether a mask was successfully loaded.
 	bool IsLoaded() const;
@@ -59,15 +64,43 @@ public:
 	
 	// Get the list of points in the outline.
 	const std::vector<Point> &Points() const;
+	// Get the amount of memory this mask is using, in bytes.
+	size_t Bytes() const;
+	
+	
+private:
+	// An axis-aligned bounding box.
+	class Box {
+	public:
+		// Expand this box to include the given point or box.
+		void Add(const Point &point);
+		void Add(const Box &box);
+		
+		Point min = Point(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
+		Point max = -min;
+	};
 	
 	
 private:
 	double Intersection(Point sA, Point vA) const;
 	bool Contains(Point point) const;
+	// Call the given function with the index of every chunk of the outline
+	// whose bounding box passes the given test.
+	template <class Test, class Function>
+	void ForChunks(Test test, Function function) const;
 	
 	
 private:
 	std::vector<Point> outline;
+	// The vector from each point in the outline to the next one.
+	std::vector<Point> edges;
+	// A tree of the bounding boxes of the outline's edges. The leaves are the
+	// bounds of each chunk of consecutive edges, and each node above them is
+	// the bounds of its two children, so that queries only need to look at
+	// the parts of the outline that are close to them. Node i has children
+	// 2i and 2i + 1, and the leaves begin at node "leaves."
+	std::vector<Box> tree;
+	size_t leaves = 0;
 	double radius;
 };
 
@@ -0,0 +1,205 @@
+/* MaskCache.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MaskCache.h"
+
+#include "Files.h"
+#include "Mask.h"
+#include "Point.h"
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// This must be changed whenever the format of the cache changes, so that an
+	// old cache will be ignored instead of being misread.
+	const char SIGNATURE[] = "Endless Sky mask cache 1\n";
+	const size_t SIGNATURE_SIZE = sizeof(SIGNATURE) - 1;
+	
+	// The cache is only ever read on the machine that wrote it, so values are
+	// just stored in whatever byte order that machine uses.
+	template <class Type>
+	void WriteValue(string &out, Type value)
+	{
+		out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	template <class Type>
+	bool ReadValue(const char *&it, const char *end, Type &value)
+	{
+		if(static_cast<size_t>(end - it) < sizeof(value))
+			return false;
+		memcpy(&value, it, sizeof(value));
+		it += sizeof(value);
+		return true;
+	}
+	
+	void WriteString(string &out, const string &value)
+	{
+		WriteValue<uint32_t>(out, value.length());
+		out += value;
+	}
+	
+	bool ReadString(const char *&it, const char *end, string &value)
+	{
+		uint32_t length = 0;
+		if(!ReadValue(it, end, length) || static_cast<size_t>(end - it) < length)
+			return false;
+		value.assign(it, length);
+		it += length;
+		return true;
+	}
+	
+	// A file is assumed not to have changed if its time stamp and size are both
+	// the same as when it was cached.
+	pair<int64_t, int64_t> Stamp(const string &path)
+	{
+		return make_pair(static_cast<int64_t>(Files::Timestamp(path)), static_cast<int64_t>(Files::Size(path)));
+	}
+	
+	class Entry {
+	public:
+		pair<int64_t, int64_t> stamp;
+		vector<Point> points;
+		// Whether this mask has been asked for since the cache was read.
+		bool isUsed = false;
+	};
+	
+	// The sprites are loaded by several threads at once, so all access to the
+	// cache must be guarded by this mutex.
+	mutex cacheMutex;
+	string cachePath;
+	map<string, Entry> entries;
+	// Whether the cache file needs to be rewritten.
+	bool isChanged = false;
+}
+
+
+
+// Read the cache file at the given path. This must be done before any of the
+// sprites begin loading.
+void MaskCache::Load(const string &path)
+{
+	lock_guard<mutex> lock(cacheMutex);
+	cachePath = path;
+	entries.clear();
+	isChanged = false;
+	
+	string cache = Files::Read(cachePath);
+	if(cache.compare(0, SIGNATURE_SIZE, SIGNATURE))
+		return;
+	
+	const char *it = cache.data() + SIGNATURE_SIZE;
+	const char *end = cache.data() + cache.length();
+	uint32_t count = 0;
+	ReadValue(it, end, count);
+	
+	string name;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		Entry entry;
+		uint32_t size = 0;
+		if(!ReadString(it, end, name) || !ReadValue(it, end, entry.stamp.first)
+				|| !ReadValue(it, end, entry.stamp.second) || !ReadValue(it, end, size)
+				|| size > static_cast<size_t>(end - it) / (2 * sizeof(double)))
+			break;
+		
+		entry.points.resize(size);
+		for(Point &point : entry.points)
+		{
+			double x = 0.;
+			double y = 0.;
+			ReadValue(it, end, x);
+			ReadValue(it, end, y);
+			point = Point(x, y);
+		}
+		entries[name] = std::move(entry);
+	}
+}
+
+
+
+// Rewrite the cache file if any masks have been traced since it was read, or if
+// any of the masks in it are no longer in use. This should be done once all the
+// sprites have been loaded.
+void MaskCache::Save()
+{
+	lock_guard<mutex> lock(cacheMutex);
+	for(auto it = entries.begin(); it != entries.end(); )
+	{
+		if(it->second.isUsed)
+			++it;
+		else
+		{
+			it = entries.erase(it);
+			isChanged = true;
+		}
+	}
+	if(!isChanged || cachePath.empty())
+		return;
+	
+	string out(SIGNATURE, SIGNATURE_SIZE);
+	WriteValue<uint32_t>(out, entries.size());
+	for(const auto &it : entries)
+	{
+		WriteString(out, it.first);
+		WriteValue(out, it.second.stamp.first);
+		WriteValue(out, it.second.stamp.second);
+		WriteValue<uint32_t>(out, it.second.points.size());
+		for(const Point &point : it.second.points)
+		{
+			WriteValue(out, point.X());
+			WriteValue(out, point.Y());
+		}
+	}
+	Files::Write(cachePath, out);
+	isChanged = false;
+}
+
+
+
+// Get the mask for the given image, if it is in the cache and the image has not
+// changed since it was traced. This is safe to call from any thread.
+bool MaskCache::Get(const string &path, Mask &mask)
+{
+	pair<int64_t, int64_t> stamp = Stamp(path);
+	
+	lock_guard<mutex> lock(cacheMutex);
+	auto it = entries.find(path);
+	if(it == entries.end() || it->second.stamp != stamp || it->second.points.empty())
+		return false;
+	
+	it->second.isUsed = true;
+	mask.Create(it->second.points);
+	return true;
+}
+
+
+
+// Add a mask that was just traced from the given image to the cache.
+void MaskCache::Set(const string &path, const Mask &mask)
+{
+	pair<int64_t, int64_t> stamp = Stamp(path);
+	
+	lock_guard<mutex> lock(cacheMutex);
+	Entry &entry = entries[path];
+	entry.stamp = stamp;
+	entry.points = mask.Points();
+	entry.isUsed = true;
+	isChanged = true;
+}
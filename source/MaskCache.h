@@ -0,0 +1,46 @@
+/* MaskCache.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MASK_CACHE_H_
+#define MASK_CACHE_H_
+
+#include <string>
+
+class Mask;
+
+
+
+// Class that keeps a binary copy of the collision masks of every sprite on disk,
+// so that the next time the game starts, the outline of any image whose time
+// stamp and size have not changed can be restored instead of being traced from
+// its pixels again. Masks that are looked up in the cache are looked up by the
+// path to the image file that they were traced from.
+class MaskCache {
+public:
+	// Read the cache file at the given path. This must be done before any of
+	// the sprites begin loading.
+	static void Load(const std::string &path);
+	// Rewrite the cache file if any masks have been traced since it was read,
+	// or if any of the masks in it are no longer in use. This should be done
+	// once all the sprites have been loaded.
+	static void Save();
+	
+	// Get the mask for the given image, if it is in the cache and the image has
+	// not changed since it was traced. This is safe to call from any thread.
+	static bool Get(const std::string &path, Mask &mask);
+	// Add a mask that was just traced from the given image to the cache.
+	static void Set(const std::string &path, const Mask &mask);
+};
+
+
+
+#endif
@@ -0,0 +1,89 @@
+/* MemoryUsage.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "MemoryUsage.h"
+
+#include <atomic>
+#include <iomanip>
+
+using namespace std;
+
+namespace {
+	const string NAMES[MemoryUsage::CATEGORY_COUNT] = {
+		"textures",
+		"collision masks",
+		"sounds",
+		"data nodes",
+		"game objects"
+	};
+	
+	atomic<int64_t> current[MemoryUsage::CATEGORY_COUNT];
+	atomic<int64_t> peak[MemoryUsage::CATEGORY_COUNT];
+	
+	double Megabytes(int64_t bytes)
+	{
+		return bytes / 1048576.;
+	}
+}
+
+
+
+// Add the given number of bytes to a category.
+void MemoryUsage::Add(Category category, int64_t bytes)
+{
+	int64_t now = (current[category] += bytes);
+	// Another thread may be raising the peak at the same time.
+	int64_t high = peak[category];
+	while(now > high && !peak[category].compare_exchange_weak(high, now))
+		continue;
+}
+
+
+
+// Get the number of bytes a category is using now.
+int64_t MemoryUsage::Current(Category category)
+{
+	return current[category];
+}
+
+
+
+// Get the most bytes a category has used at any one time.
+int64_t MemoryUsage::Peak(Category category)
+{
+	return peak[category];
+}
+
+
+
+const string &MemoryUsage::Name(Category category)
+{
+	return NAMES[category];
+}
+
+
+
+// Print a table of the current and peak usage of every category.
+void MemoryUsage::Print(ostream &out)
+{
+	out << fixed << setprecision(1);
+	out << setw(16) << left << "memory (MB)" << right << setw(10) << "current" << setw(10) << "peak" << endl;
+	int64_t total = 0;
+	for(int i = 0; i < CATEGORY_COUNT; ++i)
+	{
+		Category category = static_cast<Category>(i);
+		total += Current(category);
+		out << setw(16) << left << Name(category) << right << setw(10) << Megabytes(Current(category))
+			<< setw(10) << Megabytes(Peak(category)) << endl;
+	}
+	out << setw(16) << left << "total" << right << setw(10) << Megabytes(total) << endl;
+}
@@ -0,0 +1,60 @@
+/* MemoryUsage.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef MEMORY_USAGE_H_
+#define MEMORY_USAGE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+
+
+// Class that keeps a running count of how many bytes each of the subsystems
+// that take up the most memory is using, so it is possible to tell where the
+// memory goes. Each subsystem adds to its count when it allocates something
+// and subtracts from it when it frees it again. The counts may be changed from
+// any thread.
+class MemoryUsage {
+public:
+	enum Category {
+		// Sprite textures, uploaded to the graphics card.
+		TEXTURES,
+		// The collision masks of the sprites.
+		MASKS,
+		// The samples of the sounds, in OpenAL buffers or compressed copies.
+		SOUNDS,
+		// The nodes of the data files that are being loaded.
+		DATA,
+		// The game's named objects (ships, outfits, systems, and so on).
+		OBJECTS,
+		CATEGORY_COUNT
+	};
+	
+	
+public:
+	// Add the given number of bytes to a category. To free them again, pass a
+	// negative number.
+	static void Add(Category category, int64_t bytes);
+	// Get the number of bytes a category is using now, and the most it has
+	// used at any one time.
+	static int64_t Current(Category category);
+	static int64_t Peak(Category category);
+	static const std::string &Name(Category category);
+	
+	// Print a table of the current and peak usage of every category.
+	static void Print(std::ostream &out);
+};
+
+
+
+#endif
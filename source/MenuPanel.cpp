@@ -54,6 +54,10 @@ MenuPanel::MenuPanel(PlayerInfo &player, UI &gamePanels)
 	: player(player), gamePanels(gamePanels), scroll(0)
 {
 	SetIsFullScreen(true);
+	// This panel checks on the loading of the game data, and uploads the
+	// sprites as they are loaded, even while preferences or saved games are
+	// shown on top of it.
+	SetStepsWhenHidden(true);
 	
 	credits = Format::Split(Files::Read(Files::Resources() + "credits.txt"), "\n");
 }
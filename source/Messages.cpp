@@ -12,23 +12,56 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Messages.h"
 
+#include <deque>
 #include <mutex>
 
 using namespace std;
 
 namespace {
+	// Each new message ages the older ones, so that no more than a screenful
+	// of them is ever shown, and this is more messages than can survive that.
+	// If more than this many come in before the list is next checked, only
+	// the newest ones are kept.
+	const size_t MAX_INCOMING = 64;
+	
+	class Incoming {
+	public:
+		Incoming(const string &message, bool isImportant) : message(message), isImportant(isImportant) {}
+		
+		string message;
+		bool isImportant;
+		int count = 1;
+	};
+	
 	mutex incomingMutex;
 	
-	vector<pair<string, bool>> incoming;
+	deque<Incoming> incoming;
 	vector<Messages::Entry> list;
 }
 
 
 
+Messages::Entry::Entry(int step, const string &message, int count)
+	: step(step), message(message), count(count),
+	text(count > 1 ? message + " (x" + to_string(count) + ")" : message)
+{
+}
+
+
+
 // Add a message to the list.
 void Messages::Add(const string &message, bool isImportant)
 {
 	lock_guard<mutex> lock(incomingMutex);
+	// The same message being added several times in a row, e.g. when picking
+	// up many pieces of flotsam at once, only needs to be shown once.
+	if(!incoming.empty() && incoming.back().message == message && incoming.back().isImportant == isImportant)
+	{
+		++incoming.back().count;
+		return;
+	}
+	if(incoming.size() >= MAX_INCOMING)
+		incoming.pop_front();
 	incoming.emplace_back(message, isImportant);
 }
 
@@ -42,10 +75,11 @@ const vector<Messages::Entry> &Messages::Get(int step)
 	lock_guard<mutex> lock(incomingMutex);
 	
 	// Load the incoming messages.
-	for(const pair<string, bool> &item : incoming)
+	for(const Incoming &item : incoming)
 	{
-		const string &message = item.first;
-		bool isImportant = item.second;
+		const string &message = item.message;
+		bool isImportant = item.isImportant;
+		int count = item.count;
 		
 		// If this message is not important and it is already being shown in the
 		// list, ignore it.
@@ -59,20 +93,24 @@ const vector<Messages::Entry> &Messages::Get(int step)
 		}
 		
 		// For each incoming message, if it exactly matches an existing message,
-		// replace that one with this new one.
+		// replace that one with this new one, which counts the old one's
+		// repetitions as well.
 		auto it = list.begin();
 		while(it != list.end())
 		{
 			// Each time a new message comes in, "age" all the existing ones to
 			// limit how many of them appear at once.
 			it->step -= 60;
+			bool isRepeat = (isImportant && it->message == message);
+			if(isRepeat && it == list.end() - 1)
+				count += it->count;
 			// Also erase messages that have reached the end of their lifetime.
-			if((isImportant && it->message == message) || it->step < step - 1000)
+			if(isRepeat || it->step < step - 1000)
 				it = list.erase(it);
 			else
 				++it;
 		}
-		list.emplace_back(step, message);
+		list.emplace_back(step, message, count);
 	}
 	incoming.clear();
 	return list;
@@ -22,16 +22,21 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 // gradually fade as the game steps forward, so each one must remember the game
 // step when it came into being. If a new message is added that exactly matches
 // an old one, the old version is removed before the new one is added; this is
-// to keep repeated messages from filling up the whole screen.
+// to keep repeated messages from filling up the whole screen, and the new one
+// is shown with a count of how many times it has been repeated.
 class Messages {
 public:
 	class Entry {
 	public:
 		Entry() = default;
-		Entry(int step, const std::string &message) : step(step), message(message) {}
+		Entry(int step, const std::string &message, int count = 1);
 		
 		int step;
 		std::string message;
+		// How many times this message has been added in a row.
+		int count = 1;
+		// The message as it is shown, including the count if it is repeated.
+		std::string text;
 	};
 	
 public:
@@ -34,7 +34,7 @@ class Visual;
 
 // Class representing an asteroid or other minable object that orbits in an
 // ellipse around the system center.
-class Minable : public Body {
+class Minable : public Body, public std::enable_shared_from_this<Minable> {
 public:
 	/* Inherited from Body:
 	Frame GetFrame(int step = -1) const;
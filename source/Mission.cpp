@@ -40,11 +40,11 @@ namespace {
 	{
 		vector<int> weight;
 		int total = 0;
-		for(const Trade::Commodity &commodity : GameData::Commodities())
+		for(size_t i = 0; i < GameData::Commodities().size(); ++i)
 		{
 			// For every 100 credits in profit you can make, double the chance
 			// of this commodity being chosen.
-			double profit = to.Trade(commodity.name) - from.Trade(commodity.name);
+			double profit = to.Trade(i) - from.Trade(i);
 			int w = max<int>(1, 100. * pow(2., profit * .01));
 			weight.push_back(w);
 			total += w;
@@ -564,14 +564,8 @@ bool Mission::CanOffer(const PlayerInfo &player, const shared_ptr<Ship> &boardin
 		if(!sourceFilter.Matches(*boardingShip))
 			return false;
 	}
-	else
-	{
-		if(source && source != player.GetPlanet())
-			return false;
-	
-		if(!sourceFilter.Matches(player.GetPlanet()))
-			return false;
-	}
+	else if(!MatchesSource(player.GetPlanet()))
+		return false;
 	
 	if(!toOffer.Test(player.Conditions()))
 		return false;
@@ -603,6 +597,18 @@ bool Mission::CanOffer(const PlayerInfo &player, const shared_ptr<Ship> &boardin
 
 
 
+// Check if this mission's source and source filter allow it to be offered on
+// the given planet. This only depends on the game data.
+bool Mission::MatchesSource(const Planet *planet) const
+{
+	if(source && source != planet)
+		return false;
+	
+	return sourceFilter.Matches(planet);
+}
+
+
+
 bool Mission::HasSpace(const PlayerInfo &player) const
 {
 	int extraCrew = 0;
@@ -867,7 +873,7 @@ void Mission::Do(const ShipEvent &event, PlayerInfo &player, UI *ui)
 	if(event.TargetGovernment()->IsPlayer() && !hasFailed)
 	{
 		bool failed = false;
-		string message = "Your ship '" + event.Target()->Name() + "' has been ";
+		const char *how = nullptr;
 		if(event.Type() & ShipEvent::DESTROY)
 		{
 			// Destroyed ships carrying mission cargo result in failed missions.
@@ -877,23 +883,22 @@ void Mission::Do(const ShipEvent &event, PlayerInfo &player, UI *ui)
 			// If any mission passengers were present, this mission is failed.
 			for(const auto &it : event.Target()->Cargo().PassengerList())
 				failed |= (it.first == this && it.second);
-			if(failed)
-				message += "lost. ";
+			how = "lost. ";
 		}
 		else if(event.Type() & ShipEvent::BOARD)
 		{
 			// Fail missions whose cargo is stolen by a boarding vessel.
 			for(const auto &it : event.Actor()->Cargo().MissionCargo())
 				failed |= (it.first == this);
-			if(failed)
-				message += "plundered. ";
+			how = "plundered. ";
 		}
 		
 		if(failed)
 		{
 			hasFailed = true;
 			if(isVisible)
-				Messages::Add(message + "Mission failed: \"" + displayName + "\".");
+				Messages::Add("Your ship '" + event.Target()->Name() + "' has been " + how
+					+ "Mission failed: \"" + displayName + "\".");
 		}
 	}
 	
@@ -1073,19 +1078,17 @@ Mission Mission::Instantiate(const PlayerInfo &player, const shared_ptr<Ship> &b
 	while(!destinations.empty())
 	{
 		// Find the closest destination to this location.
-		DistanceMap distance(path);
 		auto it = destinations.begin();
 		auto bestIt = it;
 		for(++it; it != destinations.end(); ++it)
-			if(distance.Days(*it) < distance.Days(*bestIt))
+			if(DistanceMap::Jumps(path, *it) < DistanceMap::Jumps(path, *bestIt))
 				bestIt = it;
 		
+		jumps += DistanceMap::Jumps(path, *bestIt);
 		path = *bestIt;
-		jumps += distance.Days(*bestIt);
 		destinations.erase(bestIt);
 	}
-	DistanceMap distance(path);
-	jumps += distance.Days(result.destination->GetSystem());
+	jumps += DistanceMap::Jumps(path, result.destination->GetSystem());
 	int payload = result.cargoSize + 10 * result.passengers;
 	
 	// Set the deadline, if requested.
@@ -102,6 +102,9 @@ public:
 	// into account, so before actually offering a mission you should also check
 	// if the player has enough space.
 	bool CanOffer(const PlayerInfo &player, const std::shared_ptr<Ship> &boardingShip = nullptr) const;
+	// Check if this mission's source and source filter allow it to be offered
+	// on the given planet. This only depends on the game data.
+	bool MatchesSource(const Planet *planet) const;
 	bool HasSpace(const PlayerInfo &player) const;
 	bool HasSpace(const Ship &ship) const;
 	bool CanComplete(const PlayerInfo &player) const;
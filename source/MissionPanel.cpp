@@ -667,6 +667,9 @@ Point MissionPanel::DrawList(const list<Mission> &list, Point pos) const
 			continue;
 		
 		pos.Y() += 20.;
+		// Rows that are off the screen only need to be counted.
+		if(pos.Y() + 20. < Screen::Top() || pos.Y() > Screen::Bottom())
+			continue;
 		
 		bool isSelected = (it == availableIt || it == acceptedIt);
 		if(isSelected)
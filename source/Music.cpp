@@ -13,12 +13,21 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Music.h"
 
 #include "Files.h"
+#include "Threads.h"
+#include "Trace.h"
 
 #include <mad.h>
+#ifdef ES_VORBIS
+// The default callbacks in this header cause "unused variable" warnings.
+#define OV_EXCLUDE_STATIC_CALLBACKS
+#include <vorbis/vorbisfile.h>
+#endif
 
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <map>
+#include <memory>
 
 using namespace std;
 
@@ -28,8 +37,340 @@ namespace {
 	// How many samples to put in each output block. Because the output is in
 	// stereo, the duration of the sample is half this amount:
 	const size_t OUTPUT_CHUNK = 32768;
+	// How many samples the ring buffer holds. Generally try to queue up two
+	// chunks worth of samples in it, just in case NextChunk() gets called twice
+	// in rapid succession.
+	const size_t RING_SIZE = 3 * OUTPUT_CHUNK;
+	// The decoding thread waits until it can add at least this many samples.
+	const size_t MIN_WRITE = OUTPUT_CHUNK / 4;
+	// The only sample rate that is supported.
+	const int SAMPLE_RATE = 44100;
 	
 	map<string, string> paths;
+	
+	
+	
+	// Interface for decoding one type of audio file into 16-bit stereo samples.
+	// Each decoder takes ownership of the file that it is given.
+	class Decoder {
+	public:
+		virtual ~Decoder() = default;
+		
+		// Decode up to the given number of samples (counting each channel
+		// separately). This returns fewer than that only at the end of the file.
+		size_t Read(int16_t *out, size_t count);
+		// Go back to the start of the file.
+		virtual bool Rewind() = 0;
+		
+		
+	protected:
+		// Decode the next block of samples into the given buffer, which starts
+		// out empty. Return false at the end of the file.
+		virtual bool DecodeBlock(vector<int16_t> &samples) = 0;
+		// Discard any samples that have been decoded but not read.
+		void ClearBlock();
+		
+		
+	private:
+		vector<int16_t> block;
+		size_t blockPosition = 0;
+	};
+	
+	
+	
+	size_t Decoder::Read(int16_t *out, size_t count)
+	{
+		size_t done = 0;
+		while(done < count)
+		{
+			if(blockPosition == block.size())
+			{
+				ClearBlock();
+				if(!DecodeBlock(block))
+					break;
+			}
+			size_t size = min(count - done, block.size() - blockPosition);
+			memcpy(out + done, block.data() + blockPosition, size * sizeof(int16_t));
+			blockPosition += size;
+			done += size;
+		}
+		return done;
+	}
+	
+	
+	
+	void Decoder::ClearBlock()
+	{
+		block.clear();
+		blockPosition = 0;
+	}
+	
+	
+	
+	// Decoder for MP3 files, using libmad.
+	class MP3Decoder : public Decoder {
+	public:
+		explicit MP3Decoder(FILE *file);
+		virtual ~MP3Decoder() override;
+		
+		virtual bool Rewind() override;
+		
+		
+	protected:
+		virtual bool DecodeBlock(vector<int16_t> &samples) override;
+		
+		
+	private:
+		void Init();
+		void Finish();
+		
+		
+	private:
+		FILE *file;
+		// This vector will store the input from the file.
+		vector<unsigned char> input;
+		// Objects for MP3 decoding:
+		mad_stream stream;
+		mad_frame frame;
+		mad_synth synth;
+	};
+	
+	
+	
+	MP3Decoder::MP3Decoder(FILE *file)
+		: file(file), input(INPUT_CHUNK, 0)
+	{
+		Init();
+	}
+	
+	
+	
+	MP3Decoder::~MP3Decoder()
+	{
+		Finish();
+		fclose(file);
+	}
+	
+	
+	
+	bool MP3Decoder::Rewind()
+	{
+		Finish();
+		rewind(file);
+		ClearBlock();
+		Init();
+		return true;
+	}
+	
+	
+	
+	bool MP3Decoder::DecodeBlock(vector<int16_t> &samples)
+	{
+		// Decode the next frame, reading more input whenever the stream runs
+		// out of it.
+		while(mad_frame_decode(&frame, &stream))
+		{
+			// For recoverable errors, keep going.
+			if(MAD_RECOVERABLE(stream.error))
+				continue;
+			
+			// See if any input data is left undecoded in the stream. Typically
+			// this is because the last block of input contained a fraction of a
+			// full MP3 frame.
+			size_t remainder = 0;
+			if(stream.next_frame && stream.next_frame < stream.bufend)
+				remainder = stream.bufend - stream.next_frame;
+			if(remainder)
+				memmove(&input.front(), stream.next_frame, remainder);
+			
+			// Now, read a chunk of data from the file.
+			size_t read = fread(&input.front() + remainder, 1, INPUT_CHUNK - remainder, file);
+			if(!read)
+				return false;
+			
+			// Hand the input to the stream decoder.
+			mad_stream_buffer(&stream, &input.front(), read + remainder);
+		}
+		// Convert the decoded audio into a PCM signal.
+		mad_synth_frame(&synth, &frame);
+		
+		// If the source is mono, read both output channels from the left input.
+		// Otherwise, read two separate input channels.
+		mad_fixed_t *channels[2] = {
+			synth.pcm.samples[0],
+			synth.pcm.samples[synth.pcm.channels > 1]
+		};
+		
+		// We'll alternate what channel we read from each time through the loop.
+		int channel = 0;
+		for(unsigned i = 0; i < 2 * synth.pcm.length; ++i)
+		{
+			// Read the next sample from the next channel.
+			mad_fixed_t sample = *channels[channel]++;
+			channel = !channel;
+			
+			// Clip and scale the sample to 16 bits.
+			sample += (1L << (MAD_F_FRACBITS - 16));
+			sample = max(-MAD_F_ONE, min(MAD_F_ONE - 1, sample));
+			samples.push_back(sample >> (MAD_F_FRACBITS + 1 - 16));
+		}
+		return true;
+	}
+	
+	
+	
+	void MP3Decoder::Init()
+	{
+		mad_stream_init(&stream);
+		mad_frame_init(&frame);
+		mad_synth_init(&synth);
+	}
+	
+	
+	
+	void MP3Decoder::Finish()
+	{
+		mad_synth_finish(&synth);
+		mad_frame_finish(&frame);
+		mad_stream_finish(&stream);
+	}
+
+
+
+#ifdef ES_VORBIS
+	// Decoder for Ogg Vorbis files, using libvorbisfile. Vorbis takes less CPU
+	// time to decode than MP3, and sounds better at the same file size.
+	class VorbisDecoder : public Decoder {
+	public:
+		explicit VorbisDecoder(FILE *file);
+		virtual ~VorbisDecoder() override;
+		
+		virtual bool Rewind() override;
+		
+		
+	protected:
+		virtual bool DecodeBlock(vector<int16_t> &samples) override;
+		
+		
+	private:
+		OggVorbis_File vorbis;
+		bool isOpen = false;
+		int channels = 0;
+		vector<int16_t> input;
+	};
+	
+	
+	
+	VorbisDecoder::VorbisDecoder(FILE *file)
+		: input(INPUT_CHUNK / sizeof(int16_t), 0)
+	{
+		ov_callbacks callbacks = {
+			[](void *data, size_t size, size_t count, void *file) -> size_t {
+				return fread(data, size, count, static_cast<FILE *>(file));
+			},
+			[](void *file, ogg_int64_t offset, int whence) -> int {
+				return fseek(static_cast<FILE *>(file), offset, whence);
+			},
+			[](void *file) -> int {
+				return fclose(static_cast<FILE *>(file));
+			},
+			[](void *file) -> long {
+				return ftell(static_cast<FILE *>(file));
+			}
+		};
+		// Once the file is open, libvorbisfile is responsible for closing it.
+		isOpen = !ov_open_callbacks(file, &vorbis, nullptr, 0, callbacks);
+		if(!isOpen)
+		{
+			fclose(file);
+			return;
+		}
+		
+		const vorbis_info *info = ov_info(&vorbis, -1);
+		channels = info ? info->channels : 0;
+		if(!info || info->rate != SAMPLE_RATE)
+			Files::LogError("Ogg Vorbis music must have a sample rate of " + to_string(SAMPLE_RATE) + " Hz.");
+	}
+	
+	
+	
+	VorbisDecoder::~VorbisDecoder()
+	{
+		if(isOpen)
+			ov_clear(&vorbis);
+	}
+	
+	
+	
+	bool VorbisDecoder::Rewind()
+	{
+		ClearBlock();
+		return isOpen && !ov_pcm_seek(&vorbis, 0);
+	}
+	
+	
+	
+	bool VorbisDecoder::DecodeBlock(vector<int16_t> &samples)
+	{
+		const vorbis_info *info = isOpen ? ov_info(&vorbis, -1) : nullptr;
+		if(!info || info->rate != SAMPLE_RATE || channels < 1)
+			return false;
+		
+		// The decoded samples are interleaved, with each frame holding one sample
+		// for each channel. Skip over any holes in the data.
+		long bytes = OV_HOLE;
+		int section = 0;
+		while(bytes == OV_HOLE)
+			bytes = ov_read(&vorbis, reinterpret_cast<char *>(input.data()),
+				input.size() * sizeof(int16_t), 0, sizeof(int16_t), 1, &section);
+		if(bytes <= 0)
+			return false;
+		
+		// If the source is mono, use its one channel for both outputs. If it has
+		// more than two channels, only use the first two.
+		size_t frames = bytes / (sizeof(int16_t) * channels);
+		for(size_t i = 0; i < frames; ++i)
+		{
+			const int16_t *it = input.data() + i * channels;
+			samples.push_back(it[0]);
+			samples.push_back(it[channels > 1]);
+		}
+		return true;
+	}
+#endif
+
+
+
+	// The supported file types, and a function to create a decoder for each.
+	class Format {
+	public:
+		const char *extension;
+		Decoder *(*create)(FILE *file);
+	};
+	
+	const Format FORMATS[] = {
+		{".mp3", [](FILE *file) -> Decoder * { return new MP3Decoder(file); }},
+#ifdef ES_VORBIS
+		{".ogg", [](FILE *file) -> Decoder * { return new VorbisDecoder(file); }},
+#endif
+	};
+	
+	
+	
+	// Get the format of the given file, based on its extension.
+	const Format *GetFormat(const string &path)
+	{
+		if(path.length() < 4)
+			return nullptr;
+		
+		string extension = path.substr(path.length() - 4);
+		for(char &c : extension)
+			c = tolower(c);
+		for(const Format &format : FORMATS)
+			if(extension == format.extension)
+				return &format;
+		return nullptr;
+	}
 }
 
 
@@ -47,8 +388,7 @@ void Music::Init(const vector<string> &sources)
 			// Sanity check on the path length.
 			if(path.length() < root.length() + 4)
 				continue;
-			string ext = path.substr(path.length() - 4);
-			if(ext != ".mp3" && ext != ".MP3")
+			if(!GetFormat(path))
 				continue;
 			
 			string name = path.substr(root.length(), path.length() - root.length() - 4);
@@ -62,7 +402,7 @@ void Music::Init(const vector<string> &sources)
 // Music constructor, which starts the decoding thread. Initially, the thread
 // has no file to read, so it will sleep until a file is specified.
 Music::Music()
-	: silence(OUTPUT_CHUNK, 0)
+	: silence(OUTPUT_CHUNK, 0), ring(RING_SIZE, 0), readPosition(0), writePosition(0), hasNewFile(false)
 {
 	// Don't start the thread until this object is fully constructed.
 	thread = std::thread(&Music::Decode, this);
@@ -102,16 +442,18 @@ void Music::SetSource(const string &name)
 	previousPath = path;
 	
 	// Inform the decoding thread that it should switch to decoding a new file.
+	// Until it does, it will also clear any decoded data left over from the
+	// previous file, and this object will only return silence.
 	unique_lock<mutex> lock(decodeMutex);
+	if(nextFile)
+		fclose(nextFile);
 	if(path.empty())
 		nextFile = nullptr;
 	else
 		nextFile = Files::Open(path);
+	nextPath = path;
 	hasNewFile = true;
 	
-	// Also clear any decoded data left over from the previous file.
-	next.clear();
-	
 	// Notify the decoding thread that it can start.
 	lock.unlock();
 	condition.notify_all();
@@ -122,25 +464,36 @@ void Music::SetSource(const string &name)
 // Get the next audio buffer to play.
 const vector<int16_t> &Music::NextChunk()
 {
-	// Check whether the "next" buffer is ready.
-	unique_lock<mutex> lock(decodeMutex);
-	if(next.size() < OUTPUT_CHUNK)
+	// Check whether the next chunk is ready. This must be called from the same
+	// thread as SetSource(), so the positions cannot be reset while it is
+	// reading from the buffer.
+	if(hasNewFile.load(memory_order_acquire))
+		return silence;
+	size_t read = readPosition.load(memory_order_relaxed);
+	size_t written = writePosition.load(memory_order_acquire);
+	if(written - read < OUTPUT_CHUNK)
 		return silence;
 	
-	// If the next buffer is ready, move a chunk of data into the output buffer.
-	// All output buffers need to be the same size so that we can fade between
-	// two different sources.
-	current.clear();
-	current.insert(current.begin(), next.begin(), next.begin() + OUTPUT_CHUNK);
-	next.erase(next.begin(), next.begin() + OUTPUT_CHUNK);
+	// If the next chunk is ready, copy it into the output buffer. All output
+	// buffers need to be the same size so that we can fade between two
+	// different sources.
+	current.resize(OUTPUT_CHUNK);
+	size_t start = read % RING_SIZE;
+	size_t first = min(OUTPUT_CHUNK, RING_SIZE - start);
+	memcpy(current.data(), ring.data() + start, first * sizeof(int16_t));
+	memcpy(current.data() + first, ring.data(), (OUTPUT_CHUNK - first) * sizeof(int16_t));
+	readPosition.store(read + OUTPUT_CHUNK, memory_order_release);
 	
-	// Once the lock is unlocked, notify the decoding thread to continue.
-	lock.unlock();
+	// Notify the decoding thread that there is room for more. Taking the lock
+	// makes sure that it is either waiting already, or has not yet checked
+	// how much room there is.
+	{
+		lock_guard<mutex> lock(decodeMutex);
+	}
 	condition.notify_all();
 	
 	// Return the buffer.
 	return current;
-	
 }
 
 
@@ -148,18 +501,13 @@ const vector<int16_t> &Music::NextChunk()
 // Entry point for the decoding thread.
 void Music::Decode()
 {
-	// This vector will store the input from the file.
-	vector<unsigned char> input(INPUT_CHUNK, 0);
-	// Objects for MP3 decoding:
-	mad_stream stream;
-	mad_frame frame;
-	mad_synth synth;
+	Threads::Scope threadScope("music", Threads::Priority::NORMAL);
 	// Loop until the thread is told to quit.
 	while(true)
 	{
 		// First, wait until a new file has been specified or we're done.
-		FILE *file = nullptr;
-		while(!file)
+		unique_ptr<Decoder> decoder;
+		while(!decoder)
 		{
 			unique_lock<mutex> lock(decodeMutex);
 			while(!done && !hasNewFile)
@@ -170,104 +518,64 @@ void Music::Decode()
 				return;
 			
 			// The new file now belongs to us, and it's our job to close it.
-			file = nextFile;
+			FILE *file = nextFile;
 			nextFile = nullptr;
-			hasNewFile = false;
+			const Format *format = GetFormat(nextPath);
+			if(file && format)
+				decoder.reset(format->create(file));
+			else if(file)
+				fclose(file);
+			
+			// Discard anything decoded from the previous file. The audio thread
+			// does not touch the buffer until it sees that the flag is cleared.
+			readPosition.store(0, memory_order_relaxed);
+			writePosition.store(0, memory_order_relaxed);
+			hasNewFile.store(false, memory_order_release);
 		}
 		
-		// Now, we have a file to read. Initialize the decoder.
-		mad_stream_init(&stream);
-		mad_frame_init(&frame);
-		mad_synth_init(&synth);
-		
 		// Loop until we are asked to switch files.
+		bool isEmpty = true;
 		while(true)
 		{
-			// If the "next" buffer has filled up, wait until it is retrieved.
-			// Generally try to queue up two chunks worth of samples in it, just
-			// in case NextChunk() gets called twice in rapid succession.
-			unique_lock<mutex> lock(decodeMutex);
-			while(!done && next.size() >= 2 * OUTPUT_CHUNK)
-				condition.wait(lock);
-			// Check if we're done or if we need to switch files.
-			if(done || hasNewFile)
-				break;
-			
-			// The lock can be freed until we start filling the output buffer.
-			lock.unlock();
-			
-			// See if any input data is left undecoded in the stream. Typically
-			// this is because the last block of input contained a fraction of a
-			// full MP3 frame.
-			size_t remainder = 0;
-			if(stream.next_frame && stream.next_frame < stream.bufend)
-				remainder = stream.bufend - stream.next_frame;
-			if(remainder)
-				memcpy(&input.front(), stream.next_frame, remainder);
-			
-			// Now, read a chunk of data from the file.
-			size_t read = fread(&input.front() + remainder, 1, INPUT_CHUNK - remainder, file);
-			// If you get the end of the file, loop around to the beginning.
-			if(!read || feof(file))
-				rewind(file);
-			// If there is nothing to decode, return to the top of this loop.
-			if(!(read + remainder))
-				continue;
-			
-			// Hand the input to the stream decoder.
-			mad_stream_buffer(&stream, &input.front(), read + remainder);
-			
-			// Loop through the decoded result for that input block.
-			while(true)
+			// If the ring buffer has filled up, wait until some of it is read.
+			size_t written = writePosition.load(memory_order_relaxed);
+			size_t room = 0;
 			{
-				// Decode the next frame, and check if there is an error.
-				if(mad_frame_decode(&frame, &stream))
-				{
-					// For recoverable errors, keep going.
-					if(MAD_RECOVERABLE(stream.error))
-						continue;
-					else
-						break;
-				}
-				// Convert the decoded audio into a PCM signal.
-				mad_synth_frame(&synth, &frame);
-				
-				// If the source is mono, read both output channels from the left input.
-				// Otherwise, read two separate input channels.
-				mad_fixed_t *channels[2] = {
-					synth.pcm.samples[0],
-					synth.pcm.samples[synth.pcm.channels > 1]
-				};
-				
-				// For this part, we need access to the output buffer.
-				lock.lock();
+				unique_lock<mutex> lock(decodeMutex);
+				while(!done && !hasNewFile
+						&& (room = RING_SIZE - (written - readPosition.load(memory_order_acquire))) < MIN_WRITE)
+					condition.wait(lock);
+				// Check if we're done or if we need to switch files.
 				if(done || hasNewFile)
 					break;
-	
-				// We'll alternate what channel we read from each time through the loop.
-				int channel = 0;
-				for(unsigned i = 0; i < 2 * synth.pcm.length; ++i)
-				{
-					// Read the next sample from the next channel.
-					mad_fixed_t sample = *channels[channel]++;
-					channel = !channel;
-		
-					// Clip and scale the sample to 16 bits.
-					sample += (1L << (MAD_F_FRACBITS - 16));
-					sample = max(-MAD_F_ONE, min(MAD_F_ONE - 1, sample));
-					next.push_back(sample >> (MAD_F_FRACBITS + 1 - 16));
-				}
-				// Now, the "next" buffer can be used by others. In theory, the
-				// NextChunk() function could take what's in that buffer while
-				// we are right in the middle of this decoding cycle.
-				lock.unlock();
+			}
+			TRACE_SCOPE("Music::Decode");
+			
+			// Decode straight into the free part of the ring buffer. That may
+			// take two steps, if the free part wraps around its end.
+			size_t decoded = 0;
+			while(decoded < room)
+			{
+				size_t start = (written + decoded) % RING_SIZE;
+				size_t size = min(room - decoded, RING_SIZE - start);
+				size_t read = decoder->Read(ring.data() + start, size);
+				decoded += read;
+				if(read < size)
+					break;
+			}
+			if(decoded)
+			{
+				isEmpty = false;
+				writePosition.store(written + decoded, memory_order_release);
+			}
+			else
+			{
+				// If you get the end of the file, loop around to the beginning,
+				// unless the file did not have anything in it.
+				if(isEmpty || !decoder->Rewind())
+					break;
+				isEmpty = true;
 			}
 		}
-		
-		// Clean up.
-		mad_synth_finish(&synth);
-		mad_frame_finish(&frame);
-		mad_stream_finish(&stream);
-		fclose(file);
 	}
 }
@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef MUSIC_H_
 #define MUSIC_H_
 
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <cstdio>
@@ -23,9 +24,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 
 
-// The Music class streams mp3 audio from a file and delivers it to the program
-// on "block" at a time, so it never needs to hold the entire decoded file in
-// memory. Each block is 16-bit stereo, 44100 Hz. If no file is specified, or if
+// The Music class streams mp3 (or, if built with Ogg Vorbis support, ogg) audio
+// from a file and delivers it to the program one "block" at a time, so it never
+// needs to hold the entire decoded file in memory. Each block is 16-bit stereo, 44100 Hz. If no file is specified, or if
 // the decoding thread is not done yet, it returns silence rather than blocking,
 // so the game won't freeze if the music stops for some reason.
 class Music {
@@ -47,18 +48,27 @@ private:
 	
 	
 private:
-	// Buffers for storing the decoded audio sample. The "silence" buffer holds
-	// a block of silence to be returned if nothing was read from the file.
+	// The "silence" buffer holds a block of silence to be returned if nothing
+	// was read from the file.
 	std::vector<int16_t> silence;
-	std::vector<int16_t> next;
 	std::vector<int16_t> current;
+	// Ring buffer of decoded samples. The decoding thread writes to it and the
+	// audio thread reads from it. Each position only ever increases, and only
+	// one of the threads changes each of them, so the samples themselves can
+	// be handed over without locking.
+	std::vector<int16_t> ring;
+	std::atomic<size_t> readPosition;
+	std::atomic<size_t> writePosition;
 	
 	std::string previousPath;
 	// This pointer holds the file for as long as it is owned by the main
 	// thread. When the decode thread takes possession of it, it sets this
 	// pointer to null.
 	FILE *nextFile = nullptr;
-	bool hasNewFile = false;
+	std::string nextPath;
+	// While this is set, the audio thread does not read from the ring buffer,
+	// so that the decoding thread can empty it before starting the new file.
+	std::atomic<bool> hasNewFile;
 	bool done = false;
 	
 	std::thread thread;
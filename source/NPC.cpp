@@ -183,6 +183,7 @@ void NPC::Load(const DataNode &node)
 		ship->SetIsSpecial();
 		ship->FinishLoading(false);
 	}
+	CountActions();
 }
 
 
@@ -300,6 +301,7 @@ void NPC::Do(const ShipEvent &event, PlayerInfo &player, UI *ui, bool isVisible)
 	for(const Ship::Bay &bay : ship->Bays())
 		if(bay.ship)
 			actions[bay.ship.get()] |= type;
+	CountActions();
 	
 	// Check if the success status has changed. If so, display a message.
 	if(HasFailed() && !hasFailed && isVisible)
@@ -319,7 +321,9 @@ void NPC::Do(const ShipEvent &event, PlayerInfo &player, UI *ui, bool isVisible)
 
 bool NPC::HasSucceeded(const System *playerSystem) const
 {
-	if(HasFailed())
+	// Any ships that still need a required action done to them are counted
+	// whenever a ShipEvent is handled, so check that first.
+	if(HasFailed() || unfinishedShips)
 		return false;
 	
 	// Evaluate the status of each ship in this NPC block. If it has `accompany`,
@@ -353,16 +357,6 @@ bool NPC::HasSucceeded(const System *playerSystem) const
 				return false;
 		}
 	
-	if(!succeedIf)
-		return true;
-	
-	for(const shared_ptr<Ship> &ship : ships)
-	{
-		auto it = actions.find(ship.get());
-		if(it == actions.end() || (it->second & succeedIf) != succeedIf)
-			return false;
-	}
-	
 	return true;
 }
 
@@ -386,19 +380,8 @@ bool NPC::IsLeftBehind(const System *playerSystem) const
 
 
 bool NPC::HasFailed() const
-{					
-	for(const auto &it : actions)
-	{
-		if(it.second & failIf)
-			return true;
-	
-		// If we still need to perform an action on this NPC, then that ship
-		// being destroyed should cause the mission to fail.
-		if((~it.second & succeedIf) && (it.second & ShipEvent::DESTROY))
-			return true;
-	}
-
-	return false;
+{
+	return failedShips;
 }
 
 
@@ -482,5 +465,31 @@ NPC NPC::Instantiate(map<string, string> &subs, const System *origin, const Syst
 	else if(!conversation.IsEmpty())
 		result.conversation = conversation.Substitute(subs);
 	
+	result.CountActions();
 	return result;
 }
+
+
+
+// Recount which ships have met the conditions for this NPC to succeed or fail,
+// after the actions done to them have changed.
+void NPC::CountActions()
+{
+	failedShips = 0;
+	for(const auto &it : actions)
+	{
+		// If we still need to perform an action on this NPC, then that ship
+		// being destroyed should cause the mission to fail.
+		if((it.second & failIf) || ((~it.second & succeedIf) && (it.second & ShipEvent::DESTROY)))
+			++failedShips;
+	}
+	
+	unfinishedShips = 0;
+	if(succeedIf)
+		for(const shared_ptr<Ship> &ship : ships)
+		{
+			auto it = actions.find(ship.get());
+			if(it == actions.end() || (it->second & succeedIf) != succeedIf)
+				++unfinishedShips;
+		}
+}
@@ -66,6 +66,12 @@ public:
 	NPC Instantiate(std::map<std::string, std::string> &subs, const System *origin, const System *destination) const;
 	
 	
+private:
+	// Recount which ships have met the conditions for this NPC to succeed or
+	// fail, after the actions done to them have changed.
+	void CountActions();
+	
+	
 private:
 	// The government of the ships in this NPC:
 	const Government *government = nullptr;
@@ -100,6 +106,12 @@ private:
 	bool mustEvade = false;
 	bool mustAccompany = false;
 	std::map<const Ship *, int> actions;
+	// How many ships have had something done to them that fails this NPC, and
+	// how many still need something done to them for it to succeed. These only
+	// change when a ShipEvent is handled, so they are kept up to date then
+	// instead of being recounted each time this NPC's status is checked.
+	int failedShips = 0;
+	int unfinishedShips = 0;
 };
 
 
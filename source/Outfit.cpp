@@ -20,11 +20,97 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 
 #include <cmath>
+#include <cstring>
 
 using namespace std;
 
 namespace {
 	const double EPS = 0.0000000001;
+	
+	// The names of the attributes that have IDs, in alphabetical order.
+	const char *const ATTRIBUTE_NAMES[Outfit::ATTRIBUTE_COUNT] = {
+		"active cooling",
+		"afterburner energy",
+		"afterburner fuel",
+		"afterburner heat",
+		"afterburner thrust",
+		"asteroid scan power",
+		"atmosphere scan",
+		"cargo scan power",
+		"cargo scan speed",
+		"cloak",
+		"cloaking energy",
+		"cloaking fuel",
+		"cloaking heat",
+		"cooling",
+		"cooling energy",
+		"cooling inefficiency",
+		"disruption resistance",
+		"drag",
+		"energy capacity",
+		"energy consumption",
+		"energy generation",
+		"fuel capacity",
+		"fuel consumption",
+		"fuel energy",
+		"fuel generation",
+		"fuel heat",
+		"heat dissipation",
+		"heat generation",
+		"hull",
+		"hull energy",
+		"hull fuel",
+		"hull heat",
+		"hull repair rate",
+		"hyperdrive",
+		"ion resistance",
+		"jump drive",
+		"jump fuel",
+		"jump speed",
+		"outfit scan power",
+		"outfit scan speed",
+		"radar jamming",
+		"ramscoop",
+		"reverse thrust",
+		"reverse thrusting energy",
+		"reverse thrusting heat",
+		"scram drive",
+		"shield energy",
+		"shield fuel",
+		"shield generation",
+		"shield heat",
+		"shields",
+		"slowing resistance",
+		"solar collection",
+		"solar heat",
+		"tactical scan power",
+		"thrust",
+		"thrusting energy",
+		"thrusting heat",
+		"turn",
+		"turning energy",
+		"turning heat"
+	};
+	
+	// Find the ID of the attribute with the given name, or -1 if it has none.
+	int AttributeID(const char *name)
+	{
+		int low = 0;
+		int high = Outfit::ATTRIBUTE_COUNT;
+		while(low != high)
+		{
+			int mid = (low + high) / 2;
+			int cmp = strcmp(name, ATTRIBUTE_NAMES[mid]);
+			if(!cmp)
+				return mid;
+			
+			if(cmp < 0)
+				high = mid;
+			else
+				low = mid + 1;
+		}
+		return -1;
+	}
 }
 
 const vector<string> Outfit::CATEGORIES = {
@@ -125,6 +211,8 @@ void Outfit::Load(const DataNode &node)
 	};
 	convertScan("outfit");
 	convertScan("cargo");
+	
+	CacheAttributes();
 }
 
 
@@ -218,12 +306,16 @@ void Outfit::Add(const Outfit &other, int count)
 {
 	cost += other.cost * count;
 	mass += other.mass * count;
-	for(const auto &at : other.attributes)
-	{
-		attributes[at.first] += at.second * count;
-		if(fabs(attributes[at.first]) < EPS)
-			attributes[at.first] = 0.;
-	}
+	attributes.Add(other.attributes, count, EPS);
+	// The cached values do the same arithmetic as the dictionary, so they end up
+	// with exactly the same values without having to look them up.
+	for(int i = 0; i < ATTRIBUTE_COUNT; ++i)
+		if(other.cached[i])
+		{
+			cached[i] += other.cached[i] * count;
+			if(fabs(cached[i]) < EPS)
+				cached[i] = 0.;
+		}
 	
 	for(const auto &it : other.flareSprites)
 	{
@@ -249,6 +341,10 @@ void Outfit::Add(const Outfit &other, int count)
 void Outfit::Set(const char *attribute, double value)
 {
 	attributes[attribute] = value;
+	
+	int id = AttributeID(attribute);
+	if(id >= 0)
+		cached[id] = value;
 }
 
 
@@ -281,3 +377,12 @@ const Sprite *Outfit::FlotsamSprite() const
 {
 	return flotsamSprite;
 }
+
+
+
+// Copy the values of all attributes that have IDs out of the dictionary.
+void Outfit::CacheAttributes()
+{
+	for(int i = 0; i < ATTRIBUTE_COUNT; ++i)
+		cached[i] = attributes.Get(ATTRIBUTE_NAMES[i]);
+}
@@ -41,6 +41,27 @@ public:
 	// These are all the possible category strings for outfits.
 	static const std::vector<std::string> CATEGORIES;
 	
+	// Attributes that are queried often enough (e.g. every step for every ship)
+	// that they are also stored in a flat array, so they can be looked up by ID
+	// instead of by name. These must be kept in alphabetical order of the
+	// attribute names, which are defined in Outfit.cpp.
+	enum Attribute : int {
+		ACTIVE_COOLING, AFTERBURNER_ENERGY, AFTERBURNER_FUEL, AFTERBURNER_HEAT,
+		AFTERBURNER_THRUST, ASTEROID_SCAN_POWER, ATMOSPHERE_SCAN, CARGO_SCAN_POWER,
+		CARGO_SCAN_SPEED, CLOAK, CLOAKING_ENERGY, CLOAKING_FUEL, CLOAKING_HEAT,
+		COOLING, COOLING_ENERGY, COOLING_INEFFICIENCY, DISRUPTION_RESISTANCE, DRAG,
+		ENERGY_CAPACITY, ENERGY_CONSUMPTION, ENERGY_GENERATION, FUEL_CAPACITY,
+		FUEL_CONSUMPTION, FUEL_ENERGY, FUEL_GENERATION, FUEL_HEAT,
+		HEAT_DISSIPATION, HEAT_GENERATION, HULL, HULL_ENERGY, HULL_FUEL, HULL_HEAT,
+		HULL_REPAIR_RATE, HYPERDRIVE, ION_RESISTANCE, JUMP_DRIVE, JUMP_FUEL,
+		JUMP_SPEED, OUTFIT_SCAN_POWER, OUTFIT_SCAN_SPEED, RADAR_JAMMING, RAMSCOOP,
+		REVERSE_THRUST, REVERSE_THRUSTING_ENERGY, REVERSE_THRUSTING_HEAT,
+		SCRAM_DRIVE, SHIELD_ENERGY, SHIELD_FUEL, SHIELD_GENERATION, SHIELD_HEAT,
+		SHIELDS, SLOWING_RESISTANCE, SOLAR_COLLECTION, SOLAR_HEAT,
+		TACTICAL_SCAN_POWER, THRUST, THRUSTING_ENERGY, THRUSTING_HEAT, TURN,
+		TURNING_ENERGY, TURNING_HEAT, ATTRIBUTE_COUNT
+	};
+	
 public:
 	// An "outfit" can be loaded from an "outfit" node or from a ship's
 	// "attributes" node.
@@ -59,6 +80,7 @@ public:
 	
 	double Get(const char *attribute) const;
 	double Get(const std::string &attribute) const;
+	double Get(Attribute attribute) const;
 	const Dictionary &Attributes() const;
 	
 	// Determine whether the given number of instances of the given outfit can
@@ -81,6 +103,11 @@ public:
 	const Sprite *FlotsamSprite() const;
 	
 	
+private:
+	// Copy the values of all attributes that have IDs out of the dictionary.
+	void CacheAttributes();
+	
+	
 private:
 	std::string name;
 	std::string pluralName;
@@ -93,6 +120,8 @@ private:
 	std::vector<std::string> licenses;
 	
 	Dictionary attributes;
+	// The values of the attributes that have IDs.
+	double cached[ATTRIBUTE_COUNT] = {};
 	
 	std::vector<std::pair<Body, int>> flareSprites;
 	std::map<const Sound *, int> flareSounds;
@@ -105,6 +134,7 @@ private:
 // These get called a lot, so inline them for speed.
 inline int64_t Outfit::Cost() const { return cost; }
 inline double Outfit::Mass() const { return mass; }
+inline double Outfit::Get(Attribute attribute) const { return cached[attribute]; }
 
 
 
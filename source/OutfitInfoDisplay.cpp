@@ -201,6 +201,12 @@ void OutfitInfoDisplay::UpdateRequirements(const Outfit &outfit, const PlayerInf
 
 void OutfitInfoDisplay::UpdateAttributes(const Outfit &outfit)
 {
+	// An outfit's attributes never change, so if this is the same outfit as
+	// the last time, the table is already up to date.
+	if(&outfit == attributesOutfit)
+		return;
+	attributesOutfit = &outfit;
+	
 	attributeLabels.clear();
 	attributeValues.clear();
 	attributesHeight = 20;
@@ -57,6 +57,9 @@ private:
 	std::vector<std::string> requirementLabels;
 	std::vector<std::string> requirementValues;
 	int requirementsHeight = 0;
+	
+	// The outfit that the attributes table was filled in for.
+	const Outfit *attributesOutfit = nullptr;
 };
 
 
@@ -50,8 +50,9 @@ namespace {
 OutfitterPanel::OutfitterPanel(PlayerInfo &player)
 	: ShopPanel(player, true)
 {
+	// The outfits are already sorted by name.
 	for(const pair<const string, Outfit> &it : GameData::Outfits())
-		catalog[it.second.Category()].insert(it.first);
+		catalog[it.second.Category()].emplace_back(&it.second);
 	
 	// Add owned licenses
 	const string PREFIX = "license: ";
@@ -60,8 +61,14 @@ OutfitterPanel::OutfitterPanel(PlayerInfo &player)
 		{
 			const string name = it.first.substr(PREFIX.length()) + " License";
 			const Outfit *outfit = GameData::Outfits().Get(name);
-			if(outfit)
-				catalog[outfit->Category()].insert(name);
+			if(!outfit)
+				continue;
+			
+			vector<Item> &items = catalog[outfit->Category()];
+			auto position = lower_bound(items.begin(), items.end(), name,
+				[](const Item &item, const string &key) { return item.outfit->Name() < key; });
+			if(position == items.end() || position->outfit != outfit)
+				items.emplace(position, outfit);
 		}
 	
 	if(player.GetPlanet())
@@ -96,9 +103,9 @@ int OutfitterPanel::DrawPlayerShipInfo(const Point &point)
 
 
 
-bool OutfitterPanel::HasItem(const string &name) const
+bool OutfitterPanel::HasItem(const Item &item) const
 {
-	const Outfit *outfit = GameData::Outfits().Get(name);
+	const Outfit *outfit = item.outfit;
 	if((outfitter.Has(outfit) || player.Stock(outfit) > 0) && showForSale)
 		return true;
 	
@@ -109,7 +116,7 @@ bool OutfitterPanel::HasItem(const string &name) const
 		if(ship->OutfitCount(outfit))
 			return true;
 	
-	if(showForSale && HasLicense(name))
+	if(showForSale && HasLicense(outfit->Name()))
 		return true;
 	
 	return false;
@@ -117,9 +124,9 @@ bool OutfitterPanel::HasItem(const string &name) const
 
 
 
-void OutfitterPanel::DrawItem(const string &name, const Point &point, int scrollY)
+void OutfitterPanel::DrawItem(const Item &item, const Point &point, int scrollY)
 {
-	const Outfit *outfit = GameData::Outfits().Get(name);
+	const Outfit *outfit = item.outfit;
 	zones.emplace_back(point, Point(OUTFIT_SIZE, OUTFIT_SIZE), outfit, scrollY);
 	if(point.Y() + OUTFIT_SIZE / 2 < Screen::Top() || point.Y() - OUTFIT_SIZE / 2 > Screen::Bottom())
 		return;
@@ -129,7 +136,7 @@ void OutfitterPanel::DrawItem(const string &name, const Point &point, int scroll
 	DrawOutfit(*outfit, point, isSelected, isOwned);
 	
 	// Check if this outfit is a "license".
-	bool isLicense = IsLicense(name);
+	bool isLicense = IsLicense(outfit->Name());
 	int mapSize = outfit->Get("map");
 	
 	const Font &font = FontSet::Get(14);
@@ -139,7 +146,7 @@ void OutfitterPanel::DrawItem(const string &name, const Point &point, int scroll
 		int minCount = numeric_limits<int>::max();
 		int maxCount = 0;
 		if(isLicense)
-			minCount = maxCount = player.GetCondition(LicenseName(name));
+			minCount = maxCount = player.GetCondition(LicenseName(outfit->Name()));
 		else if(mapSize)
 			minCount = maxCount = HasMapped(mapSize);
 		else
@@ -18,6 +18,11 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Shader.h"
 #include "Sprite.h"
 
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <tuple>
+
 using namespace std;
 
 namespace {
@@ -32,6 +37,146 @@ namespace {
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// Outlines that do not change from one frame to the next (e.g. the ship
+	// thumbnails in the shops) are drawn once into a texture at the size they
+	// are shown on screen, and copied from there after that. The cached image
+	// is the outline's brightness, which is multiplied by the color when it is
+	// drawn, so the same image serves for any color or rotation.
+	Shader cachedShader;
+	GLint cachedScaleI;
+	GLint cachedTransformI;
+	GLint cachedPositionI;
+	GLint cachedColorI;
+	
+	GLuint cachedVao;
+	GLuint framebuffer = 0;
+	
+	// Outlines bigger than this, in pixels, are always drawn directly.
+	const int MAX_CACHED_SIZE = 1024;
+	// Once the cached outlines take up this much memory, the ones that were
+	// used least recently are dropped to make room for each new one.
+	const size_t MAX_CACHED_BYTES = 32 << 20;
+	
+	// An outline is identified by the sprite, which of its textures it came
+	// from, its frame, and its size in pixels.
+	typedef tuple<const Sprite *, uint32_t, float, int, int> CacheKey;
+	class CacheEntry {
+	public:
+		GLuint texture = 0;
+		size_t bytes = 0;
+		uint64_t lastUsed = 0;
+	};
+	map<CacheKey, CacheEntry> cache;
+	size_t cachedBytes = 0;
+	uint64_t useCount = 0;
+	
+	// Run the Sobel filter over the given sprite texture, mapping the quad with
+	// the given scale, position, and transform.
+	void DrawSobel(uint32_t texture, int frameCount, const GLfloat scale[2], const Point &pos,
+		const Point &size, const Point &unit, float frame, const Color &color)
+	{
+		glUseProgram(shader.Object());
+		glBindVertexArray(vao);
+		
+		glUniform2fv(scaleI, 1, scale);
+		
+		GLfloat off[2] = {
+			static_cast<float>(.5 / size.X()),
+			static_cast<float>(.5 / size.Y())};
+		glUniform2fv(offI, 1, off);
+		
+		glUniform1f(frameI, frame);
+		glUniform1f(frameCountI, frameCount);
+		
+		Point uw = unit * size.X();
+		Point uh = unit * size.Y();
+		GLfloat transform[4] = {
+			static_cast<float>(-uw.Y()),
+			static_cast<float>(uw.X()),
+			static_cast<float>(-uh.X()),
+			static_cast<float>(-uh.Y())
+		};
+		glUniformMatrix2fv(transformI, 1, false, transform);
+		
+		GLfloat position[2] = {
+			static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
+		glUniform2fv(positionI, 1, position);
+		
+		glUniform4fv(colorI, 1, color.Get());
+		
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		
+		glBindVertexArray(0);
+		glUseProgram(0);
+	}
+	
+	// Draw the outline of the given sprite texture into a new texture that is
+	// the given number of pixels in size. The size it is drawn at is also
+	// needed, because that is the scale the filter works on. This returns zero
+	// if offscreen drawing is not possible.
+	GLuint DrawCached(uint32_t texture, int frameCount, const Point &size, float frame, int width, int height)
+	{
+		GLuint cached;
+		glGenTextures(1, &cached);
+		glBindTexture(GL_TEXTURE_2D, cached);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		// The brightness can be more than 1 at sharp edges, and is only clamped
+		// once it is multiplied by the color, so it must be stored as a float.
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width, height, 0, GL_RED, GL_FLOAT, nullptr);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		
+		if(!framebuffer)
+			glGenFramebuffers(1, &framebuffer);
+		GLint previous = 0;
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, cached, 0);
+		if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, previous);
+			glDeleteTextures(1, &cached);
+			return 0;
+		}
+		
+		GLfloat clearColor[4];
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+		glClearColor(0.f, 0.f, 0.f, 0.f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		glViewport(0, 0, width, height);
+		
+		// Fill the whole texture with the sprite, drawn upright. The viewport
+		// is the cached image's size in pixels, so the filter sees the sprite at
+		// the same resolution as it is shown on screen.
+		GLfloat scale[2] = {
+			static_cast<float>(2. / size.X()),
+			static_cast<float>(-2. / size.Y())};
+		DrawSobel(texture, frameCount, scale, Point(), size, Point(0., -1.), frame, Color(1.f, 1.f));
+		
+		glBindFramebuffer(GL_FRAMEBUFFER, previous);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		return cached;
+	}
+	
+	// Drop the outline that was used least recently.
+	void EvictOne()
+	{
+		auto oldest = cache.begin();
+		for(auto it = cache.begin(); it != cache.end(); ++it)
+			if(it->second.lastUsed < oldest->second.lastUsed)
+				oldest = it;
+		glDeleteTextures(1, &oldest->second.texture);
+		cachedBytes -= oldest->second.bytes;
+		cache.erase(oldest);
+	}
 }
 
 
@@ -144,25 +289,96 @@ void OutlineShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	// The cached outlines are drawn with the same vertex shader. Their rows are
+	// stored from the bottom up, so they are flipped vertically.
+	static const char *cachedFragmentCode =
+		"uniform sampler2D tex;\n"
+		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
+		
+		"in vec2 fragTexCoord;\n"
+		
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  finalColor = color * texture(tex, vec2(fragTexCoord.x, 1 - fragTexCoord.y)).r;\n"
+		"}\n";
+	
+	cachedShader = Shader(vertexCode, cachedFragmentCode);
+	cachedScaleI = cachedShader.Uniform("scale");
+	cachedTransformI = cachedShader.Uniform("transform");
+	cachedPositionI = cachedShader.Uniform("position");
+	cachedColorI = cachedShader.Uniform("color");
+	
+	glUseProgram(cachedShader.Object());
+	glUniform1i(cachedShader.Uniform("tex"), 0);
+	glUseProgram(0);
+	
+	glGenVertexArrays(1, &cachedVao);
+	glBindVertexArray(cachedVao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	
+	glEnableVertexAttribArray(cachedShader.Attrib("vert"));
+	glVertexAttribPointer(cachedShader.Attrib("vert"), 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), nullptr);
+	
+	glEnableVertexAttribArray(cachedShader.Attrib("vertTexCoord"));
+	glVertexAttribPointer(cachedShader.Attrib("vertTexCoord"), 2, GL_FLOAT, GL_TRUE,
+		4 * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
 }
 
 
 
 void OutlineShader::Draw(const Sprite *sprite, const Point &pos, const Point &size, const Color &color, const Point &unit, float frame)
 {
-	glUseProgram(shader.Object());
-	glBindVertexArray(vao);
+	// Don't draw anything if the sprite's texture is not loaded yet.
+	uint32_t texture = sprite->Texture(unit.Length() * Screen::Zoom() > 50.);
+	if(!texture)
+		return;
 	
 	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
-	glUniform2fv(scaleI, 1, scale);
 	
-	GLfloat off[2] = {
-		static_cast<float>(.5 / size.X()),
-		static_cast<float>(.5 / size.Y())};
-	glUniform2fv(offI, 1, off);
+	// Find out how big the outline is in pixels. Outlines that are between two
+	// animation frames change every time they are drawn, so they are not worth
+	// caching.
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	double pixels = unit.Length() * viewport[2] / Screen::Width();
+	int width = lround(size.X() * pixels);
+	int height = lround(size.Y() * pixels);
+	bool isCacheable = (frame == floor(frame) && width > 0 && height > 0
+		&& width <= MAX_CACHED_SIZE && height <= MAX_CACHED_SIZE);
+	if(!isCacheable)
+	{
+		DrawSobel(texture, sprite->Frames(), scale, pos, size, unit, frame, color);
+		return;
+	}
+	
+	const CacheKey key(sprite, texture, frame, width, height);
+	CacheEntry &entry = cache[key];
+	entry.lastUsed = ++useCount;
+	if(!entry.texture)
+	{
+		entry.texture = DrawCached(texture, sprite->Frames(), size, frame, width, height);
+		if(!entry.texture)
+		{
+			cache.erase(key);
+			DrawSobel(texture, sprite->Frames(), scale, pos, size, unit, frame, color);
+			return;
+		}
+		entry.bytes = 2 * width * height;
+		cachedBytes += entry.bytes;
+		// The new entry is the most recently used, so it is never dropped.
+		while(cachedBytes > MAX_CACHED_BYTES && cache.size() > 1)
+			EvictOne();
+	}
+	
+	glUseProgram(cachedShader.Object());
+	glBindVertexArray(cachedVao);
 	
-	glUniform1f(frameI, frame);
-	glUniform1f(frameCountI, sprite->Frames());
+	glUniform2fv(cachedScaleI, 1, scale);
 	
 	Point uw = unit * size.X();
 	Point uh = unit * size.Y();
@@ -172,15 +388,15 @@ void OutlineShader::Draw(const Sprite *sprite, const Point &pos, const Point &si
 		static_cast<float>(-uh.X()),
 		static_cast<float>(-uh.Y())
 	};
-	glUniformMatrix2fv(transformI, 1, false, transform);
+	glUniformMatrix2fv(cachedTransformI, 1, false, transform);
 	
 	GLfloat position[2] = {
 		static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
-	glUniform2fv(positionI, 1, position);
+	glUniform2fv(cachedPositionI, 1, position);
 	
-	glUniform4fv(colorI, 1, color.Get());
+	glUniform4fv(cachedColorI, 1, color.Get());
 	
-	glBindTexture(GL_TEXTURE_2D_ARRAY, sprite->Texture(unit.Length() * Screen::Zoom() > 50.));
+	glBindTexture(GL_TEXTURE_2D, entry.texture);
 	
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 	
@@ -21,7 +21,8 @@ class Sprite;
 
 
 // Functions for drawing the "outline" of a sprite, i.e. a Sobel filter of its
-// alpha channel.
+// alpha channel. Each outline is filtered once for a given sprite, frame, and
+// size on screen, and after that is copied from a cached texture.
 class OutlineShader {
 public:
 	static void Init();
@@ -48,7 +48,7 @@ void Panel::Draw()
 
 
 // Return true if this is a full-screen panel, so there is no point in
-// drawing any of the panels under it.
+// drawing or stepping any of the panels under it.
 bool Panel::IsFullScreen()
 {
 	return isFullScreen;
@@ -56,6 +56,15 @@ bool Panel::IsFullScreen()
 
 
 
+// Return true if this panel must be stepped even when a full-screen panel is
+// hiding it. By default, hidden panels are not stepped.
+bool Panel::StepsWhenHidden() const
+{
+	return stepsWhenHidden;
+}
+
+
+
 // Return true if, when this panel is on the stack, no events should be
 // passed to any panel under it. By default, all panels do this.
 bool Panel::TrapAllEvents()
@@ -174,6 +183,13 @@ void Panel::SetIsFullScreen(bool set)
 
 
 
+void Panel::SetStepsWhenHidden(bool set)
+{
+	stepsWhenHidden = set;
+}
+
+
+
 void Panel::SetTrapAllEvents(bool set)
 {
 	trapAllEvents = set;
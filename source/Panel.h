@@ -44,8 +44,11 @@ public:
 	virtual void Draw();
 	
 	// Return true if this is a full-screen panel, so there is no point in
-	// drawing any of the panels under it.
+	// drawing or stepping any of the panels under it.
 	bool IsFullScreen();
+	// Return true if this panel must be stepped even when a full-screen panel
+	// is hiding it. By default, hidden panels are not stepped.
+	bool StepsWhenHidden() const;
 	// Return true if, when this panel is on the stack, no events should be
 	// passed to any panel under it. By default, all panels do this.
 	bool TrapAllEvents();
@@ -76,6 +79,7 @@ protected:
 	virtual void EndEditing() {}
 	
 	void SetIsFullScreen(bool set);
+	void SetStepsWhenHidden(bool set);
 	void SetTrapAllEvents(bool set);
 	void SetInterruptible(bool set);
 	
@@ -118,6 +122,7 @@ private:
 	UI *ui = nullptr;
 	
 	bool isFullScreen = false;
+	bool stepsWhenHidden = false;
 	bool trapAllEvents = true;
 	bool isInterruptible = true;
 	
@@ -0,0 +1,251 @@
+/* ParticleShader.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ParticleShader.h"
+
+#include "GameWindow.h"
+#include "Point.h"
+#include "Screen.h"
+#include "Shader.h"
+
+#include <cstddef>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+	Shader shader;
+	// Uniforms:
+	GLint scaleI;
+	GLint centerI;
+	GLint zoomI;
+	GLint stepI;
+	GLint framesI;
+	GLint useAtlasI;
+	GLint atlasI;
+	// Vertex data:
+	GLint itemPositionI;
+	GLint itemVelocityI;
+	GLint itemRotationI;
+	GLint itemSizeI;
+	GLint itemAnimationI;
+	GLint itemTimeI;
+	
+	GLuint vao;
+	GLuint vbo;
+}
+
+
+
+void ParticleShader::Init()
+{
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	// Each particle moves in a straight line and spins at a constant rate, so
+	// its position and angle follow directly from its age. Particles that have
+	// not been created yet or that have expired are collapsed into a single
+	// point outside the view, so nothing is drawn for them.
+	static const char *vertexCode =
+		"uniform vec2 scale;\n"
+		"uniform vec2 center;\n"
+		"uniform float zoom;\n"
+		"uniform int step;\n"
+		"uniform int frames;\n"
+		"uniform int useAtlas;\n"
+		// This must be at least MAX_FRAMES long.
+		"uniform vec4 atlas[64];\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 itemPosition;\n"
+		"in vec2 itemVelocity;\n"
+		"in vec2 itemRotation;\n"
+		"in vec2 itemSize;\n"
+		"in vec4 itemAnimation;\n"
+		"in ivec2 itemTime;\n"
+		
+		"out vec3 fragTexCoord;\n"
+		"out vec3 fragNextTexCoord;\n"
+		"out float fragFade;\n"
+		
+		"vec3 texCoord(int frame) {\n"
+		"  if(useAtlas == 0)\n"
+		"    return vec3(vert, frame);\n"
+		"  vec4 rect = atlas[frame];\n"
+		"  return vec3(rect.xy + vert * (rect.zw - rect.xy), 0);\n"
+		"}\n"
+		
+		"void main() {\n"
+		"  int age = step - itemTime.x;\n"
+		"  if(age < 0 || age > itemTime.y) {\n"
+		"    gl_Position = vec4(0, 0, 2, 1);\n"
+		"    fragTexCoord = vec3(0);\n"
+		"    fragNextTexCoord = vec3(0);\n"
+		"    fragFade = 0;\n"
+		"    return;\n"
+		"  }\n"
+		
+		"  vec2 position = (itemPosition + itemVelocity * float(age) - center) * zoom;\n"
+		"  float angle = itemRotation.x + itemRotation.y * float(age);\n"
+		"  vec2 unit = vec2(sin(angle), -cos(angle)) * zoom;\n"
+		"  vec2 uw = vec2(unit.y, -unit.x) * itemSize.x;\n"
+		"  vec2 uh = unit * itemSize.y;\n"
+		"  gl_Position = vec4((position + uw * (2 * vert.x - 1) + uh * (1 - 2 * vert.y)) * scale, 0, 1);\n"
+		
+		// This is the same calculation that Body::SetStep() does.
+		"  float frame = 0;\n"
+		"  if(frames > 1) {\n"
+		"    float count = float(frames);\n"
+		"    float lastFrame = count - 1;\n"
+		"    bool repeat = mod(itemAnimation.w, 2) >= 1;\n"
+		"    bool rewind = itemAnimation.w >= 2;\n"
+		"    float cycle = (rewind ? 2 * lastFrame : count) + itemAnimation.z;\n"
+		"    frame = max(0, itemAnimation.x * float(step) + itemAnimation.y);\n"
+		"    if(repeat)\n"
+		"      frame = mod(frame, cycle);\n"
+		"    if(!rewind) {\n"
+		"      if(!repeat)\n"
+		"        frame = min(frame, lastFrame);\n"
+		"      else if(frame >= count)\n"
+		"        frame = 0;\n"
+		"    }\n"
+		"    else if(frame >= lastFrame)\n"
+		"      frame = max(0, lastFrame * 2 - frame);\n"
+		"  }\n"
+		"  float first = floor(frame);\n"
+		"  fragFade = frame - first;\n"
+		"  fragTexCoord = texCoord(int(first) % max(1, frames));\n"
+		"  fragNextTexCoord = texCoord(int(ceil(frame)) % max(1, frames));\n"
+		"}\n";
+	
+	// This is the same as the BatchShader's fragment shader.
+	static const char *fragmentCode =
+		"uniform sampler2DArray tex;\n"
+		
+		"in vec3 fragTexCoord;\n"
+		"in vec3 fragNextTexCoord;\n"
+		"in float fragFade;\n"
+		
+		"out vec4 finalColor;\n"
+		
+		"void main() {\n"
+		"  finalColor = mix(\n"
+		"    texture(tex, fragTexCoord),\n"
+		"    texture(tex, fragNextTexCoord), fragFade);\n"
+		"}\n";
+	
+	shader = Shader(vertexCode, fragmentCode);
+	scaleI = shader.Uniform("scale");
+	centerI = shader.Uniform("center");
+	zoomI = shader.Uniform("zoom");
+	stepI = shader.Uniform("step");
+	framesI = shader.Uniform("frames");
+	useAtlasI = shader.Uniform("useAtlas");
+	atlasI = shader.Uniform("atlas");
+	itemPositionI = shader.Attrib("itemPosition");
+	itemVelocityI = shader.Attrib("itemVelocity");
+	itemRotationI = shader.Attrib("itemRotation");
+	itemSizeI = shader.Attrib("itemSize");
+	itemAnimationI = shader.Attrib("itemAnimation");
+	itemTimeI = shader.Attrib("itemTime");
+	
+	// Make sure we're using texture 0.
+	glUseProgram(shader.Object());
+	glUniform1i(shader.Uniform("tex"), 0);
+	glUseProgram(0);
+	
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	
+	// The corners of the quad, in the order a triangle strip needs them. They
+	// double as the texture coordinates of each corner.
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	
+	GLfloat vertexData[] = {
+		0.f, 1.f,
+		1.f, 1.f,
+		0.f, 0.f,
+		1.f, 0.f
+	};
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData, GL_STATIC_DRAW);
+	
+	GLint vertI = shader.Attrib("vert");
+	glEnableVertexAttribArray(vertI);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	
+	// Everything else comes from each sprite's particle buffer, once per
+	// particle. Where in that buffer is not known until it is drawn.
+	for(GLint attrib : {itemPositionI, itemVelocityI, itemRotationI, itemSizeI, itemAnimationI, itemTimeI})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+
+// Set up the view for drawing the given step.
+void ParticleShader::Bind(int step, const Point &center, double zoom)
+{
+	if(!shader.Object())
+		throw runtime_error("ParticleShader: Bind() called before Init().");
+	
+	glUseProgram(shader.Object());
+	glBindVertexArray(vao);
+	
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	glUniform2fv(scaleI, 1, scale);
+	GLfloat position[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
+	glUniform2fv(centerI, 1, position);
+	glUniform1f(zoomI, zoom);
+	glUniform1i(stepI, step);
+}
+
+
+
+// Draw count particles from the given buffer, starting at the given index.
+void ParticleShader::Add(uint32_t texture, int frames, const float *atlas, uint32_t buffer, size_t first, size_t count)
+{
+	if(!count || !texture)
+		return;
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glUniform1i(framesI, frames);
+	glUniform1i(useAtlasI, atlas != nullptr);
+	if(atlas)
+		glUniform4fv(atlasI, frames, atlas);
+	
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	const char *base = reinterpret_cast<const char *>(first * sizeof(Item));
+	const GLsizei stride = sizeof(Item);
+	glVertexAttribPointer(itemPositionI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, position));
+	glVertexAttribPointer(itemVelocityI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, velocity));
+	glVertexAttribPointer(itemRotationI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, angle));
+	glVertexAttribPointer(itemSizeI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, size));
+	glVertexAttribPointer(itemAnimationI, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, animation));
+	glVertexAttribIPointer(itemTimeI, 2, GL_INT, stride, base + offsetof(Item, spawn));
+	
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+}
+
+
+
+void ParticleShader::Unbind()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+}
@@ -0,0 +1,67 @@
+/* ParticleShader.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PARTICLE_SHADER_H_
+#define PARTICLE_SHADER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+class Point;
+
+
+
+// Class for drawing effect sprites whose motion and animation are computed by
+// the graphics card. Each particle is uploaded once, when it is created, with
+// the step it was created on and how long it lasts, and from then on the shader
+// works out where it is and which frame it is on from the current step, the way
+// a Visual's Move() and Body::GetFrame() would. This is only available if the
+// graphics card supports instancing.
+class ParticleShader {
+public:
+	// Animations with more frames than this can only be drawn this way if the
+	// sprite is not in the atlas, because each frame's atlas coordinates must
+	// be passed to the shader.
+	static const int MAX_FRAMES = 64;
+	
+	// The parameters of one particle, in the layout the shader reads them in.
+	// The angles are in radians, and the sizes are half the sprite's width and
+	// height after applying the body's zoom.
+	class Item {
+	public:
+		float position[2];
+		float velocity[2];
+		float angle;
+		float spin;
+		float size[2];
+		// Frame rate, frame offset, delay, and flags (1 = repeat, 2 = rewind).
+		float animation[4];
+		int32_t spawn;
+		int32_t lifetime;
+	};
+	
+	
+public:
+	static void Init();
+	
+	// Set up the view for drawing the given step.
+	static void Bind(int step, const Point &center, double zoom);
+	// Draw count particles from the given buffer, starting at the given index.
+	// If the sprite is in the atlas, its coordinates for each frame must be
+	// given; otherwise, each frame is a layer of the texture.
+	static void Add(uint32_t texture, int frames, const float *atlas, uint32_t buffer, std::size_t first, std::size_t count);
+	static void Unbind();
+};
+
+
+
+#endif
@@ -0,0 +1,236 @@
+/* ParticleSystem.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ParticleSystem.h"
+
+#include "BatchDrawList.h"
+#include "GameWindow.h"
+#include "pi.h"
+#include "Sprite.h"
+#include "Visual.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+	// The smallest buffer to allocate for any one sprite's particles.
+	const size_t MIN_CAPACITY = 256;
+	
+	bool IsAlive(const ParticleShader::Item &item, int step)
+	{
+		return item.spawn + item.lifetime >= step;
+	}
+}
+
+
+
+ParticleSystem::~ParticleSystem()
+{
+	for(const auto &it : rings)
+		if(it.second.buffer)
+			glDeleteBuffers(1, &it.second.buffer);
+}
+
+
+
+// Take all the visuals that can be drawn as particles out of the given list.
+void ParticleSystem::Add(vector<Visual> &visuals, int step)
+{
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	lock_guard<mutex> lock(addMutex);
+	auto it = remove_if(visuals.begin(), visuals.end(), [this, step](const Visual &visual)
+	{
+		// Visuals that are not drawn at all are left alone, as are any whose
+		// atlas coordinates would not all fit in the shader.
+		if(!visual.HasSprite() || !visual.Zoom())
+			return false;
+		const Sprite *sprite = visual.GetSprite();
+		if(sprite->Frames() > ParticleShader::MAX_FRAMES)
+			return false;
+		
+		// Getting the frame fills in the random or zero starting frame, if the
+		// animation has one, so that the offset is final.
+		visual.GetFrame(step);
+		
+		ParticleShader::Item item;
+		item.position[0] = visual.Position().X();
+		item.position[1] = visual.Position().Y();
+		item.velocity[0] = visual.Velocity().X();
+		item.velocity[1] = visual.Velocity().Y();
+		item.angle = visual.Facing().Degrees() * TO_RAD;
+		item.spin = visual.spin.Degrees() * TO_RAD;
+		item.size[0] = .5 * visual.Zoom() * visual.Width();
+		item.size[1] = .5 * visual.Zoom() * visual.Height();
+		// A paused animation is the same as one that started that much later.
+		item.animation[0] = visual.frameRate;
+		item.animation[1] = visual.frameOffset - visual.frameRate * visual.pause;
+		item.animation[2] = visual.delay;
+		item.animation[3] = visual.repeat + 2 * visual.rewind;
+		item.spawn = step;
+		item.lifetime = visual.lifetime;
+		
+		pending[sprite].push_back(item);
+		return true;
+	});
+	visuals.erase(it, visuals.end());
+}
+
+
+
+// Remove all the particles, e.g. when entering a new system.
+void ParticleSystem::Clear()
+{
+	lock_guard<mutex> lock(addMutex);
+	pending.clear();
+	shouldClear = true;
+}
+
+
+
+// Draw all the particles that are alive as of the given list's step.
+void ParticleSystem::Draw(const BatchDrawList &view)
+{
+	// The calculation thread may already be adding the particles for the next
+	// step, so only take the ones that have been created as of this step. Each
+	// sprite's pending particles are in the order they were added, so those are
+	// at the start of its list.
+	const int step = view.Step();
+	map<const Sprite *, vector<ParticleShader::Item>> added;
+	bool isCleared = false;
+	{
+		lock_guard<mutex> lock(addMutex);
+		swap(isCleared, shouldClear);
+		for(auto it = pending.begin(); it != pending.end(); )
+		{
+			vector<ParticleShader::Item> &items = it->second;
+			auto later = find_if(items.begin(), items.end(), [step](const ParticleShader::Item &item)
+			{
+				return item.spawn > step;
+			});
+			if(later == items.end())
+			{
+				added[it->first].swap(items);
+				it = pending.erase(it);
+				continue;
+			}
+			if(later != items.begin())
+			{
+				added[it->first].assign(items.begin(), later);
+				items.erase(items.begin(), later);
+			}
+			++it;
+		}
+	}
+	
+	if(isCleared)
+		for(auto &it : rings)
+			it.second.begin = it.second.size = 0;
+	
+	for(const auto &it : added)
+		Push(rings[it.first], it.second, step);
+	
+	bool isBound = false;
+	for(auto &it : rings)
+	{
+		// Drop any particles that have expired from the oldest end of the ring.
+		// Particles that expire sooner than some older ones are hidden by the
+		// shader until they reach that end.
+		Ring &ring = it.second;
+		const size_t capacity = ring.items.size();
+		while(ring.size && !IsAlive(ring.items[ring.begin], step))
+		{
+			ring.begin = (ring.begin + 1) % capacity;
+			--ring.size;
+		}
+		if(!ring.size)
+			continue;
+		
+		// Skip sprites that are still being streamed in.
+		const Sprite *sprite = it.first;
+		const float *atlas = nullptr;
+		uint32_t texture = sprite->AtlasTexture(view.IsHighDPI());
+		if(texture)
+			atlas = sprite->AtlasCoordinates(view.IsHighDPI());
+		else
+			texture = sprite->Texture(view.IsHighDPI());
+		if(!texture)
+			continue;
+		
+		if(!isBound)
+		{
+			ParticleShader::Bind(step, view.Center(), view.Zoom());
+			isBound = true;
+		}
+		// If the ring wraps around, it takes two calls to draw.
+		size_t first = min(ring.size, capacity - ring.begin);
+		ParticleShader::Add(texture, sprite->Frames(), atlas, ring.buffer, ring.begin, first);
+		ParticleShader::Add(texture, sprite->Frames(), atlas, ring.buffer, 0, ring.size - first);
+	}
+	if(isBound)
+		ParticleShader::Unbind();
+}
+
+
+
+// Add the given particles to the given ring, uploading only those.
+void ParticleSystem::Push(Ring &ring, const vector<ParticleShader::Item> &added, int step)
+{
+	size_t capacity = ring.items.size();
+	if(ring.size + added.size() > capacity)
+	{
+		// The ring is full, so copy whichever particles are still alive into a
+		// bigger one, along with the new ones, and upload all of them.
+		vector<ParticleShader::Item> items;
+		items.reserve(ring.size + added.size());
+		for(size_t i = 0; i < ring.size; ++i)
+		{
+			const ParticleShader::Item &item = ring.items[(ring.begin + i) % capacity];
+			if(IsAlive(item, step))
+				items.push_back(item);
+		}
+		items.insert(items.end(), added.begin(), added.end());
+		
+		capacity = max(MIN_CAPACITY, capacity);
+		while(capacity < items.size())
+			capacity *= 2;
+		ring.begin = 0;
+		ring.size = items.size();
+		items.resize(capacity);
+		ring.items.swap(items);
+		
+		if(!ring.buffer)
+			glGenBuffers(1, &ring.buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(ParticleShader::Item) * capacity, ring.items.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return;
+	}
+	
+	// Otherwise, the new particles go right after the newest ones, which may
+	// mean wrapping around to the start of the buffer.
+	size_t end = (ring.begin + ring.size) % capacity;
+	size_t first = min(added.size(), capacity - end);
+	copy(added.begin(), added.begin() + first, ring.items.begin() + end);
+	copy(added.begin() + first, added.end(), ring.items.begin());
+	ring.size += added.size();
+	
+	glBindBuffer(GL_ARRAY_BUFFER, ring.buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(ParticleShader::Item) * end,
+		sizeof(ParticleShader::Item) * first, &ring.items[end]);
+	if(first < added.size())
+		glBufferSubData(GL_ARRAY_BUFFER, 0,
+			sizeof(ParticleShader::Item) * (added.size() - first), ring.items.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
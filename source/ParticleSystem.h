@@ -0,0 +1,88 @@
+/* ParticleSystem.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PARTICLE_SYSTEM_H_
+#define PARTICLE_SYSTEM_H_
+
+#include "ParticleShader.h"
+
+#include "gl_header.h"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class BatchDrawList;
+class Sprite;
+class Visual;
+
+
+
+// Class that takes over the visuals whose whole life can be worked out ahead of
+// time, so that instead of the engine moving each of them and building their
+// vertices every step, each one is sent to the graphics card once and drawn by
+// the ParticleShader until it expires. Visuals are handed over by the thread
+// that calculates each step, and drawn by the main thread, so those two may run
+// at the same time. If the graphics card does not support instancing, every
+// visual is left for the engine to handle as usual.
+class ParticleSystem {
+public:
+	ParticleSystem() = default;
+	~ParticleSystem();
+	
+	ParticleSystem(const ParticleSystem &) = delete;
+	ParticleSystem &operator=(const ParticleSystem &) = delete;
+	
+	// Take all the visuals that can be drawn as particles out of the given
+	// list. They were created on or before the given step, and that is the
+	// step they are in now.
+	void Add(std::vector<Visual> &visuals, int step);
+	// Remove all the particles, e.g. when entering a new system.
+	void Clear();
+	
+	// Draw all the particles that are alive as of the given list's step, with
+	// the same view as that list.
+	void Draw(const BatchDrawList &view);
+	
+	
+private:
+	// Each sprite's particles are kept in a ring buffer, in the order in which
+	// they were created. A copy stays in memory so that the buffer can be
+	// reallocated when it fills up.
+	class Ring {
+	public:
+		std::vector<ParticleShader::Item> items;
+		std::size_t begin = 0;
+		std::size_t size = 0;
+		GLuint buffer = 0;
+	};
+	
+	
+private:
+	// Add the given particles to the given ring, uploading only those.
+	static void Push(Ring &ring, const std::vector<ParticleShader::Item> &added, int step);
+	
+	
+private:
+	std::map<const Sprite *, Ring> rings;
+	
+	// Particles that have been added but not yet uploaded. Any that were created
+	// after the step being drawn stay here until that step is drawn.
+	std::mutex addMutex;
+	std::map<const Sprite *, std::vector<ParticleShader::Item>> pending;
+	bool shouldClear = false;
+};
+
+
+
+#endif
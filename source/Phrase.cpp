@@ -56,23 +56,42 @@ const string &Phrase::Name() const
 string Phrase::Get() const
 {
 	string result;
+	Append(result);
+	return result;
+}
+
+
+
+// Add a random sentence's text to the end of the given string.
+void Phrase::Append(string &result) const
+{
 	if(sentences.empty())
-		return result;
+		return;
 	
+	// Replacements only apply to the text of this sentence, not to whatever
+	// was in the string before it.
+	const size_t start = result.length();
 	for(const auto &part : sentences[Random::Int(sentences.size())])
 	{
 		if(!part.choices.empty())
 		{
 			const auto &choice = part.choices[Random::Int(part.choices.size())];
 			for(const auto &element : choice)
-				result += element.second ? element.second->Get() : element.first;
+			{
+				if(element.second)
+					element.second->Append(result);
+				else
+					result += element.first;
+			}
 		}
 		else if(!part.replacements.empty())
+		{
+			string text(result, start);
 			for(const auto &pair : part.replacements)
-				Format::ReplaceAll(result, pair.first, pair.second);
+				Format::ReplaceAll(text, pair.first, pair.second);
+			result.replace(start, string::npos, text);
+		}
 	}
-	
-	return result;
 }
 
 
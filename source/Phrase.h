@@ -33,6 +33,9 @@ public:
 	
 	
 private:
+	// Add a random sentence's text to the end of the given string, so that the
+	// text of nested phrases can all be built in the same string.
+	void Append(std::string &result) const;
 	bool ReferencesPhrase(const Phrase *phrase) const;
 	
 	
@@ -54,6 +54,8 @@ void Planet::Load(const DataNode &node)
 	if(node.Size() < 2)
 		return;
 	name = node.Token(1);
+	shipyardRevision = -1;
+	outfitterRevision = -1;
 	
 	// If this planet has been loaded before, these sets of items should be
 	// reset instead of appending to them:
@@ -331,9 +333,14 @@ bool Planet::HasShipyard() const
 // Get the list of ships in the shipyard.
 const Sale<Ship> &Planet::Shipyard() const
 {
-	shipyard.clear();
-	for(const Sale<Ship> *sale : shipSales)
-		shipyard.Add(*sale);
+	int revision = GameData::Revision();
+	if(shipyardRevision != revision)
+	{
+		shipyard.clear();
+		for(const Sale<Ship> *sale : shipSales)
+			shipyard.Add(*sale);
+		shipyardRevision = revision;
+	}
 	
 	return shipyard;
 }
@@ -351,9 +358,14 @@ bool Planet::HasOutfitter() const
 // Get the list of outfits available from the outfitter.
 const Sale<Outfit> &Planet::Outfitter() const
 {
-	outfitter.clear();
-	for(const Sale<Outfit> *sale : outfitSales)
-		outfitter.Add(*sale);
+	int revision = GameData::Revision();
+	if(outfitterRevision != revision)
+	{
+		outfitter.clear();
+		for(const Sale<Outfit> *sale : outfitSales)
+			outfitter.Add(*sale);
+		outfitterRevision = revision;
+	}
 	
 	return outfitter;
 }
@@ -141,9 +141,12 @@ private:
 	std::set<const Sale<Ship> *> shipSales;
 	std::set<const Sale<Outfit> *> outfitSales;
 	// The lists above will be converted into actual ship lists when they are
-	// first asked for:
+	// first asked for, and again only if this planet or the game data has been
+	// changed since then (which may change the contents of the sales).
 	mutable Sale<Ship> shipyard;
 	mutable Sale<Outfit> outfitter;
+	mutable int shipyardRevision = -1;
+	mutable int outfitterRevision = -1;
 	
 	const Government *government = nullptr;
 	double requiredReputation = 0.;
@@ -36,11 +36,40 @@ namespace {
 	const double LINE_GAP = 1.7;
 	const double GAP = 6.;
 	const double MIN_DISTANCE = 30.;
+	// How far an object may move before the labels must be placed again.
+	const double MAX_DRIFT = 4.;
 }
 
 
 
-PlanetLabel::PlanetLabel(const Point &position, const StellarObject &object, const System *system, double zoom)
+// Forget the placements unless they were found for this system and zoom, and
+// none of the system's objects has moved far since then.
+void PlanetLabel::Placements::Update(const System *system, double zoom)
+{
+	bool isCurrent = (system == this->system && zoom == this->zoom);
+	if(isCurrent && system)
+	{
+		const vector<StellarObject> &objects = system->Objects();
+		isCurrent = (objects.size() == positions.size());
+		for(size_t i = 0; isCurrent && i < objects.size(); ++i)
+			isCurrent = (objects[i].Position().Distance(positions[i]) < MAX_DRIFT);
+	}
+	if(isCurrent)
+		return;
+	
+	this->system = system;
+	this->zoom = zoom;
+	directions.clear();
+	positions.clear();
+	if(system)
+		for(const StellarObject &object : system->Objects())
+			positions.push_back(object.Position());
+}
+
+
+
+PlanetLabel::PlanetLabel(const Point &position, const StellarObject &object, const System *system, double zoom,
+		Placements &placements)
 	: position(position * zoom), radius(object.Radius() * zoom)
 {
 	const Planet &planet = *object.GetPlanet();
@@ -66,6 +95,13 @@ PlanetLabel::PlanetLabel(const Point &position, const StellarObject &object, con
 	if(!system)
 		return;
 	
+	auto it = placements.directions.find(&object);
+	if(it != placements.directions.end())
+	{
+		direction = it->second;
+		return;
+	}
+	
 	// Figure out how big the label has to be.
 	double width = max(FontSet::Get(18).Width(name), FontSet::Get(14).Width(government)) + 8.;
 	for(int d = 0; d < 4; ++d)
@@ -102,6 +138,7 @@ PlanetLabel::PlanetLabel(const Point &position, const StellarObject &object, con
 			break;
 		}
 	}
+	placements.directions[&object] = direction;
 }
 
 
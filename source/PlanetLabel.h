@@ -16,7 +16,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Color.h"
 #include "Point.h"
 
+#include <map>
 #include <string>
+#include <vector>
 
 class StellarObject;
 class System;
@@ -25,7 +27,30 @@ class System;
 
 class PlanetLabel {
 public:
-	PlanetLabel(const Point &position, const StellarObject &object, const System *system, double zoom);
+	// The direction of the label for each object in a system. Placing
+	// a label means checking it against every other object, so the placements
+	// are kept until the zoom changes or some object moves far enough that they
+	// may no longer be right.
+	class Placements {
+	public:
+		// Forget the placements unless they were found for this system and
+		// zoom, and none of the system's objects has moved far since then.
+		void Update(const System *system, double zoom);
+		
+	private:
+		friend class PlanetLabel;
+		
+		const System *system = nullptr;
+		double zoom = 0.;
+		// Where each of the system's objects was when the placements were found.
+		std::vector<Point> positions;
+		std::map<const StellarObject *, int> directions;
+	};
+	
+	
+public:
+	PlanetLabel(const Point &position, const StellarObject &object, const System *system, double zoom,
+		Placements &placements);
 	
 	void Draw() const;
 	
@@ -30,28 +30,197 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Politics.h"
 #include "Preferences.h"
 #include "Random.h"
-#include "SavedGame.h"
 #include "Ship.h"
 #include "ShipEvent.h"
 #include "StartConditions.h"
 #include "StellarObject.h"
 #include "System.h"
+#include "Telemetry.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "UI.h"
+#include "WorkerPool.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <ctime>
 #include <sstream>
+#include <thread>
+#include <utility>
 
 using namespace std;
 
+namespace {
+	// Saved games are written to disk by a background thread, so that a large
+	// save file does not make the game hitch every time you land. The thread
+	// is joined before the next save begins, so saves are never interleaved.
+	class SaveThread {
+	public:
+		~SaveThread() { Wait(); }
+		void Wait() { if(thread.joinable()) thread.join(); }
+		
+		std::thread thread;
+	};
+	SaveThread saveThread;
+	
+	// The most recently saved game is read and parsed in the background while
+	// the game data is loading, so that LoadRecent() only has to wait for it
+	// to be done and then apply what it read, unless the file has been changed
+	// since then.
+	class RecentThread {
+	public:
+		~RecentThread() { Wait(); }
+		void Wait() { if(thread.joinable()) thread.join(); }
+		
+		std::thread thread;
+		string path;
+		time_t timestamp = 0;
+		DataFile file;
+	};
+	RecentThread recentThread;
+	
+	// Get the path to the most recently saved game, or an empty string if it
+	// does not exist.
+	string RecentPath()
+	{
+		string path = Files::Read(Files::Config() + "recent.txt");
+		// Trim trailing whitespace (including newlines) from the path.
+		while(!path.empty() && path.back() <= ' ')
+			path.pop_back();
+		
+		if(path.empty() || !Files::Exists(path))
+			return string();
+		return path;
+	}
+	
+	// The missions that a planet offers are instantiated in parallel by these
+	// threads, which are only started the first time the player lands. Each one
+	// draws its random numbers from a stream with this purpose.
+	const uint64_t MISSION_STREAM = 8;
+	WorkerPool &MissionWorkers()
+	{
+		static WorkerPool workers;
+		return workers;
+	}
+	
+	
+	
+	// Get the date stored in the given saved game file.
+	Date SavedDate(const string &path)
+	{
+		DataFile file(path);
+		for(const DataNode &node : file)
+			if(node.Token(0) == "date" && node.Size() >= 4)
+				return Date(node.Value(1), node.Value(2), node.Value(3));
+		return Date();
+	}
+	
+	
+	
+	// Write the given contents to the given path. This runs in the save thread,
+	// so it must not touch the player or any of the game data. If this is the
+	// player's main save file, remember that it was the most recent save, and
+	// if the date has changed, rotate the existing save into the backups.
+	void WriteSave(const string &path, const string &contents, const Date &date, bool isMainSave, bool compress)
+	{
+		Threads::Scope threadScope("save", Threads::Priority::LOW);
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		
+		// Write to a temporary file first, and then move it into place, so that
+		// if writing fails partway through the existing save is not lost.
+		string temp = Files::Config() + "save.tmp";
+		bool success = false;
+		if(compress)
+			success = Files::WriteCompressed(temp, contents);
+		else
+		{
+			Files::Write(temp, contents);
+			success = (Files::Size(temp) == static_cast<long long>(contents.size()));
+		}
+		if(!success)
+		{
+			Files::LogError("Error: unable to write \"" + path + "\".");
+			Files::Delete(temp);
+			return;
+		}
+		
+		if(isMainSave)
+		{
+			Files::Write(Files::Config() + "recent.txt", path + '\n');
+			
+			// Only update the backups if this save will have a newer date. The
+			// backups are rarely loaded, so they are stored compressed; each of
+			// them is still a complete saved game, so that any of them can be
+			// recovered even if the others are lost.
+			if(path.rfind(".txt") == path.length() - 4 && SavedDate(path) != date)
+			{
+				string root = path.substr(0, path.length() - 4);
+				string files[4] = {
+					root + "~~previous-3.txt",
+					root + "~~previous-2.txt",
+					root + "~~previous-1.txt",
+					path
+				};
+				for(int i = 0; i < 2; ++i)
+					if(Files::Exists(files[i + 1]))
+						Files::Move(files[i + 1], files[i]);
+				if(Files::Exists(path) && !Files::CopyCompressed(path, files[2]))
+					Files::Move(path, files[2]);
+			}
+		}
+		Files::Move(temp, path);
+		
+		if(Telemetry::IsOpen())
+		{
+			Telemetry::Timing("save.write", chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+			Telemetry::Gauge("save.bytes", contents.size());
+			Telemetry::Flush();
+		}
+	}
+	
+	
+	
+	// Hand a snapshot of a saved game off to the save thread.
+	void StartSave(const string &path, const string &contents, const Date &date, bool isMainSave)
+	{
+		// The preferences can only be checked from the main thread.
+		bool compress = Preferences::Has("Compress saved games");
+		saveThread.Wait();
+		saveThread.thread = thread(WriteSave, path, contents, date, isMainSave, compress);
+	}
+	
+	
+	
+	// Check whether the given system's bit is set in a list indexed by
+	// System::Index(). Any system past the end of the list is not set.
+	bool IsSet(const vector<bool> &bits, const System *system)
+	{
+		return system->Index() < bits.size() && bits[system->Index()];
+	}
+	
+	
+	
+	// Set or clear the given system's bit. Systems may be added after the list
+	// was last resized, so it grows to fit them.
+	void SetBit(vector<bool> &bits, const System *system, bool value)
+	{
+		if(system->Index() >= bits.size())
+			bits.resize(max(System::Count(), system->Index() + 1), false);
+		bits[system->Index()] = value;
+	}
+}
+
 
 
 // Completely clear all loaded information, to prepare for loading a file or
 // creating a new pilot.
 void PlayerInfo::Clear()
 {
+	// The map revision must never go back to a value it has had before.
+	int revision = mapRevision + 1;
 	*this = PlayerInfo();
+	mapRevision = revision;
 	
 	Random::Seed(time(nullptr));
 	GameData::Revert();
@@ -112,15 +281,24 @@ void PlayerInfo::New()
 
 // Load player information from a saved game file.
 void PlayerInfo::Load(const string &path)
+{
+	// Make sure the file is not still being written.
+	FinishSaving();
+	DataFile file(path);
+	Load(path, file);
+}
+
+
+
+// Load player information from a saved game file that has been parsed.
+void PlayerInfo::Load(const string &path, DataFile &file)
 {
 	// Make sure any previously loaded data is cleared.
 	Clear();
 	
 	filePath = path;
-	DataFile file(path);
-	
 	hasFullClearance = false;
-	for(const DataNode &child : file)
+	for(DataNode &child : file)
 	{
 		// Basic player information and persistent UI settings:
 		if(child.Token(0) == "pilot" && child.Size() >= 3)
@@ -201,6 +379,7 @@ void PlayerInfo::Load(const string &path)
 		{
 			missions.emplace_back(child);
 			cargo.AddMissionCargo(&missions.back());
+			isNPCIndexCurrent = false;
 		}
 		else if(child.Token(0) == "available job")
 			availableJobs.emplace_back(child);
@@ -213,13 +392,15 @@ void PlayerInfo::Load(const string &path)
 		}
 		else if(child.Token(0) == "event")
 			gameEvents.emplace_back(child);
+		// The file is discarded once it is loaded, so rather than copying the
+		// changes, which may be a sizable part of it, move them out.
 		else if(child.Token(0) == "changes")
 		{
-			for(const DataNode &grand : child)
-				dataChanges.push_back(grand);
+			for(DataNode &grand : child)
+				dataChanges.push_back(std::move(grand));
 		}
 		else if(child.Token(0) == "economy")
-			economy = child;
+			economy = std::move(child);
 		else if(child.Token(0) == "destroyed" && child.Size() >= 2)
 			destroyedPersons.push_back(child.Token(1));
 		
@@ -240,33 +421,16 @@ void PlayerInfo::Load(const string &path)
 						harvested.insert(item);
 				}
 		}
-		else if(child.Token(0) == "logbook")
+		else if(child.Token(0) == "logbook" && child.HasChildren())
 		{
-			for(const DataNode &grand : child)
-			{
-				if(grand.Size() >= 3)
-				{
-					Date date(grand.Value(0), grand.Value(1), grand.Value(2));
-					string text;
-					for(const DataNode &great : grand)
-					{
-						if(!text.empty())
-							text += "\n\t";
-						text += great.Token(0);
-					}
-					logbook.emplace(date, text);
-				}
-				else if(grand.Size() >= 2)
-				{
-					string &text = specialLogs[grand.Token(0)][grand.Token(1)];
-					for(const DataNode &great : grand)
-					{
-						if(!text.empty())
-							text += "\n\t";
-						text += great.Token(0);
-					}
-				}
-			}
+			// Most of the time the logbook is never looked at, so just keep
+			// its text until it is. That is also the text that will be saved
+			// if no entries are added to it.
+			DataWriter text;
+			text.Write(child);
+			sectionText[LOGBOOK] = text.GetString();
+			isSectionSaved[LOGBOOK] = true;
+			isLogbookRead = false;
 		}
 	}
 	// Based on the ships that were loaded, calculate the player's capacity for
@@ -298,27 +462,63 @@ void PlayerInfo::Load(const string &path)
 	if(!depreciation.IsLoaded())
 		depreciation.Init(ships, date.DaysSinceEpoch());
 	
+	// The events must be sorted by date, so that the ones that are due can be
+	// found at the start of the list. Sorting a list does not change the order
+	// of events that happen on the same day.
+	gameEvents.sort([](const GameEvent &a, const GameEvent &b) { return a.GetDate() < b.GetDate(); });
+	
 	// Modify the game data with any changes that were loaded from this file.
 	ApplyChanges();
 }
 
 
 
+// Start reading the most recently saved player in the background. This only
+// needs the config directory, not the game data, so it can be done while the
+// game data is loading.
+void PlayerInfo::BeginLoadRecent()
+{
+	recentThread.Wait();
+	recentThread.path = RecentPath();
+	if(recentThread.path.empty())
+		return;
+	
+	recentThread.timestamp = Files::Timestamp(recentThread.path);
+	recentThread.thread = thread([]()
+	{
+		Threads::Scope threadScope("save loader", Threads::Priority::NORMAL);
+		recentThread.file.Load(recentThread.path);
+	});
+}
+
+
+
 // Load the most recently saved player (if any). Returns false when no save was loaded.
 bool PlayerInfo::LoadRecent()
 {
-	string recentPath = Files::Read(Files::Config() + "recent.txt");
-	// Trim trailing whitespace (including newlines) from the path.
-	while(!recentPath.empty() && recentPath.back() <= ' ')
-		recentPath.pop_back();
-	
-	if(recentPath.empty() || !Files::Exists(recentPath))
+	FinishSaving();
+	recentThread.Wait();
+	string recentPath = RecentPath();
+	if(recentPath.empty())
 	{
 		Clear();
 		return false;
 	}
 	
-	Load(recentPath);
+	// If this file was already parsed in the background and has not been saved
+	// again since then, use what was read.
+	if(recentPath == recentThread.path && Files::Timestamp(recentPath) == recentThread.timestamp)
+	{
+		DataFile file = std::move(recentThread.file);
+		recentThread.path.clear();
+		Load(recentPath, file);
+	}
+	else
+	{
+		recentThread.path.clear();
+		recentThread.file = DataFile();
+		Load(recentPath);
+	}
 	return true;
 }
 
@@ -331,29 +531,23 @@ void PlayerInfo::Save() const
 	if(!CanBeSaved())
 		return;
 	
-	// Remember that this was the most recently saved player.
-	Files::Write(Files::Config() + "recent.txt", filePath + '\n');
-	
-	if(filePath.rfind(".txt") == filePath.length() - 4)
-	{
-		// Only update the backups if this save will have a newer date.
-		SavedGame saved(filePath);
-		if(saved.GetDate() != date.ToString())
-		{
-			string root = filePath.substr(0, filePath.length() - 4);
-			string files[4] = {
-				root + "~~previous-3.txt",
-				root + "~~previous-2.txt",
-				root + "~~previous-1.txt",
-				filePath
-			};
-			for(int i = 0; i < 3; ++i)
-				if(Files::Exists(files[i + 1]))
-					Files::Move(files[i + 1], files[i]);
-		}
-	}
-		
-	Save(filePath);
+	// Take a snapshot of the player's current state here, and leave writing it
+	// to disk (and updating the backups) to the save thread.
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	DataWriter out;
+	Save(out);
+	if(Telemetry::IsOpen())
+		Telemetry::Timing("save.snapshot", chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+	StartSave(filePath, out.GetString(), date, true);
+}
+
+
+
+// Block until any saved games that are being written in the background have
+// been written to disk.
+void PlayerInfo::FinishSaving()
+{
+	saveThread.Wait();
 }
 
 
@@ -372,7 +566,6 @@ string PlayerInfo::Identifier() const
 // Apply the given set of changes to the game data.
 void PlayerInfo::AddChanges(list<DataNode> &changes)
 {
-	bool changedSystems = false;
 	for(const DataNode &change : changes)
 	{
 		changedSystems |= (change.Token(0) == "system");
@@ -380,22 +573,16 @@ void PlayerInfo::AddChanges(list<DataNode> &changes)
 		changedSystems |= (change.Token(0) == "unlink");
 		GameData::Change(change);
 	}
-	if(changedSystems)
-	{
-		// Recalculate what systems have been seen.
-		GameData::UpdateNeighbors();
-		seen.clear();
-		for(const System *system : visitedSystems)
-		{
-			seen.insert(system);
-			for(const System *neighbor : system->Neighbors())
-				seen.insert(neighbor);
-		}
-	}
+	++mapRevision;
+	if(!isApplyingEvents)
+		UpdateNeighbors();
 	
 	// Only move the changes into my list if they are not already there.
 	if(&changes != &dataChanges)
+	{
 		dataChanges.splice(dataChanges.end(), changes);
+		isSectionSaved[EVENTS] = false;
+	}
 }
 
 
@@ -403,8 +590,12 @@ void PlayerInfo::AddChanges(list<DataNode> &changes)
 // Add an event that will happen at the given date.
 void PlayerInfo::AddEvent(const GameEvent &event, const Date &date)
 {
-	gameEvents.push_back(event);
-	gameEvents.back().SetDate(date);
+	// Keep the events sorted by date. An event goes after any others that
+	// happen on the same day.
+	auto it = upper_bound(gameEvents.begin(), gameEvents.end(), date,
+		[](const Date &date, const GameEvent &event) { return date < event.GetDate(); });
+	gameEvents.insert(it, event)->SetDate(date);
+	isSectionSaved[EVENTS] = false;
 }
 
 
@@ -521,22 +712,22 @@ const Date &PlayerInfo::GetDate() const
 void PlayerInfo::IncrementDate()
 {
 	++date;
+	++mapRevision;
 	conditions["day"] = date.Day();
 	conditions["month"] = date.Month();
 	conditions["year"] = date.Year();
 	
-	// Check if any special events should happen today.
-	auto it = gameEvents.begin();
-	while(it != gameEvents.end())
+	// Check if any special events should happen today. The events are sorted
+	// by date, so only the ones at the start of the list can be due.
+	isApplyingEvents = true;
+	while(!gameEvents.empty() && !(date < gameEvents.front().GetDate()))
 	{
-		if(date < it->GetDate())
-			++it;
-		else
-		{
-			it->Apply(*this);
-			it = gameEvents.erase(it);
-		}
+		gameEvents.front().Apply(*this);
+		gameEvents.pop_front();
+		isSectionSaved[EVENTS] = false;
 	}
+	isApplyingEvents = false;
+	UpdateNeighbors();
 	
 	// Check if any missions have failed because of deadlines.
 	for(Mission &mission : missions)
@@ -1400,6 +1591,7 @@ bool PlayerInfo::TakeOff(UI *ui)
 // Get the player's logbook.
 const multimap<Date, string> &PlayerInfo::Logbook() const
 {
+	ReadLogbook();
 	return logbook;
 }
 
@@ -1407,13 +1599,16 @@ const multimap<Date, string> &PlayerInfo::Logbook() const
 
 void PlayerInfo::AddLogEntry(const string &text)
 {
+	ReadLogbook();
 	logbook.emplace(date, text);
+	isSectionSaved[LOGBOOK] = false;
 }
 
 
 
 const map<string, map<string, string>> &PlayerInfo::SpecialLogs() const
 {
+	ReadLogbook();
 	return specialLogs;
 }
 
@@ -1421,17 +1616,20 @@ const map<string, map<string, string>> &PlayerInfo::SpecialLogs() const
 
 void PlayerInfo::AddSpecialLog(const string &type, const string &name, const string &text)
 {
+	ReadLogbook();
 	string &entry = specialLogs[type][name];
 	if(!entry.empty())
 		entry += "\n\t";
 	entry += text;
+	isSectionSaved[LOGBOOK] = false;
 }
 
 
 
 bool PlayerInfo::HasLogs() const
 {
-	return !logbook.empty() || !specialLogs.empty();
+	// The logbook is only kept unread if it had something in it.
+	return !isLogbookRead || !logbook.empty() || !specialLogs.empty();
 }
 
 
@@ -1491,6 +1689,7 @@ void PlayerInfo::AcceptJob(const Mission &mission, UI *ui)
 			it->Do(Mission::ACCEPT, *this, ui);
 			auto spliceIt = it->IsUnique() ? missions.begin() : missions.end();
 			missions.splice(spliceIt, availableJobs, it);
+			isNPCIndexCurrent = false;
 			break;
 		}
 }
@@ -1537,10 +1736,10 @@ Mission *PlayerInfo::BoardingMission(const shared_ptr<Ship> &ship)
 			? Mission::BOARDING : Mission::ASSISTING);
 	
 	// Check for available boarding or assisting missions.
-	for(const auto &it : GameData::Missions())
-		if(it.second.IsAtLocation(location) && it.second.CanOffer(*this, ship))
+	for(const Mission *mission : GameData::ShipMissions())
+		if(mission->IsAtLocation(location) && mission->CanOffer(*this, ship))
 		{
-			boardingMissions.push_back(it.second.Instantiate(*this, ship));
+			boardingMissions.push_back(mission->Instantiate(*this, ship));
 			if(boardingMissions.back().HasFailed(*this))
 				boardingMissions.pop_back();
 			else
@@ -1614,6 +1813,7 @@ void PlayerInfo::MissionCallback(int response)
 		// to the front, so they appear at the top of the list if viewed.
 		auto spliceIt = mission.IsUnique() ? missions.begin() : missions.end();
 		missions.splice(spliceIt, missionList, missionList.begin());
+		isNPCIndexCurrent = false;
 		mission.Do(Mission::ACCEPT, *this);
 		if(shouldAutosave)
 			Autosave();
@@ -1659,6 +1859,7 @@ void PlayerInfo::RemoveMission(Mission::Trigger trigger, const Mission &mission,
 			// this first avoids the possibility of an infinite loop, e.g. if a
 			// mission's "on fail" fails the mission itself.
 			doneMissions.splice(doneMissions.end(), missions, it);
+			isNPCIndexCurrent = false;
 			
 			it->Do(trigger, *this, ui);
 			cargo.RemoveMissionCargo(&mission);
@@ -1695,8 +1896,34 @@ void PlayerInfo::HandleEvent(const ShipEvent &event, UI *ui)
 			rating = min(maxRating, rating + (event.Target()->Cost() + 250000) / 500000);
 		}
 	
-	for(Mission &mission : missions)
-		mission.Do(event, *this, ui);
+	// Jumps and anything that happens to the player's own ships may matter to
+	// any mission. Other events only matter to the missions that the target
+	// ship is an NPC of.
+	const Government *targetGovernment = event.TargetGovernment();
+	if((event.Type() & ShipEvent::JUMP) || (targetGovernment && targetGovernment->IsPlayer()))
+		for(Mission &mission : missions)
+			mission.Do(event, *this, ui);
+	else if(event.Target())
+	{
+		if(!isNPCIndexCurrent)
+		{
+			npcMissions.clear();
+			for(Mission &mission : missions)
+				for(const NPC &npc : mission.NPCs())
+					for(const shared_ptr<Ship> &ship : npc.Ships())
+					{
+						vector<Mission *> &owners = npcMissions[ship.get()];
+						if(owners.empty() || owners.back() != &mission)
+							owners.push_back(&mission);
+					}
+			isNPCIndexCurrent = true;
+		}
+		
+		auto it = npcMissions.find(event.Target().get());
+		if(it != npcMissions.end())
+			for(Mission *mission : it->second)
+				mission->Do(event, *this, ui);
+	}
 	
 	// If the player's flagship was destroyed, the player is dead.
 	if((event.Type() & ShipEvent::DESTROY) && !ships.empty() && event.Target().get() == Flagship())
@@ -1760,6 +1987,11 @@ void PlayerInfo::CheckReputationConditions()
 // they have actually visited it).
 bool PlayerInfo::HasSeen(const System *system) const
 {
+	if(!system)
+		return false;
+	if(IsSet(seen, system))
+		return true;
+	
 	for(const Mission &mission : availableJobs)
 	{
 		if(mission.Waypoints().count(system))
@@ -1780,7 +2012,7 @@ bool PlayerInfo::HasSeen(const System *system) const
 				return true;
 	}
 	
-	return (seen.count(system) || KnowsName(system));
+	return KnowsName(system);
 }
 
 
@@ -1790,7 +2022,7 @@ bool PlayerInfo::HasVisited(const System *system) const
 {
 	if(!system)
 		return false;
-	return visitedSystems.count(system);
+	return IsSet(visitedSystems, system);
 }
 
 
@@ -1831,10 +2063,12 @@ void PlayerInfo::Visit(const System *system)
 	if(!system)
 		return;
 	
-	visitedSystems.insert(system);
-	seen.insert(system);
+	SetBit(visitedSystems, system, true);
+	SetBit(seen, system, true);
 	for(const System *neighbor : system->Neighbors())
-		seen.insert(neighbor);
+		SetBit(seen, neighbor, true);
+	++mapRevision;
+	isSectionSaved[KNOWLEDGE] = false;
 }
 
 
@@ -1843,7 +2077,11 @@ void PlayerInfo::Visit(const System *system)
 void PlayerInfo::Visit(const Planet *planet)
 {
 	if(planet && !planet->TrueName().empty())
+	{
 		visitedPlanets.insert(planet);
+		++mapRevision;
+		isSectionSaved[KNOWLEDGE] = false;
+	}
 }
 
 
@@ -1854,7 +2092,9 @@ void PlayerInfo::Unvisit(const System *system)
 	if(!system)
 		return;
 	
-	visitedSystems.erase(system);
+	SetBit(visitedSystems, system, false);
+	++mapRevision;
+	isSectionSaved[KNOWLEDGE] = false;
 	for(const StellarObject &object : system->Objects())
 		if(object.GetPlanet())
 			Unvisit(object.GetPlanet());
@@ -1868,6 +2108,8 @@ void PlayerInfo::Unvisit(const Planet *planet)
 		return;
 	
 	visitedPlanets.erase(planet);
+	++mapRevision;
+	isSectionSaved[KNOWLEDGE] = false;
 }
 
 
@@ -1895,6 +2137,48 @@ vector<const System *> &PlayerInfo::TravelPlan()
 
 
 
+// Get each step of the travel plan, starting from the player's system, up to
+// the first one that cannot be made.
+const vector<PlayerInfo::TravelHop> &PlayerInfo::TravelRoute() const
+{
+	// The plan may be changed through TravelPlan(), so a copy of it is kept to
+	// tell whether it has been. It is only a few systems long.
+	if(travelRouteSystem == system && travelRouteRevision == mapRevision && travelRoutePlan == travelPlan)
+		return travelRoute;
+	
+	travelRoute.clear();
+	travelRoutePlan = travelPlan;
+	travelRouteSystem = system;
+	travelRouteRevision = mapRevision;
+	
+	// The wormholes that can be seen on the map are the ones that the player
+	// knows go to the next system.
+	const System *previous = system;
+	for(auto it = travelPlan.rbegin(); previous && it != travelPlan.rend(); ++it)
+	{
+		const System *next = *it;
+		bool isHyper = previous->Links().count(next);
+		bool isJump = !isHyper && previous->Neighbors().count(next);
+		bool isWormhole = false;
+		for(const StellarObject &object : previous->Objects())
+			isWormhole |= (object.GetPlanet() && HasVisited(object.GetPlanet())
+				&& !object.GetPlanet()->Description().empty()
+				&& HasVisited(previous) && HasVisited(next)
+				&& object.GetPlanet()->WormholeDestination(previous) == next);
+		
+		if(!isHyper && !isJump && !isWormhole)
+			break;
+		
+		TravelHop::Type type = isWormhole ? TravelHop::WORMHOLE
+			: isJump ? TravelHop::JUMP_DRIVE : TravelHop::HYPERDRIVE;
+		travelRoute.push_back({previous, next, type});
+		previous = next;
+	}
+	return travelRoute;
+}
+
+
+
 // This is called when the player enters the system that is their current
 // hyperspace target.
 void PlayerInfo::PopTravel()
@@ -2176,8 +2460,11 @@ const Depreciation &PlayerInfo::StockDepreciation() const
 
 void PlayerInfo::Harvest(const Outfit *type)
 {
-	if(type && system)
-		harvested.insert(make_pair(system, type));
+	if(type && system && harvested.insert(make_pair(system, type)).second)
+	{
+		++mapRevision;
+		isSectionSaved[KNOWLEDGE] = false;
+	}
 }
 
 
@@ -2189,6 +2476,15 @@ const set<pair<const System *, const Outfit *>> &PlayerInfo::Harvested() const
 
 
 
+// Get a number that changes whenever the date, the systems and planets you have
+// seen or visited, the galaxy, or what you have harvested changes.
+int PlayerInfo::MapRevision() const
+{
+	return mapRevision;
+}
+
+
+
 // Get what coloring is currently selected in the map.
 int PlayerInfo::MapColoring() const
 {
@@ -2306,6 +2602,28 @@ void PlayerInfo::ApplyChanges()
 
 
 
+// If any changes since the last call created, moved, or linked systems,
+// recalculate the system neighbors and which systems have been seen.
+void PlayerInfo::UpdateNeighbors()
+{
+	if(!changedSystems)
+		return;
+	changedSystems = false;
+	
+	// Recalculate what systems have been seen.
+	GameData::UpdateNeighbors();
+	seen.assign(System::Count(), false);
+	for(const auto &it : GameData::Systems())
+		if(IsSet(visitedSystems, &it.second))
+		{
+			SetBit(seen, &it.second, true);
+			for(const System *neighbor : it.second.Neighbors())
+				SetBit(seen, neighbor, true);
+		}
+}
+
+
+
 // Update the conditions that reflect the current status of the player.
 void PlayerInfo::UpdateAutoConditions(bool isBoarding)
 {
@@ -2388,24 +2706,45 @@ void PlayerInfo::CreateMissions()
 	// Check for available missions.
 	bool skipJobs = planet && !planet->HasSpaceport();
 	bool hasPriorityMissions = false;
-	for(const auto &it : GameData::Missions())
+	// Only missions whose source matches this planet can possibly be offered.
+	vector<const Mission *> offers;
+	for(const Mission *mission : GameData::MissionsFrom(planet))
 	{
-		if(it.second.IsAtLocation(Mission::BOARDING) || it.second.IsAtLocation(Mission::ASSISTING))
-			continue;
-		if(skipJobs && it.second.IsAtLocation(Mission::JOB))
+		if(skipJobs && mission->IsAtLocation(Mission::JOB))
 			continue;
 		
-		if(it.second.CanOffer(*this))
+		if(mission->CanOffer(*this))
+			offers.push_back(mission);
+	}
+	
+	// Instantiating a mission does not change the player's state, so each offer
+	// can be instantiated independently of the others. Picking destinations and
+	// creating NPCs is slow enough that a planet with lots of jobs would make
+	// landing hitch if this were done on one thread. There are never very many
+	// offers, so they are split up even if each thread only gets one. Each one
+	// draws from its own random stream, so which thread instantiates it has no
+	// effect on what it turns out to be.
+	vector<Mission> instances(offers.size());
+	const uint64_t randomKey = Random::Int();
+	MissionWorkers().Run(offers.size(), [this, &offers, &instances, randomKey](size_t, size_t begin, size_t end)
+	{
+		for(size_t i = begin; i < end; ++i)
 		{
-			list<Mission> &missions =
-				it.second.IsAtLocation(Mission::JOB) ? availableJobs : availableMissions;
-			
-			missions.push_back(it.second.Instantiate(*this));
-			if(missions.back().HasFailed(*this))
-				missions.pop_back();
-			else if(!it.second.IsAtLocation(Mission::JOB))
-				hasPriorityMissions |= missions.back().HasPriority();
+			Random::Stream stream(MISSION_STREAM, randomKey, i);
+			instances[i] = offers[i]->Instantiate(*this);
 		}
+	}, 1);
+	
+	for(size_t i = 0; i < offers.size(); ++i)
+	{
+		if(instances[i].HasFailed(*this))
+			continue;
+		
+		bool isJob = offers[i]->IsAtLocation(Mission::JOB);
+		list<Mission> &missions = isJob ? availableJobs : availableMissions;
+		missions.push_back(std::move(instances[i]));
+		if(!isJob)
+			hasPriorityMissions |= missions.back().HasPriority();
 	}
 	
 	// If any of the available missions are "priority" missions, no other
@@ -2542,14 +2881,16 @@ void PlayerInfo::Autosave() const
 		return;
 	
 	string path = filePath.substr(0, filePath.length() - 4) + "~autosave.txt";
-	Save(path);
+	DataWriter out;
+	Save(out);
+	StartSave(path, out.GetString(), date, false);
 }
 
 
 
-void PlayerInfo::Save(const string &path) const
+void PlayerInfo::Save(DataWriter &out) const
 {
-	DataWriter out(path);
+	TRACE_SCOPE("PlayerInfo::Save");
 	
 	
 	// Basic player information and persistent UI settings:
@@ -2604,7 +2945,11 @@ void PlayerInfo::Save(const string &path) const
 	// Records of things you own:
 	out.Write();
 	out.WriteComment("What you own:");
-		
+	
+	// Save accounting information first, so that the load panel can find it
+	// and the first ship without reading the rest of the file.
+	accounts.Save(out);
+	
 	// Save all the data for all the player's ships.
 	for(const shared_ptr<Ship> &ship : ships)
 	{
@@ -2614,8 +2959,7 @@ void PlayerInfo::Save(const string &path) const
 			out.Write("groups", it->second);
 	}
 	
-	// Save accounting information, cargo, and cargo cost bases.
-	accounts.Save(out);
+	// Save cargo and cargo cost bases.
 	cargo.Save(out);
 	if(!costBasis.empty())
 	{
@@ -2675,18 +3019,21 @@ void PlayerInfo::Save(const string &path) const
 	}
 	
 	// Save pending events, and changes that have happened due to past events.
-	for(const GameEvent &event : gameEvents)
-		event.Save(out);
-	if(!dataChanges.empty())
+	SaveSection(out, EVENTS, [this](DataWriter &out)
 	{
-		out.Write("changes");
-		out.BeginChild();
+		for(const GameEvent &event : gameEvents)
+			event.Save(out);
+		if(!dataChanges.empty())
 		{
-			for(const DataNode &node : dataChanges)
-				out.Write(node);
-		}	
-		out.EndChild();
-	}
+			out.Write("changes");
+			out.BeginChild();
+			{
+				for(const DataNode &node : dataChanges)
+					out.Write(node);
+			}	
+			out.EndChild();
+		}
+	});
 	GameData::WriteEconomy(out);
 	
 	// Check which persons have been captured or destroyed.
@@ -2699,54 +3046,115 @@ void PlayerInfo::Save(const string &path) const
 	out.Write();
 	out.WriteComment("What you know:");
 	
-	// Save a list of systems the player has visited.
-	for(const System *system : visitedSystems)
-		if(!system->Name().empty())
-			out.Write("visited", system->Name());
-	
-	// Save a list of planets the player has visited.
-	for(const Planet *planet : visitedPlanets)
-		if(!planet->TrueName().empty())
-			out.Write("visited planet", planet->TrueName());
-	
-	if(!harvested.empty())
+	SaveSection(out, KNOWLEDGE, [this](DataWriter &out)
 	{
-		out.Write("harvested");
-		out.BeginChild();
+		// Save a list of systems the player has visited.
+		for(const auto &it : GameData::Systems())
+			if(IsSet(visitedSystems, &it.second) && !it.second.Name().empty())
+				out.Write("visited", it.second.Name());
+		
+		// Save a list of planets the player has visited.
+		for(const Planet *planet : visitedPlanets)
+			if(!planet->TrueName().empty())
+				out.Write("visited planet", planet->TrueName());
+		
+		if(!harvested.empty())
 		{
-			for(const auto &it : harvested)
-				if(it.first && it.second)
-					out.Write(it.first->Name(), it.second->Name());
+			out.Write("harvested");
+			out.BeginChild();
+			{
+				for(const auto &it : harvested)
+					if(it.first && it.second)
+						out.Write(it.first->Name(), it.second->Name());
+			}
+			out.EndChild();
 		}
-		out.EndChild();
-	}
+	});
 	
-	out.Write("logbook");
-	out.BeginChild();
-	for(const auto &it : logbook)
+	SaveSection(out, LOGBOOK, [this](DataWriter &out)
 	{
-		out.Write(it.first.Day(), it.first.Month(), it.first.Year());
+		out.Write("logbook");
 		out.BeginChild();
+		for(const auto &it : logbook)
 		{
-			// Break the text up into paragraphs.
-			for(const string &line : Format::Split(it.second, "\n\t"))
-				out.Write(line);
-		}
-		out.EndChild();
-	}
-	for(const auto &it : specialLogs)
-		for(const auto &eit : it.second)
-		{
-			out.Write(it.first, eit.first);
+			out.Write(it.first.Day(), it.first.Month(), it.first.Year());
 			out.BeginChild();
 			{
 				// Break the text up into paragraphs.
-				for(const string &line : Format::Split(eit.second, "\n\t"))
+				for(const string &line : Format::Split(it.second, "\n\t"))
 					out.Write(line);
 			}
 			out.EndChild();
 		}
-	out.EndChild();
+		for(const auto &it : specialLogs)
+			for(const auto &eit : it.second)
+			{
+				out.Write(it.first, eit.first);
+				out.BeginChild();
+				{
+					// Break the text up into paragraphs.
+					for(const string &line : Format::Split(eit.second, "\n\t"))
+						out.Write(line);
+				}
+				out.EndChild();
+			}
+		out.EndChild();
+	});
+}
+
+
+
+// Write the given section of the saved game, reusing the text from the last
+// save if nothing in that section has changed since then.
+void PlayerInfo::SaveSection(DataWriter &out, Section section, const function<void(DataWriter &)> &write) const
+{
+	if(!isSectionSaved[section])
+	{
+		DataWriter text;
+		write(text);
+		sectionText[section] = text.GetString();
+		isSectionSaved[section] = true;
+	}
+	out.WriteRaw(sectionText[section]);
+}
+
+
+
+// Parse the logbook text that was loaded, if that has not been done yet.
+void PlayerInfo::ReadLogbook() const
+{
+	if(isLogbookRead)
+		return;
+	isLogbookRead = true;
+	
+	istringstream in(sectionText[LOGBOOK]);
+	DataFile file(in);
+	for(const DataNode &node : file)
+		for(const DataNode &grand : node)
+		{
+			if(grand.Size() >= 3)
+			{
+				Date date(grand.Value(0), grand.Value(1), grand.Value(2));
+				string text;
+				for(const DataNode &great : grand)
+				{
+					if(!text.empty())
+						text += "\n\t";
+					text += great.Token(0);
+				}
+				logbook.emplace(date, text);
+			}
+			else if(grand.Size() >= 2)
+			{
+				string &text = specialLogs[grand.Token(0)][grand.Token(1)];
+				for(const DataNode &great : grand)
+				{
+					if(!text.empty())
+						text += "\n\t";
+					text += great.Token(0);
+				}
+			}
+		}
 }
 
 
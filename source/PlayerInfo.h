@@ -21,6 +21,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "GameEvent.h"
 #include "Mission.h"
 
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -29,6 +30,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <utility>
 #include <vector>
 
+class DataFile;
+class DataWriter;
 class Government;
 class Outfit;
 class Planet;
@@ -48,6 +51,18 @@ class UI;
 // has made to the universe, what jobs are being offered to them right now,
 // and what their current travel plan is, if any.
 class PlayerInfo {
+public:
+	// One step of the travel plan, and how it is made.
+	class TravelHop {
+	public:
+		enum Type {HYPERDRIVE, JUMP_DRIVE, WORMHOLE};
+		
+		const System *from;
+		const System *to;
+		Type type;
+	};
+	
+	
 public:
 	PlayerInfo() = default;
 	
@@ -60,10 +75,16 @@ public:
 	void New();
 	// Load an existing player.
 	void Load(const std::string &path);
+	// Start reading the most recently saved player in the background. This
+	// only needs the config directory, not the game data, so it can be done
+	// while the game data is loading.
+	static void BeginLoadRecent();
 	// Load the most recently saved player. If no save could be loaded, returns false.
 	bool LoadRecent();
-	// Save this player (using the Identifier() as the file name).
+	// Save this player (using the Identifier() as the file name). The file is
+	// written in the background; FinishSaving() waits for it to be done.
 	void Save() const;
+	static void FinishSaving();
 	
 	// Get the root filename used for this player's saved game files. (If there
 	// are multiple pilots with the same name it may have a digit appended.)
@@ -202,6 +223,10 @@ public:
 	bool HasTravelPlan() const;
 	const std::vector<const System *> &TravelPlan() const;
 	std::vector<const System *> &TravelPlan();
+	// Get each step of the travel plan, starting from the player's system, up
+	// to the first one that cannot be made. This is only worked out again if
+	// the plan, the player's system, or the map revision has changed.
+	const std::vector<TravelHop> &TravelRoute() const;
 	// Remove the first or last system from the travel plan.
 	void PopTravel();
 	// Get or set the planet to land on at the end of the travel path.
@@ -235,6 +260,11 @@ public:
 	void Harvest(const Outfit *type);
 	const std::set<std::pair<const System *, const Outfit *>> &Harvested() const;
 	
+	// Get a number that changes whenever the date, the systems and planets you
+	// have seen or visited, the galaxy, or what you have harvested changes, so
+	// cached map colorings can tell when they are out of date.
+	int MapRevision() const;
+	
 	// Get or set what coloring is currently selected in the map.
 	int MapColoring() const;
 	void SetMapColoring(int index);
@@ -251,15 +281,29 @@ private:
 	PlayerInfo(const PlayerInfo &) = default;
 	PlayerInfo &operator=(const PlayerInfo &) = default;
 	
+	// Load player information from a saved game file that has been parsed.
+	void Load(const std::string &path, DataFile &file);
+	
 	// Apply any "changes" saved in this player info to the global game state.
 	void ApplyChanges();
+	// If any changes since the last call created, moved, or linked systems,
+	// recalculate the system neighbors and which systems have been seen.
+	void UpdateNeighbors();
 	
 	// New missions are generated each time you land on a planet.
 	void UpdateAutoConditions(bool isBoarding = false);
 	void CreateMissions();
 	void StepMissions(UI *ui);
 	void Autosave() const;
-	void Save(const std::string &path) const;
+	void Save(DataWriter &out) const;
+	
+	// Parts of the saved game that only change when the player does certain
+	// things. The text of each one is kept from the last save, and is only
+	// written again if that part has changed since then.
+	enum Section {KNOWLEDGE, EVENTS, LOGBOOK, SECTION_COUNT};
+	void SaveSection(DataWriter &out, Section section, const std::function<void(DataWriter &)> &write) const;
+	// Parse the logbook text that was loaded, if that has not been done yet.
+	void ReadLogbook() const;
 	
 	// Check for and apply any punitive actions from planetary security.
 	void Fine(UI *ui);
@@ -292,11 +336,20 @@ private:
 	CargoHold cargo;
 	std::map<std::string, int64_t> costBasis;
 	
-	std::multimap<Date, std::string> logbook;
-	std::map<std::string, std::map<std::string, std::string>> specialLogs;
+	// The logbook is only parsed the first time it is needed. Until then, its
+	// text is kept as it was in the saved game.
+	mutable std::multimap<Date, std::string> logbook;
+	mutable std::map<std::string, std::map<std::string, std::string>> specialLogs;
+	mutable bool isLogbookRead = true;
 	
 	// A list of the player's active, accepted missions.
 	std::list<Mission> missions;
+	// For each ship that belongs to one of those missions' NPCs, the missions
+	// it belongs to, in the same order as the list. Most ship events are only
+	// passed to those missions. This is built once it is needed after the
+	// list of missions changes.
+	std::map<const Ship *, std::vector<Mission *>> npcMissions;
+	bool isNPCIndexCurrent = false;
 	// These lists are populated when you land on a planet, and saved so that
 	// they will not change if you reload the game.
 	std::list<Mission> availableJobs;
@@ -311,11 +364,27 @@ private:
 	
 	std::map<std::string, int64_t> conditions;
 	
-	std::set<const System *> seen;
-	std::set<const System *> visitedSystems;
+	// The systems that have been seen or visited, indexed by System::Index().
+	std::vector<bool> seen;
+	std::vector<bool> visitedSystems;
 	std::set<const Planet *> visitedPlanets;
+	
+	// The text of each section as of the last save, and whether it still
+	// matches what the player has now.
+	mutable std::string sectionText[SECTION_COUNT];
+	mutable bool isSectionSaved[SECTION_COUNT] = {};
+	int mapRevision = 0;
+	// Recalculating the system neighbors is slow, so if several events happen
+	// on the same day, it is only done once all of them have been applied.
+	bool changedSystems = false;
+	bool isApplyingEvents = false;
 	std::vector<const System *> travelPlan;
 	const Planet *travelDestination = nullptr;
+	// The steps of the travel plan, and what they were worked out from.
+	mutable std::vector<TravelHop> travelRoute;
+	mutable std::vector<const System *> travelRoutePlan;
+	mutable const System *travelRouteSystem = nullptr;
+	mutable int travelRouteRevision = -1;
 	
 	const Outfit *selectedWeapon = nullptr;
 	
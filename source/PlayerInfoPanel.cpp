@@ -40,6 +40,15 @@ namespace {
 	// Number of lines per page of the fleet listing.
 	const int LINES_PER_PAGE = 26;
 	
+	// Update the text showing the given value, if the value has changed.
+	void Update(int &value, string &text, int newValue, const string &suffix = "")
+	{
+		if(value == newValue && !text.empty())
+			return;
+		value = newValue;
+		text = to_string(newValue) + suffix;
+	}
+	
 	// Find any condition strings that begin with the given prefix, and convert
 	// them to strings ending in the given suffix (if any). Return those strings
 	// plus the values of the conditions.
@@ -601,30 +610,38 @@ void PlayerInfoPanel::DrawFleet(const Rectangle &bounds)
 		// Store this row's position, to handle hovering.
 		zones.emplace_back(table.GetCenterPoint(), table.GetRowSize(), index);
 		
-		// Indent the ship name if it is a fighter or drone.
-		table.Draw(font.TruncateMiddle(ship.CanBeCarried() ? "    " + ship.Name() : ship.Name(), 217));
+		// Only format the parts of this row that have changed since it was last
+		// drawn. Indent the ship name if it is a fighter or drone.
+		FleetRow &row = rows[&ship];
+		if(row.nameText.empty() || row.name != ship.Name())
+		{
+			row.name = ship.Name();
+			row.nameText = font.TruncateMiddle(ship.CanBeCarried() ? "    " + ship.Name() : ship.Name(), 217);
+		}
+		table.Draw(row.nameText);
 		table.Draw(ship.ModelName());
 		
 		const System *system = ship.GetSystem();
 		table.Draw(system ? system->Name() : "");
 		
-		string shields = to_string(static_cast<int>(100. * max(0., ship.Shields()))) + "%";
-		table.Draw(shields);
+		Update(row.shields, row.shieldsText, static_cast<int>(100. * max(0., ship.Shields())), "%");
+		table.Draw(row.shieldsText);
 		
-		string hull = to_string(static_cast<int>(100. * max(0., ship.Hull()))) + "%";
-		table.Draw(hull);
+		Update(row.hull, row.hullText, static_cast<int>(100. * max(0., ship.Hull())), "%");
+		table.Draw(row.hullText);
 		
-		string fuel = to_string(static_cast<int>(
+		Update(row.fuel, row.fuelText, static_cast<int>(
 			ship.Attributes().Get("fuel capacity") * ship.Fuel()));
-		table.Draw(fuel);
+		table.Draw(row.fuelText);
 		
 		// If this isn't the flagship, we'll remember how many crew it has, but
 		// only the minimum number of crew need to be paid for.
 		int crewCount = ship.Crew();
 		if(&ship != player.Flagship())
 			crewCount = min(crewCount, ship.RequiredCrew());
-		string crew = (ship.IsParked() ? "Parked" : to_string(crewCount));
-		table.Draw(crew);
+		static const string PARKED = "Parked";
+		Update(row.crew, row.crewText, crewCount);
+		table.Draw(ship.IsParked() ? PARKED : row.crewText);
 		
 		++index;
 	}
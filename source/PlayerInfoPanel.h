@@ -18,11 +18,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "ClickZone.h"
 #include "Point.h"
 
+#include <map>
 #include <set>
+#include <string>
 #include <vector>
 
 class PlayerInfo;
 class Rectangle;
+class Ship;
 
 
 
@@ -58,9 +61,30 @@ private:
 	bool Scroll(int distance);
 	
 	
+private:
+	// The text of one row of the fleet listing, along with the values it was
+	// formatted from, so that it is only formatted again if those change.
+	class FleetRow {
+	public:
+		std::string name;
+		int shields = -1;
+		int hull = -1;
+		int fuel = -1;
+		int crew = -1;
+		
+		std::string nameText;
+		std::string shieldsText;
+		std::string hullText;
+		std::string fuelText;
+		std::string crewText;
+	};
+	
+	
 private:
 	PlayerInfo &player;
 	
+	std::map<const Ship *, FleetRow> rows;
+	
 	std::vector<ClickZone<int>> zones;
 	// Keep track of which ship the mouse is hovering over, which ship was most
 	// recently selected, which ship is currently being dragged, and all ships
@@ -13,10 +13,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 
 #include "Color.h"
+#include "GameWindow.h"
 #include "Point.h"
 #include "Screen.h"
 #include "Shader.h"
+#include "StreamBuffer.h"
 
+#include <cstddef>
 #include <stdexcept>
 
 using namespace std;
@@ -32,6 +35,27 @@ namespace {
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// The instanced version of the shader reads each pointer's parameters from
+	// a vertex buffer instead of from uniforms.
+	Shader instancedShader;
+	GLint instancedScaleI;
+	GLint itemCenterI;
+	GLint itemAngleI;
+	GLint itemSizeI;
+	GLint itemOffsetI;
+	GLint itemColorI;
+	
+	GLuint instancedVao;
+	
+	void SetUniforms(const PointerShader::Item &item)
+	{
+		glUniform2fv(centerI, 1, item.center);
+		glUniform2fv(angleI, 1, item.angle);
+		glUniform2fv(sizeI, 1, item.size);
+		glUniform1f(offsetI, item.offset);
+		glUniform4fv(colorI, 1, item.color);
+	}
 }
 
 
@@ -55,10 +79,13 @@ void PointerShader::Init()
 		"  gl_Position = vec4((base + wing) * scale, 0, 1);\n"
 		"}\n";
 
-	static const char *fragmentCode =
+	// The fragment shader is the same whether its inputs are uniforms or are
+	// passed in for each instance by the instanced vertex shader.
+	static const char *fragmentUniforms =
 		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
-		"uniform vec2 size;\n"
-		
+		"uniform vec2 size;\n";
+	
+	static const char *fragmentCode =
 		"in vec2 coord;\n"
 		"out vec4 finalColor;\n"
 		
@@ -71,7 +98,7 @@ void PointerShader::Init()
 		"  finalColor = color * alpha;\n"
 		"}\n";
 	
-	shader = Shader(vertexCode, fragmentCode);
+	shader = Shader(vertexCode, (fragmentUniforms + string(fragmentCode)).c_str());
 	scaleI = shader.Uniform("scale");
 	centerI = shader.Uniform("center");
 	angleI = shader.Uniform("angle");
@@ -99,6 +126,74 @@ void PointerShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	static const char *instancedVertexCode =
+		"uniform vec2 scale;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 itemCenter;\n"
+		"in vec2 itemAngle;\n"
+		"in vec2 itemSize;\n"
+		"in float itemOffset;\n"
+		"in vec4 itemColor;\n"
+		
+		"out vec2 coord;\n"
+		"flat out vec4 color;\n"
+		"flat out vec2 size;\n"
+		
+		"void main() {\n"
+		"  coord = vert * itemSize.x;\n"
+		"  vec2 base = itemCenter + itemAngle * (itemOffset - itemSize.y * (vert.x + vert.y));\n"
+		"  vec2 wing = vec2(itemAngle.y, -itemAngle.x) * (itemSize.x * .5 * (vert.x - vert.y));\n"
+		"  gl_Position = vec4((base + wing) * scale, 0, 1);\n"
+		"  color = itemColor;\n"
+		"  size = itemSize;\n"
+		"}\n";
+	
+	static const char *fragmentInputs =
+		"flat in vec4 color;\n"
+		"flat in vec2 size;\n";
+	
+	instancedShader = Shader(instancedVertexCode, (fragmentInputs + string(fragmentCode)).c_str());
+	instancedScaleI = instancedShader.Uniform("scale");
+	itemCenterI = instancedShader.Attrib("itemCenter");
+	itemAngleI = instancedShader.Attrib("itemAngle");
+	itemSizeI = instancedShader.Attrib("itemSize");
+	itemOffsetI = instancedShader.Attrib("itemOffset");
+	itemColorI = instancedShader.Attrib("itemColor");
+	
+	glGenVertexArrays(1, &instancedVao);
+	glBindVertexArray(instancedVao);
+	
+	// The corners of the triangle come from the same buffer as above.
+	// Everything else comes from the StreamBuffer, once per pointer.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GLint vertI = instancedShader.Attrib("vert");
+	glEnableVertexAttribArray(vertI);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	for(GLint attrib : {itemCenterI, itemAngleI, itemSizeI, itemOffsetI, itemColorI})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+
+PointerShader::Item::Item(const Point &center, const Point &angle, float width, float height, float offset, const Color &color)
+	: center{static_cast<float>(center.X()), static_cast<float>(center.Y())},
+	angle{static_cast<float>(angle.X()), static_cast<float>(angle.Y())},
+	size{width, height}, offset(offset)
+{
+	const float *source = color.Get();
+	for(int i = 0; i < 4; ++i)
+		this->color[i] = source[i];
 }
 
 
@@ -130,18 +225,7 @@ void PointerShader::Bind()
 
 void PointerShader::Add(const Point &center, const Point &angle, float width, float height, float offset, const Color &color)
 {
-	GLfloat c[2] = {static_cast<float>(center.X()), static_cast<float>(center.Y())};
-	glUniform2fv(centerI, 1, c);
-	
-	GLfloat a[2] = {static_cast<float>(angle.X()), static_cast<float>(angle.Y())};
-	glUniform2fv(angleI, 1, a);
-	
-	GLfloat size[2] = {width, height};
-	glUniform2fv(sizeI, 1, size);
-	
-	glUniform1f(offsetI, offset);
-	
-	glUniform4fv(colorI, 1, color.Get());
+	SetUniforms(Item(center, angle, width, height, offset, color));
 	
 	glDrawArrays(GL_TRIANGLES, 0, 3);
 }
@@ -153,3 +237,46 @@ void PointerShader::Unbind()
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
+
+
+
+// Draw all the given pointers. If the graphics card supports instancing this is
+// a single draw call; otherwise, each pointer is drawn separately.
+void PointerShader::Draw(const vector<Item> &items)
+{
+	if(items.empty())
+		return;
+	
+	if(!GameWindow::HasInstancing())
+	{
+		Bind();
+		for(const Item &item : items)
+		{
+			SetUniforms(item);
+			glDrawArrays(GL_TRIANGLES, 0, 3);
+		}
+		Unbind();
+		return;
+	}
+	
+	glUseProgram(instancedShader.Object());
+	glBindVertexArray(instancedVao);
+	
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	glUniform2fv(instancedScaleI, 1, scale);
+	
+	// The items are uploaded exactly as they are stored.
+	const char *base = reinterpret_cast<const char *>(
+		StreamBuffer::Upload(items.data(), sizeof(Item) * items.size()));
+	const GLsizei stride = sizeof(Item);
+	glVertexAttribPointer(itemCenterI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, center));
+	glVertexAttribPointer(itemAngleI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, angle));
+	glVertexAttribPointer(itemSizeI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, size));
+	glVertexAttribPointer(itemOffsetI, 1, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, offset));
+	glVertexAttribPointer(itemColorI, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, color));
+	
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 3, items.size());
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	Unbind();
+}
@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef POINTER_SHADER_H_
 #define POINTER_SHADER_H_
 
+#include <vector>
+
 class Color;
 class Point;
 
@@ -20,6 +22,20 @@ class Point;
 
 // Functions for drawing triangular "pointers," e.g. for target crosshairs.
 class PointerShader {
+public:
+	// The parameters for drawing one pointer, for use when drawing many at once.
+	class Item {
+	public:
+		Item(const Point &center, const Point &angle, float width, float height, float offset, const Color &color);
+		
+		float center[2];
+		float angle[2];
+		float size[2];
+		float offset;
+		float color[4];
+	};
+	
+	
 public:
 	static void Init();
 	
@@ -28,6 +44,10 @@ public:
 	static void Bind();
 	static void Add(const Point &center, const Point &angle, float width, float height, float offset, const Color &color);
 	static void Unbind();
+	
+	// Draw all the given pointers. If the graphics card supports instancing
+	// this is a single draw call; otherwise, each pointer is drawn separately.
+	static void Draw(const std::vector<Item> &items);
 };
 
 
@@ -36,7 +36,11 @@ void Politics::Reset()
 	ResetDaily();
 	
 	for(const auto &it : GameData::Governments())
+	{
 		reputationWith[&it.second] = it.second.InitialPlayerReputation();
+		UpdateEnemy(&it.second);
+	}
+	++revision;
 	
 	// Disable fines for today (because the game was just loaded, so any fines
 	// were already checked for when you first landed).
@@ -57,13 +61,8 @@ bool Politics::IsEnemy(const Government *first, const Government *second) const
 		swap(first, second);
 	if(first->IsPlayer())
 	{
-		if(bribed.count(second))
-			return false;
-		if(provoked.count(second))
-			return true;
-		
-		auto it = reputationWith.find(second);
-		return (it != reputationWith.end() && it->second < 0.);
+		unsigned index = second->Index();
+		return (index < isPlayerEnemy.size() && isPlayerEnemy[index]);
 	}
 	
 	// Neither government is the player, so the question of enemies depends only
@@ -110,7 +109,9 @@ void Politics::Offend(const Government *gov, int eventType, int count)
 				reputationWith[other] = min(0., reputationWith[other]);
 			
 			reputationWith[other] -= penalty;
+			++revision;
 		}
+		UpdateEnemy(other);
 	}
 }
 
@@ -122,6 +123,7 @@ void Politics::Bribe(const Government *gov)
 	bribed.insert(gov);
 	provoked.erase(gov);
 	fined.insert(gov);
+	UpdateEnemy(gov);
 }
 
 
@@ -191,6 +193,7 @@ void Politics::DominatePlanet(const Planet *planet, bool dominate)
 		dominatedPlanets.insert(planet);
 	else
 		dominatedPlanets.erase(planet);
+	++revision;
 }
 
 
@@ -298,6 +301,8 @@ double Politics::Reputation(const Government *gov) const
 void Politics::AddReputation(const Government *gov, double value)
 {
 	reputationWith[gov] += value;
+	++revision;
+	UpdateEnemy(gov);
 }
 
 
@@ -305,6 +310,8 @@ void Politics::AddReputation(const Government *gov, double value)
 void Politics::SetReputation(const Government *gov, double value)
 {
 	reputationWith[gov] = value;
+	++revision;
+	UpdateEnemy(gov);
 }
 
 
@@ -316,4 +323,39 @@ void Politics::ResetDaily()
 	bribed.clear();
 	bribedPlanets.clear();
 	fined.clear();
+	
+	// Without any bribes or provocations, only reputation matters.
+	isPlayerEnemy.clear();
+	for(const auto &it : reputationWith)
+		UpdateEnemy(it.first);
+}
+
+
+
+// Get a number that changes whenever a reputation changes or a planet is
+// dominated or released.
+int Politics::Revision() const
+{
+	return revision;
+}
+
+
+
+// Recalculate whether the given government is hostile to the player, after any
+// change to its reputation, bribe, or provocation.
+void Politics::UpdateEnemy(const Government *gov)
+{
+	unsigned index = gov->Index();
+	if(isPlayerEnemy.size() <= index)
+		isPlayerEnemy.resize(index + 1, false);
+	
+	if(bribed.count(gov))
+		isPlayerEnemy[index] = false;
+	else if(provoked.count(gov))
+		isPlayerEnemy[index] = true;
+	else
+	{
+		auto it = reputationWith.find(gov);
+		isPlayerEnemy[index] = (it != reputationWith.end() && it->second < 0.);
+	}
 }
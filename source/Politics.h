@@ -16,6 +16,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 class Government;
 class Planet;
@@ -65,6 +66,17 @@ public:
 	// Reset any temporary effects (typically because a day has passed).
 	void ResetDaily();
 	
+	// Get a number that changes whenever a reputation changes or a planet is
+	// dominated or released, so cached data that depends on them can tell when
+	// it is out of date.
+	int Revision() const;
+	
+	
+private:
+	// Recalculate whether the given government is hostile to the player, after
+	// any change to its reputation, bribe, or provocation.
+	void UpdateEnemy(const Government *gov);
+	
 	
 private:
 	// attitude[target][other] stores how much an action toward the given target
@@ -78,6 +90,12 @@ private:
 	std::map<const Planet *, bool> bribedPlanets;
 	std::set<const Planet *> dominatedPlanets;
 	std::set<const Government *> fined;
+	// Whether each government, by index, is hostile to the player right now.
+	// This is checked for every pair of ships in every frame, so it is kept up
+	// to date whenever anything it depends on changes.
+	std::vector<bool> isPlayerEnemy;
+	
+	int revision = 0;
 };
 
 
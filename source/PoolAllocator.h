@@ -0,0 +1,119 @@
+/* PoolAllocator.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+
+
+// Allocator for objects that are created and destroyed very often, such as the
+// flotsam from ships that are destroyed in a big battle. Instead of returning
+// the memory of a destroyed object to the heap, it is kept in a free list, and
+// the next object of the same type reuses it. So, once enough objects have been
+// allocated to cover a typical battle, creating new ones no longer touches the
+// heap. This allocator is meant to be used with std::allocate_shared(), so that
+// the shared pointer's control block is recycled along with the object. It is
+// safe to allocate and deallocate from any thread.
+template <class Type>
+class PoolAllocator {
+public:
+	using value_type = Type;
+	
+	PoolAllocator() noexcept = default;
+	template <class Other>
+	PoolAllocator(const PoolAllocator<Other> &) noexcept {}
+	
+	Type *allocate(std::size_t count);
+	void deallocate(Type *object, std::size_t count) noexcept;
+	
+	// All pools of the same type share the same memory.
+	template <class Other>
+	bool operator==(const PoolAllocator<Other> &) const noexcept { return true; }
+	template <class Other>
+	bool operator!=(const PoolAllocator<Other> &) const noexcept { return false; }
+	
+	
+private:
+	class Pool {
+	public:
+		std::mutex mutex;
+		std::vector<void *> free;
+	};
+	
+	// The pool is never destroyed, so that objects which outlive the static
+	// variables (e.g. ones that are destroyed during program exit) can still
+	// give their memory back to it.
+	static Pool &GetPool();
+};
+
+
+
+template <class Type>
+Type *PoolAllocator<Type>::allocate(std::size_t count)
+{
+	// Only single objects are pooled.
+	if(count != 1)
+		return static_cast<Type *>(::operator new(count * sizeof(Type)));
+	
+	Pool &pool = GetPool();
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		if(!pool.free.empty())
+		{
+			void *memory = pool.free.back();
+			pool.free.pop_back();
+			return static_cast<Type *>(memory);
+		}
+	}
+	return static_cast<Type *>(::operator new(sizeof(Type)));
+}
+
+
+
+template <class Type>
+void PoolAllocator<Type>::deallocate(Type *object, std::size_t count) noexcept
+{
+	if(count != 1)
+	{
+		::operator delete(object);
+		return;
+	}
+	
+	Pool &pool = GetPool();
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	try {
+		pool.free.push_back(object);
+	}
+	catch(...)
+	{
+		// If the free list cannot grow, just give the memory back to the heap.
+		::operator delete(object);
+	}
+}
+
+
+
+template <class Type>
+typename PoolAllocator<Type>::Pool &PoolAllocator<Type>::GetPool()
+{
+	static Pool *pool = new Pool;
+	return *pool;
+}
+
+
+
+#endif
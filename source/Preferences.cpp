@@ -20,6 +20,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Screen.h"
 
 #include <algorithm>
+#include <cmath>
 #include <map>
 
 using namespace std;
@@ -32,8 +33,34 @@ namespace {
 	const string EXPEND_AMMO = "Escorts expend ammo";
 	const string FRUGAL_ESCORTS = "Escorts use ammo frugally";
 	
+	// The names of the settings that are also stored as flags, in the same
+	// order as Preferences::Flag.
+	const string FLAG_NAMES[Preferences::FLAG_COUNT] = {
+		"Automatic aiming",
+		"Automatic firing",
+		"Turrets focus fire",
+		"Damaged fighters retreat",
+		"Repair fighters in",
+		"Render motion blur",
+		"Highlight player's flagship",
+		"Show planet labels",
+		"Rotate flagship in HUD",
+		"Show CPU / GPU load",
+		"Show mini-map",
+		"Show hyperspace flash",
+		"Show status overlays",
+		"Disable viewport on radar",
+		"Warning siren",
+		"Draw starfield",
+		"Draw background haze",
+		"Sharp text when zoomed"
+	};
+	bool flags[Preferences::FLAG_COUNT] = {};
+	
 	const vector<double> ZOOMS = {.25, .35, .50, .70, 1.00, 1.40, 2.00};
 	int zoomIndex = 4;
+	const vector<double> RENDER_SCALES = {1., .75, .5, 0.};
+	int renderScaleIndex = 0;
 	const double VOLUME_SCALE = .25;
 }
 
@@ -71,9 +98,14 @@ void Preferences::Load()
 			scrollSpeed = node.Value(1);
 		else if(node.Token(0) == "view zoom")
 			zoomIndex = node.Value(1);
+		else if(node.Token(0) == "render scale" && node.Size() >= 2)
+			renderScaleIndex = max(0, min<int>(RENDER_SCALES.size() - 1, node.Value(1)));
 		else
 			settings[node.Token(0)] = (node.Size() == 1 || node.Value(1));
 	}
+	
+	for(int i = 0; i < FLAG_COUNT; ++i)
+		flags[i] = Has(FLAG_NAMES[i]);
 }
 
 
@@ -87,6 +119,7 @@ void Preferences::Save()
 	out.Write("zoom", Screen::UserZoom());
 	out.Write("scroll speed", scrollSpeed);
 	out.Write("view zoom", zoomIndex);
+	out.Write("render scale", renderScaleIndex);
 	
 	for(const auto &it : settings)
 		out.Write(it.first, it.second);
@@ -102,9 +135,19 @@ bool Preferences::Has(const string &name)
 
 
 
+bool Preferences::Has(Flag flag)
+{
+	return flags[flag];
+}
+
+
+
 void Preferences::Set(const string &name, bool on)
 {
 	settings[name] = on;
+	for(int i = 0; i < FLAG_COUNT; ++i)
+		if(name == FLAG_NAMES[i])
+			flags[i] = on;
 }
 
 
@@ -168,3 +211,26 @@ bool Preferences::ZoomViewOut()
 	--zoomIndex;
 	return true;
 }
+
+
+
+// Render scale.
+double Preferences::RenderScale()
+{
+	return RENDER_SCALES[renderScaleIndex];
+}
+
+
+
+void Preferences::ToggleRenderScale()
+{
+	renderScaleIndex = (renderScaleIndex + 1) % RENDER_SCALES.size();
+}
+
+
+
+string Preferences::RenderScaleSetting()
+{
+	double scale = RenderScale();
+	return scale ? to_string(lround(100. * scale)) + "%" : "adaptive";
+}
@@ -18,11 +18,40 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 
 class Preferences {
+public:
+	// Settings that are checked so often (e.g. for every ship in every step)
+	// that it would be slow to look them up by name. Each one mirrors the
+	// setting with the corresponding name, and is kept up to date by Load()
+	// and Set().
+	enum Flag : int {
+		AUTOMATIC_AIMING,
+		AUTOMATIC_FIRING,
+		TURRETS_FOCUS_FIRE,
+		DAMAGED_FIGHTERS_RETREAT,
+		REPAIR_FIGHTERS_IN,
+		RENDER_MOTION_BLUR,
+		HIGHLIGHT_FLAGSHIP,
+		SHOW_PLANET_LABELS,
+		ROTATE_FLAGSHIP_IN_HUD,
+		SHOW_LOAD,
+		SHOW_MINI_MAP,
+		SHOW_HYPERSPACE_FLASH,
+		SHOW_STATUS_OVERLAYS,
+		DISABLE_VIEWPORT_ON_RADAR,
+		WARNING_SIREN,
+		DRAW_STARFIELD,
+		DRAW_BACKGROUND_HAZE,
+		SHARP_TEXT,
+		FLAG_COUNT
+	};
+	
+	
 public:
 	static void Load();
 	static void Save();
 	
 	static bool Has(const std::string &name);
+	static bool Has(Flag flag);
 	static void Set(const std::string &name, bool on = true);
 	
 	// Toogle the ammo usage preferences, cycling between "never," "frugally,"
@@ -38,6 +67,12 @@ public:
 	static double ViewZoom();
 	static bool ZoomViewIn();
 	static bool ZoomViewOut();
+	
+	// Render scale: the fraction of the full resolution that the space scene is
+	// drawn at, or zero if it should be adjusted to keep up the frame rate.
+	static double RenderScale();
+	static void ToggleRenderScale();
+	static std::string RenderScaleSetting();
 };
 
 
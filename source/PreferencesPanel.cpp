@@ -52,6 +52,7 @@ namespace {
 	const string REACTIVATE_HELP = "Reactivate first-time help";
 	const string SCROLL_SPEED = "Scroll speed";
 	const string FIGHTER_REPAIR = "Repair fighters in";
+	const string RENDER_SCALE = "Render scale";
 }
 
 
@@ -176,6 +177,8 @@ bool PreferencesPanel::Click(int x, int y, int clicks)
 				for(const auto &it : GameData::HelpTemplates())
 					Preferences::Set("help: " + it.first, false);
 			}
+			else if(zone.Value() == RENDER_SCALE)
+				Preferences::ToggleRenderScale();
 			else if(zone.Value() == SCROLL_SPEED)
 			{
 				// Toogle between three different speeds.
@@ -425,6 +428,7 @@ void PreferencesPanel::DrawSettings()
 		"Rotate flagship in HUD",
 		"Show planet labels",
 		"Show mini-map",
+		"Sharp text when zoomed",
 		"",
 		"AI",
 		"Automatic aiming",
@@ -437,6 +441,8 @@ void PreferencesPanel::DrawSettings()
 		"Show CPU / GPU load",
 		"Render motion blur",
 		"Reduce large graphics",
+		RENDER_SCALE,
+		"Precise frame pacing",
 		"Draw background haze",
 		"Draw starfield",
 		"Show hyperspace flash",
@@ -533,6 +539,11 @@ void PreferencesPanel::DrawSettings()
 				text = "done";
 			}
 		}
+		else if(setting == RENDER_SCALE)
+		{
+			isOn = true;
+			text = Preferences::RenderScaleSetting();
+		}
 		else if(setting == SCROLL_SPEED)
 		{
 			isOn = true;
@@ -0,0 +1,148 @@
+/* Profiler.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Profiler.h"
+
+#include "Files.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+
+Profiler::Profiler(const vector<string> &names, size_t window)
+	: names(names), window(max<size_t>(1, window)), current(names.size()),
+	times(names.size(), 0.), samples(names.size()), stats(names.size())
+{
+	for(vector<double> &list : samples)
+		list.reserve(this->window);
+}
+
+
+
+Profiler::~Profiler()
+{
+	if(csv)
+		fclose(csv);
+}
+
+
+
+// Change how many steps are gathered before the statistics are updated.
+// This discards any samples that have been gathered so far.
+void Profiler::SetWindow(size_t steps)
+{
+	window = max<size_t>(1, steps);
+	for(vector<double> &list : samples)
+	{
+		list.clear();
+		list.reserve(window);
+	}
+}
+
+
+
+// Write the time of each phase in every step to the given CSV file.
+void Profiler::OpenCSV(const string &path)
+{
+	if(csv)
+		fclose(csv);
+	csv = Files::Open(path, true);
+	if(!csv)
+	{
+		Files::LogError("Unable to open \"" + path + "\" for writing.");
+		return;
+	}
+	
+	string header;
+	for(const string &name : names)
+		header += (header.empty() ? "" : ",") + name;
+	Files::Write(csv, header + '\n');
+}
+
+
+
+// End the current phase, if any, and begin timing the given one.
+void Profiler::Start(size_t phase)
+{
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	if(current < times.size())
+		times[current] += chrono::duration<double, milli>(now - begin).count();
+	
+	current = phase;
+	begin = now;
+}
+
+
+
+// Add a time that was measured some other way, in milliseconds, to the given
+// phase of the current step.
+void Profiler::Add(size_t phase, double time)
+{
+	times[phase] += time;
+}
+
+
+
+// End the current phase, and finish recording this step.
+void Profiler::Finish()
+{
+	Start(names.size());
+	
+	string row;
+	for(size_t i = 0; i < times.size(); ++i)
+	{
+		samples[i].push_back(times[i]);
+		if(csv)
+			row += (i ? "," : "") + to_string(times[i]);
+		times[i] = 0.;
+	}
+	if(csv)
+		Files::Write(csv, row + '\n');
+	
+	if(samples.empty() || samples.front().size() < window)
+		return;
+	
+	// This window is complete. Update the statistics for each phase.
+	for(size_t i = 0; i < samples.size(); ++i)
+	{
+		vector<double> &list = samples[i];
+		sort(list.begin(), list.end());
+		double total = 0.;
+		for(double time : list)
+			total += time;
+		
+		stats[i].mean = total / list.size();
+		stats[i].median = list[list.size() / 2];
+		stats[i].high = list[(list.size() * 95) / 100];
+		stats[i].max = list.back();
+		list.clear();
+	}
+}
+
+
+
+// Get the names of the phases.
+const vector<string> &Profiler::Names() const
+{
+	return names;
+}
+
+
+
+// Get the statistics for the given phase over the most recent window. The
+// "high" value is the 95th percentile.
+const Profiler::Stats &Profiler::GetStats(size_t phase) const
+{
+	return stats[phase];
+}
@@ -0,0 +1,89 @@
+/* Profiler.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+
+// Class for measuring how long each phase of a repeated calculation takes. The
+// phases of one step are timed one after another: starting one phase ends the
+// previous one. The samples are collected into windows of a certain number of
+// steps, and at the end of each window the statistics for it are updated. That
+// way the statistics can be read (e.g. for display) while the next window is
+// being collected. Optionally, every step's times can also be written out to a
+// CSV file.
+class Profiler {
+public:
+	// Statistics for one phase over one window of steps, in milliseconds.
+	class Stats {
+	public:
+		double mean = 0.;
+		double median = 0.;
+		double high = 0.;
+		double max = 0.;
+	};
+	
+	
+public:
+	explicit Profiler(const std::vector<std::string> &names, size_t window = 60);
+	~Profiler();
+	
+	Profiler(const Profiler &) = delete;
+	Profiler &operator=(const Profiler &) = delete;
+	
+	// Change how many steps are gathered before the statistics are updated.
+	// This discards any samples that have been gathered so far.
+	void SetWindow(size_t steps);
+	// Write the time of each phase in every step to the given CSV file.
+	void OpenCSV(const std::string &path);
+	
+	// End the current phase, if any, and begin timing the given one.
+	void Start(size_t phase);
+	// Add a time that was measured some other way, in milliseconds, to the
+	// given phase of the current step.
+	void Add(size_t phase, double time);
+	// End the current phase, and finish recording this step.
+	void Finish();
+	
+	// Get the names of the phases.
+	const std::vector<std::string> &Names() const;
+	// Get the statistics for the given phase over the most recent window. The
+	// "high" value is the 95th percentile.
+	const Stats &GetStats(size_t phase) const;
+	
+	
+private:
+	std::vector<std::string> names;
+	size_t window;
+	
+	// The phase that is currently being timed, and when it began.
+	size_t current;
+	std::chrono::steady_clock::time_point begin;
+	// The time spent in each phase during the current step.
+	std::vector<double> times;
+	// All the samples in the current window, one list per phase.
+	std::vector<std::vector<double>> samples;
+	std::vector<Stats> stats;
+	
+	FILE *csv = nullptr;
+};
+
+
+
+#endif
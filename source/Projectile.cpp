@@ -37,15 +37,18 @@ namespace {
 
 Projectile::Projectile(const Ship &parent, Point position, Angle angle, const Weapon *weapon)
 	: Body(weapon->WeaponSprite(), position, parent.Velocity(), angle),
-	weapon(weapon), targetShip(parent.GetTargetShip()), lifetime(weapon->Lifetime())
+	weapon(weapon), lifetime(weapon->Lifetime())
 {
 	government = parent.GetGovernment();
 	
-	// If you are boarding your target, do not fire on it.
-	if(parent.IsBoarding() || parent.Commands().Has(Command::BOARD))
-		targetShip.reset();
-	
-	cachedTarget = TargetPtr().get();
+	// If you are boarding your target, do not fire on it. Otherwise, lock the
+	// parent's target just once, both to copy it and to cache it.
+	if(!parent.IsBoarding() && !parent.Commands().Has(Command::BOARD))
+	{
+		shared_ptr<Ship> target = parent.GetTargetShip();
+		targetShip = target;
+		cachedTarget = target.get();
+	}
 	if(cachedTarget)
 		targetGovernment = cachedTarget->GetGovernment();
 	double inaccuracy = weapon->Inaccuracy();
@@ -68,7 +71,10 @@ Projectile::Projectile(const Projectile &parent, const Weapon *weapon)
 	government = parent.government;
 	targetGovernment = parent.targetGovernment;
 	
-	cachedTarget = TargetPtr().get();
+	// The parent's cached target is valid as long as its weak pointer has not
+	// expired, so there is no need to lock the weak pointer to get it.
+	if(!targetShip.expired())
+		cachedTarget = parent.cachedTarget;
 	double inaccuracy = weapon->Inaccuracy();
 	if(inaccuracy)
 	{
@@ -123,11 +129,15 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 			visuals.emplace_back(*it.first, position, velocity, angle);
 	
 	// If the target has left the system, stop following it. Also stop if the
-	// target has been captured by a different government.
+	// target has been captured by a different government. The cached pointer
+	// is only valid as long as the weak pointer has not expired, but checking
+	// that does not need to lock the weak pointer (which bumps the ship's
+	// reference count on every step of every homing projectile).
 	const Ship *target = cachedTarget;
 	if(target)
 	{
-		target = TargetPtr().get();
+		if(targetShip.expired())
+			target = nullptr;
 		if(!target || !target->IsTargetable() || target->GetGovernment() != targetGovernment)
 		{
 			targetShip.reset();
@@ -136,6 +146,24 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 		}
 	}
 	
+	// Most projectiles fly in a straight line at a constant velocity, so only
+	// do the homing and acceleration calculations for those that need them.
+	if(weapon->IsGuided())
+		Steer(target);
+	
+	position += velocity;
+	
+	// If this projectile is now within its "split range," it should split into
+	// sub-munitions next turn.
+	if(target && (position - target->Position()).Length() < weapon->SplitRange() && !Random::Int(10))
+		lifetime = 0;
+}
+
+
+
+// Turn and accelerate this projectile, tracking its target if it is homing.
+void Projectile::Steer(const Ship *target)
+{
 	double turn = weapon->Turn();
 	double accel = weapon->Acceleration();
 	int homing = weapon->Homing();
@@ -211,13 +239,6 @@ void Projectile::Move(vector<Visual> &visuals, vector<Projectile> &projectiles)
 		velocity *= 1. - weapon->Drag();
 		velocity += accel * angle.Unit();
 	}
-	
-	position += velocity;
-	
-	// If this projectile is now within its "split range," it should split into
-	// sub-munitions next turn.
-	if(target && (position - target->Position()).Length() < weapon->SplitRange() && !Random::Int(10))
-		lifetime = 0;
 }
 
 
@@ -315,7 +336,7 @@ void Projectile::CheckLock(const Ship &target)
 	// Jamming of 1 is enough to increase your chance of dodging to 50%.
 	if(weapon->RadarTracking())
 	{
-		double probability = weapon->RadarTracking() / (1. + target.Attributes().Get("radar jamming"));
+		double probability = weapon->RadarTracking() / (1. + target.Attributes().Get(Outfit::RADAR_JAMMING));
 		hasLock |= Check(probability, base);
 	}
 }
@@ -76,6 +76,8 @@ public:
 	
 private:
 	void CheckLock(const Ship &target);
+	// Turn and accelerate this projectile, tracking its target if it is homing.
+	void Steer(const Ship *target);
 	
 	
 private:
@@ -17,10 +17,19 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "PointerShader.h"
 #include "RingShader.h"
 
+#include <algorithm>
 #include <cmath>
+#include <set>
+#include <tuple>
 
 using namespace std;
 
+namespace {
+	// Dots that land within this fraction of a pixel of one another are drawn
+	// as one, if they are also the same size and color.
+	const double MERGE_DISTANCE = .5;
+}
+
 const int Radar::PLAYER = 0;
 const int Radar::FRIENDLY = 1;
 const int Radar::UNFRIENDLY = 2;
@@ -107,25 +116,39 @@ void Radar::Draw(const Point &center, double scale, double radius, double pointe
 		LineShader::Draw(start + center, start + v + center, 1.f, line.color);
 	}
 	
-	// Draw StellarObjects and ships.
-	RingShader::Bind();
-	for(const Object &object : objects)
+	// Draw StellarObjects and ships. They are all drawn at once, because even
+	// a modest battle can put hundreds of objects on the radar. Objects beyond
+	// the edge of the display are drawn on its edge, so in a dense system many
+	// of them, like a swarm of fighters, end up in the same place. Any object
+	// that is hidden by an identical one drawn after it is skipped, so they
+	// are checked from last to first.
+	using Key = tuple<long, long, double, double, float, float, float>;
+	set<Key> drawn;
+	vector<RingShader::Item> rings;
+	rings.reserve(objects.size());
+	for(auto it = objects.rbegin(); it != objects.rend(); ++it)
 	{
+		const Object &object = *it;
 		Point position = object.position * scale;
 		double length = position.Length();
 		if(length > radius)
 			position *= radius / length;
-		position += center;
 		
-		RingShader::Add(position, object.outer, object.inner, object.color);
+		const float *color = object.color.Get();
+		Key key(lround(position.X() / MERGE_DISTANCE), lround(position.Y() / MERGE_DISTANCE),
+			object.outer, object.inner, color[0], color[1], color[2]);
+		if(drawn.insert(key).second)
+			rings.emplace_back(position + center, object.outer, object.inner, object.color);
 	}
-	RingShader::Unbind();
+	reverse(rings.begin(), rings.end());
+	RingShader::Draw(rings);
 	
 	// Draw neighboring system indicators.
-	PointerShader::Bind();
+	vector<PointerShader::Item> indicators;
+	indicators.reserve(pointers.size());
 	for(const Pointer &pointer : pointers)
-		PointerShader::Add(center, pointer.unit, 10.f, 10.f, pointerRadius, pointer.color);
-	PointerShader::Unbind();
+		indicators.emplace_back(center, pointer.unit, 10.f, 10.f, pointerRadius, pointer.color);
+	PointerShader::Draw(indicators);
 }
 
 
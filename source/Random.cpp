@@ -12,68 +12,133 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Random.h"
 
+#include <atomic>
 #include <random>
 
-#ifndef __linux__
-#include <mutex>
-#endif
-
 using namespace std;
 
-// Right now thread_local storage is only supported under Linux.
+// The generator is SplitMix64: each number is a hash of a counter that goes up
+// by a fixed increment for every number drawn. That makes it very cheap, and
+// means its whole state fits in a single 64-bit integer, so a Stream can start
+// a whole new sequence just by hashing its keys into that integer.
 namespace {
-#ifndef __linux__
-	mutex workaroundMutex;
-	mt19937_64 gen;
-	uniform_int_distribution<uint32_t> uniform;
-	uniform_real_distribution<double> real;
-#else
-	thread_local mt19937_64 gen;
-	thread_local uniform_int_distribution<uint32_t> uniform;
-	thread_local uniform_real_distribution<double> real;
-#endif
+	const uint64_t INCREMENT = 0x9E3779B97F4A7C15ull;
+	
+	// Scramble the bits of the given counter value.
+	uint64_t Mix(uint64_t z)
+	{
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+	
+	// The seed that every Stream is derived from. Until something seeds the
+	// generator, it is different every time the game is run.
+	atomic<uint64_t> seed(Mix(random_device()()));
+	// The hash of the Streams that have ended, for each purpose. Each one is a
+	// sum, so that the order in which they end does not matter.
+	const uint64_t PURPOSES = 16;
+	atomic<uint64_t> streamHash[PURPOSES];
+	
+	// Each thread starts at a different, scrambled point in the sequence, so
+	// that the worker threads do not all draw the same numbers. Which thread
+	// gets which starting point depends on the order in which they first draw
+	// a number, so anything that must be reproducible either uses a Stream or
+	// is handed a state with Random::SetState().
+	atomic<uint64_t> threadCount(0);
+	thread_local uint64_t state = Mix(++threadCount);
+	
+	// Get the next 64 random bits.
+	uint64_t Next()
+	{
+		return Mix(state += INCREMENT);
+	}
+	
+	// Adapter so that the standard library's distributions can draw from the
+	// generator.
+	class Generator {
+	public:
+		using result_type = uint64_t;
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return ~static_cast<result_type>(0); }
+		result_type operator()() { return Next(); }
+	};
+}
+
+
+
+Random::Stream::Stream(uint64_t purpose, uint64_t step, uint64_t index)
+	: purpose(purpose), key(Mix(Mix(Mix(seed.load(memory_order_relaxed) ^ purpose) + step) + index)),
+	previous(state)
+{
+	state = key;
+}
+
+
+
+Random::Stream::~Stream()
+{
+	streamHash[purpose % PURPOSES].fetch_add(Mix(key ^ Mix(state)), memory_order_relaxed);
+	state = previous;
 }
 
 
 
 // Seed the generator (e.g. to make it produce exactly the same random
 // numbers it produced previously).
-void Random::Seed(uint64_t seed)
+void Random::Seed(uint64_t value)
+{
+	seed = value;
+	state = value;
+}
+
+
+
+// Get the generator's current state in this thread.
+uint64_t Random::State()
+{
+	return state;
+}
+
+
+
+// Set the generator's current state in this thread.
+void Random::SetState(uint64_t value)
+{
+	state = value;
+}
+
+
+
+// Get a hash of the keys of all the Streams with the given purpose that have
+// ended since the last call, and of how far each one got.
+uint64_t Random::StreamHash(uint64_t purpose)
 {
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
-	gen.seed(seed);
+	return streamHash[purpose % PURPOSES].exchange(0, memory_order_relaxed);
 }
 
 
 
 uint32_t Random::Int()
 {
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
-	return uniform(gen);
+	return Next() >> 32;
 }
 
 
 
 uint32_t Random::Int(uint32_t modulus)
 {
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
-	return uniform(gen) % modulus;
+	// Scale the random bits to the range instead of taking their remainder,
+	// which avoids a division.
+	return ((Next() >> 32) * modulus) >> 32;
 }
 
 
 
 double Random::Real()
 {
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
-	return real(gen);
+	// Use the top 53 bits, so every result is exactly representable in [0, 1).
+	return (Next() >> 11) * (1. / 9007199254740992.);
 }
 
 
@@ -83,9 +148,7 @@ double Random::Real()
 uint32_t Random::Polya(uint32_t k, double p)
 {
 	negative_binomial_distribution<uint32_t> polya(k, p);
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
+	Generator gen;
 	return polya(gen);
 }
 
@@ -95,9 +158,7 @@ uint32_t Random::Polya(uint32_t k, double p)
 uint32_t Random::Binomial(uint32_t t, double p)
 {
 	binomial_distribution<uint32_t> binomial(t, p);
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
+	Generator gen;
 	return binomial(gen);
 }
 
@@ -107,8 +168,6 @@ uint32_t Random::Binomial(uint32_t t, double p)
 double Random::Normal()
 {
 	normal_distribution<double> normal;
-#ifndef __linux__
-	lock_guard<mutex> lock(workaroundMutex);
-#endif
+	Generator gen;
 	return normal(gen);
 }
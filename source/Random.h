@@ -18,13 +18,47 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 
 // Collection of functions for generating random numbers with a variety of
-// different distributions. (This is done partly because on some systems the
-// random number generation is not thread-safe.)
+// different distributions. These can be called from any thread without
+// locking. (This is done partly because on some systems the standard random
+// number generation is not thread-safe.)
 class Random {
+public:
+	// While one of these exists, the random numbers that the thread that made
+	// it draws come from a separate sequence, which depends only on the seed
+	// and on the given keys (e.g. what is being done, the step, and the index
+	// of the object it is being done to). Work that is split up between several
+	// threads uses this to draw the same numbers no matter which thread does
+	// which part of it. When it goes away, the thread's own sequence resumes.
+	class Stream {
+	public:
+		Stream(uint64_t purpose, uint64_t step, uint64_t index);
+		~Stream();
+		
+		Stream(const Stream &) = delete;
+		Stream &operator=(const Stream &) = delete;
+		
+	private:
+		uint64_t purpose;
+		uint64_t key;
+		uint64_t previous;
+	};
+	
+	
 public:
 	// Seed the generator (e.g. to make it produce exactly the same random
-	// numbers it produced previously).
+	// numbers it produced previously). This seeds the calling thread and every
+	// Stream, but not any other thread's own sequence.
 	static void Seed(uint64_t seed);
+	// Get or set the generator's current state in this thread, e.g. to check
+	// that two runs drew exactly the same random numbers, or to have another
+	// thread carry on with this thread's sequence.
+	static uint64_t State();
+	static void SetState(uint64_t state);
+	// Get a hash of the keys of all the Streams with the given purpose that
+	// have ended since the last call, and of how far each one got. It does not
+	// depend on which threads they were used on, or in what order. Only the
+	// lowest few bits of the purpose are used to tell them apart.
+	static uint64_t StreamHash(uint64_t purpose);
 	
 	static uint32_t Int();
 	static uint32_t Int(uint32_t modulus);
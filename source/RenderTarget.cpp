@@ -0,0 +1,149 @@
+/* RenderTarget.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "RenderTarget.h"
+
+#include "Screen.h"
+#include "SpriteShader.h"
+
+#include "gl_header.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+	// Get the dimensions of the current viewport, in pixels.
+	void GetViewport(int &width, int &height)
+	{
+		GLint viewport[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		width = viewport[2];
+		height = viewport[3];
+	}
+}
+
+
+
+// Check if this target holds an image that matches the current viewport.
+bool RenderTarget::IsCurrent() const
+{
+	if(!isValid)
+		return false;
+	
+	int currentWidth, currentHeight;
+	GetViewport(currentWidth, currentHeight);
+	return (currentWidth == width && currentHeight == height);
+}
+
+
+
+// Redirect all drawing into this target, which is resized to match the
+// viewport (times the given scale) if necessary and then cleared to
+// transparent. If offscreen drawing is not possible, this returns false and
+// nothing is changed.
+bool RenderTarget::Begin(double scale)
+{
+	GetViewport(viewWidth, viewHeight);
+	int targetWidth = max(1, static_cast<int>(viewWidth * scale + .5));
+	int targetHeight = max(1, static_cast<int>(viewHeight * scale + .5));
+	if(viewWidth <= 0 || viewHeight <= 0)
+		return false;
+	
+	if(!framebuffer)
+	{
+		glGenFramebuffers(1, &framebuffer);
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	
+	GLint bound = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+	previous = bound;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	
+	// Reallocate the texture whenever the window or the scale changes. If it
+	// is not the same size as the screen, it must be filtered when it is drawn.
+	if(targetWidth != width || targetHeight != height)
+	{
+		width = targetWidth;
+		height = targetHeight;
+		GLint filter = (width == viewWidth && height == viewHeight) ? GL_NEAREST : GL_LINEAR;
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, 1,
+			0, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture, 0, 0);
+	}
+	
+	isValid = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	if(!isValid)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, previous);
+		return false;
+	}
+	
+	// Everything is drawn with premultiplied alpha, so drawing into a fully
+	// transparent texture and then drawing that texture onto the screen gives
+	// the same result as drawing directly onto the screen.
+	GLfloat clearColor[4];
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+	
+	// Everything is positioned relative to the viewport, so drawing into a
+	// smaller viewport just draws everything smaller.
+	if(width != viewWidth || height != viewHeight)
+		glViewport(0, 0, width, height);
+	
+	return true;
+}
+
+
+
+// Go back to drawing on the screen.
+void RenderTarget::End()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, previous);
+	if(width != viewWidth || height != viewHeight)
+		glViewport(0, 0, viewWidth, viewHeight);
+}
+
+
+
+// Draw the contents of this target onto the screen, optionally faded by the
+// given alpha.
+void RenderTarget::Draw(float alpha) const
+{
+	if(!isValid)
+		return;
+	
+	// The texture covers the whole screen. Its rows are stored from the bottom
+	// up, so it must be flipped vertically.
+	SpriteShader::Item item;
+	item.texture = texture;
+	item.transform[0] = Screen::Width();
+	item.transform[3] = -Screen::Height();
+	item.alpha = alpha;
+	
+	SpriteShader::Bind();
+	SpriteShader::Add(item);
+	SpriteShader::Unbind();
+}
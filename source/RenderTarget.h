@@ -0,0 +1,60 @@
+/* RenderTarget.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef RENDER_TARGET_H_
+#define RENDER_TARGET_H_
+
+#include <cstdint>
+
+
+
+// Class representing an offscreen texture the same size as the screen. Anything
+// that is expensive to draw but rarely changes can be drawn into it once, and
+// then copied onto the screen each frame with a single draw call. The texture
+// is a single-layer array texture, so that it can be drawn by the SpriteShader.
+// It can also be smaller than the screen, so that something which is expensive
+// to draw every frame can be drawn at a lower resolution and then scaled up.
+class RenderTarget {
+public:
+	// Check if this target holds an image that matches the current viewport.
+	bool IsCurrent() const;
+	
+	// Redirect all drawing into this target, which is resized to match the
+	// viewport (times the given scale) if necessary and then cleared to
+	// transparent. If offscreen drawing is not possible, this returns false
+	// and nothing is changed.
+	bool Begin(double scale = 1.);
+	// Go back to drawing on the screen.
+	void End();
+	
+	// Draw the contents of this target onto the screen, optionally faded by the
+	// given alpha.
+	void Draw(float alpha = 1.f) const;
+	
+	
+private:
+	uint32_t framebuffer = 0;
+	uint32_t texture = 0;
+	int width = 0;
+	int height = 0;
+	// The size of the viewport when Begin() was called, which is restored by
+	// End() if this target is a different size.
+	int viewWidth = 0;
+	int viewHeight = 0;
+	// Remember which framebuffer was bound when Begin() was called.
+	int previous = 0;
+	bool isValid = false;
+};
+
+
+
+#endif
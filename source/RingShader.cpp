@@ -13,11 +13,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "RingShader.h"
 
 #include "Color.h"
+#include "GameWindow.h"
 #include "pi.h"
 #include "Point.h"
 #include "Screen.h"
 #include "Shader.h"
+#include "StreamBuffer.h"
 
+#include <cstddef>
 #include <stdexcept>
 
 using namespace std;
@@ -35,6 +38,32 @@ namespace {
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// The instanced version of the shader reads each ring's parameters from a
+	// vertex buffer instead of from uniforms.
+	Shader instancedShader;
+	GLint instancedScaleI;
+	GLint instancedOffsetI;
+	GLint itemPositionI;
+	GLint itemSizeI;
+	GLint itemArcI;
+	GLint itemColorI;
+	
+	GLuint instancedVao;
+	
+	void SetUniforms(const RingShader::Item &item, const Point &offset = Point())
+	{
+		GLfloat position[2] = {
+			static_cast<float>(item.position[0] + offset.X()),
+			static_cast<float>(item.position[1] + offset.Y())};
+		glUniform2fv(positionI, 1, position);
+		glUniform1f(radiusI, item.radius);
+		glUniform1f(widthI, item.width);
+		glUniform1f(angleI, item.angle);
+		glUniform1f(startAngleI, item.startAngle);
+		glUniform1f(dashI, item.dash);
+		glUniform4fv(colorI, 1, item.color);
+	}
 }
 
 
@@ -55,13 +84,17 @@ void RingShader::Init()
 		"  gl_Position = vec4((coord + position) * scale, 0, 1);\n"
 		"}\n";
 
-	static const char *fragmentCode =
+	// The fragment shader is the same whether its inputs are uniforms or are
+	// passed in for each instance by the instanced vertex shader.
+	static const char *fragmentUniforms =
 		"uniform vec4 color = vec4(1, 1, 1, 1);\n"
 		"uniform float radius;\n"
 		"uniform float width;\n"
 		"uniform float angle;\n"
 		"uniform float startAngle;\n"
-		"uniform float dash;\n"
+		"uniform float dash;\n";
+	
+	static const char *fragmentCode =
 		"const float pi = 3.1415926535897932384626433832795;\n"
 		
 		"in vec2 coord;\n"
@@ -81,7 +114,7 @@ void RingShader::Init()
 		"  finalColor = color * alpha;\n"
 		"}\n";
 	
-	shader = Shader(vertexCode, fragmentCode);
+	shader = Shader(vertexCode, (fragmentUniforms + string(fragmentCode)).c_str());
 	scaleI = shader.Uniform("scale");
 	positionI = shader.Uniform("position");
 	radiusI = shader.Uniform("radius");
@@ -112,6 +145,91 @@ void RingShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	static const char *instancedVertexCode =
+		"uniform vec2 scale;\n"
+		"uniform vec2 offset;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 itemPosition;\n"
+		"in vec2 itemSize;\n"
+		"in vec3 itemArc;\n"
+		"in vec4 itemColor;\n"
+		
+		"out vec2 coord;\n"
+		"flat out vec4 color;\n"
+		"flat out float radius;\n"
+		"flat out float width;\n"
+		"flat out float angle;\n"
+		"flat out float startAngle;\n"
+		"flat out float dash;\n"
+		
+		"void main() {\n"
+		"  coord = (itemSize.x + itemSize.y) * vert;\n"
+		"  gl_Position = vec4((coord + itemPosition + offset) * scale, 0, 1);\n"
+		"  color = itemColor;\n"
+		"  radius = itemSize.x;\n"
+		"  width = itemSize.y;\n"
+		"  angle = itemArc.x;\n"
+		"  startAngle = itemArc.y;\n"
+		"  dash = itemArc.z;\n"
+		"}\n";
+	
+	static const char *fragmentInputs =
+		"flat in vec4 color;\n"
+		"flat in float radius;\n"
+		"flat in float width;\n"
+		"flat in float angle;\n"
+		"flat in float startAngle;\n"
+		"flat in float dash;\n";
+	
+	instancedShader = Shader(instancedVertexCode, (fragmentInputs + string(fragmentCode)).c_str());
+	instancedScaleI = instancedShader.Uniform("scale");
+	instancedOffsetI = instancedShader.Uniform("offset");
+	itemPositionI = instancedShader.Attrib("itemPosition");
+	itemSizeI = instancedShader.Attrib("itemSize");
+	itemArcI = instancedShader.Attrib("itemArc");
+	itemColorI = instancedShader.Attrib("itemColor");
+	
+	glGenVertexArrays(1, &instancedVao);
+	glBindVertexArray(instancedVao);
+	
+	// The corners of the quad come from the same buffer as above. Everything
+	// else comes from the StreamBuffer, once per ring.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GLint vertI = instancedShader.Attrib("vert");
+	glEnableVertexAttribArray(vertI);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	for(GLint attrib : {itemPositionI, itemSizeI, itemArcI, itemColorI})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+}
+
+
+
+RingShader::Item::Item(const Point &pos, float out, float in, const Color &color)
+	: Item(pos, out - .5f * (1.f + out - in), .5f * (1.f + out - in), 1.f, color)
+{
+}
+
+
+
+RingShader::Item::Item(const Point &pos, float radius, float width, float fraction, const Color &color, float dash, float startAngle)
+	: position{static_cast<float>(pos.X()), static_cast<float>(pos.Y())},
+	radius(radius), width(width), angle(fraction * 2. * PI), startAngle(startAngle * TO_RAD),
+	dash(dash ? 2. * PI / dash : 0.)
+{
+	const float *source = color.Get();
+	for(int i = 0; i < 4; ++i)
+		this->color[i] = source[i];
 }
 
 
@@ -159,16 +277,7 @@ void RingShader::Add(const Point &pos, float out, float in, const Color &color)
 
 void RingShader::Add(const Point &pos, float radius, float width, float fraction, const Color &color, float dash, float startAngle)
 {
-	GLfloat position[2] = {static_cast<float>(pos.X()), static_cast<float>(pos.Y())};
-	glUniform2fv(positionI, 1, position);
-	
-	glUniform1f(radiusI, radius);
-	glUniform1f(widthI, width);
-	glUniform1f(angleI, fraction * 2. * PI);
-	glUniform1f(startAngleI, startAngle * TO_RAD);
-	glUniform1f(dashI, dash ? 2. * PI / dash : 0.);
-	
-	glUniform4fv(colorI, 1, color.Get());
+	SetUniforms(Item(pos, radius, width, fraction, color, dash, startAngle));
 	
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
@@ -180,3 +289,55 @@ void RingShader::Unbind()
 	glBindVertexArray(0);
 	glUseProgram(0);
 }
+
+
+
+// Draw all the given rings, optionally moved by the given offset. If the
+// graphics card supports instancing this is a single draw call; otherwise,
+// each ring is drawn separately.
+void RingShader::Draw(const vector<Item> &items)
+{
+	Draw(items, Point());
+}
+
+
+
+void RingShader::Draw(const vector<Item> &items, const Point &offset)
+{
+	if(items.empty())
+		return;
+	
+	if(!GameWindow::HasInstancing())
+	{
+		Bind();
+		for(const Item &item : items)
+		{
+			SetUniforms(item, offset);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+		Unbind();
+		return;
+	}
+	
+	glUseProgram(instancedShader.Object());
+	glBindVertexArray(instancedVao);
+	
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	glUniform2fv(instancedScaleI, 1, scale);
+	GLfloat translate[2] = {static_cast<float>(offset.X()), static_cast<float>(offset.Y())};
+	glUniform2fv(instancedOffsetI, 1, translate);
+	
+	// The items are uploaded exactly as they are stored.
+	const char *base = reinterpret_cast<const char *>(
+		StreamBuffer::Upload(items.data(), sizeof(Item) * items.size()));
+	const GLsizei stride = sizeof(Item);
+	glVertexAttribPointer(itemPositionI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, position));
+	glVertexAttribPointer(itemSizeI, 2, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, radius));
+	glVertexAttribPointer(itemArcI, 3, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, angle));
+	glVertexAttribPointer(itemColorI, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(Item, color));
+	
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, items.size());
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	Unbind();
+}
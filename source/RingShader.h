@@ -13,6 +13,8 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef RING_SHADER_H_
 #define RING_SHADER_H_
 
+#include <vector>
+
 class Color;
 class Point;
 
@@ -21,6 +23,25 @@ class Point;
 // Class representing a shader that draws round "dots," either filled in or with
 // transparent centers (i.e. circles or rings).
 class RingShader {
+public:
+	// The parameters for drawing one ring, for use when drawing many at once.
+	// The values are stored the way the shader uses them, with the angles in
+	// radians and the dash as the angle between dashes.
+	class Item {
+	public:
+		Item(const Point &pos, float out, float in, const Color &color);
+		Item(const Point &pos, float radius, float width, float fraction, const Color &color, float dash = 0.f, float startAngle = 0.f);
+		
+		float position[2];
+		float radius;
+		float width;
+		float angle;
+		float startAngle;
+		float dash;
+		float color[4];
+	};
+	
+	
 public:
 	static void Init();
 	
@@ -31,6 +52,12 @@ public:
 	static void Add(const Point &pos, float out, float in, const Color &color);
 	static void Add(const Point &pos, float radius, float width, float fraction, const Color &color, float dash = 0.f, float startAngle = 0.f);
 	static void Unbind();
+	
+	// Draw all the given rings, optionally moved by the given offset. If the
+	// graphics card supports instancing this is a single draw call; otherwise,
+	// each ring is drawn separately.
+	static void Draw(const std::vector<Item> &items);
+	static void Draw(const std::vector<Item> &items, const Point &offset);
 };
 
 
@@ -16,10 +16,39 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "DataNode.h"
 #include "Date.h"
 #include "Format.h"
+#include "MappedFile.h"
 #include "SpriteSet.h"
 
+#include <algorithm>
+#include <cstring>
+
 using namespace std;
 
+namespace {
+	// Find how much of the given saved game must be parsed to get to the end of
+	// the first ship in it. Saved games list the player's account before their
+	// ships, so that is everything the load panel shows. If the file has no
+	// ships, that is all of it.
+	size_t HeaderSize(const char *data, size_t size)
+	{
+		// Check the start of each line to see whether it is a new top-level
+		// node - one with no indentation.
+		const char *end = data + size;
+		bool foundShip = false;
+		for(const char *it = static_cast<const char *>(memchr(data, '\n', size)); it && end - it >= 6;
+				it = static_cast<const char *>(memchr(it + 1, '\n', end - it - 1)))
+		{
+			char c = it[1];
+			if(c <= ' ' || c == '#')
+				continue;
+			if(foundShip)
+				return it + 1 - data;
+			foundShip = !strncmp(it + 1, "ship", 4) && it[5] <= ' ';
+		}
+		return size;
+	}
+}
+
 
 
 SavedGame::SavedGame(const string &path)
@@ -32,7 +61,19 @@ SavedGame::SavedGame(const string &path)
 void SavedGame::Load(const string &path)
 {
 	Clear();
-	DataFile file(path);
+	// Only parse the beginning of the file, unless it turns out not to contain
+	// the account (e.g. because the file was saved by an older version). That
+	// part is parsed straight from the mapped file.
+	MappedFile data(path);
+	const char *begin = data.Data();
+	size_t size = HeaderSize(begin, data.Size());
+	static const string ACCOUNT = "\naccount";
+	const char *account = search(begin, begin + size, ACCOUNT.begin(), ACCOUNT.end());
+	DataFile file;
+	if(account + ACCOUNT.size() < begin + size && account[ACCOUNT.size()] <= ' ' && begin[size - 1] == '\n')
+		file.Load(begin, begin + size);
+	else
+		file.Load(path);
 	if(file.begin() != file.end())
 		this->path = path;
 	
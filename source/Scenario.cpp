@@ -0,0 +1,146 @@
+/* Scenario.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Scenario.h"
+
+#include "DataFile.h"
+#include "DataNode.h"
+#include "Engine.h"
+#include "GameData.h"
+#include "Profiler.h"
+#include "Random.h"
+#include "Ship.h"
+#include "ShipEvent.h"
+#include "System.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Print the mean, median, 95th percentile, and maximum time of each phase.
+	void PrintTimes(const Profiler &profiler)
+	{
+		const vector<string> &names = profiler.Names();
+		for(size_t i = 0; i < names.size(); ++i)
+		{
+			const Profiler::Stats &stats = profiler.GetStats(i);
+			cout << setw(16) << left << names[i] << right
+				<< setw(10) << stats.mean
+				<< setw(10) << stats.median
+				<< setw(10) << stats.high
+				<< setw(10) << stats.max << endl;
+		}
+	}
+}
+
+
+
+// Load the scenario from the given data file.
+Scenario::Scenario(const string &path)
+{
+	// Starting a new pilot reverts the game data, which would discard anything
+	// that the NPCs refer to, so it must be done before loading them.
+	player.New();
+	
+	DataFile file(path);
+	for(const DataNode &node : file)
+	{
+		const string &key = node.Token(0);
+		bool hasValue = (node.Size() >= 2);
+		if(key == "seed" && hasValue)
+			seed = node.Value(1);
+		else if(key == "system" && hasValue)
+			system = GameData::Systems().Find(node.Token(1));
+		else if(key == "npc")
+			npcs.emplace_back(node);
+		else if(key == "command" && node.Size() >= 3)
+		{
+			Command &command = commands[node.Value(1)];
+			command.SetKeys(node.Value(2));
+			if(node.Size() >= 4)
+				command.SetTurn(node.Value(3));
+		}
+		else
+			node.PrintTrace("Skipping unrecognized attribute:");
+	}
+}
+
+
+
+// Place the ships and run the given number of engine steps as fast as
+// possible, with no drawing. Then, print the timing results. If a CSV path is
+// given, the time of each phase of every step is written to it.
+void Scenario::Run(int steps, const string &csvPath)
+{
+	// The sprites must be loaded, because collisions depend on their masks.
+	GameData::FinishLoading();
+	Random::Seed(seed);
+	
+	if(system && system != player.GetSystem())
+	{
+		// Start out in flight, because the starting planet is somewhere else.
+		player.SetSystem(system);
+		player.SetPlanet(nullptr);
+		for(const shared_ptr<Ship> &ship : player.Ships())
+		{
+			ship->SetSystem(system);
+			ship->SetPlanet(nullptr);
+		}
+	}
+	
+	Engine engine(player);
+	engine.Place();
+	map<string, string> subs;
+	list<NPC> instances;
+	for(const NPC &npc : npcs)
+		instances.push_back(npc.Instantiate(subs, player.GetSystem(), player.GetSystem()));
+	engine.Place(instances, player.FlagshipPtr());
+	engine.ReplayCommands(commands);
+	
+	// Gather statistics over the entire run, rather than a rolling window.
+	Profiler &phases = engine.GetProfiler();
+	phases.SetWindow(steps);
+	if(!csvPath.empty())
+		phases.OpenCSV(csvPath);
+	
+	// The calculation step runs in the engine's own thread, while the engine
+	// step is the part that must happen while that thread is paused.
+	Profiler total({"calculate", "step"}, steps);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for(int i = 0; i < steps; ++i)
+	{
+		total.Start(0);
+		engine.Go();
+		engine.Wait();
+		total.Start(1);
+		engine.Step(false);
+		engine.Events().clear();
+		total.Finish();
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	
+	cout << fixed << setprecision(3);
+	cout << "Ran " << steps << " steps in " << seconds << " seconds";
+	if(seconds > 0.)
+		cout << " (" << steps / seconds << " steps per second)";
+	cout << "." << endl;
+	cout << setw(16) << left << "phase (ms)" << right << setw(10) << "mean" << setw(10) << "median"
+		<< setw(10) << "95%" << setw(10) << "max" << endl;
+	PrintTimes(total);
+	PrintTimes(phases);
+}
@@ -0,0 +1,60 @@
+/* Scenario.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SCENARIO_H_
+#define SCENARIO_H_
+
+#include "Command.h"
+#include "NPC.h"
+#include "PlayerInfo.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+
+class System;
+
+
+
+// Class representing a scripted setup of ships that can be simulated without
+// opening a window, for measuring how fast the game engine runs. A scenario
+// file may contain these root nodes:
+// seed <number>: the seed for the random number generator.
+// system <name>: the system to start in, instead of the default start system.
+// npc: a block of ships to place in the system, in the same format as in a
+// mission. These are placed in addition to the player's starting ships.
+// command <step> <keys> [<turn>]: the commands to give the player in the given
+// step, as recorded by running the game with "--record <path>".
+class Scenario {
+public:
+	// Load the scenario from the given data file.
+	explicit Scenario(const std::string &path);
+	
+	// Place the ships and run the given number of engine steps as fast as
+	// possible, with no drawing. Then, print the timing results. If a CSV path is
+	// given, the time of each phase of every step is written to it.
+	void Run(int steps, const std::string &csvPath = "");
+	
+	
+private:
+	PlayerInfo player;
+	
+	uint64_t seed = 0;
+	const System *system = nullptr;
+	std::list<NPC> npcs;
+	std::map<int, Command> commands;
+};
+
+
+
+#endif
@@ -13,55 +13,153 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SET_H_
 #define SET_H_
 
+#include "Arena.h"
+
+#include <functional>
 #include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 
 
 // Template representing a set of named objects of a given type, where you can
 // query it for a pointer to any object and it will return one, whether or not that
-// object has been loaded yet. (This allows cyclic pointers.)
+// object has been loaded yet. (This allows cyclic pointers.) The objects are
+// stored in name order, but are also indexed by a hash of their names to make
+// lookups faster. Each object also has an integer ID, assigned in the order the
+// objects were first referred to, which never changes once it is assigned. The
+// objects are allocated from an arena of their own, in that same order, so that
+// they are close together in memory and do not fragment the rest of the heap.
 template<class Type>
 class Set {
+private:
+	typedef std::map<std::string, Type, std::less<std::string>,
+		ArenaAllocator<std::pair<const std::string, Type>>> Map;
+	
+	
+public:
+	// A handle to the object with the given name, for code that uses the same
+	// object over and over (e.g. in every frame). The name is only looked up
+	// the first time the handle is used, and again only if the object has been
+	// removed by Revert() since then.
+	class Ref {
+	public:
+		Ref(const Set<Type> &set, const std::string &name) : set(&set), name(name) {}
+		
+		const Type *Get() const;
+		const Type &operator*() const { return *Get(); }
+		const Type *operator->() const { return Get(); }
+		
+	private:
+		const Set<Type> *set;
+		std::string name;
+		mutable size_t id = static_cast<size_t>(-1);
+	};
+	
+	
 public:
+	Set() = default;
+	// Copying a set must rebuild the index, so that it points to the copies.
+	Set(const Set<Type> &other);
+	Set<Type> &operator=(const Set<Type> &other);
+	
 	// Allow non-const access to the owner of this set; it can hand off only
 	// const references to avoid anyone else modifying the objects.
-	Type *Get(const std::string &name) { return &data[name]; }
-	const Type *Get(const std::string &name) const { return &data[name]; }
+	Type *Get(const std::string &name) { return objects[Insert(name)]; }
+	const Type *Get(const std::string &name) const { return objects[Insert(name)]; }
 	// If an item already exists in this set, get it. Otherwise, return a null
 	// pointer rather than creating the item.
 	const Type *Find(const std::string &name) const;
 	
-	bool Has(const std::string &name) const { return data.count(name); }
+	bool Has(const std::string &name) const { return index.count(name); }
+	
+	// Get the ID of the object with the given name, creating the object if it
+	// does not exist yet. IDs start at zero and are never reused.
+	size_t Id(const std::string &name) const { return Insert(name); }
+	// Get the object with the given ID. This returns a null pointer if no object
+	// has that ID, or if the object was removed by Revert().
+	const Type *FromId(size_t id) const { return id < objects.size() ? objects[id] : nullptr; }
 	
-	typename std::map<std::string, Type>::iterator begin() { return data.begin(); }
-	typename std::map<std::string, Type>::const_iterator begin() const { return data.begin(); }
-	typename std::map<std::string, Type>::iterator end() { return data.end(); }
-	typename std::map<std::string, Type>::const_iterator end() const { return data.end(); }
+	typename Map::iterator begin() { return data.begin(); }
+	typename Map::const_iterator begin() const { return data.begin(); }
+	typename Map::iterator end() { return data.end(); }
+	typename Map::const_iterator end() const { return data.end(); }
 	
 	int size() const { return data.size(); }
 	// Remove any objects in this set that are not in the given set, and for
-	// those that are in the given set, revert to their contents.
-	void Revert(const Set<Type> &other);
+	// those that are in the given set, revert to their contents. If a list of
+	// changed objects is given, only those are reverted, and the rest must
+	// already be identical to the objects in the given set.
+	void Revert(const Set<Type> &other, const std::set<std::string> *changed = nullptr);
 	
 	
 private:
-	mutable std::map<std::string, Type> data;
+	// Get the ID of the object with the given name, creating it if necessary.
+	size_t Insert(const std::string &name) const;
+	
+	
+private:
+	// The arena must be declared first, so that it outlives the objects in it.
+	Arena arena;
+	mutable Map data{std::less<std::string>(), ArenaAllocator<std::pair<const std::string, Type>>(arena)};
+	// The ID of each object, by name, and the object that has each ID.
+	mutable std::unordered_map<std::string, size_t> index;
+	mutable std::vector<Type *> objects;
 };
 
 
 
+template <class Type>
+const Type *Set<Type>::Ref::Get() const
+{
+	const Type *object = set->FromId(id);
+	if(!object)
+	{
+		id = set->Id(name);
+		object = set->FromId(id);
+	}
+	return object;
+}
+
+
+
+template <class Type>
+Set<Type>::Set(const Set<Type> &other)
+{
+	*this = other;
+}
+
+
+
+template <class Type>
+Set<Type> &Set<Type>::operator=(const Set<Type> &other)
+{
+	if(this == &other)
+		return *this;
+	
+	data = other.data;
+	index = other.index;
+	objects.assign(other.objects.size(), nullptr);
+	for(const auto &it : index)
+		objects[it.second] = &data.find(it.first)->second;
+	return *this;
+}
+
+
+
 template <class Type>
 const Type *Set<Type>::Find(const std::string &name) const
 {
-	auto it = data.find(name);
-	return (it == data.end() ? nullptr : &it->second);
+	auto it = index.find(name);
+	return (it == index.end() ? nullptr : objects[it->second]);
 }
 
 
 
 template <class Type>
-void Set<Type>::Revert(const Set<Type> &other)
+void Set<Type>::Revert(const Set<Type> &other, const std::set<std::string> *changed)
 {
 	auto it = data.begin();
 	auto oit = other.data.begin();
@@ -69,12 +167,19 @@ void Set<Type>::Revert(const Set<Type> &other)
 	while(it != data.end())
 	{
 		if(oit == other.data.end() || it->first < oit->first)
+		{
+			// The ID of a removed object is not given to any other object.
+			auto iit = index.find(it->first);
+			objects[iit->second] = nullptr;
+			index.erase(iit);
 			it = data.erase(it);
+		}
 		else if(it->first == oit->first)
 		{
 			// If this is an entry that is in the set we are reverting to, copy
 			// the state we are reverting to.
-			it->second = oit->second;
+			if(!changed || changed->count(it->first))
+				it->second = oit->second;
 			++it;
 			++oit;
 		}
@@ -86,4 +191,19 @@ void Set<Type>::Revert(const Set<Type> &other)
 
 
 
+
+template <class Type>
+size_t Set<Type>::Insert(const std::string &name) const
+{
+	auto it = index.find(name);
+	if(it != index.end())
+		return it->second;
+	
+	index.emplace(name, objects.size());
+	objects.push_back(&data[name]);
+	return objects.size() - 1;
+}
+
+
+
 #endif
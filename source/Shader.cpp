@@ -13,6 +13,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Shader.h"
 
 #include "Files.h"
+#include "ShaderCache.h"
 
 #include <cctype>
 #include <cstring>
@@ -26,16 +27,26 @@ using namespace std;
 
 Shader::Shader(const char *vertex, const char *fragment)
 {
-	GLuint vertexShader = Compile(vertex, GL_VERTEX_SHADER);
-	GLuint fragmentShader = Compile(fragment, GL_FRAGMENT_SHADER);
-	
 	program = glCreateProgram();
 	if(!program)
 		throw runtime_error("Creating OpenGL shader program failed.");
 	
+	// If this program was linked the last time the game ran, it can be
+	// restored from the shader cache instead of being compiled again.
+	string source = vertex;
+	source += '\0';
+	source += fragment;
+	if(ShaderCache::Get(source, program))
+		return;
+	
+	GLuint vertexShader = Compile(vertex, GL_VERTEX_SHADER);
+	GLuint fragmentShader = Compile(fragment, GL_FRAGMENT_SHADER);
+	
 	glAttachShader(program, vertexShader);
 	glAttachShader(program, fragmentShader);
 	
+	if(ShaderCache::IsEnabled())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program);
 	
 	glDetachShader(program, vertexShader);
@@ -45,6 +56,8 @@ Shader::Shader(const char *vertex, const char *fragment)
 	glGetProgramiv(program, GL_LINK_STATUS, &status);
 	if(status == GL_FALSE)
 		throw runtime_error("Linking OpenGL shader program failed.");
+	
+	ShaderCache::Set(source, program);
 }
 
 
@@ -0,0 +1,229 @@
+/* ShaderCache.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "ShaderCache.h"
+
+#include "Files.h"
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+
+using namespace std;
+
+namespace {
+	// This must be changed whenever the format of the cache changes, so that an
+	// old cache will be ignored instead of being misread.
+	const char SIGNATURE[] = "Endless Sky shader cache 1\n";
+	const size_t SIGNATURE_SIZE = sizeof(SIGNATURE) - 1;
+	
+	// The cache is only ever read on the machine that wrote it, so values are
+	// just stored in whatever byte order that machine uses.
+	template <class Type>
+	void WriteValue(string &out, Type value)
+	{
+		out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+	}
+	
+	template <class Type>
+	bool ReadValue(const char *&it, const char *end, Type &value)
+	{
+		if(static_cast<size_t>(end - it) < sizeof(value))
+			return false;
+		memcpy(&value, it, sizeof(value));
+		it += sizeof(value);
+		return true;
+	}
+	
+	void WriteString(string &out, const string &value)
+	{
+		WriteValue<uint32_t>(out, value.length());
+		out += value;
+	}
+	
+	bool ReadString(const char *&it, const char *end, string &value)
+	{
+		uint32_t length = 0;
+		if(!ReadValue(it, end, length) || static_cast<size_t>(end - it) < length)
+			return false;
+		value.assign(it, length);
+		it += length;
+		return true;
+	}
+	
+	// A program binary only works with the exact driver that produced it.
+	string Driver()
+	{
+		string driver;
+		for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+		{
+			const GLubyte *value = glGetString(name);
+			if(value)
+				driver += reinterpret_cast<const char *>(value);
+			driver += '\n';
+		}
+		return driver;
+	}
+	
+	class Entry {
+	public:
+		GLenum format = 0;
+		string binary;
+		// Whether this program has been asked for since the cache was read.
+		bool isUsed = false;
+	};
+	
+	string cachePath;
+	bool isEnabled = false;
+	map<string, Entry> entries;
+	// Whether the cache file needs to be rewritten.
+	bool isChanged = false;
+}
+
+
+
+// Read the cache file at the given path.
+void ShaderCache::Load(const string &path)
+{
+	cachePath = path;
+	entries.clear();
+	isChanged = false;
+	
+	// Program binaries are part of OpenGL 4.1, and are available as an
+	// extension in some earlier versions. Even then, a driver might not
+	// support any binary formats.
+	GLint majorVersion = 0;
+	GLint minorVersion = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+	isEnabled = (majorVersion > 4 || (majorVersion == 4 && minorVersion >= 1))
+		|| SDL_GL_ExtensionSupported("GL_ARB_get_program_binary");
+	GLint formats = 0;
+	if(isEnabled)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	isEnabled = (formats > 0);
+	if(!isEnabled)
+		return;
+	
+	string cache = Files::Read(cachePath);
+	if(cache.compare(0, SIGNATURE_SIZE, SIGNATURE))
+		return;
+	
+	const char *it = cache.data() + SIGNATURE_SIZE;
+	const char *end = cache.data() + cache.length();
+	string driver;
+	if(!ReadString(it, end, driver) || driver != Driver())
+		return;
+	
+	uint32_t count = 0;
+	ReadValue(it, end, count);
+	string source;
+	for(uint32_t i = 0; i < count; ++i)
+	{
+		Entry entry;
+		if(!ReadString(it, end, source) || !ReadValue(it, end, entry.format) || !ReadString(it, end, entry.binary))
+			break;
+		entries[source] = std::move(entry);
+	}
+}
+
+
+
+// Rewrite the cache file if any programs were linked since it was read, or if
+// any of the programs in it are no longer in use.
+void ShaderCache::Save()
+{
+	for(auto it = entries.begin(); it != entries.end(); )
+	{
+		if(it->second.isUsed)
+			++it;
+		else
+		{
+			it = entries.erase(it);
+			isChanged = true;
+		}
+	}
+	if(!isChanged || !isEnabled || cachePath.empty())
+		return;
+	
+	string out(SIGNATURE, SIGNATURE_SIZE);
+	WriteString(out, Driver());
+	WriteValue<uint32_t>(out, entries.size());
+	for(const auto &it : entries)
+	{
+		WriteString(out, it.first);
+		WriteValue(out, it.second.format);
+		WriteString(out, it.second.binary);
+	}
+	Files::Write(cachePath, out);
+	isChanged = false;
+}
+
+
+
+// Check whether programs can be saved at all.
+bool ShaderCache::IsEnabled()
+{
+	return isEnabled;
+}
+
+
+
+// Restore the program with the given source code into the given program object.
+bool ShaderCache::Get(const string &source, GLuint program)
+{
+	if(!isEnabled)
+		return false;
+	
+	auto it = entries.find(source);
+	if(it == entries.end())
+		return false;
+	
+	// If the driver refuses the binary anyway, the program will be linked
+	// from its source code, and the binary replaced.
+	glProgramBinary(program, it->second.format, it->second.binary.data(), it->second.binary.length());
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if(status == GL_FALSE)
+	{
+		entries.erase(it);
+		isChanged = true;
+		return false;
+	}
+	
+	it->second.isUsed = true;
+	return true;
+}
+
+
+
+// Add a program that was just linked to the cache.
+void ShaderCache::Set(const string &source, GLuint program)
+{
+	if(!isEnabled)
+		return;
+	
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+		return;
+	
+	Entry &entry = entries[source];
+	entry.binary.resize(length);
+	glGetProgramBinary(program, length, &length, &entry.format, &entry.binary[0]);
+	entry.binary.resize(length);
+	entry.isUsed = true;
+	isChanged = true;
+}
@@ -0,0 +1,49 @@
+/* ShaderCache.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SHADER_CACHE_H_
+#define SHADER_CACHE_H_
+
+#include "gl_header.h"
+
+#include <string>
+
+
+
+// Class that keeps a copy on disk of every shader program the graphics driver
+// has linked, so that the next time the game starts the programs can be
+// restored instead of compiled again, which is slow on some drivers. Programs
+// are looked up by their source code. The whole cache is ignored if the
+// graphics card or the driver has changed since it was written, or if the
+// driver does not support saving program binaries.
+class ShaderCache {
+public:
+	// Read the cache file at the given path. This must be done once there is
+	// an OpenGL context, but before any of the shaders are created.
+	static void Load(const std::string &path);
+	// Rewrite the cache file if any programs were linked since it was read.
+	// This should be done once all the shaders have been created.
+	static void Save();
+	
+	// Check whether programs can be saved at all. If so, they must be told so
+	// before they are linked.
+	static bool IsEnabled();
+	// Restore the program with the given source code into the given program
+	// object. If this returns false, the program must be compiled and linked.
+	static bool Get(const std::string &source, GLuint program);
+	// Add a program that was just linked to the cache.
+	static void Set(const std::string &source, GLuint program);
+};
+
+
+
+#endif
@@ -44,7 +44,6 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 using namespace std;
 
 namespace {
-	const string FIGHTER_REPAIR = "Repair fighters in";
 	const vector<string> BAY_TYPE = {"drone", "fighter"};
 	const vector<string> BAY_SIDE = {"inside", "over", "under"};
 	const vector<string> BAY_FACING = {"forward", "left", "right", "back"};
@@ -122,6 +121,7 @@ void Ship::Load(const DataNode &node)
 	
 	government = GameData::PlayerGovernment();
 	equipped.clear();
+	hasSummedAttributes = false;
 	
 	// Note: I do not clear the attributes list here so that it is permissible
 	// to override one ship definition with another.
@@ -158,11 +158,11 @@ void Ship::Load(const DataNode &node)
 		else if(key == "attributes" || add)
 		{
 			if(!add)
-				baseAttributes.Load(child);
+				baseAttributes.Mutable().Load(child);
 			else
 			{
 				addAttributes = true;
-				attributes.Load(child);
+				attributes.Mutable().Load(child);
 			}
 		}
 		else if(key == "engine" && child.Size() >= 3)
@@ -281,14 +281,14 @@ void Ship::Load(const DataNode &node)
 		{
 			if(!hasOutfits)
 			{
-				outfits.clear();
+				outfits.Mutable().clear();
 				hasOutfits = true;
 			}
 			for(const DataNode &grand : child)
 			{
 				int count = (grand.Size() >= 2) ? grand.Value(1) : 1;
 				if(count > 0)
-					outfits[GameData::Outfits().Get(grand.Token(0))] += count;
+					outfits.Mutable()[GameData::Outfits().Get(grand.Token(0))] += count;
 				else
 					grand.PrintTrace("Skipping invalid outfit count:");
 			}
@@ -361,8 +361,11 @@ void Ship::FinishLoading(bool isNewInstance)
 			reinterpret_cast<Body &>(*this) = *base;
 		if(customSwizzle == -1)
 			customSwizzle = base->CustomSwizzle();
-		if(baseAttributes.Attributes().empty())
+		if(baseAttributes->Attributes().empty())
+		{
 			baseAttributes = base->baseAttributes;
+			hasSummedAttributes = false;
+		}
 		if(bays.empty() && !base->bays.empty())
 			bays = base->bays;
 		if(enginePoints.empty())
@@ -374,8 +377,11 @@ void Ship::FinishLoading(bool isNewInstance)
 		}
 		if(finalExplosions.empty())
 			finalExplosions = base->finalExplosions;
-		if(outfits.empty())
+		if(outfits->empty())
+		{
 			outfits = base->outfits;
+			hasSummedAttributes = false;
+		}
 		if(description.empty())
 			description = base->description;
 		
@@ -433,7 +439,7 @@ void Ship::FinishLoading(bool isNewInstance)
 	// warn if any non-weapon outfits are "installed" in a hardpoint.
 	for(auto &it : equipped)
 	{
-		int excess = it.second - outfits[it.first];
+		int excess = it.second - OutfitCount(it.first);
 		if(excess > 0)
 		{
 			// If there are more hardpoints specifying this outfit than there
@@ -462,29 +468,45 @@ void Ship::FinishLoading(bool isNewInstance)
 	
 	// Mark any drone that has no "automaton" value as an automaton, to
 	// grandfather in the drones from before that attribute existed.
-	if(baseAttributes.Category() == "Drone" && !baseAttributes.Get("automaton"))
-		baseAttributes.Set("automaton", 1.);
+	if(baseAttributes->Category() == "Drone" && !baseAttributes->Get("automaton"))
+	{
+		baseAttributes.Mutable().Set("automaton", 1.);
+		hasSummedAttributes = false;
+	}
 	
-	baseAttributes.Set("gun ports", armament.GunCount());
-	baseAttributes.Set("turret mounts", armament.TurretCount());
+	// Only change the base attributes if they are not already right, so that a
+	// copy of a ship model can keep sharing them with the model.
+	if(baseAttributes->Get("gun ports") != armament.GunCount()
+			|| baseAttributes->Get("turret mounts") != armament.TurretCount())
+	{
+		Outfit &mutableAttributes = baseAttributes.Mutable();
+		mutableAttributes.Set("gun ports", armament.GunCount());
+		mutableAttributes.Set("turret mounts", armament.TurretCount());
+		hasSummedAttributes = false;
+	}
 	
 	if(addAttributes)
 	{
 		// Store attributes from an "add attributes" node in the ship's
 		// baseAttributes so they can be written to the save file.
-		baseAttributes.Add(attributes);
+		baseAttributes.Mutable().Add(*attributes);
 		addAttributes = false;
+		hasSummedAttributes = false;
 	}
 	// Add the attributes of all your outfits to the ship's base attributes.
-	attributes = baseAttributes;
-	for(const auto &it : outfits)
+	// If neither of those has changed since they were last added up, e.g.
+	// because this is a copy of a ship model, the sum is still shared.
+	if(!hasSummedAttributes)
+		attributes = baseAttributes;
+	for(const auto &it : *outfits)
 	{
 		if(it.first->Name().empty())
 		{
 			Files::LogError("Unrecognized outfit in " + modelName + " \"" + name + "\"");
 			continue;
 		}
-		attributes.Add(*it.first, it.second);
+		if(!hasSummedAttributes)
+			attributes.Mutable().Add(*it.first, it.second);
 		// Some ship variant definitions do not specify which weapons
 		// are placed in which hardpoint. Add any weapons that are not
 		// yet installed to the ship's armament.
@@ -499,6 +521,7 @@ void Ship::FinishLoading(bool isNewInstance)
 				armament.Add(it.first, count);
 		}
 	}
+	hasSummedAttributes = true;
 	// Inspect the ship's armament to ensure that guns are in gun ports and
 	// turrets are in turret mounts. This can only happen when the armament
 	// is configured incorrectly in a ship or variant definition.
@@ -517,7 +540,8 @@ void Ship::FinishLoading(bool isNewInstance)
 			Files::LogError(warning);
 		}
 	}
-	cargo.SetSize(attributes.Get("cargo space"));
+	cargo.SetSize(attributes->Get("cargo space"));
+	CacheStats();
 	equipped.clear();
 	armament.FinishLoading();
 	
@@ -536,15 +560,21 @@ void Ship::FinishLoading(bool isNewInstance)
 		if(bay.side == Bay::INSIDE && bay.launchEffects.empty() && Crew())
 			bay.launchEffects.emplace_back(GameData::Effects().Get("basic launch"));
 	
+	// Count the empty bays of each kind. From now on, the counts are updated
+	// whenever a ship is carried or launched.
+	freeBays[0] = freeBays[1] = 0;
+	for(const Bay &bay : bays)
+		freeBays[bay.isFighter] += !bay.ship;
+	
 	// Figure out if this ship can be carried.
-	const string &category = attributes.Category();
+	const string &category = attributes->Category();
 	canBeCarried = (category == "Fighter" || category == "Drone");
 	
 	// Issue warnings if this ship has negative outfit, cargo, weapon, or engine capacity.
 	string warning;
 	for(const string &attr : set<string>{"outfit space", "cargo space", "weapon capacity", "engine capacity"})
 	{
-		double val = attributes.Get(attr);
+		double val = attributes->Get(attr);
 		if(val < 0)
 			warning += attr + ": " + Format::Number(val) + "\n";
 	}
@@ -554,7 +584,7 @@ void Ship::FinishLoading(bool isNewInstance)
 		// no names. Print the outfits to facilitate identifying this ship definition.
 		string message = (!name.empty() ? "Ship \"" + name + "\" " : "") + "(" + modelName + "):\n";
 		ostringstream outfitNames("outfits:\n");
-		for(const auto &it : outfits)
+		for(const auto &it : *outfits)
 			outfitNames << '\t' << it.second << " " + it.first->Name() << endl;
 		Files::LogError(message + warning + outfitNames.str());
 	}
@@ -592,19 +622,19 @@ void Ship::Save(DataWriter &out) const
 		out.Write("attributes");
 		out.BeginChild();
 		{
-			out.Write("category", baseAttributes.Category());
-			out.Write("cost", baseAttributes.Cost());
-			out.Write("mass", baseAttributes.Mass());
-			for(const auto &it : baseAttributes.FlareSprites())
+			out.Write("category", baseAttributes->Category());
+			out.Write("cost", baseAttributes->Cost());
+			out.Write("mass", baseAttributes->Mass());
+			for(const auto &it : baseAttributes->FlareSprites())
 				for(int i = 0; i < it.second; ++i)
 					it.first.SaveSprite(out, "flare sprite");
-			for(const auto &it : baseAttributes.FlareSounds())
+			for(const auto &it : baseAttributes->FlareSounds())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("flare sound", it.first->Name());
-			for(const auto &it : baseAttributes.AfterburnerEffects())
+			for(const auto &it : baseAttributes->AfterburnerEffects())
 				for(int i = 0; i < it.second; ++i)
 					out.Write("afterburner effect", it.first->Name());
-			for(const auto &it : baseAttributes.Attributes())
+			for(const auto &it : baseAttributes->Attributes())
 				if(it.second)
 					out.Write(it.first, it.second);
 		}
@@ -613,7 +643,7 @@ void Ship::Save(DataWriter &out) const
 		out.Write("outfits");
 		out.BeginChild();
 		{
-			for(const auto &it : outfits)
+			for(const auto &it : *outfits)
 				if(it.first && it.second)
 				{
 					if(it.second == 1)
@@ -742,7 +772,7 @@ const Sprite *Ship::Thumbnail() const
 // Get this ship's cost.
 int64_t Ship::Cost() const
 {
-	return attributes.Cost();
+	return attributes->Cost();
 }
 
 
@@ -750,7 +780,7 @@ int64_t Ship::Cost() const
 // Get the cost of this ship's chassis, with no outfits installed.
 int64_t Ship::ChassisCost() const
 {
-	return baseAttributes.Cost();
+	return baseAttributes->Cost();
 }
 
 
@@ -761,22 +791,22 @@ vector<string> Ship::FlightCheck() const
 {
 	auto checks = vector<string>{};
 	
-	double generation = attributes.Get("energy generation") - attributes.Get("energy consumption");
-	double burning = attributes.Get("fuel energy");
-	double solar = attributes.Get("solar collection");
-	double battery = attributes.Get("energy capacity");
+	double generation = attributes->Get(Outfit::ENERGY_GENERATION) - attributes->Get(Outfit::ENERGY_CONSUMPTION);
+	double burning = attributes->Get(Outfit::FUEL_ENERGY);
+	double solar = attributes->Get(Outfit::SOLAR_COLLECTION);
+	double battery = attributes->Get(Outfit::ENERGY_CAPACITY);
 	double energy = generation + burning + solar + battery;
-	double fuelChange = attributes.Get("fuel generation") - attributes.Get("fuel consumption");
-	double fuelCapacity = attributes.Get("fuel capacity");
+	double fuelChange = attributes->Get(Outfit::FUEL_GENERATION) - attributes->Get(Outfit::FUEL_CONSUMPTION);
+	double fuelCapacity = attributes->Get(Outfit::FUEL_CAPACITY);
 	double fuel = fuelCapacity + fuelChange;
-	double thrust = attributes.Get("thrust");
-	double reverseThrust = attributes.Get("reverse thrust");
-	double afterburner = attributes.Get("afterburner thrust");
-	double thrustEnergy = attributes.Get("thrusting energy");
-	double turn = attributes.Get("turn");
-	double turnEnergy = attributes.Get("turning energy");
-	double hyperDrive = attributes.Get("hyperdrive");
-	double jumpDrive = attributes.Get("jump drive");
+	double thrust = attributes->Get(Outfit::THRUST);
+	double reverseThrust = attributes->Get(Outfit::REVERSE_THRUST);
+	double afterburner = attributes->Get(Outfit::AFTERBURNER_THRUST);
+	double thrustEnergy = attributes->Get(Outfit::THRUSTING_ENERGY);
+	double turn = attributes->Get(Outfit::TURN);
+	double turnEnergy = attributes->Get(Outfit::TURNING_ENERGY);
+	double hyperDrive = attributes->Get(Outfit::HYPERDRIVE);
+	double jumpDrive = attributes->Get(Outfit::JUMP_DRIVE);
 	
 	// Report the first error condition that will prevent takeoff:
 	if(IdleHeat() >= MaximumHeat())
@@ -814,7 +844,7 @@ vector<string> Ship::FlightCheck() const
 			if(fuelCapacity < JumpFuel())
 				checks.emplace_back("no fuel?");
 		}
-		for(const auto &it : outfits)
+		for(const auto &it : *outfits)
 			if(it.first->IsWeapon() && it.first->FiringEnergy() > energy)
 			{
 				checks.emplace_back("insufficient energy to fire?");
@@ -1014,7 +1044,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		return;
 	}
 	isInSystem = false;
-	if(!fuel || !(attributes.Get("hyperdrive") || attributes.Get("jump drive")))
+	if(!fuel || !(attributes->Get(Outfit::HYPERDRIVE) || attributes->Get(Outfit::JUMP_DRIVE)))
 		hyperspaceSystem = nullptr;
 	
 	// Adjust the error in the pilot's targeting.
@@ -1050,16 +1080,16 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		if(!cloak)
 			cloakDisruption = max(0., cloakDisruption - 1.);
 		
-		double cloakingSpeed = attributes.Get("cloak");
+		double cloakingSpeed = attributes->Get(Outfit::CLOAK);
 		bool canCloak = (!isDisabled && cloakingSpeed > 0. && !cloakDisruption
-			&& fuel >= attributes.Get("cloaking fuel")
-			&& energy >= attributes.Get("cloaking energy"));
+			&& fuel >= attributes->Get(Outfit::CLOAKING_FUEL)
+			&& energy >= attributes->Get(Outfit::CLOAKING_ENERGY));
 		if(commands.Has(Command::CLOAK) && canCloak)
 		{
 			cloak = min(1., cloak + cloakingSpeed);
-			fuel -= attributes.Get("cloaking fuel");
-			energy -= attributes.Get("cloaking energy");
-			heat += attributes.Get("cloaking heat");
+			fuel -= attributes->Get(Outfit::CLOAKING_FUEL);
+			energy -= attributes->Get(Outfit::CLOAKING_ENERGY);
+			heat += attributes->Get(Outfit::CLOAKING_HEAT);
 		}
 		else if(cloakingSpeed)
 		{
@@ -1088,7 +1118,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				double size = Width() + Height();
 				double scale = .03 * size + .5;
 				double radius = .2 * size;
-				int debrisCount = attributes.Mass() * .07;
+				int debrisCount = attributes->Mass() * .07;
 				for(int i = 0; i < debrisCount; ++i)
 				{
 					Angle angle = Angle::Random();
@@ -1109,7 +1139,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				for(const auto &it : cargo.Outfits())
 					Jettison(it.first, Random::Binomial(it.second, .25));
 				// Ammunition has a 5% chance to survive as flotsam
-				for(const auto &it : outfits)
+				for(const auto &it : *outfits)
 					if(it.first->Category() == "Ammunition")
 						Jettison(it.first, Random::Binomial(it.second, .05));
 				for(shared_ptr<Flotsam> &it : jettisoned)
@@ -1315,7 +1345,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			}
 		}
 		// Only refuel if this planet has a spaceport.
-		else if(fuel >= attributes.Get("fuel capacity")
+		else if(fuel >= attributes->Get(Outfit::FUEL_CAPACITY)
 				|| !landingPlanet || !landingPlanet->HasSpaceport())
 		{
 			zoom = min(1.f, zoom + .02f);
@@ -1323,7 +1353,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			landingPlanet = nullptr;
 		}
 		else
-			fuel = min(fuel + 1., attributes.Get("fuel capacity"));
+			fuel = min(fuel + 1., attributes->Get(Outfit::FUEL_CAPACITY));
 		
 		// Move the ship at the velocity it had when it began landing, but
 		// scaled based on how small it is now.
@@ -1341,7 +1371,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	else if(commands.Has(Command::JUMP) && IsReadyToJump())
 	{
 		hyperspaceSystem = GetTargetSystem();
-		isUsingJumpDrive = !attributes.Get("hyperdrive") || !currentSystem->Links().count(hyperspaceSystem);
+		isUsingJumpDrive = !attributes->Get(Outfit::HYPERDRIVE) || !currentSystem->Links().count(hyperspaceSystem);
 		hyperspaceFuelCost = JumpFuel(hyperspaceSystem);
 	}
 	
@@ -1369,13 +1399,13 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	double mass = Mass();
 	bool isUsingAfterburner = false;
 	if(isDisabled)
-		velocity *= 1. - attributes.Get("drag") / mass;
+		velocity *= 1. - attributes->Get(Outfit::DRAG) / mass;
 	else if(!pilotError)
 	{
 		if(commands.Turn())
 		{
 			// Check if we are able to turn.
-			double cost = attributes.Get("turning energy");
+			double cost = attributes->Get(Outfit::TURNING_ENERGY);
 			if(energy < cost * fabs(commands.Turn()))
 				commands.SetTurn(commands.Turn() * energy / (cost * fabs(commands.Turn())));
 			
@@ -1386,7 +1416,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				// of the turning energy and produce a fraction of the heat.
 				double scale = fabs(commands.Turn());
 				energy -= scale * cost;
-				heat += scale * attributes.Get("turning heat");
+				heat += scale * attributes->Get(Outfit::TURNING_HEAT);
 				angle += commands.Turn() * TurnRate() * slowMultiplier;
 			}
 		}
@@ -1395,8 +1425,8 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 		if(thrustCommand)
 		{
 			// Check if we are able to apply this thrust.
-			double cost = attributes.Get((thrustCommand > 0.) ?
-				"thrusting energy" : "reverse thrusting energy");
+			double cost = attributes->Get((thrustCommand > 0.) ?
+				Outfit::THRUSTING_ENERGY : Outfit::REVERSE_THRUSTING_ENERGY);
 			if(energy < cost)
 				thrustCommand *= energy / cost;
 			
@@ -1405,12 +1435,12 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				// If a reverse thrust is commanded and the capability does not
 				// exist, ignore it (do not even slow under drag).
 				isThrusting = (thrustCommand > 0.);
-				thrust = attributes.Get(isThrusting ? "thrust" : "reverse thrust");
+				thrust = attributes->Get(isThrusting ? Outfit::THRUST : Outfit::REVERSE_THRUST);
 				if(thrust)
 				{
 					double scale = fabs(thrustCommand);
 					energy -= scale * cost;
-					heat += scale * attributes.Get(isThrusting ? "thrusting heat" : "reverse thrusting heat");
+					heat += scale * attributes->Get(isThrusting ? Outfit::THRUSTING_HEAT : Outfit::REVERSE_THRUSTING_HEAT);
 					acceleration += angle.Unit() * (thrustCommand * thrust / mass);
 				}
 			}
@@ -1419,12 +1449,12 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 				&& !CannotAct();
 		if(applyAfterburner)
 		{
-			thrust = attributes.Get("afterburner thrust");
-			double fuelCost = attributes.Get("afterburner fuel");
-			double energyCost = attributes.Get("afterburner energy");
+			thrust = attributes->Get(Outfit::AFTERBURNER_THRUST);
+			double fuelCost = attributes->Get(Outfit::AFTERBURNER_FUEL);
+			double energyCost = attributes->Get(Outfit::AFTERBURNER_ENERGY);
 			if(thrust && fuel >= fuelCost && energy >= energyCost)
 			{
-				heat += attributes.Get("afterburner heat");
+				heat += attributes->Get(Outfit::AFTERBURNER_HEAT);
 				fuel -= fuelCost;
 				energy -= energyCost;
 				acceleration += angle.Unit() * thrust / mass;
@@ -1437,7 +1467,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 	if(acceleration)
 	{
 		acceleration *= slowMultiplier;
-		Point dragAcceleration = acceleration - velocity * (attributes.Get("drag") / mass);
+		Point dragAcceleration = acceleration - velocity * (attributes->Get(Outfit::DRAG) / mass);
 		// Make sure dragAcceleration has nonzero length, to avoid divide by zero.
 		if(dragAcceleration)
 		{
@@ -1545,7 +1575,7 @@ void Ship::Move(vector<Visual> &visuals, list<shared_ptr<Flotsam>> &flotsam)
 			Point pos = angle.Rotate(point) * Zoom() + position;
 			// Stream the afterburner effects outward in the direction the engines are facing.
 			Point effectVelocity = velocity - 6. * angle.Unit();
-			for(const auto &it : attributes.AfterburnerEffects())
+			for(const auto &it : attributes->AfterburnerEffects())
 				for(int i = 0; i < it.second; ++i)
 					visuals.emplace_back(*it.first, pos, effectVelocity, angle);
 		}
@@ -1574,19 +1604,19 @@ void Ship::DoGeneration()
 		// 4. Shields of carried fighters
 		// 5. Transfer of excess energy and fuel to carried fighters.
 		
-		const double hullAvailable = attributes.Get("hull repair rate");
-		const double hullEnergy = attributes.Get("hull energy") / hullAvailable;
-		const double hullFuel = attributes.Get("hull fuel") / hullAvailable;
-		const double hullHeat = attributes.Get("hull heat") / hullAvailable;
+		const double hullAvailable = attributes->Get(Outfit::HULL_REPAIR_RATE);
+		const double hullEnergy = attributes->Get(Outfit::HULL_ENERGY) / hullAvailable;
+		const double hullFuel = attributes->Get(Outfit::HULL_FUEL) / hullAvailable;
+		const double hullHeat = attributes->Get(Outfit::HULL_HEAT) / hullAvailable;
 		double hullRemaining = hullAvailable;
-		DoRepair(hull, hullRemaining, attributes.Get("hull"), energy, hullEnergy, fuel, hullFuel);
+		DoRepair(hull, hullRemaining, attributes->Get(Outfit::HULL), energy, hullEnergy, fuel, hullFuel);
 		
-		const double shieldsAvailable = attributes.Get("shield generation");
-		const double shieldsEnergy = attributes.Get("shield energy") / shieldsAvailable;
-		const double shieldsFuel = attributes.Get("shield fuel") / shieldsAvailable;
-		const double shieldsHeat = attributes.Get("shield heat") / shieldsAvailable;
+		const double shieldsAvailable = attributes->Get(Outfit::SHIELD_GENERATION);
+		const double shieldsEnergy = attributes->Get(Outfit::SHIELD_ENERGY) / shieldsAvailable;
+		const double shieldsFuel = attributes->Get(Outfit::SHIELD_FUEL) / shieldsAvailable;
+		const double shieldsHeat = attributes->Get(Outfit::SHIELD_HEAT) / shieldsAvailable;
 		double shieldsRemaining = shieldsAvailable;
-		DoRepair(shields, shieldsRemaining, attributes.Get("shields"), energy, shieldsEnergy, fuel, shieldsFuel);
+		DoRepair(shields, shieldsRemaining, attributes->Get(Outfit::SHIELDS), energy, shieldsEnergy, fuel, shieldsFuel);
 		
 		if(!bays.empty())
 		{
@@ -1595,7 +1625,7 @@ void Ship::DoGeneration()
 			for(const Bay &bay : bays)
 				if(bay.ship)
 					carried.emplace_back(1. - bay.ship->Health(), bay.ship.get());
-			sort(carried.begin(), carried.end(), (isYours && Preferences::Has(FIGHTER_REPAIR))
+			sort(carried.begin(), carried.end(), (isYours && Preferences::Has(Preferences::REPAIR_FIGHTERS_IN))
 				// Players may use a parallel strategy, to launch fighters in waves.
 				? [] (const pair<double, Ship *> &lhs, const pair<double, Ship *> &rhs)
 				{
@@ -1613,19 +1643,19 @@ void Ship::DoGeneration()
 			for(const pair<double, Ship *> &it : carried)
 			{
 				Ship &ship = *it.second;
-				DoRepair(ship.hull, hullRemaining, ship.attributes.Get("hull"), energy, hullEnergy, fuel, hullFuel);
-				DoRepair(ship.shields, shieldsRemaining, ship.attributes.Get("shields"), energy, shieldsEnergy, fuel, shieldsFuel);
+				DoRepair(ship.hull, hullRemaining, ship.attributes->Get(Outfit::HULL), energy, hullEnergy, fuel, hullFuel);
+				DoRepair(ship.shields, shieldsRemaining, ship.attributes->Get(Outfit::SHIELDS), energy, shieldsEnergy, fuel, shieldsFuel);
 			}
 			
 			// Now that there is no more need to use energy for hull and shield
 			// repair, if there is still excess energy, transfer it.
-			double energyRemaining = min(0., energy - attributes.Get("energy capacity"));
-			double fuelRemaining = min(0., fuel - attributes.Get("fuel capacity"));
+			double energyRemaining = min(0., energy - attributes->Get(Outfit::ENERGY_CAPACITY));
+			double fuelRemaining = min(0., fuel - attributes->Get(Outfit::FUEL_CAPACITY));
 			for(const pair<double, Ship *> &it : carried)
 			{
 				Ship &ship = *it.second;
-				DoRepair(ship.energy, energyRemaining, ship.attributes.Get("energy capacity"));
-				DoRepair(ship.fuel, fuelRemaining, ship.attributes.Get("fuel capacity"));
+				DoRepair(ship.energy, energyRemaining, ship.attributes->Get(Outfit::ENERGY_CAPACITY));
+				DoRepair(ship.fuel, fuelRemaining, ship.attributes->Get(Outfit::FUEL_CAPACITY));
 			}
 		}
 		
@@ -1639,18 +1669,18 @@ void Ship::DoGeneration()
 	}
 	// Handle ionization effects, etc.
 	if(ionization)
-		ionization = max(0., .99 * ionization - attributes.Get("ion resistance"));
+		ionization = max(0., .99 * ionization - attributes->Get(Outfit::ION_RESISTANCE));
 	if(disruption)
-		disruption = max(0., .99 * disruption - attributes.Get("disruption resistance"));
+		disruption = max(0., .99 * disruption - attributes->Get(Outfit::DISRUPTION_RESISTANCE));
 	if(slowness)
-		slowness = max(0., .99 * slowness - attributes.Get("slowing resistance"));
+		slowness = max(0., .99 * slowness - attributes->Get(Outfit::SLOWING_RESISTANCE));
 	
 	// When ships recharge, what actually happens is that they can exceed their
 	// maximum capacity for the rest of the turn, but must be clamped to the
 	// maximum here before they gain more. This is so that, for example, a ship
 	// with no batteries but a good generator can still move.
-	energy = min(energy, attributes.Get("energy capacity"));
-	fuel = min(fuel, attributes.Get("fuel capacity"));
+	energy = min(energy, attributes->Get(Outfit::ENERGY_CAPACITY));
+	fuel = min(fuel, attributes->Get(Outfit::FUEL_CAPACITY));
 	
 	heat -= heat * HeatDissipation();
 	if(heat > MaximumHeat())
@@ -1658,9 +1688,9 @@ void Ship::DoGeneration()
 	else if(heat < .9 * MaximumHeat())
 		isOverheated = false;
 	
-	double maxShields = attributes.Get("shields");
+	double maxShields = attributes->Get(Outfit::SHIELDS);
 	shields = min(shields, maxShields);
-	double maxHull = attributes.Get("hull");
+	double maxHull = attributes->Get(Outfit::HULL);
 	hull = min(hull, maxHull);
 	
 	isDisabled = isOverheated || hull < MinimumHull() || (!crew && RequiredCrew());
@@ -1685,36 +1715,36 @@ void Ship::DoGeneration()
 		if(currentSystem)
 		{
 			double scale = .2 + 1.8 / (.001 * position.Length() + 1);
-			fuel += currentSystem->SolarWind() * .03 * scale * (sqrt(attributes.Get("ramscoop")) + .05 * scale);
+			fuel += currentSystem->SolarWind() * .03 * scale * (sqrt(attributes->Get(Outfit::RAMSCOOP)) + .05 * scale);
 			
 			double solarScaling = currentSystem->SolarPower() * scale;
-			energy += solarScaling * attributes.Get("solar collection");
-			heat += solarScaling * attributes.Get("solar heat");
+			energy += solarScaling * attributes->Get(Outfit::SOLAR_COLLECTION);
+			heat += solarScaling * attributes->Get(Outfit::SOLAR_HEAT);
 		}
 		
 		double coolingEfficiency = CoolingEfficiency();
-		energy += attributes.Get("energy generation") - attributes.Get("energy consumption");
+		energy += attributes->Get(Outfit::ENERGY_GENERATION) - attributes->Get(Outfit::ENERGY_CONSUMPTION);
 		energy -= ionization;
-		fuel += attributes.Get("fuel generation");
-		heat += attributes.Get("heat generation");
-		heat -= coolingEfficiency * attributes.Get("cooling");
+		fuel += attributes->Get(Outfit::FUEL_GENERATION);
+		heat += attributes->Get(Outfit::HEAT_GENERATION);
+		heat -= coolingEfficiency * attributes->Get(Outfit::COOLING);
 		
 		// Convert fuel into energy and heat only when the required amount of fuel is available.
-		if(attributes.Get("fuel consumption") <= fuel)
+		if(attributes->Get(Outfit::FUEL_CONSUMPTION) <= fuel)
 		{	
-			fuel -= attributes.Get("fuel consumption");
-			energy += attributes.Get("fuel energy");
-			heat += attributes.Get("fuel heat");
+			fuel -= attributes->Get(Outfit::FUEL_CONSUMPTION);
+			energy += attributes->Get(Outfit::FUEL_ENERGY);
+			heat += attributes->Get(Outfit::FUEL_HEAT);
 		}
 		
 		// Apply active cooling. The fraction of full cooling to apply equals
 		// your ship's current fraction of its maximum temperature.
-		double activeCooling = coolingEfficiency * attributes.Get("active cooling");
+		double activeCooling = coolingEfficiency * attributes->Get(Outfit::ACTIVE_COOLING);
 		if(activeCooling > 0. && heat > 0.)
 		{
 			// Although it's a misuse of this feature, handle the case where
 			// "active cooling" does not require any energy.
-			double coolingEnergy = attributes.Get("cooling energy");
+			double coolingEnergy = attributes->Get(Outfit::COOLING_ENERGY);
 			if(coolingEnergy)
 			{
 				double spentEnergy = min(energy, coolingEnergy * min(1., Heat()));
@@ -1755,7 +1785,7 @@ void Ship::Launch(list<shared_ptr<Ship>> &ships, vector<Visual> &visuals)
 				
 				// This ship will refuel naturally based on the carrier's fuel
 				// collection, but the carrier may have some reserves to spare.
-				double maxFuel = bay.ship->attributes.Get("fuel capacity");
+				double maxFuel = bay.ship->attributes->Get(Outfit::FUEL_CAPACITY);
 				if(maxFuel)
 				{
 					double spareFuel = fuel - JumpFuel();
@@ -1785,6 +1815,7 @@ void Ship::Launch(list<shared_ptr<Ship>> &ships, vector<Visual> &visuals)
 			bay.ship->UnmarkForRemoval();
 			// Update the cached sum of carried ship masses.
 			carriedMass -= bay.ship->Mass();
+			++freeBays[bay.isFighter];
 			// Create the desired launch effects.
 			for(const Effect *effect : bay.launchEffects)
 				visuals.emplace_back(*effect, exitPoint, velocity, launchAngle);
@@ -1871,20 +1902,16 @@ int Ship::Scan()
 	if(!(target && target->IsTargetable()))
 		return 0;
 	
-	// The range of a scanner is proportional to the square root of its power.
-	double cargoDistance = 100. * sqrt(attributes.Get("cargo scan power"));
-	double outfitDistance = 100. * sqrt(attributes.Get("outfit scan power"));
-	
 	// Bail out if this ship has no scanners.
-	if(!cargoDistance && !outfitDistance)
+	if(!cargoScanRange && !outfitScanRange)
 		return 0;
 	
 	// Scanning speed also uses a square root, so you need four scanners to get
 	// twice the speed out of them.
-	double cargoSpeed = sqrt(attributes.Get("cargo scan speed"));
+	double cargoSpeed = sqrt(attributes->Get(Outfit::CARGO_SCAN_SPEED));
 	if(!cargoSpeed)
 		cargoSpeed = 1.;
-	double outfitSpeed = sqrt(attributes.Get("outfit scan speed"));
+	double outfitSpeed = sqrt(attributes->Get(Outfit::OUTFIT_SCAN_SPEED));
 	if(!outfitSpeed)
 		outfitSpeed = 1.;
 	
@@ -1907,8 +1934,8 @@ int Ship::Scan()
 				result |= event;
 		}
 	};
-	doScan(cargoScan, cargoSpeed, cargoDistance, ShipEvent::SCAN_CARGO);
-	doScan(outfitScan, outfitSpeed, outfitDistance, ShipEvent::SCAN_OUTFITS);
+	doScan(cargoScan, cargoSpeed, cargoScanRange, ShipEvent::SCAN_CARGO);
+	doScan(outfitScan, outfitSpeed, outfitScanRange, ShipEvent::SCAN_OUTFITS);
 	
 	// Play the scanning sound if the actor or the target is the player's ship.
 	if(isYours || (target->isYours && activeScanning))
@@ -1955,6 +1982,22 @@ double Ship::OutfitScanFraction() const
 
 
 
+// Get the range of this ship's asteroid and tactical scanners, or zero if it
+// does not have any.
+double Ship::AsteroidScanRange() const
+{
+	return asteroidScanRange;
+}
+
+
+
+double Ship::TacticalScanRange() const
+{
+	return tacticalScanRange;
+}
+
+
+
 // Fire any weapons that are ready to fire. If an anti-missile is ready,
 // instead of firing here this function returns true and it can be fired if
 // collision detection finds a missile in range.
@@ -2015,6 +2058,15 @@ bool Ship::FireAntiMissile(const Projectile &projectile, vector<Visual> &visuals
 
 
 
+// Get the farthest a missile can be from this ship and still be shot down by
+// its anti-missile systems that were ready the last time Fire() was called.
+double Ship::AntiMissileRange() const
+{
+	return antiMissileRange;
+}
+
+
+
 const System *Ship::GetSystem() const
 {
 	return currentSystem;
@@ -2144,8 +2196,8 @@ bool Ship::IsReadyToJump(bool waitingIsReady) const
 		return false;
 	
 	Point direction = targetSystem->Position() - currentSystem->Position();
-	bool isJump = !attributes.Get("hyperdrive") || !currentSystem->Links().count(targetSystem);
-	double scramThreshold = attributes.Get("scram drive");
+	bool isJump = !attributes->Get(Outfit::HYPERDRIVE) || !currentSystem->Links().count(targetSystem);
+	double scramThreshold = attributes->Get(Outfit::SCRAM_DRIVE);
 	
 	// The ship can only enter hyperspace if it is traveling slowly enough
 	// and pointed in the right direction.
@@ -2155,7 +2207,7 @@ bool Ship::IsReadyToJump(bool waitingIsReady) const
 		if(deviation > scramThreshold)
 			return false;
 	}
-	else if(velocity.Length() > attributes.Get("jump speed"))
+	else if(velocity.Length() > attributes->Get(Outfit::JUMP_SPEED))
 		return false;
 	
 	if(!isJump)
@@ -2252,18 +2304,18 @@ void Ship::Recharge(bool atSpaceport)
 	
 	if(atSpaceport)
 	{
-		crew = min<int>(max(crew, RequiredCrew()), attributes.Get("bunks"));
-		fuel = attributes.Get("fuel capacity");
+		crew = min<int>(max(crew, RequiredCrew()), attributes->Get("bunks"));
+		fuel = attributes->Get(Outfit::FUEL_CAPACITY);
 	}
 	pilotError = 0;
 	pilotOkay = 0;
 	
-	if(atSpaceport || attributes.Get("shield generation"))
-		shields = attributes.Get("shields");
-	if(atSpaceport || attributes.Get("hull repair rate"))
-		hull = attributes.Get("hull");
-	if(atSpaceport || attributes.Get("energy generation"))
-		energy = attributes.Get("energy capacity");
+	if(atSpaceport || attributes->Get(Outfit::SHIELD_GENERATION))
+		shields = attributes->Get(Outfit::SHIELDS);
+	if(atSpaceport || attributes->Get(Outfit::HULL_REPAIR_RATE))
+		hull = attributes->Get(Outfit::HULL);
+	if(atSpaceport || attributes->Get(Outfit::ENERGY_GENERATION))
+		energy = attributes->Get(Outfit::ENERGY_CAPACITY);
 	
 	heat = IdleHeat();
 	ionization = 0.;
@@ -2282,10 +2334,10 @@ bool Ship::CanRefuel(const Ship &other) const
 
 double Ship::TransferFuel(double amount, Ship *to)
 {
-	amount = max(fuel - attributes.Get("fuel capacity"), amount);
+	amount = max(fuel - attributes->Get(Outfit::FUEL_CAPACITY), amount);
 	if(to)
 	{
-		amount = min(to->attributes.Get("fuel capacity") - to->fuel, amount);
+		amount = min(to->attributes->Get(Outfit::FUEL_CAPACITY) - to->fuel, amount);
 		to->fuel += amount;
 	}
 	fuel -= amount;
@@ -2356,7 +2408,7 @@ void Ship::WasCaptured(const shared_ptr<Ship> &capturer)
 // Get characteristics of this ship, as a fraction between 0 and 1.
 double Ship::Shields() const
 {
-	double maximum = attributes.Get("shields");
+	double maximum = attributes->Get(Outfit::SHIELDS);
 	return maximum ? min(1., shields / maximum) : 0.;
 }
 
@@ -2364,7 +2416,7 @@ double Ship::Shields() const
 
 double Ship::Hull() const
 {
-	double maximum = attributes.Get("hull");
+	double maximum = attributes->Get(Outfit::HULL);
 	return maximum ? min(1., hull / maximum) : 1.;
 }
 
@@ -2372,7 +2424,7 @@ double Ship::Hull() const
 
 double Ship::Fuel() const
 {
-	double maximum = attributes.Get("fuel capacity");
+	double maximum = attributes->Get(Outfit::FUEL_CAPACITY);
 	return maximum ? min(1., fuel / maximum) : 0.;
 }
 
@@ -2380,7 +2432,7 @@ double Ship::Fuel() const
 
 double Ship::Energy() const
 {
-	double maximum = attributes.Get("energy capacity");
+	double maximum = attributes->Get(Outfit::ENERGY_CAPACITY);
 	return maximum ? min(1., energy / maximum) : (hull > 0.) ? 1. : 0.;
 }
 
@@ -2400,8 +2452,8 @@ double Ship::Heat() const
 double Ship::Health() const
 {
 	double minimumHull = MinimumHull();
-	double hullDivisor = attributes.Get("hull") - minimumHull;
-	double divisor = attributes.Get("shields") + hullDivisor;
+	double hullDivisor = attributes->Get(Outfit::HULL) - minimumHull;
+	double divisor = attributes->Get(Outfit::SHIELDS) + hullDivisor;
 	// This should not happen, but just in case.
 	if(divisor <= 0. || hullDivisor <= 0.)
 		return 0.;
@@ -2416,7 +2468,7 @@ double Ship::Health() const
 // Get the hull fraction at which this ship is disabled.
 double Ship::DisabledHull() const
 {
-	double hull = attributes.Get("hull");
+	double hull = attributes->Get(Outfit::HULL);
 	double minimumHull = MinimumHull();
 	
 	return (hull > 0. ? minimumHull / hull : 0.);
@@ -2455,10 +2507,10 @@ double Ship::JumpFuel(const System *destination) const
 		return max(JumpDriveFuel(), HyperdriveFuel());
 	
 	// Figure out what sort of jump we're making.
-	if(attributes.Get("hyperdrive") && currentSystem->Links().count(destination))
+	if(attributes->Get(Outfit::HYPERDRIVE) && currentSystem->Links().count(destination))
 		return HyperdriveFuel();
 	
-	if(attributes.Get("jump drive") && currentSystem->Neighbors().count(destination))
+	if(attributes->Get(Outfit::JUMP_DRIVE) && currentSystem->Neighbors().count(destination))
 		return JumpDriveFuel();
 	
 	// If the given system is not a possible destination, return 0.
@@ -2471,10 +2523,10 @@ double Ship::JumpFuel(const System *destination) const
 double Ship::HyperdriveFuel() const
 {
 	// Don't bother searching through the outfits if there is no hyperdrive.
-	if(!attributes.Get("hyperdrive"))
+	if(!attributes->Get(Outfit::HYPERDRIVE))
 		return JumpDriveFuel();
 	
-	if(attributes.Get("scram drive"))
+	if(attributes->Get(Outfit::SCRAM_DRIVE))
 		return BestFuel("hyperdrive", "scram drive", 150.);
 	
 	return BestFuel("hyperdrive", "", 100.);
@@ -2485,7 +2537,7 @@ double Ship::HyperdriveFuel() const
 double Ship::JumpDriveFuel() const
 {
 	// Don't bother searching through the outfits if there is no jump drive.
-	if(!attributes.Get("jump drive"))
+	if(!attributes->Get(Outfit::JUMP_DRIVE))
 		return 0.;
 	
 	return BestFuel("jump drive", "", 200.);
@@ -2498,7 +2550,7 @@ double Ship::JumpFuelMissing() const
 	// Used for smart refuelling: transfer only as much as really needed
 	// includes checking if fuel cap is high enough at all
 	double jumpFuel = JumpFuel(targetSystem);
-	if(!jumpFuel || fuel > jumpFuel || jumpFuel > attributes.Get("fuel capacity"))
+	if(!jumpFuel || fuel > jumpFuel || jumpFuel > attributes->Get(Outfit::FUEL_CAPACITY))
 		return 0.;
 	
 	return jumpFuel - fuel;
@@ -2511,14 +2563,14 @@ double Ship::IdleHeat() const
 {
 	// This ship's cooling ability:
 	double coolingEfficiency = CoolingEfficiency();
-	double cooling = coolingEfficiency * attributes.Get("cooling");
-	double activeCooling = coolingEfficiency * attributes.Get("active cooling");
+	double cooling = coolingEfficiency * attributes->Get(Outfit::COOLING);
+	double activeCooling = coolingEfficiency * attributes->Get(Outfit::ACTIVE_COOLING);
 	
 	// Idle heat is the heat level where:
 	// heat = heat * diss + heatGen - cool - activeCool * heat / (100 * mass)
 	// heat = heat * (diss - activeCool / (100 * mass)) + (heatGen - cool)
 	// heat * (1 - diss + activeCool / (100 * mass)) = (heatGen - cool)
-	double production = max(0., attributes.Get("heat generation") - cooling);
+	double production = max(0., attributes->Get(Outfit::HEAT_GENERATION) - cooling);
 	double dissipation = HeatDissipation() + activeCooling / MaximumHeat();
 	return production / dissipation;
 }
@@ -2528,7 +2580,7 @@ double Ship::IdleHeat() const
 // Get the heat dissipation, in heat units per heat unit per frame.
 double Ship::HeatDissipation() const
 {
-	return .001 * attributes.Get("heat dissipation");
+	return .001 * attributes->Get(Outfit::HEAT_DISSIPATION);
 }
 
 
@@ -2536,7 +2588,7 @@ double Ship::HeatDissipation() const
 // Get the maximum heat level, in heat units (not temperature).
 double Ship::MaximumHeat() const
 {
-	return MAXIMUM_TEMPERATURE * (cargo.Used() + attributes.Mass());
+	return MAXIMUM_TEMPERATURE * (cargo.Used() + attributes->Mass());
 }
 
 
@@ -2544,11 +2596,7 @@ double Ship::MaximumHeat() const
 // Calculate the multiplier for cooling efficiency.
 double Ship::CoolingEfficiency() const
 {
-	// This is an S-curve where the efficiency is 100% if you have no outfits
-	// that create "cooling inefficiency", and as that value increases the
-	// efficiency stays high for a while, then drops off, then approaches 0.
-	double x = attributes.Get("cooling inefficiency");
-	return 2. + 2. / (1. + exp(x / -2.)) - 4. / (1. + exp(x / -4.));
+	return coolingEfficiency;
 }
 
 
@@ -2562,18 +2610,18 @@ int Ship::Crew() const
 
 int Ship::RequiredCrew() const
 {
-	if(attributes.Get("automaton"))
+	if(attributes->Get("automaton"))
 		return 0;
 	
 	// Drones do not need crew, but all other ships need at least one.
-	return max<int>(1, attributes.Get("required crew"));
+	return max<int>(1, attributes->Get("required crew"));
 }
 
 
 
 void Ship::AddCrew(int count)
 {
-	crew = min<int>(crew + count, attributes.Get("bunks"));
+	crew = min<int>(crew + count, attributes->Get("bunks"));
 }
 
 
@@ -2588,22 +2636,22 @@ bool Ship::CanBeFlagship() const
 
 double Ship::Mass() const
 {
-	return carriedMass + cargo.Used() + attributes.Mass();
+	return carriedMass + cargo.Used() + attributes->Mass();
 }
 
 
 
 double Ship::TurnRate() const
 {
-	return attributes.Get("turn") / Mass();
+	return attributes->Get(Outfit::TURN) / Mass();
 }
 
 
 
 double Ship::Acceleration() const
 {
-	double thrust = attributes.Get("thrust");
-	return (thrust ? thrust : attributes.Get("afterburner thrust")) / Mass();
+	double thrust = attributes->Get(Outfit::THRUST);
+	return (thrust ? thrust : attributes->Get(Outfit::AFTERBURNER_THRUST)) / Mass();
 }
 
 
@@ -2613,15 +2661,15 @@ double Ship::MaxVelocity() const
 	// v * drag / mass == thrust / mass
 	// v * drag == thrust
 	// v = thrust / drag
-	double thrust = attributes.Get("thrust");
-	return (thrust ? thrust : attributes.Get("afterburner thrust")) / attributes.Get("drag");
+	double thrust = attributes->Get(Outfit::THRUST);
+	return (thrust ? thrust : attributes->Get(Outfit::AFTERBURNER_THRUST)) / attributes->Get(Outfit::DRAG);
 }
 
 
 
 double Ship::MaxReverseVelocity() const
 {
-	return attributes.Get("reverse thrust") / attributes.Get("drag");
+	return attributes->Get(Outfit::REVERSE_THRUST) / attributes->Get(Outfit::DRAG);
 }
 
 
@@ -2731,10 +2779,7 @@ bool Ship::HasBays() const
 
 int Ship::BaysFree(bool isFighter) const
 {
-	int count = 0;
-	for(const Bay &bay : bays)
-		count += (bay.isFighter == isFighter) && !bay.ship;
-	return count;
+	return freeBays[isFighter];
 }
 
 
@@ -2746,7 +2791,7 @@ bool Ship::CanCarry(const Ship &ship) const
 	if(!ship.canBeCarried)
 		return false;
 	// This carried ship is either a fighter or a drone.
-	bool isFighter = (ship.attributes.Category() == "Fighter");
+	bool isFighter = (ship.attributes->Category() == "Fighter");
 	
 	int free = BaysFree(isFighter);
 	if(!free)
@@ -2755,7 +2800,7 @@ bool Ship::CanCarry(const Ship &ship) const
 	for(const auto &it : escorts)
 	{
 		auto escort = it.lock();
-		if(escort && escort->attributes.Category() == ship.attributes.Category())
+		if(escort && escort->attributes->Category() == ship.attributes->Category())
 			--free;
 	}
 	return (free > 0);
@@ -2776,7 +2821,7 @@ bool Ship::Carry(const shared_ptr<Ship> &ship)
 		return false;
 	
 	// This carried ship is either a fighter or a drone.
-	bool isFighter = ship->attributes.Category() == "Fighter";
+	bool isFighter = ship->attributes->Category() == "Fighter";
 	
 	for(Bay &bay : bays)
 		if((bay.isFighter == isFighter) && !bay.ship)
@@ -2798,6 +2843,7 @@ bool Ship::Carry(const shared_ptr<Ship> &ship)
 			
 			// Update the cached mass of the mothership.
 			carriedMass += ship->Mass();
+			--freeBays[isFighter];
 			return true;
 		}
 	return false;
@@ -2811,6 +2857,7 @@ void Ship::UnloadBays()
 		if(bay.ship)
 		{
 			carriedMass -= bay.ship->Mass();
+			++freeBays[bay.isFighter];
 			bay.ship->SetSystem(currentSystem);
 			bay.ship->SetPlanet(landingPlanet);
 			bay.ship.reset();
@@ -2869,7 +2916,7 @@ void Ship::Jettison(const string &commodity, int tons)
 	heat -= tons * MAXIMUM_TEMPERATURE * Heat();
 	
 	for( ; tons > 0; tons -= Flotsam::TONS_PER_BOX)
-		jettisoned.emplace_back(new Flotsam(commodity, (Flotsam::TONS_PER_BOX < tons) ? Flotsam::TONS_PER_BOX : tons));
+		jettisoned.emplace_back(Flotsam::Create(commodity, (Flotsam::TONS_PER_BOX < tons) ? Flotsam::TONS_PER_BOX : tons));
 }
 
 
@@ -2889,7 +2936,7 @@ void Ship::Jettison(const Outfit *outfit, int count)
 	const int perBox = (mass <= 0.) ? count : (mass > Flotsam::TONS_PER_BOX) ? 1 : static_cast<int>(Flotsam::TONS_PER_BOX / mass);
 	while(count > 0)
 	{
-		jettisoned.emplace_back(new Flotsam(outfit, (perBox < count) ? perBox : count));
+		jettisoned.emplace_back(Flotsam::Create(outfit, (perBox < count) ? perBox : count));
 		count -= perBox;
 	}
 }
@@ -2898,14 +2945,14 @@ void Ship::Jettison(const Outfit *outfit, int count)
 
 const Outfit &Ship::Attributes() const
 {
-	return attributes;
+	return *attributes;
 }
 
 
 
 const Outfit &Ship::BaseAttributes() const
 {
-	return baseAttributes;
+	return *baseAttributes;
 }
 
 
@@ -2913,15 +2960,15 @@ const Outfit &Ship::BaseAttributes() const
 // Get outfit information.
 const map<const Outfit *, int> &Ship::Outfits() const
 {
-	return outfits;
+	return *outfits;
 }
 
 
 
 int Ship::OutfitCount(const Outfit *outfit) const
 {
-	auto it = outfits.find(outfit);
-	return (it == outfits.end()) ? 0 : it->second;
+	auto it = outfits->find(outfit);
+	return (it == outfits->end()) ? 0 : it->second;
 }
 
 
@@ -2931,23 +2978,25 @@ void Ship::AddOutfit(const Outfit *outfit, int count)
 {
 	if(outfit && count)
 	{
-		auto it = outfits.find(outfit);
-		if(it == outfits.end())
-			outfits[outfit] = count;
+		map<const Outfit *, int> &installed = outfits.Mutable();
+		auto it = installed.find(outfit);
+		if(it == installed.end())
+			installed[outfit] = count;
 		else
 		{
 			it->second += count;
 			if(!it->second)
-				outfits.erase(it);
+				installed.erase(it);
 		}
-		attributes.Add(*outfit, count);
+		attributes.Mutable().Add(*outfit, count);
 		if(outfit->IsWeapon())
 			armament.Add(outfit, count);
 		
 		if(outfit->Get("cargo space"))
-			cargo.SetSize(attributes.Get("cargo space"));
+			cargo.SetSize(attributes->Get("cargo space"));
 		if(outfit->Get("hull"))
 			hull += outfit->Get("hull") * count;
+		CacheStats();
 	}
 }
 
@@ -2977,8 +3026,8 @@ bool Ship::CanFire(const Weapon *weapon) const
 	
 	if(weapon->Ammo())
 	{
-		auto it = outfits.find(weapon->Ammo());
-		if(it == outfits.end() || it->second < weapon->AmmoUsage())
+		auto it = outfits->find(weapon->Ammo());
+		if(it == outfits->end() || it->second < weapon->AmmoUsage())
 			return false;
 	}
 	
@@ -3156,12 +3205,32 @@ void Ship::RemoveEscort(const Ship &ship)
 
 
 
+// Recalculate the stats that depend only on this ship's attributes. This must
+// be done whenever the attributes change, i.e. when outfits are installed.
+void Ship::CacheStats()
+{
+	// The cooling efficiency is an S-curve where the efficiency is 100% if you
+	// have no outfits that create "cooling inefficiency", and as that value
+	// increases the efficiency stays high for a while, then drops off, then
+	// approaches 0.
+	double x = attributes->Get(Outfit::COOLING_INEFFICIENCY);
+	coolingEfficiency = 2. + 2. / (1. + exp(x / -2.)) - 4. / (1. + exp(x / -4.));
+	
+	// The range of a scanner is proportional to the square root of its power.
+	cargoScanRange = 100. * sqrt(attributes->Get(Outfit::CARGO_SCAN_POWER));
+	outfitScanRange = 100. * sqrt(attributes->Get(Outfit::OUTFIT_SCAN_POWER));
+	asteroidScanRange = 100. * sqrt(attributes->Get(Outfit::ASTEROID_SCAN_POWER));
+	tacticalScanRange = 100. * sqrt(attributes->Get(Outfit::TACTICAL_SCAN_POWER));
+}
+
+
+
 double Ship::MinimumHull() const
 {
 	if(neverDisabled)
 		return 0.;
 	
-	double maximumHull = attributes.Get("hull");
+	double maximumHull = attributes->Get(Outfit::HULL);
 	return floor(maximumHull * max(.15, min(.45, 10. / sqrt(maximumHull))));
 }
 
@@ -3173,14 +3242,14 @@ double Ship::BestFuel(const string &type, const string &subtype, double defaultF
 	// Find the outfit that provides the least costly hyperjump.
 	double best = 0.;
 	// Make it possible for a hyperdrive to be integrated into a ship.
-	if(baseAttributes.Get(type) && (subtype.empty() || baseAttributes.Get(subtype)))
+	if(baseAttributes->Get(type) && (subtype.empty() || baseAttributes->Get(subtype)))
 	{
-		best = baseAttributes.Get("jump fuel");
+		best = baseAttributes->Get(Outfit::JUMP_FUEL);
 		if(!best)
 			best = defaultFuel;
 	}
 	// Search through all the outfits.
-	for(const auto &it : outfits)
+	for(const auto &it : *outfits)
 		if(it.first->Get(type) && (subtype.empty() || it.first->Get(subtype)))
 		{
 			double fuel = it.first->Get("jump fuel");
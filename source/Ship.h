@@ -19,6 +19,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Armament.h"
 #include "CargoHold.h"
 #include "Command.h"
+#include "CopyOnWrite.h"
 #include "Outfit.h"
 #include "Personality.h"
 #include "Point.h"
@@ -184,6 +185,10 @@ public:
 	// Find out what fraction of the scan is complete.
 	double CargoScanFraction() const;
 	double OutfitScanFraction() const;
+	// Get the range of this ship's asteroid and tactical scanners, or zero if
+	// it does not have any.
+	double AsteroidScanRange() const;
+	double TacticalScanRange() const;
 	
 	// Fire any weapons that are ready to fire. If an anti-missile is ready,
 	// instead of firing here this function returns true and it can be fired if
@@ -191,6 +196,9 @@ public:
 	bool Fire(std::vector<Projectile> &projectiles, std::vector<Visual> &visuals);
 	// Fire an anti-missile. Returns true if the missile was killed.
 	bool FireAntiMissile(const Projectile &projectile, std::vector<Visual> &visuals);
+	// Get the farthest a missile can be from this ship and still be shot down
+	// by its anti-missile systems that were ready the last time Fire() was called.
+	double AntiMissileRange() const;
 	
 	// Get the system this ship is in.
 	const System *GetSystem() const;
@@ -382,6 +390,8 @@ private:
 	// Add or remove a ship from this ship's list of escorts.
 	void AddEscort(Ship &ship);
 	void RemoveEscort(const Ship &ship);
+	// Recalculate the stats that depend only on this ship's attributes.
+	void CacheStats();
 	// Get the hull amount at which this ship is disabled.
 	double MinimumHull() const;
 	// Find out how much fuel is consumed by the hyperdrive of the given type.
@@ -403,6 +413,65 @@ private:
 	const Government *government;
 	*/
 	
+	// The state that Move(), the AI, and the collision checks read or update
+	// every step comes first, right after the Body members, so that stepping a
+	// ship only touches a few cache lines of it. Everything that is large or
+	// rarely used (names, outfits, cargo, etc.) comes after it.
+	
+	// Various energy levels:
+	double shields = 0.;
+	double hull = 0.;
+	double fuel = 0.;
+	double energy = 0.;
+	double heat = 0.;
+	double ionization = 0.;
+	double disruption = 0.;
+	double slowness = 0.;
+	// Acceleration can be created by engines, firing weapons, or weapon impacts.
+	Point acceleration;
+	double cloak = 0.;
+	double cloakDisruption = 0.;
+	// Cache the mass of carried ships to avoid repeatedly recomputing it.
+	double carriedMass = 0.;
+	// Likewise, keep count of how many drone and fighter bays are empty.
+	int freeBays[2] = {0, 0};
+	// Stats derived from the attributes, cached because they are needed every
+	// step but only change when outfits are installed or removed.
+	double coolingEfficiency = 1.;
+	// The range of each kind of scanner is proportional to the square root of
+	// its power.
+	double cargoScanRange = 0.;
+	double outfitScanRange = 0.;
+	double asteroidScanRange = 0.;
+	double tacticalScanRange = 0.;
+	// Cached values for figuring out when anti-missile is in range.
+	double antiMissileRange = 0.;
+	double weaponRadius = 0.;
+	
+	Command commands;
+	
+	int forget = 0;
+	int pilotError = 0;
+	int pilotOkay = 0;
+	bool isInSystem = true;
+	bool isOverheated = false;
+	bool isDisabled = false;
+	bool isBoarding = false;
+	bool hasBoarded = false;
+	bool isThrusting = false;
+	
+	// Current status of this particular ship:
+	const System *currentSystem = nullptr;
+	// A Ship can be locked into one of three special states: landing,
+	// hyperspacing, and exploding. Each one must track some special counters:
+	const Planet *landingPlanet = nullptr;
+	
+	int hyperspaceCount = 0;
+	const System *hyperspaceSystem = nullptr;
+	bool isUsingJumpDrive = false;
+	double hyperspaceFuelCost = 0.;
+	Point hyperspaceOffset;
+	
 	// Characteristics of the chassis:
 	const Ship *base = nullptr;
 	std::string modelName;
@@ -414,48 +483,37 @@ private:
 	std::string name;
 	bool canBeCarried = false;
 	
-	int forget = 0;
-	bool isInSystem = true;
 	// "Special" ships cannot be forgotten, and if they land on a planet, they
 	// continue to exist and refuel instead of being deleted.
 	bool isSpecial = false;
 	bool isYours = false;
 	bool isParked = false;
-	bool isOverheated = false;
-	bool isDisabled = false;
-	bool isBoarding = false;
-	bool hasBoarded = false;
-	bool isThrusting = false;
 	bool neverDisabled = false;
 	bool isCapturable = true;
 	bool isInvisible = false;
 	int customSwizzle = -1;
-	double cloak = 0.;
-	double cloakDisruption = 0.;
-	// Cached values for figuring out when anti-missile is in range.
-	double antiMissileRange = 0.;
-	double weaponRadius = 0.;
 	// Cargo and outfit scanning takes time.
 	double cargoScan = 0.;
 	double outfitScan = 0.;
 	
-	Command commands;
-	
 	Personality personality;
 	const Phrase *hail = nullptr;
 	
-	// Installed outfits, cargo, etc.:
-	Outfit attributes;
-	Outfit baseAttributes;
+	// Installed outfits, cargo, etc. Most ships never change the outfits they
+	// were created with, so these are shared with the model they were copied
+	// from until they are modified.
+	CopyOnWrite<Outfit> attributes;
+	CopyOnWrite<Outfit> baseAttributes;
+	// Whether the attributes are the sum of the base attributes and outfits as
+	// they are now, so FinishLoading() does not need to add them up again.
+	bool hasSummedAttributes = false;
 	bool addAttributes = false;
 	const Outfit *explosionWeapon = nullptr;
-	std::map<const Outfit *, int> outfits;
+	CopyOnWrite<std::map<const Outfit *, int>> outfits;
 	CargoHold cargo;
 	std::list<std::shared_ptr<Flotsam>> jettisoned;
 	
 	std::vector<Bay> bays;
-	// Cache the mass of carried ships to avoid repeatedly recomputing it.
-	double carriedMass = 0.;
 	
 	std::vector<EnginePoint> enginePoints;
 	Armament armament;
@@ -463,33 +521,7 @@ private:
 	// (That is, they were specified as linked to a given gun or turret point.)
 	std::map<const Outfit *, int> equipped;
 	
-	// Various energy levels:
-	double shields = 0.;
-	double hull = 0.;
-	double fuel = 0.;
-	double energy = 0.;
-	double heat = 0.;
-	double ionization = 0.;
-	double disruption = 0.;
-	double slowness = 0.;
-	// Acceleration can be created by engines, firing weapons, or weapon impacts.
-	Point acceleration;
-	
 	int crew = 0;
-	int pilotError = 0;
-	int pilotOkay = 0;
-	
-	// Current status of this particular ship:
-	const System *currentSystem = nullptr;
-	// A Ship can be locked into one of three special states: landing,
-	// hyperspacing, and exploding. Each one must track some special counters:
-	const Planet *landingPlanet = nullptr;
-	
-	int hyperspaceCount = 0;
-	const System *hyperspaceSystem = nullptr;
-	bool isUsingJumpDrive = false;
-	double hyperspaceFuelCost = 0.;
-	Point hyperspaceOffset;
 	
 	// The hull may spring a "leak" (venting atmosphere, flames, blood, etc.)
 	// when the ship is dying.
@@ -328,12 +328,20 @@ void ShipInfoDisplay::UpdateAttributes(const Ship &ship, const Depreciation &dep
 
 void ShipInfoDisplay::UpdateOutfits(const Ship &ship, const Depreciation &depreciation, int day)
 {
+	UpdateSale(ship, depreciation, day);
+	
+	// The shops update their displays in every frame, so only sort the list of
+	// outfits again if they have changed.
+	if(outfitsHeight && ship.Outfits() == listedOutfits)
+		return;
+	listedOutfits = ship.Outfits();
+	
 	outfitLabels.clear();
 	outfitValues.clear();
 	outfitsHeight = 20;
 	
 	map<string, map<string, int>> listing;
-	for(const auto &it : ship.Outfits())
+	for(const auto &it : listedOutfits)
 		listing[it.first->Category()][it.first->Name()] += it.second;
 	
 	for(const auto &cit : listing)
@@ -357,8 +365,12 @@ void ShipInfoDisplay::UpdateOutfits(const Ship &ship, const Depreciation &deprec
 			outfitsHeight += 20;
 		}
 	}
-	
-	
+}
+
+
+
+void ShipInfoDisplay::UpdateSale(const Ship &ship, const Depreciation &depreciation, int day)
+{
 	int64_t totalCost = depreciation.Value(ship, day);
 	int64_t chassisCost = depreciation.Value(GameData::Ships().Get(ship.ModelName()), day);
 	saleLabels.clear();
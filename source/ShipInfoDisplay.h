@@ -15,10 +15,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "ItemInfoDisplay.h"
 
+#include <map>
 #include <string>
 #include <vector>
 
 class Depreciation;
+class Outfit;
 class Point;
 class Ship;
 
@@ -54,6 +56,7 @@ public:
 private:
 	void UpdateAttributes(const Ship &ship, const Depreciation &depreciation, int day);
 	void UpdateOutfits(const Ship &ship, const Depreciation &depreciation, int day);
+	void UpdateSale(const Ship &ship, const Depreciation &depreciation, int day);
 	
 	
 private:
@@ -64,6 +67,8 @@ private:
 	std::vector<std::string> outfitLabels;
 	std::vector<std::string> outfitValues;
 	int outfitsHeight = 0;
+	// The outfits that the outfit list was filled in for.
+	std::map<const Outfit *, int> listedOutfits;
 	
 	std::vector<std::string> saleLabels;
 	std::vector<std::string> saleValues;
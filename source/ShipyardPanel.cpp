@@ -75,8 +75,9 @@ namespace {
 ShipyardPanel::ShipyardPanel(PlayerInfo &player)
 	: ShopPanel(player, false), modifier(0)
 {
+	// The ships are already sorted by name.
 	for(const auto &it : GameData::Ships())
-		catalog[it.second.Attributes().Category()].insert(it.first);
+		catalog[it.second.Attributes().Category()].emplace_back(&it.second);
 	
 	if(player.GetPlanet())
 		shipyard = player.GetPlanet()->Shipyard();
@@ -102,17 +103,16 @@ int ShipyardPanel::DrawPlayerShipInfo(const Point &point)
 
 
 
-bool ShipyardPanel::HasItem(const string &name) const
+bool ShipyardPanel::HasItem(const Item &item) const
 {
-	const Ship *ship = GameData::Ships().Get(name);
-	return shipyard.Has(ship);
+	return shipyard.Has(item.ship);
 }
 
 
 
-void ShipyardPanel::DrawItem(const string &name, const Point &point, int scrollY)
+void ShipyardPanel::DrawItem(const Item &item, const Point &point, int scrollY)
 {
-	const Ship *ship = GameData::Ships().Get(name);
+	const Ship *ship = item.ship;
 	zones.emplace_back(point, Point(SHIP_SIZE, SHIP_SIZE), ship, scrollY);
 	if(point.Y() + SHIP_SIZE / 2 < Screen::Top() || point.Y() - SHIP_SIZE / 2 > Screen::Bottom())
 		return;
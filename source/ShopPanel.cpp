@@ -365,7 +365,7 @@ void ShopPanel::DrawMain()
 	int scrollY = 0;
 	for(const string &category : categories)
 	{
-		map<string, set<string>>::const_iterator it = catalog.find(category);
+		auto it = catalog.find(category);
 		if(it == catalog.end())
 			continue;
 		
@@ -380,21 +380,21 @@ void ShopPanel::DrawMain()
 		
 		bool isCollapsed = collapsed.count(category);
 		bool isEmpty = true;
-		for(const string &name : it->second)
+		for(const Item &item : it->second)
 		{
-			bool isSelected = (selectedShip && GameData::Ships().Get(name) == selectedShip)
-				|| (selectedOutfit && GameData::Outfits().Get(name) == selectedOutfit);
+			bool isSelected = (selectedShip && item.ship == selectedShip)
+				|| (selectedOutfit && item.outfit == selectedOutfit);
 			
 			if(isSelected)
 				selectedTopY = point.Y() - TILE_SIZE / 2;
 			
-			if(!HasItem(name))
+			if(!HasItem(item))
 				continue;
 			isEmpty = false;
 			if(isCollapsed)
 				break;
 			
-			DrawItem(name, point, scrollY);
+			DrawItem(item, point, scrollY);
 			
 			if(isSelected)
 			{
@@ -844,6 +844,20 @@ int64_t ShopPanel::LicenseCost(const Outfit *outfit) const
 
 
 
+ShopPanel::Item::Item(const Ship *ship)
+	: ship(ship)
+{
+}
+
+
+
+ShopPanel::Item::Item(const Outfit *outfit)
+	: outfit(outfit)
+{
+}
+
+
+
 ShopPanel::Zone::Zone(Point center, Point size, const Ship *ship, double scrollY)
 	: ClickZone(center, size, ship), scrollY(scrollY)
 {
@@ -42,6 +42,8 @@ public:
 	virtual void Draw() override;
 	
 protected:
+	class Item;
+	
 	void DrawSidebar();
 	void DrawButtons();
 	void DrawMain();
@@ -51,8 +53,8 @@ protected:
 	// These are for the individual shop panels to override.
 	virtual int TileSize() const = 0;
 	virtual int DrawPlayerShipInfo(const Point &point) = 0;
-	virtual bool HasItem(const std::string &name) const = 0;
-	virtual void DrawItem(const std::string &name, const Point &point, int scrollY) = 0;
+	virtual bool HasItem(const Item &item) const = 0;
+	virtual void DrawItem(const Item &item, const Point &point, int scrollY) = 0;
 	virtual int DividerOffset() const = 0;
 	virtual int DetailWidth() const = 0;
 	virtual int DrawDetails(const Point &center) = 0;
@@ -80,6 +82,18 @@ protected:
 	
 	
 protected:
+	// An entry in the catalog of everything this shop might sell. The catalog
+	// is built when the shop is opened, so drawing it each frame does not
+	// require looking up any items by name.
+	class Item {
+	public:
+		explicit Item(const Ship *ship);
+		explicit Item(const Outfit *outfit);
+		
+		const Ship *ship = nullptr;
+		const Outfit *outfit = nullptr;
+	};
+	
 	class Zone : public ClickZone<const Ship *> {
 	public:
 		Zone(Point center, Point size, const Ship *ship, double scrollY = 0.);
@@ -131,7 +145,8 @@ protected:
 	std::vector<Zone> zones;
 	std::vector<ClickZone<std::string>> categoryZones;
 	
-	std::map<std::string, std::set<std::string>> catalog;
+	// The items in each category, sorted by name.
+	std::map<std::string, std::vector<Item>> catalog;
 	const std::vector<std::string> &categories;
 	std::set<std::string> &collapsed;
 	
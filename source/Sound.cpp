@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "File.h"
 #include "Files.h"
+#include "MemoryUsage.h"
 
 #ifndef __APPLE__
 #include <AL/al.h>
@@ -21,12 +22,20 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include <OpenAL/al.h>
 #endif
 
+#include <zlib.h>
+
+#include <cstdint>
 #include <cstdio>
 #include <vector>
 
 using namespace std;
 
 namespace {
+	// Sounds at least this large keep a compressed copy of their samples when
+	// they are loaded on demand, if compressing them saves enough memory.
+	const size_t COMPRESS_SIZE = 256 << 10;
+	
+	
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
 	// this will return 0.
@@ -39,16 +48,12 @@ namespace {
 
 bool Sound::Load(const string &path, const string &name)
 {
-	if(path.length() < 5 || path.compare(path.length() - 4, 4, ".wav"))
+	if(!Defer(path, name))
 		return false;
-	this->name = name;
-	
-	isLooped = path[path.length() - 5] == '~';
 	
 	File in(path);
 	if(!in)
 		return false;
-	uint32_t frequency = 0;
 	uint32_t bytes = ReadHeader(in, frequency);
 	if(!bytes)
 		return false;
@@ -57,15 +62,92 @@ bool Sound::Load(const string &path, const string &name)
 	if(fread(&data[0], 1, bytes, in) != bytes)
 		return false;
 	
-	if(!buffer)
-		alGenBuffers(1, &buffer);
-	alBufferData(buffer, AL_FORMAT_MONO16, &data.front(), bytes, frequency);
+	return Upload(&data.front(), bytes);
+}
+
+
+
+// Remember where this sound is to be loaded from, without loading it until
+// Reload() is called.
+bool Sound::Defer(const string &path, const string &name)
+{
+	if(path.length() < 5 || path.compare(path.length() - 4, 4, ".wav"))
+		return false;
+	this->name = name;
+	this->path = path;
 	
+	isLooped = path[path.length() - 5] == '~';
 	return true;
 }
 
 
 
+// Load a deferred or unloaded sound. A large sound keeps a compressed copy of
+// its samples in memory, so it can be reloaded without reading the file.
+bool Sound::Reload()
+{
+	if(buffer)
+		return true;
+	if(isBroken || path.empty())
+		return false;
+	
+	vector<char> data(compressedSize);
+	if(!compressed.empty())
+	{
+		uLongf bytes = data.size();
+		if(uncompress(reinterpret_cast<Bytef *>(&data.front()), &bytes,
+				reinterpret_cast<const Bytef *>(compressed.data()), compressed.size()) == Z_OK)
+			return Upload(&data.front(), bytes);
+		MemoryUsage::Add(MemoryUsage::SOUNDS, -static_cast<int64_t>(compressed.size()));
+		compressed.clear();
+	}
+	
+	File in(path);
+	uint32_t bytes = in ? ReadHeader(in, frequency) : 0;
+	data.resize(bytes);
+	if(!bytes || fread(&data[0], 1, bytes, in) != bytes)
+	{
+		// Only report the error once, rather than every time this is played.
+		isBroken = true;
+		Files::LogError("Unable to load sound \"" + name + "\" from path: " + path);
+		return false;
+	}
+	
+	// Sound effects are mostly noise, so they do not compress very well, but
+	// some of the long ones are mostly silence.
+	if(bytes >= COMPRESS_SIZE)
+	{
+		uLongf maxSize = compressBound(bytes);
+		compressed.resize(maxSize);
+		if(compress2(reinterpret_cast<Bytef *>(&compressed[0]), &maxSize,
+				reinterpret_cast<const Bytef *>(&data.front()), bytes, Z_BEST_SPEED) == Z_OK
+				&& maxSize < bytes - bytes / 4)
+		{
+			compressed.resize(maxSize);
+			compressed.shrink_to_fit();
+			compressedSize = bytes;
+			MemoryUsage::Add(MemoryUsage::SOUNDS, compressed.size());
+		}
+		else
+			compressed.clear();
+	}
+	return Upload(&data.front(), bytes);
+}
+
+
+
+// Free the OpenAL buffer. This must not be done while any source uses it.
+void Sound::Unload()
+{
+	if(buffer)
+		alDeleteBuffers(1, &buffer);
+	buffer = 0;
+	MemoryUsage::Add(MemoryUsage::SOUNDS, -static_cast<int64_t>(size));
+	size = 0;
+}
+
+
+
 const string &Sound::Name() const
 {
 	return name;
@@ -87,6 +169,26 @@ bool Sound::IsLooping() const
 
 
 
+// Get the size of the samples, in bytes, if they are loaded.
+size_t Sound::Size() const
+{
+	return size;
+}
+
+
+
+bool Sound::Upload(const char *data, size_t bytes)
+{
+	if(!buffer)
+		alGenBuffers(1, &buffer);
+	alBufferData(buffer, AL_FORMAT_MONO16, data, bytes, frequency);
+	MemoryUsage::Add(MemoryUsage::SOUNDS, static_cast<int64_t>(bytes) - static_cast<int64_t>(size));
+	size = bytes;
+	return true;
+}
+
+
+
 namespace {
 	// Read a WAV header, and return the size of the data, in bytes. If the file
 	// is an unsupported format (anything but little-endian 16-bit PCM at 44100 HZ),
@@ -13,26 +13,49 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef SOUND_H_
 #define SOUND_H_
 
+#include <cstdint>
 #include <string>
 
 
 
 // This is a sound that can be played. The sound's file name will determine
-// whether it is looping (ends in '~') or not.
+// whether it is looping (ends in '~') or not. A sound can also be loaded only
+// once it is needed, and unloaded again to free up memory.
 class Sound {
 public:
 	bool Load(const std::string &path, const std::string &name);
+	// Remember where this sound is to be loaded from, without loading it until
+	// Reload() is called.
+	bool Defer(const std::string &path, const std::string &name);
+	// Load a deferred or unloaded sound. A large sound keeps a compressed copy
+	// of its samples in memory, so it can be reloaded without reading the file.
+	bool Reload();
+	// Free the OpenAL buffer. This must not be done while any source uses it.
+	void Unload();
 	
 	const std::string &Name() const;
 	
 	unsigned Buffer() const;
 	bool IsLooping() const;
+	// Get the size of the samples, in bytes, if they are loaded.
+	size_t Size() const;
+	
+	
+private:
+	bool Upload(const char *data, size_t bytes);
 	
 	
 private:
 	std::string name;
+	std::string path;
 	unsigned buffer = 0;
 	bool isLooped = false;
+	bool isBroken = false;
+	uint32_t frequency = 0;
+	size_t size = 0;
+	// A compressed copy of the samples, and their size once decompressed.
+	std::string compressed;
+	size_t compressedSize = 0;
 };
 
 
@@ -12,21 +12,48 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Sprite.h"
 
+#include "CompressedImage.h"
 #include "ImageBuffer.h"
+#include "MemoryUsage.h"
 #include "Preferences.h"
 #include "Screen.h"
+#include "SpriteAtlas.h"
 
 #include "gl_header.h"
 #include <SDL2/SDL.h>
 
+// Some OpenGL headers do not define the constants for extensions.
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 #include <algorithm>
+#include <cstdint>
 
 using namespace std;
 
+namespace {
+	// Check whether the graphics card can draw DXT5 textures. This is not part
+	// of the OpenGL standard, but nearly every desktop graphics card has it.
+	bool HasCompression()
+	{
+		static const bool hasCompression = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc");
+		return hasCompression;
+	}
+	
+	int64_t MaskBytes(const vector<Mask> &masks)
+	{
+		int64_t bytes = 0;
+		for(const Mask &mask : masks)
+			bytes += mask.Bytes();
+		return bytes;
+	}
+}
+
 
 
 Sprite::Sprite(const string &name)
-	: name(name)
+	: name(name), drawn(false)
 {
 }
 
@@ -54,6 +81,14 @@ void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
 		frames = buffer.Frames();
 	}
 	
+	// When running without a window (e.g. for benchmarking), there is nowhere
+	// to upload the textures to, so only the dimensions and masks are kept.
+	if(!SDL_GL_GetCurrentContext())
+	{
+		buffer.Clear();
+		return;
+	}
+	
 	// Check whether this sprite is large enough to require size reduction.
 	if(Preferences::Has("Reduce large graphics") && buffer.Width() * buffer.Height() >= 1000000)
 		buffer.ShrinkToHalfSize();
@@ -75,6 +110,15 @@ void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
 	
 	// Unbind the texture.
 	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	size_t bytes = sizeof(uint32_t) * buffer.Width() * buffer.Height() * buffer.Frames();
+	textureBytes += bytes;
+	MemoryUsage::Add(MemoryUsage::TEXTURES, bytes);
+	
+	// Small sprites are also copied into the atlas, so they can be drawn in
+	// batches. That copy is kept even if this sprite's own texture is unloaded
+	// and reloaded later.
+	if(!atlas[is2x] && SpriteAtlas::IsEligible(name, buffer.Width(), buffer.Height(), buffer.Frames(), is2x))
+		atlas[is2x] = SpriteAtlas::Add(buffer, atlasCoordinates[is2x]);
 	
 	// Free the ImageBuffer memory.
 	buffer.Clear();
@@ -82,10 +126,66 @@ void Sprite::AddFrames(ImageBuffer &buffer, bool is2x)
 
 
 
+// Upload frames that were compressed ahead of time.
+void Sprite::AddFrames(const CompressedImage &image, bool is2x)
+{
+	// Do nothing if there are no frames.
+	if(!image.Frames())
+		return;
+	
+	// If this is the 1x image, its dimensions determine the sprite's size.
+	if(!is2x)
+	{
+		width = image.Width();
+		height = image.Height();
+		frames = image.Frames();
+	}
+	
+	if(!SDL_GL_GetCurrentContext())
+		return;
+	
+	// If the graphics card cannot use the compressed frames directly, they must
+	// be decoded and uploaded the same way as any other image.
+	if(!HasCompression())
+	{
+		ImageBuffer buffer;
+		image.Decompress(buffer);
+		AddFrames(buffer, is2x);
+		return;
+	}
+	
+	glGenTextures(1, &texture[is2x]);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture[is2x]);
+	
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	
+	glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+		image.Width(), image.Height(), image.Frames(), 0, image.Data().size(), image.Data().data());
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	textureBytes += image.Data().size();
+	MemoryUsage::Add(MemoryUsage::TEXTURES, image.Data().size());
+	
+	// The atlas is not compressed, so the frames must be decoded to copy them
+	// into it. That only happens the first time this sprite is loaded.
+	if(!atlas[is2x] && SpriteAtlas::IsEligible(name, image.Width(), image.Height(), image.Frames(), is2x))
+	{
+		ImageBuffer buffer;
+		image.Decompress(buffer);
+		atlas[is2x] = SpriteAtlas::Add(buffer, atlasCoordinates[is2x]);
+	}
+}
+
+
+
 // Move the given masks into this sprite's internal storage. The given
 // vector will be cleared.
 void Sprite::AddMasks(vector<Mask> &masks)
 {
+	MemoryUsage::Add(MemoryUsage::MASKS, MaskBytes(masks) - MaskBytes(this->masks));
 	this->masks.swap(masks);
 	masks.clear();
 }
@@ -95,9 +195,14 @@ void Sprite::AddMasks(vector<Mask> &masks)
 // Free up all textures loaded for this sprite.
 void Sprite::Unload()
 {
-	glDeleteTextures(2, texture);
-	texture[0] = texture[1] = 0;
+	UnloadTextures();
 	
+	// The space this sprite took up in the atlas is not reclaimed, but if the
+	// sprite is loaded again it should get a fresh copy.
+	atlas[0] = atlas[1] = 0;
+	atlasCoordinates[0].clear();
+	atlasCoordinates[1].clear();
+	MemoryUsage::Add(MemoryUsage::MASKS, -MaskBytes(masks));
 	masks.clear();
 	width = 0.f;
 	height = 0.f;
@@ -106,6 +211,44 @@ void Sprite::Unload()
 
 
 
+// Set the dimensions of a sprite whose frames are not loaded yet.
+void Sprite::SetSize(float width, float height, int frames)
+{
+	this->width = width;
+	this->height = height;
+	this->frames = frames;
+}
+
+
+
+// Free up the textures, but keep the dimensions and collision masks.
+void Sprite::UnloadTextures()
+{
+	glDeleteTextures(2, texture);
+	texture[0] = texture[1] = 0;
+	MemoryUsage::Add(MemoryUsage::TEXTURES, -static_cast<int64_t>(textureBytes));
+	textureBytes = 0;
+}
+
+
+
+// Get the amount of texture memory that this sprite is using, in bytes.
+size_t Sprite::TextureBytes() const
+{
+	return textureBytes;
+}
+
+
+
+// Check whether this sprite's texture has been asked for since the last time
+// this was called.
+bool Sprite::CheckDrawn()
+{
+	return drawn.exchange(false, memory_order_relaxed);
+}
+
+
+
 // Get the width, in pixels, of the 1x image.
 float Sprite::Width() const
 {
@@ -150,11 +293,31 @@ uint32_t Sprite::Texture() const
 // Get the index of the texture for the given high DPI mode.
 uint32_t Sprite::Texture(bool isHighDPI) const
 {
+	drawn.store(true, memory_order_relaxed);
 	return (isHighDPI && texture[1]) ? texture[1] : texture[0];
 }
 
 
 
+// Get the shared atlas texture that this sprite's frames were packed into, or
+// zero if they were not.
+uint32_t Sprite::AtlasTexture(bool isHighDPI) const
+{
+	int index = AtlasIndex(isHighDPI);
+	return (index < 0) ? 0 : atlas[index];
+}
+
+
+
+// Get the texture coordinates of each frame in the atlas.
+const float *Sprite::AtlasCoordinates(bool isHighDPI) const
+{
+	int index = AtlasIndex(isHighDPI);
+	return (index < 0) ? nullptr : atlasCoordinates[index].data();
+}
+
+
+
 // Get the collision mask for the given frame of the animation.
 const Mask &Sprite::GetMask(int frame) const
 {
@@ -165,3 +328,17 @@ const Mask &Sprite::GetMask(int frame) const
 	// Assume that if a masks array exists, it has the right number of frames.
 	return masks[frame % masks.size()];
 }
+
+
+
+// Check which resolution of the atlas should be used, or -1 if none.
+int Sprite::AtlasIndex(bool isHighDPI) const
+{
+	if(isHighDPI && atlas[1])
+		return 1;
+	// If this sprite's own @2x texture is loaded but it was too big for the
+	// atlas, drawing from the 1x copy in the atlas would look blurry.
+	if(isHighDPI && texture[1])
+		return -1;
+	return atlas[0] ? 0 : -1;
+}
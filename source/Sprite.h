@@ -16,10 +16,13 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Mask.h"
 #include "Point.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+class CompressedImage;
 class ImageBuffer;
 
 
@@ -38,12 +41,25 @@ public:
 	
 	// Upload the given frames. The given buffer will be cleared afterwards.
 	void AddFrames(ImageBuffer &buffer, bool is2x);
+	// Upload frames that were compressed ahead of time.
+	void AddFrames(const CompressedImage &image, bool is2x);
 	// Move the given masks into this sprite's internal storage. The given
 	// vector will be cleared.
 	void AddMasks(std::vector<Mask> &masks);
 	// Free up all textures loaded for this sprite.
 	void Unload();
 	
+	// Functions for sprites whose textures are streamed in only when they are
+	// drawn. Set the dimensions of a sprite whose frames are not loaded yet:
+	void SetSize(float width, float height, int frames);
+	// Free up the textures, but keep the dimensions and collision masks.
+	void UnloadTextures();
+	// Get the amount of texture memory that this sprite is using, in bytes.
+	size_t TextureBytes() const;
+	// Check whether this sprite's texture has been asked for (i.e. the sprite
+	// has been drawn) since the last time this was called.
+	bool CheckDrawn();
+	
 	// Image dimensions, in pixels.
 	float Width() const;
 	float Height() const;
@@ -59,19 +75,38 @@ public:
 	// setting or specifying it manually.
 	uint32_t Texture() const;
 	uint32_t Texture(bool isHighDPI) const;
+	// Get the shared atlas texture that this sprite's frames were packed into,
+	// or zero if they were not. Unlike Texture(), this does not count as the
+	// sprite being drawn, because the atlas is never unloaded.
+	uint32_t AtlasTexture(bool isHighDPI) const;
+	// Get the texture coordinates of each frame in the atlas, as four values
+	// (left, top, right, bottom) per frame.
+	const float *AtlasCoordinates(bool isHighDPI) const;
 	// Get the collision mask for the given frame of the animation.
 	const Mask &GetMask(int frame = 0) const;
 	
 	
+private:
+	// Check which resolution of the atlas should be used, or -1 if none.
+	int AtlasIndex(bool isHighDPI) const;
+	
+	
 private:
 	std::string name;
 	
 	uint32_t texture[2] = {0, 0};
 	std::vector<Mask> masks;
+	// Small sprites are also copied into a shared texture atlas.
+	uint32_t atlas[2] = {0, 0};
+	std::vector<float> atlasCoordinates[2];
 	
 	float width = 0.f;
 	float height = 0.f;
 	int frames = 0;
+	
+	size_t textureBytes = 0;
+	// This may be set by whichever thread is building a list of things to draw.
+	mutable std::atomic<bool> drawn;
 };
 
 
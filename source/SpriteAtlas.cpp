@@ -0,0 +1,183 @@
+/* SpriteAtlas.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "SpriteAtlas.h"
+
+#include "ImageBuffer.h"
+#include "MemoryUsage.h"
+
+#include "gl_header.h"
+
+using namespace std;
+
+namespace {
+	// Each page of the atlas is a square texture of this size.
+	const int PAGE_SIZE = 2048;
+	// Each frame is surrounded by a transparent border, so that the linear
+	// interpolation at its edges does not pick up pixels from its neighbors.
+	const int PADDING = 1;
+	// Only frames up to this size (in 1x pixels) are packed, and only if all
+	// the frames together take up a small fraction of a page.
+	const int MAX_SIZE = 256;
+	const int MAX_AREA = PAGE_SIZE * PAGE_SIZE / 8;
+	
+	// A shelf is a horizontal strip of a page. Frames are packed into it from
+	// left to right.
+	class Shelf {
+	public:
+		int y;
+		int height;
+		int width;
+	};
+	
+	class Page {
+	public:
+		uint32_t texture = 0;
+		vector<Shelf> shelves;
+		// The y coordinate of the first row that no shelf covers yet.
+		int bottom = 0;
+	};
+	
+	vector<Page> pages;
+	
+	
+	
+	// Find room for the given number of frames of the given size in the given
+	// page. If they all fit, the page is updated and the top left corner of
+	// each frame is stored in the given vector.
+	bool Fit(Page &page, int width, int height, int frames, vector<int> &corners)
+	{
+		Page result = page;
+		corners.clear();
+		for(int i = 0; i < frames; ++i)
+		{
+			// Use the first shelf that is tall enough for this frame, but not so
+			// tall that a lot of space would be wasted above it.
+			Shelf *shelf = nullptr;
+			for(Shelf &it : result.shelves)
+				if(it.height >= height && it.height <= height + height / 4 + 2 * PADDING
+						&& it.width + width <= PAGE_SIZE)
+				{
+					shelf = &it;
+					break;
+				}
+			if(!shelf)
+			{
+				if(result.bottom + height > PAGE_SIZE)
+					return false;
+				result.shelves.push_back(Shelf{result.bottom, height, 0});
+				result.bottom += height;
+				shelf = &result.shelves.back();
+			}
+			corners.push_back(shelf->width);
+			corners.push_back(shelf->y);
+			shelf->width += width;
+		}
+		page = result;
+		return true;
+	}
+	
+	
+	
+	// Create a new, empty atlas page.
+	void AddPage()
+	{
+		pages.emplace_back();
+		Page &page = pages.back();
+		
+		glGenTextures(1, &page.texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.texture);
+		
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		
+		// The padding around each frame must be transparent, so start out with
+		// a page that is entirely transparent.
+		vector<uint32_t> empty(PAGE_SIZE * PAGE_SIZE, 0);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, PAGE_SIZE, PAGE_SIZE, 1,
+			0, GL_BGRA, GL_UNSIGNED_BYTE, empty.data());
+		
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		MemoryUsage::Add(MemoryUsage::TEXTURES, empty.size() * sizeof(uint32_t));
+	}
+}
+
+
+
+// Check whether a sprite with the given name and frame dimensions should be
+// packed into the atlas.
+bool SpriteAtlas::IsEligible(const string &name, int width, int height, int frames, bool is2x)
+{
+	if(name.compare(0, 11, "projectile/") && name.compare(0, 7, "effect/"))
+		return false;
+	
+	int maxSize = MAX_SIZE * (1 + is2x);
+	if(width > maxSize || height > maxSize)
+		return false;
+	
+	int area = (width + 2 * PADDING) * (height + 2 * PADDING) * frames;
+	return area <= MAX_AREA;
+}
+
+
+
+// Copy all the frames of the given image into the atlas, and return the texture
+// that they were copied into (or zero if they did not fit). For each frame, four
+// texture coordinates (left, top, right, bottom) are put in the given vector.
+uint32_t SpriteAtlas::Add(const ImageBuffer &buffer, vector<float> &coordinates)
+{
+	coordinates.clear();
+	int width = buffer.Width();
+	int height = buffer.Height();
+	int frames = buffer.Frames();
+	if(!buffer.Pixels() || width + 2 * PADDING > PAGE_SIZE || height + 2 * PADDING > PAGE_SIZE)
+		return 0;
+	
+	// All the frames must be in the same page, so that the shader can blend
+	// between them. Try to fit them into each existing page, and only start a
+	// new page if none of them has room.
+	vector<int> corners;
+	Page *page = nullptr;
+	for(Page &it : pages)
+		if(Fit(it, width + 2 * PADDING, height + 2 * PADDING, frames, corners))
+		{
+			page = &it;
+			break;
+		}
+	if(!page)
+	{
+		AddPage();
+		page = &pages.back();
+		if(!Fit(*page, width + 2 * PADDING, height + 2 * PADDING, frames, corners))
+			return 0;
+	}
+	
+	glBindTexture(GL_TEXTURE_2D_ARRAY, page->texture);
+	const double scale = 1. / PAGE_SIZE;
+	for(int i = 0; i < frames; ++i)
+	{
+		int x = corners[2 * i] + PADDING;
+		int y = corners[2 * i + 1] + PADDING;
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, 0, width, height, 1,
+			GL_BGRA, GL_UNSIGNED_BYTE, buffer.Pixels() + i * width * height);
+		
+		coordinates.push_back(x * scale);
+		coordinates.push_back(y * scale);
+		coordinates.push_back((x + width) * scale);
+		coordinates.push_back((y + height) * scale);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	
+	return page->texture;
+}
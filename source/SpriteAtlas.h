@@ -0,0 +1,46 @@
+/* SpriteAtlas.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef SPRITE_ATLAS_H_
+#define SPRITE_ATLAS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ImageBuffer;
+
+
+
+// Class that packs the frames of small projectile and effect sprites into a few
+// large, shared textures. Each of those textures is a single-layer array
+// texture, so it can be drawn by the same shaders as any other sprite. Drawing
+// sprites out of the atlas means that all the projectiles and visual effects on
+// the screen can be drawn with just a handful of draw calls, rather than one
+// for every different sprite. Space in the atlas is never reclaimed, so each
+// sprite's frames are only copied into it once, even if the sprite's own
+// texture is unloaded and loaded again later.
+class SpriteAtlas {
+public:
+	// Check whether a sprite with the given name and frame dimensions should
+	// be packed into the atlas.
+	static bool IsEligible(const std::string &name, int width, int height, int frames, bool is2x);
+	// Copy all the frames of the given image into the atlas, and return the
+	// texture that they were copied into (or zero if they did not fit). For
+	// each frame, four texture coordinates (left, top, right, bottom) are put
+	// in the given vector.
+	static uint32_t Add(const ImageBuffer &buffer, std::vector<float> &coordinates);
+};
+
+
+
+#endif
@@ -17,20 +17,36 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Mask.h"
 #include "Sprite.h"
 #include "SpriteSet.h"
+#include "Threads.h"
+#include "Trace.h"
 
 #include <algorithm>
-#include <functional>
+#include <chrono>
+#include <utility>
 
 using namespace std;
 
-
-
-// Constructor, which allocates worker threads.
-SpriteQueue::SpriteQueue()
-{
-	threads.resize(max(4u, thread::hardware_concurrency()));
-	for(thread &t : threads)
-		t = thread(ref(*this));
+namespace {
+	// A streamed sprite that was drawn this recently may still be in a draw list
+	// that has not been drawn yet, so it must not be unloaded.
+	const int MIN_UNLOAD_AGE = 60;
+	
+	// Uploading a texture stalls the main thread, so each frame only uploads
+	// as many sprites as fit in this many bytes (but always at least one).
+	const size_t UPLOAD_BUDGET = 16 << 20;
+	const int MAX_UPLOADS = 100;
+	
+	// The decoding threads share the cores with the main thread, the thread
+	// that calculates each step, and the thread that loads the sounds.
+	const int OTHER_THREADS = 3;
+	// The reading thread stops once this many sprites per decoding thread are
+	// waiting to be decoded, so that it does not fill up memory with them.
+	const size_t DECODE_QUEUE_PER_THREAD = 2;
+	
+	double Elapsed(const chrono::steady_clock::time_point &start)
+	{
+		return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	}
 }
 
 
@@ -43,7 +59,10 @@ SpriteQueue::~SpriteQueue()
 		added = -1;
 	}
 	readCondition.notify_all();
-	for(thread &t : threads)
+	decodeCondition.notify_all();
+	if(readThread.joinable())
+		readThread.join();
+	for(thread &t : decodeThreads)
 		t.join();
 }
 
@@ -52,20 +71,50 @@ SpriteQueue::~SpriteQueue()
 // Add a sprite to load.
 void SpriteQueue::Add(const shared_ptr<ImageSet> &images)
 {
+	Add(images, false);
+}
+
+
+
+// Add a sprite that is not needed right away. These are only read once no other
+// sprites are waiting, and Progress() does not wait for them, but any that are
+// drawn before they are loaded are loaded right away.
+void SpriteQueue::AddBackground(const shared_ptr<ImageSet> &images)
+{
+	Background &entry = background[SpriteSet::Modify(images->Name())];
+	entry.images = images;
 	{
 		lock_guard<mutex> lock(readMutex);
 		// Do nothing if we are destroying the queue already.
 		if(added < 0)
 			return;
 		
-		toRead.push(images);
+		Start();
+		toReadLater.push_back(images);
 		++added;
+		++addedLater;
 	}
 	readCondition.notify_one();
 }
 
 
 
+// Load the given background sprite ahead of the other background sprites,
+// because it is likely to be needed soon.
+void SpriteQueue::Prioritize(const Sprite *sprite)
+{
+	if(!sprite)
+		return;
+	auto it = background.find(SpriteSet::Modify(sprite->Name()));
+	if(it == background.end() || it->second.isPromoted)
+		return;
+	
+	it->second.isPromoted = true;
+	Promote(it->second.images, false);
+}
+
+
+
 // Unload the texture for the given sprite (to free up memory).
 void SpriteQueue::Unload(const string &name)
 {
@@ -75,7 +124,99 @@ void SpriteQueue::Unload(const string &name)
 
 
 
-// Find out our percent completion.
+// Set the most texture memory that streamed sprites may use, in bytes.
+void SpriteQueue::SetTextureBudget(size_t bytes)
+{
+	textureBudget = bytes;
+}
+
+
+
+// Add a sprite that is streamed: unless it must be loaded right away, it is
+// not loaded until it is first drawn, and it may be unloaded again if it has
+// not been drawn recently and the textures are over budget.
+void SpriteQueue::AddStreamed(const shared_ptr<ImageSet> &images, bool loadNow)
+{
+	// A sprite that must be loaded right away is never unloaded. Loading it
+	// again would replace its collision masks while the calculation thread may
+	// be using them.
+	if(loadNow)
+	{
+		Add(images, false);
+		return;
+	}
+	
+	// Until a sprite is loaded, it only needs its dimensions.
+	Sprite *sprite = SpriteSet::Modify(images->Name());
+	Streamed &entry = streamed[sprite];
+	entry.images = images;
+	images->LoadSize(sprite);
+}
+
+
+
+// Start loading any streamed or background sprites that have been drawn, unload
+// the least recently drawn ones if over budget, and upload any that are now
+// loaded.
+void SpriteQueue::Stream()
+{
+	// A background sprite that is drawn before it is loaded jumps the queue,
+	// the same way a streamed one does.
+	for(auto &it : background)
+		if(!it.second.isPromoted && it.first->CheckDrawn())
+		{
+			it.second.isPromoted = true;
+			Promote(it.second.images, true);
+		}
+	
+	if(streamed.empty())
+		return;
+	
+	++step;
+	size_t used = 0;
+	vector<pair<int, Sprite *>> loaded;
+	for(auto &it : streamed)
+	{
+		Sprite *sprite = it.first;
+		Streamed &entry = it.second;
+		if(sprite->CheckDrawn())
+		{
+			entry.lastDrawn = step;
+			if(!entry.isQueued)
+			{
+				entry.isQueued = true;
+				Add(entry.images, true);
+			}
+		}
+		if(sprite->TextureBytes())
+		{
+			used += sprite->TextureBytes();
+			loaded.emplace_back(entry.lastDrawn, sprite);
+		}
+	}
+	
+	// Unload the least recently drawn sprites until the rest fit in the budget.
+	if(used > textureBudget)
+	{
+		sort(loaded.begin(), loaded.end());
+		for(const pair<int, Sprite *> &it : loaded)
+		{
+			if(used <= textureBudget || it.first > step - MIN_UNLOAD_AGE)
+				break;
+			
+			used -= it.second->TextureBytes();
+			it.second->UnloadTextures();
+			streamed[it.second].isQueued = false;
+		}
+	}
+	
+	// Upload any sprites that have finished loading.
+	Progress();
+}
+
+
+
+// Find out our percent completion, not counting the background sprites.
 double SpriteQueue::Progress()
 {
 	unique_lock<mutex> lock(loadMutex);
@@ -84,7 +225,17 @@ double SpriteQueue::Progress()
 
 
 
-// Finish loading.
+// Check whether every sprite, including the background ones, is loaded.
+bool SpriteQueue::IsDone()
+{
+	lock_guard<mutex> lock(loadMutex);
+	lock_guard<mutex> readLock(readMutex);
+	return added <= 0 || added == completed;
+}
+
+
+
+// Finish loading everything but the background sprites.
 void SpriteQueue::Finish()
 {
 	// Loop until done loading.
@@ -98,55 +249,186 @@ void SpriteQueue::Finish()
 		
 		// We still have sprites to upload, but none of them have been read from
 		// disk yet. Wait until one arrives.
-		loadCondition.wait(lock);
+		if(toLoad.empty())
+			loadCondition.wait(lock);
+	}
+}
+
+
+
+// Get the current loading statistics.
+SpriteQueue::Stats SpriteQueue::GetStats()
+{
+	Stats stats;
+	stats.decodeThreads = decodeThreads.size();
+	{
+		lock_guard<mutex> lock(loadMutex);
+		stats.toUpload = toLoad.size();
+	}
+	lock_guard<mutex> lock(readMutex);
+	stats.toRead = toRead.size() + toReadLater.size();
+	stats.toDecode = toDecode.size();
+	stats.bytesRead = bytesRead;
+	stats.readTime = readTime;
+	stats.decodeTime = decodeTime;
+	return stats;
+}
+
+
+
+// Start the worker threads, if they have not been started yet.
+void SpriteQueue::Start()
+{
+	if(readThread.joinable())
+		return;
+	
+	// The reading thread needs to know how many decoding threads there are, so
+	// the list of them must be filled in before it starts.
+	decodeThreads.resize(max(1, Threads::Workers(static_cast<int>(thread::hardware_concurrency()) - OTHER_THREADS)));
+	readThread = thread(&SpriteQueue::ReadThread, this);
+	for(thread &t : decodeThreads)
+		t = thread(&SpriteQueue::DecodeThread, this);
+}
+
+
+
+// Entry point for the thread that reads the files, one sprite at a time.
+void SpriteQueue::ReadThread()
+{
+	Threads::Scope threadScope("sprite reader", Threads::Priority::LOW);
+	const size_t maxWaiting = DECODE_QUEUE_PER_THREAD * decodeThreads.size();
+	unique_lock<mutex> lock(readMutex);
+	while(true)
+	{
+		// To signal this thread that it is time for it to quit, we set "added"
+		// to -1.
+		while(added >= 0 && ((toRead.empty() && toReadLater.empty()) || toDecode.size() >= maxWaiting))
+			readCondition.wait(lock);
+		if(added < 0)
+			return;
+		
+		// Extract the one item we should work on reading right now. The
+		// background sprites wait until nothing else is left.
+		shared_ptr<ImageSet> imageSet;
+		bool isUrgent = false;
+		if(!toRead.empty())
+		{
+			imageSet = toRead.front().first;
+			isUrgent = toRead.front().second;
+			toRead.pop_front();
+		}
+		else
+		{
+			imageSet = toReadLater.front();
+			toReadLater.pop_front();
+		}
+		
+		// It's now safe to add to the lists.
+		lock.unlock();
+		
+		auto start = chrono::steady_clock::now();
+		imageSet->Read();
+		double elapsed = Elapsed(start);
+		
+		lock.lock();
+		bytesRead += imageSet->ReadSize();
+		readTime += elapsed;
+		if(isUrgent)
+			toDecode.emplace_front(imageSet, true);
+		else
+			toDecode.emplace_back(imageSet, false);
+		decodeCondition.notify_one();
 	}
 }
 
 
 
-// Thread entry point.
-void SpriteQueue::operator()()
+// Entry point for the threads that decode the sprites once they are read.
+void SpriteQueue::DecodeThread()
 {
+	Threads::Scope threadScope("sprite decoder", Threads::Priority::LOW);
+	unique_lock<mutex> lock(readMutex);
 	while(true)
 	{
-		unique_lock<mutex> lock(readMutex);
-		while(true)
+		while(added >= 0 && toDecode.empty())
+			decodeCondition.wait(lock);
+		if(added < 0)
+			return;
+		
+		shared_ptr<ImageSet> imageSet = toDecode.front().first;
+		bool isUrgent = toDecode.front().second;
+		toDecode.pop_front();
+		// There is room in the queue for the reading thread to add another.
+		readCondition.notify_one();
+		lock.unlock();
+		
+		auto start = chrono::steady_clock::now();
+		imageSet->Load();
+		double elapsed = Elapsed(start);
+		
 		{
-			// To signal this thread that it is time for it to quit, we set
-			// "added" to -1.
-			if(added < 0)
-				return;
-			if(toRead.empty())
-				break;
-			
-			// Extract the one item we should work on reading right now.
-			shared_ptr<ImageSet> imageSet = toRead.front();
-			toRead.pop();
-			
-			// It's now safe to add to the lists.
-			lock.unlock();
-			
-			// Load the sprite.
-			imageSet->Load();
-			
-			{
-				// The texture must be uploaded to OpenGL in the main thread.
-				unique_lock<mutex> lock(loadMutex);
-				toLoad.push(imageSet);
-			}
-			loadCondition.notify_one();
-			
-			lock.lock();
+			// The texture must be uploaded to OpenGL in the main thread.
+			unique_lock<mutex> lock(loadMutex);
+			if(isUrgent)
+				toLoad.push_front(imageSet);
+			else
+				toLoad.push_back(imageSet);
 		}
+		loadCondition.notify_one();
 		
-		readCondition.wait(lock);
+		lock.lock();
+		decodeTime += elapsed;
 	}
 }
 
 
 
+// Add a sprite to load. If it is urgent (because it is on screen and has not
+// been loaded yet), it goes to the front of the queue.
+void SpriteQueue::Add(const shared_ptr<ImageSet> &images, bool isUrgent)
+{
+	{
+		lock_guard<mutex> lock(readMutex);
+		// Do nothing if we are destroying the queue already.
+		if(added < 0)
+			return;
+		
+		Start();
+		if(isUrgent)
+			toRead.emplace_front(images, true);
+		else
+			toRead.emplace_back(images, false);
+		++added;
+	}
+	readCondition.notify_one();
+}
+
+
+
+// Move a background sprite that has not been read yet into the main queue. If
+// it is already being read or decoded, it will be done soon anyway.
+void SpriteQueue::Promote(const shared_ptr<ImageSet> &images, bool isUrgent)
+{
+	{
+		lock_guard<mutex> lock(readMutex);
+		auto it = find(toReadLater.begin(), toReadLater.end(), images);
+		if(it == toReadLater.end())
+			return;
+		
+		toReadLater.erase(it);
+		if(isUrgent)
+			toRead.emplace_front(images, true);
+		else
+			toRead.emplace_back(images, false);
+	}
+	readCondition.notify_one();
+}
+
+
+
 double SpriteQueue::DoLoad(unique_lock<mutex> &lock)
 {
+	TRACE_SCOPE("SpriteQueue::DoLoad");
 	while(!toUnload.empty())
 	{
 		Sprite *sprite = SpriteSet::Modify(toUnload.front());
@@ -157,26 +439,50 @@ double SpriteQueue::DoLoad(unique_lock<mutex> &lock)
 		lock.lock();
 	}
 	
-	for(int i = 0; !toLoad.empty() && i < 100; ++i)
+	// If the @2x frames are needed now, load them for any sprites that skipped
+	// them. A sprite whose textures have been unloaded since then will get them
+	// the next time it is loaded.
+	if(!without2x.empty() && ImageSet::Uses2x())
+	{
+		for(const shared_ptr<ImageSet> &imageSet : without2x)
+			if(imageSet->Skipped2x() && SpriteSet::Get(imageSet->Name())->TextureBytes())
+			{
+				imageSet->Set2xOnly();
+				Add(imageSet, false);
+			}
+		without2x.clear();
+	}
+	
+	size_t uploaded = 0;
+	for(int i = 0; !toLoad.empty() && i < MAX_UPLOADS && uploaded < UPLOAD_BUDGET; ++i)
 	{
 		// Extract the one item we should work on uploading right now.
 		shared_ptr<ImageSet> imageSet = toLoad.front();
-		toLoad.pop();
+		toLoad.pop_front();
 		
 		// It's now safe to modify the lists.
 		lock.unlock();
 		
-		imageSet->Upload(SpriteSet::Modify(imageSet->Name()));
+		Sprite *sprite = SpriteSet::Modify(imageSet->Name());
+		uploaded += imageSet->UploadSize();
+		imageSet->Upload(sprite);
 		
 		lock.lock();
 		++completed;
+		if(background.erase(sprite))
+			++completedLater;
+		if(imageSet->Skipped2x())
+			without2x.push_back(imageSet);
 	}
 	
-	// Wait until we have completed loading of as many sprites as we have added.
-	// The value of "added" is protected by readMutex.
+	// Wait until we have completed loading of as many sprites as we have added,
+	// not counting the background ones. The value of "added" is protected by
+	// readMutex.
 	unique_lock<mutex> readLock(readMutex);
+	int needed = added - addedLater;
+	int done = completed - completedLater;
 	// Special cases: we're bailing out, or we are done.
-	if(added <= 0 || added == completed)
+	if(added <= 0 || needed <= done)
 		return 1.;
-	return static_cast<double>(completed) / static_cast<double>(added);
+	return static_cast<double>(done) / static_cast<double>(needed);
 }
@@ -14,12 +14,14 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #define SPRITE_QUEUE_H_
 
 #include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 class ImageBuffer;
@@ -30,47 +32,137 @@ class Sprite;
 
 
 // Class for queuing up a list of sprites to be loaded from the disk, with a set of
-// worker threads that begins loading them as soon as they are added.
+// worker threads that begins loading them as soon as they are added. One thread
+// reads the files, in the order that the sprites were added, and the others
+// decode them. The threads are started when the first sprite is added, so that
+// the number of them can be configured first.
 class SpriteQueue {
 public:
-	SpriteQueue();
+	// Statistics on how far along the loading is and how fast it is going.
+	class Stats {
+	public:
+		// The number of sprites waiting to be read, decoded, and uploaded.
+		size_t toRead = 0;
+		size_t toDecode = 0;
+		size_t toUpload = 0;
+		// The number of bytes read so far, and the total number of seconds
+		// spent reading and decoding (summed over all the decoding threads).
+		size_t bytesRead = 0;
+		double readTime = 0.;
+		double decodeTime = 0.;
+		int decodeThreads = 0;
+	};
+	
+	
+public:
 	~SpriteQueue();
 	
 	// Add a sprite to load.
 	void Add(const std::shared_ptr<ImageSet> &images);
+	// Add a sprite that is not needed right away. These are only read once no
+	// other sprites are waiting, and Progress() does not wait for them, but
+	// any that are drawn before they are loaded are loaded right away.
+	void AddBackground(const std::shared_ptr<ImageSet> &images);
+	// Load the given background sprite ahead of the other background sprites,
+	// because it is likely to be needed soon.
+	void Prioritize(const Sprite *sprite);
 	// Unload the texture for the given sprite (to free up memory).
 	void Unload(const std::string &name);
-	// Upload more iamges and find out our percent completion.
+	
+	// Set the most texture memory that streamed sprites may use, in bytes.
+	void SetTextureBudget(size_t bytes);
+	// Add a sprite that is streamed: unless it must be loaded right away, it is
+	// not loaded until it is first drawn, and it may be unloaded again if it has
+	// not been drawn recently and the textures are over budget. Sprites that
+	// must be loaded right away are never unloaded.
+	void AddStreamed(const std::shared_ptr<ImageSet> &images, bool loadNow);
+	// Start loading any streamed or background sprites that have been drawn,
+	// unload the least recently drawn ones if over budget, and upload any that
+	// are now loaded. This must be called from the main thread, once per frame.
+	void Stream();
+	// Upload more iamges and find out our percent completion, not counting the
+	// background sprites.
 	double Progress();
-	// Finish loading.
+	// Check whether every sprite, including the background ones, is loaded.
+	bool IsDone();
+	// Finish loading everything but the background sprites.
 	void Finish();
-	
-	// Thread entry point.
-	void operator()();
+	// Get the current loading statistics.
+	Stats GetStats();
 	
 	
 private:
+	// Start the worker threads, if they have not been started yet.
+	void Start();
+	// Thread entry points.
+	void ReadThread();
+	void DecodeThread();
+	
+	// Add a sprite to load. If it is urgent (because it is on screen and
+	// has not been loaded yet), it goes to the front of the queue.
+	void Add(const std::shared_ptr<ImageSet> &images, bool isUrgent);
+	// Move a background sprite that has not been read yet into the main queue.
+	void Promote(const std::shared_ptr<ImageSet> &images, bool isUrgent);
 	double DoLoad(std::unique_lock<std::mutex> &lock);
 	
 	
 private:
-	// These are the image sets that need to be loaded from disk.
-	std::queue<std::shared_ptr<ImageSet>> toRead;
+	// These are the image sets that need to be loaded from disk, and whether
+	// each of them is urgent.
+	std::deque<std::pair<std::shared_ptr<ImageSet>, bool>> toRead;
 	std::mutex readMutex;
 	std::condition_variable readCondition;
 	int added = 0;
+	// Background sprites are only read once the queue above is empty. They
+	// are counted in "added," but also here.
+	std::deque<std::shared_ptr<ImageSet>> toReadLater;
+	int addedLater = 0;
+	
+	// These image sets have been read but not decoded. They are protected by
+	// the same mutex as the ones to be read, so that the reading thread can
+	// stop reading when too many of them are waiting.
+	std::deque<std::pair<std::shared_ptr<ImageSet>, bool>> toDecode;
+	std::condition_variable decodeCondition;
+	size_t bytesRead = 0;
+	double readTime = 0.;
+	double decodeTime = 0.;
 	
 	// These image sets have been loaded from disk but have not been uplodaed.
-	std::queue<std::shared_ptr<ImageSet>> toLoad;
+	std::deque<std::shared_ptr<ImageSet>> toLoad;
 	std::mutex loadMutex;
 	std::condition_variable loadCondition;
 	int completed = 0;
 	
 	// These sprites must be unloaded to reclaim GPU memory.
 	std::queue<std::string> toUnload;
+	// These sprites were uploaded without their @2x frames, which must be
+	// loaded if the screen or the zoom changes so that they are needed.
+	std::vector<std::shared_ptr<ImageSet>> without2x;
+	
+	// Streamed sprites, with the step in which each one was last drawn. These
+	// are only used by the main thread.
+	struct Streamed {
+		std::shared_ptr<ImageSet> images;
+		int lastDrawn = 0;
+		bool isQueued = false;
+	};
+	std::map<Sprite *, Streamed> streamed;
+	size_t textureBudget = 0;
+	int step = 0;
+	
+	// Background sprites that have not been uploaded yet, and whether each one
+	// has been moved ahead of the others. These are also only used by the main
+	// thread, as is the count of the ones that have been uploaded.
+	struct Background {
+		std::shared_ptr<ImageSet> images;
+		bool isPromoted = false;
+	};
+	std::map<Sprite *, Background> background;
+	int completedLater = 0;
 	
-	// Worker threads for loading sprites from disk.
-	std::vector<std::thread> threads;
+	// Worker threads for reading sprites from disk and for decoding them.
+	std::thread readThread;
+	std::vector<std::thread> decodeThreads;
 };
 
 #endif
@@ -12,10 +12,12 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "SpriteShader.h"
 
+#include "GameWindow.h"
 #include "Point.h"
 #include "Screen.h"
 #include "Shader.h"
 #include "Sprite.h"
+#include "StreamBuffer.h"
 
 #include <vector>
 
@@ -34,6 +36,22 @@ namespace {
 	
 	GLuint vao;
 	GLuint vbo;
+	
+	// The instanced version of the shader gets all the parameters for each
+	// sprite from a vertex buffer, so a run of sprites that share a texture can
+	// be drawn with a single call.
+	Shader instancedShader;
+	GLint instancedScaleI;
+	GLint instancePositionI;
+	GLint instanceTransformI;
+	GLint instanceBlurI;
+	GLint instanceParametersI;
+	
+	GLuint instancedVao;
+	// Each instance has 12 floats: position (2), transform matrix (4), blur (2),
+	// and the clip, alpha, frame, and frame count.
+	const int INSTANCE_SIZE = 12;
+	vector<float> instanceData;
 
 	const vector<vector<GLint>> SWIZZLE = {
 		{GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA}, // red + yellow markings (republic)
@@ -70,12 +88,16 @@ void SpriteShader::Init()
 		"  fragTexCoord = vec2(texCoord.x, max(clip, texCoord.y)) + blurOff;\n"
 		"}\n";
 	
-	static const char *fragmentCode =
-		"uniform sampler2DArray tex;\n"
+	// The fragment shader is the same whether its inputs are uniforms or are
+	// passed in for each instance by the instanced vertex shader.
+	static const char *fragmentUniforms =
 		"uniform float frame;\n"
 		"uniform float frameCount;\n"
 		"uniform vec2 blur;\n"
-		"uniform float alpha;\n"
+		"uniform float alpha;\n";
+	
+	static const char *fragmentCode =
+		"uniform sampler2DArray tex;\n"
 		"const int range = 5;\n"
 		
 		"in vec2 fragTexCoord;\n"
@@ -115,7 +137,7 @@ void SpriteShader::Init()
 		"  finalColor = color * alpha;\n"
 		"}\n";
 	
-	shader = Shader(vertexCode, fragmentCode);
+	shader = Shader(vertexCode, (fragmentUniforms + string(fragmentCode)).c_str());
 	scaleI = shader.Uniform("scale");
 	frameI = shader.Uniform("frame");
 	frameCountI = shader.Uniform("frameCount");
@@ -150,6 +172,77 @@ void SpriteShader::Init()
 	// unbind the VBO and VAO
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindVertexArray(0);
+	
+	// If the graphics card supports it, also set up a shader that takes all
+	// the parameters that would be uniforms as per-instance vertex attributes.
+	if(!GameWindow::HasInstancing())
+		return;
+	
+	static const char *instancedVertexCode =
+		"uniform vec2 scale;\n"
+		
+		"in vec2 vert;\n"
+		"in vec2 instancePosition;\n"
+		"in vec4 instanceTransform;\n"
+		"in vec2 instanceBlur;\n"
+		"in vec4 instanceParameters;\n"
+		
+		"out vec2 fragTexCoord;\n"
+		"flat out float frame;\n"
+		"flat out float frameCount;\n"
+		"flat out vec2 blur;\n"
+		"flat out float alpha;\n"
+		
+		"void main() {\n"
+		"  mat2 transform = mat2(instanceTransform.xy, instanceTransform.zw);\n"
+		"  vec2 blurOff = 2 * vec2(vert.x * abs(instanceBlur.x), vert.y * abs(instanceBlur.y));\n"
+		"  gl_Position = vec4((transform * (vert + blurOff) + instancePosition) * scale, 0, 1);\n"
+		"  vec2 texCoord = vert + vec2(.5, .5);\n"
+		"  fragTexCoord = vec2(texCoord.x, max(instanceParameters.x, texCoord.y)) + blurOff;\n"
+		"  alpha = instanceParameters.y;\n"
+		"  frame = instanceParameters.z;\n"
+		"  frameCount = instanceParameters.w;\n"
+		"  blur = instanceBlur;\n"
+		"}\n";
+	
+	static const char *fragmentInputs =
+		"flat in float frame;\n"
+		"flat in float frameCount;\n"
+		"flat in vec2 blur;\n"
+		"flat in float alpha;\n";
+	
+	instancedShader = Shader(instancedVertexCode, (fragmentInputs + string(fragmentCode)).c_str());
+	instancedScaleI = instancedShader.Uniform("scale");
+	
+	glUseProgram(instancedShader.Object());
+	glUniform1i(instancedShader.Uniform("tex"), 0);
+	glUseProgram(0);
+	
+	glGenVertexArrays(1, &instancedVao);
+	glBindVertexArray(instancedVao);
+	
+	// The corners of the sprite come from the same buffer as above.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	GLint vertI = instancedShader.Attrib("vert");
+	glEnableVertexAttribArray(vertI);
+	glVertexAttribPointer(vertI, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), nullptr);
+	
+	// Everything else comes from the StreamBuffer, and advances once per
+	// sprite rather than once per vertex. The attribute pointers are set each
+	// time a run of instances is drawn, because each run starts at a different
+	// place in that buffer.
+	instancePositionI = instancedShader.Attrib("instancePosition");
+	instanceTransformI = instancedShader.Attrib("instanceTransform");
+	instanceBlurI = instancedShader.Attrib("instanceBlur");
+	instanceParametersI = instancedShader.Attrib("instanceParameters");
+	for(GLint attrib : {instancePositionI, instanceTransformI, instanceBlurI, instanceParametersI})
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
 }
 
 
@@ -192,6 +285,11 @@ void SpriteShader::Bind()
 
 void SpriteShader::Add(const Item &item, bool withBlur)
 {
+	// A sprite with no texture (e.g. one that is still being streamed in) would
+	// just be drawn as a black rectangle.
+	if(!item.texture)
+		return;
+	
 	glBindTexture(GL_TEXTURE_2D_ARRAY, item.texture);
 
 	glUniform1f(frameI, item.frame);
@@ -215,6 +313,86 @@ void SpriteShader::Add(const Item &item, bool withBlur)
 
 
 
+// Draw all the given items. If the graphics card supports instancing, each run
+// of consecutive items that share a texture and swizzle is drawn with a single
+// call; otherwise, each item is drawn separately.
+void SpriteShader::Draw(const vector<Item> &items, bool withBlur)
+{
+	if(!GameWindow::HasInstancing())
+	{
+		Bind();
+		for(const Item &item : items)
+			Add(item, withBlur);
+		Unbind();
+		return;
+	}
+	
+	// Gather the parameters for every item that has a texture to draw.
+	instanceData.clear();
+	vector<const Item *> drawn;
+	drawn.reserve(items.size());
+	for(const Item &item : items)
+	{
+		if(!item.texture)
+			continue;
+		drawn.push_back(&item);
+		
+		instanceData.insert(instanceData.end(), item.position, item.position + 2);
+		instanceData.insert(instanceData.end(), item.transform, item.transform + 4);
+		instanceData.push_back(withBlur ? item.blur[0] : 0.f);
+		instanceData.push_back(withBlur ? item.blur[1] : 0.f);
+		// Clipping has the opposite sense in the shader.
+		instanceData.push_back(1.f - item.clip);
+		instanceData.push_back(item.alpha);
+		instanceData.push_back(item.frame);
+		instanceData.push_back(item.frameCount);
+	}
+	if(drawn.empty())
+		return;
+	
+	glUseProgram(instancedShader.Object());
+	glBindVertexArray(instancedVao);
+	
+	GLfloat scale[2] = {2.f / Screen::Width(), -2.f / Screen::Height()};
+	glUniform2fv(instancedScaleI, 1, scale);
+	
+	// Upload the data for all the instances at once.
+	size_t base = StreamBuffer::Upload(instanceData.data(), sizeof(float) * instanceData.size());
+	
+	// The items must still be drawn in order, so only neighboring items that
+	// use the same texture and swizzle can be drawn together.
+	const GLsizei stride = INSTANCE_SIZE * sizeof(float);
+	for(size_t start = 0; start < drawn.size(); )
+	{
+		const Item &first = *drawn[start];
+		size_t end = start + 1;
+		while(end < drawn.size() && drawn[end]->texture == first.texture && drawn[end]->swizzle == first.swizzle)
+			++end;
+		
+		glBindTexture(GL_TEXTURE_2D_ARRAY, first.texture);
+		int swizzle = (static_cast<size_t>(first.swizzle) >= SWIZZLE.size() ? 0 : first.swizzle);
+		glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[swizzle].data());
+		
+		const char *offset = reinterpret_cast<const char *>(base + start * stride);
+		glVertexAttribPointer(instancePositionI, 2, GL_FLOAT, GL_FALSE, stride, offset);
+		glVertexAttribPointer(instanceTransformI, 4, GL_FLOAT, GL_FALSE, stride, offset + 2 * sizeof(float));
+		glVertexAttribPointer(instanceBlurI, 2, GL_FLOAT, GL_FALSE, stride, offset + 6 * sizeof(float));
+		glVertexAttribPointer(instanceParametersI, 4, GL_FLOAT, GL_FALSE, stride, offset + 8 * sizeof(float));
+		
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, end - start);
+		start = end;
+	}
+	
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+	
+	// Reset the swizzle.
+	glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, SWIZZLE[0].data());
+}
+
+
+
 void SpriteShader::Unbind()
 {
 	glBindVertexArray(0);
@@ -17,6 +17,7 @@ class Sprite;
 class Point;
 
 #include <cstdint>
+#include <vector>
 
 
 
@@ -51,6 +52,11 @@ public:
 	static void Bind();
 	static void Add(const Item &item, bool withBlur = false);
 	static void Unbind();
+	
+	// Draw a whole list of items. This batches items that share a texture into
+	// instanced draw calls if the graphics card supports that, and otherwise
+	// is equivalent to calling Add() for each one in turn.
+	static void Draw(const std::vector<Item> &items, bool withBlur = false);
 };
 
 
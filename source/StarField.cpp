@@ -91,7 +91,7 @@ void StarField::SetHaze(const Sprite *sprite)
 void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 {
 	// Draw the starfield unless it is disabled in the preferences.
-	if(Preferences::Has("Draw starfield"))
+	if(Preferences::Has(Preferences::DRAW_STARFIELD))
 	{
 		glUseProgram(shader.Object());
 		glBindVertexArray(vao);
@@ -126,20 +126,43 @@ void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 		minX &= ~(TILE_SIZE - 1l);
 		minY &= ~(TILE_SIZE - 1l);
 	
-		for(int gy = minY; gy < maxY; gy += TILE_SIZE)
-			for(int gx = minX; gx < maxX; gx += TILE_SIZE)
+		// The stars' positions are relative to the origin of the repeating
+		// pattern, so every visible tile in any one copy of the pattern can be
+		// drawn with a single call. The tiles of each row are contiguous in
+		// the vertex buffer, so each row only needs one range.
+		int width = widthMod + 1;
+		vector<GLint> firsts;
+		vector<GLsizei> counts;
+		for(int copyY = minY & ~widthMod; copyY < maxY; copyY += width)
+			for(int copyX = minX & ~widthMod; copyX < maxX; copyX += width)
 			{
-				Point off = Point(gx, gy) - pos;
+				int startCol = (max(minX, copyX) - copyX) / TILE_SIZE;
+				int endCol = (min(maxX, copyX + width) - copyX + TILE_SIZE - 1) / TILE_SIZE;
+				int startRow = (max(minY, copyY) - copyY) / TILE_SIZE;
+				int endRow = (min(maxY, copyY + width) - copyY + TILE_SIZE - 1) / TILE_SIZE;
+				
+				firsts.clear();
+				counts.clear();
+				for(int row = startRow; row < endRow; ++row)
+				{
+					int first = 6 * tileIndex[startCol + row * tileCols];
+					int end = 6 * tileIndex[endCol + row * tileCols];
+					if(end > first)
+					{
+						firsts.push_back(first);
+						counts.push_back(end - first);
+					}
+				}
+				if(firsts.empty())
+					continue;
+				
+				Point off = Point(copyX, copyY) - pos;
 				GLfloat translate[2] = {
 					static_cast<float>(off.X()),
 					static_cast<float>(off.Y())
 				};
 				glUniform2fv(translateI, 1, translate);
-				
-				int index = (gx & widthMod) / TILE_SIZE + ((gy & widthMod) / TILE_SIZE) * tileCols;
-				int first = 6 * tileIndex[index];
-				int count = 6 * tileIndex[index + 1] - first;
-				glDrawArrays(GL_TRIANGLES, first, count);
+				glMultiDrawArrays(GL_TRIANGLES, firsts.data(), counts.data(), firsts.size());
 			}
 	
 		glBindVertexArray(0);
@@ -147,7 +170,7 @@ void StarField::Draw(const Point &pos, const Point &vel, double zoom) const
 	}
 	
 	// Draw the background haze unless it is disabled in the preferences.
-	if(!Preferences::Has("Draw background haze"))
+	if(!Preferences::Has(Preferences::DRAW_BACKGROUND_HAZE))
 		return;
 	
 	DrawList drawList;
@@ -301,8 +324,8 @@ void StarField::MakeStars(int stars, int width)
 		
 		// Randomize its sub-pixel position and its size / brightness.
 		int random = Random::Int(4096);
-		float fx = (x & (TILE_SIZE - 1)) + (random & 15) * 0.0625f;
-		float fy = (y & (TILE_SIZE - 1)) + (random >> 8) * 0.0625f;
+		float fx = x + (random & 15) * 0.0625f;
+		float fy = y + (random >> 8) * 0.0625f;
 		float size = (((random >> 4) & 15) + 20) * 0.0625f;
 		
 		// Fill in the data array.
@@ -0,0 +1,167 @@
+/* StreamBuffer.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "StreamBuffer.h"
+
+#include "gl_header.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+	// The number of frames that may be in flight at once.
+	const int SECTIONS = 3;
+	// Each section starts out at this size, but the buffer is enlarged if any
+	// single frame needs more room than that.
+	const size_t INITIAL_SIZE = 1 << 20;
+	// Start each upload on a boundary that every vertex format can use.
+	const size_t ALIGNMENT = 16;
+	// Never wait more than this long (in nanoseconds) for a fence.
+	const GLuint64 TIMEOUT = 1000000000;
+	
+	GLuint buffer = 0;
+	size_t sectionSize = 0;
+	int section = 0;
+	size_t used = 0;
+	GLsync fences[SECTIONS] = {};
+	
+	bool hasFences = false;
+	bool hasPersistent = false;
+	// If the buffer can be persistently mapped, it is mapped once when it is
+	// created, and data is copied directly into that memory.
+	char *mapped = nullptr;
+	
+	
+	
+	// Create a new buffer with the given section size.
+	void Create(size_t size)
+	{
+		for(GLsync &fence : fences)
+			if(fence)
+			{
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		// Any commands already issued that use the old buffer keep it alive
+		// until they are done, so it is safe to delete it right away.
+		if(buffer)
+			glDeleteBuffers(1, &buffer);
+		
+		sectionSize = size;
+		section = 0;
+		used = 0;
+		mapped = nullptr;
+		
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+#ifdef GL_MAP_PERSISTENT_BIT
+		if(hasPersistent)
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, SECTIONS * size, nullptr, flags);
+			mapped = static_cast<char *>(glMapBufferRange(GL_ARRAY_BUFFER, 0, SECTIONS * size, flags));
+		}
+		if(!mapped)
+#endif
+			glBufferData(GL_ARRAY_BUFFER, SECTIONS * size, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+
+
+// Create the buffer. This must be called after the OpenGL context exists.
+void StreamBuffer::Init()
+{
+	// Fences are part of OpenGL 3.2, and persistent mapping of OpenGL 4.4.
+	GLint major = 0;
+	GLint minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	hasFences = (major > 3 || (major == 3 && minor >= 2));
+	hasPersistent = (major > 4 || (major == 4 && minor >= 4));
+	
+	Create(INITIAL_SIZE);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+
+// Mark the end of a frame. All the data uploaded since the last call to this
+// function is not touched again until the graphics card is done with it.
+void StreamBuffer::EndFrame()
+{
+	if(!buffer || !hasFences)
+		return;
+	
+	if(fences[section])
+		glDeleteSync(fences[section]);
+	fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	
+	// Move on to the next section, waiting if the frame that last used it is
+	// still being drawn. With three sections, that should almost never happen.
+	section = (section + 1) % SECTIONS;
+	used = 0;
+	if(fences[section])
+	{
+		glClientWaitSync(fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT);
+		glDeleteSync(fences[section]);
+		fences[section] = nullptr;
+	}
+}
+
+
+
+// Copy the given data into the buffer, and bind the buffer to the
+// GL_ARRAY_BUFFER target. The return value is the byte offset of the data in
+// the buffer, for use with glVertexAttribPointer().
+size_t StreamBuffer::Upload(const void *data, size_t size)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	// Without fences, there is no way to know when it is safe to overwrite
+	// part of the buffer, so just let the driver allocate new storage.
+	if(!hasFences)
+	{
+		glBufferData(GL_ARRAY_BUFFER, size, data, GL_STREAM_DRAW);
+		return 0;
+	}
+	
+	size_t offset = (used + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	if(offset + size > sectionSize)
+	{
+		Create(max(2 * sectionSize, 2 * size));
+		offset = 0;
+	}
+	size_t start = section * sectionSize + offset;
+	used = offset + size;
+	
+	if(mapped)
+	{
+		memcpy(mapped + start, data, size);
+		return start;
+	}
+	// Nothing the graphics card might still be reading is in this range, so
+	// there is no need for the driver to synchronize.
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+	void *out = glMapBufferRange(GL_ARRAY_BUFFER, start, size, flags);
+	if(out)
+	{
+		memcpy(out, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	else
+		glBufferSubData(GL_ARRAY_BUFFER, start, size, data);
+	
+	return start;
+}
+
@@ -0,0 +1,43 @@
+/* StreamBuffer.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef STREAM_BUFFER_H_
+#define STREAM_BUFFER_H_
+
+#include <cstddef>
+
+
+
+// Class representing a single vertex buffer that is shared by all the shaders
+// that upload new vertex data every frame. The buffer is split into three
+// sections, one for each frame that the graphics card may still be drawing, and
+// each frame's data is written into the next section without making the driver
+// wait. A fence at the end of each frame makes sure that a section is never
+// overwritten while the frame that used it is still being drawn. If the OpenGL
+// version does not support fences, every upload just replaces the buffer.
+class StreamBuffer {
+public:
+	// Create the buffer. This must be called after the OpenGL context exists.
+	static void Init();
+	// Mark the end of a frame. All the data uploaded since the last call to
+	// this function is not touched again until the graphics card is done with it.
+	static void EndFrame();
+	
+	// Copy the given data into the buffer, and bind the buffer to the
+	// GL_ARRAY_BUFFER target. The return value is the byte offset of the data
+	// in the buffer, for use with glVertexAttribPointer().
+	static size_t Upload(const void *data, size_t size);
+};
+
+
+
+#endif
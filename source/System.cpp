@@ -24,7 +24,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "SpriteSet.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <mutex>
 
 using namespace std;
 
@@ -37,6 +39,13 @@ namespace {
 	const double VOLUME = 2000.;
 	// Above this supply amount, price differences taper off:
 	const double LIMIT = 20000.;
+	
+	// The number of systems that have been created so far.
+	atomic<size_t> systemCount(0);
+	
+	// Several threads may ask for the same system's objects at once, but only
+	// one of them should move the objects.
+	mutex positionMutex;
 }
 
 const double System::NEIGHBOR_DISTANCE = 100.;
@@ -106,12 +115,23 @@ int System::FleetProbability::Period() const
 
 
 
+// Each system is given a unique index when it is created, so information about
+// every system can be stored in a flat array instead of a map.
+System::System()
+	: index(systemCount++)
+{
+}
+
+
+
 // Load a system's description.
 void System::Load(const DataNode &node, Set<Planet> &planets)
 {
 	if(node.Size() < 2)
 		return;
 	name = node.Token(1);
+	// Any objects that are added must be moved to the current date's positions.
+	isMoved.value = false;
 	
 	// For the following keys, if this data node defines a new value for that
 	// key, the old values should be cleared (unless using the "add" keyword).
@@ -159,7 +179,7 @@ void System::Load(const DataNode &node, Set<Planet> &planets)
 			else if(key == "haze")
 				haze = nullptr;
 			else if(key == "trade")
-				trade.clear();
+				tradeBases.clear();
 			else if(key == "fleet")
 				fleets.clear();
 			else if(key == "object")
@@ -265,12 +285,13 @@ void System::Load(const DataNode &node, Set<Planet> &planets)
 		else if(key == "haze")
 			haze = SpriteSet::Get(value);
 		else if(key == "trade" && child.Size() >= 3)
-			trade[value].SetBase(child.Value(valueIndex + 1));
+			tradeBases[value] = child.Value(valueIndex + 1);
 		else if(key == "object")
 			LoadObject(child, planets);
 		else
 			child.PrintTrace("Skipping unrecognized attribute:");
 	}
+	UpdateTrade();
 	
 	// Set planet messages based on what zone they are in.
 	for(StellarObject &object : objects)
@@ -320,8 +341,10 @@ void System::Load(const DataNode &node, Set<Planet> &planets)
 
 
 // Once the star map is fully loaded, figure out which stars are "neighbors"
-// of this one, i.e. close enough to see or to reach via jump drive.
-void System::UpdateNeighbors(const Set<System> &systems)
+// of this one, i.e. close enough to see or to reach via jump drive. Only
+// the given systems are checked, so they must include every star that is
+// close enough to this one.
+void System::UpdateNeighbors(const vector<const System *> &nearby)
 {
 	neighbors.clear();
 	
@@ -333,9 +356,9 @@ void System::UpdateNeighbors(const Set<System> &systems)
 	
 	// Any other star system that is within the neighbor distance is also a
 	// neighbor. This will include any nearby linked systems.
-	for(const auto &it : systems)
-		if(&it.second != this && it.second.Position().Distance(position) <= NEIGHBOR_DISTANCE)
-			neighbors.insert(&it.second);
+	for(const System *system : nearby)
+		if(system != this && system->Position().Distance(position) <= NEIGHBOR_DISTANCE)
+			neighbors.insert(system);
 	
 	// Calculate the solar power and solar wind.
 	solarPower = 0.;
@@ -399,6 +422,21 @@ const Point &System::Position() const
 
 
 
+// Get this system's index. Every system's index is less than Count().
+size_t System::Index() const
+{
+	return index;
+}
+
+
+
+size_t System::Count()
+{
+	return systemCount;
+}
+
+
+
 // Get this system's government.
 const Government *System::GetGovernment() const
 {
@@ -446,26 +484,12 @@ const set<const System *> &System::Neighbors() const
 // Move the stellar objects to their positions on the given date.
 void System::SetDate(const Date &date)
 {
-	double now = date.DaysSinceEpoch();
+	day = date.DaysSinceEpoch();
+	isMoved.value = false;
 	
 	for(StellarObject &object : objects)
-	{
-		// "offset" is used to allow binary orbits; the second object is offset
-		// by 180 degrees.
-		object.angle = Angle(now * object.speed + object.offset);
-		object.position = object.angle.Unit() * object.distance;
-		
-		// Because of the order of the vector, the parent's position has always
-		// been updated before this loop reaches any of its children, so:
-		if(object.parent >= 0)
-			object.position += objects[object.parent].position;
-		
-		if(object.position)
-			object.angle = Angle(object.position);
-		
 		if(object.planet)
 			object.planet->ResetDefense();
-	}
 }
 
 
@@ -473,6 +497,7 @@ void System::SetDate(const Date &date)
 // Get the stellar object locations on the most recently set date.
 const vector<StellarObject> &System::Objects() const
 {
+	UpdatePositions();
 	return objects;
 }
 
@@ -481,6 +506,7 @@ const vector<StellarObject> &System::Objects() const
 // Get the stellar object (if any) for the given planet.
 const StellarObject *System::FindStellar(const Planet *planet) const
 {
+	UpdatePositions();
 	if(planet)
 		for(const StellarObject &object : objects)
 			if(object.GetPlanet() == planet)
@@ -593,15 +619,21 @@ const Sprite *System::Haze() const
 // Get the price of the given commodity in this system.
 int System::Trade(const string &commodity) const
 {
-	auto it = trade.find(commodity);
-	return (it == trade.end()) ? 0 : it->second.price;
+	return Trade(GameData::CommodityIndex(commodity));
+}
+
+
+
+int System::Trade(size_t commodity) const
+{
+	return (commodity < trade.size()) ? trade[commodity].price : 0;
 }
 
 
 
 bool System::HasTrade() const
 {
-	return !trade.empty();
+	return !tradeBases.empty();
 }
 
 
@@ -609,41 +641,60 @@ bool System::HasTrade() const
 // Update the economy.
 void System::StepEconomy()
 {
-	for(auto &it : trade)
-	{
-		it.second.exports = EXPORT * it.second.supply;
-		it.second.supply *= KEEP;
-		it.second.supply += Random::Normal() * VOLUME;
-		it.second.Update();
-	}
+	for(Price &it : trade)
+		if(it.base)
+		{
+			it.exports = EXPORT * it.supply;
+			it.supply *= KEEP;
+			it.supply += Random::Normal() * VOLUME;
+			it.Update();
+		}
 }
 
 
 
-void System::SetSupply(const string &commodity, double tons)
+void System::SetSupply(size_t commodity, double tons)
 {
-	auto it = trade.find(commodity);
-	if(it == trade.end())
+	if(commodity >= trade.size() || !trade[commodity].base)
 		return;
 	
-	it->second.supply = tons;
-	it->second.Update();
+	trade[commodity].supply = tons;
+	trade[commodity].Update();
+}
+
+
+
+double System::Supply(size_t commodity) const
+{
+	return (commodity < trade.size()) ? trade[commodity].supply : 0.;
 }
 
 
 
-double System::Supply(const string &commodity) const
+double System::Exports(size_t commodity) const
 {
-	auto it = trade.find(commodity);
-	return (it == trade.end()) ? 0 : it->second.supply;
+	return (commodity < trade.size()) ? trade[commodity].exports : 0.;
 }
 
 
 
-double System::Exports(const string &commodity) const
+// Fill in the table of prices from the base prices given in the data files.
+void System::UpdateTrade()
 {
-	auto it = trade.find(commodity);
-	return (it == trade.end()) ? 0 : it->second.exports;
+	// Keep the supply of any commodity that is still traded here.
+	const vector<Trade::Commodity> &commodities = GameData::Commodities();
+	vector<Price> table(commodities.size());
+	for(size_t i = 0; i < commodities.size(); ++i)
+	{
+		auto it = tradeBases.find(commodities[i].name);
+		if(it == tradeBases.end())
+			continue;
+		
+		if(i < trade.size() && trade[i].base)
+			table[i] = trade[i];
+		table[i].SetBase(it->second);
+	}
+	trade.swap(table);
 }
 
 
@@ -669,6 +720,35 @@ double System::Danger() const
 
 
 
+void System::UpdatePositions() const
+{
+	if(isMoved.value)
+		return;
+	
+	lock_guard<mutex> lock(positionMutex);
+	if(isMoved.value)
+		return;
+	
+	for(StellarObject &object : objects)
+	{
+		// "offset" is used to allow binary orbits; the second object is offset
+		// by 180 degrees.
+		object.angle = Angle(day * object.speed + object.offset);
+		object.position = object.angle.Unit() * object.distance;
+		
+		// Because of the order of the vector, the parent's position has always
+		// been updated before this loop reaches any of its children, so:
+		if(object.parent >= 0)
+			object.position += objects[object.parent].position;
+		
+		if(object.position)
+			object.angle = Angle(object.position);
+	}
+	isMoved.value = true;
+}
+
+
+
 void System::LoadObject(const DataNode &node, Set<Planet> &planets, int parent)
 {
 	int index = objects.size();
@@ -17,6 +17,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Set.h"
 #include "StellarObject.h"
 
+#include <atomic>
+#include <cstddef>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -72,11 +75,17 @@ public:
 	
 	
 public:
+	// Each system is given a unique index when it is created, so information
+	// about every system can be stored in a flat array instead of a map.
+	System();
+	
 	// Load a system's description.
 	void Load(const DataNode &node, Set<Planet> &planets);
 	// Once the star map is fully loaded, figure out which stars are "neighbors"
-	// of this one, i.e. close enough to see or to reach via jump drive.
-	void UpdateNeighbors(const Set<System> &systems);
+	// of this one, i.e. close enough to see or to reach via jump drive. Only
+	// the given systems are checked, so they must include every star that is
+	// close enough to this one.
+	void UpdateNeighbors(const std::vector<const System *> &nearby);
 	
 	// Modify a system's links.
 	void Link(System *other);
@@ -85,6 +94,9 @@ public:
 	// Get this system's name and position (in the star map).
 	const std::string &Name() const;
 	const Point &Position() const;
+	// Get this system's index. Every system's index is less than Count().
+	size_t Index() const;
+	static size_t Count();
 	// Get this system's government.
 	const Government *GetGovernment() const;
 	// Get the name of the ambient audio to play in this system.
@@ -100,7 +112,8 @@ public:
 	// can travel to from here via the jump drive.
 	const std::set<const System *> &Neighbors() const;
 	
-	// Move the stellar objects to their positions on the given date.
+	// Move the stellar objects to their positions on the given date. The
+	// positions are only calculated once they are asked for.
 	void SetDate(const Date &date);
 	// Get the stellar object locations on the most recently set date.
 	const std::vector<StellarObject> &Objects() const;
@@ -127,14 +140,19 @@ public:
 	// Get the background haze sprite for this system.
 	const Sprite *Haze() const;
 	
-	// Get the price of the given commodity in this system.
+	// Get the price of the given commodity in this system. Commodities can be
+	// given by name or by their index in GameData::Commodities().
 	int Trade(const std::string &commodity) const;
+	int Trade(std::size_t commodity) const;
 	bool HasTrade() const;
 	// Update the economy. Returns the amount of trade goods this system exports.
 	void StepEconomy();
-	void SetSupply(const std::string &commodity, double tons);
-	double Supply(const std::string &commodity) const;
-	double Exports(const std::string &commodity) const;
+	void SetSupply(std::size_t commodity, double tons);
+	double Supply(std::size_t commodity) const;
+	double Exports(std::size_t commodity) const;
+	// Fill in the table of prices from the base prices given in the data
+	// files. This must be done whenever the list of commodities changes.
+	void UpdateTrade();
 	
 	// Get the probabilities of various fleets entering this system.
 	const std::vector<FleetProbability> &Fleets() const;
@@ -145,9 +163,23 @@ public:
 	
 private:
 	void LoadObject(const DataNode &node, Set<Planet> &planets, int parent = -1);
+	// If the date has changed since the stellar objects were last moved, move
+	// them to their positions on the new date.
+	void UpdatePositions() const;
 	
 	
 private:
+	// A flag that can be checked from several threads at once. Unlike an atomic
+	// variable, it can be copied along with the rest of the system.
+	class Flag {
+	public:
+		Flag() = default;
+		Flag(const Flag &other) : value(other.value.load()) {}
+		Flag &operator=(const Flag &other) { value = other.value.load(); return *this; }
+		
+		std::atomic<bool> value{false};
+	};
+	
 	class Price {
 	public:
 		void SetBase(int base);
@@ -161,6 +193,7 @@ private:
 	
 	
 private:
+	size_t index;
 	// Name and position (within the star map) of this system.
 	std::string name;
 	Point position;
@@ -175,7 +208,11 @@ private:
 	// guaranteed to appear before it (so that if we traverse the vector in
 	// order, updating positions, an object's parents will already be at the
 	// proper position before that object is updated).
-	std::vector<StellarObject> objects;
+	mutable std::vector<StellarObject> objects;
+	// The day (since the epoch) that the objects should be positioned for, and
+	// whether they have been moved there yet.
+	double day = 0.;
+	mutable Flag isMoved;
 	std::vector<Asteroid> asteroids;
 	const Sprite *haze = nullptr;
 	std::vector<FleetProbability> fleets;
@@ -184,8 +221,11 @@ private:
 	double solarPower = 0.;
 	double solarWind = 0.;
 	
-	// Commodity prices.
-	std::map<std::string, Price> trade;
+	// Commodity prices, indexed by commodity. Commodities that are not traded
+	// here have a base price of zero. The base prices as they were given in the
+	// data files are also kept, in case the list of commodities changes.
+	std::vector<Price> trade;
+	std::map<std::string, int> tradeBases;
 	
 	// Attributes, for use in location filters.
 	std::set<std::string> attributes;
@@ -0,0 +1,174 @@
+/* Telemetry.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Telemetry.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+using namespace std;
+
+namespace {
+	// Every measurement's name begins with this.
+	const string PREFIX = "endless_sky.";
+	// Keep each packet small enough that it will not be fragmented.
+	const size_t PACKET_SIZE = 1400;
+
+#ifdef _WIN32
+	typedef SOCKET Socket;
+	const Socket NO_SOCKET = INVALID_SOCKET;
+#else
+	typedef int Socket;
+	const Socket NO_SOCKET = -1;
+#endif
+
+	// The socket and the buffered lines are protected by this mutex.
+	mutex telemetryMutex;
+	Socket telemetrySocket = NO_SOCKET;
+	atomic<bool> isOpen(false);
+	string buffer;
+	
+	// Send the given packet. The mutex must be held.
+	void Send(const string &packet)
+	{
+		if(!packet.empty())
+			send(telemetrySocket, packet.data(), packet.size(), 0);
+	}
+	
+	// Add one line in the StatsD format, e.g. "endless_sky.ships:120|g".
+	void Add(const string &name, double value, const char *type)
+	{
+		if(!isOpen)
+			return;
+		
+		char number[32];
+		snprintf(number, sizeof(number), "%.6f", value);
+		string line = PREFIX + name + ':' + number + '|' + type + '\n';
+		
+		lock_guard<mutex> lock(telemetryMutex);
+		if(buffer.size() + line.size() > PACKET_SIZE)
+		{
+			Send(buffer);
+			buffer.clear();
+		}
+		buffer += line;
+	}
+}
+
+
+
+// Begin sending measurements to the given "host:port" address.
+bool Telemetry::Open(const string &address)
+{
+	size_t colon = address.rfind(':');
+	if(colon == string::npos || colon == 0 || colon + 1 == address.length())
+	{
+		cerr << "Telemetry address \"" << address << "\" must be of the form <host>:<port>." << endl;
+		return false;
+	}
+	string host = address.substr(0, colon);
+	string port = address.substr(colon + 1);
+
+#ifdef _WIN32
+	WSADATA data;
+	if(WSAStartup(MAKEWORD(2, 2), &data))
+	{
+		cerr << "Unable to initialize sockets for sending telemetry." << endl;
+		return false;
+	}
+#endif
+
+	// "Connecting" a UDP socket just fixes where its packets are sent.
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	addrinfo *result = nullptr;
+	if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) || !result)
+	{
+		cerr << "Unable to resolve telemetry address \"" << address << "\"." << endl;
+		return false;
+	}
+	Socket newSocket = NO_SOCKET;
+	for(addrinfo *it = result; it && newSocket == NO_SOCKET; it = it->ai_next)
+	{
+		newSocket = socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+		if(newSocket != NO_SOCKET && connect(newSocket, it->ai_addr, it->ai_addrlen))
+		{
+#ifdef _WIN32
+			closesocket(newSocket);
+#else
+			close(newSocket);
+#endif
+			newSocket = NO_SOCKET;
+		}
+	}
+	freeaddrinfo(result);
+	if(newSocket == NO_SOCKET)
+	{
+		cerr << "Unable to open a socket for sending telemetry to \"" << address << "\"." << endl;
+		return false;
+	}
+	
+	lock_guard<mutex> lock(telemetryMutex);
+	telemetrySocket = newSocket;
+	isOpen = true;
+	return true;
+}
+
+
+
+// Check if measurements are being sent anywhere.
+bool Telemetry::IsOpen()
+{
+	return isOpen;
+}
+
+
+
+// Record the current value of something, e.g. the number of ships.
+void Telemetry::Gauge(const string &name, double value)
+{
+	Add(name, value, "g");
+}
+
+
+
+// Record how long something took, in milliseconds.
+void Telemetry::Timing(const string &name, double milliseconds)
+{
+	Add(name, milliseconds, "ms");
+}
+
+
+
+// Send everything that has been recorded since the last flush.
+void Telemetry::Flush()
+{
+	if(!isOpen)
+		return;
+	
+	lock_guard<mutex> lock(telemetryMutex);
+	Send(buffer);
+	buffer.clear();
+}
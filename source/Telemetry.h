@@ -0,0 +1,44 @@
+/* Telemetry.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <string>
+
+
+
+// Class for sending measurements of how the game is running (how many objects
+// exist, how long each step and frame takes, and so on) to a StatsD server, so
+// that long sessions can be watched from outside the game. The measurements are
+// sent over UDP, so nothing waits for the server or even checks that it exists.
+// Nothing is recorded or sent unless an address has been given to Open(). All
+// of these functions may be called from any thread.
+class Telemetry {
+public:
+	// Begin sending measurements to the given "host:port" address.
+	static bool Open(const std::string &address);
+	// Check if measurements are being sent anywhere.
+	static bool IsOpen();
+	
+	// Record the current value of something, e.g. the number of ships.
+	static void Gauge(const std::string &name, double value);
+	// Record how long something took, in milliseconds.
+	static void Timing(const std::string &name, double milliseconds);
+	
+	// Send everything that has been recorded since the last flush.
+	static void Flush();
+};
+
+
+
+#endif
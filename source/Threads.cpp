@@ -0,0 +1,216 @@
+/* Threads.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Threads.h"
+
+#include "Trace.h"
+
+#ifdef _WIN32
+#define STRICT
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+namespace {
+#ifdef _WIN32
+	typedef HANDLE Handle;
+#else
+	typedef pthread_t Handle;
+#endif
+
+	class Entry {
+	public:
+		Threads::Priority priority;
+		Handle handle;
+	};
+	
+	// All the threads that currently exist, in the order they were started.
+	// Some threads (e.g. the sprite loaders) are only joined by the destructors
+	// of other globals, so these are never destroyed.
+	mutex &ThreadsMutex()
+	{
+		static mutex *threadsMutex = new mutex;
+		return *threadsMutex;
+	}
+	
+	map<size_t, Entry> &Entries()
+	{
+		static map<size_t, Entry> *entries = new map<size_t, Entry>;
+		return *entries;
+	}
+	
+	size_t nextID = 0;
+	bool isPinning = false;
+	int workerLimit = 0;
+	
+	
+	
+	// Restrict the given thread to the cores whose bits are set in the mask.
+	void SetAffinity(Handle handle, uint64_t mask)
+	{
+#ifdef _WIN32
+		SetThreadAffinityMask(handle, static_cast<DWORD_PTR>(mask));
+#elif defined(__linux__)
+		cpu_set_t cores;
+		CPU_ZERO(&cores);
+		for(int i = 0; i < 64; ++i)
+			if(mask & (uint64_t(1) << i))
+				CPU_SET(i, &cores);
+		pthread_setaffinity_np(handle, sizeof(cores), &cores);
+#else
+		// Other systems (e.g. macOS) do not let threads be pinned to cores.
+		(void)handle;
+		(void)mask;
+#endif
+	}
+	
+	
+	
+	// Give each high priority thread, in the order they started, a core of its
+	// own, and let all the other threads share whatever cores are left over.
+	// At least one core is always left for the others. The mutex must be held.
+	void Pin()
+	{
+		int cores = min(64, static_cast<int>(thread::hardware_concurrency()));
+		uint64_t all = (cores >= 64) ? ~uint64_t(0) : (uint64_t(1) << cores) - 1;
+		if(cores < 2)
+			return;
+		
+		int next = 0;
+		uint64_t shared = all;
+		for(const auto &it : Entries())
+			if(isPinning && it.second.priority == Threads::Priority::HIGH && next < cores - 1)
+			{
+				SetAffinity(it.second.handle, uint64_t(1) << next);
+				shared &= ~(uint64_t(1) << next);
+				++next;
+			}
+			else if(it.second.priority == Threads::Priority::HIGH)
+				SetAffinity(it.second.handle, all);
+		for(const auto &it : Entries())
+			if(it.second.priority != Threads::Priority::HIGH)
+				SetAffinity(it.second.handle, shared);
+	}
+	
+	
+	
+	// Set the calling thread's priority and name.
+	void Configure(const char *name, Threads::Priority priority)
+	{
+#ifdef _WIN32
+		SetThreadPriority(GetCurrentThread(), priority == Threads::Priority::HIGH ? THREAD_PRIORITY_ABOVE_NORMAL
+			: priority == Threads::Priority::LOW ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_NORMAL);
+		(void)name;
+#elif defined(__APPLE__)
+		pthread_set_qos_class_self_np(priority == Threads::Priority::HIGH ? QOS_CLASS_USER_INTERACTIVE
+			: priority == Threads::Priority::LOW ? QOS_CLASS_UTILITY : QOS_CLASS_USER_INITIATED, 0);
+		pthread_setname_np(name);
+#elif defined(__linux__)
+		// On Linux, each thread has its own "nice" value. Raising the priority
+		// needs special permissions, so that may fail; lowering it never does.
+		int nice = (priority == Threads::Priority::HIGH) ? -5 : (priority == Threads::Priority::LOW) ? 10 : 0;
+		if(nice)
+			setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice);
+		// Thread names are limited to 15 characters.
+		pthread_setname_np(pthread_self(), string(name).substr(0, 15).c_str());
+#else
+		(void)name;
+		(void)priority;
+#endif
+#ifdef ES_TRACE
+		Trace::NameThread(name);
+#endif
+	}
+}
+
+
+
+Threads::Scope::Scope(const char *name, Priority priority)
+{
+	Configure(name, priority);
+	
+	Entry entry;
+	entry.priority = priority;
+#ifdef _WIN32
+	// GetCurrentThread() only returns a stand-in for "this thread," so it must
+	// be duplicated to get a handle that other threads can use.
+	DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &entry.handle, 0, FALSE,
+		DUPLICATE_SAME_ACCESS);
+#else
+	entry.handle = pthread_self();
+#endif
+
+	lock_guard<mutex> lock(ThreadsMutex());
+	id = nextID++;
+	Entries()[id] = entry;
+	if(isPinning)
+		Pin();
+}
+
+
+
+Threads::Scope::~Scope()
+{
+	lock_guard<mutex> lock(ThreadsMutex());
+	auto it = Entries().find(id);
+#ifdef _WIN32
+	CloseHandle(it->second.handle);
+#endif
+	Entries().erase(it);
+}
+
+
+
+// Pin each high priority thread to its own core.
+void Threads::SetPinning(bool pin)
+{
+	lock_guard<mutex> lock(ThreadsMutex());
+	if(pin == isPinning)
+		return;
+	
+	isPinning = pin;
+	Pin();
+}
+
+
+
+// Set the most worker threads that any one pool of them may have.
+void Threads::SetWorkerLimit(int count)
+{
+	lock_guard<mutex> lock(ThreadsMutex());
+	workerLimit = max(0, count);
+}
+
+
+
+// Get how many worker threads a pool should have, if it would like to have
+// the given number.
+int Threads::Workers(int count)
+{
+	lock_guard<mutex> lock(ThreadsMutex());
+	return workerLimit ? min(count, workerLimit) : count;
+}
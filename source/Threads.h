@@ -0,0 +1,61 @@
+/* Threads.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef THREADS_H_
+#define THREADS_H_
+
+#include <cstddef>
+
+
+
+// Class for controlling how the operating system schedules the game's threads.
+// Each thread names itself and says how urgent its work is by creating a Scope
+// when it starts. The drawing and simulation threads get a higher priority than
+// the threads that load files in the background, so that loading never makes
+// the game stutter. Optionally, each high priority thread can also be pinned to
+// a core of its own, with all the other threads sharing the remaining cores.
+// Priorities and pinning are only hints: if the operating system does not
+// support them or does not allow them, the threads are scheduled normally.
+class Threads {
+public:
+	enum class Priority : int {LOW, NORMAL, HIGH};
+	
+	// Object that names the calling thread and sets its priority for as long
+	// as it exists. It must be created and destroyed in the same thread.
+	class Scope {
+	public:
+		Scope(const char *name, Priority priority);
+		~Scope();
+		
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+		
+	private:
+		std::size_t id;
+	};
+	
+	
+public:
+	// Pin each high priority thread to its own core. Only the threads that
+	// have been started so far are pinned; the others are pinned as they start.
+	static void SetPinning(bool pin);
+	// Set the most worker threads that any one pool of them may have, or zero
+	// for no limit. This only affects pools that are created afterwards.
+	static void SetWorkerLimit(int count);
+	// Get how many worker threads a pool should have, if it would like to have
+	// the given number.
+	static int Workers(int count);
+};
+
+
+
+#endif
@@ -0,0 +1,176 @@
+/* Trace.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "Trace.h"
+
+#include "Files.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Write the buffered events out once this many have accumulated.
+	const size_t FLUSH_SIZE = 4096;
+	
+	class Event {
+	public:
+		const char *name;
+		int thread;
+		chrono::steady_clock::time_point begin;
+		chrono::steady_clock::time_point end;
+	};
+	
+	// All of the trace state is protected by this mutex. Some threads (e.g.
+	// the sprite loaders) start before main() and may name themselves before
+	// the other globals in this file are constructed, so the thread lists are
+	// kept in function-local statics instead.
+	mutex traceMutex;
+	FILE *file = nullptr;
+	bool isFirst = true;
+	chrono::steady_clock::time_point start;
+	vector<Event> events;
+	
+	// Number each thread in the order that it first records something.
+	map<thread::id, int> &ThreadIDs()
+	{
+		static map<thread::id, int> ids;
+		return ids;
+	}
+	
+	map<int, string> &ThreadNames()
+	{
+		static map<int, string> names;
+		return names;
+	}
+	
+	int ThreadID()
+	{
+		map<thread::id, int> &ids = ThreadIDs();
+		return ids.emplace(this_thread::get_id(), ids.size() + 1).first->second;
+	}
+	
+	double Microseconds(chrono::steady_clock::time_point time)
+	{
+		return chrono::duration<double, micro>(time - start).count();
+	}
+	
+	void Write(const string &entry)
+	{
+		Files::Write(file, (isFirst ? "[\n" : ",\n") + entry);
+		isFirst = false;
+	}
+	
+	// Write all buffered events to the file. The mutex must be held.
+	void Flush()
+	{
+		for(const Event &event : events)
+			Write("{\"name\":\"" + string(event.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				+ to_string(event.thread) + ",\"ts\":" + to_string(Microseconds(event.begin))
+				+ ",\"dur\":" + to_string(Microseconds(event.end) - Microseconds(event.begin)) + "}");
+		events.clear();
+	}
+}
+
+
+
+Trace::Scope::Scope(const char *name)
+	: name(name), begin(chrono::steady_clock::now())
+{
+}
+
+
+
+Trace::Scope::~Scope()
+{
+	Record(name, begin, chrono::steady_clock::now());
+}
+
+
+
+// Begin writing trace events to the given file.
+void Trace::Open(const string &path)
+{
+#ifndef ES_TRACE
+	cerr << "Warning: the game was built without tracing, so \"" << path << "\" will be empty." << endl;
+#endif
+	Close();
+	
+	lock_guard<mutex> lock(traceMutex);
+	file = Files::Open(path, true);
+	if(!file)
+	{
+		cerr << "Unable to open \"" << path << "\" for writing the trace." << endl;
+		return;
+	}
+	isFirst = true;
+	start = chrono::steady_clock::now();
+	
+	// Make sure the file is completed however the program exits. The thread
+	// lists must be constructed first so that they outlive that final write.
+	static bool registered = false;
+	if(!registered)
+	{
+		registered = true;
+		ThreadIDs();
+		ThreadNames();
+		atexit(Close);
+	}
+}
+
+
+
+// Write out any remaining events and close the file.
+void Trace::Close()
+{
+	lock_guard<mutex> lock(traceMutex);
+	if(!file)
+		return;
+	
+	Flush();
+	for(const auto &it : ThreadNames())
+		Write("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+			+ to_string(it.first) + ",\"args\":{\"name\":\"" + it.second + "\"}}");
+	Files::Write(file, isFirst ? "[]\n" : "\n]\n");
+	fclose(file);
+	file = nullptr;
+}
+
+
+
+// Give the calling thread a name to show in the trace.
+void Trace::NameThread(const char *name)
+{
+	lock_guard<mutex> lock(traceMutex);
+	ThreadNames()[ThreadID()] = name;
+}
+
+
+
+// Record an event in the calling thread. This is done by Scope objects.
+void Trace::Record(const char *name, chrono::steady_clock::time_point begin,
+	chrono::steady_clock::time_point end)
+{
+	lock_guard<mutex> lock(traceMutex);
+	if(!file)
+		return;
+	
+	events.push_back(Event{name, ThreadID(), begin, end});
+	if(events.size() >= FLUSH_SIZE)
+		Flush();
+}
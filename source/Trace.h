@@ -0,0 +1,68 @@
+/* Trace.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <chrono>
+#include <string>
+
+
+
+// Class for recording when each thread enters and leaves certain blocks of
+// code, written out in the Chrome trace event format (which can be viewed in
+// chrome://tracing or in Perfetto). Code is instrumented using the macros
+// below, which expand to nothing unless the game is built with ES_TRACE
+// defined (i.e. "scons trace=1"), so there is no cost in normal builds.
+class Trace {
+public:
+	// Object that records an event covering its own lifetime.
+	class Scope {
+	public:
+		explicit Scope(const char *name);
+		~Scope();
+		
+	private:
+		const char *name;
+		std::chrono::steady_clock::time_point begin;
+	};
+	
+	
+public:
+	// Begin writing trace events to the given file.
+	static void Open(const std::string &path);
+	// Write out any remaining events and close the file. This is also done
+	// automatically when the program exits.
+	static void Close();
+	
+	// Give the calling thread a name to show in the trace. This is done by
+	// Threads::Scope objects.
+	static void NameThread(const char *name);
+	// Record an event in the calling thread. This is done by Scope objects.
+	static void Record(const char *name, std::chrono::steady_clock::time_point begin,
+		std::chrono::steady_clock::time_point end);
+};
+
+
+
+#ifdef ES_TRACE
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+// Record the time from this point until the end of the enclosing block.
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+
+
+#endif
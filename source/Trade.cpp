@@ -49,6 +49,10 @@ void Trade::Load(const DataNode &node)
 		else
 			child.PrintTrace("Skipping unrecognized attribute:");
 	}
+	
+	indices.clear();
+	for(size_t i = 0; i < commodities.size(); ++i)
+		indices[commodities[i].name] = i;
 }
 
 
@@ -64,3 +68,12 @@ const vector<Trade::Commodity> &Trade::SpecialCommodities() const
 {
 	return specialCommodities;
 }
+
+
+
+// Get the index of the given commodity in Commodities().
+size_t Trade::Index(const string &name) const
+{
+	auto it = indices.find(name);
+	return (it == indices.end()) ? commodities.size() : it->second;
+}
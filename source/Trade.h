@@ -13,7 +13,9 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #ifndef TRADE_H_
 #define TRADE_H_
 
+#include <cstddef>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class DataNode;
@@ -40,11 +42,16 @@ public:
 	
 	const std::vector<Commodity> &Commodities() const;
 	const std::vector<Commodity> &SpecialCommodities() const;
+	// Get the index of the given commodity in Commodities(). If it is not one
+	// of the ordinary commodities, this returns the number of commodities.
+	std::size_t Index(const std::string &name) const;
 	
 	
 private:
 	std::vector<Commodity> commodities;
 	std::vector<Commodity> specialCommodities;
+	// The index of each ordinary commodity, by name.
+	std::unordered_map<std::string, std::size_t> indices;
 };
 
 
@@ -15,6 +15,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 #include "Command.h"
 #include "Panel.h"
 #include "Screen.h"
+#include "Trace.h"
 
 #include <SDL2/SDL.h>
 
@@ -101,12 +102,17 @@ bool UI::Handle(const SDL_Event &event)
 // Step all the panels forward (advance animations, move objects, etc.).
 void UI::StepAll()
 {
+	TRACE_SCOPE("UI::StepAll");
 	// Handle any queued push or pop commands.
 	PushOrPop();
 	
-	// Step all the panels.
-	for(shared_ptr<Panel> &panel : stack)
-		panel->Step();
+	// Step all the panels, except for any that are hidden under a full-screen
+	// panel. In particular, the flight view does not need to step its engine
+	// while the map or a shop covers it.
+	vector<shared_ptr<Panel>>::const_iterator visible = TopFullScreen();
+	for(auto it = stack.cbegin(); it != stack.cend(); ++it)
+		if(it >= visible || (*it)->StepsWhenHidden())
+			(*it)->Step();
 }
 
 
@@ -114,18 +120,14 @@ void UI::StepAll()
 // Draw all the panels.
 void UI::DrawAll()
 {
+	TRACE_SCOPE("UI::DrawAll");
 	// First, clear all the clickable zones. New ones will be added in the
 	// course of drawing the screen.
 	for(const shared_ptr<Panel> &it : stack)
 		it->ClearZones();
 	
-	// Find the topmost full-screen panel. Nothing below that needs to be drawn.
-	vector<shared_ptr<Panel>>::const_iterator it = stack.end();
-	while(it != stack.begin())
-		if((*--it)->IsFullScreen())
-			break;
-	
-	for( ; it != stack.end(); ++it)
+	// Nothing below the topmost full-screen panel needs to be drawn.
+	for(auto it = TopFullScreen(); it != stack.cend(); ++it)
 		(*it)->Draw();
 }
 
@@ -284,3 +286,16 @@ void UI::PushOrPop()
 	}
 	toPop.clear();
 }
+
+
+
+// Find the topmost full-screen panel, or the bottom of the stack if there is
+// none. The panels below it are completely hidden.
+vector<shared_ptr<Panel>>::const_iterator UI::TopFullScreen() const
+{
+	auto it = stack.cend();
+	while(it != stack.cbegin())
+		if((*--it)->IsFullScreen())
+			break;
+	return it;
+}
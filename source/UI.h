@@ -79,6 +79,9 @@ public:
 private:
 	// If a push or pop is queued, apply it.
 	void PushOrPop();
+	// Find the topmost full-screen panel, or the bottom of the stack if there
+	// is none. The panels below it are completely hidden.
+	std::vector<std::shared_ptr<Panel>>::const_iterator TopFullScreen() const;
 	
 	
 private:
@@ -0,0 +1,69 @@
+/* VirtualList.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "VirtualList.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+
+// Remove all the rows.
+void VirtualList::Clear()
+{
+	tops.assign(1, 0.);
+}
+
+
+
+// Add a row of the given height to the bottom of the list.
+void VirtualList::Add(double height)
+{
+	tops.push_back(tops.back() + height);
+}
+
+
+
+size_t VirtualList::Size() const
+{
+	return tops.size() - 1;
+}
+
+
+
+// Get the total height of all the rows.
+double VirtualList::Height() const
+{
+	return tops.back();
+}
+
+
+
+// Get the distance from the top of the list to the top of the given row.
+double VirtualList::Top(size_t row) const
+{
+	return tops[min(row, Size())];
+}
+
+
+
+// Get the range [first, last) of rows that are at least partly between the
+// given distances from the top of the list.
+pair<size_t, size_t> VirtualList::Visible(double top, double bottom) const
+{
+	// The first visible row is the first one whose bottom is below the top of
+	// the range. The rows after the last visible one start below the bottom.
+	size_t first = upper_bound(tops.begin() + 1, tops.end(), top) - (tops.begin() + 1);
+	size_t last = lower_bound(tops.begin(), tops.end() - 1, bottom) - tops.begin();
+	return make_pair(first, max(first, last));
+}
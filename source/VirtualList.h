@@ -0,0 +1,51 @@
+/* VirtualList.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef VIRTUAL_LIST_H_
+#define VIRTUAL_LIST_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+
+// Class that remembers the heights of the rows in a long, scrolling list, so
+// that each row only has to be measured once (e.g. when the list is filled in)
+// and each frame only the rows that are actually on the screen have to be laid
+// out and drawn. Rows are stacked from the top of the list downward.
+class VirtualList {
+public:
+	// Remove all the rows.
+	void Clear();
+	// Add a row of the given height to the bottom of the list.
+	void Add(double height);
+	
+	std::size_t Size() const;
+	// Get the total height of all the rows.
+	double Height() const;
+	// Get the distance from the top of the list to the top of the given row.
+	double Top(std::size_t row) const;
+	
+	// Get the range [first, last) of rows that are at least partly between the
+	// given distances from the top of the list.
+	std::pair<std::size_t, std::size_t> Visible(double top, double bottom) const;
+	
+	
+private:
+	// The top of each row, followed by the bottom of the last row.
+	std::vector<double> tops = {0.};
+};
+
+
+
+#endif
@@ -43,6 +43,8 @@ public:
 	
 	
 private:
+	friend class ParticleSystem;
+	
 	Angle spin;
 	int lifetime = 0;
 };
@@ -193,6 +193,10 @@ void Weapon::LoadWeapon(const DataNode &node)
 		node.PrintTrace("Warning: Deprecated use of \"homing\" without use of \"[optical|infrared|radar] tracking.\"");
 	}
 	
+	// Remember whether this weapon's projectiles need any steering at all, so
+	// that the unguided ones can skip straight to moving.
+	isGuided = (homing || turn || acceleration);
+	
 	// Convert the "live effect" counts from occurrences per projectile lifetime
 	// into chance of occurring per frame.
 	if(lifetime <= 0)
@@ -76,6 +76,9 @@ public:
 	const Point &HardpointOffset() const;
 	
 	double Turn() const;
+	// Check if projectiles from this weapon ever change their heading or speed
+	// after they are fired, i.e. if they turn, accelerate, or home in.
+	bool IsGuided() const;
 	double Inaccuracy() const;
 	double TurretTurn() const;
 	
@@ -155,6 +158,7 @@ private:
 	bool isSafe = false;
 	bool isPhasing = false;
 	bool isDamageScaled = true;
+	bool isGuided = false;
 	
 	// Attributes.
 	int lifetime = 0;
@@ -231,6 +235,7 @@ inline double Weapon::Drag() const { return drag; }
 inline const Point &Weapon::HardpointOffset() const { return hardpointOffset; }
 
 inline double Weapon::Turn() const { return turn; }
+inline bool Weapon::IsGuided() const { return isGuided; }
 inline double Weapon::Inaccuracy() const { return inaccuracy; }
 inline double Weapon::TurretTurn() const { return turretTurn; }
 
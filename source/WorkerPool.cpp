@@ -0,0 +1,132 @@
+/* WorkerPool.cpp
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#include "WorkerPool.h"
+
+#include "Threads.h"
+
+#include <algorithm>
+
+using namespace std;
+
+
+
+// Create a pool with the given number of extra threads. If the count is
+// negative, pick a count based on the number of available cores.
+WorkerPool::WorkerPool(int count)
+{
+	// By default, leave one core free for the main (drawing) thread and one
+	// for the thread that is calling Run().
+	if(count < 0)
+		count = max(0, Threads::Workers(static_cast<int>(thread::hardware_concurrency()) - 2));
+	
+	threads.resize(count);
+	for(thread &t : threads)
+		t = thread(ref(*this));
+}
+
+
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(jobMutex);
+		terminate = true;
+	}
+	jobCondition.notify_all();
+	for(thread &t : threads)
+		t.join();
+}
+
+
+
+// Get the number of chunks that each loop will be split into.
+size_t WorkerPool::Chunks() const
+{
+	return threads.size() + 1;
+}
+
+
+
+// Call the given function for each chunk of the range [0, count). The
+// arguments to the function are the chunk index and the [begin, end) range
+// that it covers. This does not return until every chunk is done.
+void WorkerPool::Run(size_t count, const function<void(size_t, size_t, size_t)> &function, size_t minChunkSize)
+{
+	// If the loop is too short to be worth splitting, or there are no other
+	// threads, just do all the work right here as the first chunk. The other
+	// chunks are still "run," but with an empty range, so that callers can
+	// always rely on every chunk index being visited.
+	size_t chunks = Chunks();
+	if(threads.empty() || count < max<size_t>(minChunkSize, 1) * 2)
+	{
+		function(0, 0, count);
+		for(size_t i = 1; i < chunks; ++i)
+			function(i, count, count);
+		return;
+	}
+	
+	unique_lock<mutex> lock(jobMutex);
+	job = &function;
+	jobCount = count;
+	nextChunk = 0;
+	unfinished = chunks;
+	lock.unlock();
+	jobCondition.notify_all();
+	
+	lock.lock();
+	DoWork(lock);
+	while(unfinished)
+		doneCondition.wait(lock);
+	job = nullptr;
+}
+
+
+
+// Thread entry point.
+void WorkerPool::operator()()
+{
+	Threads::Scope threadScope("worker", Threads::Priority::NORMAL);
+	unique_lock<mutex> lock(jobMutex);
+	while(true)
+	{
+		while(!terminate && (!job || nextChunk >= Chunks()))
+			jobCondition.wait(lock);
+		if(terminate)
+			return;
+		
+		DoWork(lock);
+	}
+}
+
+
+
+// Claim and run chunks of the current job until there are none left. The lock
+// must be held when this is called, and it will be held again on return.
+void WorkerPool::DoWork(unique_lock<mutex> &lock)
+{
+	size_t chunks = Chunks();
+	while(job && nextChunk < chunks)
+	{
+		size_t chunk = nextChunk++;
+		const function<void(size_t, size_t, size_t)> &function = *job;
+		size_t begin = (jobCount * chunk) / chunks;
+		size_t end = (jobCount * (chunk + 1)) / chunks;
+		
+		lock.unlock();
+		function(chunk, begin, end);
+		lock.lock();
+		
+		if(!--unfinished)
+			doneCondition.notify_all();
+	}
+}
@@ -0,0 +1,80 @@
+/* WorkerPool.h
+Copyright (c) 2020 by Michael Zahniser
+
+Endless Sky is free software: you can redistribute it and/or modify it under the
+terms of the GNU General Public License as published by the Free Software
+Foundation, either version 3 of the License, or (at your option) any later version.
+
+Endless Sky is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+*/
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+// Class representing a set of worker threads that can split a loop over a range
+// of objects into contiguous chunks and run those chunks in parallel. The thread
+// that calls Run() also works on the chunks, and blocks until all are done. Each
+// chunk is identified by its index, so that any objects a chunk generates can be
+// stored in a per-chunk buffer and merged afterwards in chunk order, giving the
+// same ordering as if the loop had been run on a single thread.
+class WorkerPool {
+public:
+	// Create a pool with the given number of extra threads. If the count is
+	// negative, pick a count based on the number of available cores.
+	explicit WorkerPool(int threads = -1);
+	~WorkerPool();
+	
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+	
+	// Loops are not split up unless each chunk would get at least this many
+	// objects, unless Run() is given a different minimum. This suits loops over
+	// many cheap objects; loops over a few expensive ones can use a lower one.
+	static const size_t MIN_CHUNK_SIZE = 64;
+	
+	// Get the number of chunks that each loop will be split into.
+	size_t Chunks() const;
+	// Call the given function for each chunk of the range [0, count). The
+	// arguments to the function are the chunk index and the [begin, end) range
+	// that it covers. This does not return until every chunk is done.
+	void Run(size_t count, const std::function<void(size_t, size_t, size_t)> &function,
+		size_t minChunkSize = MIN_CHUNK_SIZE);
+	
+	// Thread entry point.
+	void operator()();
+	
+	
+private:
+	// Claim and run chunks of the current job until there are none left.
+	void DoWork(std::unique_lock<std::mutex> &lock);
+	
+	
+private:
+	std::vector<std::thread> threads;
+	
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	std::condition_variable doneCondition;
+	
+	// The job that is currently being run. These are protected by jobMutex.
+	const std::function<void(size_t, size_t, size_t)> *job = nullptr;
+	size_t jobCount = 0;
+	size_t nextChunk = 0;
+	size_t unfinished = 0;
+	bool terminate = false;
+};
+
+
+
+#endif
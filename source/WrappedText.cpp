@@ -14,6 +14,7 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 
 #include "Font.h"
 
+#include <cmath>
 #include <cstring>
 
 using namespace std;
@@ -22,7 +23,8 @@ using namespace std;
 
 WrappedText::WrappedText()
 	: font(nullptr), space(0), wrapWidth(1000), tabWidth(0),
-	  lineHeight(0), paragraphBreak(0), alignment(JUSTIFIED), height(0)
+	  lineHeight(0), paragraphBreak(0), alignment(JUSTIFIED), height(0),
+	  isWrapped(false), hasVertices(false), vertexUnderlines(false)
 {
 }
 
@@ -46,6 +48,7 @@ WrappedText::Align WrappedText::Alignment() const
 
 void WrappedText::SetAlignment(Align align)
 {
+	isWrapped &= (alignment == align);
 	alignment = align;
 }
 
@@ -61,6 +64,7 @@ int WrappedText::WrapWidth() const
 
 void WrappedText::SetWrapWidth(int width)
 {
+	isWrapped &= (wrapWidth == width);
 	wrapWidth = width;
 }
 
@@ -71,6 +75,7 @@ void WrappedText::SetWrapWidth(int width)
 // and the alignment separately.
 void WrappedText::SetFont(const Font &font)
 {
+	isWrapped &= (this->font == &font);
 	this->font = &font;
 	
 	space = font.Space();
@@ -91,6 +96,7 @@ int WrappedText::TabWidth() const
 
 void WrappedText::SetTabWidth(int width)
 {
+	isWrapped &= (tabWidth == width);
 	tabWidth = width;
 }
 
@@ -106,6 +112,7 @@ int WrappedText::LineHeight() const
 
 void WrappedText::SetLineHeight(int height)
 {
+	isWrapped &= (lineHeight == height);
 	lineHeight = height;
 }
 
@@ -121,6 +128,7 @@ int WrappedText::ParagraphBreak() const
 
 void WrappedText::SetParagraphBreak(int height)
 {
+	isWrapped &= (paragraphBreak == height);
 	paragraphBreak = height;
 }
 
@@ -130,18 +138,14 @@ void WrappedText::SetParagraphBreak(int height)
 // always begin at (0, 0).
 void WrappedText::Wrap(const string &str)
 {
-	SetText(str.data(), str.length());
-	
-	Wrap();
+	Wrap(str.data(), str.length());
 }
 
 
 
 void WrappedText::Wrap(const char *str)
 {
-	SetText(str, strlen(str));
-	
-	Wrap();
+	Wrap(str, strlen(str));
 }
 
 
@@ -157,8 +161,20 @@ int WrappedText::Height() const
 // Draw the text.
 void WrappedText::Draw(const Point &topLeft, const Color &color) const
 {
-	for(const Word &w : words)
-		font->Draw(text.c_str() + w.Index(), w.Pos() + topLeft, color);
+	if(!font)
+		return;
+	
+	// Lay out the glyphs of every word once, so that the whole text can be
+	// drawn with a single call.
+	if(!hasVertices || vertexUnderlines != Font::IsShowingUnderlines())
+	{
+		vertices.clear();
+		for(const Word &w : words)
+			font->Layout(text.c_str() + w.Index(), w.x, w.y, vertices);
+		hasVertices = true;
+		vertexUnderlines = Font::IsShowingUnderlines();
+	}
+	font->DrawLayout(vertices, round(topLeft.X()), round(topLeft.Y()), color);
 }
 
 
@@ -184,6 +200,22 @@ Point WrappedText::Word::Pos() const
 
 
 
+// Wrap the given text, unless it is the same text that was wrapped last time
+// and none of the formatting parameters have changed since then.
+void WrappedText::Wrap(const char *str, size_t length)
+{
+	if(isWrapped && length == source.length() && !source.compare(0, length, str, length))
+		return;
+	
+	source.assign(str, length);
+	SetText(str, length);
+	Wrap();
+	isWrapped = true;
+	hasVertices = false;
+}
+
+
+
 void WrappedText::SetText(const char *it, size_t length)
 {
 	// Clear any previous word-wrapping data. It becomes invalid as soon as the
@@ -68,6 +68,7 @@ public:
 	
 	
 private:
+	void Wrap(const char *str, size_t length);
 	void SetText(const char *it, size_t length);
 	void Wrap();
 	void AdjustLine(unsigned &lineBegin, int &lineWidth, bool isEnd);
@@ -105,6 +106,15 @@ private:
 	std::string text;
 	std::vector<Word> words;
 	int height;
+	
+	// Remember what text was wrapped, so that wrapping the same text again
+	// with the same settings (e.g. on every frame) does nothing.
+	std::string source;
+	bool isWrapped;
+	// The glyphs of all the words, ready to be drawn in a single batch.
+	mutable std::vector<float> vertices;
+	mutable bool hasVertices;
+	mutable bool vertexUnderlines;
 };
 
 
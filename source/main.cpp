@@ -13,25 +13,41 @@ PARTICULAR PURPOSE.  See the GNU General Public License for more details.
 */
 
 #include "Audio.h"
+#include "Checksum.h"
 #include "Command.h"
 #include "Conversation.h"
 #include "ConversationPanel.h"
 #include "DataFile.h"
 #include "DataNode.h"
 #include "Dialog.h"
+#include "Engine.h"
+#include "Files.h"
 #include "Font.h"
 #include "FrameTimer.h"
 #include "GameData.h"
 #include "GameWindow.h"
+#include "MemoryUsage.h"
 #include "MenuPanel.h"
 #include "Panel.h"
 #include "PlayerInfo.h"
 #include "Preferences.h"
+#include "Random.h"
+#include "Scenario.h"
 #include "Screen.h"
+#include "Ship.h"
 #include "SpriteSet.h"
 #include "SpriteShader.h"
+#include "StellarObject.h"
+#include "System.h"
+#include "Telemetry.h"
+#include "Threads.h"
+#include "Trace.h"
 #include "UI.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 
@@ -47,6 +63,7 @@ using namespace std;
 void PrintHelp();
 void PrintVersion();
 void GameLoop(PlayerInfo &player, Conversation &conversation, bool &debugMode);
+void PrioritizeSprites(const PlayerInfo &player);
 Conversation LoadConversation();
 #ifdef _WIN32
 void InitConsole();
@@ -65,6 +82,19 @@ int main(int argc, char *argv[])
 	Conversation conversation;
 	bool debugMode = false;
 	bool loadOnly = false;
+	bool headless = false;
+	int ticks = 3600;
+	string scenarioPath;
+	string csvPath;
+	string tracePath;
+	string recordPath;
+	string checksumPath;
+	string comparePaths[2];
+	size_t soundBudget = 0;
+	bool memoryReport = false;
+	string statsdAddress;
+	bool pinThreads = false;
+	int workerThreads = 0;
 	for(const char *const *it = argv + 1; *it; ++it)
 	{
 		string arg = *it;
@@ -84,13 +114,75 @@ int main(int argc, char *argv[])
 			debugMode = true;
 		else if(arg == "-p" || arg == "--parse-save")
 			loadOnly = true;
+		else if(arg == "--headless")
+			headless = true;
+		else if(arg == "--ticks" && *++it)
+			ticks = max(0, atoi(*it));
+		else if(arg == "--scenario" && *++it)
+			scenarioPath = *it;
+		else if(arg == "--csv" && *++it)
+			csvPath = *it;
+		else if(arg == "--trace" && *++it)
+			tracePath = *it;
+		else if(arg == "--record" && *++it)
+			recordPath = *it;
+		else if(arg == "--checksum" && *++it)
+			checksumPath = *it;
+		else if(arg == "--compare" && it[1] && it[2])
+		{
+			comparePaths[0] = *++it;
+			comparePaths[1] = *++it;
+		}
+		else if(arg == "--sound-budget" && *++it)
+			soundBudget = static_cast<size_t>(max(0, atoi(*it))) << 20;
+		else if(arg == "--memory-report")
+			memoryReport = true;
+		else if(arg == "--statsd" && *++it)
+			statsdAddress = *it;
+		else if(arg == "--pin-threads")
+			pinThreads = true;
+		else if(arg == "--worker-threads" && *++it)
+			workerThreads = max(0, atoi(*it));
 	}
 	
+	// The thread settings must be in place before any threads are started.
+	Threads::SetWorkerLimit(workerThreads);
+	Threads::SetPinning(pinThreads);
+	
+	// The trace file is completed automatically when the program exits.
+	if(!tracePath.empty())
+		Trace::Open(tracePath);
+	Threads::Scope mainThread("main", Threads::Priority::HIGH);
+	if(!statsdAddress.empty())
+		Telemetry::Open(statsdAddress);
+	
 	try {
+		// Find the resource and config directories.
+		Files::Init(argv);
+		// Comparing two runs does not need any of the game data.
+		if(!comparePaths[0].empty())
+			return Checksum::Compare(comparePaths[0], comparePaths[1]) ? 0 : 1;
+		if(!checksumPath.empty())
+			Engine::WriteChecksums(checksumPath);
+		// The most recent saved game can be parsed while the game data loads;
+		// it is applied once the data is done.
+		if(!headless)
+			PlayerInfo::BeginLoadRecent();
+		
 		// Begin loading the game data. Exit early if we are not using the UI.
 		if(!GameData::BeginLoad(argv))
 			return 0;
 		
+		// In headless mode, simulate the given scenario without ever creating
+		// a window, for measuring the engine's performance.
+		if(headless)
+		{
+			Scenario(scenarioPath).Run(ticks, csvPath);
+			if(memoryReport)
+				MemoryUsage::Print(cout);
+			return 0;
+		}
+		
 		// Load player data, including reference-checking.
 		PlayerInfo player;
 		bool checkedReferences = player.LoadRecent();
@@ -99,9 +191,14 @@ int main(int argc, char *argv[])
 			if(!checkedReferences)
 				GameData::CheckReferences();
 			cout << "Parse completed." << endl;
+			if(memoryReport)
+				MemoryUsage::Print(cout);
 			return 0;
 		}
 		
+		// The player will see their ships and the system they are in first.
+		PrioritizeSprites(player);
+		
 		// On Windows, make sure that the sleep timer has at least 1 ms resolution
 		// to avoid irregular frame rates.
 #ifdef _WIN32
@@ -110,6 +207,15 @@ int main(int argc, char *argv[])
 		
 		Preferences::Load();
 		
+		// If recording the player's commands, pick a random seed that can be
+		// given to the scenario that replays them.
+		if(!recordPath.empty())
+		{
+			uint64_t seed = chrono::steady_clock::now().time_since_epoch().count();
+			Random::Seed(seed);
+			Engine::RecordCommands(recordPath, seed);
+		}
+		
 		if(!GameWindow::Init())
 			return 1;
 		
@@ -118,13 +224,20 @@ int main(int argc, char *argv[])
 		// Show something other than a blank window.
 		GameWindow::Step();
 		
-		Audio::Init(GameData::Sources());
+		Audio::Init(GameData::Sources(), soundBudget);
 		
 		// This is the main loop where all the action begins.
 		GameLoop(player, conversation, debugMode);
+		if(memoryReport)
+			MemoryUsage::Print(cout);
 	}
 	catch(const runtime_error &error)
 	{
+		if(headless)
+		{
+			cerr << error.what() << endl;
+			return 1;
+		}
 		Audio::Quit();
 		GameWindow::ExitWithError(error.what());
 		return 1;
@@ -173,11 +286,16 @@ void GameLoop(PlayerInfo &player, Conversation &conversation, bool &debugMode)
 	bool isPaused = false;
 	bool isFastForward = false;
 	
-	// If fast forwarding, keep track of whether the current frame should be drawn.
-	int skipFrame = 0;
+	// The simulation runs at a fixed rate. If a frame takes too long, the next
+	// one runs extra steps to make up for it, up to this many in total. If fast
+	// forwarding, each frame runs three times as many steps instead.
+	const int MAX_STEPS = 3;
+	int steps = 1;
 	
 	// Limit how quickly full-screen mode can be toggled.
 	int toggleTimeout = 0;
+	// In debug mode, check for changed data files about once a second.
+	int reloadTimeout = 0;
 	
 	// IsDone becomes true when the game is quit.
 	while(!menuPanels.IsDone())
@@ -248,12 +366,10 @@ void GameLoop(PlayerInfo &player, Conversation &conversation, bool &debugMode)
 			SDL_ShowCursor(showCursor);
 		}
 		
-		// Tell all the panels to step forward, then draw them.
-		((!isPaused && menuPanels.IsEmpty()) ? gamePanels : menuPanels).StepAll();
-		
 		// Caps lock slows the frame rate in debug mode.
 		// Slowing eases in and out over a couple of frames.
-		if((mod & KMOD_CAPS) && inFlight && debugMode)
+		bool isSlowMotion = ((mod & KMOD_CAPS) && inFlight && debugMode);
+		if(isSlowMotion)
 		{
 			if(frameRate > 10)
 			{
@@ -261,20 +377,35 @@ void GameLoop(PlayerInfo &player, Conversation &conversation, bool &debugMode)
 				timer.SetFrameRate(frameRate);
 			}
 		}
+		else if(frameRate < 60)
+		{
+			frameRate = min(frameRate + 5, 60);
+			timer.SetFrameRate(frameRate);
+		}
+		if(isFastForward && inFlight && !isSlowMotion)
+			steps *= 3;
+		
+		// Tell all the panels to step forward, then draw them. Only the main
+		// flight view runs extra steps, and it stops doing so as soon as any
+		// other panel is shown on top of it.
+		if(!isPaused && menuPanels.IsEmpty())
+		{
+			gamePanels.StepAll();
+			for(int i = 1; i < steps && menuPanels.IsEmpty() && gamePanels.Root() == gamePanels.Top(); ++i)
+				gamePanels.StepAll();
+		}
 		else
+			menuPanels.StepAll();
+		
+		// Changed data files can only be reloaded when the flight engine is not
+		// running, which is the case once the game panels have stepped with
+		// some other panel on top of the main view, or if there is no game yet.
+		bool isEngineIdle = gamePanels.IsEmpty()
+			|| (!isPaused && menuPanels.IsEmpty() && gamePanels.Root() != gamePanels.Top());
+		if(debugMode && isEngineIdle && ++reloadTimeout >= 60)
 		{
-			if(frameRate < 60)
-			{
-				frameRate = min(frameRate + 5, 60);
-				timer.SetFrameRate(frameRate);
-			}
-			
-			if(isFastForward && inFlight)
-			{
-				skipFrame = (skipFrame + 1) % 3;
-				if(skipFrame)
-					continue;
-			}
+			reloadTimeout = 0;
+			GameData::ReloadChangedFiles();
 		}
 		
 		Audio::Step();
@@ -284,15 +415,42 @@ void GameLoop(PlayerInfo &player, Conversation &conversation, bool &debugMode)
 		(menuPanels.IsEmpty() ? gamePanels : menuPanels).DrawAll();
 		if(isFastForward)
 			SpriteShader::Draw(SpriteSet::Get("ui/fast forward"), Screen::TopLeft() + Point(10., 10.));
+		// Now that this frame's sprites have all been drawn, load any streamed
+		// ones that were missing and unload any that have not been used.
+		GameData::StreamSprites();
 		
 		GameWindow::Step();
-
-		timer.Wait();
+		
+		// The events for the next frame are read as soon as this returns, so
+		// waking up on time also keeps the controls responsive.
+		timer.SetPrecise(Preferences::Has("Precise frame pacing"));
+		steps = timer.WaitSteps(MAX_STEPS);
 	}
 	
 	// If player quit while landed on a planet, save the game if there are changes.
 	if(player.GetPlanet() && gamePanels.CanSave())
 		player.Save();
+	PlayerInfo::FinishSaving();
+}
+
+
+
+// Load the sprites that the player will see first ahead of all the others that
+// are loading in the background.
+void PrioritizeSprites(const PlayerInfo &player)
+{
+	for(const shared_ptr<Ship> &ship : player.Ships())
+	{
+		GameData::Prioritize(ship->GetSprite());
+		GameData::Prioritize(ship->Thumbnail());
+	}
+	const System *system = player.GetSystem();
+	if(!system)
+		return;
+	
+	GameData::Prioritize(system->Haze());
+	for(const StellarObject &object : system->Objects())
+		GameData::Prioritize(object.GetSprite());
 }
 
 
@@ -310,6 +468,30 @@ void PrintHelp()
 	cerr << "    -c, --config <path>: save user's files to given directory." << endl;
 	cerr << "    -d, --debug: turn on debugging features (e.g. Caps Lock slows down instead of speeds up)." << endl;
 	cerr << "    -p, --parse-save: load the most recent saved game and inspect it for content errors" << endl;
+	cerr << "    --compress-images: save a compressed copy of every sprite, so it loads faster, then exit." << endl;
+	cerr << "    --pack-archives: pack the images and sounds of the game and each plugin into a single" << endl;
+	cerr << "        file, so they load faster, then exit." << endl;
+	cerr << "    --texture-budget <MB>: only load sprites when they are drawn, and unload the least" << endl;
+	cerr << "        recently drawn ones to keep the textures within the given amount of memory." << endl;
+	cerr << "    --sound-budget <MB>: only load sounds when they are played, and unload the least" << endl;
+	cerr << "        recently played ones to keep them within the given amount of memory." << endl;
+	cerr << "    --headless: run a scenario with no window as fast as possible, and print timings." << endl;
+	cerr << "    --ticks <count>: number of steps to run in headless mode (default 3600)." << endl;
+	cerr << "    --scenario <path>: data file defining the ships to place in headless mode." << endl;
+	cerr << "    --csv <path>: in headless mode, write the time of each phase of every step to a file." << endl;
+	cerr << "    --record <path>: write the player's commands in flight to a file, in the format of a" << endl;
+	cerr << "        scenario, so that they can be replayed in headless mode." << endl;
+	cerr << "    --checksum <path>: write a checksum of the ships, projectiles, and random number generator" << endl;
+	cerr << "        after each step in flight to a file." << endl;
+	cerr << "    --compare <path> <path>: print the first step and object in which two checksum files" << endl;
+	cerr << "        differ, then exit." << endl;
+	cerr << "    --memory-report: on exit, print how much memory the textures, masks, sounds, and data use." << endl;
+	cerr << "    --trace <path>: write a Chrome trace of what each thread is doing (if built with trace=1)." << endl;
+	cerr << "    --worker-threads <count>: use at most this many threads for each set of background" << endl;
+	cerr << "        workers (e.g. for decoding sprites), to leave more cores free for the game itself." << endl;
+	cerr << "    --pin-threads: run the drawing and simulation threads each on a core of their own." << endl;
+	cerr << "    --statsd <host>:<port>: send the engine's object counts, step and frame times, and save" << endl;
+	cerr << "        times to a StatsD server over UDP, for monitoring long sessions." << endl;
 	cerr << endl;
 	cerr << "Report bugs to: <https://github.com/endless-sky/endless-sky/issues>" << endl;
 	cerr << "Home page: <https://endless-sky.github.io>" << endl;
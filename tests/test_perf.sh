@@ -0,0 +1,119 @@
+#!/bin/bash
+if [ -z "$1" ]; then
+  echo "You must supply a path to the binary as an argument, e.g."
+  echo "~$ ./test_perf.sh ./endless-sky"
+  echo "To record new baselines instead of comparing against them, add --update."
+  exit 1
+fi
+BINARY=$(cd "$(dirname "$1")" && pwd)/$(basename "$1")
+UPDATE=0
+if [ "$2" == "--update" ]; then
+  UPDATE=1
+fi
+
+# Each scenario in tests/perf is run for this many steps. A result fails if it
+# is more than this fraction slower (or larger) than its baseline. Phases that
+# take less than the given number of milliseconds are too noisy to compare.
+TICKS=${PERF_TICKS:-1800}
+TOLERANCE=${PERF_TOLERANCE:-0.25}
+MIN_TIME=${PERF_MIN_TIME:-0.05}
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$HERE/.." && pwd)
+BASELINES="$HERE/perf/baselines.txt"
+# Use an empty config directory, so that the user's preferences and saved
+# games do not affect the results.
+CONFIG=$(mktemp -d)
+mkdir -p "$CONFIG/saves"
+RESULTS=$(mktemp)
+trap 'rm -rf "$CONFIG" "$RESULTS"' EXIT
+
+# Peak memory use can only be measured if GNU time is available.
+GNU_TIME=""
+if /usr/bin/time -f "%M" true > /dev/null 2>&1; then
+  GNU_TIME=/usr/bin/time
+fi
+
+for SCENARIO in "$HERE"/perf/*.txt; do
+  NAME=$(basename "$SCENARIO" .txt)
+  if [ "$NAME" == "baselines" ]; then
+    continue
+  fi
+  OUTPUT=$(mktemp)
+  if [ -n "$GNU_TIME" ]; then
+    $GNU_TIME -f "peak-rss %M" -o "$OUTPUT.rss" "$BINARY" -r "$ROOT" -c "$CONFIG" \
+      --headless --ticks "$TICKS" --scenario "$SCENARIO" > "$OUTPUT"
+  else
+    "$BINARY" -r "$ROOT" -c "$CONFIG" --headless --ticks "$TICKS" --scenario "$SCENARIO" > "$OUTPUT"
+  fi
+  EXIT_CODE=$?
+  if [ $EXIT_CODE -ne 0 ]; then
+    cat "$OUTPUT"
+    echo "Error running scenario '$NAME'"
+    rm -f "$OUTPUT" "$OUTPUT.rss"
+    exit $EXIT_CODE
+  fi
+  if [ -f "$CONFIG/errors.txt" ] && [ -s "$CONFIG/errors.txt" ]; then
+    cat "$CONFIG/errors.txt"
+    echo "Assertion failed: scenario '$NAME' wrote to errors.txt"
+    rm -f "$OUTPUT" "$OUTPUT.rss"
+    exit 1
+  fi
+
+  # Gather the wall time, the peak memory in kB, and the mean time of each
+  # phase in milliseconds, one "<scenario> <measurement> <value>" per line.
+  awk -v name="$NAME" '
+    /^Ran / { print name, "wall-time", $5 * 1000. }
+    /^peak-rss / { print name, "peak-rss", $2 }
+    NF >= 5 && $(NF - 3) ~ /^[0-9.]+$/ {
+      phase = $1
+      for(i = 2; i <= NF - 4; ++i)
+        phase = phase "-" $i
+      print name, phase, $(NF - 3)
+    }' "$OUTPUT" "$OUTPUT.rss" 2> /dev/null >> "$RESULTS"
+  rm -f "$OUTPUT" "$OUTPUT.rss"
+done
+
+if [ $UPDATE -eq 1 ]; then
+  echo "# Baselines for tests/test_perf.sh: <scenario> <measurement> <value>." > "$BASELINES"
+  echo "# Times are in milliseconds and memory is in kB. Regenerate them on the" >> "$BASELINES"
+  echo "# reference machine with: tests/test_perf.sh <binary> --update" >> "$BASELINES"
+  cat "$RESULTS" >> "$BASELINES"
+  echo "Baselines written to $BASELINES."
+  exit 0
+fi
+
+if [ ! -f "$BASELINES" ]; then
+  cat "$RESULTS"
+  echo "No baselines to compare against. Run with --update to record them."
+  exit 1
+fi
+
+# Compare each result to its baseline, if it has one.
+awk -v tolerance="$TOLERANCE" -v minTime="$MIN_TIME" '
+  FNR == NR {
+    if($1 !~ /^#/)
+      baseline[$1 " " $2] = $3
+    next
+  }
+  {
+    key = $1 " " $2
+    if(!(key in baseline))
+      next
+    limit = baseline[key] * (1. + tolerance)
+    if($2 != "peak-rss" && baseline[key] < minTime)
+      next
+    status = ($3 > limit) ? "FAIL" : "ok"
+    if(status == "FAIL")
+      failed = 1
+    printf "%-4s %-12s %-16s %12.3f (baseline %.3f)\n", status, $1, $2, $3, baseline[key]
+  }
+  END { exit failed }' "$BASELINES" "$RESULTS"
+EXIT_CODE=$?
+
+if [ $EXIT_CODE -ne 0 ]; then
+  echo && echo "Assertion failed: some results are more than $TOLERANCE slower than their baselines." && echo
+  exit 1
+else
+  echo "Performance test completed successfully."
+fi